@@ -0,0 +1,249 @@
+/**
+ * @file front_end_bench.cpp
+ * @brief 前端微基准测试：分别统计 lexer、parser 与语义分析（含 IR 生成）的速度
+ *
+ * 输入是由语言各构造（fn、let mut、循环、数组、元组）拼接而成的合成程序，
+ * 默认规模从 1 KB 到 10 MB，可以在命令行上指定其它规模（最大到 100 MB）。
+ * 每个规模重复若干次取最快的一次，输出 tokens/s、lines/s 以及进程的峰值 RSS。
+ *
+ * NOTE: 峰值 RSS 是整个进程的历史峰值，因此规模应从小到大排列；
+ *       目前每字节输入大约需要 100 字节内存，100 MB 的输入需要约 10 GB
+ *
+ * Usage:
+ *   $ make bench
+ *   $ make bench BENCH_ARGS="-r 5 1K 64K 8M 100M"
+ */
+#include <sys/resource.h>
+
+#include <print>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "arena.hpp"
+#include "timer.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "interner.hpp"
+#include "err_report.hpp"
+#include "symbol_table.hpp"
+#include "source_buffer.hpp"
+#include "semantic_ir_builder.hpp"
+
+namespace {
+
+// 单次测量的结果
+struct Result {
+  std::size_t bytes  = 0; // 输入大小
+  std::size_t lines  = 0; // 输入行数
+  std::size_t tokens = 0; // token 数（含 END）
+
+  double lex   = 0.0; // Lexer::nextToken 耗时（秒）
+  double parse = 0.0; // Parser::parseProgram 耗时，不含语义分析
+  double sema  = 0.0; // SemanticIRBuilder::lower 耗时
+};
+
+/**
+ * @brief  生成第 i 个函数：覆盖 let mut、元组、数组、for/while/loop、if 与函数调用
+ * @param  i 函数编号，i > 0 时调用前一个函数
+ * @return 函数源码
+ */
+std::string
+generateFunc(std::size_t i)
+{
+  std::string call = i == 0 ? "a" : std::format("f{}(a, b)", i - 1);
+
+  return std::format(
+    "fn f{0}(mut a: i32, mut b: i32) -> i32 {{\n"
+    "    let mut s = {1};\n"
+    "    let mut t: (i32, i32) = (a, b + 1);\n"
+    "    let mut arr: [i32; 3] = [a, b, 3];\n"
+    "    arr[0] = t.0 + arr[1];\n"
+    "    for mut k in 0..a {{\n"
+    "        s = s + k * 2;\n"
+    "    }}\n"
+    "    while s > 100 {{\n"
+    "        s = s - b;\n"
+    "    }}\n"
+    "    let mut c = loop {{ break s + 1; }};\n"
+    "    if c > b {{\n"
+    "        c = c - 1;\n"
+    "    }} else {{\n"
+    "        c = c + 1;\n"
+    "    }}\n"
+    "    return c + arr[0] + t.1;\n"
+    "}}\n\n",
+    i, call
+  );
+}
+
+/**
+ * @brief  生成不小于指定大小的合成程序
+ * @param  bytes 目标大小
+ * @return 程序源码
+ */
+std::string
+generateProgram(std::size_t bytes)
+{
+  std::string program;
+  program.reserve(bytes + 1024);
+
+  std::size_t n = 0;
+  while (program.size() < bytes) {
+    program += generateFunc(n++);
+  }
+  program += std::format("fn main() {{\n    let mut x = f{}(1, 2);\n}}\n", n - 1);
+
+  return program;
+}
+
+/**
+ * @brief  测量一次前端各阶段的耗时
+ * @param  source 输入
+ * @return 测量结果
+ */
+Result
+measure(const util::SourceBuffer &source)
+{
+  Result result;
+  result.bytes = source.text().size();
+  result.lines = source.lineCount();
+
+  // lexer：逐个拉取 token
+  {
+    util::Interner   interner;
+    err::ErrReporter reporter{source};
+    lex::Lexer       lexer{source, interner, reporter};
+
+    util::Timer timer;
+    timer.start();
+    while (true) {
+      auto token = lexer.nextToken();
+      ++result.tokens;
+      if (token.has_value() && token->type == lex::TokenType::END) {
+        break;
+      }
+    }
+    timer.stop();
+
+    result.lex = timer.seconds();
+  }
+
+  // parser + 语义分析：语法制导，语义分析的时间单独累计后从总时间中扣除
+  {
+    util::Interner   interner;
+    err::ErrReporter reporter{source};
+    lex::Lexer       lexer{source, interner, reporter};
+    auto tokens = lexer.tokenize();
+
+    sym::SymbolTable       symtab{interner};
+    par::SemanticIRBuilder builder{symtab, reporter};
+    util::Arena            arena;
+    par::Parser            parser{tokens, arena, builder, reporter};
+
+    util::Timer sema;
+    builder.setTimer(&sema);
+
+    util::Timer total;
+    total.start();
+    auto prog = parser.parseProgram();
+    total.stop();
+
+    if (reporter.hasErrs()) {
+      reporter.displayErrs();
+      UNREACHABLE("合成程序中存在错误");
+    }
+
+    result.sema  = sema.seconds();
+    result.parse = total.seconds() - result.sema;
+  }
+
+  return result;
+}
+
+/**
+ * @brief  获取进程的峰值 RSS（MB）
+ */
+double
+peakRSS()
+{
+  struct rusage usage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0; // Linux 下 ru_maxrss 以 KB 为单位
+}
+
+/**
+ * @brief  解析带 K/M 后缀的大小
+ */
+std::size_t
+parseSize(const std::string &arg)
+{
+  char *end = nullptr;
+  std::size_t size = std::strtoull(arg.c_str(), &end, 10);
+  switch (*end) {
+    case 'k': case 'K': size <<= 10; break;
+    case 'm': case 'M': size <<= 20; break;
+    default: break;
+  }
+  return size;
+}
+
+/**
+ * @brief 打印一个阶段的吞吐量
+ */
+void
+printPhase(const char *name, double seconds, const Result &r)
+{
+  std::println("  {:<6} {:>9.4f} s {:>10.2f} Mtok/s {:>10.2f} Mline/s",
+    name, seconds, r.tokens / seconds / 1e6, r.lines / seconds / 1e6
+  );
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+  int repeat = 3; // 每个规模的重复次数
+  std::vector<std::size_t> sizes;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if ((arg == "-r" || arg == "--repeat") && i + 1 < argc) {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    } else {
+      sizes.push_back(parseSize(arg));
+    }
+  }
+  if (sizes.empty()) {
+    sizes = {1 << 10, 10 << 10, 100 << 10, 1 << 20, 10 << 20};
+  }
+
+  for (auto size : sizes) {
+    util::SourceBuffer source{std::format("bench-{}.rs", size), generateProgram(size)};
+
+    Result best;
+    for (int i = 0; i < repeat; ++i) {
+      auto r = measure(source);
+      if (i == 0) {
+        best = r;
+        continue;
+      }
+      best.lex   = std::min(best.lex, r.lex);
+      best.parse = std::min(best.parse, r.parse);
+      best.sema  = std::min(best.sema, r.sema);
+    }
+
+    std::println("== {:.1f} KB: {} lines, {} tokens ==",
+      best.bytes / 1024.0, best.lines, best.tokens
+    );
+    printPhase("lex", best.lex, best);
+    printPhase("parse", best.parse, best);
+    printPhase("sema", best.sema, best);
+    std::println("  peak RSS {:.1f} MB", peakRSS());
+  }
+
+  return 0;
+}
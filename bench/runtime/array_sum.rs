@@ -0,0 +1,16 @@
+// 数组上的循环：逐元素更新再求和，循环体可以向量化（-march=rv64gcv）
+fn main0() -> i32 {
+    let mut a: [i32; 16] = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15];
+    let mut b: [i32; 16] = [15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0];
+    let mut total = 0;
+    for mut round in 0..3000 {
+        for mut i in 0..16 {
+            a[i] = a[i] + b[i];
+        }
+        for mut i in 0..16 {
+            total = total + a[i] / 64;
+        }
+        total = total - total / 1000003 * 1000003;
+    }
+    total / 1000
+}
@@ -0,0 +1,21 @@
+// 数组上的双重循环与条件交换：反复把逆序的数组冒泡排序
+fn main0() -> i32 {
+    let mut a: [i32; 24] = [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0];
+    let mut swaps = 0;
+    for mut round in 0..40 {
+        for mut i in 0..24 {
+            a[i] = 24 - i + round;
+        }
+        for mut i in 0..23 {
+            for mut j in 0..23 - i {
+                if a[j] > a[j + 1] {
+                    let mut t = a[j];
+                    a[j] = a[j + 1];
+                    a[j + 1] = t;
+                    swaps = swaps + 1;
+                }
+            }
+        }
+    }
+    swaps / 100 + a[0] - a[23]
+}
@@ -0,0 +1,36 @@
+// 嵌套条件：Collatz 序列的步数，按奇偶与区间分类累计
+fn steps(mut n: i32) -> i32 {
+    let mut count = 0;
+    while n > 1 {
+        if n - n / 2 * 2 == 0 {
+            n = n / 2;
+        } else {
+            n = 3 * n + 1;
+        }
+        count = count + 1;
+    }
+    count
+}
+
+fn main0() -> i32 {
+    let mut short = 0;
+    let mut medium = 0;
+    let mut long = 0;
+    for mut n in 1..4000 {
+        let mut s = steps(n);
+        if s < 50 {
+            short = short + 1;
+        } else {
+            if s < 100 {
+                medium = medium + 1;
+            } else {
+                if s < 150 {
+                    long = long + 1;
+                } else {
+                    long = long + 2;
+                }
+            }
+        }
+    }
+    (short + medium * 3 + long * 7) / 100
+}
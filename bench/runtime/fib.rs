@@ -0,0 +1,11 @@
+// 递归：朴素的 Fibonacci，每次调用两个递归调用
+fn fib(mut n: i32) -> i32 {
+    if n < 2 {
+        return n;
+    }
+    fib(n - 1) + fib(n - 2)
+}
+
+fn main0() -> i32 {
+    fib(24) / 1000
+}
@@ -0,0 +1,25 @@
+// 数组下标计算与三重循环：4x4 矩阵反复相乘，按行主序存放在一维数组中
+fn main0() -> i32 {
+    let mut x: [i32; 16] = [1, 2, 0, 1, 0, 1, 2, 0, 1, 0, 1, 2, 2, 1, 0, 1];
+    let mut y: [i32; 16] = [1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1];
+    let mut z: [i32; 16] = [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0];
+    for mut round in 0..500 {
+        for mut i in 0..4 {
+            for mut j in 0..4 {
+                let mut s = 0;
+                for mut k in 0..4 {
+                    s = s + x[i * 4 + k] * y[k * 4 + j];
+                }
+                z[i * 4 + j] = s - s / 1009 * 1009;
+            }
+        }
+        for mut i in 0..16 {
+            y[i] = z[i];
+        }
+    }
+    let mut trace = 0;
+    for mut i in 0..4 {
+        trace = trace + y[i * 5];
+    }
+    trace
+}
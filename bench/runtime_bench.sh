@@ -0,0 +1,161 @@
+#!/bin/sh
+#
+# 生成代码的运行时基准：统计编译出的程序在 qemu-riscv64 中执行的动态指令数
+#
+# 语料为 bench/runtime/*.rs 与 test/ 中可以运行（定义了 main0）的程序。每个程序
+# 按 BENCH_LEVELS 中的各优化级别用 --asm --time-report 编译，用 riscv-asm/Makefile
+# 与 main.c 链接，再在 qemu-riscv64 中用 insn 插件统计执行的指令数。记录：
+#
+#   insns   动态指令数（整个静态链接的进程，包括 libc 的启动与 printf）
+#   code    生成的机器指令条数（--time-report 的 machine instructions）
+#   spills  放到栈上过的值的个数（--time-report 的 spilled values）
+#   ret     main0 的返回值，与基线不同、或同一程序在各优化级别下不同时视为生成了错误的代码
+#
+# 结果与基线（bench/runtime_baseline.txt）逐项比较：insns 或 code 增加超过
+# BENCH_TOLERANCE 个百分点、spills 增加或 ret 不同时报告并以状态 1 退出。
+# BENCH_UPDATE=1 时把本次结果写为新的基线。
+#
+# Usage:
+#   $ make bench-runtime
+#   $ make bench-runtime INSN_PLUGIN=/path/to/libinsn.so BENCH_LEVELS="0 1" BENCH_FLAGS="-march=rv64gc"
+#   $ make bench-runtime BENCH_UPDATE=1
+#
+# 环境变量：
+#   INSN_PLUGIN      qemu 的 insn 插件（libinsn.so），默认在常见的安装位置中查找
+#   QEMU             默认 qemu-riscv64
+#   TOOLPREFIX       交叉工具链前缀，传给 riscv-asm/Makefile（默认自动推断）
+#   BENCH_LEVELS     优化级别，默认 "0 1"
+#   BENCH_FLAGS      附加的编译选项，如 -march=rv64gcv、-fregalloc=greedy
+#   BENCH_TOLERANCE  允许的增长（百分比），默认 1
+#   BENCH_BASELINE   基线文件，默认 bench/runtime_baseline.txt
+#   BENCH_UPDATE     为 1 时更新基线
+#   BENCH_WORK       中间文件目录，默认 build/bench-runtime
+
+set -eu
+
+compiler=${1:?usage: runtime_bench.sh path/to/toy_compiler}
+root=$(cd "$(dirname "$0")/.." && pwd)
+compiler=$(cd "$(dirname "$compiler")" && pwd)/$(basename "$compiler")
+
+qemu=${QEMU:-qemu-riscv64}
+levels=${BENCH_LEVELS:-"0 1"}
+flags=${BENCH_FLAGS:-}
+tolerance=${BENCH_TOLERANCE:-1}
+baseline=${BENCH_BASELINE:-$root/bench/runtime_baseline.txt}
+work=${BENCH_WORK:-$root/build/bench-runtime}
+
+plugin=${INSN_PLUGIN:-}
+if [ -z "$plugin" ]; then
+  for dir in /usr/lib/qemu/plugins /usr/local/lib/qemu/plugins /usr/libexec/qemu/plugins \
+             /usr/lib/x86_64-linux-gnu/qemu/plugins /usr/local/libexec/qemu/plugins; do
+    if [ -f "$dir/libinsn.so" ]; then
+      plugin=$dir/libinsn.so
+      break
+    fi
+  done
+fi
+if [ -z "$plugin" ] || [ ! -f "$plugin" ]; then
+  echo "找不到 qemu 的 insn 插件，请用 INSN_PLUGIN=/path/to/libinsn.so 指定" >&2
+  echo "（qemu 源码树中 make plugins 之后位于 build/tests/tcg/plugins/libinsn.so）" >&2
+  exit 1
+fi
+
+# 语料：bench/runtime 中的全部程序，以及 test/ 中定义了 main0 的程序
+programs=$(ls "$root"/bench/runtime/*.rs)
+for src in "$root"/test/*.rs; do
+  if grep -q 'fn main0' "$src"; then
+    programs="$programs $src"
+  fi
+done
+
+mkdir -p "$work"
+results=$work/results.txt
+echo "# program level insns code spills ret" > "$results"
+
+failed=0
+for src in $programs; do
+  name=$(basename "$src" .rs)
+  for level in $levels; do
+    out=$work/$name-O$level
+
+    # shellcheck disable=SC2086 # BENCH_FLAGS 按空白拆分为多个选项
+    if ! "$compiler" --asm -O"$level" $flags --time-report -i "$src" -o "$out" 2> "$out.report"; then
+      echo "$name -O$level: 编译失败（见 $out.report）" >&2
+      failed=1
+      continue
+    fi
+    code=$(awk '/^  machine instructions / { print $NF }' "$out.report")
+    spills=$(awk '/^  spilled values / { print $NF }' "$out.report")
+
+    if ! make -s -C "$root/riscv-asm" elf SRC="$out.s" > /dev/null; then
+      echo "$name -O$level: 链接失败" >&2
+      failed=1
+      continue
+    fi
+
+    # main0 的返回值即进程的退出状态，非 0 不代表失败
+    "$qemu" -plugin "$plugin" -d plugin -D "$out.insn" "$out.elf" > "$out.stdout" || true
+    insns=$(awk '/insns/ { n = $NF } END { print n }' "$out.insn")
+    ret=$(sed -n 's/^return value = //p' "$out.stdout")
+    if [ -z "$insns" ] || [ -z "$ret" ]; then
+      echo "$name -O$level: 运行失败（见 $out.stdout 与 $out.insn）" >&2
+      failed=1
+      continue
+    fi
+
+    echo "$name O$level $insns ${code:-0} ${spills:-0} $ret" >> "$results"
+  done
+done
+
+# 同一程序在各优化级别下的返回值必须相同（不需要基线）
+awk '
+  /^#/ { next }
+  !($1 in ret) { ret[$1] = $6; first[$1] = $2; next }
+  $6 != ret[$1] {
+    printf "%s: %s 的返回值 %s 与 %s 的 %s 不同\n", $1, $2, $6, first[$1], ret[$1]
+    bad = 1
+  }
+  END { exit bad ? 1 : 0 }
+' "$results" >&2 || failed=1
+
+if [ "${BENCH_UPDATE:-0}" = 1 ]; then
+  cp "$results" "$baseline"
+  echo "基线已更新：$baseline"
+fi
+
+if [ ! -f "$baseline" ]; then
+  awk '!/^#/ { printf "%-16s %-4s %12s %8s %6s  ret=%s\n", $1, $2, $3, $4, $5, $6 }' "$results"
+  echo "没有基线，用 BENCH_UPDATE=1 把本次结果保存为基线"
+  exit "$failed"
+fi
+
+# 与基线逐项比较；基线中没有的程序只输出结果
+awk -v tolerance="$tolerance" '
+  function delta(now, old) {
+    return old == 0 ? (now == 0 ? 0 : 100) : (now - old) * 100 / old
+  }
+  /^#/ { next }
+  FNR == NR { base[$1 " " $2] = $0; next }
+  {
+    key = $1 " " $2
+    printf "%-16s %-4s %12s", $1, $2, $3
+    if (!(key in base)) {
+      printf " %8s %6s  (new)\n", $4, $5
+      next
+    }
+    split(base[key], old, " ")
+    di = delta($3, old[3]); dc = delta($4, old[4])
+    printf " %+7.2f%% %8s %+7.2f%% %6s (%+d)", di, $4, dc, $5, $5 - old[5]
+    status = ""
+    if ($6 != old[6]) {
+      status = " WRONG RESULT (ret " $6 ", expected " old[6] ")"
+    } else if (di > tolerance || dc > tolerance || $5 > old[5]) {
+      status = " REGRESSION"
+    }
+    print status
+    bad = bad || status != ""
+  }
+  END { exit bad ? 1 : 0 }
+' "$baseline" "$results" || failed=1
+
+exit "$failed"
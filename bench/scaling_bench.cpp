@@ -0,0 +1,384 @@
+/**
+ * @file scaling_bench.cpp
+ * @brief 编译时间的可扩展性测试：按单个维度放大合成程序，检查各阶段的增长曲线
+ *
+ * 机器生成的输入常在某一个维度上极端：很深的 if/loop 嵌套、很大的函数、
+ * 很多的函数、很长的行、很大的数组字面量。每个维度有一个生成器，规模 n
+ * 从基数开始每次翻倍；每个规模在进程内完整编译一次（与 --asm 相同的流程），
+ * 用 util::TimeReport 取 lex、parse、semantic + IR、optimize 与 codegen
+ * 各阶段的时间（parse 不含其中的语义分析），重复若干次取最快的一次。
+ *
+ * 对每个阶段在对数坐标上用最小二乘拟合 t ~ (n log n)^k：线性或 n log n 的
+ * 阶段 k 约为 1，平方的阶段 k 接近 2。k 超过上限（默认 1.3）时报告 FAIL，
+ * 并以状态 1 退出。耗时不足 1 ms 的点噪声太大，不参与拟合；少于 3 个点的
+ * 阶段不做判断。
+ *
+ * 维度（n 的含义）：
+ *   depth   if 与 loop 交替嵌套的层数，每层声明一个变量
+ *   body    一个函数中的语句数
+ *   funcs   函数个数，每个函数调用前一个
+ *   line    一行中的语句数（整个函数写在一行上）
+ *   array   数组字面量的元素个数
+ *
+ * Usage:
+ *   $ make bench-scaling
+ *   $ make bench-scaling SCALING_ARGS="-r 5 -s 6 -O 0 depth body"
+ *
+ * 选项：
+ *   -r, --repeat N      每个规模的重复次数，默认 3
+ *   -s, --steps N       每个维度的规模个数（每次翻倍），默认 5
+ *   -x, --scale N       各维度的基数乘以 N，默认 1
+ *   -O N                优化级别，默认 1
+ *   --max-slope K       允许的 k 的上限，默认 1.3
+ *   维度名               只测试给出的维度，默认全部
+ *
+ * NOTE: depth 维度在 parser 与各遍历中递归，规模过大时会耗尽主线程的栈；
+ *       测试时不使用 -fmax-nesting 的默认上限
+ */
+#include <unistd.h>
+
+#include <cmath>
+#include <print>
+#include <array>
+#include <format>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#include "panic.hpp"
+#include "compiler.hpp"
+#include "time_report.hpp"
+
+namespace {
+
+// 参与拟合的阶段：TimeReport 中的区间名与表头
+struct Phase {
+  std::string_view name;
+  std::string_view title;
+};
+
+constexpr std::array<Phase, 5> PHASES{{
+  {"lex",           "lex"},
+  {"parse",         "parse"},
+  {"semantic + IR", "sema+IR"},
+  {"optimize",      "optimize"},
+  {"codegen",       "codegen"},
+}};
+
+constexpr double MIN_SECONDS = 1e-3; // 参与拟合的最短耗时
+
+using Times = std::array<double, PHASES.size()>;
+
+// 一个维度：生成器与基数
+struct Dimension {
+  std::string_view name;
+  std::string_view desc;
+  std::size_t      base;
+  std::string    (*generate)(std::size_t n);
+};
+
+/**
+ * @brief  depth：if 与 loop 交替嵌套 n 层
+ * @details 每层只引用本层与上一层的变量，使名字查找不随深度变长；
+ *          不缩进，源码大小与 n 成正比
+ */
+std::string
+generateDepth(std::size_t n)
+{
+  std::string program = "fn main() {\nlet mut v0 = 1;\n";
+  for (std::size_t i = 1; i <= n; ++i) {
+    program += (i & 1) != 0 ? std::format("if v{} < {} {{\n", i - 1, i) : "loop {\n";
+    program += std::format("let mut v{} = v{} + 1;\n", i, i - 1);
+  }
+  for (std::size_t i = n; i >= 1; --i) {
+    program += (i & 1) != 0 ? "}\n" : "break;\n}\n";
+  }
+  program += "}\n";
+  return program;
+}
+
+/**
+ * @brief  body：一个有 n 条语句的函数，每 8 条语句有一个 if
+ */
+std::string
+generateBody(std::size_t n)
+{
+  std::string program = "fn f(mut a: i32) -> i32 {\n    let mut v0 = a;\n";
+  for (std::size_t i = 1; i <= n; ++i) {
+    program += std::format("    let mut v{} = v{} + {};\n", i, i - 1, i);
+    if ((i & 7) == 0) {
+      program += std::format("    if v{0} > {1} {{\n        v{0} = v{0} - a;\n    }}\n", i, i * 4);
+    }
+  }
+  program += std::format("    return v{};\n}}\n\nfn main() {{\n    let mut x = f(1);\n}}\n", n);
+  return program;
+}
+
+/**
+ * @brief  funcs：n 个小函数，每个调用前一个
+ */
+std::string
+generateFuncs(std::size_t n)
+{
+  std::string program;
+  for (std::size_t i = 0; i < n; ++i) {
+    auto call = i == 0 ? std::string{"a"} : std::format("f{}(a)", i - 1);
+    program += std::format(
+      "fn f{0}(mut a: i32) -> i32 {{\n"
+      "    let mut s = {1};\n"
+      "    for mut k in 0..a {{\n"
+      "        s = s + k;\n"
+      "    }}\n"
+      "    if s > {0} {{\n"
+      "        s = s - {0};\n"
+      "    }}\n"
+      "    return s;\n"
+      "}}\n\n",
+      i, call
+    );
+  }
+  program += std::format("fn main() {{\n    let mut x = f{}(1);\n}}\n", n - 1);
+  return program;
+}
+
+/**
+ * @brief  line：整个函数（n 条语句）写在一行上
+ */
+std::string
+generateLine(std::size_t n)
+{
+  std::string program = "fn f(mut a: i32) -> i32 { let mut x = a;";
+  for (std::size_t i = 1; i <= n; ++i) {
+    program += std::format(" x = x + {};", i);
+  }
+  program += " return x; }\n\nfn main() {\n    let mut x = f(1);\n}\n";
+  return program;
+}
+
+/**
+ * @brief  array：n 个元素的数组字面量（每行 16 个），再逐个求和
+ */
+std::string
+generateArray(std::size_t n)
+{
+  std::string program = std::format("fn f(mut a: i32) -> i32 {{\n    let mut arr: [i32; {}] = [", n);
+  for (std::size_t i = 0; i < n; ++i) {
+    if ((i & 15) == 0) {
+      program += "\n       ";
+    }
+    program += std::format(" a + {}{}", i, i + 1 < n ? "," : "");
+  }
+  program += std::format(
+    "\n    ];\n"
+    "    let mut s = 0;\n"
+    "    for mut k in 0..{} {{\n"
+    "        s = s + arr[k];\n"
+    "    }}\n"
+    "    return s;\n"
+    "}}\n\n"
+    "fn main() {{\n    let mut x = f(1);\n}}\n",
+    n
+  );
+  return program;
+}
+
+constexpr std::array<Dimension, 5> DIMENSIONS{{
+  {"depth", "nested if/loop blocks",   64,   generateDepth},
+  {"body",  "statements per function", 1024, generateBody},
+  {"funcs", "functions",               256,  generateFuncs},
+  {"line",  "statements on one line",  1024, generateLine},
+  {"array", "array literal elements",  1024, generateArray},
+}};
+
+/**
+ * @brief  在进程内完整编译一次，返回各阶段的耗时（秒）
+ * @param  source 源文件
+ * @param  output 输出文件名（不带后缀）
+ * @param  level  优化级别
+ */
+Times
+measure(const std::string &source, const std::string &output, unsigned level)
+{
+  util::TimeReport report;
+
+  cpr::CompileOptions opts;
+  opts.flag_asm    = true;
+  opts.optim.level = level;
+  opts.time_report = &report;
+  opts.max_nesting = 0; // depth 维度的嵌套层数可以超过默认的上限
+
+  cpr::Compiler compiler{source, opts};
+  compiler.generateIR(output, false);
+  if (compiler.hasErrs()) {
+    UNREACHABLE("合成程序中存在错误");
+  }
+  compiler.generateAssemble(output);
+
+  Times times{};
+  for (std::size_t i = 0; i < PHASES.size(); ++i) {
+    times[i] = report.seconds(PHASES[i].name);
+  }
+  times[1] -= times[2]; // 单线程时语义分析与 IR 生成嵌套在 parse 之中
+  return times;
+}
+
+/**
+ * @brief  在对数坐标上拟合 t ~ (n log n)^k
+ * @return k；可用的点少于 3 个时为空
+ */
+std::optional<double>
+fitSlope(const std::vector<std::size_t> &sizes, const std::vector<double> &seconds)
+{
+  std::vector<std::pair<double, double>> points;
+  for (std::size_t i = 0; i < sizes.size(); ++i) {
+    if (seconds[i] >= MIN_SECONDS) {
+      auto n = static_cast<double>(sizes[i]);
+      points.emplace_back(std::log(n * std::log2(n)), std::log(seconds[i]));
+    }
+  }
+  if (points.size() < 3) {
+    return std::nullopt;
+  }
+
+  double mx = 0.0;
+  double my = 0.0;
+  for (const auto &[x, y] : points) {
+    mx += x;
+    my += y;
+  }
+  mx /= static_cast<double>(points.size());
+  my /= static_cast<double>(points.size());
+
+  double sxy = 0.0;
+  double sxx = 0.0;
+  for (const auto &[x, y] : points) {
+    sxy += (x - mx) * (y - my);
+    sxx += (x - mx) * (x - mx);
+  }
+  return sxy / sxx;
+}
+
+/**
+ * @brief  测试一个维度，输出各规模的耗时与各阶段的 k
+ * @return 是否所有阶段都不超过上限
+ */
+bool
+runDimension(const Dimension &dim, int repeat, int steps, std::size_t scale, unsigned level,
+  double max_slope, const std::filesystem::path &work)
+{
+  std::println("== {}: {} ==", dim.name, dim.desc);
+  std::print("  {:>8}", "n");
+  for (const auto &phase : PHASES) {
+    std::print(" {:>10}", phase.title);
+  }
+  std::println("  (ms)");
+
+  std::vector<std::size_t> sizes;
+  std::vector<Times>       best;
+  for (int step = 0; step < steps; ++step) {
+    auto n = (dim.base * scale) << step;
+    auto source = (work / std::format("{}-{}.rs", dim.name, n)).string();
+    auto output = (work / std::format("{}-{}", dim.name, n)).string();
+    {
+      std::ofstream out{source};
+      if (!out) {
+        UNREACHABLE("无法写入合成程序");
+      }
+      out << dim.generate(n);
+    }
+
+    Times times = measure(source, output, level);
+    for (int i = 1; i < repeat; ++i) {
+      auto again = measure(source, output, level);
+      for (std::size_t p = 0; p < PHASES.size(); ++p) {
+        times[p] = std::min(times[p], again[p]);
+      }
+    }
+    sizes.push_back(n);
+    best.push_back(times);
+
+    std::print("  {:>8}", n);
+    for (auto t : times) {
+      std::print(" {:>10.3f}", t * 1e3);
+    }
+    std::println("");
+  }
+
+  bool ok = true;
+  std::print("  {:>8}", "k");
+  std::vector<std::string_view> failed;
+  for (std::size_t p = 0; p < PHASES.size(); ++p) {
+    std::vector<double> seconds;
+    for (const auto &times : best) {
+      seconds.push_back(times[p]);
+    }
+    auto k = fitSlope(sizes, seconds);
+    if (!k.has_value()) {
+      std::print(" {:>10}", "-");
+      continue;
+    }
+    std::print(" {:>10.2f}", k.value());
+    if (k.value() > max_slope) {
+      failed.push_back(PHASES[p].name);
+      ok = false;
+    }
+  }
+  std::println("");
+
+  for (auto name : failed) {
+    std::println("  FAIL {}: grows faster than (n log n)^{:.2f} in {}", name, max_slope, dim.name);
+  }
+  return ok;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+  int         repeat    = 3;   // 每个规模的重复次数
+  int         steps     = 5;   // 每个维度的规模个数
+  std::size_t scale     = 1;   // 基数的倍数
+  unsigned    level     = 1;   // 优化级别
+  double      max_slope = 1.3; // k 的上限
+  std::vector<std::string_view> selected;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg{argv[i]};
+    bool has_value = i + 1 < argc;
+    if ((arg == "-r" || arg == "--repeat") && has_value) {
+      repeat = std::max(1, std::atoi(argv[++i]));
+    } else if ((arg == "-s" || arg == "--steps") && has_value) {
+      steps = std::max(1, std::atoi(argv[++i]));
+    } else if ((arg == "-x" || arg == "--scale") && has_value) {
+      scale = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "-O" && has_value) {
+      level = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+    } else if (arg == "--max-slope" && has_value) {
+      max_slope = std::atof(argv[++i]);
+    } else if (std::ranges::contains(DIMENSIONS, arg, &Dimension::name)) {
+      selected.push_back(arg);
+    } else {
+      std::println(stderr, "unknown argument: {}", arg);
+      exit(1);
+    }
+  }
+
+  auto work = std::filesystem::temp_directory_path() / std::format("toy-scaling-{}", ::getpid());
+  std::filesystem::create_directories(work);
+
+  bool ok = true;
+  for (const auto &dim : DIMENSIONS) {
+    if (selected.empty() || std::ranges::contains(selected, dim.name)) {
+      ok = runDimension(dim, repeat, steps, scale, level, max_slope, work) && ok;
+    }
+  }
+
+  std::filesystem::remove_all(work);
+  return ok ? 0 : 1;
+}
@@ -1,12 +1,49 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 extern int main0();
 
+/* --profile-generate 编译的程序定义以下两个符号，否则弱引用为空 */
+struct toy_prof_func {
+  const char *name;
+  long        blocks;
+};
+extern const struct toy_prof_func __toy_prof_table[] __attribute__((weak));
+extern long __toy_prof_counts[] __attribute__((weak));
+
+/* 把各基本块的执行次数写到 $TOY_PROFILE（默认 toy.profdata），供 --profile-use 读取 */
+static void
+dump_profile(void)
+{
+  if (__toy_prof_table == NULL) {
+    return;
+  }
+
+  const char *path = getenv("TOY_PROFILE");
+  FILE *out = fopen(path != NULL ? path : "toy.profdata", "w");
+  if (out == NULL) {
+    perror("toy.profdata");
+    return;
+  }
+
+  fprintf(out, "toy-profile 1\n");
+  const long *count = __toy_prof_counts;
+  for (const struct toy_prof_func *func = __toy_prof_table; func->name != NULL; ++func) {
+    fprintf(out, "%s %ld", func->name, func->blocks);
+    for (long i = 0; i < func->blocks; ++i) {
+      fprintf(out, " %ld", *count++);
+    }
+    fprintf(out, "\n");
+  }
+  fclose(out);
+}
+
 int
 main()
 {
   int ret_val = main0();
   printf("return value = %d\n", ret_val);
+  dump_profile();
 
   return ret_val;
 }
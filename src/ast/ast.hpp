@@ -3,37 +3,42 @@
  * @brief Defines the Abstract Syntax Tree (AST) node structures.
  *
  * This header contains the core AST node definitions, including statements, expressions,
- * declarations, types, and control flow constructs. It supports both OOP and CRTP visitor patterns
- * for traversing and processing the AST. Each node records its source position and may store
+ * declarations, types, and control flow constructs. The node set is closed: every concrete node
+ * carries a NodeKind tag and is traversed through the jump table in dispatch.hpp. Each node records its source position and may store
  * intermediate representation (IR) quads for code generation.
  *
  * Key Features:
  * - Node hierarchy for all language constructs (program, declarations, statements, expressions, etc.)
- * - Support for both OOP and CRTP visitor patterns via `accept` methods
+ * - Closed node set (AST_NODE_LIST) with a NodeKind tag per node, no virtual functions
  * - Type information encapsulated in `Type` nodes
  * - Rich set of expression and statement types, including control flow, function calls, assignments, etc.
- * - Use of smart pointers for memory management
+ * - Nodes are allocated in a per-compilation util::Arena and referenced by raw, non-owning pointers
  * - Source code position tracking for error reporting and diagnostics
  *
  * Namespaces:
  * - ast: Contains all AST node definitions and related types
  *
  * Dependencies:
+ * - interner.hpp: Interned identifiers (util::Name)
  * - position.hpp: Source code position tracking
  * - type_factory.hpp: Type system and type construction utilities
  */
 #pragma once
 
+#include <list>
 #include <memory>
 #include <vector>
 
+#include "ir_quad.hpp"
+#include "node_kind.hpp"
+#include "interner.hpp"
 #include "position.hpp"
 #include "type_factory.hpp"
 
 namespace ir {
 
-struct IRQuad;
-using IRQuadPtr = std::shared_ptr<IRQuad>;
+class FuncCode;
+using FuncCodePtr = std::shared_ptr<FuncCode>;
 
 } // namespace ir
 
@@ -46,60 +51,46 @@ using ValuePtr = std::shared_ptr<Value>;
 
 namespace ast {
 
-class OOPVisitor;
-
 /// 所有 AST 结点的基类
+/// NOTE: 结点都分配在 util::Arena 中（见 Parser），*Ptr 均为非拥有指针，
+///       结点随 arena 一起批量释放；析构函数不是虚函数，arena 总是以具体类型销毁结点
+/// NOTE: 结点集合是封闭的（见 AST_NODE_LIST），具体类型记录在 node_kind 中，
+///       通过 ast::dispatch 查表派发，不依赖虚函数
 struct Node {
+  NodeKind       node_kind; // 结点的具体类型
   util::Position pos; // 在源代码中的位置
-  std::vector<ir::IRQuadPtr> ircode; // 存放结点对应的四元式序列
-
-  virtual ~Node() = default;
-  virtual void accept(OOPVisitor &visitor) = 0; // 传统双分发 visitor 接口
-};
-using NodePtr = std::shared_ptr<Node>;
+  ir::IRCode     ircode; // 存放结点对应的四元式序列（父结点生成时会被 splice 走）
 
-// CRTP 模式 visitor 接口
-// 需要使用 CRTP 模式进行访问的 AST 结点都需要继承该基类
-template<typename Derived>
-struct CRTPVisitable {
-  template<typename VisitorT>
-  void accept(VisitorT &visitor) {
-    // 编译时确定实际调用的 visit 方法，减少运行时开销
-    visitor.visit(static_cast<Derived&>(*this));
-  }
+  explicit Node(NodeKind kind) : node_kind(kind) {}
 };
+using NodePtr = Node *;
 
 // Declaration
-struct Decl : virtual Node {
-  ~Decl() override = default;
-  void accept(OOPVisitor &visitor) override = 0;
+struct Decl : Node {
+  explicit Decl(NodeKind kind) : Node(kind) {}
 };
-using DeclPtr = std::shared_ptr<Decl>;
+using DeclPtr = Decl *;
 
 // Program
-struct Prog : Node, CRTPVisitable<Prog> {
+struct Prog : Node {
   std::vector<DeclPtr> decls; // declarations
 
-  Prog(std::vector<DeclPtr> decls) : decls(std::move(decls)) {}
-  ~Prog() override = default;
-  void accept(OOPVisitor &visitor) final;
+  Prog(std::vector<DeclPtr> decls)
+    : Node(NodeKind::Prog), decls(std::move(decls)) {}
 };
-using ProgPtr = std::shared_ptr<Prog>;
+using ProgPtr = Prog *;
 
-// 显式弃用 visit 访问，所有不应该被 visitor 访问的结点都需要继承该基类
+// 不参与遍历的辅助结点（visitor 通常不实现对应的 visit）
 struct MetaNode : Node {
-  void accept(OOPVisitor &visitor) final {
-    UNREACHABLE("MetaNode cannot be visited");
-  }
+  explicit MetaNode(NodeKind kind) : Node(kind) {}
 };
 
 // Type - 封装了 type::Type
 struct Type : MetaNode {
   type::TypePtr type;
 
-  Type() : type(type::TypeFactory::UNKNOWN_TYPE) {}
-  explicit Type(type::TypePtr t) : type(std::move(t)) {}
-  ~Type() override = default;
+  Type() : MetaNode(NodeKind::Type), type(type::TypeFactory::UNKNOWN_TYPE) {}
+  explicit Type(type::TypePtr t) : MetaNode(NodeKind::Type), type(t) {}
 
   bool operator==(const Type& other) const {
     return type::typeEquals(this->type, other.type);
@@ -108,36 +99,31 @@ struct Type : MetaNode {
 };
 
 // Argument
-struct Arg : Node, CRTPVisitable<Arg> {
-  bool        mut;  // mutable or not
-  std::string name; // argument name
-  Type        type; // argument type
-
-  Arg(bool mut, std::string name, const Type &type)
-    : mut(mut), name(std::move(name)), type(type) {}
-  ~Arg() override = default;
+struct Arg : Node {
+  bool       mut;  // mutable or not
+  util::Name name; // argument name
+  Type       type; // argument type
 
-  void accept(OOPVisitor& visitor) final;
+  Arg(bool mut, util::Name name, const Type &type)
+    : Node(NodeKind::Arg), mut(mut), name(name), type(type) {}
 };
-using ArgPtr = std::shared_ptr<Arg>;
+using ArgPtr = Arg *;
 
 // Function header declaration
-struct FuncHeaderDecl : Decl, CRTPVisitable<FuncHeaderDecl> {
-  std::string         name; // function name
+struct FuncHeaderDecl : Decl {
+  util::Name          name; // function name
   std::vector<ArgPtr> argv; // argument vector
   Type                type; // return value type
 
-  FuncHeaderDecl(std::string name,
+  FuncHeaderDecl(util::Name name,
     std::vector<ArgPtr> argv, const Type &type
-  ) : name(std::move(name)), argv(std::move(argv)),
+  ) : Decl(NodeKind::FuncHeaderDecl), name(name), argv(std::move(argv)),
       type(type) {};
-  ~FuncHeaderDecl() override = default;
-  void accept(OOPVisitor& visitor) final;
 };
-using FuncHeaderDeclPtr = std::shared_ptr<FuncHeaderDecl>;
+using FuncHeaderDeclPtr = FuncHeaderDecl *;
 
 // Statement
-struct Stmt : virtual Node {
+struct Stmt : Node {
   enum class Kind : std::uint8_t {
     EMPTY, // 空语句
     DECL,  // 声明语句（当前只有变量声明语句）
@@ -147,41 +133,35 @@ struct Stmt : virtual Node {
   bool is_last = false;
   Type type;
 
-  Stmt(Kind kind) : kind(kind) {}
-  ~Stmt() override = default;
-  void accept(OOPVisitor &visitor) override = 0;
+  Stmt(NodeKind node_kind, Kind kind) : Node(node_kind), kind(kind) {}
 };
-using StmtPtr = std::shared_ptr<Stmt>;
+using StmtPtr = Stmt *;
 
 // Empty Statement
-struct EmptyStmt : Stmt, CRTPVisitable<EmptyStmt> {
-  EmptyStmt() : Stmt(Kind::EMPTY) {}
-  ~EmptyStmt() override = default;
-  void accept(OOPVisitor& visitor) final;
+struct EmptyStmt : Stmt {
+  EmptyStmt() : Stmt(NodeKind::EmptyStmt, Kind::EMPTY) {}
 };
-using EmptyStmtPtr = std::shared_ptr<EmptyStmt>;
+using EmptyStmtPtr = EmptyStmt *;
 
 struct Expr;
-using ExprPtr = std::shared_ptr<Expr>;
+using ExprPtr = Expr *;
 
 // Variable Declaration Statement
-struct VarDeclStmt : Stmt, CRTPVisitable<VarDeclStmt> {
-  bool        mut;     // mutable or not (the declared variable)
-  std::string name;    // the declared variable name
-  Type        vartype; // the declared variable type
+struct VarDeclStmt : Stmt {
+  bool       mut;     // mutable or not (the declared variable)
+  util::Name name;    // the declared variable name
+  Type       vartype; // the declared variable type
   std::optional<ExprPtr> rval; // r-value for variable initialization
 
-  VarDeclStmt(bool mut, std::string name,
+  VarDeclStmt(bool mut, util::Name name,
     const Type &vartype, std::optional<ExprPtr> expr
-  ) : Stmt(Kind::DECL), mut(mut), name(std::move(name)),
+  ) : Stmt(NodeKind::VarDeclStmt, Kind::DECL), mut(mut), name(name),
       vartype(vartype), rval(std::move(expr)) {}
-  ~VarDeclStmt() override = default;
-  void accept(OOPVisitor& visitor) final;
 };
-using VarDeclStmtPtr = std::shared_ptr<VarDeclStmt>;
+using VarDeclStmtPtr = VarDeclStmt *;
 
 // Expression
-struct Expr : virtual Node {
+struct Expr : Node {
   sym::ValuePtr symbol; // 表达式计算结果存储位置
 
   bool res_mut = false; // 表达式计算结果是否可变
@@ -191,29 +171,25 @@ struct Expr : virtual Node {
   bool is_var = false; // 是否是一个变量
   Type type; // value type
 
-  ~Expr() override = default;
-  void accept(OOPVisitor& visitor) override = 0;
+  explicit Expr(NodeKind kind) : Node(kind) {}
 };
 
-struct EmptyExpr : Expr, CRTPVisitable<EmptyExpr> {
-  ~EmptyExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+struct EmptyExpr : Expr {
+  EmptyExpr() : Expr(NodeKind::EmptyExpr) {}
 };
-using EmptyExprPtr = std::shared_ptr<EmptyExpr>;
+using EmptyExprPtr = EmptyExpr *;
 
 // Return Expression
-struct RetExpr : Expr, CRTPVisitable<RetExpr> {
+struct RetExpr : Expr {
   std::optional<ExprPtr> retval; // return value (an expression)
 
   RetExpr(std::optional<ExprPtr> retval)
-    : retval(std::move(retval)) {}
-  ~RetExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::RetExpr), retval(std::move(retval)) {}
 };
-using RetExprPtr = std::shared_ptr<RetExpr>;
+using RetExprPtr = RetExpr *;
 
 // break expression
-struct BreakExpr : Expr, CRTPVisitable<BreakExpr> {
+struct BreakExpr : Expr {
   // break expression can return
   // a value if it in a loop context
   std::optional<ExprPtr> value;
@@ -223,18 +199,15 @@ struct BreakExpr : Expr, CRTPVisitable<BreakExpr> {
   std::optional<sym::ValuePtr> dst;
 
   BreakExpr(std::optional<ExprPtr> expr)
-    : value(std::move(expr)) {}
-  ~BreakExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::BreakExpr), value(std::move(expr)) {}
 };
-using BreakExprPtr = std::shared_ptr<BreakExpr>;
+using BreakExprPtr = BreakExpr *;
 
 // continue expression
-struct ContinueExpr : Expr, CRTPVisitable<ContinueExpr> {
-  ~ContinueExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+struct ContinueExpr : Expr {
+  ContinueExpr() : Expr(NodeKind::ContinueExpr) {}
 };
-using ContinueExprPtr = std::shared_ptr<ContinueExpr>;
+using ContinueExprPtr = ContinueExpr *;
 
 // Comparison Operator
 enum class CmpOper : std::uint8_t {
@@ -255,51 +228,43 @@ enum class AriOper : std::uint8_t {
 };
 
 // Comparison Expression
-struct CmpExpr : Expr, CRTPVisitable<CmpExpr> {
+struct CmpExpr : Expr {
   ExprPtr lhs; // 左部
   CmpOper op;  // operator
   ExprPtr rhs; // 右部
 
   CmpExpr(ExprPtr lhs, CmpOper op, ExprPtr rhs)
-    : lhs(std::move(lhs)), op(op), rhs(std::move(rhs)) {}
-  ~CmpExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::CmpExpr), lhs(std::move(lhs)), op(op), rhs(std::move(rhs)) {}
 };
-using CmpExprPtr = std::shared_ptr<CmpExpr>;
+using CmpExprPtr = CmpExpr *;
 
 // Arithmetic Expression
-struct AriExpr : Expr, CRTPVisitable<AriExpr> {
+struct AriExpr : Expr {
   ExprPtr lhs; // 左操作数
   AriOper op;  // operator
   ExprPtr rhs; // 右操作数
 
   AriExpr(ExprPtr lhs, AriOper op, ExprPtr rhs)
-    : lhs(std::move(lhs)), op(op), rhs(std::move(rhs)) {}
-  ~AriExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::AriExpr), lhs(std::move(lhs)), op(op), rhs(std::move(rhs)) {}
 };
-using AriExprPtr = std::shared_ptr<AriExpr>;
+using AriExprPtr = AriExpr *;
 
-struct Number : Expr, CRTPVisitable<Number> {
+struct Number : Expr {
   int value; // 值
 
-  Number(int value) : value(value) {}
-  ~Number() override = default;
-  void accept(OOPVisitor& visitor) final;
+  Number(int value) : Expr(NodeKind::Number), value(value) {}
 };
-using NumberPtr = std::shared_ptr<Number>;
+using NumberPtr = Number *;
 
-struct Variable : Expr, CRTPVisitable<Variable> {
-  std::string name; // variable name
+struct Variable : Expr {
+  util::Name name; // variable name
 
-  Variable(std::string name) : name(std::move(name)) {}
-  ~Variable() override = default;
-  void accept(OOPVisitor& visitor) final;
+  Variable(util::Name name) : Expr(NodeKind::Variable), name(name) {}
 };
-using VariablePtr = std::shared_ptr<Variable>;
+using VariablePtr = Variable *;
 
 // Assign Element
-struct AssignElem : Expr, CRTPVisitable<AssignElem> {
+struct AssignElem : Expr {
   enum class Kind : std::uint8_t {
     VARIABLE, // 变量
     ARRACC,   // 数组访问
@@ -308,234 +273,190 @@ struct AssignElem : Expr, CRTPVisitable<AssignElem> {
 
   ExprPtr base;
 
-  AssignElem(ExprPtr expr) : base(std::move(expr)) {}
-  ~AssignElem() override = default;
-  void accept(OOPVisitor& visitor) override;
+  AssignElem(ExprPtr expr) : AssignElem(NodeKind::AssignElem, std::move(expr)) {}
+
+protected:
+  AssignElem(NodeKind node_kind, ExprPtr expr)
+    : Expr(node_kind), base(std::move(expr)) {}
 };
-using AssignElemPtr = std::shared_ptr<AssignElem>;
+using AssignElemPtr = AssignElem *;
 
 // 数组访问
 struct ArrAcc : AssignElem {
   ExprPtr idx; // 索引值
 
   ArrAcc(ExprPtr value, ExprPtr idx)
-    : AssignElem(std::move(value)), idx(std::move(idx)) {}
-  ~ArrAcc() override = default;
-
-  void accept(OOPVisitor& visitor) final;
-  // 重写 accept，调用 visit(TupAcc&)
-  template <typename Visitor>
-  void accept(Visitor &visitor) {
-    visitor.visit(*this);
-  }
+    : AssignElem(NodeKind::ArrAcc, std::move(value)), idx(std::move(idx)) {}
 };
-using ArrAccPtr = std::shared_ptr<ArrAcc>;
+using ArrAccPtr = ArrAcc *;
 
 // 元组访问
 struct TupAcc : AssignElem {
   NumberPtr idx; // 索引值
 
   TupAcc(ExprPtr value, NumberPtr idx)
-    : AssignElem(std::move(value)), idx(std::move(idx)) {}
-  ~TupAcc() override = default;
-
-  void accept(OOPVisitor& visitor) final;
-  // 重写 accept，调用 visit(ArrAcc&)
-  template <typename Visitor>
-  void accept(Visitor &visitor) {
-    visitor.visit(*this);
-  }
+    : AssignElem(NodeKind::TupAcc, std::move(value)), idx(std::move(idx)) {}
 };
-using TupAccPtr = std::shared_ptr<TupAcc>;
+using TupAccPtr = TupAcc *;
 
 // Expression Statement
-struct ExprStmt : Stmt, CRTPVisitable<ExprStmt> {
+struct ExprStmt : Stmt {
   ExprPtr expr;
 
-  ExprStmt(ExprPtr expr) : Stmt(Kind::EXPR), expr(std::move(expr)) {}
-  ~ExprStmt() override = default;
-  void accept(OOPVisitor& visitor) final;
+  ExprStmt(ExprPtr expr) : Stmt(NodeKind::ExprStmt, Kind::EXPR), expr(std::move(expr)) {}
 };
-using ExprStmtPtr = std::shared_ptr<ExprStmt>;
+using ExprStmtPtr = ExprStmt *;
 
 // Statement Block Expression
-struct StmtBlockExpr : Expr, CRTPVisitable<StmtBlockExpr> {
+struct StmtBlockExpr : Expr {
   bool has_ret = false; // 是否含有返回语句
+  bool missing = false; // 缺少语句块时 parser 补上的空语句块，不检查也不生成 IR
   std::vector<StmtPtr> stmts; // statements
 
   StmtBlockExpr(std::vector<StmtPtr> stmts)
-    : stmts(std::move(stmts)) {}
-  ~StmtBlockExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::StmtBlockExpr), stmts(std::move(stmts)) {}
 };
-using StmtBlockExprPtr = std::shared_ptr<StmtBlockExpr>;
+using StmtBlockExprPtr = StmtBlockExpr *;
 
 // Function Declaration
-struct FuncDecl : Decl, CRTPVisitable<FuncDecl> {
+struct FuncDecl : Decl {
   FuncHeaderDeclPtr header; // function header
   StmtBlockExprPtr  body;   // function body
+  ir::FuncCodePtr   code;   // 函数的稠密 IR（存在语义错误时可能为空）
+
+  // 在 token stream 中的下标：[tok_begin, tok_body) 为函数头，[tok_body, tok_end) 为函数体
+  std::size_t tok_begin = 0;
+  std::size_t tok_body  = 0;
+  std::size_t tok_end   = 0;
 
   FuncDecl(FuncHeaderDeclPtr header, StmtBlockExprPtr body)
-    : header(std::move(header)), body(std::move(body)) {}
-  ~FuncDecl() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Decl(NodeKind::FuncDecl), header(std::move(header)), body(std::move(body)) {}
 };
-using FuncDeclPtr = std::shared_ptr<FuncDecl>;
+using FuncDeclPtr = FuncDecl *;
 
 // 括号表达式
-struct BracketExpr : Expr, CRTPVisitable<BracketExpr> {
+struct BracketExpr : Expr {
   std::optional<ExprPtr> expr; // ( expr )，允许空括号
 
   BracketExpr(std::optional<ExprPtr> expr)
-    : expr(std::move(expr)) {}
-  ~BracketExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::BracketExpr), expr(std::move(expr)) {}
 };
-using BracketExprPtr = std::shared_ptr<BracketExpr>;
+using BracketExprPtr = BracketExpr *;
 
 // Array Elements => e.g., [1, 2, 3]
-struct ArrElems : Expr, CRTPVisitable<ArrElems> {
+struct ArrElems : Expr {
   std::vector<ExprPtr> elems;
 
   ArrElems(std::vector<ExprPtr> elems)
-    : elems(std::move(elems)) {}
-  ~ArrElems() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::ArrElems), elems(std::move(elems)) {}
 };
-using ArrElemsPtr = std::shared_ptr<ArrElems>;
+using ArrElemsPtr = ArrElems *;
 
 // Tuple Elements => e.g. (1, 2)
-struct TupElems : Expr, CRTPVisitable<TupElems> {
+struct TupElems : Expr {
   std::vector<ExprPtr> elems;
 
   TupElems(std::vector<ExprPtr> elems)
-    : elems(std::move(elems)) {}
-  ~TupElems() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::TupElems), elems(std::move(elems)) {}
 };
-using TupElemsPtr = std::shared_ptr<TupElems>;
+using TupElemsPtr = TupElems *;
 
 // Assign Expression
-struct AssignExpr : Expr, CRTPVisitable<AssignExpr> {
+struct AssignExpr : Expr {
   AssignElemPtr lval;
   ExprPtr       rval; // expression
 
   AssignExpr(AssignElemPtr lval, ExprPtr rval)
-    : lval(std::move(lval)), rval(std::move(rval)) {}
-  ~AssignExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+    : Expr(NodeKind::AssignExpr), lval(std::move(lval)), rval(std::move(rval)) {}
 };
-using AssignExprPtr = std::shared_ptr<AssignExpr>;
+using AssignExprPtr = AssignExpr *;
 
 // Call Expression
-struct CallExpr : Expr, CRTPVisitable<CallExpr> {
-  std::string          callee; // 被调用函数名
+struct CallExpr : Expr {
+  util::Name           callee; // 被调用函数名
   std::vector<ExprPtr> argv;   // argument vector
 
-  CallExpr(std::string callee, std::vector<ExprPtr> argv
-  ) : callee(std::move(callee)), argv(std::move(argv)) {}
-  ~CallExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
+  CallExpr(util::Name callee, std::vector<ExprPtr> argv
+  ) : Expr(NodeKind::CallExpr), callee(callee), argv(std::move(argv)) {}
 };
-using CallExprPtr = std::shared_ptr<CallExpr>;
+using CallExprPtr = CallExpr *;
 
 // else 子句
-struct ElseClause : Node, CRTPVisitable<ElseClause> {
+struct ElseClause : Node {
   sym::ValuePtr          symbol;
   std::optional<ExprPtr> cond; // else (if expr)?
   StmtBlockExprPtr       body;
 
   ElseClause(std::optional<ExprPtr> cond, StmtBlockExprPtr body
-  ) : cond(std::move(cond)), body(std::move(body)) {}
-  ~ElseClause() override = default;
-  void accept(OOPVisitor& visitor) final;
+  ) : Node(NodeKind::ElseClause), cond(std::move(cond)), body(std::move(body)) {}
 };
-using ElseClausePtr = std::shared_ptr<ElseClause>;
+using ElseClausePtr = ElseClause *;
 
 // If Expression
-struct IfExpr : Expr, CRTPVisitable<IfExpr> {
+struct IfExpr : Expr {
   ExprPtr                    cond;
   StmtBlockExprPtr           body;
   std::vector<ElseClausePtr> elses; // else clauses
 
   IfExpr(ExprPtr cond, StmtBlockExprPtr body,
     std::vector<ElseClausePtr> elses
-  ) : cond(std::move(cond)), body(std::move(body)),
+  ) : Expr(NodeKind::IfExpr), cond(std::move(cond)), body(std::move(body)),
       elses(std::move(elses)) {}
-  ~IfExpr() override = default;
-  void accept(OOPVisitor& visitor) final;
 };
-using IfExprPtr = std::shared_ptr<IfExpr>;
+using IfExprPtr = IfExpr *;
 
 // loop expression
-struct LoopExpr : Expr, CRTPVisitable<LoopExpr> {
+struct LoopExpr : Expr {
   StmtBlockExprPtr body;
 
   LoopExpr(StmtBlockExprPtr body)
-    : body(std::move(body)) {}
-  ~LoopExpr() override = default;
-  void accept(OOPVisitor& visitor) override;
+    : LoopExpr(NodeKind::LoopExpr, std::move(body)) {}
+
+protected:
+  LoopExpr(NodeKind node_kind, StmtBlockExprPtr body)
+    : Expr(node_kind), body(std::move(body)) {}
 };
-using LoopExprPtr = std::shared_ptr<LoopExpr>;
+using LoopExprPtr = LoopExpr *;
 
 // while loop expression
 struct WhileLoopExpr : LoopExpr {
   ExprPtr cond;
 
   WhileLoopExpr(ExprPtr cond, StmtBlockExprPtr body)
-    : LoopExpr(std::move(body)), cond(std::move(cond)) {}
-  ~WhileLoopExpr() override = default;
-
-  void accept(OOPVisitor& visitor) final;
-  // CRTP visitor: 调用 visit(WhileLoopExpr&)
-  template <typename Visitor>
-  void accept(Visitor &visitor) {
-    visitor.visit(*this);
-  }
+    : LoopExpr(NodeKind::WhileLoopExpr, std::move(body)), cond(std::move(cond)) {}
 };
-using WhileLoopExprPtr = std::shared_ptr<WhileLoopExpr>;
+using WhileLoopExprPtr = WhileLoopExpr *;
 
 // 可迭代的值
 // 可以是一个 Array 类型的变量或中间值
-struct IterableVal : Expr, CRTPVisitable<IterableVal> {
+struct IterableVal : Expr {
   ExprPtr value;
 
-  IterableVal(ExprPtr value) : value(std::move(value)) {}
-  ~IterableVal() override = default;
-  void accept(OOPVisitor &visitor) final;
+  IterableVal(ExprPtr value) : Expr(NodeKind::IterableVal), value(std::move(value)) {}
 };
-using IterableValPtr = std::shared_ptr<IterableVal>;
+using IterableValPtr = IterableVal *;
 
-struct RangeExpr : Expr, CRTPVisitable<RangeExpr> {
+struct RangeExpr : Expr {
   // 左闭右开区间
   ExprPtr start;
   ExprPtr end;
 
   RangeExpr(ExprPtr start, ExprPtr end)
-    : start(std::move(start)), end(std::move(end)) {}
-  ~RangeExpr() override = default;
-  void accept(OOPVisitor &visitor) final;
+    : Expr(NodeKind::RangeExpr), start(std::move(start)), end(std::move(end)) {}
 };
-using RangeExprPtr = std::shared_ptr<RangeExpr>;
+using RangeExprPtr = RangeExpr *;
 
 // for loop expression
 struct ForLoopExpr : LoopExpr {
-  bool        mut;
-  std::string pattern;
-  ExprPtr     iterexpr;
-
-  ForLoopExpr(bool mut, std::string pattern, ExprPtr iterexpr,
-    StmtBlockExprPtr body) : LoopExpr(std::move(body)), mut(mut),
-      pattern(std::move(pattern)), iterexpr(std::move(iterexpr)) {}
-  ~ForLoopExpr() override = default;
-
-  void accept(OOPVisitor &visitor) final;
-  // 重写 accept，调用 visit(ForLoopExpr&)
-  template <typename Visitor>
-  void accept(Visitor &visitor) {
-    visitor.visit(*this);
-  }
+  bool           mut;
+  util::Name     pattern;
+  util::Position pattern_pos; // 循环变量的声明位置
+  ExprPtr        iterexpr;
+
+  ForLoopExpr(bool mut, util::Name pattern, ExprPtr iterexpr,
+    StmtBlockExprPtr body) : LoopExpr(NodeKind::ForLoopExpr, std::move(body)), mut(mut),
+      pattern(pattern), iterexpr(std::move(iterexpr)) {}
 };
-using ForLoopExprPtr = std::shared_ptr<ForLoopExpr>;
+using ForLoopExprPtr = ForLoopExpr *;
 
 } // namespace ast
@@ -38,9 +38,6 @@ concept HasVisit = requires(Visitor v, NodeT &node) {
 
 template <typename Derived>
 class CRTPVisitor {
-public:
-  virtual ~CRTPVisitor() = default;
-
 public:
   template <typename NodeT>
   void visit(NodeT &node) {
@@ -0,0 +1,52 @@
+/**
+ * @file dispatch.hpp
+ * @brief Compile-time jump table for visiting AST nodes through a base pointer.
+ *
+ * `ast::dispatch(visitor, node)` reads `node.node_kind` and jumps through a
+ * constexpr table generated from AST_NODE_LIST, calling
+ * `visitor.visit(ConcreteNode&)`. The table is instantiated per visitor type,
+ * so the visit calls are direct (and inlinable) rather than virtual. Node kinds
+ * the visitor does not handle are ignored.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "ast.hpp"
+
+namespace ast {
+
+namespace detail {
+
+template<typename Visitor, typename NodeT>
+void
+visitAs(Visitor &visitor, Node &node)
+{
+  if constexpr (requires { visitor.visit(static_cast<NodeT &>(node)); }) {
+    visitor.visit(static_cast<NodeT &>(node));
+  }
+}
+
+template<typename Visitor>
+inline constexpr std::array<void (*)(Visitor &, Node &), NODE_KIND_CNT> DISPATCH_TABLE{
+#define TABLE_ENTRY(name) &visitAs<Visitor, name>,
+  AST_NODE_LIST(TABLE_ENTRY)
+#undef TABLE_ENTRY
+};
+
+} // namespace detail
+
+/**
+ * @brief 按结点的具体类型调用 visitor.visit
+ * @param visitor 任意提供 visit(NodeT&) 重载的 visitor
+ * @param node    待访问的结点
+ */
+template<typename Visitor>
+inline void
+dispatch(Visitor &visitor, Node &node)
+{
+  detail::DISPATCH_TABLE<Visitor>[static_cast<std::size_t>(node.node_kind)](visitor, node);
+}
+
+} // namespace ast
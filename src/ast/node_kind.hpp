@@ -0,0 +1,68 @@
+/**
+ * @file node_kind.hpp
+ * @brief Defines the closed set of AST node kinds.
+ *
+ * AST_NODE_LIST enumerates every concrete AST node type exactly once. It is
+ * expanded into forward declarations, the `NodeKind` tag stored in each node,
+ * and the dispatch table in dispatch.hpp, so adding a node only requires
+ * extending this list and tagging the new node's constructor.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define AST_NODE_LIST(_) \
+  _(Prog) \
+  _(Type) \
+  _(Arg) \
+  _(StmtBlockExpr) \
+  _(FuncHeaderDecl) \
+  _(FuncDecl) \
+  _(ExprStmt) \
+  _(EmptyExpr) \
+  _(BracketExpr) \
+  _(AssignElem) \
+  _(Variable) \
+  _(ArrAcc) \
+  _(TupAcc) \
+  _(Number) \
+  _(ArrElems) \
+  _(TupElems) \
+  _(RetExpr) \
+  _(VarDeclStmt) \
+  _(AssignExpr) \
+  _(CmpExpr) \
+  _(AriExpr) \
+  _(CallExpr) \
+  _(ElseClause) \
+  _(IfExpr) \
+  _(WhileLoopExpr) \
+  _(RangeExpr) \
+  _(IterableVal) \
+  _(ForLoopExpr) \
+  _(LoopExpr) \
+  _(BreakExpr) \
+  _(ContinueExpr) \
+  _(EmptyStmt)
+
+namespace ast {
+
+#define FORWARD_DECLARE(name) struct name;
+  AST_NODE_LIST(FORWARD_DECLARE)
+#undef FORWARD_DECLARE
+
+// 结点的具体类型，枚举值与结点类型同名
+enum class NodeKind : std::uint8_t {
+#define ENUM_DECLARE(name) name,
+  AST_NODE_LIST(ENUM_DECLARE)
+#undef ENUM_DECLARE
+};
+
+inline constexpr std::size_t NODE_KIND_CNT = 0
+#define COUNT(name) + 1
+  AST_NODE_LIST(COUNT)
+#undef COUNT
+  ;
+
+} // namespace ast
@@ -0,0 +1,121 @@
+#include <format>
+
+#include "fold.hpp"
+#include "panic.hpp"
+#include "def_use.hpp"
+#include "aggregate.hpp"
+#include "func_code.hpp"
+
+namespace cg {
+
+using ir::NONE;
+using ir::IROp;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr int MAX_OFFSET = 2047; // 访存指令 12 位立即数偏移的上限
+
+} // namespace
+
+bool
+Aggregates::isAggregate(type::TypePtr type)
+{
+  return type->kind == type::TypeKind::ARRAY || type->kind == type::TypeKind::TUPLE;
+}
+
+/**
+ * @brief 类型在栈帧中占的字节数，每个标量一个字
+ */
+int
+Aggregates::sizeOf(type::TypePtr type)
+{
+  switch (type->kind) {
+    case type::TypeKind::ARRAY:
+      return type->size() * sizeOf(type->getElemType());
+    case type::TypeKind::TUPLE: {
+      int size = 0;
+      for (int idx = 0; idx < type->size(); ++idx) {
+        size += sizeOf(type->getElemType(idx));
+      }
+      return size;
+    }
+    case type::TypeKind::UNIT:
+      return 0;
+    default:
+      return WORD;
+  }
+}
+
+/**
+ * @brief 数组元素或元组字段相对于起始地址的偏移
+ */
+int
+Aggregates::offsetOf(type::TypePtr type, int idx)
+{
+  if (type->kind == type::TypeKind::ARRAY) {
+    return idx * sizeOf(type->getElemType());
+  }
+  int offset = 0;
+  for (int field = 0; field < idx; ++field) {
+    offset += sizeOf(type->getElemType(field));
+  }
+  return offset;
+}
+
+Aggregates::Aggregates(const ir::FuncCode &code)
+{
+  auto n = code.valueCount();
+  kinds.assign(n, Kind::SCALAR);
+  offsets.assign(n, 0);
+
+  std::vector<std::uint32_t> defs(n, 0);
+  for (const auto &quad : code.quads) {
+    if (quad.dst == NONE) {
+      continue;
+    }
+    ++defs[quad.dst];
+    if (ir::isElemAccess(quad)) {
+      kinds[quad.dst] = Kind::POINTER;
+      used = true;
+    }
+  }
+
+  for (ValueId value = 0; value < n; ++value) {
+    const auto &val = code.value(value);
+    if (val->isConst()) {
+      kinds[value] = Kind::CONST;
+    } else if (kinds[value] == Kind::SCALAR && isAggregate(val->type)) {
+      kinds[value]   = Kind::FRAME;
+      offsets[value] = total;
+      total += sizeOf(val->type);
+      used = true;
+      CHECK(sizeOf(val->type) <= MAX_OFFSET, std::format("{} is too large for the stack frame", val->str()));
+    }
+  }
+
+  // 只定义一次、以常量下标访问栈上数组/元组的别名，地址在编译时就确定了
+  for (const auto &quad : code.quads) {
+    if (!ir::isElemAccess(quad) || defs[quad.dst] != 1 || !code.value(quad.arg2)->isConst()) {
+      continue;
+    }
+    if (!inFrame(quad.arg1) && !isFixed(quad.arg1)) {
+      continue;
+    }
+    auto type = code.value(quad.arg1)->type;
+    auto idx  = ir::constValue(*code.value(quad.arg2));
+    if (idx < 0 || idx >= type->size()) {
+      continue; // 越界的访问留到运行时检查
+    }
+    kinds[quad.dst]   = Kind::FIXED;
+    offsets[quad.dst] = offsets[quad.arg1] + offsetOf(type, idx);
+  }
+}
+
+bool
+Aggregates::isStore(const ir::IRQuad &quad) const
+{
+  return quad.dst != NONE && isAlias(quad.dst) && !ir::isElemAccess(quad);
+}
+
+} // namespace cg
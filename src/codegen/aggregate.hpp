@@ -0,0 +1,89 @@
+/**
+ * @file aggregate.hpp
+ * @brief Frame layout of arrays and tuples, and the element aliases into them.
+ *
+ * Arrays and tuples never live in registers. Every scalar element (i32 or
+ * bool) takes one 4-byte word, so an aggregate is a contiguous run of words:
+ * element k of [T; N] starts at k * sizeOf(T), field k of a tuple after the
+ * fields before it. Each aggregate local or temporary gets its own area in
+ * the locals part of the frame; an aggregate parameter arrives as a pointer
+ * in its argument register and is copied there on entry, so arrays and
+ * tuples are passed by value.
+ *
+ * The dst of an INDEX or DOT quad is an alias of an element: it stands for
+ * the element's address. Reading it loads the element, assigning to it
+ * stores the element, and an aggregate element is used through the address
+ * directly. An alias defined once with a constant index into a frame
+ * aggregate, or into another such alias, has a fixed frame offset and needs
+ * no register; any other alias is a pointer allocated like a scalar.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "type.hpp"
+#include "ir_quad.hpp"
+
+namespace ir { class FuncCode; }
+
+namespace cg {
+
+class Aggregates {
+public:
+  explicit Aggregates(const ir::FuncCode &code);
+
+public:
+  static constexpr int WORD = 4; // 每个标量元素占的字节数
+
+  [[nodiscard]] static bool isAggregate(type::TypePtr type);
+  [[nodiscard]] static int sizeOf(type::TypePtr type);
+  [[nodiscard]] static int offsetOf(type::TypePtr type, int idx);
+
+  /**
+   * @brief 函数中是否用到数组或元组
+   */
+  [[nodiscard]] bool any() const { return used; }
+
+  [[nodiscard]] bool inFrame(ir::ValueId value) const { return kinds[value] == Kind::FRAME; }
+  [[nodiscard]] bool isAlias(ir::ValueId value) const {
+    return kinds[value] == Kind::POINTER || kinds[value] == Kind::FIXED;
+  }
+  [[nodiscard]] bool isFixed(ir::ValueId value) const { return kinds[value] == Kind::FIXED; }
+
+  /**
+   * @brief 值是否放在寄存器中（标量，或者地址不固定的元素别名）
+   */
+  [[nodiscard]] bool inRegister(ir::ValueId value) const {
+    return kinds[value] == Kind::SCALAR || kinds[value] == Kind::POINTER;
+  }
+
+  /**
+   * @brief 四元式是否经由元素别名写入数组/元组，而不是定义 dst
+   */
+  [[nodiscard]] bool isStore(const ir::IRQuad &quad) const;
+
+  /**
+   * @brief 栈上的数组/元组或地址固定的别名在局部区中的偏移
+   */
+  [[nodiscard]] int offset(ir::ValueId value) const { return offsets[value]; }
+  [[nodiscard]] int size() const { return total; }
+
+private:
+  enum class Kind : std::uint8_t {
+    CONST,   // 常量
+    SCALAR,  // i32、bool
+    FRAME,   // 栈上的数组/元组
+    POINTER, // 元素别名，地址放在寄存器中
+    FIXED,   // 元素别名，地址是栈帧中的固定偏移
+  };
+
+  std::vector<Kind> kinds;
+  std::vector<int>  offsets;
+  int               total = 0;
+  bool              used  = false;
+};
+
+} // namespace cg
@@ -1,13 +1,14 @@
 #pragma once
 
 #ifdef VERBOSE
-#include <print>
+#include <format>
 #endif
 
 namespace cg {
 
+// out 是 MCode：注释与指令一起缓存，保持原来的顺序
 #ifdef VERBOSE
-#define DBG(out, fmt, ...) std::println(out, fmt, ##__VA_ARGS__)
+#define DBG(out, fmt, ...) (out).comment(std::format(fmt, ##__VA_ARGS__))
 #else
 #define DBG(out, fmt, ...)
 #endif
@@ -1,185 +1,1215 @@
+#include <bit>
+#include <mutex>
 #include <print>
 #include <ranges>
+#include <sstream>
+#include <algorithm>
 
 #include "ast.hpp"
+#include "fold.hpp"
 #include "panic.hpp"
 #include "asm_dbg.hpp"
+#include "profile.hpp"
+#include "parallel.hpp"
 #include "ir_quad.hpp"
+#include "def_use.hpp"
+#include "func_code.hpp"
+#include "time_report.hpp"
 #include "symbol_table.hpp"
 #include "code_generate.hpp"
 
 namespace cg {
 
-CodeGenerator::CodeGenerator(std::ofstream &out,
-  sym::SymbolTable &symtab) : out(out), symtab(symtab)
+static int getConstantVal(const sym::ValuePtr &val);
+static ir::IROp invertCompare(ir::IROp op);
+
+// 数组/元组以 sp 为基址访存，偏移要在 12 位立即数之内
+static constexpr int MAX_FRAME = 2048;
+
+CodeGenerator::CodeGenerator(std::ostream &out, sym::SymbolTable &symtab,
+  const CodeGenOptions &opts, ElfWriter *obj) : out(out), symtab(symtab), opts(opts), obj(obj)
+{
+  stackalloc = std::make_unique<StackAllocator>(mc);
+  regalloc   = std::make_unique<RegAllocator>(mc, *stackalloc);
+  memalloc   = std::make_unique<MemAllocator>(
+    mc, *regalloc, *stackalloc, symtab.valueCount()
+  );
+}
+
+/**
+ * @brief 生成整个程序
+ * @param jobs 线程数：大于 1 时各函数在多个线程上并行生成，再按声明顺序输出，
+ *             输出与顺序生成逐字节相同
+ */
+void
+CodeGenerator::generate(const ast::Prog &prog, unsigned jobs)
+{
+  generateHeader();
+
+  std::vector<const ir::FuncCode *> funcs;
+  for (const auto &decl : prog.decls) {
+    if (const auto &funccode = static_cast<ast::FuncDeclPtr>(decl)->code; funccode) {
+      funcs.push_back(funccode.get());
+    }
+  }
+
+  if (jobs <= 1 || funcs.size() <= 1) {
+    for (const auto *funccode : funcs) {
+      generateFunc(*funccode);
+    }
+    return;
+  }
+
+  if (obj != nullptr) {
+    // 目标文件按声明顺序排布各函数，编码留在当前线程中进行
+    std::vector<std::vector<MInst>> insts(funcs.size());
+    forEachFunc(funcs, jobs, [&](CodeGenerator &gen, std::size_t i) {
+      const auto &code = gen.mc.instructions();
+      insts[i].assign(code.begin(), code.end());
+    });
+    for (const auto &code : insts) {
+      obj->addFunc(code);
+    }
+    return;
+  }
+
+  for (const auto &text : generateFuncs(funcs, jobs)) {
+    out.append(text);
+    out.flush();
+  }
+}
+
+/**
+ * @brief  在多个线程上生成若干函数的汇编，不写出
+ * @param  funcs 要生成的函数
+ * @param  jobs  线程数
+ * @return 各函数的汇编，与 funcs 一一对应
+ */
+std::vector<std::string>
+CodeGenerator::generateFuncs(std::span<const ir::FuncCode *const> funcs, unsigned jobs)
+{
+  std::vector<std::string> texts(funcs.size());
+  forEachFunc(funcs, jobs, [&](CodeGenerator &gen, std::size_t i) {
+    gen.mc.print(texts[i]);
+  });
+  return texts;
+}
+
+/**
+ * @brief 在 jobs 个线程上生成 funcs 中的各函数，每个函数生成完后调用 fn(gen, i)，
+ *        此时 gen.mc 中是函数 funcs[i] 的机器指令
+ *
+ * 除符号表的查询外各函数的代码生成互不相关：每个线程取用一个自己的 CodeGenerator
+ * （栈、寄存器与内存分配器和机器指令缓冲区），用完后放回，供之后的任务复用
+ */
+template <typename Fn>
+void
+CodeGenerator::forEachFunc(std::span<const ir::FuncCode *const> funcs, unsigned jobs, Fn &&fn)
 {
-  stackalloc = std::make_unique<StackAllocator>(out);
-  regalloc   = std::make_unique<RegAllocator>(out, *stackalloc);
-  memalloc   = std::make_unique<MemAllocator>(out, *regalloc, *stackalloc);
+  std::mutex mutex;
+  std::vector<std::unique_ptr<CodeGenerator>> idle;
+  util::parallelFor(funcs.size(), jobs, [&](std::size_t i) {
+    std::unique_ptr<CodeGenerator> gen;
+    {
+      std::lock_guard lock{mutex};
+      if (!idle.empty()) {
+        gen = std::move(idle.back());
+        idle.pop_back();
+      }
+    }
+    if (gen == nullptr) {
+      gen = std::make_unique<CodeGenerator>(out.stream(), symtab, opts);
+      gen->report = report;
+    }
+
+    gen->lowerFunc(*funcs[i]);
+    fn(*gen, i);
+    gen->mc.clear();
+
+    std::lock_guard lock{mutex};
+    idle.push_back(std::move(gen));
+  });
 }
 
+/**
+ * @brief 生成所有函数之前的段声明
+ */
 void
-CodeGenerator::generate(const ast::Prog &prog)
+CodeGenerator::generateHeader()
 {
-  std::println(out, "  .text");
-  std::println(out, "  .align 2\n");
+  out.println("  .text");
+  if (opts.compress) {
+    out.println("  .option arch, +c");
+  }
+  if (opts.vector) {
+    out.println("  .option arch, +v");
+  }
+  out.println("  .align 2\n");
+  out.flush();
+}
 
-  for (const auto &funcdecl : prog.decls) {
-    generateFunc(funcdecl->ircode);
+void
+CodeGenerator::generateFunc(const ir::FuncCode &funccode)
+{
+  lowerFunc(funccode);
+  if (obj != nullptr) {
+    obj->addFunc(mc.instructions());
+  } else {
+    mc.print(out.text());
+    out.flush();
   }
+  mc.clear();
 }
 
+/**
+ * @brief 生成一个函数的机器指令（经过窥孔优化、调度与压缩）到 mc 中，不输出
+ */
 void
-CodeGenerator::generateFunc(const std::vector<ir::IRQuadPtr> &funccode)
+CodeGenerator::lowerFunc(const ir::FuncCode &funccode)
 {
-  for (const auto &code : funccode) {
-    DBG(out, "  # {}", code->str());
+  func = &funccode;
+  std::optional<util::TimeScope> phase{std::in_place, report, "select"};
+
+  // 四元式连续存放，顺序扫描即可
+  const auto &quads = funccode.quads;
+  uses.assign(funccode.valueCount(), 0);
+  for (const auto &code : quads) {
+    ir::forEachUse(funccode, code, [this](ir::ValueId value) { ++uses[value]; });
+  }
+
+  agg  = std::make_unique<Aggregates>(funccode);
+  live = std::make_unique<Liveness>(funccode, *agg);
+  CHECK(!agg->any() || opts.regalloc == RegAllocKind::LINEAR_SCAN,
+    "arrays and tuples need -fregalloc=linear");
 
-    switch (code->op) {
+  // 只有尾调用的函数不需要保存 ra
+  leaf = true;
+  for (std::size_t i = 0; i < quads.size(); ++i) {
+    leaf = leaf && (quads[i].op != ir::IROp::CALL || isTailCall(i));
+  }
+
+  scan.reset();
+  ranges.reset();
+  stubs.clear();
+  emitted = 0;
+  oob  = false;
+  cold = false;
+  if (opts.regalloc == RegAllocKind::LINEAR_SCAN) {
+    scan  = std::make_unique<LinearScan>(funccode, *live, opts.compress);
+    frame = scan->frame(!leaf, agg->size());
+    if (agg->any()) {
+      CHECK(frame.size <= MAX_FRAME, std::format("stack frame of {} is too large", funccode.name));
+      for (ir::ValueId value = 0; value < funccode.valueCount(); ++value) {
+        if (agg->inFrame(value) || agg->isFixed(value)) {
+          funccode.value(value)->frameaddr = frame.locals + agg->offset(value);
+        }
+      }
+      ranges = std::make_unique<ValueRanges>(funccode, *live);
+    }
+    wrap = shrinkWrap();
+  } else {
+    across.assign(funccode.valueCount(), false);
+    for (std::size_t i = 0; i < quads.size(); ++i) {
+      if (quads[i].op == ir::IROp::CALL) {
+        auto after = live->liveAfter(i);
+        for (ir::ValueId value = 0; value < funccode.valueCount(); ++value) {
+          across[value] = across[value] || after.test(value);
+        }
+      }
+    }
+  }
+
+  for (index = 0; index < quads.size(); ++index) {
+    const auto &code = quads[index];
+    DBG(mc, "  # {}", func->str(code));
+
+    if (scan) {
+      // 栈帧推迟到块 wrap 才建立：块首是标号时放在标号之后
+      if (wrap != 0 && wrap < live->blocks().size() && index == live->block(wrap).begin
+        && code.op != ir::IROp::LABEL)
+      {
+        emitPrologue();
+      }
+      emitMoves(scan->splitMoves(index));
+    }
+
+    // call 之后紧跟返回其结果的 return：拆除栈帧后直接跳转，return 不再生成
+    if (code.op == ir::IROp::CALL && isTailCall(index)) {
+      emitTailCall(code);
+      ++index;
+      DBG(mc, "");
+      continue;
+    }
+
+    switch (code.op) {
       case ir::IROp::ADD: case ir::IROp::SUB:
       case ir::IROp::MUL: case ir::IROp::DIV:
       case ir::IROp::EQ:  case ir::IROp::NEQ:
       case ir::IROp::GT:  case ir::IROp::GEQ:
       case ir::IROp::LT:  case ir::IROp::LEQ:
-        emitBinary(code);
+        if (fusesWithBranch(index)) {
+          emitCmpBranch(code);
+        } else {
+          emitBinary(code);
+        }
         break;
       case ir::IROp::ASSIGN: emitAssign(code); break;
       case ir::IROp::GOTO:   emitGoto(code);   break;
       case ir::IROp::BEQZ:   emitBeqz(code);   break;
       case ir::IROp::BNEZ:   emitBnez(code);   break;
       case ir::IROp::BGE:    emitBge(code);    break;
-      case ir::IROp::LABEL:  emitLabel(code);  break;
+      case ir::IROp::LABEL:
+        emitLabel(code);
+        if (auto loop = matchVectorLoop(index); loop) {
+          emitVectorLoop(*loop);
+        }
+        break;
       case ir::IROp::CALL:   emitCall(code);   break;
       case ir::IROp::FUNC:   emitFunc(code);   break;
       case ir::IROp::RETURN: emitRet(code);    break;
+      case ir::IROp::INDEX: case ir::IROp::DOT:
+        emitIndex(code);
+        break;
+      case ir::IROp::MAKE_ARR: case ir::IROp::MAKE_TUP:
+        emitMake(code);
+        break;
+      case ir::IROp::PROBE:  emitProbe(code);  break;
       default:
         UNREACHABLE(
-          std::format("unsupport ir operator {}", ir::irop2str(code->op))
+          std::format("unsupport ir operator {}", ir::irop2str(code.op))
         );
     }
 
-    DBG(out, "");
+    if (scan) {
+      if (wrap != 0 && wrap < live->blocks().size() && index == live->block(wrap).begin
+        && code.op == ir::IROp::LABEL)
+      {
+        emitPrologue();
+      }
+      emitFallThrough();
+    }
+    DBG(mc, "");
+  }
+
+  if (scan) {
+    emitEdgeStubs();
+  }
+  emitOobExit();
+  if (cold) {
+    mc.directive(".text");
+  }
+
+  phase.emplace(report, "peephole");
+  mc.peephole();
+  if (opts.schedule) {
+    phase.emplace(report, "schedule");
+    mc.schedule(*opts.target);
   }
+  if (opts.compress) {
+    phase.emplace(report, "compress");
+    mc.compress();
+    auto size = mc.codeSize();
+    mc.comment(std::format("  # {}: {} bytes, {} of {} instructions compressed", func->name, size.bytes,
+      size.compressed, size.insts));
+  }
+
+  if (report != nullptr) {
+    phase.reset();
+    report->count("machine instructions", mc.codeSize().insts);
+    report->count("spilled values", scan ? scan->spilledCount() : 0);
+  }
+}
+
+/**
+ * @brief 第 i 个四元式是否是尾调用：call 之后紧跟返回其结果的 return；
+ *        实参中有数组/元组时不是，被调用者要从当前函数的栈帧中复制它们
+ */
+bool
+CodeGenerator::isTailCall(std::size_t i) const
+{
+  const auto &quads = func->quads;
+  return quads[i].op == ir::IROp::CALL && i + 1 < quads.size() && quads[i + 1].op == ir::IROp::RETURN
+    && (quads[i + 1].arg1 == ir::NONE || quads[i + 1].arg1 == quads[i].dst)
+    && std::ranges::none_of(func->elems(quads[i].elems), [this](ir::ValueId arg) {
+         return Aggregates::isAggregate(func->value(arg)->type);
+       });
 }
 
+/**
+ * @brief 块是否要在栈帧建立之后执行：有非尾调用，或用到溢出槽、被调用者保存寄存器
+ */
+bool
+CodeGenerator::needsFrame(std::size_t block) const
+{
+  const auto &range = live->block(block);
+  for (auto i = range.begin; i < range.end; ++i) {
+    if (func->quads[i].op == ir::IROp::CALL && !isTailCall(i)) {
+      return true;
+    }
+  }
+  return scan->usesFrame(LinearScan::usePos(range.begin), LinearScan::usePos(range.end));
+}
+
+/**
+ * @brief  选择建立栈帧的块（shrink-wrapping）
+ *
+ * 取第一个需要栈帧的块 w：它之前的块（如递归的出口）不建立栈帧，直接返回。
+ * 要求控制流只能从 w 之前的块经由 w 进入其后的块，且不会再回到 w 及之前，
+ * 这样 w 之后的代码都恰好经过一次栈帧的建立；进入 w 的边上的搬移也不能
+ * 触及栈帧。w 之后只从 w 之前的块进入、不需要栈帧的返回块（如布局移到
+ * 函数末尾的提前返回）同样不建立栈帧，记在 unframed 中。不满足时退回到函数入口。
+ *
+ * @return 建立栈帧的块；不需要栈帧时为块数
+ */
+std::size_t
+CodeGenerator::shrinkWrap()
+{
+  auto blocks = live->blocks();
+  unframed.assign(blocks.size(), false);
+  if (frame.size == 0) {
+    return blocks.size();
+  }
+  if (agg->any()) {
+    return 0; // 数组/元组的地址以建立栈帧后的 sp 为基址
+  }
+
+  std::size_t first = 0;
+  while (first < blocks.size() && !needsFrame(first)) {
+    ++first;
+  }
+  if (first == 0 || first == blocks.size()) {
+    return 0;
+  }
+
+  std::vector<bool> late(blocks.size(), false);
+  for (auto b = first + 1; b < blocks.size(); ++b) {
+    late[b] = blocks[b].succs.empty() && !needsFrame(b);
+  }
+  for (auto b = first; b < blocks.size(); ++b) {
+    for (auto succ : blocks[b].succs) {
+      late[succ] = false;
+    }
+  }
+
+  auto framed = [](const Location &loc) {
+    return loc.kind == Location::Kind::STACK || (loc.isReg() && !isCaller(loc.reg));
+  };
+  for (std::size_t b = 0; b < blocks.size(); ++b) {
+    for (auto succ : blocks[b].succs) {
+      if (b < first ? (succ > first && !late[succ]) : (succ <= first)) {
+        return 0;
+      }
+      if (b < first && (succ == first || late[succ])) {
+        for (const auto &move : scan->edgeMoves(b, succ)) {
+          if (framed(move.from) || framed(move.to)) {
+            return 0;
+          }
+        }
+      }
+    }
+  }
+  unframed = std::move(late);
+  return first;
+}
+
+/**
+ * @brief 数组/元组或元素别名的地址：栈上的在 sp 的固定偏移处，
+ *        其余的是寄存器中的指针，溢出到栈上时先装入 scratch
+ */
+CodeGenerator::Addr
+CodeGenerator::addressOf(ir::ValueId value, Register scratch)
+{
+  if (agg->inFrame(value) || agg->isFixed(value)) {
+    return {.base = Register::SP, .offset = func->value(value)->frameaddr};
+  }
+  auto loc = scan->location(value, LinearScan::usePos(index));
+  if (loc.isReg()) {
+    return {.base = loc.reg, .offset = 0};
+  }
+  emitMove(loc, Location::inReg(scratch));
+  return {.base = scratch, .offset = 0};
+}
+
+/**
+ * @brief 把数组/元组 from 逐字复制到 to，借用 t5；to 的基址不能是 t5
+ */
 void
-CodeGenerator::emitFunc(const ir::IRQuadPtr &code)
+CodeGenerator::copyWords(ir::ValueId from, const Addr &to, int size)
 {
-  std::println(out, ".global {}", code->label);
-  std::println(out, "{}:", code->label);
+  auto src = addressOf(from, Register::T5);
+  for (int word = 0; word < size; word += Aggregates::WORD) {
+    if (word != 0 && src.base == Register::T5) {
+      src = addressOf(from, Register::T5); // 溢出的指针被上一个字覆盖了
+    }
+    mc.load(MOp::LW, Register::T5, src.offset + word, src.base);
+    mc.store(MOp::SW, Register::T5, to.offset + word, to.base);
+  }
+}
+
+/**
+ * @brief 读取一个值，返回它所在的寄存器；
+ *        线性扫描分配时，常量与栈上的值先装入 scratch，元素别名读出元素
+ */
+Register
+CodeGenerator::useReg(ir::ValueId value, Register scratch)
+{
+  if (!scan) {
+    return memalloc->alloc(func->value(value), false, across[value]);
+  }
+
+  if (func->value(value)->isConst()) {
+    mc.li(scratch, getConstantVal(func->value(value)));
+    return scratch;
+  }
+  if (agg->isAlias(value)) {
+    auto addr = addressOf(value, scratch);
+    mc.load(MOp::LW, scratch, addr.offset, addr.base);
+    return scratch;
+  }
+  auto loc = scan->location(value, LinearScan::usePos(index));
+  if (loc.isReg()) {
+    return loc.reg;
+  }
+  emitMove(loc, Location::inReg(scratch));
+  return scratch;
+}
+
+/**
+ * @brief 写入一个值的寄存器；线性扫描分配时栈上的值与要存入的元素先写入 t5，
+ *        再由 flushDef 存回
+ */
+Register
+CodeGenerator::defReg(ir::ValueId value)
+{
+  if (!scan) {
+    return memalloc->alloc(func->value(value), true, across[value]);
+  }
+
+  if (agg->isStore(func->quads[index])) {
+    return Register::T5;
+  }
+  auto loc = scan->location(value, LinearScan::defPos(index));
+  return loc.isReg() ? loc.reg : Register::T5;
+}
+
+void
+CodeGenerator::flushDef(ir::ValueId value, Register reg)
+{
+  if (!scan) {
+    return;
+  }
+  if (agg->isStore(func->quads[index])) {
+    auto addr = addressOf(value, Register::T6);
+    mc.store(MOp::SW, reg, addr.offset, addr.base);
+    return;
+  }
+  emitMove(Location::inReg(reg), scan->location(value, LinearScan::defPos(index)));
+}
+
+/**
+ * @brief 装入立即数的寄存器：线性扫描分配时为 t6，贪心分配时直接借用目标寄存器
+ */
+Register
+CodeGenerator::immScratch(Register dst) const
+{
+  return scan ? Register::T6 : dst;
+}
+
+/**
+ * @brief 条件跳转的目标；跳转的边上需要搬移时改为跳到桩代码
+ */
+std::string
+CodeGenerator::branchTarget(const ir::IRQuad &code)
+{
+  const auto &label = func->label(code.label);
+  if (!scan) {
+    return label;
+  }
+
+  auto from = live->blockOf(index);
+  auto to   = live->labelBlock(code.label);
+  if (scan->edgeMoves(from, to).empty()) {
+    return label;
+  }
+  stubs.push_back({
+    .label  = std::format("{}_edge{}", func->name, stubs.size()),
+    .from   = from,
+    .to     = to,
+    .target = label,
+  });
+  return stubs.back().label;
+}
+
+void
+CodeGenerator::emitMove(const Location &from, const Location &to)
+{
+  if (from == to) {
+    return;
+  }
+
+  if (from.isReg() && to.isReg()) {
+    mc.mv(to.reg, from.reg);
+  } else if (from.isReg()) {
+    mc.store(MOp::SD, from.reg, Frame::slot(to.slot), Register::SP);
+  } else if (to.isReg()) {
+    mc.load(MOp::LD, to.reg, Frame::slot(from.slot), Register::SP);
+  } else {
+    mc.load(MOp::LD, Register::T5, Frame::slot(from.slot), Register::SP);
+    mc.store(MOp::SD, Register::T5, Frame::slot(to.slot), Register::SP);
+  }
+}
+
+/**
+ * @brief 同时完成一组搬移：每次先做目标不再被读取的搬移，
+ *        剩下的只能是寄存器之间的环，借 t6 打开
+ */
+void
+CodeGenerator::emitMoves(std::vector<Move> moves)
+{
+  std::erase_if(moves, [](const Move &move) { return move.from == move.to; });
+  while (!moves.empty()) {
+    auto ready = std::ranges::find_if(moves, [&moves](const Move &move) {
+      return std::ranges::none_of(moves, [&move](const Move &other) { return other.from == move.to; });
+    });
+    if (ready != moves.end()) {
+      emitMove(ready->from, ready->to);
+      moves.erase(ready);
+      continue;
+    }
+
+    auto blocked = moves.front().to;
+    auto temp    = Location::inReg(Register::T6);
+    emitMove(blocked, temp);
+    for (auto &move : moves) {
+      if (move.from == blocked) {
+        move.from = temp;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 实参同时搬入 a0-a7，常量与栈上的元素最后再装入；
+ *        数组/元组传递地址，由被调用者复制
+ */
+void
+CodeGenerator::emitArgs(const ir::IRQuad &code)
+{
+  auto args = func->elems(code.elems);
+  CHECK(args.size() <= 8, "parameter > 8");
+
+  std::vector<Move> moves;
+  for (std::size_t k = 0; k < args.size(); ++k) {
+    if (live->tracked(args[k])) {
+      moves.push_back({
+        .from = scan->location(args[k], LinearScan::usePos(index)),
+        .to   = Location::inReg(toReg(static_cast<int>(k))),
+      });
+    }
+  }
+  emitMoves(std::move(moves));
+
+  for (std::size_t k = 0; k < args.size(); ++k) {
+    auto reg = toReg(static_cast<int>(k));
+    const auto &arg = func->value(args[k]);
+    if (arg->isConst()) {
+      mc.li(reg, getConstantVal(arg));
+    } else if (Aggregates::isAggregate(arg->type)) {
+      if (!agg->inRegister(args[k])) {
+        mc.opImm(MOp::ADDI, reg, Register::SP, arg->frameaddr);
+      }
+    } else if (agg->isFixed(args[k])) {
+      mc.load(MOp::LW, reg, arg->frameaddr, Register::SP);
+    } else if (agg->isAlias(args[k])) {
+      mc.load(MOp::LW, reg, 0, reg);
+    }
+  }
+}
+
+/**
+ * @brief 块的最后一个四元式之后，补上顺序进入下一个块的边上的搬移
+ */
+void
+CodeGenerator::emitFallThrough()
+{
+  auto block = live->blockOf(index);
+  auto op    = func->quads[index].op;
+  if (index + 1 != live->block(block).end || block + 1 == live->blocks().size()
+    || op == ir::IROp::GOTO || op == ir::IROp::RETURN)
+  {
+    return;
+  }
+  emitMoves(scan->edgeMoves(block, block + 1));
+}
+
+/**
+ * @brief 在函数末尾生成条件跳转边上的桩代码
+ */
+void
+CodeGenerator::emitEdgeStubs()
+{
+  for (; emitted < stubs.size(); ++emitted) {
+    const auto &stub = stubs[emitted];
+    mc.label(stub.label);
+    emitMoves(scan->edgeMoves(stub.from, stub.to));
+    mc.jump(MOp::J, stub.target);
+  }
+}
+
+/**
+ * @brief 越界检查跳到的 ebreak，热、冷两部分各有一个
+ */
+void
+CodeGenerator::emitOobExit()
+{
+  if (oob) {
+    mc.label(oobLabel());
+    mc.ebreak();
+  }
+  oob = false;
+}
+
+std::string
+CodeGenerator::oobLabel() const
+{
+  return std::format("{}_oob{}", func->name, cold ? "_cold" : "");
+}
+
+/**
+ * @brief 进入函数的冷块部分（剖析数据中从未执行的块，见 opt/layout.hpp）：
+ *        先在热的部分末尾生成至此为止的桩代码与越界出口，再切换到 .text.unlikely，
+ *        两部分之间只有无条件跳转；生成目标文件时不拆分
+ */
+void
+CodeGenerator::enterCold()
+{
+  if (obj != nullptr || cold) {
+    return;
+  }
+  if (scan) {
+    emitEdgeStubs();
+  }
+  emitOobExit();
+  cold = true;
+  mc.directive(".section .text.unlikely,\"ax\",@progbits");
+}
+
+/**
+ * @brief 建立栈帧：一次移动 sp，保存 ra 与用到的被调用者保存寄存器
+ */
+void
+CodeGenerator::emitPrologue()
+{
+  DBG(mc, "  # frame: {} bytes", frame.size);
+  mc.opImm(MOp::ADDI, Register::SP, Register::SP, -frame.size);
+  if (frame.ra >= 0) {
+    mc.store(MOp::SD, Register::RA, frame.ra, Register::SP);
+  }
+  for (const auto &[reg, offset] : frame.callee) {
+    mc.store(MOp::SD, reg, offset, Register::SP);
+  }
+}
+
+/**
+ * @brief 恢复被调用者保存寄存器与 ra，释放栈帧；
+ *        栈帧尚未建立的块（shrink-wrapping 之前）不需要
+ */
+void
+CodeGenerator::emitEpilogue()
+{
+  if (live->blockOf(index) < wrap || unframed[live->blockOf(index)]) {
+    return;
+  }
+  for (const auto &[reg, offset] : frame.callee) {
+    mc.load(MOp::LD, reg, offset, Register::SP);
+  }
+  if (frame.ra >= 0) {
+    mc.load(MOp::LD, Register::RA, frame.ra, Register::SP);
+  }
+  mc.opImm(MOp::ADDI, Register::SP, Register::SP, frame.size);
+}
+
+void
+CodeGenerator::emitFunc(const ir::IRQuad &code)
+{
+  if (code.label == func->cold) {
+    enterCold();
+  }
+  mc.directive(std::format(".global {}", func->label(code.label)));
+  mc.label(func->label(code.label));
+
+  if (scan) {
+#ifdef VERBOSE
+    std::ostringstream dump;
+    scan->dump(dump);
+    for (auto line : std::views::split(dump.view(), '\n')) {
+      if (!line.empty()) {
+        mc.comment(std::string{line.begin(), line.end()});
+      }
+    }
+#endif
+    CHECK(func->params.size() <= 8, "argument > 8");
+    if (wrap == 0) {
+      emitPrologue();
+    }
+
+    // 数组/元组形参从 a0-a7 指向的地址复制到栈帧中
+    for (std::size_t k = 0; k < func->params.size(); ++k) {
+      const auto &param = func->value(func->params[k]);
+      if (!agg->inFrame(func->params[k])) {
+        continue;
+      }
+      for (int word = 0; word < Aggregates::sizeOf(param->type); word += Aggregates::WORD) {
+        mc.load(MOp::LW, Register::T5, word, toReg(static_cast<int>(k)));
+        mc.store(MOp::SW, Register::T5, param->frameaddr + word, Register::SP);
+      }
+    }
+
+    // 形参从 a0-a7 搬到分配给它们的位置
+    std::vector<Move> moves;
+    for (std::size_t k = 0; k < func->params.size(); ++k) {
+      if (!live->tracked(func->params[k])) {
+        continue;
+      }
+      moves.push_back({
+        .from = Location::inReg(toReg(static_cast<int>(k))),
+        .to   = scan->location(func->params[k], LinearScan::defPos(index)),
+      });
+    }
+    emitMoves(std::move(moves));
+    return;
+  }
+
   stackalloc->reset();
-  stackalloc->enterFunc();
+  stackalloc->enterFunc(leaf);
   regalloc->reset();
   memalloc->reset();
 
-  auto opt_func = symtab.lookupFunc(code->label);
+  auto opt_func = symtab.lookupFunc(func->label(code.label));
   CHECK(opt_func.has_value(), "can't find function symbol");
-  const auto &func = opt_func.value();
-  memalloc->allocArgv(func->argv);
+  const auto &funcsym = opt_func.value();
+  memalloc->allocArgv(funcsym->argv);
 }
 
 void
-CodeGenerator::emitRet(const ir::IRQuadPtr &code)
+CodeGenerator::emitRet(const ir::IRQuad &code)
 {
-  if (code->arg1.value != nullptr) {
-    DBG(out, "  # prepare return value");
-    auto retval = code->arg1.value;
+  if (scan) {
+    if (code.arg1 != ir::NONE) {
+      CHECK(!Aggregates::isAggregate(func->value(code.arg1)->type),
+        "returning arrays and tuples is not supported");
+      DBG(mc, "  # prepare return value");
+      if (func->value(code.arg1)->isConst() || agg->isAlias(code.arg1)) {
+        useReg(code.arg1, Register::A0);
+      } else {
+        emitMove(scan->location(code.arg1, LinearScan::usePos(index)), Location::inReg(Register::A0));
+      }
+    }
+    emitEpilogue();
+    mc.ret();
+    return;
+  }
+
+  if (func->value(code.arg1) != nullptr) {
+    DBG(mc, "  # prepare return value");
+    auto retval = func->value(code.arg1);
     if (retval->isConst()) {
-      std::println(out, "  li a0, {}", retval->str());
+      mc.li(Register::A0, getConstantVal(retval));
     } else {
       auto opt_sym = memalloc->lookup(retval);
       ASSERT_MSG(opt_sym.has_value(), "can't find this symbol");
       const auto &symbol = opt_sym.value();
       if (symbol->on_stack) {
-        std::println(out,
-          "  lw a0, {}(sp)",
-          stackalloc->offsetFromSP(symbol->stackloc)
-        );
+        mc.load(MOp::LW, Register::A0, stackalloc->offsetFromSP(symbol->stackloc), Register::SP);
       } else {
-        std::println(out,
-          "  mv a0, {}",
-          symbol->regloc
-        );
+        mc.mv(Register::A0, symbol->regloc);
       }
     }
   }
 
+  regalloc->restoreUsedCallee();
   stackalloc->retFunc();
 
-  std::println(out, "  ret");
+  mc.ret();
 }
 
 void
-CodeGenerator::emitAssign(const ir::IRQuadPtr &code)
+CodeGenerator::emitAssign(const ir::IRQuad &code)
 {
-  if (code->arg1.value->isConst()) {
-    auto dst = memalloc->alloc(code->dst.value, true);
-    std::println(out, "  li {}, {}", dst, code->arg1.value->str());
+  if (scan && Aggregates::isAggregate(func->value(code.dst)->type)) {
+    copyWords(code.arg1, addressOf(code.dst, Register::T6), Aggregates::sizeOf(func->value(code.dst)->type));
     return;
   }
 
-  auto src = memalloc->alloc(code->arg1.value, false);
-  auto dst = memalloc->alloc(code->dst.value, true);
+  if (func->value(code.arg1)->isConst()) {
+    auto dst = defReg(code.dst);
+    mc.li(dst, getConstantVal(func->value(code.arg1)));
+    flushDef(code.dst, dst);
+    return;
+  }
 
-  std::println(out, "  mv {}, {}", dst, src);
+  if (scan && (agg->isAlias(code.arg1) || agg->isStore(code))) {
+    // 经由元素别名读写数组/元组
+    auto src = useReg(code.arg1, Register::T5);
+    if (agg->isStore(code)) {
+      flushDef(code.dst, src);
+      return;
+    }
+    auto dst = defReg(code.dst);
+    if (src != dst) {
+      mc.mv(dst, src);
+    }
+    flushDef(code.dst, dst);
+    return;
+  }
+
+  if (scan) {
+    auto from = scan->location(code.arg1, LinearScan::usePos(index));
+    auto to   = scan->location(code.dst, LinearScan::defPos(index));
+    if (from == to) {
+      DBG(mc, "  # {} shares {}'s location", func->value(code.dst)->str(), func->value(code.arg1)->str());
+      return;
+    }
+    emitMove(from, to);
+    return;
+  }
+
+  // 源是只在这里使用一次的临时变量时，复制之后它就不再活跃：
+  // 目标直接接管它的寄存器，不需要 mv
+  const auto &srcval = func->value(code.arg1);
+  if (srcval->kind == sym::Value::Kind::TEMP && uses[code.arg1] == 1
+    && memalloc->coalesce(srcval, func->value(code.dst)))
+  {
+    DBG(mc, "  # {} reuses {}'s register", func->value(code.dst)->str(), srcval->str());
+    return;
+  }
+
+  auto src = memalloc->alloc(srcval, false, across[code.arg1]);
+  auto dst = memalloc->alloc(func->value(code.dst), true, across[code.dst]);
+
+  mc.mv(dst, src);
+}
+
+void
+CodeGenerator::emitGoto(const ir::IRQuad &code)
+{
+  if (scan) {
+    emitMoves(scan->edgeMoves(live->blockOf(index), live->labelBlock(code.label)));
+  }
+  mc.jump(MOp::J, func->label(code.label));
+}
 
-  // DBG(out,
-  //   "  # {} reuses {}'s register",
-  //   code->dst.value->str(),
-  //   code->arg1.value->str()
-  // );
-  // memalloc->reuseReg(src, code->dst.value);
+void
+CodeGenerator::emitBeqz(const ir::IRQuad &code)
+{
+  auto cond = useReg(code.arg1, Register::T5);
+  emitCondJump(ir::IROp::EQ, cond, Register::ZERO);
 }
 
 void
-CodeGenerator::emitGoto(const ir::IRQuadPtr &code)
+CodeGenerator::emitBnez(const ir::IRQuad &code)
+{
+  auto cond = useReg(code.arg1, Register::T5);
+  emitCondJump(ir::IROp::NEQ, cond, Register::ZERO);
+}
+
+void
+CodeGenerator::emitBge(const ir::IRQuad &code)
+{
+  auto lhs = useReg(code.arg1, Register::T5);
+  auto rhs = useReg(code.arg2, Register::T6);
+  emitCondJump(ir::IROp::GEQ, lhs, rhs);
+}
+
+/**
+ * @brief 第 i 个四元式是否是只被紧接着的 beqz/bnez 使用的比较：
+ *        两者合成一条比较跳转指令，比较结果不再写入寄存器
+ */
+bool
+CodeGenerator::fusesWithBranch(std::size_t i) const
 {
-  std::println(out, "  j {}", code->label);
+  const auto &quads = func->quads;
+  const auto &cmp   = quads[i];
+  if (i + 1 >= quads.size() || !ir::isCompare(cmp.op)) {
+    return false;
+  }
+  if (func->value(cmp.arg1)->isConst() && func->value(cmp.arg2)->isConst()) {
+    return false;
+  }
+  const auto &branch = quads[i + 1];
+  return (branch.op == ir::IROp::BEQZ || branch.op == ir::IROp::BNEZ) && branch.arg1 == cmp.dst
+    && uses[cmp.dst] == 1 && !agg->isAlias(cmp.dst) && (!scan || scan->splitMoves(i + 1).empty());
 }
 
+/**
+ * @brief 比较与其后的 beqz/bnez 合成一条比较跳转指令；常量 0 直接用 x0
+ */
 void
-CodeGenerator::emitBeqz(const ir::IRQuadPtr &code)
+CodeGenerator::emitCmpBranch(const ir::IRQuad &code)
+{
+  auto operand = [this](ir::ValueId value, Register scratch) {
+    const auto &val = func->value(value);
+    return val->isConst() && getConstantVal(val) == 0 ? Register::ZERO : useReg(value, scratch);
+  };
+  auto lhs = operand(code.arg1, Register::T5);
+  auto rhs = operand(code.arg2, Register::T6);
+
+  ++index;
+  const auto &branch = func->quads[index];
+  DBG(mc, "  # {} (fused)", func->str(branch));
+  emitCondJump(branch.op == ir::IROp::BNEZ ? code.op : invertCompare(code.op), lhs, rhs);
+}
+
+/**
+ * @brief 第 i 个四元式（条件跳转）之后是否是 goto 与条件跳转目标的标号：
+ *        反转条件直接跳到 goto 的目标，顺序进入原来的目标，省去 goto；
+ *        线性扫描分配时这些边上都不能有搬移，goto 所在的块也不能建立栈帧
+ */
+bool
+CodeGenerator::skipsJump(std::size_t i) const
 {
-  auto cond = memalloc->alloc(code->arg1.value, false);
-  std::println(out, "  beq {}, x0, {}", cond, code->label);
+  const auto &quads = func->quads;
+  if (i + 2 >= quads.size() || quads[i + 1].op != ir::IROp::GOTO || quads[i + 2].op != ir::IROp::LABEL
+    || quads[i + 2].label != quads[i].label)
+  {
+    return false;
+  }
+  if (!scan) {
+    return true;
+  }
+  auto from  = live->blockOf(i);
+  auto jump  = live->blockOf(i + 1);
+  auto label = live->blockOf(i + 2);
+  return jump != wrap && scan->edgeMoves(from, jump).empty() && scan->edgeMoves(from, label).empty()
+    && scan->edgeMoves(jump, live->labelBlock(quads[i + 1].label)).empty();
 }
 
+/**
+ * @brief 第 index 个四元式的条件跳转：lhs op rhs 成立时跳转
+ */
 void
-CodeGenerator::emitBnez(const ir::IRQuadPtr &code)
+CodeGenerator::emitCondJump(ir::IROp op, Register lhs, Register rhs)
 {
-  auto cond = memalloc->alloc(code->arg1.value, false);
-  std::println(out, "  bne {}, x0, {}", cond, code->label);
+  std::string target;
+  if (skipsJump(index)) {
+    op = invertCompare(op);
+    ++index;
+    DBG(mc, "  # {} (inverted into the branch)", func->str(func->quads[index]));
+    target = func->label(func->quads[index].label);
+  } else {
+    target = branchTarget(func->quads[index]);
+  }
+
+  switch (op) {
+    case ir::IROp::EQ:  mc.branch(MOp::BEQ, lhs, rhs, target); break;
+    case ir::IROp::NEQ: mc.branch(MOp::BNE, lhs, rhs, target); break;
+    case ir::IROp::LT:  mc.branch(MOp::BLT, lhs, rhs, target); break;
+    case ir::IROp::GEQ: mc.branch(MOp::BGE, lhs, rhs, target); break;
+    case ir::IROp::GT:  mc.branch(MOp::BLT, rhs, lhs, target); break;
+    case ir::IROp::LEQ: mc.branch(MOp::BGE, rhs, lhs, target); break;
+    default:
+      UNREACHABLE(std::format("invalid comparison {}", ir::irop2str(op)));
+  }
 }
 
 void
-CodeGenerator::emitBge(const ir::IRQuadPtr &code)
+CodeGenerator::emitLabel(const ir::IRQuad &code)
 {
-  auto lhs = memalloc->alloc(code->arg1.value, false);
-  auto rhs = memalloc->alloc(code->arg2.value, false);
+  if (code.label == func->cold) {
+    enterCold();
+  }
+  mc.label(func->label(code.label));
+}
 
-  std::println(out, "  bge {}, {}, {}", lhs, rhs, code->label);
+/**
+ * @brief 插桩的块计数：__toy_prof_counts[k] += 1，只使用不保存值的 t5/t6
+ */
+void
+CodeGenerator::emitProbe(const ir::IRQuad &code)
+{
+  CHECK(scan != nullptr, "--profile-generate needs -fregalloc=linear");
+  auto slot = getConstantVal(func->value(code.arg1));
+  mc.lla(Register::T5, std::format("{}+{}", opt::PROFILE_COUNTERS, slot * 8));
+  mc.load(MOp::LD, Register::T6, 0, Register::T5);
+  mc.opImm(MOp::ADDI, Register::T6, Register::T6, 1);
+  mc.store(MOp::SD, Register::T6, 0, Register::T5);
 }
 
 void
-CodeGenerator::emitLabel(const ir::IRQuadPtr &code)
+CodeGenerator::emitCall(const ir::IRQuad &code)
 {
-  std::println(out, "{}:", code->label);
+  if (scan) {
+    // 跨过调用活跃的值不在调用者保存寄存器中，不需要保存
+    CHECK(code.dst == ir::NONE || !Aggregates::isAggregate(func->value(code.dst)->type),
+      "functions returning arrays and tuples are not supported");
+    emitArgs(code);
+    mc.jump(MOp::CALL, func->label(code.label));
+    if (code.dst != ir::NONE) {
+      flushDef(code.dst, Register::A0);
+    }
+    return;
+  }
+
+  regalloc->spillCaller(savedAtCall(code));
+
+  auto params = func->elems(code.elems)
+    | std::views::transform([this](ir::ValueId elem) {
+        return func->value(elem);
+      })
+    | std::ranges::to<std::vector>();
+  memalloc->prepareParam(params);
+
+  mc.jump(MOp::CALL, func->label(code.label));
+  memalloc->reuseReg(Register::A0, func->value(code.dst));
 }
 
+/**
+ * @brief 贪心分配时调用前需要留存的值：调用之后仍然活跃的值与实参，
+ *        其余在调用者保存寄存器中的值直接丢弃，不必写回栈上
+ * @return 这些值的 sym::Value 编号
+ */
+std::unordered_set<std::uint32_t>
+CodeGenerator::savedAtCall(const ir::IRQuad &code) const
+{
+  std::unordered_set<std::uint32_t> saved;
+  auto after = live->liveAfter(index);
+  for (ir::ValueId value = 0; value < func->valueCount(); ++value) {
+    if (after.test(value)) {
+      saved.insert(func->value(value)->id);
+    }
+  }
+  for (auto arg : func->elems(code.elems)) {
+    saved.insert(func->value(arg)->id);
+  }
+  return saved;
+}
+
+/**
+ * @brief 尾调用：准备好实参，恢复被调用者保存寄存器与 ra 并释放栈帧，
+ *        再跳转到被调用者，由它直接返回到当前函数的调用者
+ */
 void
-CodeGenerator::emitCall(const ir::IRQuadPtr &code)
+CodeGenerator::emitTailCall(const ir::IRQuad &code)
 {
-  regalloc->spillCaller();
+  if (scan) {
+    emitArgs(code);
+    emitEpilogue();
+    mc.jump(MOp::TAIL, func->label(code.label));
+    return;
+  }
+
+  regalloc->spillCaller(savedAtCall(code));
 
-  auto params = code->elems
-    | std::views::transform([](const auto &elem) {
-        return elem.value;
+  auto params = func->elems(code.elems)
+    | std::views::transform([this](ir::ValueId elem) {
+        return func->value(elem);
       })
     | std::ranges::to<std::vector>();
   memalloc->prepareParam(params);
 
-  std::println(out, "  call {}", code->label);
-  memalloc->reuseReg(Register::A0, code->dst.value);
+  regalloc->restoreUsedCallee();
+  stackalloc->retFunc();
+
+  mc.jump(MOp::TAIL, func->label(code.label));
+}
+
+/**
+ * @brief INDEX/DOT：求出元素的地址
+ *
+ * 常量下标直接折叠进偏移（地址固定的别名不生成代码），否则下标乘以元素大小
+ * 加到基址上；下标不能证明在范围之内时，越界跳转到函数末尾的 ebreak。
+ */
+void
+CodeGenerator::emitIndex(const ir::IRQuad &code)
+{
+  if (agg->isFixed(code.dst)) {
+    DBG(mc, "  # {} is at {}(sp)", func->value(code.dst)->str(), func->value(code.dst)->frameaddr);
+    return;
+  }
+
+  auto type = func->value(code.arg1)->type;
+  if (func->value(code.arg2)->isConst()) {
+    auto idx = getConstantVal(func->value(code.arg2));
+    if (idx < 0 || idx >= type->size()) {
+      oob = true;
+      mc.jump(MOp::J, oobLabel());
+      return;
+    }
+    auto base = addressOf(code.arg1, Register::T6);
+    auto dst  = defReg(code.dst);
+    mc.opImm(MOp::ADDI, dst, base.base, base.offset + Aggregates::offsetOf(type, idx));
+    flushDef(code.dst, dst);
+    return;
+  }
+
+  // 下标不是常量的只有数组，元素大小都相同
+  auto idx = useReg(code.arg2, Register::T5);
+  if (ranges->inBounds(index)) {
+    DBG(mc, "  # bounds check elided");
+  } else {
+    oob = true;
+    mc.li(Register::T6, type->size());
+    mc.branch(MOp::BGEU, idx, Register::T6, oobLabel());
+  }
+  auto size = static_cast<unsigned>(Aggregates::sizeOf(type->getElemType()));
+  if (std::has_single_bit(size)) {
+    mc.opImm(MOp::SLLI, Register::T6, idx, std::countr_zero(size));
+  } else {
+    mc.li(Register::T6, size);
+    mc.op(MOp::MUL, Register::T6, idx, Register::T6);
+  }
+
+  auto base = addressOf(code.arg1, Register::T5);
+  auto dst  = defReg(code.dst);
+  mc.op(MOp::ADD, dst, base.base, Register::T6);
+  if (base.offset != 0) {
+    mc.opImm(MOp::ADDI, dst, dst, base.offset);
+  }
+  flushDef(code.dst, dst);
+}
+
+/**
+ * @brief MAKE_ARR/MAKE_TUP：逐个元素直接存入数组/元组
+ *
+ * 结果只用来初始化紧接着赋值的栈上变量（let a = [...]）时，直接在变量中构造，
+ * 省去一次整体复制；元素中有别名或数组/元组时可能读到变量自己，不这样做。
+ */
+void
+CodeGenerator::emitMake(const ir::IRQuad &code)
+{
+  auto elems  = func->elems(code.elems);
+  auto target = code.dst;
+  if (index + 1 < func->quads.size()) {
+    const auto &next = func->quads[index + 1];
+    bool fuse = next.op == ir::IROp::ASSIGN && next.arg1 == code.dst && uses[code.dst] == 1
+      && (agg->inFrame(next.dst) || agg->isFixed(next.dst))
+      && std::ranges::none_of(elems, [this](ir::ValueId elem) {
+           return agg->isAlias(elem) || agg->inFrame(elem);
+         });
+    target = fuse ? next.dst : code.dst;
+  }
+
+  auto type = func->value(target)->type;
+  auto to   = addressOf(target, Register::T6);
+  for (std::size_t k = 0; k < elems.size(); ++k) {
+    auto offset = to.offset + Aggregates::offsetOf(type, static_cast<int>(k));
+    const auto &elem = func->value(elems[k]);
+    if (Aggregates::isAggregate(elem->type)) {
+      copyWords(elems[k], {.base = to.base, .offset = offset}, Aggregates::sizeOf(elem->type));
+    } else if (elem->isConst() && getConstantVal(elem) == 0) {
+      mc.store(MOp::SW, Register::ZERO, offset, to.base);
+    } else {
+      auto reg = useReg(elems[k], Register::T5);
+      mc.store(MOp::SW, reg, offset, to.base);
+    }
+  }
+
+  if (target != code.dst) {
+    ++index;
+    DBG(mc, "  # {}", func->str(func->quads[index]));
+    DBG(mc, "  # built in place");
+    emitMoves(scan->splitMoves(index));
+  }
 }
 
 /**
@@ -228,52 +1258,92 @@ getConstantVal(const sym::ValuePtr &val)
   return std::get<bool>(constant->val) ? 1 : 0;
 }
 
-static int
-calculateConst(ir::IROp op, const ir::Operand &arg1, const ir::Operand &arg2)
+/**
+ * @brief 比较取反：a op b 不成立时 a invertCompare(op) b 成立
+ */
+static ir::IROp
+invertCompare(ir::IROp op)
 {
-  auto lhs = getConstantVal(arg1.value);
-  auto rhs = getConstantVal(arg2.value);
-
   switch (op) {
-    case ir::IROp::ADD: return lhs  + rhs;
-    case ir::IROp::SUB: return lhs  - rhs;
-    case ir::IROp::MUL: return lhs  * rhs;
-    case ir::IROp::DIV: return lhs  / rhs;
-    case ir::IROp::EQ:  return static_cast<int>(lhs == rhs);
-    case ir::IROp::NEQ: return static_cast<int>(lhs != rhs);
-    case ir::IROp::GT:  return static_cast<int>(lhs  > rhs);
-    case ir::IROp::GEQ: return static_cast<int>(lhs >= rhs);
-    case ir::IROp::LT:  return static_cast<int>(lhs  < rhs);
-    case ir::IROp::LEQ: return static_cast<int>(lhs <= rhs);
+    case ir::IROp::EQ:  return ir::IROp::NEQ;
+    case ir::IROp::NEQ: return ir::IROp::EQ;
+    case ir::IROp::LT:  return ir::IROp::GEQ;
+    case ir::IROp::GEQ: return ir::IROp::LT;
+    case ir::IROp::GT:  return ir::IROp::LEQ;
+    case ir::IROp::LEQ: return ir::IROp::GT;
     default:
-      UNREACHABLE(
-        std::format("invalid operator {}", ir::irop2str(op))
-      );
+      UNREACHABLE(std::format("invalid comparison {}", ir::irop2str(op)));
   }
 }
 
-void
-CodeGenerator::emitBinary(const ir::IRQuadPtr &code)
+/**
+ * @brief li 展开后的指令条数（估计值）
+ */
+static int
+liCount(std::int64_t imm)
 {
-  if (code->arg1.isConst() && code->arg2.isConst()) {
-    auto res = calculateConst(code->op, code->arg1, code->arg2);
+  if (imm >= -2048 && imm < 2048) {
+    return 1;
+  }
+  if (imm >= INT32_MIN && imm <= INT32_MAX) {
+    return 2; // lui + addi
+  }
+  return 3;
+}
+
+/**
+ * @brief 常量的非相邻形式（NAF）：相邻两位不同时非零，非零位最少
+ * @return (位, ±1) 按位从高到低排列
+ */
+static std::vector<std::pair<int, int>>
+nafTerms(std::int64_t value)
+{
+  auto sign = value < 0 ? -1 : 1;
+  auto rest = value < 0 ? -value : value;
+
+  std::vector<std::pair<int, int>> terms;
+  for (int bit = 0; rest != 0; ++bit, rest /= 2) {
+    if (rest % 2 != 0) {
+      auto digit = rest % 4 == 1 ? 1 : -1; // 取 -1 时进位，使下一位为 0
+      terms.emplace_back(bit, sign * digit);
+      rest -= digit;
+    }
+  }
+  std::ranges::reverse(terms);
+  return terms;
+}
 
-    auto dst = memalloc->alloc(code->dst.value, true);
+void
+CodeGenerator::emitBinary(const ir::IRQuad &code)
+{
+  if (func->value(code.arg1)->isConst() && func->value(code.arg2)->isConst()) {
+    auto lhs = getConstantVal(func->value(code.arg1));
+    auto rhs = getConstantVal(func->value(code.arg2));
+    auto dst = defReg(code.dst);
 
-    std::println(out, "  li {}, {}", dst, res);
+    // 与运行时的指令结果相同：不截断到 i32，除数为 0 时为 -1
+    mc.li(dst, ir::evalBinary(code.op, lhs, rhs));
+    flushDef(code.dst, dst);
     return;
   }
 
-  if (code->arg1.isConst() || code->arg2.isConst()) {
+  if (func->value(code.arg1)->isConst() || func->value(code.arg2)->isConst()) {
     emitImmBinary(code);
     return;
   }
 
-  auto lhs = memalloc->alloc(code->arg1.value, false);
-  auto rhs = memalloc->alloc(code->arg2.value, false);
-  auto dst = memalloc->alloc(code->dst.value, true);
+  auto lhs = useReg(code.arg1, Register::T5);
+  auto rhs = useReg(code.arg2, Register::T6);
+  auto dst = defReg(code.dst);
 
-  switch (code->op) {
+  emitOp(code.op, lhs, rhs, dst);
+  flushDef(code.dst, dst);
+}
+
+void
+CodeGenerator::emitOp(ir::IROp op, Register lhs, Register rhs, Register dst)
+{
+  switch (op) {
     case ir::IROp::ADD: emitAdd(lhs, rhs, dst); return;
     case ir::IROp::SUB: emitSub(lhs, rhs, dst); return;
     case ir::IROp::MUL: emitMul(lhs, rhs, dst); return;
@@ -286,200 +1356,359 @@ CodeGenerator::emitBinary(const ir::IRQuadPtr &code)
     case ir::IROp::LEQ: emitLeq(lhs, rhs, dst); return;
     default:
       UNREACHABLE(
-        std::format("invalid operator {}", ir::irop2str(code->op))
+        std::format("invalid operator {}", ir::irop2str(op))
       );
   }
 }
 
 void
-CodeGenerator::emitImmBinary(const ir::IRQuadPtr &code)
+CodeGenerator::emitImmBinary(const ir::IRQuad &code)
 {
-  Register lhs;
-  int rhs;
+  bool imm_lhs = func->value(code.arg1)->isConst();
 
-  if (code->arg1.isConst()) {
-    lhs = memalloc->alloc(code->arg2.value, false);
-    rhs = getConstantVal(code->arg1.value);
-  } else {
-    lhs = memalloc->alloc(code->arg1.value, false);
-    rhs = getConstantVal(code->arg2.value);
-  }
+  Register lhs = useReg(imm_lhs ? code.arg2 : code.arg1, Register::T5);
+  int      rhs = getConstantVal(func->value(imm_lhs ? code.arg1 : code.arg2));
 
-  auto dst = memalloc->alloc(code->dst.value, true);
+  auto dst = defReg(code.dst);
+
+  // 立即数超出 12 位，或常量是减法、除法的左操作数：先把常量装入寄存器；
+  // 乘以、除以常量由 emitImmMul/emitImmDiv 自行选择指令序列
+  bool wide   = rhs <= -2048 || rhs >= 2048;
+  bool reduce = code.op == ir::IROp::MUL || (code.op == ir::IROp::DIV && !imm_lhs);
+  if ((wide && !reduce) || (imm_lhs && (code.op == ir::IROp::SUB || code.op == ir::IROp::DIV))) {
+    auto imm = immScratch(dst);
+    mc.li(imm, rhs);
+    if (imm_lhs) {
+      emitOp(code.op, imm, lhs, dst);
+    } else {
+      emitOp(code.op, lhs, imm, dst);
+    }
+    flushDef(code.dst, dst);
+    return;
+  }
 
-  switch (code->op) {
-    case ir::IROp::ADD: emitImmAdd(lhs, rhs, dst); return;
-    case ir::IROp::SUB: emitImmSub(lhs, rhs, dst); return;
-    case ir::IROp::MUL: emitImmMul(lhs, rhs, dst); return;
-    case ir::IROp::DIV: emitImmDiv(lhs, rhs, dst); return;
-    case ir::IROp::EQ:  emitImmEq(lhs, rhs, dst);  return;
-    case ir::IROp::NEQ: emitImmNeq(lhs, rhs, dst); return;
+  switch (code.op) {
+    case ir::IROp::ADD: emitImmAdd(lhs, rhs, dst); break;
+    case ir::IROp::SUB: emitImmSub(lhs, rhs, dst); break;
+    case ir::IROp::MUL: emitImmMul(lhs, rhs, dst); break;
+    case ir::IROp::DIV: emitImmDiv(lhs, rhs, dst); break;
+    case ir::IROp::EQ:  emitImmEq(lhs, rhs, dst);  break;
+    case ir::IROp::NEQ: emitImmNeq(lhs, rhs, dst); break;
     case ir::IROp::GT:
-      if (code->arg2.isConst()) {
+      if (!imm_lhs) {
         emitImmGt(lhs, rhs, dst);
       } else {
         emitImmLt(lhs, rhs, dst);
       }
-      return;
+      break;
     case ir::IROp::GEQ:
-      if (code->arg2.isConst()) {
+      if (!imm_lhs) {
         emitImmGeq(lhs, rhs, dst);
       } else {
         emitImmLeq(lhs, rhs, dst);
       }
-      return;
+      break;
     case ir::IROp::LT:
-      if (code->arg2.isConst()) {
+      if (!imm_lhs) {
         emitImmLt(lhs, rhs, dst);
       } else {
         emitImmGt(lhs, rhs, dst);
       }
-      return;
+      break;
     case ir::IROp::LEQ:
-      if (code->arg2.isConst()) {
+      if (!imm_lhs) {
         emitImmLeq(lhs, rhs, dst);
       } else {
         emitImmGeq(lhs, rhs, dst);
       }
-      return;
+      break;
     default:
       UNREACHABLE(
-        std::format("invalid operator {}", ir::irop2str(code->op))
+        std::format("invalid operator {}", ir::irop2str(code.op))
       );
   }
+  flushDef(code.dst, dst);
 }
 
 void
 CodeGenerator::emitAdd(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  add {}, {}, {}", dst, lhs, rhs);
+  mc.op(MOp::ADD, dst, lhs, rhs);
 }
 
 void
 CodeGenerator::emitSub(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  sub {}, {}, {}", dst, lhs, rhs);
+  mc.op(MOp::SUB, dst, lhs, rhs);
 }
 
 void
 CodeGenerator::emitMul(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  mul {}, {}, {}", dst, lhs, rhs);
+  mc.op(MOp::MUL, dst, lhs, rhs);
 }
 
 void
 CodeGenerator::emitDiv(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  div {}, {}, {}", dst, lhs, rhs);
+  mc.op(MOp::DIV, dst, lhs, rhs);
 }
 
 void
 CodeGenerator::emitEq(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  xor {}, {}, {}", dst, lhs, rhs);
-  std::println(out, "  sltiu {}, {}, 1", dst, dst);
+  mc.op(MOp::XOR, dst, lhs, rhs);
+  mc.opImm(MOp::SLTIU, dst, dst, 1);
 }
 
 void
 CodeGenerator::emitNeq(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  xor {}, {}, {}", dst, lhs, rhs);
-  std::println(out, "  sltu {}, x0, {}", dst, dst);
+  mc.op(MOp::XOR, dst, lhs, rhs);
+  mc.op(MOp::SLTU, dst, Register::ZERO, dst);
 }
 
 void
 CodeGenerator::emitGt(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  slt {}, {}, {}", dst, rhs, lhs);
+  mc.op(MOp::SLT, dst, rhs, lhs);
 }
 
 void
 CodeGenerator::emitGeq(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  slt {}, {}, {}", dst, lhs, rhs);
-  std::println(out, "  xori {}, {}, 1", dst, dst);
+  mc.op(MOp::SLT, dst, lhs, rhs);
+  mc.opImm(MOp::XORI, dst, dst, 1);
 }
 
 void
 CodeGenerator::emitLt(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  slt {}, {}, {}", dst, lhs, rhs);
+  mc.op(MOp::SLT, dst, lhs, rhs);
 }
 
 void
 CodeGenerator::emitLeq(Register lhs, Register rhs, Register dst)
 {
-  std::println(out, "  slt {}, {}, {}", dst, rhs, lhs);
-  std::println(out, "  xori {}, {}, 1", dst, dst);
+  mc.op(MOp::SLT, dst, rhs, lhs);
+  mc.opImm(MOp::XORI, dst, dst, 1);
 }
 
 void
 CodeGenerator::emitImmAdd(Register lhs, int rhs, Register dst)
 {
-  std::println(out, " addi {}, {}, {}", dst, lhs, rhs);
+  mc.opImm(MOp::ADDI, dst, lhs, rhs);
 }
 
 void
 CodeGenerator::emitImmSub(Register lhs, int rhs, Register dst)
 {
   int neg_rhs = -rhs;
-  std::println(out, "  addi {}, {}, {}", dst, lhs, neg_rhs);
+  mc.opImm(MOp::ADDI, dst, lhs, neg_rhs);
 }
 
 void
 CodeGenerator::emitImmMul(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  li {}, {}", dst, rhs);
-  std::println(out, "  mul {}, {}, {}", dst, lhs, dst);
+  if (rhs == 0) {
+    mc.li(dst, 0);
+    return;
+  }
+  if (rhs == 1 || rhs == -1) {
+    if (rhs == 1) {
+      mc.mv(dst, lhs);
+    } else {
+      mc.neg(dst, lhs);
+    }
+    return;
+  }
+  if (emitShiftAdd(lhs, rhs, dst)) {
+    return;
+  }
+
+  auto imm = immScratch(dst);
+  mc.li(imm, rhs);
+  mc.op(MOp::MUL, dst, lhs, imm);
 }
 
 void
 CodeGenerator::emitImmDiv(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  li {}, {}", dst, rhs);
-  std::println(out, "  div {}, {}, {}", dst, lhs, dst);
+  if (rhs == 1 || rhs == -1) {
+    if (rhs == 1) {
+      mc.mv(dst, lhs);
+    } else {
+      mc.neg(dst, lhs);
+    }
+    return;
+  }
+  if (rhs != 0 && emitMagicDiv(lhs, rhs, dst)) {
+    return;
+  }
+
+  auto imm = immScratch(dst);
+  mc.li(imm, rhs);
+  mc.op(MOp::DIV, dst, lhs, imm);
+}
+
+/**
+ * @brief 乘除常量的指令序列中保存中间结果的寄存器，要与 lhs 不同：
+ *        线性扫描分配时为 t6，贪心分配时只能借用目标寄存器
+ */
+std::optional<Register>
+CodeGenerator::mulScratch(Register lhs, Register dst) const
+{
+  if (scan) {
+    return Register::T6;
+  }
+  return dst != lhs ? std::optional{dst} : std::nullopt;
+}
+
+/**
+ * @brief 乘以常量改为移位与加减（Horner 形式）：
+ *        rhs 写成非相邻形式 ±2^k0 ±2^k1 ...（k0 > k1 > ...），依次
+ *        acc = ±lhs; acc = (acc << (k0 - k1)) ± lhs; ...; acc <<= k_last
+ * @return 比 li + mul 便宜并生成了代码时为 true
+ */
+bool
+CodeGenerator::emitShiftAdd(Register lhs, std::int64_t rhs, Register dst)
+{
+  auto terms = nafTerms(rhs);
+
+  // 有多项时之后还要读取 lhs，累加到别的寄存器中
+  std::optional<Register> acc = dst;
+  if (terms.size() > 1 && dst == lhs) {
+    acc = scan ? std::optional{Register::T6} : std::nullopt;
+  }
+  if (!acc) {
+    return false;
+  }
+
+  auto count = 2 * static_cast<int>(terms.size() - 1) + (terms.back().first != 0 ? 1 : 0)
+    + (terms.front().second < 0 ? 1 : 0) + (*acc != dst ? 1 : 0);
+  if (count * opts.target->alu >= liCount(rhs) * opts.target->alu + opts.target->mul) {
+    return false;
+  }
+
+  auto from = lhs;
+  if (terms.front().second < 0) {
+    mc.neg(*acc, lhs);
+    from = *acc;
+  }
+  for (std::size_t k = 1; k < terms.size(); ++k) {
+    mc.opImm(MOp::SLLI, *acc, from, terms[k - 1].first - terms[k].first);
+    mc.op(terms[k].second > 0 ? MOp::ADD : MOp::SUB, *acc, *acc, lhs);
+    from = *acc;
+  }
+  if (terms.back().first != 0) {
+    mc.opImm(MOp::SLLI, *acc, from, terms.back().first);
+  }
+  if (*acc != dst) {
+    mc.mv(dst, *acc);
+  }
+  return true;
+}
+
+/**
+ * @brief 除以常量改为移位或乘以倒数，商向零取整
+ *
+ * |rhs| = 2^k 时被除数为负先加上 2^k - 1 再算术右移；否则取
+ * l = ceil(log2 |rhs|)，m = 2^(31+l) / |rhs| + 1（m <= 2^32，与 32 位被除数
+ * 的乘积不会超出 64 位），商为 (lhs * m) >> (31 + l)，被除数为负时再加 1
+ * （Granlund & Montgomery, "Division by Invariant Integers using Multiplication"）。
+ * 除数为负时最后取反。
+ *
+ * @return 比 li + div 便宜并生成了代码时为 true
+ */
+bool
+CodeGenerator::emitMagicDiv(Register lhs, std::int64_t rhs, Register dst)
+{
+  auto divisor = rhs < 0 ? -rhs : rhs;
+  auto neg     = rhs < 0 ? 1 : 0;
+  auto limit   = liCount(rhs) * opts.target->alu + opts.target->div;
+
+  auto tmp = mulScratch(lhs, dst);
+  if (!tmp) {
+    return false;
+  }
+
+  if (std::has_single_bit(static_cast<std::uint64_t>(divisor))) {
+    auto k = std::countr_zero(static_cast<std::uint64_t>(divisor));
+    if ((4 + neg) * opts.target->alu >= limit) {
+      return false;
+    }
+    if (k == 1) {
+      mc.opImm(MOp::SRLI, *tmp, lhs, 63);
+    } else {
+      mc.opImm(MOp::SRAI, *tmp, lhs, 63);
+      mc.opImm(MOp::SRLI, *tmp, *tmp, 64 - k);
+    }
+    mc.op(MOp::ADD, *tmp, lhs, *tmp);
+    mc.opImm(MOp::SRAI, dst, *tmp, k);
+  } else {
+    // tmp 保存乘积时 dst 用来保存被除数的符号，二者不能相同
+    if (*tmp == dst) {
+      return false;
+    }
+    auto l     = std::bit_width(static_cast<std::uint64_t>(divisor - 1));
+    auto magic = (std::int64_t{1} << (31 + l)) / divisor + 1;
+    if ((liCount(magic) + 3 + neg) * opts.target->alu + opts.target->mul >= limit) {
+      return false;
+    }
+    mc.li(*tmp, magic);
+    mc.op(MOp::MUL, *tmp, lhs, *tmp);
+    mc.opImm(MOp::SRAI, *tmp, *tmp, 31 + l);
+    mc.opImm(MOp::SRLI, dst, lhs, 63);
+    mc.op(MOp::ADD, dst, *tmp, dst);
+  }
+  if (neg != 0) {
+    mc.neg(dst, dst);
+  }
+  return true;
 }
 
 void
 CodeGenerator::emitImmEq(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  xor {}, {}, {}", dst, lhs, rhs);
-  std::println(out, "  sltiu {}, {}, 1", dst, dst);
+  mc.opImm(MOp::XORI, dst, lhs, rhs);
+  mc.opImm(MOp::SLTIU, dst, dst, 1);
 }
 
 void
 CodeGenerator::emitImmNeq(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  xori {}, {}, {}", dst, lhs, rhs);
-  std::println(out, "  sltu {}, x0, {}", dst, dst);
+  mc.opImm(MOp::XORI, dst, lhs, rhs);
+  mc.op(MOp::SLTU, dst, Register::ZERO, dst);
 }
 
 void
 CodeGenerator::emitImmGt(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  li {}, {}", dst, rhs);
-  std::println(out, "  slt {}, {}, {}", dst, dst, lhs);
+  auto imm = immScratch(dst);
+  mc.li(imm, rhs);
+  mc.op(MOp::SLT, dst, imm, lhs);
 }
 
 void
 CodeGenerator::emitImmGeq(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  slti {}, {}, {}", dst, lhs, rhs);
-  std::println(out, "  xori {}, {}, 1", dst, dst);
+  mc.opImm(MOp::SLTI, dst, lhs, rhs);
+  mc.opImm(MOp::XORI, dst, dst, 1);
 }
 
 void
 CodeGenerator::emitImmLt(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  slti {}, {}, {}", dst, lhs, rhs);
+  mc.opImm(MOp::SLTI, dst, lhs, rhs);
 }
 
 void
 CodeGenerator::emitImmLeq(Register lhs, int rhs, Register dst)
 {
-  std::println(out, "  li {}, {}", dst, rhs);
-  std::println(out, "  slt {}, {}, {}", dst, dst, lhs);
-  std::println(out, "  xori {}, {}, 1", dst, dst);
+  auto imm = immScratch(dst);
+  mc.li(imm, rhs);
+  mc.op(MOp::SLT, dst, imm, lhs);
+  mc.opImm(MOp::XORI, dst, dst, 1);
 }
 
 } // namespace cg
@@ -1,48 +1,152 @@
 #pragma once
 
+#include <span>
+#include <format>
 #include <memory>
+#include <string>
 #include <vector>
-#include <fstream>
+#include <cstdint>
+#include <ostream>
+#include <optional>
+#include <unordered_set>
 
+#include "machine.hpp"
+#include "liveness.hpp"
+#include "out_buffer.hpp"
+#include "elf_writer.hpp"
+#include "aggregate.hpp"
 #include "mem_alloc.hpp"
 #include "reg_alloc.hpp"
+#include "value_range.hpp"
+#include "linear_scan.hpp"
 #include "stack_alloc.hpp"
+#include "target_cost.hpp"
 
 namespace ast { struct Prog; }
 
 namespace ir {
 
 struct IRQuad;
-using IRQuadPtr = std::shared_ptr<IRQuad>;
+class FuncCode;
 
 } // namespace ir
 
 namespace sym { class SymbolTable; }
 
+namespace util { class TimeReport; }
+
 namespace cg {
 
+// 寄存器分配算法
+enum class RegAllocKind : std::uint8_t {
+  LINEAR_SCAN, // 按活跃区间线性扫描，跨基本块保持一致（默认）
+  GREEDY,      // 按 IR 顺序贪心分配，寄存器用尽时轮转溢出
+};
+
+// 代码生成选项
+struct CodeGenOptions {
+  RegAllocKind      regalloc = RegAllocKind::LINEAR_SCAN;
+  const TargetCost *target   = &TARGETS[0]; // 选择指令序列与调度时参考的处理器（-mtune）
+  bool              schedule = true;         // 是否按 target 的延迟重排块内的指令（-fschedule）
+  bool              vector   = false;        // 是否把数组的逐元素循环向量化为 RVV 指令（-march=rv64gcv）
+  bool              compress = false;        // 是否优先选择 16 位的压缩指令并报告代码大小（-march=rv64gc）
+
+  /**
+   * @brief 参与增量编译缓存键：选项不同的编译不能共享缓存
+   */
+  [[nodiscard]] std::string key() const {
+    return std::format("{}-{}{}{}{}", regalloc == RegAllocKind::GREEDY ? "ra-greedy" : "ra-linear", target->name,
+      schedule ? "" : "-nosched", vector ? "-rvv" : "", compress ? "-rvc" : "");
+  }
+};
+
 class CodeGenerator {
 public:
-  CodeGenerator(std::ofstream &out, sym::SymbolTable &symtab);
+  // obj 不为空时各函数的机器指令交给 obj 编码，不输出汇编
+  CodeGenerator(std::ostream &out, sym::SymbolTable &symtab, const CodeGenOptions &opts = {},
+    ElfWriter *obj = nullptr);
 
 public:
-  void generate(const ast::Prog &prog);
+  void generate(const ast::Prog &prog, unsigned jobs = 1);
+
+  // 逐函数生成（增量编译时分别缓存每个函数的汇编）
+  void generateHeader();
+  void generateFunc(const ir::FuncCode &funccode);
+  auto generateFuncs(std::span<const ir::FuncCode *const> funcs, unsigned jobs) -> std::vector<std::string>;
+
+  /**
+   * @brief 设置 --time-report 的统计，各函数的生成计时并计数（nullptr 表示不统计）
+   */
+  void setReport(util::TimeReport *report) {
+    this->report = report;
+  }
 
 private:
-  void generateFunc(const std::vector<ir::IRQuadPtr> &funccode);
-
-  void emitFunc(const ir::IRQuadPtr &code);
-  void emitRet(const ir::IRQuadPtr &code);
-  void emitAssign(const ir::IRQuadPtr &code);
-  void emitGoto(const ir::IRQuadPtr &code);
-  void emitBeqz(const ir::IRQuadPtr &code);
-  void emitBnez(const ir::IRQuadPtr &code);
-  void emitBge(const ir::IRQuadPtr &code);
-  void emitLabel(const ir::IRQuadPtr &code);
-  void emitCall(const ir::IRQuadPtr &code);
-
-  void emitBinary(const ir::IRQuadPtr &code);
-  void emitImmBinary(const ir::IRQuadPtr &code);
+  void lowerFunc(const ir::FuncCode &funccode);
+  template <typename Fn>
+  void forEachFunc(std::span<const ir::FuncCode *const> funcs, unsigned jobs, Fn &&fn);
+
+  void emitFunc(const ir::IRQuad &code);
+  void emitRet(const ir::IRQuad &code);
+  void emitAssign(const ir::IRQuad &code);
+  void emitGoto(const ir::IRQuad &code);
+  void emitBeqz(const ir::IRQuad &code);
+  void emitBnez(const ir::IRQuad &code);
+  void emitBge(const ir::IRQuad &code);
+  void emitCmpBranch(const ir::IRQuad &code);
+  void emitCondJump(ir::IROp op, Register lhs, Register rhs);
+  bool fusesWithBranch(std::size_t i) const;
+  bool skipsJump(std::size_t i) const;
+  void emitLabel(const ir::IRQuad &code);
+  void emitProbe(const ir::IRQuad &code);
+  void emitCall(const ir::IRQuad &code);
+  void emitTailCall(const ir::IRQuad &code);
+  void emitIndex(const ir::IRQuad &code);
+  void emitMake(const ir::IRQuad &code);
+  auto savedAtCall(const ir::IRQuad &code) const -> std::unordered_set<std::uint32_t>;
+  bool isTailCall(std::size_t i) const;
+
+  // 可以向量化的 for 循环（vectorize.cpp）：head 为循环开始的标号
+  struct VectorLoop {
+    std::size_t head;
+    std::size_t body;  // 循环体的第一个四元式
+    std::size_t latch; // 回到 head 的 goto
+    ir::ValueId iv;    // 循环变量
+    ir::ValueId bound; // 循环变量的上界（不含）
+  };
+  auto matchVectorLoop(std::size_t head) const -> std::optional<VectorLoop>;
+  void emitVectorLoop(const VectorLoop &loop);
+
+  // 数组/元组元素的地址：基址寄存器加偏移
+  struct Addr {
+    Register base;
+    int      offset;
+  };
+
+  // 线性扫描分配时：值所在的位置、块之间的搬移与栈帧
+  auto addressOf(ir::ValueId value, Register scratch) -> Addr;
+  void copyWords(ir::ValueId from, const Addr &to, int size);
+  auto useReg(ir::ValueId value, Register scratch) -> Register;
+  auto defReg(ir::ValueId value) -> Register;
+  void flushDef(ir::ValueId value, Register reg);
+  auto immScratch(Register dst) const -> Register;
+  auto branchTarget(const ir::IRQuad &code) -> std::string;
+  void emitMove(const Location &from, const Location &to);
+  void emitMoves(std::vector<Move> moves);
+  void emitArgs(const ir::IRQuad &code);
+  void emitFallThrough();
+  void emitEdgeStubs();
+  void emitOobExit();
+  auto oobLabel() const -> std::string;
+  void enterCold();
+  bool needsFrame(std::size_t block) const;
+  auto shrinkWrap() -> std::size_t;
+  void emitPrologue();
+  void emitEpilogue();
+
+  void emitBinary(const ir::IRQuad &code);
+  void emitImmBinary(const ir::IRQuad &code);
+  void emitOp(ir::IROp op, Register lhs, Register rhs, Register dst);
   inline void emitAdd(Register lhs, Register rhs, Register dst);
   inline void emitSub(Register lhs, Register rhs, Register dst);
   inline void emitMul(Register lhs, Register rhs, Register dst);
@@ -57,6 +161,9 @@ private:
   inline void emitImmSub(Register lhs, int rhs, Register dst);
   inline void emitImmMul(Register lhs, int rhs, Register dst);
   inline void emitImmDiv(Register lhs, int rhs, Register dst);
+  auto mulScratch(Register lhs, Register dst) const -> std::optional<Register>;
+  bool emitShiftAdd(Register lhs, std::int64_t rhs, Register dst);
+  bool emitMagicDiv(Register lhs, std::int64_t rhs, Register dst);
   inline void emitImmEq(Register lhs, int rhs, Register dst);
   inline void emitImmNeq(Register lhs, int rhs, Register dst);
   inline void emitImmGt(Register lhs, int rhs, Register dst);
@@ -64,12 +171,45 @@ private:
   inline void emitImmLt(Register lhs, int rhs, Register dst);
   inline void emitImmLeq(Register lhs, int rhs, Register dst);
 private:
-  std::ofstream &out;
+  util::OutBuffer out; // 逐函数格式化，函数生成完后一次写出
   sym::SymbolTable &symtab;
+  CodeGenOptions opts;
+  ElfWriter *obj;
+  util::TimeReport *report = nullptr; // --time-report 的统计
+
+  MCode mc; // 当前函数的机器指令，函数生成完后经窥孔优化再输出
 
   std::unique_ptr<StackAllocator> stackalloc;
   std::unique_ptr<RegAllocator>   regalloc;
   std::unique_ptr<MemAllocator>   memalloc;
+
+  const ir::FuncCode *func = nullptr; // 当前正在生成的函数
+  std::vector<std::uint32_t> uses;    // 当前函数中各值被读取的次数
+  bool leaf = false;                  // 当前函数是否不调用其他函数（尾调用除外）
+
+  std::unique_ptr<Aggregates>  agg;    // 当前函数中数组/元组的布局
+  std::unique_ptr<Liveness>    live;   // 当前函数的基本块与活跃值
+  std::unique_ptr<ValueRanges> ranges; // 下标的取值范围，用于省去越界检查
+  bool                         oob = false; // 是否生成了越界检查（当前的热/冷部分中）
+  std::vector<bool>            across; // 值 -> 是否跨过某个调用活跃（贪心分配时放入 s 寄存器）
+
+  std::unique_ptr<LinearScan> scan;  // 当前函数的线性扫描分配结果，贪心分配时为空
+  Frame                       frame; // 线性扫描分配时当前函数的栈帧
+  std::size_t                 wrap  = 0; // 建立栈帧的块，不需要栈帧时为块数
+  std::vector<bool>           unframed;  // wrap 之后仍不建立栈帧的返回块
+  std::size_t                 index = 0; // 正在生成的四元式下标
+
+  // 条件跳转的边上需要搬移时，跳转到函数末尾的一段桩代码，搬移后再跳到目标
+  struct EdgeStub {
+    std::string label;
+    std::size_t from;
+    std::size_t to;
+    std::string target;
+  };
+  std::vector<EdgeStub> stubs;
+  std::size_t           emitted = 0; // stubs 中已经生成的个数
+
+  bool cold = false; // 是否已经进入函数的冷块部分（.text.unlikely）
 };
 
 } // namespace cg
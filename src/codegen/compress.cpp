@@ -0,0 +1,124 @@
+#include <cstdint>
+
+#include "machine.hpp"
+
+namespace cg {
+
+namespace {
+
+/**
+ * @brief imm 是否是 bits 位的有符号数
+ */
+inline bool
+fits(std::int64_t imm, int bits)
+{
+  return imm >= -(std::int64_t{1} << (bits - 1)) && imm < (std::int64_t{1} << (bits - 1));
+}
+
+/**
+ * @brief imm 是否是 [0, max] 中 scale 的倍数（压缩访存指令的无符号偏移）
+ */
+inline bool
+scaled(std::int64_t imm, std::int64_t scale, std::int64_t max)
+{
+  return imm >= 0 && imm <= max && imm % scale == 0;
+}
+
+/**
+ * @brief  访存指令能否压缩：以 sp 为基址时用 c.lwsp/c.ldsp/c.swsp/c.sdsp，
+ *         否则两个寄存器都要在 x8-x15 中，偏移的范围也更小
+ * @param  data 读出或存入的寄存器
+ * @param  width 访问的字节数，4 或 8
+ */
+bool
+compressibleAccess(const MInst &inst, Register data, std::int64_t width)
+{
+  if (inst.rs1 == Register::SP) {
+    return scaled(inst.imm, width, width * 63);
+  }
+  return isCompressible(data) && isCompressible(inst.rs1) && scaled(inst.imm, width, width * 31);
+}
+
+/**
+ * @brief 指令的操作数是否满足某种 16 位压缩编码的约束
+ */
+bool
+compressible(const MInst &inst)
+{
+  auto rd = inst.rd;
+  auto rs1 = inst.rs1;
+  auto rs2 = inst.rs2;
+  switch (inst.op) {
+    case MOp::LI:
+      return rd != Register::ZERO && fits(inst.imm, 6);
+    case MOp::MV:
+      return rd != Register::ZERO && rs1 != Register::ZERO;
+    case MOp::ADDI:
+      if (rd == Register::SP && rs1 == Register::SP) { // c.addi16sp
+        return inst.imm != 0 && inst.imm % 16 == 0 && fits(inst.imm, 10);
+      }
+      if (rs1 == Register::SP) { // c.addi4spn
+        return isCompressible(rd) && inst.imm != 0 && scaled(inst.imm, 4, 1020);
+      }
+      return rd == rs1 && rd != Register::ZERO && inst.imm != 0 && fits(inst.imm, 6);
+    case MOp::SEXTW: // c.addiw rd, 0
+      return rd == rs1 && rd != Register::ZERO;
+    case MOp::ADD: // c.add rd, rs，加法可以交换操作数
+      return rd != Register::ZERO && rs1 != Register::ZERO && rs2 != Register::ZERO && (rd == rs1 || rd == rs2);
+    case MOp::SUB: case MOp::XOR:
+      return rd == rs1 && isCompressible(rd) && isCompressible(rs2);
+    case MOp::SLLI:
+      return rd == rs1 && rd != Register::ZERO && inst.imm > 0 && inst.imm < 64;
+    case MOp::SRLI: case MOp::SRAI:
+      return rd == rs1 && isCompressible(rd) && inst.imm > 0 && inst.imm < 64;
+    case MOp::LW:
+      return compressibleAccess(inst, rd, 4) && rd != Register::ZERO;
+    case MOp::LD:
+      return compressibleAccess(inst, rd, 8) && rd != Register::ZERO;
+    case MOp::SW:
+      return compressibleAccess(inst, rs2, 4);
+    case MOp::SD:
+      return compressibleAccess(inst, rs2, 8);
+    case MOp::RET: case MOp::EBREAK:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+void
+MCode::compress()
+{
+  for (auto &inst : insts) {
+    inst.compressed = compressible(inst);
+  }
+}
+
+/**
+ * @brief 估计函数的代码大小：压缩指令 2 字节，其余 4 字节；
+ *        call、tail 与超出 12 位的 li 展开为两条指令
+ */
+auto
+MCode::codeSize() const -> CodeSize
+{
+  CodeSize size;
+  for (const auto &inst : insts) {
+    if (inst.op == MOp::LABEL || inst.op == MOp::DIRECTIVE || inst.op == MOp::COMMENT) {
+      continue;
+    }
+    ++size.insts;
+    if (inst.compressed) {
+      ++size.compressed;
+      size.bytes += 2;
+    } else if (inst.op == MOp::CALL || inst.op == MOp::TAIL || (inst.op == MOp::LI && !fits(inst.imm, 12))) {
+      size.bytes += 8;
+    } else {
+      size.bytes += 4;
+    }
+  }
+  return size;
+}
+
+} // namespace cg
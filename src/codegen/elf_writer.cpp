@@ -0,0 +1,323 @@
+#include <array>
+#include <format>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <unordered_map>
+
+#include "panic.hpp"
+#include "elf_writer.hpp"
+#include "riscv_encode.hpp"
+
+namespace cg {
+
+namespace {
+
+// ELF 中用到的常量（见 System V ABI 与 RISC-V ELF psABI）
+inline constexpr std::uint16_t ET_REL        = 1;
+inline constexpr std::uint16_t EM_RISCV      = 243;
+inline constexpr std::uint32_t SHT_PROGBITS  = 1;
+inline constexpr std::uint32_t SHT_SYMTAB    = 2;
+inline constexpr std::uint32_t SHT_STRTAB    = 3;
+inline constexpr std::uint32_t SHT_RELA      = 4;
+inline constexpr std::uint64_t SHF_ALLOC     = 0x2;
+inline constexpr std::uint64_t SHF_EXECINSTR = 0x4;
+inline constexpr std::uint64_t SHF_INFO_LINK = 0x40;
+inline constexpr std::uint8_t  STB_GLOBAL    = 1;
+inline constexpr std::uint8_t  STT_NOTYPE    = 0;
+inline constexpr std::uint8_t  STT_FUNC      = 2;
+inline constexpr std::uint8_t  STT_SECTION   = 3;
+
+inline constexpr std::uint32_t EF_RISCV_RVC              = 0x1;
+inline constexpr std::uint32_t EF_RISCV_FLOAT_ABI_DOUBLE = 0x4; // lp64d，与 rv64g 的默认 ABI 一致
+
+inline constexpr std::uint32_t R_RISCV_BRANCH = 16;
+inline constexpr std::uint32_t R_RISCV_JAL    = 17;
+inline constexpr std::uint32_t R_RISCV_CALL   = 18;
+
+inline constexpr std::size_t EHDR_SIZE = 64;
+inline constexpr std::size_t SHDR_SIZE = 64;
+inline constexpr std::size_t SYM_SIZE  = 24;
+inline constexpr std::size_t RELA_SIZE = 24;
+
+// 节的下标
+enum : std::uint16_t { SEC_NULL, SEC_TEXT, SEC_RELA, SEC_SYMTAB, SEC_STRTAB, SEC_SHSTRTAB, SEC_COUNT };
+
+// 符号表开头的局部符号：空符号与 .text 的节符号
+inline constexpr std::uint32_t LOCAL_SYMS = 2;
+
+inline bool
+isBranch(MOp op)
+{
+  return op >= MOp::BEQ && op <= MOp::BGEU;
+}
+
+/**
+ * @brief 以小端序追加 bytes 字节的整数
+ */
+void
+put(std::string &buf, std::uint64_t value, int bytes)
+{
+  for (int i = 0; i < bytes; ++i) {
+    buf.push_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+void
+align(std::string &buf, std::size_t alignment)
+{
+  buf.resize((buf.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+/**
+ * @brief  向字符串表追加一个名字
+ * @return 名字在表中的偏移
+ */
+std::uint32_t
+addName(std::string &table, std::string_view name)
+{
+  auto offset = static_cast<std::uint32_t>(table.size());
+  table.append(name);
+  table.push_back('\0');
+  return offset;
+}
+
+struct Section {
+  std::uint32_t name;
+  std::uint32_t type;
+  std::uint64_t flags;
+  std::uint64_t offset;
+  std::uint64_t size;
+  std::uint32_t link;
+  std::uint32_t info;
+  std::uint64_t align;
+  std::uint64_t entsize;
+};
+
+} // namespace
+
+/**
+ * @brief 全局符号的下标，第一次出现时作为未定义符号加入
+ */
+std::uint32_t
+ElfWriter::symbol(const std::string &name)
+{
+  auto [it, inserted] = symbol_ids.try_emplace(name, static_cast<std::uint32_t>(symbols.size()));
+  if (inserted) {
+    symbols.push_back({.name = name});
+  }
+  return it->second;
+}
+
+/**
+ * @brief 把一个函数的指令排在 .text 的末尾并编码
+ */
+void
+ElfWriter::addFunc(std::span<const MInst> insts)
+{
+  auto n = insts.size();
+  std::vector<std::size_t>   sizes(n);
+  std::vector<std::uint64_t> offsets(n);
+  std::vector<bool>          far(n, false);
+  for (std::size_t i = 0; i < n; ++i) {
+    sizes[i] = encodedSize(insts[i]);
+  }
+
+  // 确定标号的位置：超出范围的条件跳转变长之后，其后的标号后移，再检查一遍直到不变
+  std::unordered_map<std::string_view, std::uint64_t> labels;
+  for (bool changed = true; changed;) {
+    changed = false;
+    labels.clear();
+    auto pc = text.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      offsets[i] = pc;
+      if (insts[i].op == MOp::LABEL) {
+        labels[insts[i].sym] = pc;
+      }
+      pc += sizes[i];
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!isBranch(insts[i].op) || far[i]) {
+        continue;
+      }
+      auto it = labels.find(insts[i].sym);
+      if (it != labels.end() && !isNearBranch(static_cast<std::int64_t>(it->second - offsets[i]))) {
+        far[i]   = true;
+        sizes[i] = FAR_BRANCH_SIZE;
+        changed  = true;
+      }
+    }
+  }
+
+  std::unordered_set<std::string_view> globals;
+  std::optional<std::uint32_t>         func;
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto &inst = insts[i];
+    switch (inst.op) {
+      case MOp::DIRECTIVE:
+        if (std::string_view sym{inst.sym}; sym.starts_with(".global ")) {
+          globals.insert(sym.substr(8));
+        }
+        break;
+      case MOp::LABEL:
+        if (globals.contains(inst.sym)) {
+          func = symbol(inst.sym);
+          CHECK(!symbols[*func].defined, std::format("symbol {} is already defined", inst.sym));
+          symbols[*func].defined = true;
+          symbols[*func].value   = offsets[i];
+        }
+        break;
+      case MOp::CALL: case MOp::TAIL:
+        relocs.push_back({.offset = offsets[i], .symbol = symbol(inst.sym), .type = R_RISCV_CALL});
+        encode(inst, 0, text);
+        break;
+      case MOp::BEQ: case MOp::BNE: case MOp::BLT: case MOp::BGE: case MOp::BGEU: case MOp::J: {
+        auto it = labels.find(inst.sym);
+        if (it == labels.end()) { // 不在本函数中，由链接器填写
+          relocs.push_back({
+            .offset = offsets[i],
+            .symbol = symbol(inst.sym),
+            .type   = inst.op == MOp::J ? R_RISCV_JAL : R_RISCV_BRANCH,
+          });
+          encode(inst, 0, text);
+          break;
+        }
+        auto offset = static_cast<std::int64_t>(it->second) - static_cast<std::int64_t>(offsets[i]);
+        if (far[i]) {
+          encodeFarBranch(inst, offset, text);
+        } else {
+          CHECK(inst.op != MOp::J || isNearJump(offset), std::format("jump to {} is out of range", inst.sym));
+          encode(inst, offset, text);
+        }
+        break;
+      }
+      default:
+        encode(inst, 0, text);
+        break;
+    }
+  }
+  if (func.has_value()) {
+    symbols[*func].size = text.size() - symbols[*func].value;
+  }
+}
+
+/**
+ * @brief 生成整个目标文件并一次写出
+ */
+void
+ElfWriter::write(std::ostream &out) const
+{
+  std::string strtab(1, '\0');
+  std::vector<std::uint32_t> names;
+  names.reserve(symbols.size());
+  for (const auto &sym : symbols) {
+    names.push_back(addName(strtab, sym.name));
+  }
+  std::string shstrtab(1, '\0');
+  std::array<Section, SEC_COUNT> sections{};
+  sections[SEC_TEXT] = {
+    .name = addName(shstrtab, ".text"), .type = SHT_PROGBITS, .flags = SHF_ALLOC | SHF_EXECINSTR, .align = 4,
+  };
+  sections[SEC_RELA] = {
+    .name = addName(shstrtab, ".rela.text"), .type = SHT_RELA, .flags = SHF_INFO_LINK,
+    .link = SEC_SYMTAB, .info = SEC_TEXT, .align = 8, .entsize = RELA_SIZE,
+  };
+  sections[SEC_SYMTAB] = {
+    .name = addName(shstrtab, ".symtab"), .type = SHT_SYMTAB,
+    .link = SEC_STRTAB, .info = LOCAL_SYMS, .align = 8, .entsize = SYM_SIZE,
+  };
+  sections[SEC_STRTAB]   = {.name = addName(shstrtab, ".strtab"), .type = SHT_STRTAB, .align = 1};
+  sections[SEC_SHSTRTAB] = {.name = addName(shstrtab, ".shstrtab"), .type = SHT_STRTAB, .align = 1};
+
+  // 各节的内容依次排在 ELF 头之后，节头表在最后
+  std::string buf;
+  buf.reserve(EHDR_SIZE + text.size() + relocs.size() * RELA_SIZE + (LOCAL_SYMS + symbols.size()) * SYM_SIZE
+    + strtab.size() + shstrtab.size() + SEC_COUNT * SHDR_SIZE + 32);
+  buf.resize(EHDR_SIZE, '\0');
+
+  auto begin = [&](Section &sec) {
+    align(buf, sec.align);
+    sec.offset = buf.size();
+  };
+  auto end = [&](Section &sec) { sec.size = buf.size() - sec.offset; };
+
+  begin(sections[SEC_TEXT]);
+  buf += text;
+  end(sections[SEC_TEXT]);
+
+  begin(sections[SEC_RELA]);
+  for (const auto &reloc : relocs) {
+    put(buf, reloc.offset, 8);
+    put(buf, static_cast<std::uint64_t>(LOCAL_SYMS + reloc.symbol) << 32 | reloc.type, 8);
+    put(buf, 0, 8); // addend
+  }
+  end(sections[SEC_RELA]);
+
+  begin(sections[SEC_SYMTAB]);
+  buf.append(SYM_SIZE, '\0');
+  put(buf, 0, 4);
+  put(buf, STT_SECTION, 1);
+  put(buf, 0, 1);
+  put(buf, SEC_TEXT, 2);
+  buf.append(16, '\0'); // value、size
+  for (std::size_t i = 0; i < symbols.size(); ++i) {
+    const auto &sym = symbols[i];
+    put(buf, names[i], 4);
+    put(buf, STB_GLOBAL << 4 | (sym.defined ? STT_FUNC : STT_NOTYPE), 1);
+    put(buf, 0, 1);
+    put(buf, sym.defined ? SEC_TEXT : SEC_NULL, 2);
+    put(buf, sym.value, 8);
+    put(buf, sym.size, 8);
+  }
+  end(sections[SEC_SYMTAB]);
+
+  begin(sections[SEC_STRTAB]);
+  buf += strtab;
+  end(sections[SEC_STRTAB]);
+
+  begin(sections[SEC_SHSTRTAB]);
+  buf += shstrtab;
+  end(sections[SEC_SHSTRTAB]);
+
+  align(buf, 8);
+  auto shoff = buf.size();
+  for (const auto &sec : sections) {
+    put(buf, sec.name, 4);
+    put(buf, sec.type, 4);
+    put(buf, sec.flags, 8);
+    put(buf, 0, 8); // addr
+    put(buf, sec.offset, 8);
+    put(buf, sec.size, 8);
+    put(buf, sec.link, 4);
+    put(buf, sec.info, 4);
+    put(buf, sec.align, 8);
+    put(buf, sec.entsize, 8);
+  }
+
+  // ELF 头
+  std::string ehdr = "\x7f" "ELF";
+  put(ehdr, 2, 1); // ELFCLASS64
+  put(ehdr, 1, 1); // ELFDATA2LSB
+  put(ehdr, 1, 1); // EV_CURRENT
+  ehdr.resize(16, '\0');
+  put(ehdr, ET_REL, 2);
+  put(ehdr, EM_RISCV, 2);
+  put(ehdr, 1, 4); // e_version
+  put(ehdr, 0, 8); // e_entry
+  put(ehdr, 0, 8); // e_phoff
+  put(ehdr, shoff, 8);
+  put(ehdr, EF_RISCV_FLOAT_ABI_DOUBLE | (compressed ? EF_RISCV_RVC : 0), 4);
+  put(ehdr, EHDR_SIZE, 2);
+  put(ehdr, 0, 2); // e_phentsize
+  put(ehdr, 0, 2); // e_phnum
+  put(ehdr, SHDR_SIZE, 2);
+  put(ehdr, SEC_COUNT, 2);
+  put(ehdr, SEC_SHSTRTAB, 2);
+  buf.replace(0, EHDR_SIZE, ehdr);
+
+  out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+}
+
+} // namespace cg
@@ -0,0 +1,69 @@
+/**
+ * @file elf_writer.hpp
+ * @brief ELF64 relocatable object for RISC-V, written without an assembler.
+ *
+ * The code generator hands over the machine instructions of every
+ * function (MCode) instead of printing them. Each function is laid out at
+ * the end of .text: its labels are resolved in memory, branches whose
+ * target is out of the ±4KiB range become an inverted branch over a jal,
+ * and the instructions are encoded (riscv_encode.hpp).
+ *
+ * Functions named by a .global directive become global STT_FUNC symbols;
+ * every other name a call, tail or jump refers to becomes an undefined
+ * global symbol. Calls carry R_RISCV_CALL relocations (also to functions
+ * of the same object, so the linker may still interpose them); branches
+ * and jumps get R_RISCV_BRANCH/R_RISCV_JAL relocations only when their
+ * target is not a label of the function.
+ *
+ * write() builds the whole object (.text, .rela.text, .symtab, .strtab,
+ * .shstrtab and the section headers) in memory and writes it at once.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+
+#include "machine.hpp"
+
+namespace cg {
+
+class ElfWriter {
+public:
+  explicit ElfWriter(bool compressed = false) : compressed(compressed) {}
+
+public:
+  void addFunc(std::span<const MInst> insts);
+  void write(std::ostream &out) const;
+
+private:
+  struct Symbol {
+    std::string   name;
+    bool          defined = false;
+    std::uint64_t value   = 0; // .text 中的偏移
+    std::uint64_t size    = 0;
+  };
+
+  struct Reloc {
+    std::uint64_t offset;
+    std::uint32_t symbol; // symbols 中的下标
+    std::uint32_t type;
+  };
+
+  auto symbol(const std::string &name) -> std::uint32_t;
+
+private:
+  bool compressed; // 是否含有压缩指令（e_flags 的 EF_RISCV_RVC）
+
+  std::string                                    text;
+  std::vector<Reloc>                             relocs;
+  std::vector<Symbol>                            symbols; // 全局符号
+  std::unordered_map<std::string, std::uint32_t> symbol_ids;
+};
+
+} // namespace cg
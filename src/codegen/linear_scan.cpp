@@ -0,0 +1,688 @@
+#include <limits>
+#include <format>
+#include <string>
+#include <optional>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "def_use.hpp"
+#include "func_code.hpp"
+#include "linear_scan.hpp"
+
+namespace cg {
+
+using ir::NONE;
+using ir::IROp;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr auto MAX_POS = std::numeric_limits<std::uint32_t>::max();
+
+// 参与分配的寄存器，按优先顺序排列；t5、t6 留作载入栈上操作数的临时寄存器
+constexpr std::array ALLOCATABLE = {
+  Register::T0, Register::T1, Register::T2, Register::T3, Register::T4,
+  Register::A7, Register::A6, Register::A5, Register::A4,
+  Register::A3, Register::A2, Register::A1, Register::A0,
+  Register::S0, Register::S1, Register::S2,  Register::S3,
+  Register::S4, Register::S5, Register::S6,  Register::S7,
+  Register::S8, Register::S9, Register::S10, Register::S11,
+};
+
+// 优先选择压缩指令时的顺序：x8-x15（a0-a5、s0、s1）在前
+constexpr std::array COMPACT_ORDER = {
+  Register::A5, Register::A4, Register::A3, Register::A2, Register::A1, Register::A0,
+  Register::T0, Register::T1, Register::T2, Register::T3, Register::T4,
+  Register::A7, Register::A6,
+  Register::S0, Register::S1, Register::S2,  Register::S3,
+  Register::S4, Register::S5, Register::S6,  Register::S7,
+  Register::S8, Register::S9, Register::S10, Register::S11,
+};
+static_assert(COMPACT_ORDER.size() == ALLOCATABLE.size());
+
+/**
+ * @brief 向前取到四元式的边界，区间只在这里拆分
+ */
+inline std::uint32_t
+boundary(std::uint32_t pos)
+{
+  return pos & ~3U;
+}
+
+} // namespace
+
+bool
+LinearScan::Interval::covers(std::uint32_t pos) const
+{
+  return std::ranges::any_of(ranges, [pos](const Range &range) {
+    return range.from <= pos && pos < range.to;
+  });
+}
+
+/**
+ * @brief  两个区间都覆盖的第一个位置
+ * @return 不相交时返回 MAX_POS
+ */
+std::uint32_t
+LinearScan::Interval::intersect(const Interval &other) const
+{
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < ranges.size() && j < other.ranges.size()) {
+    const auto &lhs = ranges[i];
+    const auto &rhs = other.ranges[j];
+    if (auto from = std::max(lhs.from, rhs.from); from < std::min(lhs.to, rhs.to)) {
+      return from;
+    }
+    if (lhs.to <= rhs.to) {
+      ++i;
+    } else {
+      ++j;
+    }
+  }
+  return MAX_POS;
+}
+
+LinearScan::LinearScan(const ir::FuncCode &code, const Liveness &live, bool compact)
+  : code(code), live(live), order(compact ? COMPACT_ORDER : ALLOCATABLE)
+{
+  buildIntervals();
+  allocate();
+  assignSlots();
+  collectMoves();
+}
+
+/**
+ * @brief 逆序扫描各块，构造每个值的活跃区间、读写位置与分配提示
+ */
+void
+LinearScan::buildIntervals()
+{
+  auto n = code.valueCount();
+  intervals.resize(n);
+  children.resize(n);
+  reg_hint.resize(n);
+  copy_src.assign(n, NONE);
+  copy_pos.assign(n, 0);
+  for (ValueId value = 0; value < n; ++value) {
+    intervals[value].value = value;
+  }
+
+  // 从后往前构造：ranges 与 uses 先按位置降序追加，最后再翻转
+  auto addRange = [this](ValueId value, std::uint32_t from, std::uint32_t to) {
+    auto &ranges = intervals[value].ranges;
+    if (!ranges.empty() && ranges.back().from <= to) {
+      ranges.back().from = std::min(ranges.back().from, from);
+      ranges.back().to   = std::max(ranges.back().to, to);
+    } else {
+      ranges.push_back({.from = from, .to = to});
+    }
+  };
+  auto define = [this](ValueId value, std::uint32_t pos) {
+    auto &ranges = intervals[value].ranges;
+    if (ranges.empty() || ranges.back().from > pos) {
+      ranges.push_back({.from = pos, .to = pos + 1}); // 定义之后不再使用
+    } else {
+      ranges.back().from = pos;
+    }
+    intervals[value].uses.push_back(pos);
+  };
+
+  // 只被读取一次、且这一次是作为调用实参的值，直接算到对应的 a 寄存器中
+  std::vector<std::uint32_t> reads(n, 0);
+  std::vector<Location>      arg_hint(n);
+
+  const auto &agg = live.aggregates();
+  auto blocks = live.blocks();
+  for (auto b = blocks.size(); b-- > 0;) {
+    const auto &block = blocks[b];
+    auto from = usePos(block.begin);
+    for (ValueId value = 0; value < n; ++value) {
+      if (live.liveOut(b).test(value)) {
+        addRange(value, from, usePos(block.end));
+      }
+    }
+
+    for (auto i = block.end; i-- > block.begin;) {
+      const auto &quad = code.quads[i];
+      if (quad.op == IROp::FUNC) {
+        for (std::size_t k = 0; k < code.params.size(); ++k) {
+          if (!live.tracked(code.params[k])) {
+            continue; // 数组/元组形参拷贝到栈帧中
+          }
+          define(code.params[k], defPos(i));
+          if (k < 8) {
+            reg_hint[code.params[k]] = Location::inReg(toReg(static_cast<int>(k))); // a0-a7
+          }
+        }
+      }
+      if (auto dst = live.written(quad); dst != NONE) {
+        define(dst, defPos(i));
+        if (quad.op == IROp::CALL) {
+          reg_hint[dst] = Location::inReg(Register::A0);
+        } else if (quad.op == IROp::ASSIGN && live.tracked(quad.arg1) && !agg.isAlias(quad.arg1)) {
+          copy_src[dst] = quad.arg1;
+          copy_pos[dst] = usePos(i);
+        }
+      }
+      live.forEachRead(quad, [&](ValueId value) {
+        // 写入元素时，结果算出之后才经由别名存回，别名要活跃到 dst 的位置
+        auto to = agg.isStore(quad) && value == quad.dst ? defPos(i) + 1 : usePos(i) + 1;
+        addRange(value, from, to);
+        intervals[value].uses.push_back(usePos(i));
+        ++reads[value];
+      });
+      if (quad.op == IROp::CALL) {
+        auto args = code.elems(quad.elems);
+        for (std::size_t k = 0; k < args.size() && k < 8; ++k) {
+          arg_hint[args[k]] = Location::inReg(toReg(static_cast<int>(k)));
+        }
+      }
+    }
+  }
+
+  for (ValueId value = 0; value < n; ++value) {
+    auto &interval = intervals[value];
+    std::ranges::reverse(interval.ranges);
+    std::ranges::reverse(interval.uses);
+    auto dup = std::ranges::unique(interval.uses);
+    interval.uses.erase(dup.begin(), dup.end());
+    if (!interval.ranges.empty()) {
+      children[value].push_back(value);
+    }
+    if (reads[value] == 1 && !reg_hint[value].isReg() && copy_src[value] == NONE) {
+      reg_hint[value] = arg_hint[value];
+    }
+  }
+
+  // 调用破坏所有调用者保存寄存器：跨过调用活跃的值不能放在其中
+  for (std::size_t i = 0; i < code.quads.size(); ++i) {
+    if (code.quads[i].op == IROp::CALL) {
+      for (auto reg : CALLER_SAVED_REGS) {
+        fixed[toIndex(reg)].ranges.push_back({.from = usePos(i) + 1, .to = defPos(i)});
+      }
+    }
+  }
+}
+
+void
+LinearScan::enqueue(std::uint32_t id)
+{
+  unhandled.push_back(id);
+  std::ranges::push_heap(unhandled, [this](std::uint32_t lhs, std::uint32_t rhs) {
+    return intervals[lhs].start() > intervals[rhs].start();
+  });
+}
+
+std::uint32_t
+LinearScan::dequeue()
+{
+  std::ranges::pop_heap(unhandled, [this](std::uint32_t lhs, std::uint32_t rhs) {
+    return intervals[lhs].start() > intervals[rhs].start();
+  });
+  auto id = unhandled.back();
+  unhandled.pop_back();
+  return id;
+}
+
+/**
+ * @brief 按起点依次为各区间分配寄存器或溢出槽
+ */
+void
+LinearScan::allocate()
+{
+  for (ValueId value = 0; value < code.valueCount(); ++value) {
+    if (!intervals[value].ranges.empty()) {
+      enqueue(value);
+    }
+  }
+
+  while (!unhandled.empty()) {
+    auto cur = dequeue();
+    auto pos = intervals[cur].start();
+
+    // 已结束的区间出列，进入空洞与离开空洞的区间互换
+    std::vector<std::uint32_t> now_active;
+    std::vector<std::uint32_t> now_inactive;
+    for (auto id : active) {
+      if (intervals[id].end() > pos) {
+        (intervals[id].covers(pos) ? now_active : now_inactive).push_back(id);
+      }
+    }
+    for (auto id : inactive) {
+      if (intervals[id].end() > pos) {
+        (intervals[id].covers(pos) ? now_active : now_inactive).push_back(id);
+      }
+    }
+    active   = std::move(now_active);
+    inactive = std::move(now_inactive);
+
+    if (!tryAllocateFree(cur)) {
+      allocateBlocked(cur);
+    }
+    if (intervals[cur].loc.isReg()) {
+      active.push_back(cur);
+    }
+  }
+}
+
+/**
+ * @brief  为区间找一个空闲的寄存器，只空闲一段时拆分区间
+ * @return 是否分配到寄存器
+ */
+bool
+LinearScan::tryAllocateFree(std::uint32_t cur)
+{
+  // 各寄存器空闲到的位置，不参与分配的 t5、t6 为 0
+  std::array<std::uint32_t, AVAILABLE_REG_CNT> free_until{};
+  for (auto reg : ALLOCATABLE) {
+    free_until[toIndex(reg)] = fixed[toIndex(reg)].intersect(intervals[cur]);
+  }
+  for (auto id : active) {
+    free_until[toIndex(intervals[id].loc.reg)] = 0;
+  }
+  for (auto id : inactive) {
+    auto &until = free_until[toIndex(intervals[id].loc.reg)];
+    until = std::min(until, intervals[id].intersect(intervals[cur]));
+  }
+
+  // 整个区间都空闲的寄存器：先取提示，再依次取 t/a 寄存器、
+  // 已经保存过的 s 寄存器，最后才用新的 s 寄存器
+  auto end = intervals[cur].end();
+  if (auto loc = hint(cur); loc.isReg() && free_until[toIndex(loc.reg)] >= end) {
+    assign(cur, loc);
+    return true;
+  }
+  for (bool fresh : {false, true}) {
+    for (auto reg : order) {
+      if (free_until[toIndex(reg)] >= end && (fresh || isCaller(reg) || used[toIndex(reg)])) {
+        assign(cur, Location::inReg(reg));
+        return true;
+      }
+    }
+  }
+
+  // 只空闲一段：取空闲得最久的寄存器，之后的部分拆出去另行分配
+  auto best = order.front();
+  for (auto reg : order) {
+    if (free_until[toIndex(reg)] > free_until[toIndex(best)]) {
+      best = reg;
+    }
+  }
+  auto at = boundary(free_until[toIndex(best)]);
+  if (at <= intervals[cur].start()) {
+    return false;
+  }
+  enqueue(split(cur, at));
+  assign(cur, Location::inReg(best));
+  return true;
+}
+
+/**
+ * @brief 没有空闲寄存器时，比较溢出代价：溢出当前区间，
+ *        或者挤出代价最小的寄存器中与它冲突的区间
+ */
+void
+LinearScan::allocateBlocked(std::uint32_t cur)
+{
+  auto pos = intervals[cur].start();
+  auto end = intervals[cur].end();
+
+  std::array<double, AVAILABLE_REG_CNT> cost{};
+  std::array<std::uint32_t, AVAILABLE_REG_CNT> blocked{}; // 被调用占用的位置
+  for (auto reg : ALLOCATABLE) {
+    blocked[toIndex(reg)] = fixed[toIndex(reg)].intersect(intervals[cur]);
+  }
+  for (auto id : active) {
+    cost[toIndex(intervals[id].loc.reg)] += weight(id, pos);
+  }
+  for (auto id : inactive) {
+    if (intervals[id].intersect(intervals[cur]) != MAX_POS) {
+      cost[toIndex(intervals[id].loc.reg)] += weight(id, pos);
+    }
+  }
+
+  std::optional<Register> best;
+  for (auto reg : ALLOCATABLE) {
+    auto at = blocked[toIndex(reg)];
+    if (at < end && boundary(at) <= pos) {
+      continue; // 当前位置就被调用占用
+    }
+    if (!best.has_value() || cost[toIndex(reg)] < cost[toIndex(*best)]) {
+      best = reg;
+    }
+  }
+  if (!best.has_value() || cost[toIndex(*best)] >= weight(cur, pos)) {
+    spill(cur, pos);
+    return;
+  }
+
+  auto reg = *best;
+  std::vector<std::uint32_t> victims;
+  for (auto id : active) {
+    if (intervals[id].loc.reg == reg) {
+      victims.push_back(id);
+    }
+  }
+  for (auto id : inactive) {
+    if (intervals[id].loc.reg == reg && intervals[id].intersect(intervals[cur]) != MAX_POS) {
+      victims.push_back(id);
+    }
+  }
+  auto evicted = [&](std::uint32_t id) { return std::ranges::contains(victims, id); };
+  std::erase_if(active, evicted);
+  std::erase_if(inactive, evicted);
+  for (auto id : victims) {
+    evict(id, pos);
+  }
+
+  if (auto at = blocked[toIndex(reg)]; at < end) {
+    enqueue(split(cur, boundary(at)));
+  }
+  assign(cur, Location::inReg(reg));
+}
+
+/**
+ * @brief 把区间从 pos 所在的四元式起移出寄存器
+ */
+void
+LinearScan::evict(std::uint32_t id, std::uint32_t pos)
+{
+  if (auto at = boundary(pos); at > intervals[id].start()) {
+    id = split(id, at); // 之前的部分留在寄存器中
+  }
+  spill(id, pos);
+}
+
+/**
+ * @brief 区间放到栈上，直到 pos 之后的下一次读写；其后的部分重新排队分配
+ */
+void
+LinearScan::spill(std::uint32_t id, std::uint32_t pos)
+{
+  auto at = MAX_POS;
+  for (auto use : intervals[id].uses) {
+    if (boundary(use) > pos) {
+      at = boundary(use);
+      break;
+    }
+  }
+  if (at != MAX_POS && at > intervals[id].start()) {
+    enqueue(split(id, at));
+  }
+  assign(id, Location::onStack(NONE)); // 槽在分配结束后由 assignSlots 统一着色
+}
+
+void
+LinearScan::assign(std::uint32_t id, Location loc)
+{
+  intervals[id].loc = loc;
+  if (loc.isReg()) {
+    used[toIndex(loc.reg)] = true;
+  }
+}
+
+/**
+ * @brief  在 pos 处拆分区间，pos 之前的部分保留在原区间中
+ * @return 从 pos 开始的新区间
+ */
+std::uint32_t
+LinearScan::split(std::uint32_t id, std::uint32_t pos)
+{
+  Interval tail{.value = intervals[id].value};
+  auto &head = intervals[id];
+
+  std::vector<Range> kept;
+  for (const auto &range : head.ranges) {
+    if (range.to <= pos) {
+      kept.push_back(range);
+    } else if (range.from >= pos) {
+      tail.ranges.push_back(range);
+    } else {
+      kept.push_back({.from = range.from, .to = pos});
+      tail.ranges.push_back({.from = pos, .to = range.to});
+    }
+  }
+  head.ranges = std::move(kept);
+
+  auto first = std::ranges::lower_bound(head.uses, pos);
+  tail.uses.assign(first, head.uses.end());
+  head.uses.erase(first, head.uses.end());
+
+  auto tail_id = static_cast<std::uint32_t>(intervals.size());
+  children[tail.value].push_back(tail_id);
+  intervals.push_back(std::move(tail));
+  return tail_id;
+}
+
+/**
+ * @brief  值在 pos 处所在的区间
+ * @return 没有覆盖 pos 的区间时返回 NONE
+ */
+std::uint32_t
+LinearScan::find(ValueId value, std::uint32_t pos) const
+{
+  for (auto id : children[value]) {
+    if (intervals[id].covers(pos)) {
+      return id;
+    }
+  }
+  return NONE;
+}
+
+/**
+ * @brief 分配时优先考虑的寄存器：拆分出的区间沿用前一段的寄存器，
+ *        否则取形参、调用结果的固定寄存器或复制源所在的寄存器
+ */
+Location
+LinearScan::hint(std::uint32_t id) const
+{
+  auto value = intervals[id].value;
+  if (id != value) {
+    Location prev;
+    std::uint32_t latest = 0;
+    for (auto sibling : children[value]) {
+      const auto &other = intervals[sibling];
+      if (other.loc.isReg() && other.start() < intervals[id].start() && other.start() >= latest) {
+        prev   = other.loc;
+        latest = other.start();
+      }
+    }
+    return prev;
+  }
+
+  if (reg_hint[value].isReg()) {
+    return reg_hint[value];
+  }
+  if (copy_src[value] != NONE) {
+    if (auto src = find(copy_src[value], copy_pos[value]); src != NONE) {
+      return intervals[src].loc;
+    }
+  }
+  return {};
+}
+
+/**
+ * @brief 区间从 from 开始的溢出代价：其后每次读写按所在块的执行频率计
+ */
+double
+LinearScan::weight(std::uint32_t id, std::uint32_t from) const
+{
+  double sum = 0;
+  for (auto use : intervals[id].uses) {
+    if (use >= from) {
+      sum += live.block(live.blockOf(use / 4)).freq;
+    }
+  }
+  return sum;
+}
+
+/**
+ * @brief 为栈上的区间分配溢出槽：按起点依次取第一个与已占用区间都不相交的槽，
+ *        同一个值拆分出的区间优先沿用上一段的槽
+ */
+void
+LinearScan::assignSlots()
+{
+  std::vector<std::uint32_t> stacked;
+  for (std::uint32_t id = 0; id < intervals.size(); ++id) {
+    if (intervals[id].loc.kind == Location::Kind::STACK && !intervals[id].ranges.empty()) {
+      stacked.push_back(id);
+    }
+  }
+  std::ranges::sort(stacked, {}, [this](std::uint32_t id) { return intervals[id].start(); });
+
+  std::vector<std::vector<std::uint32_t>> owners; // 槽 -> 占用它的区间
+  std::vector<std::uint32_t> last(code.valueCount(), NONE); // 值 -> 上一段所在的槽
+  auto fits = [&](std::uint32_t slot, std::uint32_t id) {
+    return std::ranges::none_of(owners[slot], [&](std::uint32_t other) {
+      return intervals[other].intersect(intervals[id]) != MAX_POS;
+    });
+  };
+
+  for (auto id : stacked) {
+    auto value = intervals[id].value;
+    auto slot  = last[value];
+    if (slot == NONE) {
+      ++spilled_count;
+    }
+    if (slot == NONE || !fits(slot, id)) {
+      slot = 0;
+      while (slot < owners.size() && !fits(slot, id)) {
+        ++slot;
+      }
+    }
+    if (slot == owners.size()) {
+      owners.emplace_back();
+    }
+    owners[slot].push_back(id);
+    intervals[id].loc.slot = slot;
+    last[value] = slot;
+  }
+  slot_count = static_cast<std::uint32_t>(owners.size());
+}
+
+/**
+ * @brief 收集块中间拆分处的搬移：值在拆分点两侧都活跃且位置不同
+ * @note  块首的拆分由 edgeMoves 在进入该块的边上处理
+ */
+void
+LinearScan::collectMoves()
+{
+  split_moves.assign(code.quads.size(), {});
+  for (auto &list : children) {
+    std::ranges::sort(list, {}, [this](std::uint32_t id) { return intervals[id].start(); });
+    for (std::size_t k = 1; k < list.size(); ++k) {
+      const auto &prev = intervals[list[k - 1]];
+      const auto &next = intervals[list[k]];
+      auto at = next.start();
+      if (at % 4 != 0 || live.isBlockStart(at / 4)) {
+        continue;
+      }
+      if (prev.covers(at - 1) && !(prev.loc == next.loc)) {
+        split_moves[at / 4].push_back({.from = prev.loc, .to = next.loc});
+      }
+    }
+  }
+}
+
+/**
+ * @brief 值在 pos 处的位置
+ */
+Location
+LinearScan::location(ValueId value, std::uint32_t pos) const
+{
+  auto id = find(value, pos);
+  ASSERT_MSG(id != NONE, std::format("{} is not live at {}", code.value(value)->str(), pos));
+  return intervals[id].loc;
+}
+
+/**
+ * @brief 控制流从块 from 进入块 to 时需要的搬移
+ */
+std::vector<Move>
+LinearScan::edgeMoves(std::size_t from, std::size_t to) const
+{
+  std::vector<Move> moves;
+  auto leave = usePos(live.block(from).end) - 1;
+  auto enter = usePos(live.block(to).begin);
+  for (ValueId value = 0; value < code.valueCount(); ++value) {
+    if (!live.liveIn(to).test(value)) {
+      continue;
+    }
+    auto src = location(value, leave);
+    auto dst = location(value, enter);
+    if (!(src == dst)) {
+      moves.push_back({.from = src, .to = dst});
+    }
+  }
+  return moves;
+}
+
+/**
+ * @brief 栈帧自底向上依次为溢出槽、数组/元组所在的局部区、用到的被调用者保存寄存器与 ra
+ * @param save_ra 函数中是否有（非尾）调用，需要保存 ra
+ * @param locals  局部区的字节数
+ */
+Frame
+LinearScan::frame(bool save_ra, int locals) const
+{
+  Frame frame;
+  frame.locals = Frame::slot(slot_count);
+  int offset = (frame.locals + locals + REG_SIZE - 1) / REG_SIZE * REG_SIZE;
+  for (auto reg : CALLEE_SAVED_REGS) {
+    if (used[toIndex(reg)]) {
+      frame.callee.emplace_back(reg, offset);
+      offset += REG_SIZE;
+    }
+  }
+  if (save_ra) {
+    frame.ra = offset;
+    offset  += REG_SIZE;
+  }
+  frame.size = (offset + 15) / 16 * 16;
+  return frame;
+}
+
+/**
+ * @brief 位置 [from, to) 中是否有值放在栈上或被调用者保存寄存器中，
+ *        即这段代码是否要在栈帧建立之后才能执行
+ */
+bool
+LinearScan::usesFrame(std::uint32_t from, std::uint32_t to) const
+{
+  Interval span{.ranges = {{.from = from, .to = to}}};
+  return std::ranges::any_of(intervals, [&span](const Interval &interval) {
+    bool framed = interval.loc.kind == Location::Kind::STACK
+      || (interval.loc.isReg() && !isCaller(interval.loc.reg));
+    return framed && !interval.ranges.empty() && interval.intersect(span) != MAX_POS;
+  });
+}
+
+/**
+ * @brief 以汇编注释的形式输出各值的区间与分配结果
+ */
+void
+LinearScan::dump(std::ostream &out) const
+{
+  for (ValueId value = 0; value < code.valueCount(); ++value) {
+    if (children[value].empty()) {
+      continue;
+    }
+    std::string line;
+    for (auto id : children[value]) {
+      const auto &interval = intervals[id];
+      auto where = interval.loc.isReg()
+        ? toString(interval.loc.reg)
+        : std::format("stack{}", interval.loc.slot);
+      line += std::format("{}[{}, {}) {}", line.empty() ? "" : ", ", interval.start(), interval.end(), where);
+    }
+    out << std::format("  # {}: {}\n", code.value(value)->str(), line);
+  }
+  if (spilled_count > 0) {
+    out << std::format("  # spill slots: {} ({} bytes) shared by {} values\n",
+      slot_count, Frame::slot(slot_count), spilled_count);
+  }
+}
+
+} // namespace cg
@@ -0,0 +1,197 @@
+/**
+ * @file linear_scan.hpp
+ * @brief Linear scan register allocation over live intervals.
+ *
+ * The quads of a function are numbered in layout order: quad i reads its
+ * operands at position 4i, a call clobbers the caller-saved registers at
+ * 4i+1, and the quad writes its dst at 4i+2. Block-level liveness gives
+ * every value one live interval, a sorted list of ranges with holes where
+ * the value is dead, e.g. between its last use and a redefinition.
+ *
+ * Intervals are allocated in order of their start (Wimmer & Mössenböck,
+ * "Optimized Interval Splitting in a Linear Scan Register Allocator"):
+ *
+ *   - a register free for the whole interval is taken, the hint first (the
+ *     register of a copy source, a0 for a call result, the argument register
+ *     of a parameter or of a value only computed to be passed to a call),
+ *     then t/a registers, then s registers already saved; for compressed
+ *     code (compact) a0-a5 and s0/s1 come first, which the 16-bit RVC
+ *     encodings can name in their 3-bit register fields;
+ *   - a register free only for a prefix of the interval (another interval
+ *     or a call needs it later) is taken for that prefix, the rest is split
+ *     off and allocated when the scan reaches it;
+ *   - otherwise the spill costs are compared, every remaining use weighted
+ *     by 10^loop depth: either the current interval goes to the stack, or
+ *     the intervals in the cheapest register are split here, wait on the
+ *     stack, and are allocated again from their next use on.
+ *
+ * Values live across a call cannot stay in t/a registers, which the call
+ * clobbers, so they end up in s registers or are split around the call;
+ * nothing else is saved at a call site.
+ *
+ * Spilled intervals get their stack slots after the scan, by coloring:
+ * intervals that never overlap share a slot, so the frame grows with the
+ * largest number of values on the stack at once rather than with the
+ * number of values ever spilled. A split part prefers the slot of its
+ * previous part to avoid a stack-to-stack move.
+ *
+ * Splits happen at quad boundaries only. A split inside a block becomes a
+ * move before the quad (splitMoves); where a value has different locations
+ * at the end of a block and at the start of a successor, the code generator
+ * places edgeMoves on that edge. Values on the stack are loaded into t5/t6
+ * around each use; these two scratch registers never hold a value.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+#include "ir_quad.hpp"
+#include "liveness.hpp"
+#include "riscv_reg.hpp"
+
+namespace ir { class FuncCode; }
+
+namespace cg {
+
+// 值在某一位置所在的地方：寄存器或栈上的溢出槽
+struct Location {
+  enum class Kind : std::uint8_t { NONE, REG, STACK };
+
+  Kind          kind = Kind::NONE;
+  Register      reg  = Register::A0;
+  std::uint32_t slot = 0;
+
+  static Location inReg(Register reg) { return {.kind = Kind::REG, .reg = reg}; }
+  static Location onStack(std::uint32_t slot) { return {.kind = Kind::STACK, .slot = slot}; }
+
+  [[nodiscard]] bool isReg() const { return kind == Kind::REG; }
+
+  bool operator==(const Location &other) const {
+    return kind == other.kind && (kind == Kind::REG ? reg == other.reg : slot == other.slot);
+  }
+};
+
+// 把一个值从一处搬到另一处
+struct Move {
+  Location from;
+  Location to;
+};
+
+// 分配完成后一次确定的栈帧布局（偏移相对于 sp）
+struct Frame {
+  int size   = 0;  // 栈帧大小，16 字节对齐；不需要栈帧的叶子函数为 0
+  int ra     = -1; // ra 的保存位置，不调用其他函数时为 -1
+  int locals = 0;  // 数组/元组所在局部区的起始偏移
+
+  // 用到的被调用者保存寄存器及其保存位置
+  std::vector<std::pair<Register, int>> callee;
+
+  /**
+   * @brief 溢出槽的偏移，从栈帧底部开始；槽中可能是元素的地址，每个槽 8 字节
+   */
+  [[nodiscard]] static int slot(std::uint32_t slot) { return static_cast<int>(slot) * REG_SIZE; }
+};
+
+class LinearScan {
+public:
+  // compact 时优先分配压缩指令可以使用的 x8-x15
+  LinearScan(const ir::FuncCode &code, const Liveness &live, bool compact = false);
+
+public:
+  // 第 i 个四元式读取操作数与写入结果的位置
+  static constexpr std::uint32_t usePos(std::size_t i) { return static_cast<std::uint32_t>(4 * i); }
+  static constexpr std::uint32_t defPos(std::size_t i) { return static_cast<std::uint32_t>(4 * i + 2); }
+
+  [[nodiscard]] auto location(ir::ValueId value, std::uint32_t pos) const -> Location;
+
+  /**
+   * @brief 在第 index 个四元式之前完成的搬移（区间在块中间拆分处）
+   */
+  [[nodiscard]] const std::vector<Move> &splitMoves(std::size_t index) const {
+    return split_moves[index];
+  }
+
+  [[nodiscard]] auto edgeMoves(std::size_t from, std::size_t to) const -> std::vector<Move>;
+
+  [[nodiscard]] auto frame(bool save_ra, int locals) const -> Frame;
+  [[nodiscard]] bool usesFrame(std::uint32_t from, std::uint32_t to) const;
+
+  /**
+   * @brief 放到栈上过的值的个数
+   */
+  [[nodiscard]] std::uint32_t spilledCount() const {
+    return spilled_count;
+  }
+
+  void dump(std::ostream &out) const;
+
+private:
+  // 半开区间 [from, to)
+  struct Range {
+    std::uint32_t from;
+    std::uint32_t to;
+  };
+
+  struct Interval {
+    ir::ValueId                value = ir::NONE;
+    std::vector<Range>         ranges; // 按位置升序，互不相交
+    std::vector<std::uint32_t> uses;   // 读写该值的位置，升序
+    Location                   loc;    // 分配的结果
+
+    [[nodiscard]] std::uint32_t start() const { return ranges.front().from; }
+    [[nodiscard]] std::uint32_t end() const { return ranges.back().to; }
+    [[nodiscard]] bool covers(std::uint32_t pos) const;
+    [[nodiscard]] auto intersect(const Interval &other) const -> std::uint32_t;
+  };
+
+  void buildIntervals();
+  void allocate();
+  void assignSlots();
+  void collectMoves();
+
+  bool tryAllocateFree(std::uint32_t cur);
+  void allocateBlocked(std::uint32_t cur);
+  void evict(std::uint32_t id, std::uint32_t pos);
+  void spill(std::uint32_t id, std::uint32_t pos);
+  void assign(std::uint32_t id, Location loc);
+
+  auto split(std::uint32_t id, std::uint32_t pos) -> std::uint32_t;
+  auto find(ir::ValueId value, std::uint32_t pos) const -> std::uint32_t;
+  auto hint(std::uint32_t id) const -> Location;
+  auto weight(std::uint32_t id, std::uint32_t from) const -> double;
+
+  void enqueue(std::uint32_t id);
+  auto dequeue() -> std::uint32_t;
+
+private:
+  const ir::FuncCode &code;
+  const Liveness     &live;
+
+  std::span<const Register> order; // 寄存器的优先顺序
+
+  std::vector<Interval>                   intervals; // 下标先与值编号一一对应，拆分出的区间接在后面
+  std::vector<std::vector<std::uint32_t>> children;  // 值 -> 它的各段区间，分配结束后按起点升序
+  std::array<Interval, AVAILABLE_REG_CNT> fixed;     // 寄存器 -> 被调用破坏的位置
+
+  std::vector<Location>      reg_hint; // 值 -> 固定的寄存器提示（形参、调用结果、实参）
+  std::vector<ir::ValueId>   copy_src; // 值 -> 复制源，分配时优先使用源所在的寄存器
+  std::vector<std::uint32_t> copy_pos; // 值 -> 复制发生的位置
+
+  std::uint32_t slot_count    = 0; // 着色后的溢出槽数
+  std::uint32_t spilled_count = 0; // 放到栈上过的值的个数
+
+  std::array<bool, AVAILABLE_REG_CNT> used{}; // 分配出去过的寄存器
+
+  std::vector<std::uint32_t>     unhandled; // 待分配的区间，按起点排列的小根堆
+  std::vector<std::uint32_t>     active;    // 当前位置占用寄存器的区间
+  std::vector<std::uint32_t>     inactive;  // 占有寄存器、当前位置处于空洞中的区间
+  std::vector<std::vector<Move>> split_moves;
+};
+
+} // namespace cg
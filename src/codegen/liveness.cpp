@@ -0,0 +1,180 @@
+#include <cmath>
+#include <algorithm>
+
+#include "cfg.hpp"
+#include "liveness.hpp"
+
+namespace cg {
+
+using ir::NONE;
+using ir::IROp;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr double        LOOP_WEIGHT = 10; // 每深一层循环，执行频率乘以的倍数
+inline constexpr std::uint32_t MAX_DEPTH   = 6;  // 参与估计的最大循环深度
+
+} // namespace
+
+Liveness::Liveness(const ir::FuncCode &code, const Aggregates &agg) : code(code), agg(agg)
+{
+  buildBlocks();
+  estimateFreq();
+  solve();
+}
+
+/**
+ * @brief 值是否参与活跃分析：常量作为立即数直接使用，数组/元组与地址固定的别名在栈帧中
+ */
+bool
+Liveness::tracked(ValueId value) const
+{
+  return value != NONE && agg.inRegister(value);
+}
+
+/**
+ * @brief 四元式定义的、放在寄存器中的值，没有时为 NONE
+ */
+ValueId
+Liveness::written(const ir::IRQuad &quad) const
+{
+  return tracked(quad.dst) && !agg.isStore(quad) ? quad.dst : NONE;
+}
+
+/**
+ * @brief 按与 ir::Function 相同的规则划分基本块
+ */
+void
+Liveness::buildBlocks()
+{
+  const auto &quads = code.quads;
+  block_of.resize(quads.size());
+  for (std::size_t i = 0; i < quads.size(); ++i) {
+    if (all.empty() || quads[i].op == IROp::LABEL || ir::isTerminator(quads[i - 1].op)) {
+      all.push_back({.begin = i});
+    }
+    all.back().end = i + 1;
+    block_of[i] = all.size() - 1;
+  }
+
+  label_blocks.assign(code.labelCount(), NONE);
+  for (std::size_t b = 0; b < all.size(); ++b) {
+    if (const auto &first = quads[all[b].begin]; first.op == IROp::LABEL) {
+      label_blocks[first.label] = b;
+    }
+  }
+
+  for (std::size_t b = 0; b < all.size(); ++b) {
+    auto &block = all[b];
+    const auto &last = quads[block.end - 1];
+    if (ir::isTerminator(last.op) && last.op != IROp::RETURN) {
+      block.succs.push_back(label_blocks[last.label]);
+    }
+    bool falls = !ir::isTerminator(last.op) || ir::isBranch(last.op);
+    if (falls && b + 1 < all.size() && (block.succs.empty() || block.succs.front() != b + 1)) {
+      block.succs.push_back(b + 1);
+    }
+  }
+}
+
+/**
+ * @brief 由回边估计各块的执行频率；有剖析数据时直接使用各块的执行次数
+ */
+void
+Liveness::estimateFreq()
+{
+  if (code.counts.has_value()) {
+    std::uint64_t count = 0;
+    for (auto &block : all) {
+      count = code.counts->at(code.quads[block.begin], count);
+      block.freq = 1 + static_cast<double>(count); // 从未执行的块仍有最小的代价
+    }
+    return;
+  }
+
+  std::vector<std::size_t> latch_end(all.size(), 0); // 循环头 -> 最后一个回边源块之后
+  for (std::size_t b = 0; b < all.size(); ++b) {
+    for (auto succ : all[b].succs) {
+      if (succ <= b) {
+        latch_end[succ] = std::max(latch_end[succ], b + 1);
+      }
+    }
+  }
+
+  std::vector<std::uint32_t> depth(all.size(), 0);
+  for (std::size_t header = 0; header < all.size(); ++header) {
+    for (auto b = header; b < latch_end[header]; ++b) {
+      ++depth[b];
+    }
+  }
+  for (std::size_t b = 0; b < all.size(); ++b) {
+    all[b].freq = std::pow(LOOP_WEIGHT, std::min(depth[b], MAX_DEPTH));
+  }
+}
+
+/**
+ * @brief 逆序迭代求各块入口、出口活跃的值
+ */
+void
+Liveness::solve()
+{
+  auto n = code.valueCount();
+  std::vector<util::BitSet> gen(all.size(), util::BitSet(n));
+  std::vector<util::BitSet> kill(all.size(), util::BitSet(n));
+  for (std::size_t b = 0; b < all.size(); ++b) {
+    for (auto i = all[b].begin; i < all[b].end; ++i) {
+      const auto &quad = code.quads[i];
+      forEachRead(quad, [&](ValueId value) {
+        if (!kill[b].test(value)) {
+          gen[b].set(value);
+        }
+      });
+      if (quad.op == IROp::FUNC) {
+        for (auto param : code.params) {
+          if (tracked(param)) {
+            kill[b].set(param);
+          }
+        }
+      }
+      if (auto dst = written(quad); dst != NONE) {
+        kill[b].set(dst);
+      }
+    }
+  }
+
+  live_in = gen;
+  live_out.assign(all.size(), util::BitSet(n));
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto b = all.size(); b-- > 0;) {
+      for (auto succ : all[b].succs) {
+        live_out[b].unite(live_in[succ]);
+      }
+      changed = live_in[b].uniteExcept(live_out[b], kill[b]) || changed;
+    }
+  }
+}
+
+/**
+ * @brief 第 index 个四元式执行之后仍然活跃的值（不含它自己写入的值）
+ */
+util::BitSet
+Liveness::liveAfter(std::size_t index) const
+{
+  const auto &block = all[block_of[index]];
+  auto live = live_out[block_of[index]];
+  for (auto i = block.end; i-- > index + 1;) {
+    const auto &quad = code.quads[i];
+    if (auto dst = written(quad); dst != NONE) {
+      live.reset(dst);
+    }
+    forEachRead(quad, [&](ValueId value) { live.set(value); });
+  }
+  if (auto dst = written(code.quads[index]); dst != NONE) {
+    live.reset(dst);
+  }
+  return live;
+}
+
+} // namespace cg
@@ -0,0 +1,101 @@
+/**
+ * @file liveness.hpp
+ * @brief Basic blocks and live values of a function, as seen by the code generator.
+ *
+ * The quads are split into basic blocks by the same rules as ir::Function,
+ * but the blocks only record index ranges into FuncCode::quads, so the code
+ * generator keeps walking the dense quads in layout order. Live-in sets are
+ * solved backwards over the blocks; parameters are defined by the FUNC quad
+ * and constants are never live. Only values kept in registers take part:
+ * arrays and tuples live in the frame, and an assignment to an element
+ * alias reads the alias (the element's address) instead of defining it.
+ *
+ * Loops only come from structured loop expressions and are contiguous in
+ * the layout (without a profile the block layout pass only moves early
+ * returns out of them), so every back edge latch -> header encloses the
+ * blocks of its loop; each enclosing loop multiplies the estimated frequency
+ * of a block by 10. With a profile (--profile-use) the block's execution
+ * count is used instead, so spill costs follow the hot path.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include "bitset.hpp"
+#include "ir_quad.hpp"
+#include "def_use.hpp"
+#include "aggregate.hpp"
+#include "func_code.hpp"
+
+namespace cg {
+
+class Liveness {
+public:
+  struct Block {
+    std::size_t              begin = 0; // 第一个四元式
+    std::size_t              end   = 0; // 最后一个四元式之后
+    std::vector<std::size_t> succs;
+    double                   freq  = 1; // 按循环深度估计（或剖析数据中）的执行频率
+  };
+
+public:
+  Liveness(const ir::FuncCode &code, const Aggregates &agg);
+
+public:
+  [[nodiscard]] std::span<const Block> blocks() const { return all; }
+  [[nodiscard]] const Block &block(std::size_t id) const { return all[id]; }
+  [[nodiscard]] std::size_t blockOf(std::size_t index) const { return block_of[index]; }
+  [[nodiscard]] std::size_t labelBlock(ir::LabelId label) const { return label_blocks[label]; }
+
+  /**
+   * @brief 第 index 个四元式是否是块首
+   */
+  [[nodiscard]] bool isBlockStart(std::size_t index) const {
+    return all[block_of[index]].begin == index;
+  }
+
+  [[nodiscard]] const util::BitSet &liveIn(std::size_t block) const { return live_in[block]; }
+  [[nodiscard]] const util::BitSet &liveOut(std::size_t block) const { return live_out[block]; }
+
+  [[nodiscard]] const Aggregates &aggregates() const { return agg; }
+
+  [[nodiscard]] bool tracked(ir::ValueId value) const;
+  [[nodiscard]] auto written(const ir::IRQuad &quad) const -> ir::ValueId;
+  [[nodiscard]] auto liveAfter(std::size_t index) const -> util::BitSet;
+
+  /**
+   * @brief 依次访问四元式读取的、放在寄存器中的值（包括写入元素时的别名）
+   */
+  template <typename Fn>
+  void forEachRead(const ir::IRQuad &quad, Fn &&fn) const {
+    ir::forEachUse(code, quad, [&](ir::ValueId value) {
+      if (tracked(value)) {
+        fn(value);
+      }
+    });
+    if (agg.isStore(quad) && tracked(quad.dst)) {
+      fn(quad.dst);
+    }
+  }
+
+private:
+  void buildBlocks();
+  void estimateFreq();
+  void solve();
+
+private:
+  const ir::FuncCode &code;
+  const Aggregates   &agg;
+
+  std::vector<Block>        all;
+  std::vector<std::size_t>  block_of;     // 四元式 -> 所在块
+  std::vector<std::size_t>  label_blocks; // 标号 -> 以它开头的块
+  std::vector<util::BitSet> live_in;      // 块入口活跃的值
+  std::vector<util::BitSet> live_out;     // 块出口活跃的值
+};
+
+} // namespace cg
@@ -0,0 +1,378 @@
+#include <array>
+#include <format>
+#include <string>
+#include <utility>
+#include <iterator>
+#include <string_view>
+
+#include "machine.hpp"
+
+namespace cg {
+
+namespace {
+
+constexpr std::array<std::string_view, static_cast<std::size_t>(MOp::COMMENT) + 1> MNEMONICS = {
+  "add", "sub", "mul", "div", "xor", "slt", "sltu",
+  "addi", "xori", "slti", "sltiu", "slli", "srli", "srai",
+  "li", "mv", "neg", "sext.w", "lla",
+  "lw", "ld", "sw", "sd",
+  "beq", "bne", "blt", "bge", "bgeu", "j", "call", "tail", "ret", "ebreak",
+  "vsetvli", "vle32.v", "vse32.v",
+  "vadd.vv", "vsub.vv", "vmul.vv", "vdiv.vv",
+  "vadd.vx", "vsub.vx", "vrsub.vx", "vmul.vx", "vdiv.vx", "vmv.v.x",
+  "", "", "",
+};
+
+inline std::string_view
+mnemonic(MOp op)
+{
+  return MNEMONICS[static_cast<std::size_t>(op)];
+}
+
+/**
+ * @brief 格式化一行汇编，追加到 out 的末尾
+ */
+template <typename... Args>
+void
+line(std::string &out, std::format_string<Args...> fmt, Args &&...args)
+{
+  std::format_to(std::back_inserter(out), fmt, std::forward<Args>(args)...);
+  out.push_back('\n');
+}
+
+inline bool
+isRegOp(MOp op)
+{
+  return op >= MOp::ADD && op <= MOp::SLTU;
+}
+
+inline bool
+isImmOp(MOp op)
+{
+  return op >= MOp::ADDI && op <= MOp::SRAI;
+}
+
+inline bool
+isBranch(MOp op)
+{
+  return op >= MOp::BEQ && op <= MOp::BGEU;
+}
+
+inline bool
+isVector(MOp op)
+{
+  return op >= MOp::VSETVLI && op <= MOp::VMV_VX;
+}
+
+/**
+ * @brief 以压缩指令输出，操作数的约束已由 MCode::compress 检查
+ */
+void
+printCompressed(std::string &out, const MInst &inst)
+{
+  auto name = mnemonic(inst.op);
+  switch (inst.op) {
+    case MOp::LI:
+      line(out, "  c.li {}, {}", inst.rd, inst.imm);
+      break;
+    case MOp::MV:
+      line(out, "  c.mv {}, {}", inst.rd, inst.rs1);
+      break;
+    case MOp::ADDI:
+      if (inst.rd == Register::SP && inst.rs1 == Register::SP) {
+        line(out, "  c.addi16sp sp, {}", inst.imm);
+      } else if (inst.rs1 == Register::SP) {
+        line(out, "  c.addi4spn {}, sp, {}", inst.rd, inst.imm);
+      } else {
+        line(out, "  c.addi {}, {}", inst.rd, inst.imm);
+      }
+      break;
+    case MOp::SEXTW:
+      line(out, "  c.addiw {}, 0", inst.rd);
+      break;
+    case MOp::ADD:
+      line(out, "  c.add {}, {}", inst.rd, inst.rd == inst.rs1 ? inst.rs2 : inst.rs1);
+      break;
+    case MOp::SUB: case MOp::XOR:
+      line(out, "  c.{} {}, {}", name, inst.rd, inst.rs2);
+      break;
+    case MOp::SLLI: case MOp::SRLI: case MOp::SRAI:
+      line(out, "  c.{} {}, {}", name, inst.rd, inst.imm);
+      break;
+    case MOp::LW: case MOp::LD:
+      line(out, "  c.{}{} {}, {}({})", name, inst.rs1 == Register::SP ? "sp" : "", inst.rd, inst.imm, inst.rs1);
+      break;
+    case MOp::SW: case MOp::SD:
+      line(out, "  c.{}{} {}, {}({})", name, inst.rs1 == Register::SP ? "sp" : "", inst.rs2, inst.imm, inst.rs1);
+      break;
+    case MOp::RET:
+      line(out, "  c.jr ra");
+      break;
+    default: // ebreak
+      line(out, "  c.{}", name);
+      break;
+  }
+}
+
+} // namespace
+
+Register
+MInst::def() const
+{
+  return isRegOp(op) || isImmOp(op) || (op >= MOp::LI && op <= MOp::LD) || op == MOp::VSETVLI
+    ? rd : Register::ZERO;
+}
+
+std::array<Register, 2>
+MInst::uses() const
+{
+  if (isRegOp(op) || op == MOp::SW || op == MOp::SD || isBranch(op)) {
+    return {rs1, rs2};
+  }
+  if (isImmOp(op) || op == MOp::MV || op == MOp::NEG || op == MOp::SEXTW || op == MOp::LW || op == MOp::LD
+    || isVector(op))
+  {
+    return {rs1, Register::ZERO};
+  }
+  return {Register::ZERO, Register::ZERO};
+}
+
+bool
+MInst::writes(Register reg) const
+{
+  return reg != Register::ZERO && def() == reg;
+}
+
+bool
+MInst::reads(Register reg) const
+{
+  auto regs = uses();
+  return reg != Register::ZERO && (regs[0] == reg || regs[1] == reg);
+}
+
+/**
+ * @brief 之后的寄存器状态不能再顺序推断：标号、跳转、调用与返回；
+ *        向量指令的向量寄存器与 vl 不参与分析，也不跨过它们移动指令
+ */
+bool
+MInst::isBarrier() const
+{
+  return op == MOp::LABEL || op == MOp::DIRECTIVE || isBranch(op) || (op >= MOp::J && op <= MOp::EBREAK)
+    || isVector(op);
+}
+
+/**
+ * @brief 第 i 条之后第一条没有被删除的指令（跳过注释），没有时为指令数
+ */
+std::size_t
+MCode::nextInst(std::size_t i) const
+{
+  for (auto j = i + 1; j < insts.size(); ++j) {
+    if (!removed[j] && insts[j].op != MOp::COMMENT) {
+      return j;
+    }
+  }
+  return insts.size();
+}
+
+/**
+ * @brief 第 i 条之后 reg 的值是否不再被读取：在读取之前先被改写
+ */
+bool
+MCode::deadAfter(std::size_t i, Register reg) const
+{
+  for (auto j = nextInst(i); j < insts.size(); j = nextInst(j)) {
+    if (insts[j].reads(reg) || insts[j].isBarrier()) {
+      return false;
+    }
+    if (insts[j].writes(reg)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+MCode::peephole()
+{
+  removed.assign(insts.size(), false);
+  forwardStores();
+  foldImmediates();
+  removeSelfMoves();
+  removeJumpsToNext();
+  compact();
+}
+
+void
+MCode::removeSelfMoves()
+{
+  for (std::size_t i = 0; i < insts.size(); ++i) {
+    if (insts[i].op == MOp::MV && insts[i].rd == insts[i].rs1) {
+      removed[i] = true;
+    }
+  }
+}
+
+/**
+ * @brief 删除跳到紧随其后的标号的 j（中间只有标号与注释）
+ */
+void
+MCode::removeJumpsToNext()
+{
+  for (std::size_t i = 0; i < insts.size(); ++i) {
+    if (removed[i] || insts[i].op != MOp::J) {
+      continue;
+    }
+    for (auto j = nextInst(i); j < insts.size() && insts[j].op == MOp::LABEL; j = nextInst(j)) {
+      if (insts[j].sym == insts[i].sym) {
+        removed[i] = true;
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 存入栈上后紧接着从同一位置读出：直接使用存入的寄存器
+ */
+void
+MCode::forwardStores()
+{
+  for (std::size_t i = 0; i < insts.size(); ++i) {
+    const auto &store = insts[i];
+    if (store.op != MOp::SW && store.op != MOp::SD) {
+      continue;
+    }
+    auto n = nextInst(i);
+    if (n == insts.size()) {
+      break;
+    }
+    auto &load = insts[n];
+    auto width = store.op == MOp::SW ? MOp::LW : MOp::LD;
+    if (load.op != width || load.rs1 != store.rs1 || load.imm != store.imm) {
+      continue;
+    }
+    if (load.op == MOp::LD && load.rd == store.rs2) {
+      removed[n] = true;
+    } else {
+      // lw 会把低 32 位符号扩展，用 sext.w 保持相同的结果
+      load = {.op = load.op == MOp::LW ? MOp::SEXTW : MOp::MV, .rd = load.rd, .rs1 = store.rs2};
+    }
+  }
+}
+
+/**
+ * @brief li t, imm 之后的 add/sub 用到 t、且 t 随后不再被读取：合成一条 addi
+ */
+void
+MCode::foldImmediates()
+{
+  for (std::size_t i = 0; i < insts.size(); ++i) {
+    const auto &li = insts[i];
+    if (removed[i] || li.op != MOp::LI || li.imm < -2048 || li.imm > 2047) {
+      continue;
+    }
+    auto n = nextInst(i);
+    if (n == insts.size()) {
+      break;
+    }
+    auto &use = insts[n];
+    auto tmp  = li.rd;
+
+    Register     other;
+    std::int64_t imm;
+    if (use.op == MOp::ADD && (use.rs1 == tmp) != (use.rs2 == tmp)) {
+      other = use.rs1 == tmp ? use.rs2 : use.rs1;
+      imm   = li.imm;
+    } else if (use.op == MOp::SUB && use.rs2 == tmp && use.rs1 != tmp && li.imm != -2048) {
+      other = use.rs1;
+      imm   = -li.imm;
+    } else {
+      continue;
+    }
+    if (use.rd != tmp && !deadAfter(n, tmp)) {
+      continue;
+    }
+    use = {.op = MOp::ADDI, .rd = use.rd, .rs1 = other, .imm = imm};
+    removed[i] = true;
+  }
+}
+
+void
+MCode::compact()
+{
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < insts.size(); ++i) {
+    if (removed[i]) {
+      continue;
+    }
+    if (kept != i) {
+      insts[kept] = std::move(insts[i]);
+    }
+    ++kept;
+  }
+  insts.resize(kept);
+  removed.clear();
+}
+
+void
+MCode::print(std::string &out) const
+{
+  for (const auto &inst : insts) {
+    auto name = mnemonic(inst.op);
+    if (inst.compressed) {
+      printCompressed(out, inst);
+    } else if (isRegOp(inst.op)) {
+      line(out, "  {} {}, {}, {}", name, inst.rd, inst.rs1, inst.rs2);
+    } else if (isImmOp(inst.op)) {
+      line(out, "  {} {}, {}, {}", name, inst.rd, inst.rs1, inst.imm);
+    } else if (isBranch(inst.op)) {
+      line(out, "  {} {}, {}, {}", name, inst.rs1, inst.rs2, inst.sym);
+    } else if (inst.op >= MOp::VADD_VV && inst.op <= MOp::VDIV_VV) {
+      line(out, "  {} v{}, v{}, v{}", name, inst.vd, inst.vs1, inst.vs2);
+    } else if (inst.op >= MOp::VADD_VX && inst.op <= MOp::VDIV_VX) {
+      line(out, "  {} v{}, v{}, {}", name, inst.vd, inst.vs1, inst.rs1);
+    } else {
+      switch (inst.op) {
+        case MOp::LI:
+          line(out, "  li {}, {}", inst.rd, inst.imm);
+          break;
+        case MOp::MV: case MOp::NEG: case MOp::SEXTW:
+          line(out, "  {} {}, {}", name, inst.rd, inst.rs1);
+          break;
+        case MOp::LLA:
+          line(out, "  lla {}, {}", inst.rd, inst.sym);
+          break;
+        case MOp::LW: case MOp::LD:
+          line(out, "  {} {}, {}({})", name, inst.rd, inst.imm, inst.rs1);
+          break;
+        case MOp::SW: case MOp::SD:
+          line(out, "  {} {}, {}({})", name, inst.rs2, inst.imm, inst.rs1);
+          break;
+        case MOp::J: case MOp::CALL: case MOp::TAIL:
+          line(out, "  {} {}", name, inst.sym);
+          break;
+        case MOp::VSETVLI:
+          line(out, "  vsetvli {}, {}, e32, m1, ta, ma", inst.rd, inst.rs1);
+          break;
+        case MOp::VLE32: case MOp::VSE32:
+          line(out, "  {} v{}, ({})", name, inst.vd, inst.rs1);
+          break;
+        case MOp::VMV_VX:
+          line(out, "  vmv.v.x v{}, {}", inst.vd, inst.rs1);
+          break;
+        case MOp::RET: case MOp::EBREAK:
+          line(out, "  {}", name);
+          break;
+        case MOp::LABEL:
+          line(out, "{}:", inst.sym);
+          break;
+        default: // 伪操作与注释
+          line(out, "{}", inst.sym);
+          break;
+      }
+    }
+  }
+}
+
+} // namespace cg
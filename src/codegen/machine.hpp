@@ -0,0 +1,162 @@
+/**
+ * @file machine.hpp
+ * @brief Machine instructions of one function, buffered until the function is done.
+ *
+ * The code generator and the allocators append RISC-V instructions with
+ * their opcode and register operands instead of printing assembly text, so
+ * the code of a function can still be inspected and rewritten before it is
+ * flushed. Labels, directives and VERBOSE comments are kept in the same
+ * list, in order.
+ *
+ * peephole() cleans up what the per-quad code generation leaves behind:
+ *
+ *   - mv x, x is removed;
+ *   - a j to a label that directly follows it is removed;
+ *   - a load right after a store to the same stack slot becomes a move
+ *     (sext.w for lw, which sign-extends) or disappears;
+ *   - li t, imm followed by add/sub using t becomes addi when imm fits in
+ *     12 bits and t is overwritten before it is read again.
+ *
+ * Vector (RVV) instructions name their vector registers by number in vd,
+ * vs1 and vs2; they always work on 32-bit elements with LMUL = 1 and are
+ * never moved or rewritten by these passes.
+ *
+ * schedule() then reorders the instructions between two labels or jumps
+ * for an in-order pipeline (schedule.cpp).
+ *
+ * compress() finally marks the instructions whose operands fit one of the
+ * 16-bit RVC encodings (c.li, c.mv, c.addi, c.lwsp, ...), which print() then
+ * writes with their c. mnemonic; codeSize() estimates the resulting size of
+ * the function (compress.cpp). Branches, j and call are left to the
+ * assembler, which relaxes them itself.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <span>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "riscv_reg.hpp"
+
+namespace cg {
+
+struct TargetCost;
+
+enum class MOp : std::uint8_t {
+  // 寄存器-寄存器运算
+  ADD, SUB, MUL, DIV, XOR, SLT, SLTU,
+  // 寄存器-立即数运算
+  ADDI, XORI, SLTI, SLTIU, SLLI, SRLI, SRAI,
+  // 伪指令（lla rd, sym：符号的 pc 相对地址）
+  LI, MV, NEG, SEXTW, LLA,
+  // 访存：lw/ld rd, imm(rs1)，sw/sd rs2, imm(rs1)
+  LW, LD, SW, SD,
+  // 跳转
+  BEQ, BNE, BLT, BGE, BGEU, J, CALL, TAIL, RET, EBREAK,
+  // 向量：vsetvli rd, rs1；vle32.v/vse32.v vd, (rs1)；.vv 为 vd = vs1 op vs2，.vx 为 vd = vs1 op rs1
+  VSETVLI, VLE32, VSE32,
+  VADD_VV, VSUB_VV, VMUL_VV, VDIV_VV,
+  VADD_VX, VSUB_VX, VRSUB_VX, VMUL_VX, VDIV_VX, VMV_VX,
+  // 不是指令：标号、汇编伪操作与注释（原样输出）
+  LABEL, DIRECTIVE, COMMENT,
+};
+
+struct MInst {
+  MOp          op;
+  Register     rd  = Register::ZERO;
+  Register     rs1 = Register::ZERO;
+  Register     rs2 = Register::ZERO;
+  std::int64_t imm = 0;
+  std::string  sym; // 标号、跳转目标、伪操作或注释
+  std::uint8_t vd  = 0; // 向量寄存器编号
+  std::uint8_t vs1 = 0;
+  std::uint8_t vs2 = 0;
+  bool         compressed = false; // 以 16 位的压缩指令输出
+
+  [[nodiscard]] auto def() const -> Register;                  // 写入的寄存器，没有时为 x0
+  [[nodiscard]] auto uses() const -> std::array<Register, 2>; // 读取的寄存器，不足两个时补 x0
+  [[nodiscard]] bool writes(Register reg) const;
+  [[nodiscard]] bool reads(Register reg) const;
+  [[nodiscard]] bool isBarrier() const;
+};
+
+// 一个函数的代码大小
+struct CodeSize {
+  std::size_t bytes      = 0;
+  std::size_t insts      = 0; // 指令数，不含标号、伪操作与注释
+  std::size_t compressed = 0; // 其中压缩指令的条数
+};
+
+class MCode {
+public:
+  void op(MOp op, Register rd, Register rs1, Register rs2) {
+    insts.push_back({.op = op, .rd = rd, .rs1 = rs1, .rs2 = rs2});
+  }
+  void opImm(MOp op, Register rd, Register rs1, std::int64_t imm) {
+    insts.push_back({.op = op, .rd = rd, .rs1 = rs1, .imm = imm});
+  }
+  void li(Register rd, std::int64_t imm) { insts.push_back({.op = MOp::LI, .rd = rd, .imm = imm}); }
+  void mv(Register rd, Register rs) { insts.push_back({.op = MOp::MV, .rd = rd, .rs1 = rs}); }
+  void neg(Register rd, Register rs) { insts.push_back({.op = MOp::NEG, .rd = rd, .rs1 = rs}); }
+  void lla(Register rd, std::string sym) { insts.push_back({.op = MOp::LLA, .rd = rd, .sym = std::move(sym)}); }
+
+  void load(MOp op, Register rd, std::int64_t offset, Register base) {
+    insts.push_back({.op = op, .rd = rd, .rs1 = base, .imm = offset});
+  }
+  void store(MOp op, Register rs, std::int64_t offset, Register base) {
+    insts.push_back({.op = op, .rs1 = base, .rs2 = rs, .imm = offset});
+  }
+
+  void branch(MOp op, Register rs1, Register rs2, std::string target) {
+    insts.push_back({.op = op, .rs1 = rs1, .rs2 = rs2, .sym = std::move(target)});
+  }
+  void jump(MOp op, std::string target) { insts.push_back({.op = op, .sym = std::move(target)}); }
+  void ret() { insts.push_back({.op = MOp::RET}); }
+  void ebreak() { insts.push_back({.op = MOp::EBREAK}); }
+
+  void vsetvli(Register rd, Register avl) { insts.push_back({.op = MOp::VSETVLI, .rd = rd, .rs1 = avl}); }
+  void vload(std::uint8_t vd, Register base) { insts.push_back({.op = MOp::VLE32, .rs1 = base, .vd = vd}); }
+  void vstore(std::uint8_t vs, Register base) { insts.push_back({.op = MOp::VSE32, .rs1 = base, .vd = vs}); }
+  void vop(MOp op, std::uint8_t vd, std::uint8_t vs1, std::uint8_t vs2) {
+    insts.push_back({.op = op, .vd = vd, .vs1 = vs1, .vs2 = vs2});
+  }
+  void vopScalar(MOp op, std::uint8_t vd, std::uint8_t vs1, Register rs) {
+    insts.push_back({.op = op, .rs1 = rs, .vd = vd, .vs1 = vs1});
+  }
+  void vsplat(std::uint8_t vd, Register rs) { insts.push_back({.op = MOp::VMV_VX, .rs1 = rs, .vd = vd}); }
+
+  void label(std::string name) { insts.push_back({.op = MOp::LABEL, .sym = std::move(name)}); }
+  void directive(std::string text) { insts.push_back({.op = MOp::DIRECTIVE, .sym = std::move(text)}); }
+  void comment(std::string text) { insts.push_back({.op = MOp::COMMENT, .sym = std::move(text)}); }
+
+  [[nodiscard]] std::span<const MInst> instructions() const { return insts; }
+
+  void peephole();
+  void schedule(const TargetCost &cost);
+  void compress();
+  [[nodiscard]] auto codeSize() const -> CodeSize;
+  void print(std::string &out) const; // 汇编文本追加到 out 的末尾
+  void clear() { insts.clear(); }
+
+private:
+  auto nextInst(std::size_t i) const -> std::size_t;
+  bool deadAfter(std::size_t i, Register reg) const;
+
+  void removeSelfMoves();
+  void removeJumpsToNext();
+  void forwardStores();
+  void foldImmediates();
+  void compact();
+
+  void scheduleRegion(std::size_t begin, std::size_t end, const TargetCost &cost);
+
+private:
+  std::vector<MInst> insts;
+  std::vector<bool>  removed; // peephole 期间标记删除的指令
+};
+
+} // namespace cg
@@ -1,6 +1,6 @@
-#include <print>
 #include <ranges>
 
+#include "fold.hpp"
 #include "panic.hpp"
 #include "symbol.hpp"
 #include "asm_dbg.hpp"
@@ -10,21 +10,46 @@
 
 namespace cg {
 
+/**
+ * @brief 登记一个新符号
+ */
+void
+MemAllocator::record(const SymbolPtr &symbol)
+{
+  slot(symbol->val->id) = symbol;
+  touched.push_back(symbol->val->id);
+}
+
+/**
+ * @brief 为一个值分配寄存器
+ *
+ * @param val         待分配的值
+ * @param be_assigned 是否即将被写入
+ * @param across_call 是否跨过调用活跃
+ * @return Register 值所在的寄存器
+ */
 Register
-MemAllocator::alloc(const sym::ValuePtr &val, bool be_assigned)
+MemAllocator::alloc(const sym::ValuePtr &val, bool be_assigned, bool across_call)
 {
   ASSERT_MSG(
     val->kind != sym::Value::Kind::CONST,
     "alloc register for constant"
   );
 
-  if (symtab.contains(val->str())) {
-    SymbolPtr symbol = symtab[val->str()];
-
+  if (SymbolPtr symbol = slot(val->id); symbol != nullptr) {
+    symbol->across_call = across_call;
     if (symbol->in_reg && be_assigned) {
       regalloc.spillExcept(symbol);
     }
 
+    // 即将被整体覆盖的值不必先载入，调用前被丢弃的值在栈上也没有空间
+    if (!symbol->in_reg && be_assigned) {
+      symbol->regloc = regalloc.alloc(symbol);
+      symbol->in_reg = true;
+      symbol->dirty  = symbol->on_stack;
+      return symbol->regloc;
+    }
+
     load(symbol);
 
     if (symbol->on_stack && be_assigned) {
@@ -34,24 +59,22 @@ MemAllocator::alloc(const sym::ValuePtr &val, bool be_assigned)
   }
 
   auto symbol = std::make_shared<Symbol>();
-  symbol->val      = val;
-  symbol->on_stack = false;
-  symbol->in_reg   = true;
-  symbol->dirty    = false;
-  symbol->regloc   = regalloc.alloc(symbol);
-
-  symtab[val->str()] = symbol;
+  symbol->val         = val;
+  symbol->on_stack    = false;
+  symbol->in_reg      = true;
+  symbol->dirty       = false;
+  symbol->across_call = across_call;
+  symbol->regloc      = regalloc.alloc(symbol);
+
+  record(symbol);
   return symbol->regloc;
 }
 
 void
 MemAllocator::reuseReg(Register reg, const sym::ValuePtr &val)
 {
-  SymbolPtr symbol;
-  if (const auto &it = symtab.find(val->str());
-    it != symtab.end())
-  {
-    symbol = it->second;
+  SymbolPtr symbol = slot(val->id);
+  if (symbol != nullptr) {
     if (symbol->in_reg) {
       // 释放掉原符号占据的 register
       regalloc.free(symbol);
@@ -65,12 +88,30 @@ MemAllocator::reuseReg(Register reg, const sym::ValuePtr &val)
     symbol->dirty = false;
     symbol->val = val;
 
-    symtab[symbol->val->str()] = symbol;
+    record(symbol);
   }
 
   regalloc.reuse(reg, symbol);
 }
 
+/**
+ * @brief  复制 dst = src 且 src 此后不再使用时，dst 直接接管 src 所在的寄存器
+ * @return 是否合并（src 不在寄存器中时不合并，由调用者生成复制）
+ */
+bool
+MemAllocator::coalesce(const sym::ValuePtr &src, const sym::ValuePtr &dst)
+{
+  SymbolPtr symbol = slot(src->id);
+  if (symbol == nullptr || !symbol->in_reg) {
+    return false;
+  }
+
+  auto reg = symbol->regloc;
+  regalloc.drop(symbol); // src 已经死亡，不需要写回
+  reuseReg(reg, dst);
+  return true;
+}
+
 void
 MemAllocator::load(const SymbolPtr &symbol)
 {
@@ -84,19 +125,17 @@ MemAllocator::load(const SymbolPtr &symbol)
   symbol->in_reg = true;
   symbol->dirty  = false;
 
-  DBG(out, "  # load symbol {}", symbol->val->str());
+  DBG(mc, "  # load symbol {}", symbol->val->str());
 
   int offset = stackalloc.offsetFromSP(symbol->stackloc);
-  std::println(out, "  lw {}, {}(sp)", symbol->regloc, offset);
+  mc.load(MOp::LW, symbol->regloc, offset, Register::SP);
 }
 
 std::optional<SymbolPtr>
 MemAllocator::lookup(const sym::ValuePtr &val)
 {
-  if (const auto &it = symtab.find(val->str());
-    it != symtab.end())
-  {
-    return it->second;
+  if (const auto &symbol = slot(val->id); symbol != nullptr) {
+    return symbol;
   }
   return std::nullopt;
 }
@@ -117,17 +156,17 @@ MemAllocator::prepareParam(const std::vector<sym::ValuePtr> &params)
   CHECK(params.size() <= 8, "parameter > 8");
   for (const auto &[idx, param] : std::ranges::enumerate_view(params)) {
     if (param->isConst()) {
-      std::println(out, "  li {}, {}", toReg(idx), param->str());
+      mc.li(toReg(idx), ir::constValue(*param));
     } else {
-      const auto &it = symtab.find(param->str());
-      ASSERT_MSG(it != symtab.end(), "can't find param symbol");
-      auto symbol = it->second;
+      const auto &symbol = slot(param->id);
+      ASSERT_MSG(symbol != nullptr, "can't find param symbol");
+      if (symbol->in_reg) {
+        // spillCaller 之后仍在寄存器中的只有被调用者保存寄存器，不会与 a0-a7 冲突
+        mc.mv(toReg(idx), symbol->regloc);
+        continue;
+      }
       ASSERT_MSG(symbol->on_stack, "symbol don't on stack");
-      std::println(out,
-        "  lw {}, {}(sp)",
-        toReg(idx),
-        stackalloc.offsetFromSP(symbol->stackloc)
-      );
+      mc.load(MOp::LW, toReg(idx), stackalloc.offsetFromSP(symbol->stackloc), Register::SP);
     }
   }
 }
@@ -2,12 +2,13 @@
 
 #include <memory>
 #include <vector>
-#include <fstream>
+#include <cstdint>
 #include <optional>
-#include <unordered_map>
 
 namespace sym {
 
+using ValueId = std::uint32_t;
+
 struct Value;
 using ValuePtr = std::shared_ptr<Value>;
 
@@ -15,6 +16,7 @@ using ValuePtr = std::shared_ptr<Value>;
 
 namespace cg {
 
+class MCode;
 class StackAllocator;
 class RegAllocator;
 struct Symbol;
@@ -23,14 +25,24 @@ enum class Register : std::uint8_t;
 
 class MemAllocator {
 public:
-  MemAllocator(std::ofstream &out, RegAllocator &regalloc, StackAllocator &stackalloc)
-    : out(out), regalloc(regalloc), stackalloc(stackalloc) {}
+  MemAllocator(MCode &mc, RegAllocator &regalloc,
+    StackAllocator &stackalloc, std::size_t value_cnt)
+    : mc(mc), regalloc(regalloc), stackalloc(stackalloc), symtab(value_cnt) {}
 
 public:
-  void reset() { symtab.clear(); }
-
-  auto alloc(const sym::ValuePtr &val, bool be_assigned) -> Register;
+  /**
+   * @brief 清空当前函数的符号，只清理登记过的位置
+   */
+  void reset() {
+    for (auto id : touched) {
+      symtab[id] = nullptr;
+    }
+    touched.clear();
+  }
+
+  auto alloc(const sym::ValuePtr &val, bool be_assigned, bool across_call = false) -> Register;
   void reuseReg(Register reg, const sym::ValuePtr &val);
+  bool coalesce(const sym::ValuePtr &src, const sym::ValuePtr &dst);
 
   void prepareParam(const std::vector<sym::ValuePtr> &params);
 
@@ -41,12 +53,26 @@ public:
   void allocArgv(const std::vector<sym::ValuePtr> &argv);
 
 private:
-  std::ofstream &out;
+  void record(const SymbolPtr &symbol);
+
+  /**
+   * @brief 值编号对应的符号槽位；优化 pass 新建的值编号可能超出初始容量
+   */
+  SymbolPtr &slot(sym::ValueId id) {
+    if (id >= symtab.size()) {
+      symtab.resize(id + 1);
+    }
+    return symtab[id];
+  }
+
+private:
+  MCode &mc;
 
   RegAllocator   &regalloc;
   StackAllocator &stackalloc;
 
-  std::unordered_map<std::string, SymbolPtr> symtab;
+  std::vector<SymbolPtr>    symtab;  // sym::ValueId -> Symbol
+  std::vector<sym::ValueId> touched; // 当前函数中登记过符号的编号
 };
 
 } // namespace cg
@@ -1,5 +1,5 @@
-#include <print>
 #include <ranges>
+#include <algorithm>
 
 #include "panic.hpp"
 #include "asm_dbg.hpp"
@@ -12,8 +12,9 @@ namespace cg {
  * @brief 分配一个寄存器
  *
  * 优先分配 caller saved 寄存器，如果 caller saved 寄存器都被使用了
- * 则分配 callee saved 寄存器。如果所有寄存器都被分配了，则 spill 一个
- * 寄存器到栈中
+ * 则分配 callee saved 寄存器；跨过调用活跃的符号反过来优先分配
+ * callee saved 寄存器，调用时不必写回。如果所有寄存器都被分配了，
+ * 则 spill 一个寄存器到栈中
  *
  * @return Register 分配到的寄存器
  */
@@ -21,13 +22,13 @@ Register
 RegAllocator::alloc(const SymbolPtr &symbol)
 {
   Register alloced_reg;
-  if (auto [success, reg] = allocReg(); success) {
+  if (auto [success, reg] = allocReg(symbol->across_call); success) {
     alloced_reg = reg.value();
   } else {
     alloced_reg = spill();
   }
 
-  regpool[toIndex(alloced_reg)][symbol->val->str()] = symbol;
+  insert(regpool[toIndex(alloced_reg)], symbol);
 
   return alloced_reg;
 }
@@ -38,31 +39,50 @@ RegAllocator::reuse(Register reg, const SymbolPtr &symbol)
   auto &sympool = regpool[toIndex(reg)];
   symbol->in_reg = true;
   symbol->regloc = reg;
-  sympool[symbol->val->str()] = symbol;
+  insert(sympool, symbol);
+}
+
+/**
+ * @brief 将符号放入寄存器的符号池，同一个值只保留一份
+ */
+void
+RegAllocator::insert(SymPool &sympool, const SymbolPtr &symbol)
+{
+  auto it = std::ranges::find_if(sympool, [&symbol](const auto &pooled) {
+    return pooled->val->id == symbol->val->id;
+  });
+  if (it != sympool.end()) {
+    *it = symbol;
+  } else {
+    sympool.push_back(symbol);
+  }
 }
 
 /**
  * @brief 分配一个 register
  *
+ * @param callee_first 是否先尝试 callee saved register
  * @return std::tuple<bool, std::optional<Register>>
  *         是否分配成功，以及分配到的 register
  */
 std::tuple<bool, std::optional<Register>>
-RegAllocator::allocReg()
+RegAllocator::allocReg(bool callee_first)
 {
+  if (callee_first) {
+    for (const auto &reg : CALLEE_SAVED_REGS) {
+      if (regpool[toIndex(reg)].empty()) {
+        saveCallee(reg);
+        return {true, reg};
+      }
+    }
+  }
+
   for (const auto &[idx, sympool] : std::ranges::enumerate_view(regpool)) {
     // 找到第一个没有被使用的 register
     Register reg = toReg(idx);
     if (sympool.empty()) {
-      if (isCaller(reg)) {
-        return {true, reg};
-      }
-      // 如果是第一次使用这个 callee saved register
-      // 则需要将其 spill 到栈，保留原始值，然后在
-      // 函数 return 前统一恢复其值
-      if (!used_callee.contains(reg)) {
-        int stackloc = spillReg(reg);
-        used_callee[reg] = {.reg = reg, .stackloc = stackloc};
+      if (!isCaller(reg)) {
+        saveCallee(reg);
       }
       return {true, reg};
     }
@@ -70,6 +90,19 @@ RegAllocator::allocReg()
   return {false, std::nullopt};
 }
 
+/**
+ * @brief 如果是第一次使用这个 callee saved register，则需要将其
+ *        spill 到栈，保留原始值，然后在函数 return 前统一恢复其值
+ */
+void
+RegAllocator::saveCallee(Register reg)
+{
+  if (!used_callee.contains(reg)) {
+    int stackloc = spillReg(reg);
+    used_callee[reg] = {.reg = reg, .stackloc = stackloc};
+  }
+}
+
 /**
  * @brief 将一个 register 中的值 spill 到栈中保存起来
  *
@@ -81,12 +114,12 @@ RegAllocator::allocReg()
 int
 RegAllocator::spillReg(Register reg)
 {
-  DBG(out, "  # spill register {}", reg);
+  DBG(mc, "  # spill register {}", reg);
 
   int stackloc = stackalloc.alloc(REG_SIZE, REG_SIZE);
   int offset = stackalloc.offsetFromSP(stackloc);
 
-  std::println(out, "  sd {}, {}(sp)", reg, offset);
+  mc.store(MOp::SD, reg, offset, Register::SP);
 
   return stackloc;
 }
@@ -101,18 +134,17 @@ RegAllocator::spillSymbolIn(Register reg)
 {
   RegAllocator::SymPool &sympool = regpool[toIndex(reg)];
 
-  DBG(out, "  # spill symbol in register {}", reg);
+  DBG(mc, "  # spill symbol in register {}", reg);
 
   // 如果寄存器对应的符号池中没有符号，则直接返回
   if (sympool.empty()) {
     return;
   }
 
-  for (auto &sympair : sympool) {
+  for (const auto &symbol : sympool) {
     // 对于 symbol pool 中的每个 symbol
     // 如果其没有在栈上分配空间，或者分配了且有被修改
     // 则将寄存器中的值写回栈上
-    auto symbol = sympair.second;
     CHECK(symbol != nullptr, "can't find symbol");
 
     // 如果该符号已经在栈上分配了空间，
@@ -128,7 +160,7 @@ RegAllocator::spillSymbolIn(Register reg)
     }
 
     int delta = stackalloc.getFrameSize() - symbol->stackloc;
-    std::println(out, "  sw {}, {}(sp)", reg, delta);
+    mc.store(MOp::SW, reg, delta, Register::SP);
     symbol->dirty    = false;
     symbol->in_reg   = false;
   }
@@ -141,52 +173,63 @@ RegAllocator::spillExcept(const SymbolPtr &symbol)
 {
   RegAllocator::SymPool &sympool = regpool[toIndex(symbol->regloc)];
 
-  DBG(out,
+  DBG(mc,
     "  # spill symbol in register {} except {}",
     symbol->regloc,
     symbol->val->str()
   );
 
-  for (auto &sympair : sympool) {
-    if (sympair.first == symbol->val->str()) {
+  for (const auto &other : sympool) {
+    CHECK(other != nullptr, "can't find symbol");
+    if (other->val->id == symbol->val->id) {
       continue;
     }
 
     // 对于 symbol pool 中的每个 symbol
     // 如果其没有在栈上分配空间，或者分配了且有被修改
     // 则将寄存器中的值写回栈上
-    auto symbol = sympair.second;
-    CHECK(symbol != nullptr, "can't find symbol");
-
     // 如果该符号已经在栈上分配了空间，
     // 并且寄存器中的值并没有被修改，则不需要写回
-    if (symbol->on_stack && !symbol->dirty) {
+    if (other->on_stack && !other->dirty) {
       continue;
     }
 
-    if (!symbol->on_stack) {
+    if (!other->on_stack) {
       // 没在栈上分配空间则分配
-      symbol->stackloc = stackalloc.spill(symbol->val);
-      symbol->on_stack = true;
+      other->stackloc = stackalloc.spill(other->val);
+      other->on_stack = true;
     }
 
-    int delta = stackalloc.getFrameSize() - symbol->stackloc;
-    std::println(out, "  sw {}, {}(sp)", symbol->regloc, delta);
-    symbol->dirty    = false;
-    symbol->in_reg   = false;
+    int delta = stackalloc.getFrameSize() - other->stackloc;
+    mc.store(MOp::SW, other->regloc, delta, Register::SP);
+    other->dirty    = false;
+    other->in_reg   = false;
   }
 
   sympool.clear();
-  sympool[symbol->val->str()] = symbol;
+  sympool.push_back(symbol);
 }
 
 /**
- * @brief 将 caller saved register 中的符号写回栈上
+ * @brief 调用前将 caller saved register 中的符号写回栈上
+ *
+ * 只有调用之后仍然需要的符号才写回，其余的符号已经死亡，直接丢弃
+ *
+ * @param saved 需要留存的符号（sym::Value 编号）
  */
 void
-RegAllocator::spillCaller()
+RegAllocator::spillCaller(const std::unordered_set<std::uint32_t> &saved)
 {
   for (const auto &reg : CALLER_SAVED_REGS) {
+    auto &sympool = regpool[toIndex(reg)];
+    std::erase_if(sympool, [&saved](const auto &symbol) {
+      if (saved.contains(symbol->val->id)) {
+        return false;
+      }
+      symbol->in_reg = false;
+      symbol->dirty  = false;
+      return true;
+    });
     spillSymbolIn(reg);
   }
 }
@@ -199,8 +242,8 @@ RegAllocator::restoreUsedCallee()
 {
   for (const auto &callee_pair : used_callee) {
     const auto &callee = callee_pair.second;
-    DBG(out,"  # restore register {}", callee.reg);
-    std::println(out, "  ld {}, {}(sp)", callee.reg, callee.stackloc);
+    DBG(mc,"  # restore register {}", callee.reg);
+    mc.load(MOp::LD, callee.reg, stackalloc.offsetFromSP(callee.stackloc), Register::SP);
   }
 }
 
@@ -239,23 +282,41 @@ RegAllocator::free(Register reg)
 void
 RegAllocator::free(const SymbolPtr &symbol)
 {
-  DBG(out, "  # free symbol {}", symbol->val->str());
+  DBG(mc, "  # free symbol {}", symbol->val->str());
 
   if (!symbol->in_reg) {
-    DBG(out, "  # this symbol is not in a register");
+    DBG(mc, "  # this symbol is not in a register");
     return;
   }
 
   if (symbol->on_stack && symbol->dirty) {
-    std::println(out,
-      "  sw {}, {}(sp)",
-      symbol->regloc,
-      stackalloc.offsetFromSP(symbol->stackloc)
-    );
+    mc.store(MOp::SW, symbol->regloc, stackalloc.offsetFromSP(symbol->stackloc), Register::SP);
+  }
+
+  auto &sympool = regpool[toIndex(symbol->regloc)];
+  std::erase_if(sympool, [&symbol](const auto &pooled) {
+    return pooled->val->id == symbol->val->id;
+  });
+}
+
+/**
+ * @brief 从寄存器中移除一个不再活跃的符号，不写回栈上
+ *
+ * @param symbol 待移除的符号
+ */
+void
+RegAllocator::drop(const SymbolPtr &symbol)
+{
+  if (!symbol->in_reg) {
+    return;
   }
 
   auto &sympool = regpool[toIndex(symbol->regloc)];
-  sympool.erase(sympool.find(symbol->val->str()));
+  std::erase_if(sympool, [&symbol](const auto &pooled) {
+    return pooled->val->id == symbol->val->id;
+  });
+  symbol->in_reg = false;
+  symbol->dirty  = false;
 }
 
 } // namespace cg
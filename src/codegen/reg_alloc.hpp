@@ -3,10 +3,12 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <fstream>
+#include <cstdint>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "machine.hpp"
 #include "riscv_reg.hpp"
 
 namespace sym {
@@ -28,6 +30,7 @@ struct Symbol {
                      // 则可能出现二者保存的数据不一致的情况
                      // 且通常是寄存器中的数据更新
                      // 所以标记 dirty 意味着 stack 上的数据不能直接使用！
+  bool across_call; // 跨过调用活跃：优先放入被调用者保存寄存器，调用时不必写回
   int      stackloc;
   Register regloc;
 };
@@ -35,17 +38,19 @@ using SymbolPtr = std::shared_ptr<Symbol>;
 
 class RegAllocator {
 public:
-  RegAllocator(std::ofstream &out, StackAllocator &stackalloc)
-    : out(out), stackalloc(stackalloc) {}
+  RegAllocator(MCode &mc, StackAllocator &stackalloc)
+    : mc(mc), stackalloc(stackalloc) {}
 
 private:
-  using SymPool = std::unordered_map<std::string, SymbolPtr>;
+  // 寄存器中保存的符号，通常只有一个，按 sym::ValueId 区分
+  using SymPool = std::vector<SymbolPtr>;
 
 public:
   void reset() {
     regpool.clear();
     regpool.resize(AVAILABLE_REG_CNT);
     used_callee.clear();
+    spill_reg = Register::A0; // 每个函数的代码只取决于函数本身，与生成顺序无关
   }
 
   auto alloc(const SymbolPtr &symbol) -> Register;
@@ -53,8 +58,9 @@ public:
 
   void free(Register reg);
   void free(const SymbolPtr &symbol);
+  void drop(const SymbolPtr &symbol);
 
-  void spillCaller();
+  void spillCaller(const std::unordered_set<std::uint32_t> &saved);
   void restoreUsedCallee();
 
   void spillExcept(const SymbolPtr &symbol);
@@ -62,13 +68,16 @@ public:
 private:
   auto spill() -> Register;
 
-  auto allocReg() -> std::tuple<bool, std::optional<Register>>;
+  auto allocReg(bool callee_first) -> std::tuple<bool, std::optional<Register>>;
+  void saveCallee(Register reg);
 
   auto spillReg(Register reg) -> int;
   void spillSymbolIn(Register reg);
 
+  static void insert(SymPool &sympool, const SymbolPtr &symbol);
+
 private:
-  std::ofstream  &out;
+  MCode          &mc;
   StackAllocator &stackalloc;
 
   std::vector<SymPool> regpool;
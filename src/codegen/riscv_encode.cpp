@@ -0,0 +1,379 @@
+#include <bit>
+#include <string>
+#include <cstdint>
+
+#include "panic.hpp"
+#include "riscv_encode.hpp"
+
+namespace cg {
+
+namespace {
+
+// 主操作码
+inline constexpr std::uint32_t OP_LOAD     = 0x03;
+inline constexpr std::uint32_t OP_LOAD_FP  = 0x07;
+inline constexpr std::uint32_t OP_IMM      = 0x13;
+inline constexpr std::uint32_t OP_AUIPC    = 0x17;
+inline constexpr std::uint32_t OP_IMM_32   = 0x1b;
+inline constexpr std::uint32_t OP_STORE    = 0x23;
+inline constexpr std::uint32_t OP_STORE_FP = 0x27;
+inline constexpr std::uint32_t OP_REG      = 0x33;
+inline constexpr std::uint32_t OP_LUI      = 0x37;
+inline constexpr std::uint32_t OP_VECTOR   = 0x57;
+inline constexpr std::uint32_t OP_BRANCH   = 0x63;
+inline constexpr std::uint32_t OP_JALR     = 0x67;
+inline constexpr std::uint32_t OP_JAL      = 0x6f;
+inline constexpr std::uint32_t OP_SYSTEM   = 0x73;
+
+// vsetvli 的 vtype：e32、m1、ta、ma
+inline constexpr std::uint32_t VTYPE_E32_M1 = 0xd0;
+
+/**
+ * @brief 寄存器在指令中的编号（x0-x31）
+ */
+std::uint32_t
+xreg(Register reg)
+{
+  switch (reg) {
+    case Register::ZERO: return 0;
+    case Register::RA:   return 1;
+    case Register::SP:   return 2;
+    case Register::T0: case Register::T1: case Register::T2:
+      return 5 + static_cast<std::uint32_t>(toIndex(reg) - toIndex(Register::T0));
+    case Register::S0: case Register::S1:
+      return 8 + static_cast<std::uint32_t>(toIndex(reg) - toIndex(Register::S0));
+    default:
+      break;
+  }
+  if (toIndex(reg) <= toIndex(Register::A7)) {
+    return 10 + static_cast<std::uint32_t>(toIndex(reg));
+  }
+  if (toIndex(reg) <= toIndex(Register::T6)) {
+    return 28 + static_cast<std::uint32_t>(toIndex(reg) - toIndex(Register::T3));
+  }
+  return 18 + static_cast<std::uint32_t>(toIndex(reg) - toIndex(Register::S2));
+}
+
+/**
+ * @brief 压缩指令 3 位寄存器字段中的编号（x8-x15 -> 0-7）
+ */
+inline std::uint32_t
+creg(Register reg)
+{
+  return xreg(reg) - 8;
+}
+
+/**
+ * @brief 取 imm 的第 lo 位到第 hi 位
+ */
+inline std::uint32_t
+bits(std::int64_t imm, int hi, int lo)
+{
+  return static_cast<std::uint32_t>(static_cast<std::uint64_t>(imm) >> lo) & ((1U << (hi - lo + 1)) - 1);
+}
+
+/**
+ * @brief 低 12 位按有符号数解释的值
+ */
+inline std::int64_t
+low12(std::int64_t imm)
+{
+  return static_cast<std::int64_t>(static_cast<std::uint64_t>(imm) << 52) >> 52;
+}
+
+inline bool
+fits(std::int64_t imm, int width)
+{
+  return imm >= -(std::int64_t{1} << (width - 1)) && imm < (std::int64_t{1} << (width - 1));
+}
+
+void
+word(std::string &out, std::uint32_t inst)
+{
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>(inst >> (8 * i)));
+  }
+}
+
+void
+half(std::string &out, std::uint32_t inst)
+{
+  out.push_back(static_cast<char>(inst));
+  out.push_back(static_cast<char>(inst >> 8));
+}
+
+std::uint32_t
+rType(std::uint32_t funct7, std::uint32_t rs2, std::uint32_t rs1, std::uint32_t funct3, std::uint32_t rd,
+  std::uint32_t opcode)
+{
+  return funct7 << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | rd << 7 | opcode;
+}
+
+std::uint32_t
+iType(std::int64_t imm, std::uint32_t rs1, std::uint32_t funct3, std::uint32_t rd, std::uint32_t opcode)
+{
+  return bits(imm, 11, 0) << 20 | rs1 << 15 | funct3 << 12 | rd << 7 | opcode;
+}
+
+std::uint32_t
+sType(std::int64_t imm, std::uint32_t rs2, std::uint32_t rs1, std::uint32_t funct3)
+{
+  return bits(imm, 11, 5) << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | bits(imm, 4, 0) << 7 | OP_STORE;
+}
+
+std::uint32_t
+bType(std::int64_t offset, std::uint32_t rs2, std::uint32_t rs1, std::uint32_t funct3)
+{
+  return bits(offset, 12, 12) << 31 | bits(offset, 10, 5) << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12
+    | bits(offset, 4, 1) << 8 | bits(offset, 11, 11) << 7 | OP_BRANCH;
+}
+
+std::uint32_t
+jType(std::int64_t offset, std::uint32_t rd)
+{
+  return bits(offset, 20, 20) << 31 | bits(offset, 10, 1) << 21 | bits(offset, 11, 11) << 20
+    | bits(offset, 19, 12) << 12 | rd << 7 | OP_JAL;
+}
+
+/**
+ * @brief 向量运算：vd = vs2 op vs1/rs1（汇编中 vs2 写在前面）
+ */
+std::uint32_t
+vType(std::uint32_t funct6, std::uint32_t vs2, std::uint32_t vs1, std::uint32_t funct3, std::uint32_t vd)
+{
+  return funct6 << 26 | 1U << 25 | vs2 << 20 | vs1 << 15 | funct3 << 12 | vd << 7 | OP_VECTOR;
+}
+
+/**
+ * @brief li 的展开：12 位以内为 addi，32 位以内为 lui 与 addiw，
+ *        更大的数先装入高位再左移、加上低 12 位
+ */
+void
+loadImm(std::uint32_t rd, std::int64_t imm, std::string &out)
+{
+  auto lo = low12(imm);
+  if (fits(imm, 12)) {
+    word(out, iType(imm, 0, 0, rd, OP_IMM));
+    return;
+  }
+  if (fits(imm, 32)) {
+    word(out, bits(imm - lo, 31, 12) << 12 | rd << 7 | OP_LUI);
+    if (lo != 0) {
+      word(out, iType(lo, rd, 0, rd, OP_IMM_32));
+    }
+    return;
+  }
+  auto hi    = static_cast<std::int64_t>(static_cast<std::uint64_t>(imm) - static_cast<std::uint64_t>(lo)) >> 12;
+  auto shift = std::countr_zero(static_cast<std::uint64_t>(hi));
+  loadImm(rd, hi >> shift, out);
+  word(out, iType(12 + shift, rd, 1, rd, OP_IMM));
+  if (lo != 0) {
+    word(out, iType(lo, rd, 0, rd, OP_IMM));
+  }
+}
+
+std::uint32_t
+branchFunct3(MOp op)
+{
+  switch (op) {
+    case MOp::BEQ:  return 0b000;
+    case MOp::BNE:  return 0b001;
+    case MOp::BLT:  return 0b100;
+    case MOp::BGE:  return 0b101;
+    default:        return 0b111; // bgeu
+  }
+}
+
+/**
+ * @brief 以 MCode::compress 选中的 16 位压缩指令编码
+ */
+std::uint32_t
+encodeCompressed(const MInst &inst)
+{
+  auto rd  = xreg(inst.rd);
+  auto imm = inst.imm;
+  switch (inst.op) {
+    case MOp::LI:
+      return 0b010U << 13 | bits(imm, 5, 5) << 12 | rd << 7 | bits(imm, 4, 0) << 2 | 0b01;
+    case MOp::MV:
+      return 0b1000U << 12 | rd << 7 | xreg(inst.rs1) << 2 | 0b10;
+    case MOp::ADD:
+      return 0b1001U << 12 | rd << 7 | xreg(inst.rd == inst.rs1 ? inst.rs2 : inst.rs1) << 2 | 0b10;
+    case MOp::SEXTW: // c.addiw rd, 0
+      return 0b001U << 13 | rd << 7 | 0b01;
+    case MOp::ADDI:
+      if (inst.rd == Register::SP && inst.rs1 == Register::SP) { // c.addi16sp
+        return 0b011U << 13 | bits(imm, 9, 9) << 12 | 2U << 7 | bits(imm, 4, 4) << 6 | bits(imm, 6, 6) << 5
+          | bits(imm, 8, 7) << 3 | bits(imm, 5, 5) << 2 | 0b01;
+      }
+      if (inst.rs1 == Register::SP) { // c.addi4spn
+        return bits(imm, 5, 4) << 11 | bits(imm, 9, 6) << 7 | bits(imm, 2, 2) << 6 | bits(imm, 3, 3) << 5
+          | creg(inst.rd) << 2;
+      }
+      return bits(imm, 5, 5) << 12 | rd << 7 | bits(imm, 4, 0) << 2 | 0b01;
+    case MOp::SUB: case MOp::XOR:
+      return 0b100011U << 10 | creg(inst.rd) << 7 | (inst.op == MOp::SUB ? 0b00U : 0b01U) << 5
+        | creg(inst.rs2) << 2 | 0b01;
+    case MOp::SLLI:
+      return bits(imm, 5, 5) << 12 | rd << 7 | bits(imm, 4, 0) << 2 | 0b10;
+    case MOp::SRLI: case MOp::SRAI:
+      return 0b100U << 13 | bits(imm, 5, 5) << 12 | (inst.op == MOp::SRLI ? 0b00U : 0b01U) << 10
+        | creg(inst.rd) << 7 | bits(imm, 4, 0) << 2 | 0b01;
+    case MOp::LW: case MOp::SW: {
+      auto funct3 = inst.op == MOp::LW ? 0b010U : 0b110U;
+      auto data   = inst.op == MOp::LW ? inst.rd : inst.rs2;
+      if (inst.rs1 == Register::SP) {
+        return inst.op == MOp::LW
+          ? 0b010U << 13 | bits(imm, 5, 5) << 12 | rd << 7 | bits(imm, 4, 2) << 4 | bits(imm, 7, 6) << 2 | 0b10
+          : 0b110U << 13 | bits(imm, 5, 2) << 9 | bits(imm, 7, 6) << 7 | xreg(data) << 2 | 0b10;
+      }
+      return funct3 << 13 | bits(imm, 5, 3) << 10 | creg(inst.rs1) << 7 | bits(imm, 2, 2) << 6
+        | bits(imm, 6, 6) << 5 | creg(data) << 2;
+    }
+    case MOp::LD: case MOp::SD: {
+      auto funct3 = inst.op == MOp::LD ? 0b011U : 0b111U;
+      auto data   = inst.op == MOp::LD ? inst.rd : inst.rs2;
+      if (inst.rs1 == Register::SP) {
+        return inst.op == MOp::LD
+          ? 0b011U << 13 | bits(imm, 5, 5) << 12 | rd << 7 | bits(imm, 4, 3) << 5 | bits(imm, 8, 6) << 2 | 0b10
+          : 0b111U << 13 | bits(imm, 5, 3) << 10 | bits(imm, 8, 6) << 7 | xreg(data) << 2 | 0b10;
+      }
+      return funct3 << 13 | bits(imm, 5, 3) << 10 | creg(inst.rs1) << 7 | bits(imm, 7, 6) << 5 | creg(data) << 2;
+    }
+    case MOp::RET: // c.jr ra
+      return 0x8082;
+    case MOp::EBREAK:
+      return 0x9002;
+    default:
+      UNREACHABLE("instruction cannot be compressed");
+  }
+}
+
+} // namespace
+
+/**
+ * @brief 指令编码后的字节数，条件跳转按近跳转计算
+ */
+auto
+encodedSize(const MInst &inst) -> std::size_t
+{
+  if (inst.compressed) {
+    return 2;
+  }
+  switch (inst.op) {
+    case MOp::LABEL: case MOp::DIRECTIVE: case MOp::COMMENT:
+      return 0;
+    case MOp::CALL: case MOp::TAIL: case MOp::LLA:
+      return 8;
+    case MOp::LI: {
+      std::string buf;
+      loadImm(0, inst.imm, buf);
+      return buf.size();
+    }
+    default:
+      return 4;
+  }
+}
+
+/**
+ * @brief 把 inst 的编码追加到 out
+ * @param offset 条件跳转与 j 的目标相对于本指令的偏移
+ */
+void
+encode(const MInst &inst, std::int64_t offset, std::string &out)
+{
+  if (inst.compressed) {
+    half(out, encodeCompressed(inst));
+    return;
+  }
+
+  auto rd  = xreg(inst.rd);
+  auto rs1 = xreg(inst.rs1);
+  auto rs2 = xreg(inst.rs2);
+  switch (inst.op) {
+    case MOp::ADD:  word(out, rType(0b0000000, rs2, rs1, 0b000, rd, OP_REG)); break;
+    case MOp::SUB:  word(out, rType(0b0100000, rs2, rs1, 0b000, rd, OP_REG)); break;
+    case MOp::MUL:  word(out, rType(0b0000001, rs2, rs1, 0b000, rd, OP_REG)); break;
+    case MOp::DIV:  word(out, rType(0b0000001, rs2, rs1, 0b100, rd, OP_REG)); break;
+    case MOp::XOR:  word(out, rType(0b0000000, rs2, rs1, 0b100, rd, OP_REG)); break;
+    case MOp::SLT:  word(out, rType(0b0000000, rs2, rs1, 0b010, rd, OP_REG)); break;
+    case MOp::SLTU: word(out, rType(0b0000000, rs2, rs1, 0b011, rd, OP_REG)); break;
+
+    case MOp::ADDI:  word(out, iType(inst.imm, rs1, 0b000, rd, OP_IMM)); break;
+    case MOp::XORI:  word(out, iType(inst.imm, rs1, 0b100, rd, OP_IMM)); break;
+    case MOp::SLTI:  word(out, iType(inst.imm, rs1, 0b010, rd, OP_IMM)); break;
+    case MOp::SLTIU: word(out, iType(inst.imm, rs1, 0b011, rd, OP_IMM)); break;
+    case MOp::SLLI:  word(out, iType(inst.imm, rs1, 0b001, rd, OP_IMM)); break;
+    case MOp::SRLI:  word(out, iType(inst.imm, rs1, 0b101, rd, OP_IMM)); break;
+    case MOp::SRAI:  word(out, iType(inst.imm | 0x400, rs1, 0b101, rd, OP_IMM)); break;
+
+    case MOp::LI:    loadImm(rd, inst.imm, out); break;
+    case MOp::MV:    word(out, iType(0, rs1, 0b000, rd, OP_IMM)); break;
+    case MOp::NEG:   word(out, rType(0b0100000, rs1, 0, 0b000, rd, OP_REG)); break;
+    case MOp::SEXTW: word(out, iType(0, rs1, 0b000, rd, OP_IMM_32)); break;
+    case MOp::LLA:   UNREACHABLE("lla refers to a data symbol, which objects written directly do not define");
+
+    case MOp::LW: word(out, iType(inst.imm, rs1, 0b010, rd, OP_LOAD)); break;
+    case MOp::LD: word(out, iType(inst.imm, rs1, 0b011, rd, OP_LOAD)); break;
+    case MOp::SW: word(out, sType(inst.imm, rs2, rs1, 0b010)); break;
+    case MOp::SD: word(out, sType(inst.imm, rs2, rs1, 0b011)); break;
+
+    case MOp::BEQ: case MOp::BNE: case MOp::BLT: case MOp::BGE: case MOp::BGEU:
+      word(out, bType(offset, rs2, rs1, branchFunct3(inst.op)));
+      break;
+    case MOp::J:
+      word(out, jType(offset, 0));
+      break;
+    case MOp::CALL: // auipc ra, 0; jalr ra, 0(ra)
+      word(out, 1U << 7 | OP_AUIPC);
+      word(out, iType(0, 1, 0b000, 1, OP_JALR));
+      break;
+    case MOp::TAIL: // auipc t1, 0; jalr x0, 0(t1)
+      word(out, 6U << 7 | OP_AUIPC);
+      word(out, iType(0, 6, 0b000, 0, OP_JALR));
+      break;
+    case MOp::RET:
+      word(out, iType(0, 1, 0b000, 0, OP_JALR));
+      break;
+    case MOp::EBREAK:
+      word(out, 1U << 20 | OP_SYSTEM);
+      break;
+
+    case MOp::VSETVLI:
+      word(out, VTYPE_E32_M1 << 20 | rs1 << 15 | 0b111U << 12 | rd << 7 | OP_VECTOR);
+      break;
+    case MOp::VLE32: // 单位步长，width = 110 为 32 位元素
+      word(out, 1U << 25 | rs1 << 15 | 0b110U << 12 | std::uint32_t{inst.vd} << 7 | OP_LOAD_FP);
+      break;
+    case MOp::VSE32:
+      word(out, 1U << 25 | rs1 << 15 | 0b110U << 12 | std::uint32_t{inst.vd} << 7 | OP_STORE_FP);
+      break;
+    case MOp::VADD_VV: word(out, vType(0b000000, inst.vs1, inst.vs2, 0b000, inst.vd)); break;
+    case MOp::VSUB_VV: word(out, vType(0b000010, inst.vs1, inst.vs2, 0b000, inst.vd)); break;
+    case MOp::VMUL_VV: word(out, vType(0b100101, inst.vs1, inst.vs2, 0b010, inst.vd)); break;
+    case MOp::VDIV_VV: word(out, vType(0b100001, inst.vs1, inst.vs2, 0b010, inst.vd)); break;
+    case MOp::VADD_VX:  word(out, vType(0b000000, inst.vs1, rs1, 0b100, inst.vd)); break;
+    case MOp::VSUB_VX:  word(out, vType(0b000010, inst.vs1, rs1, 0b100, inst.vd)); break;
+    case MOp::VRSUB_VX: word(out, vType(0b000011, inst.vs1, rs1, 0b100, inst.vd)); break;
+    case MOp::VMUL_VX:  word(out, vType(0b100101, inst.vs1, rs1, 0b110, inst.vd)); break;
+    case MOp::VDIV_VX:  word(out, vType(0b100001, inst.vs1, rs1, 0b110, inst.vd)); break;
+    case MOp::VMV_VX:   word(out, vType(0b010111, 0, rs1, 0b100, inst.vd)); break;
+
+    default: // 标号、伪操作与注释
+      break;
+  }
+}
+
+/**
+ * @brief 超出范围的条件跳转：取反的条件跳过 8 字节，再 jal 到目标
+ * @param offset 目标相对于本指令（取反的条件跳转）的偏移
+ */
+void
+encodeFarBranch(const MInst &inst, std::int64_t offset, std::string &out)
+{
+  auto funct3 = branchFunct3(inst.op) ^ 1U; // beq/bne、blt/bge、bltu/bgeu 只差最低位
+  word(out, bType(FAR_BRANCH_SIZE, xreg(inst.rs2), xreg(inst.rs1), funct3));
+  word(out, jType(offset - 4, 0));
+}
+
+} // namespace cg
@@ -0,0 +1,52 @@
+/**
+ * @file riscv_encode.hpp
+ * @brief Binary encoding of the buffered machine instructions.
+ *
+ * Every MInst maps to a fixed sequence of little-endian RV64 instruction
+ * words: pseudo-instructions expand as the assembler would (li to
+ * lui/addiw/slli/addi, mv to addi, call and tail to auipc + jalr), compressed
+ * instructions become their 16-bit RVC encoding and the RVV instructions use
+ * the e32, m1, ta, ma configuration. Labels, directives and comments encode
+ * to nothing.
+ *
+ * Jump targets are not known here: the caller lays the code out, resolves
+ * labels and passes the pc-relative offset of a branch or j; call and tail
+ * are encoded with a zero offset and need an R_RISCV_CALL relocation.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "machine.hpp"
+
+namespace cg {
+
+// 超出 ±4KiB 的条件跳转：取反的条件跳过其后的 jal，共 8 字节
+inline constexpr std::size_t FAR_BRANCH_SIZE = 8;
+
+/**
+ * @brief 条件跳转的偏移能否直接编码（13 位有符号数）
+ */
+inline bool
+isNearBranch(std::int64_t offset)
+{
+  return offset >= -4096 && offset < 4096;
+}
+
+/**
+ * @brief jal 的偏移能否直接编码（21 位有符号数）
+ */
+inline bool
+isNearJump(std::int64_t offset)
+{
+  return offset >= -(1 << 20) && offset < (1 << 20);
+}
+
+auto encodedSize(const MInst &inst) -> std::size_t;
+void encode(const MInst &inst, std::int64_t offset, std::string &out);
+void encodeFarBranch(const MInst &inst, std::int64_t offset, std::string &out);
+
+} // namespace cg
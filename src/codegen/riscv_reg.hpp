@@ -19,6 +19,9 @@ enum class Register : std::uint8_t {
   S0 = 15, S1 = 16, S2  = 17, S3  = 18,
   S4 = 19, S5 = 20, S6  = 21, S7  = 22,
   S8 = 23, S9 = 24, S10 = 25, S11 = 26,
+
+  // 不参与分配的寄存器：栈指针、恒为 0 的 x0 与返回地址
+  SP = 27, ZERO = 28, RA = 29,
 };
 
 constexpr unsigned char REG_SIZE = 8; // 8 byte = 64 bit
@@ -45,6 +48,11 @@ inline bool isCallee(Register reg) {
   return toIndex(reg) >= CALLER_SAVED_REG_CNT;
 }
 
+// 压缩指令 3 位的寄存器字段只能表示 x8-x15，即 s0、s1 与 a0-a5
+inline bool isCompressible(Register reg) {
+  return reg == Register::S0 || reg == Register::S1 || toIndex(reg) <= toIndex(Register::A5);
+}
+
 constexpr std::array<Register, CALLER_SAVED_REG_CNT> CALLER_SAVED_REGS = {
   Register::A0, Register::A1, Register::A2, Register::A3,
   Register::A4, Register::A5, Register::A6, Register::A7,
@@ -87,6 +95,9 @@ inline std::string toString(Register r) {
     case Register::S9:  return "s9";
     case Register::S10: return "s10";
     case Register::S11: return "s11";
+    case Register::SP:   return "sp";
+    case Register::ZERO: return "x0";
+    case Register::RA:   return "ra";
     default: UNREACHABLE("invalid register");
   }
 }
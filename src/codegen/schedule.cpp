@@ -0,0 +1,212 @@
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "machine.hpp"
+#include "target_cost.hpp"
+
+namespace cg {
+
+namespace {
+
+// 一次调度的指令数上限，依赖图按窗口建立，代价与块的长度成线性关系
+inline constexpr std::size_t SCHED_WINDOW = 256;
+
+inline constexpr std::size_t REG_COUNT = static_cast<std::size_t>(Register::RA) + 1;
+
+inline bool
+isLoad(MOp op)
+{
+  return op == MOp::LW || op == MOp::LD;
+}
+
+inline bool
+isStore(MOp op)
+{
+  return op == MOp::SW || op == MOp::SD;
+}
+
+inline int
+width(MOp op)
+{
+  return op == MOp::LW || op == MOp::SW ? 4 : 8;
+}
+
+/**
+ * @brief 结果可以被使用之前经过的周期数
+ */
+int
+latency(const MInst &inst, const TargetCost &cost)
+{
+  switch (inst.op) {
+    case MOp::LW: case MOp::LD: return cost.load;
+    case MOp::MUL:              return cost.mul;
+    case MOp::DIV:              return cost.div;
+    default:                    return cost.alu;
+  }
+}
+
+/**
+ * @brief 两条访存指令是否可能访问同一位置：
+ *        都以 sp 为基址时比较偏移，其余的地址无法区分
+ */
+bool
+mayAlias(const MInst &a, const MInst &b)
+{
+  if (a.rs1 != Register::SP || b.rs1 != Register::SP) {
+    return true;
+  }
+  return a.imm < b.imm + width(b.op) && b.imm < a.imm + width(a.op);
+}
+
+} // namespace
+
+/**
+ * @brief 在标号、跳转与调用之间分段做表调度（list scheduling）
+ */
+void
+MCode::schedule(const TargetCost &cost)
+{
+  std::size_t begin = 0;
+  for (std::size_t i = 0; i < insts.size(); ++i) {
+    if (insts[i].isBarrier()) {
+      scheduleRegion(begin, i, cost);
+      begin = i + 1;
+    }
+  }
+  scheduleRegion(begin, insts.size(), cost);
+}
+
+/**
+ * @brief 重排 [begin, end) 中的指令，使单发射顺序流水线停顿最少
+ *
+ * 依赖图的边：寄存器的写后读（权为前者的延迟）、读后写与写后写，
+ * 以及可能访问同一位置且至少有一条是存储的访存指令。每个周期从
+ * 前驱都已发射的指令中，选操作数最早就绪的，其次是到末尾的关键路径
+ * 最长的，再其次是原来的顺序。注释跟随其后的指令移动。
+ */
+void
+MCode::scheduleRegion(std::size_t begin, std::size_t end, const TargetCost &cost)
+{
+  for (std::size_t window = begin; window < end;) {
+    // 窗口中的指令（不含注释），以及每条指令之前的注释从哪里开始
+    std::vector<std::size_t> nodes;
+    std::vector<std::size_t> leads;
+    auto lead = window;
+    auto last = window;
+    for (; last < end && nodes.size() < SCHED_WINDOW; ++last) {
+      if (insts[last].op != MOp::COMMENT) {
+        nodes.push_back(last);
+        leads.push_back(lead);
+        lead = last + 1;
+      }
+    }
+    if (nodes.size() < 2) {
+      window = last;
+      continue;
+    }
+
+    auto n = nodes.size();
+    std::vector<std::vector<std::pair<std::size_t, int>>> succs(n);
+    std::vector<std::uint32_t> preds(n, 0);
+    auto edge = [&](std::size_t from, std::size_t to, int lat) {
+      succs[from].emplace_back(to, lat);
+      ++preds[to];
+    };
+
+    std::vector<std::size_t>              writer(REG_COUNT, n);
+    std::vector<std::vector<std::size_t>> readers(REG_COUNT);
+    std::vector<std::size_t>              mems;
+    for (std::size_t k = 0; k < n; ++k) {
+      const auto &inst = insts[nodes[k]];
+      for (auto reg : inst.uses()) {
+        auto r = static_cast<std::size_t>(reg);
+        if (reg == Register::ZERO) {
+          continue;
+        }
+        if (writer[r] != n) {
+          edge(writer[r], k, latency(insts[nodes[writer[r]]], cost));
+        }
+        readers[r].push_back(k);
+      }
+      if (auto reg = inst.def(); reg != Register::ZERO) {
+        auto r = static_cast<std::size_t>(reg);
+        for (auto reader : readers[r]) {
+          if (reader != k) {
+            edge(reader, k, 0);
+          }
+        }
+        if (writer[r] != n) {
+          edge(writer[r], k, 0);
+        }
+        writer[r] = k;
+        readers[r].clear();
+      }
+      if (isLoad(inst.op) || isStore(inst.op)) {
+        for (auto prev : mems) {
+          const auto &other = insts[nodes[prev]];
+          if ((isStore(inst.op) || isStore(other.op)) && mayAlias(other, inst)) {
+            edge(prev, k, isStore(other.op) ? 1 : 0);
+          }
+        }
+        mems.push_back(k);
+      }
+    }
+
+    // 到末尾的关键路径长度；边总是从前往后，逆序一遍即可
+    std::vector<int> height(n, 0);
+    for (auto k = n; k-- > 0;) {
+      height[k] = latency(insts[nodes[k]], cost);
+      for (auto [succ, lat] : succs[k]) {
+        height[k] = std::max(height[k], lat + height[succ]);
+      }
+    }
+
+    std::vector<int>         earliest(n, 0);
+    std::vector<std::size_t> ready;
+    std::vector<std::size_t> order;
+    for (std::size_t k = 0; k < n; ++k) {
+      if (preds[k] == 0) {
+        ready.push_back(k);
+      }
+    }
+    for (int cycle = 0; !ready.empty();) {
+      auto best = std::ranges::min_element(ready, [&](std::size_t a, std::size_t b) {
+        auto sa = std::max(earliest[a], cycle);
+        auto sb = std::max(earliest[b], cycle);
+        if (sa != sb) {
+          return sa < sb;
+        }
+        return height[a] != height[b] ? height[a] > height[b] : a < b;
+      });
+      auto k = *best;
+      ready.erase(best);
+      order.push_back(k);
+
+      auto start = std::max(earliest[k], cycle);
+      cycle = start + 1;
+      for (auto [succ, lat] : succs[k]) {
+        earliest[succ] = std::max(earliest[succ], start + lat);
+        if (--preds[succ] == 0) {
+          ready.push_back(succ);
+        }
+      }
+    }
+
+    // 按新的顺序写回，窗口末尾的注释留在原处
+    std::vector<MInst> scheduled;
+    scheduled.reserve(last - window);
+    for (auto k : order) {
+      for (auto i = leads[k]; i <= nodes[k]; ++i) {
+        scheduled.push_back(std::move(insts[i]));
+      }
+    }
+    for (auto i = nodes.back() + 1; i < last; ++i) {
+      scheduled.push_back(std::move(insts[i]));
+    }
+    std::ranges::move(scheduled, insts.begin() + static_cast<std::ptrdiff_t>(window));
+    window = last;
+  }
+}
+
+} // namespace cg
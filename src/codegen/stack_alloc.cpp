@@ -1,5 +1,3 @@
-#include <print>
-
 #include "type.hpp"
 #include "panic.hpp"
 #include "asm_dbg.hpp"
@@ -95,8 +93,8 @@ StackAllocator::spMove(int delta)
   framesize += delta_aligned;
 
   // 栈帧是向下增长的因此是移动一个负数！
-  DBG(out, "  # stack grow: {} bytes", delta_aligned);
-  std::println(out, "  addi sp, sp, {}", -delta_aligned);
+  DBG(mc, "  # stack grow: {} bytes", delta_aligned);
+  mc.opImm(MOp::ADDI, Register::SP, Register::SP, -delta_aligned);
 }
 
 /**
@@ -137,22 +135,36 @@ StackAllocator::reset()
   scopemarks.clear();
 }
 
+/**
+ * @brief 进入函数；叶子函数不调用其他函数，ra 不会被改写，不需要保存，
+ *        此时栈帧只在第一次溢出时才分配
+ *
+ * @param leaf 是否是叶子函数
+ */
 void
-StackAllocator::enterFunc()
+StackAllocator::enterFunc(bool leaf)
 {
   enterScope();
+  ra_addr = -1;
+  if (leaf) {
+    return;
+  }
   ra_addr = alloc(4, 4);
-  DBG(out, "  # save return address");
-  std::println(out, "  sw ra, {}(sp)", offsetFromSP(ra_addr));
+  DBG(mc, "  # save return address");
+  mc.store(MOp::SW, Register::RA, offsetFromSP(ra_addr), Register::SP);
 }
 
 void
 StackAllocator::retFunc()
 {
-  DBG(out, "  # restore return address");
-  std::println(out, "  lw ra, {}(sp)", offsetFromSP(ra_addr));
-  DBG(out, "  # release the stack frame");
-  std::println(out, "  addi sp, sp, {}", framesize);
+  if (ra_addr >= 0) {
+    DBG(mc, "  # restore return address");
+    mc.load(MOp::LW, Register::RA, offsetFromSP(ra_addr), Register::SP);
+  }
+  if (framesize > 0) {
+    DBG(mc, "  # release the stack frame");
+    mc.opImm(MOp::ADDI, Register::SP, Register::SP, framesize);
+  }
 }
 
 void
@@ -1,9 +1,9 @@
 #pragma once
 
 #include <vector>
-#include <fstream>
 
 #include "symbol.hpp"
+#include "machine.hpp"
 
 namespace cg {
 
@@ -45,7 +45,7 @@ namespace cg {
 
 class StackAllocator {
 public:
-  StackAllocator(std::ofstream &out) : out(out) {}
+  StackAllocator(MCode &mc) : mc(mc) {}
 public:
   static constexpr std::uint8_t BLOCK_SIZE = 16; // 栈上内存以 16B/Block 的方式分配
 
@@ -56,7 +56,7 @@ public:
   void reset();
 
   // Scope
-  void enterFunc();
+  void enterFunc(bool leaf);
   void enterScope();
   void exitScope();
 
@@ -72,12 +72,12 @@ private:
   void spMove(int delta);
 
 private:
-  std::ofstream &out;
+  MCode &mc;
 
   int frameusage = 0; // usage amount (栈帧使用量)
   int framesize  = 0; // 栈帧大小（以 16 Byte 对齐）
 
-  int ra_addr;
+  int ra_addr = -1; // ra 的保存位置，叶子函数不保存
 
   std::vector<int> scopemarks; // scope marks
 };
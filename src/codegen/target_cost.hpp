@@ -0,0 +1,51 @@
+/**
+ * @file target_cost.hpp
+ * @brief Per-core instruction costs used to pick instruction sequences.
+ *
+ * The costs are rough latencies in cycles. They decide whether a
+ * multiplication or division by a constant is replaced by shifts and
+ * additions (or by a multiplication with the reciprocal), where only the
+ * ratio of mul and div to a single-cycle ALU instruction matters, and how
+ * far the instruction scheduler moves a use away from a load, mul or div.
+ * Cores without the M extension emulate mul and div in software and get
+ * large costs.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <array>
+#include <string_view>
+
+namespace cg {
+
+struct TargetCost {
+  std::string_view name;
+  int alu; // add、sub、移位与 12 位以内的 li
+  int mul;
+  int div;
+  int load; // 读出的值可以被使用之前的周期数（load-use）
+};
+
+inline constexpr std::array<TargetCost, 4> TARGETS = {{
+  {.name = "generic",    .alu = 1, .mul = 4,  .div = 34, .load = 3},
+  {.name = "rocket",     .alu = 1, .mul = 4,  .div = 33, .load = 3}, // Rocket：流水线乘法器，迭代除法器
+  {.name = "sifive-u74", .alu = 1, .mul = 3,  .div = 20, .load = 3},
+  {.name = "serial",     .alu = 1, .mul = 32, .div = 66, .load = 2}, // 逐位迭代或软件模拟的乘除法
+}};
+
+/**
+ * @brief 按名字查找处理器的代价表，找不到时为空
+ */
+inline const TargetCost *
+findTarget(std::string_view name)
+{
+  for (const auto &target : TARGETS) {
+    if (target.name == name) {
+      return &target;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace cg
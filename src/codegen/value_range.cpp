@@ -0,0 +1,323 @@
+#include <limits>
+#include <algorithm>
+
+#include "cfg.hpp"
+#include "fold.hpp"
+#include "func_code.hpp"
+#include "value_range.hpp"
+
+namespace cg {
+
+using ir::NONE;
+using ir::IROp;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr std::int64_t MIN_I32 = std::numeric_limits<std::int32_t>::min();
+inline constexpr std::int64_t MAX_I32 = std::numeric_limits<std::int32_t>::max();
+
+inline constexpr std::uint32_t WIDEN_AFTER = 2; // 块入口被更新这么多次之后开始放宽
+
+/**
+ * @brief 比较条件不成立时成立的比较
+ */
+IROp
+negate(IROp op)
+{
+  switch (op) {
+    case IROp::LT:  return IROp::GEQ;
+    case IROp::LEQ: return IROp::GT;
+    case IROp::GT:  return IROp::LEQ;
+    case IROp::GEQ: return IROp::LT;
+    default:        return op;
+  }
+}
+
+bool
+isOrdering(IROp op)
+{
+  return op == IROp::LT || op == IROp::LEQ || op == IROp::GT || op == IROp::GEQ;
+}
+
+} // namespace
+
+ValueRanges::ValueRanges(const ir::FuncCode &code, const Liveness &live) : code(code), live(live)
+{
+  collect();
+  if (count != 0) {
+    solve();
+  }
+}
+
+/**
+ * @brief 值是否可以作为候选值：放在寄存器中的标量，元素别名读出的是内存中的值
+ */
+bool
+ValueRanges::eligible(ValueId value) const
+{
+  return live.tracked(value) && !live.aggregates().isAlias(value);
+}
+
+/**
+ * @brief 从 INDEX 的下标出发，收集计算它们用到的值以及与它们比较的值
+ */
+void
+ValueRanges::collect()
+{
+  slots.assign(code.valueCount(), NONE);
+  auto add = [this](ValueId value) {
+    if (!eligible(value) || slots[value] != NONE) {
+      return false;
+    }
+    slots[value] = count++;
+    return true;
+  };
+
+  for (const auto &quad : code.quads) {
+    if (quad.op == IROp::INDEX) {
+      add(quad.arg2);
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+
+  auto candidate = [this](ValueId value) { return value != NONE && slots[value] != NONE; };
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const auto &quad : code.quads) {
+      auto dst = live.written(quad);
+      bool arith = quad.op == IROp::ASSIGN || quad.op == IROp::ADD
+        || quad.op == IROp::SUB || quad.op == IROp::MUL;
+      if (arith && candidate(dst)) {
+        changed = add(quad.arg1) || changed;
+        changed = add(quad.arg2) || changed;
+      }
+      if (quad.op == IROp::BGE || isOrdering(quad.op)) {
+        if (candidate(quad.arg1) || candidate(quad.arg2)) {
+          changed = add(quad.arg1) || changed;
+          changed = add(quad.arg2) || changed;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief 值在 state 下的区间：常量是一个点，不参与的值不受限制
+ */
+auto
+ValueRanges::get(const State &state, ValueId value) const -> Range
+{
+  if (value == NONE) {
+    return {MIN_I32, MAX_I32};
+  }
+  if (const auto &val = code.value(value); val->isConst()) {
+    auto constant = ir::constValue(*val);
+    return {constant, constant};
+  }
+  return slots[value] != NONE ? state[slots[value]] : Range{MIN_I32, MAX_I32};
+}
+
+/**
+ * @brief 执行一个四元式后候选值的区间；结果可能超出 i32 时不受限制
+ */
+void
+ValueRanges::transfer(const ir::IRQuad &quad, State &state) const
+{
+  auto dst = live.written(quad);
+  if (dst == NONE || slots[dst] == NONE) {
+    return;
+  }
+
+  Range range{MIN_I32, MAX_I32};
+  switch (quad.op) {
+    case IROp::ASSIGN:
+      range = get(state, quad.arg1);
+      break;
+    case IROp::ADD: {
+      auto lhs = get(state, quad.arg1);
+      auto rhs = get(state, quad.arg2);
+      range = {lhs.lo + rhs.lo, lhs.hi + rhs.hi};
+      break;
+    }
+    case IROp::SUB: {
+      auto lhs = get(state, quad.arg1);
+      auto rhs = get(state, quad.arg2);
+      range = {lhs.lo - rhs.hi, lhs.hi - rhs.lo};
+      break;
+    }
+    case IROp::MUL: {
+      auto lhs = get(state, quad.arg1);
+      auto rhs = get(state, quad.arg2);
+      auto products = {lhs.lo * rhs.lo, lhs.lo * rhs.hi, lhs.hi * rhs.lo, lhs.hi * rhs.hi};
+      range = {std::ranges::min(products), std::ranges::max(products)};
+      break;
+    }
+    default:
+      break;
+  }
+  if (range.lo < MIN_I32 || range.hi > MAX_I32) {
+    range = {MIN_I32, MAX_I32};
+  }
+  state[slots[dst]] = range;
+}
+
+/**
+ * @brief 假定 lhs op rhs 成立，收紧两边的区间
+ * @return 条件是否可能成立
+ */
+bool
+ValueRanges::assume(IROp op, ValueId lhs, ValueId rhs, State &state) const
+{
+  if (lhs == rhs) {
+    return true;
+  }
+  switch (op) {
+    case IROp::GT:  return assume(IROp::LT, rhs, lhs, state);
+    case IROp::GEQ: return assume(IROp::LEQ, rhs, lhs, state);
+    case IROp::LT: case IROp::LEQ:
+      break;
+    default:
+      return true;
+  }
+
+  auto a   = get(state, lhs);
+  auto b   = get(state, rhs);
+  auto gap = op == IROp::LT ? 1 : 0;
+  a.hi = std::min(a.hi, b.hi - gap);
+  b.lo = std::max(b.lo, a.lo + gap);
+  if (a.lo > a.hi || b.lo > b.hi) {
+    return false;
+  }
+  if (slots[lhs] != NONE) {
+    state[slots[lhs]] = a;
+  }
+  if (slots[rhs] != NONE) {
+    state[slots[rhs]] = b;
+  }
+  return true;
+}
+
+/**
+ * @brief 沿块 from 到块 to 的边收紧区间
+ * @return 这条边是否可能被执行
+ */
+bool
+ValueRanges::refine(std::size_t from, std::size_t to, State &state) const
+{
+  const auto &block = live.block(from);
+  const auto &last  = code.quads[block.end - 1];
+  if (!ir::isBranch(last.op) || block.succs.size() < 2) {
+    return true;
+  }
+  bool taken = to == live.labelBlock(last.label);
+
+  if (last.op == IROp::BGE) {
+    return assume(taken ? IROp::GEQ : IROp::LT, last.arg1, last.arg2, state);
+  }
+
+  // beqz/bnez 测试同一块中比较的结果，且比较的操作数在此之间没有被改写
+  std::size_t def = NONE;
+  for (auto i = block.end - 1; i-- > block.begin;) {
+    if (live.written(code.quads[i]) == last.arg1) {
+      def = i;
+      break;
+    }
+  }
+  if (def == NONE || !isOrdering(code.quads[def].op)) {
+    return true;
+  }
+  const auto &cmp = code.quads[def];
+  for (auto i = def + 1; i + 1 < block.end; ++i) {
+    auto dst = live.written(code.quads[i]);
+    if (dst == cmp.arg1 || dst == cmp.arg2) {
+      return true;
+    }
+  }
+  bool holds = (last.op == IROp::BNEZ) == taken;
+  return assume(holds ? cmp.op : negate(cmp.op), cmp.arg1, cmp.arg2, state);
+}
+
+/**
+ * @brief 按布局顺序反复前推各块入口的区间，直到不再变化
+ */
+void
+ValueRanges::solve()
+{
+  auto blocks = live.blocks();
+  entry.assign(blocks.size(), State(count, Range{MIN_I32, MAX_I32}));
+  reached.assign(blocks.size(), false);
+  if (blocks.empty()) {
+    return;
+  }
+  reached[0] = true;
+
+  std::vector<std::uint32_t> updates(blocks.size(), 0);
+  auto merge = [&](std::size_t block, const State &state) {
+    if (!reached[block]) {
+      reached[block] = true;
+      entry[block]   = state;
+      ++updates[block];
+      return true;
+    }
+    bool changed = false;
+    bool widen   = updates[block] >= WIDEN_AFTER;
+    for (std::uint32_t k = 0; k < count; ++k) {
+      auto &old = entry[block][k];
+      Range joined{std::min(old.lo, state[k].lo), std::max(old.hi, state[k].hi)};
+      if (widen && joined.lo < old.lo) {
+        joined.lo = MIN_I32;
+      }
+      if (widen && joined.hi > old.hi) {
+        joined.hi = MAX_I32;
+      }
+      changed = changed || !(joined == old);
+      old = joined;
+    }
+    updates[block] += changed ? 1 : 0;
+    return changed;
+  };
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+      if (!reached[b]) {
+        continue;
+      }
+      auto state = entry[b];
+      for (auto i = blocks[b].begin; i < blocks[b].end; ++i) {
+        transfer(code.quads[i], state);
+      }
+      for (auto succ : blocks[b].succs) {
+        auto out = state;
+        if (refine(b, succ, out)) {
+          changed = merge(succ, out) || changed;
+        }
+      }
+    }
+  }
+}
+
+bool
+ValueRanges::inBounds(std::size_t index) const
+{
+  const auto &quad = code.quads[index];
+  if (slots[quad.arg2] == NONE) {
+    return false;
+  }
+  auto block = live.blockOf(index);
+  if (!reached[block]) {
+    return false;
+  }
+
+  auto state = entry[block];
+  for (auto i = live.block(block).begin; i < index; ++i) {
+    transfer(code.quads[i], state);
+  }
+  auto range = get(state, quad.arg2);
+  return range.lo >= 0 && range.hi < code.value(quad.arg1)->type->size();
+}
+
+} // namespace cg
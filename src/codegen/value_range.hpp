@@ -0,0 +1,78 @@
+/**
+ * @file value_range.hpp
+ * @brief Integer ranges of array indices, for removing bounds checks.
+ *
+ * Only the values an INDEX quad may use as its index are tracked, together
+ * with the values they are computed from by copies, additions, subtractions
+ * and multiplications, and the values they are compared with. Each of them
+ * gets an interval [lo, hi] at the entry of every block, solved forwards
+ * over the blocks; any other definition (a call, a division, a load through
+ * an element alias) makes the interval unbounded.
+ *
+ * Branches narrow the intervals on their outgoing edges: bge a, b leaves a
+ * >= b on the taken edge and a < b on the fall-through edge, and a beqz or
+ * bnez on the result of a comparison in the same block does the same for
+ * its operands. An edge whose condition cannot hold is not followed. A
+ * bound that still grows after a block has been reached twice is widened
+ * to the int32 limit, so loops converge: in
+ *
+ *   i = s - 1; L: t = i + 1; i = t; bge i, n, L_end; ... a[i] ... goto L
+ *
+ * the lower bound of i stays s and the upper bound comes from the exit
+ * test alone, which is what `for i in s..n` produces.
+ *
+ * Namespace: cg
+ */
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "ir_quad.hpp"
+#include "liveness.hpp"
+
+namespace ir { class FuncCode; }
+
+namespace cg {
+
+class ValueRanges {
+public:
+  ValueRanges(const ir::FuncCode &code, const Liveness &live);
+
+public:
+  /**
+   * @brief 第 index 个 INDEX 四元式的下标是否一定在数组范围之内
+   */
+  [[nodiscard]] bool inBounds(std::size_t index) const;
+
+private:
+  // 闭区间 [lo, hi]，用 64 位表示以免计算时溢出
+  struct Range {
+    std::int64_t lo;
+    std::int64_t hi;
+
+    bool operator==(const Range &other) const = default;
+  };
+  using State = std::vector<Range>; // 候选值 -> 区间
+
+  void collect();
+  void solve();
+  void transfer(const ir::IRQuad &quad, State &state) const;
+  bool refine(std::size_t from, std::size_t to, State &state) const;
+  bool assume(ir::IROp op, ir::ValueId lhs, ir::ValueId rhs, State &state) const;
+
+  [[nodiscard]] auto get(const State &state, ir::ValueId value) const -> Range;
+  [[nodiscard]] bool eligible(ir::ValueId value) const;
+
+private:
+  const ir::FuncCode &code;
+  const Liveness     &live;
+
+  std::vector<std::uint32_t> slots; // 值 -> 候选值编号，不参与时为 NONE
+  std::uint32_t              count = 0;
+
+  std::vector<State> entry;   // 块入口各候选值的区间
+  std::vector<bool>  reached; // 块是否可达
+};
+
+} // namespace cg
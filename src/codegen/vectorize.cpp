@@ -0,0 +1,314 @@
+#include <bit>
+#include <vector>
+#include <algorithm>
+
+#include "cfg.hpp"
+#include "fold.hpp"
+#include "asm_dbg.hpp"
+#include "func_code.hpp"
+#include "code_generate.hpp"
+
+namespace cg {
+
+using ir::NONE;
+using ir::IROp;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr int VREG_COUNT = 31; // v1-v31，v0 留给掩码
+
+bool
+isVectorOp(IROp op)
+{
+  return op == IROp::ADD || op == IROp::SUB || op == IROp::MUL || op == IROp::DIV;
+}
+
+/**
+ * @brief 向量运算的指令：两个操作数都是向量时为 .vv，否则为 .vx
+ */
+MOp
+vectorOp(IROp op, bool scalar)
+{
+  switch (op) {
+    case IROp::ADD: return scalar ? MOp::VADD_VX : MOp::VADD_VV;
+    case IROp::SUB: return scalar ? MOp::VSUB_VX : MOp::VSUB_VV;
+    case IROp::MUL: return scalar ? MOp::VMUL_VX : MOp::VMUL_VV;
+    default:        return scalar ? MOp::VDIV_VX : MOp::VDIV_VV;
+  }
+}
+
+} // namespace
+
+/**
+ * @brief 识别可以向量化的 for 循环
+ *
+ * 要求是 for i in s..n 生成的形状：
+ *
+ *   head: label L_start; t = i + 1; i = t; bge i, n, L_end
+ *   body: 只有 INDEX a, i 与 ADD/SUB/MUL/DIV/ASSIGN，没有标号（剖析数据补上的除外）、跳转与调用
+ *   latch: goto L_start; label L_end
+ *
+ * 其中 a 是栈上的 [i32; N]，下标都是 i 且能证明不越界，各次迭代访问不同的
+ * 元素，彼此没有依赖。循环体中定义的值只在本次迭代中使用；其余操作数在循环中
+ * 不变。循环中的值不能有搬移，位置始终相同。
+ */
+auto
+CodeGenerator::matchVectorLoop(std::size_t head) const -> std::optional<VectorLoop>
+{
+  const auto &quads = func->quads;
+  if (!opts.vector || !scan || !ranges || head + 5 >= quads.size()) {
+    return std::nullopt;
+  }
+
+  const auto &inc  = quads[head + 1];
+  const auto &copy = quads[head + 2];
+  const auto &test = quads[head + 3];
+  auto iv = inc.arg1;
+  if (inc.op != IROp::ADD || !func->value(inc.arg2)->isConst() || ir::constValue(*func->value(inc.arg2)) != 1
+    || copy.op != IROp::ASSIGN || copy.arg1 != inc.dst || copy.dst != iv || uses[inc.dst] != 1
+    || test.op != IROp::BGE || test.arg1 != iv || !agg->inRegister(iv) || agg->isAlias(iv))
+  {
+    return std::nullopt;
+  }
+  auto bound = test.arg2;
+  if (!func->value(bound)->isConst() && (!agg->inRegister(bound) || agg->isAlias(bound))) {
+    return std::nullopt;
+  }
+
+  // 循环体开头可能有剖析数据（--profile-use）补上的标号，没有跳转指向它时跳过
+  auto first = head + 4;
+  if (quads[first].op == IROp::LABEL && std::ranges::none_of(quads, [&](const ir::IRQuad &quad) {
+        return (quad.op == IROp::GOTO || ir::isBranch(quad.op)) && quad.label == quads[first].label;
+      }))
+  {
+    ++first;
+  }
+  auto latch = first;
+  while (latch < quads.size() && quads[latch].op != IROp::GOTO && quads[latch].op != IROp::LABEL
+    && quads[latch].op != IROp::CALL && quads[latch].op != IROp::RETURN && !ir::isBranch(quads[latch].op))
+  {
+    ++latch;
+  }
+  if (latch == first || latch + 1 >= quads.size() || quads[latch].op != IROp::GOTO
+    || quads[latch].label != quads[head].label || quads[latch + 1].op != IROp::LABEL
+    || quads[latch + 1].label != test.label)
+  {
+    return std::nullopt;
+  }
+
+  // 位置在循环中保持不变：块内、块之间都没有搬移
+  auto header = live->blockOf(head);
+  auto body   = live->blockOf(first);
+  auto exit   = live->labelBlock(test.label);
+  if (live->blockOf(head + 3) != header || live->blockOf(latch) != body || !scan->edgeMoves(header, body).empty()
+    || !scan->edgeMoves(body, header).empty() || !scan->edgeMoves(header, exit).empty())
+  {
+    return std::nullopt;
+  }
+  for (auto i = head + 1; i <= latch; ++i) {
+    if (!scan->splitMoves(i).empty()) {
+      return std::nullopt;
+    }
+  }
+  auto loc = scan->location(iv, LinearScan::usePos(head + 1));
+  if (!(scan->location(iv, LinearScan::defPos(head + 2)) == loc)
+    || !(scan->location(iv, LinearScan::usePos(head + 3)) == loc))
+  {
+    return std::nullopt;
+  }
+
+  // 循环体中写入的值：各写入一次，且不能是循环变量与上界
+  std::vector<std::uint32_t> writes(func->valueCount(), 0);
+  for (auto i = first; i < latch; ++i) {
+    if (auto dst = live->written(quads[i]); dst != NONE) {
+      ++writes[dst];
+    }
+  }
+  if (writes[iv] != 0 || writes[bound] != 0) {
+    return std::nullopt;
+  }
+
+  std::vector<bool> defined(func->valueCount(), false); // 本次迭代中已经定义的向量值或元素别名
+  auto operand = [&](ValueId value) {
+    if (defined[value]) {
+      return true;
+    }
+    const auto &val = func->value(value);
+    return value != iv && writes[value] == 0
+      && (val->isConst() || (agg->inRegister(value) && !agg->isAlias(value)));
+  };
+
+  int vregs = 0;
+  for (auto i = first; i < latch; ++i) {
+    const auto &quad = quads[i];
+    if (quad.op == IROp::INDEX) {
+      auto type = func->value(quad.arg1)->type;
+      if (quad.arg2 != iv || !agg->inFrame(quad.arg1) || type->kind != type::TypeKind::ARRAY
+        || type->getElemType()->kind != type::TypeKind::I32 || !agg->isAlias(quad.dst) || agg->isFixed(quad.dst)
+        || writes[quad.dst] != 1 || !ranges->inBounds(i))
+      {
+        return std::nullopt;
+      }
+      defined[quad.dst] = true;
+      continue;
+    }
+
+    if (isVectorOp(quad.op)) {
+      if (!operand(quad.arg1) || !operand(quad.arg2)) {
+        return std::nullopt;
+      }
+      vregs += 3;
+    } else if (quad.op == IROp::ASSIGN) {
+      if (!operand(quad.arg1) || (agg->isStore(quad) && !defined[quad.dst])) {
+        return std::nullopt;
+      }
+      vregs += 1;
+      if (agg->isStore(quad)) {
+        continue;
+      }
+    } else {
+      return std::nullopt;
+    }
+    if (!agg->inRegister(quad.dst) || agg->isAlias(quad.dst) || writes[quad.dst] != 1) {
+      return std::nullopt;
+    }
+    defined[quad.dst] = true;
+  }
+  if (vregs > VREG_COUNT) {
+    return std::nullopt;
+  }
+
+  // 循环体中定义的值不能在下一次迭代或循环之后使用
+  for (ValueId value = 0; value < func->valueCount(); ++value) {
+    if (defined[value] && (live->liveIn(header).test(value) || live->liveIn(exit).test(value))) {
+      return std::nullopt;
+    }
+  }
+  return VectorLoop{.head = head, .body = first, .latch = latch, .iv = iv, .bound = bound};
+}
+
+/**
+ * @brief 生成分段（strip-mining）的向量循环，代替 head 之后直到 latch 的四元式
+ *
+ *   i = i + 1
+ * L_vl:
+ *   t6 = n - i; 0 >= t6 时跳到 L_end
+ *   vsetvli t6, t6, e32, m1     # 本段处理 t6 个元素
+ *   ... 元素 a[i..i+t6) 的 vle32.v、运算与 vse32.v ...
+ *   i = i + t6; j L_vl
+ *
+ * 退出时 i = max(s, n)，与标量循环相同。元素地址为 sp + 偏移 + i * 4，
+ * 借用 t5；t6 在整个循环体中保存 vl。
+ */
+void
+CodeGenerator::emitVectorLoop(const VectorLoop &loop)
+{
+  const auto &quads = func->quads;
+  const auto &test  = quads[loop.head + 3];
+  auto vl_label = std::format("{}_vl", func->label(quads[loop.head].label));
+  DBG(mc, "  # vectorized loop");
+
+  index = loop.head + 1;
+  auto cur = useReg(loop.iv, Register::T5);
+  index = loop.head + 2;
+  auto next = defReg(loop.iv);
+  mc.opImm(MOp::ADDI, next, cur, 1);
+  flushDef(loop.iv, next);
+
+  mc.label(vl_label);
+  index = loop.head + 3;
+  auto bound = useReg(loop.bound, Register::T6);
+  cur = useReg(loop.iv, Register::T5);
+  mc.op(MOp::SUB, Register::T6, bound, cur);
+  mc.branch(MOp::BGE, Register::ZERO, Register::T6, func->label(test.label));
+  mc.vsetvli(Register::T6, Register::T6);
+
+  std::vector<std::uint8_t> vreg(func->valueCount(), 0); // 向量值 -> 向量寄存器
+  std::vector<ValueId>      array(func->valueCount(), NONE); // 元素别名 -> 数组
+  std::uint8_t              next_vreg = 1;
+
+  // 元素 array[value][i..] 的地址装入 t5
+  auto address = [&](ValueId alias) {
+    auto base = addressOf(array[alias], Register::T5);
+    auto idx  = useReg(loop.iv, Register::T5);
+    mc.opImm(MOp::SLLI, Register::T5, idx, std::countr_zero(static_cast<unsigned>(Aggregates::WORD)));
+    mc.op(MOp::ADD, Register::T5, base.base, Register::T5);
+    if (base.offset != 0) {
+      mc.opImm(MOp::ADDI, Register::T5, Register::T5, base.offset);
+    }
+  };
+  auto scalar = [&](ValueId value) {
+    const auto &val = func->value(value);
+    return val->isConst() && ir::constValue(*val) == 0 ? Register::ZERO : useReg(value, Register::T5);
+  };
+  // 读出向量值：元素别名从内存装入，不变量扩展到每个元素
+  auto vector = [&](ValueId value) -> std::uint8_t {
+    if (array[value] != NONE) {
+      address(value);
+      mc.vload(next_vreg, Register::T5);
+      return next_vreg++;
+    }
+    if (vreg[value] != 0) {
+      return vreg[value];
+    }
+    mc.vsplat(next_vreg, scalar(value));
+    return next_vreg++;
+  };
+  auto isVector = [&](ValueId value) { return array[value] != NONE || vreg[value] != 0; };
+
+  for (index = loop.body; index < loop.latch; ++index) {
+    const auto &quad = quads[index];
+    DBG(mc, "  # {}", func->str(quad));
+    if (quad.op == IROp::INDEX) {
+      array[quad.dst] = quad.arg1;
+      continue;
+    }
+
+    if (quad.op == IROp::ASSIGN) {
+      auto src = vector(quad.arg1);
+      if (agg->isStore(quad)) {
+        address(quad.dst);
+        mc.vstore(src, Register::T5);
+      } else {
+        vreg[quad.dst] = src;
+      }
+      continue;
+    }
+
+    // 先装入向量操作数，标量操作数最后装入 t5，避免被元素地址覆盖
+    bool lhs_vec = isVector(quad.arg1);
+    bool rhs_vec = isVector(quad.arg2);
+    auto dst     = next_vreg++;
+    if (lhs_vec && rhs_vec) {
+      auto lhs = vector(quad.arg1);
+      auto rhs = vector(quad.arg2);
+      mc.vop(vectorOp(quad.op, false), dst, lhs, rhs);
+    } else if (rhs_vec && quad.op == IROp::DIV) {
+      auto rhs = vector(quad.arg2);
+      auto lhs = vector(quad.arg1);
+      mc.vop(MOp::VDIV_VV, dst, lhs, rhs);
+    } else if (rhs_vec) {
+      // 常量在左：加法、乘法交换操作数，减法用 vrsub
+      auto rhs = vector(quad.arg2);
+      auto op  = quad.op == IROp::SUB ? MOp::VRSUB_VX : vectorOp(quad.op, true);
+      mc.vopScalar(op, dst, rhs, scalar(quad.arg1));
+    } else {
+      auto lhs = vector(quad.arg1);
+      mc.vopScalar(vectorOp(quad.op, true), dst, lhs, scalar(quad.arg2));
+    }
+    vreg[quad.dst] = dst;
+  }
+
+  index = loop.head + 3;
+  cur = useReg(loop.iv, Register::T5);
+  index = loop.head + 2;
+  next = defReg(loop.iv);
+  mc.op(MOp::ADD, next, cur, Register::T6);
+  flushDef(loop.iv, next);
+  mc.jump(MOp::J, vl_label);
+
+  index = loop.latch;
+}
+
+} // namespace cg
@@ -0,0 +1,105 @@
+#include <print>
+#include <optional>
+#include <filesystem>
+
+#include "panic.hpp"
+#include "timer.hpp"
+#include "batch.hpp"
+#include "parallel.hpp"
+#include "compiler.hpp"
+
+namespace cpr {
+
+/**
+ * @brief  批量编译时一个输入文件的输出文件名（不带后缀）
+ * @param  input  输入文件名
+ * @param  outdir 输出目录，为空时输出到输入文件所在的目录
+ * @return 如 a/b.rs -> a/b，或 outdir/b
+ */
+std::string
+batchOutput(const std::string &input, const std::string &outdir)
+{
+  std::filesystem::path path{input};
+  if (outdir.empty()) {
+    return path.replace_extension().string();
+  }
+  return (std::filesystem::path{outdir} / path.stem()).string();
+}
+
+/**
+ * @brief   并发编译多个文件，每个文件使用独立的 Compiler 实例
+ * @details 只有一个文件时，线程用于并行检查该文件中的各个函数
+ * @param   jobs    待编译的文件，完成后填入耗时与是否出错
+ * @param   opts    各文件的编译选项（opts.jobs 被忽略）
+ * @param   threads 线程数
+ */
+void
+compileBatch(std::vector<BatchJob> &jobs, const CompileOptions &opts, unsigned threads)
+{
+  auto per_file = opts;
+  per_file.jobs = jobs.size() == 1 ? threads : 1;
+
+  util::parallelFor(jobs.size(), threads, [&](std::size_t i) {
+    auto &job = jobs[i];
+
+    util::Timer timer;
+    timer.start();
+    {
+      // 只有一个文件时保持原来的行为：致命错误直接终止进程
+      std::optional<util::RecoverScope> recover;
+      if (jobs.size() > 1) {
+        recover.emplace();
+      }
+
+      try {
+        Compiler compiler{job.input, per_file};
+        if (opts.flag_ir || opts.flag_ir_bin) {
+          compiler.generateIR(job.output, opts.flag_ir);
+        }
+        if (opts.flag_asm) {
+          compiler.generateAssemble(job.output);
+        }
+        if (opts.flag_obj) {
+          compiler.generateObject(job.output);
+        }
+        if (opts.flag_run) {
+          job.status = compiler.run(job.output);
+        }
+        job.failed = compiler.hasErrs();
+      } catch (const util::FatalAbort &) {
+        job.failed  = true;
+        job.aborted = true;
+      }
+    }
+    timer.stop();
+
+    job.seconds = timer.seconds();
+  });
+}
+
+/**
+ * @brief 打印批量编译中每个文件的耗时
+ * @param jobs 已完成的编译任务
+ * @param wall 批量编译的总耗时（墙上时间）
+ */
+void
+printBatchSummary(const std::vector<BatchJob> &jobs, double wall)
+{
+  double total = 0.0;
+  std::size_t failed = 0;
+  for (const auto &job : jobs) {
+    total  += job.seconds;
+    failed += job.failed ? 1 : 0;
+  }
+
+  std::println("Summary: {} files, {} failed, {:.3f} s in total, {:.3f} s wall",
+    jobs.size(), failed, total, wall
+  );
+  for (const auto &job : jobs) {
+    std::println("  {:>9.3f} ms  {:<6}  {}",
+      job.seconds * 1e3, job.aborted ? "abort" : job.failed ? "failed" : "ok", job.input
+    );
+  }
+}
+
+} // namespace cpr
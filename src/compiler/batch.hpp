@@ -0,0 +1,37 @@
+/**
+ * @file batch.hpp
+ * @brief Compiles many input files in one process.
+ *
+ * Every input is compiled by its own cpr::Compiler instance, so the jobs share
+ * no state and run concurrently on the work-stealing pool of util::parallelFor.
+ * Diagnostics of one file are printed as one block (see ErrReporter::displayErrs),
+ * and a fatal error in one file only aborts that file (see util::RecoverScope).
+ *
+ * Namespace: cpr
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "compiler.hpp"
+
+namespace cpr {
+
+// 批量编译中的一个输入文件
+struct BatchJob {
+  std::string input;  // 输入文件名
+  std::string output; // 输出文件名（不带后缀）
+
+  double seconds = 0.0;   // 编译耗时
+  bool   failed  = false; // 是否发现了错误
+  bool   aborted = false; // 是否因致命错误而中止
+  int    status  = 0;     // --run 时程序的退出状态
+};
+
+auto batchOutput(const std::string &input, const std::string &outdir) -> std::string;
+
+void compileBatch(std::vector<BatchJob> &jobs, const CompileOptions &opts, unsigned threads);
+void printBatchSummary(const std::vector<BatchJob> &jobs, double wall);
+
+} // namespace cpr
@@ -0,0 +1,68 @@
+#include <string_view>
+#include <unordered_map>
+
+#include "ast.hpp"
+#include "call_graph.hpp"
+#include "token_stream.hpp"
+
+namespace cpr {
+
+/**
+ * @brief  从 main、main0 与导出的函数出发，沿调用图求出可达的函数
+ * @param  prog    已完整解析的程序
+ * @param  tokens  程序的 token stream
+ * @param  exports 额外的根（-fexport）
+ * @return 与 prog.decls 一一对应的标记；程序中没有任何根时全部为 true
+ */
+std::vector<bool>
+reachableFuncs(const ast::Prog &prog, const lex::TokenStream &tokens, std::span<const std::string> exports)
+{
+  auto n = prog.decls.size();
+  std::unordered_map<std::string_view, std::vector<std::size_t>> index; // 函数名 -> 同名的各函数
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto &name = static_cast<ast::FuncDeclPtr>(prog.decls[i])->header->name;
+    if (!name.valid()) {
+      return std::vector<bool>(n, true);
+    }
+    index[name.text].push_back(i);
+  }
+
+  std::vector<bool>        live(n, false);
+  std::vector<std::size_t> worklist;
+  auto reach = [&](std::string_view name) {
+    auto it = index.find(name);
+    if (it == index.end()) {
+      return;
+    }
+    for (auto func : it->second) {
+      if (!live[func]) {
+        live[func] = true;
+        worklist.push_back(func);
+      }
+    }
+  };
+
+  reach("main");
+  reach("main0");
+  for (const auto &name : exports) {
+    reach(name);
+  }
+  if (worklist.empty()) {
+    return std::vector<bool>(n, true);
+  }
+
+  while (!worklist.empty()) {
+    const auto &fdecl = *static_cast<ast::FuncDeclPtr>(prog.decls[worklist.back()]);
+    worklist.pop_back();
+
+    // <ID> ( 即函数调用，从函数体开始扫描，跳过函数头中的函数名本身
+    for (std::size_t t = fdecl.tok_body; t + 1 < fdecl.tok_end; ++t) {
+      if (tokens.type(t) == lex::TokenType::ID && tokens.type(t + 1) == lex::TokenType::LPAREN) {
+        reach(tokens.name(t).text);
+      }
+    }
+  }
+  return live;
+}
+
+} // namespace cpr
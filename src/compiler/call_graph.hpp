@@ -0,0 +1,35 @@
+/**
+ * @file call_graph.hpp
+ * @brief Whole-program reachability over the call graph of a parsed program.
+ *
+ * With -fprune-funcs=on the driver parses the whole file first, then keeps
+ * only the functions reachable from the roots: main, main0 (the entry when
+ * linked with riscv-asm/main.c) and every name given with -fexport. The
+ * other functions are declared, so their headers are still checked, but
+ * their bodies are never checked, lowered, optimized or compiled, and they
+ * are missing from the IR, the assembly and the object file.
+ *
+ * The call graph is read off the token stream like the callees of the
+ * incremental compilation cache: every <ID> ( inside a function is an edge
+ * to the functions of that name. Functions are not values in the language,
+ * so this over-approximates the calls the semantic checker would accept and
+ * never drops a function a kept one can call. A program without any root
+ * (a file of helpers) is kept whole.
+ *
+ * Namespace: cpr
+ */
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ast { struct Prog; }
+namespace lex { class TokenStream; }
+
+namespace cpr {
+
+auto reachableFuncs(const ast::Prog &prog, const lex::TokenStream &tokens, std::span<const std::string> exports)
+  -> std::vector<bool>;
+
+} // namespace cpr
@@ -1,96 +1,355 @@
 #include <print>
 #include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
 #include <sstream>
-#include <filesystem>
 
 #include "panic.hpp"
-#include "preproc.hpp"
 #include "ir_quad.hpp"
+#include "func_code.hpp"
 #include "compiler.hpp"
+#include "call_graph.hpp"
+#include "ir_binary.hpp"
+#include "cfg_dump.hpp"
+#include "out_buffer.hpp"
+#include "parallel_lowering.hpp"
 #include "code_generate.hpp"
+#include "interpreter.hpp"
 
 namespace cpr {
 
-Compiler::Compiler(const std::string &file)
+namespace {
+
+/**
+ * @brief  打开输出文件 <base>.<suffix>；base 为 "-" 时输出到标准输出
+ * @param  file 打开的文件（输出到标准输出时不使用）
+ * @return 输出流
+ */
+std::ostream &
+openOutput(const std::string &base, std::string_view suffix, std::ofstream &file)
 {
-  // 读取输入文件
-  std::ifstream in;
-  in.open(file);
-  if (!in) {
-    UNREACHABLE("无法打开输入文件");
+  if (base == "-") {
+    return std::cout;
   }
+  file.open(std::format("{}.{}", base, suffix), std::ios::binary);
+  if (!file) {
+    UNREACHABLE(std::format("无法打开输出文件（.{}）", suffix));
+  }
+  return file;
+}
 
-  std::ostringstream oss;
-  oss << in.rdbuf();
+/**
+ * @brief 把程序中各函数的四元式数与值（变量与临时变量）的个数计入 report
+ * @param when 计数器名的后缀，区分优化前后
+ */
+void
+countIR(util::TimeReport *report, const ast::Prog &prog, std::string_view when)
+{
+  if (report == nullptr) {
+    return;
+  }
+  std::size_t quads  = 0;
+  std::size_t values = 0;
+  for (const auto &decl : prog.decls) {
+    if (const auto &code = static_cast<ast::FuncDeclPtr>(decl)->code; code) {
+      quads  += code->quads.size();
+      values += code->valueCount();
+    }
+  }
+  report->count(std::format("IR quads ({})", when), quads);
+  report->count(std::format("IR values ({})", when), values);
+}
 
-  // 初始化错误报告器
-  reporter = std::make_unique<err::ErrReporter>(oss.str()); // 保留原始文本信息
+/**
+ * @brief 按 live 删去 items 中对应不可达函数的元素（items 为空时不变）
+ */
+template<typename T>
+void
+keepLive(std::vector<T> &items, const std::vector<bool> &live)
+{
+  if (items.empty()) {
+    return;
+  }
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    if (!live[i]) {
+      continue;
+    }
+    if (kept != i) {
+      items[kept] = std::move(items[i]);
+    }
+    ++kept;
+  }
+  items.resize(kept);
+}
 
-  // 删除注释
-  std::istringstream iss{preproc::removeAnnotations(oss.str())};
+} // namespace
 
-  std::string line{};
-  std::vector<std::string> text{};
-  while (std::getline(iss, line)) {
-    text.push_back(std::move(line)); // 逐行读取待分析代码
+/**
+ * @param file      输入文件名
+ * @param opts      编译选项
+ * @param workspace 复用的类型缓存与 arena（为空时各自新建）
+ */
+Compiler::Compiler(const std::string &file, const CompileOptions &opts, Workspace *workspace)
+  : opts(opts)
+{
+  // 缓存的是各函数的汇编文本，目标文件需要重新生成所有函数的机器指令；
+  // 剖析数据与插桩改变的输出不在缓存键中；二进制 IR 与解释执行需要所有函数的 IR
+  if (opts.flag_obj || opts.flag_ir_bin || opts.from_ir_bin || opts.flag_run || opts.profile_gen ||
+      opts.profile != nullptr) {
+    this->opts.cache = nullptr;
   }
 
-  if (!iss.eof()) {
-    UNREACHABLE("编译器初始化时，文件读取错误");
-  }
+  // 映射输入文件，后续各组件共享这一块只读内存
+  source = std::make_unique<util::SourceBuffer>(file);
+
+  // 初始化错误报告器
+  reporter = std::make_unique<err::ErrReporter>(*source, opts.report); // 保留原始文本信息
 
   // 初始化各组件
-  this->lexer   = std::make_unique<lex::Lexer>(text, *reporter);
-  this->symtab  = std::make_unique<sym::SymbolTable>();
-  this->builder = std::make_unique<par::SemanticIRBuilder>(*symtab, *reporter);
-  this->parser  = std::make_unique<par::Parser>(*lexer, *builder, *reporter);
+  this->interner = std::make_unique<util::Interner>();
+  this->symtab  = std::make_unique<sym::SymbolTable>(*interner);
+  if (opts.from_ir_bin) {
+    loadIR(file, workspace);
+    return;
+  }
+  this->lexer   = std::make_unique<lex::Lexer>(*source, *interner, *reporter);
+  this->builder = workspace == nullptr
+    ? std::make_unique<par::SemanticIRBuilder>(*symtab, *reporter)
+    : std::make_unique<par::SemanticIRBuilder>(*symtab, *reporter, workspace->types);
+  builder->setDeferred(this->opts.jobs > 1 || this->opts.cache != nullptr || this->opts.prune_funcs);
+  builder->setReport(opts.time_report);
+  opt::buildPipeline(passes, opts.optim);
+  passes.setReport(opts.time_report);
+
+  // 先一次性完成词法分析，parser 在 token stream 上任意向前看
+  {
+    util::TimeScope phase{opts.time_report, "lex"};
+    this->tokens  = std::make_unique<lex::TokenStream>(lexer->tokenize());
+  }
+  if (opts.time_report != nullptr) {
+    opts.time_report->count("tokens", tokens->size());
+  }
+  if (workspace == nullptr) {
+    this->own_arena = std::make_unique<util::Arena>();
+    this->arena     = own_arena.get();
+  } else {
+    this->arena = &workspace->arena;
+  }
+  this->parser  = std::make_unique<par::Parser>(*tokens, *arena, *builder, *reporter);
+  parser->setMaxNesting(opts.max_nesting);
 }
 
 /**
- * @brief 生成中间代码
- * @param file 输出文件名（不带后缀）
+ * @brief 读入二进制 IR（--from-ir-bin），每个函数放在一个只有 IR 的 FuncDecl 中
+ * @param file 输入文件名
  */
 void
-Compiler::generateIR(const std::string &file, bool print)
+Compiler::loadIR(const std::string &file, Workspace *workspace)
 {
-  // 准备输出文件流
-  std::string base = file.empty() ? "output" : file;
-  std::string filename = std::format("{}.ir", base);
-  std::ofstream out;
-  out.open(filename);
-  if (!out) {
-    UNREACHABLE("无法打开输出文件（.ir）");
+  util::TimeScope phase{opts.time_report, "load IR binary"};
+  types = workspace == nullptr ? std::make_shared<type::TypeFactory>() : workspace->types;
+  auto funcs = ir::readBinary(source->text(), *types, *symtab);
+  CHECK(funcs.has_value(), std::format("{} 不是版本 {} 的二进制 IR 或已损坏", file, ir::IRB_VERSION));
+
+  if (workspace == nullptr) {
+    this->own_arena = std::make_unique<util::Arena>();
+    this->arena     = own_arena.get();
+  } else {
+    this->arena = &workspace->arena;
+  }
+  std::vector<ast::DeclPtr> decls;
+  for (auto &code : funcs.value()) {
+    auto *decl = arena->make<ast::FuncDecl>(nullptr, nullptr);
+    decl->code = std::move(code);
+    decls.push_back(decl);
+  }
+  ast_root = arena->make<ast::Prog>(std::move(decls));
+}
+
+/**
+ * @brief  词法分析之后的前端与优化：解析、语义检查、生成 IR 并执行各 pass
+ * @param  base 输出文件名（不带后缀），调试构建在 <base>.symbol.txt 中输出符号表
+ * @return 是否没有错误
+ */
+bool
+Compiler::buildIR(const std::string &base)
+{
+  auto *report = opts.time_report;
+
+  // 一遍扫描、语法制导地生成中间代码；多线程时先完整解析，再并行检查各函数
+  {
+    util::TimeScope phase{report, "parse"};
+    ast_root = parser->parseProgram();
+  }
+  if (report != nullptr) {
+    report->count("AST bytes", arena->bytesUsed());
+  }
+  // 剪枝时不可达的函数只声明函数头，函数体不检查也不生成 IR，检查之后从程序中删去
+  std::vector<bool> live; // 各函数是否可达，为空时不剪枝
+  if (opts.prune_funcs) {
+    util::TimeScope phase{report, "call graph"};
+    live = reachableFuncs(*ast_root, *tokens, opts.exports);
   }
 
-  // 一遍扫描、语法制导地生成中间代码
-  ast_root = parser->parseProgram();
+  auto *cache = opts.cache;
+  std::vector<bool> skipped; // 不需要生成 IR 的函数
+  if (cache != nullptr) {
+    std::vector<std::vector<std::size_t>> callees;
+    auto pipeline = std::format("{}-{}", opts.optim.key(), opts.codegen.key());
+    cache_keys = FuncCache::funcKeys(*ast_root, *tokens, pipeline, opts.optim.usesCallees(), &callees);
+    cached.assign(ast_root->decls.size(), false);
+    entries.resize(ast_root->decls.size());
+    for (std::size_t i = 0; i < cache_keys.size(); ++i) {
+      if (!live.empty() && !live[i]) {
+        continue;
+      }
+      if (auto entry = cache->lookup(cache_keys[i], opts.flag_ir, opts.flag_asm); entry.has_value()) {
+        cached[i]  = true;
+        entries[i] = std::move(entry.value());
+      }
+    }
+
+    // 重新编译的函数可能内联或在编译期求值它调用的函数，这些函数（及其调用的函数）即使命中
+    // 也要生成 IR，否则优化的结果取决于缓存中有什么；被调用者总在调用者之前
+    skipped = cached;
+    if (opts.optim.usesCallees() && !cache_keys.empty()) {
+      for (std::size_t i = skipped.size(); i-- > 0;) {
+        if (skipped[i]) {
+          continue;
+        }
+        for (auto callee : callees[i]) {
+          skipped[callee] = false;
+        }
+      }
+    }
+  }
+  if (!live.empty()) {
+    skipped.resize(live.size(), false);
+    for (std::size_t i = 0; i < live.size(); ++i) {
+      skipped[i] = skipped[i] || !live[i];
+    }
+  }
+  if (opts.jobs > 1 || cache != nullptr || opts.prune_funcs) {
+    util::TimeScope phase{report, "semantic + IR"};
+    par::lowerParallel(*ast_root, *builder, *symtab, *reporter, *source, opts.jobs,
+      skipped.empty() ? nullptr : &skipped
+    );
+  }
+  if (cache != nullptr) {
+    auto hit   = static_cast<std::size_t>(std::ranges::count(cached, true));
+    auto total = live.empty() ? cached.size() : static_cast<std::size_t>(std::ranges::count(live, true));
+    cache->count(hit, total - hit);
+  }
 
 #ifdef DEBUG
-  std::ofstream out_sym;
-  out_sym.open("symbol.txt");
-  if (!out_sym) {
-    UNREACHABLE("无法打开输出文件（symbol.txt）");
+  // 与输出文件放在一起：批量编译与 server 模式下各输入的符号表互不覆盖
+  if (base != "-") {
+    std::ofstream out_sym{std::format("{}.symbol.txt", base)};
+    if (!out_sym) {
+      UNREACHABLE("无法打开输出文件（.symbol.txt）");
+    }
+    symtab->dump(out_sym);
   }
-  symtab->dump(out_sym);
 #endif
 
   // 如果扫描过程中发现了错误，则打印错误并退出
   if (reporter->hasErrs()) {
     reporter->displayErrs();
-    std::filesystem::remove(filename);
+    return false;
+  }
+
+  if (!live.empty()) {
+    if (report != nullptr) {
+      report->count("functions pruned", static_cast<std::size_t>(std::ranges::count(live, false)));
+    }
+    keepLive(ast_root->decls, live);
+    keepLive(cache_keys, live);
+    keepLive(cached, live);
+    keepLive(entries, live);
+  }
+
+  // 剖析数据按刚生成的 IR 中的基本块对应，在所有 pass 之前附加或插桩
+  if (opts.profile != nullptr) {
+    util::TimeScope phase{report, "profile"};
+    opt::annotate(*ast_root, *opts.profile);
+  }
+  if (opts.profile_gen) {
+    util::TimeScope phase{report, "profile"};
+    probes = opt::instrument(*ast_root);
+  }
+  countIR(report, *ast_root, "generated");
+  {
+    util::TimeScope phase{report, "optimize"};
+    passes.run(*ast_root, opts.jobs);
+  }
+  countIR(report, *ast_root, "optimized");
+  return true;
+}
+
+/**
+ * @brief 生成中间代码
+ * @param file  输出文件名（不带后缀）
+ * @param print 是否输出文本形式的 IR
+ */
+void
+Compiler::generateIR(const std::string &file, bool print)
+{
+  auto *report = opts.time_report;
+  std::string base = file.empty() ? "output" : file;
+  if (ast_root == nullptr && !buildIR(base)) {
     return;
   }
 
-  if (print) {
-    // pretty print
-    for (const auto &code : ast_root->ircode) {
-      std::string idxstr =
-        (code->op == ir::IROp::LABEL || code ->op == ir::IROp::FUNC)
-        ? "" : "  ";
-      std::println(out, "{}{}", idxstr, code->str());
+  if (opts.dump_cfg) {
+    std::ofstream out_cfg{std::format("{}.cfg.dot", base)};
+    if (!out_cfg) {
+      UNREACHABLE("无法打开输出文件（.cfg.dot）");
     }
-  } else {
-    std::filesystem::remove(filename);
+    opt::dumpCFG(out_cfg, *ast_root);
+  }
+
+  if (opts.flag_ir_bin) {
+    util::TimeScope phase{report, "write IR binary"};
+    std::vector<const ir::FuncCode *> funcs;
+    for (const auto &decl : ast_root->decls) {
+      funcs.push_back(static_cast<ast::FuncDeclPtr>(decl)->code.get());
+    }
+    std::ofstream file_out;
+    auto &out = openOutput(base, "irb", file_out);
+    ir::writeBinary(out, funcs, *symtab);
+    out.flush();
+  }
+
+  if (!print) {
+    return;
+  }
+
+  // pretty print：逐函数格式化到缓冲区，每个函数完成后写出
+  util::TimeScope phase{report, "print IR"};
+  std::ofstream file_out;
+  util::OutBuffer out{openOutput(base, "ir", file_out)};
+  for (std::size_t i = 0; i < ast_root->decls.size(); ++i) {
+    if (opts.cache != nullptr && cached[i]) {
+      out.append(entries[i].ir);
+      out.flush();
+      continue;
+    }
+
+    const auto &func = static_cast<ast::FuncDeclPtr>(ast_root->decls[i])->code;
+    auto &text = out.text();
+    for (const auto &code : func->quads) {
+      if (code.op != ir::IROp::LABEL && code.op != ir::IROp::FUNC) {
+        text += "  ";
+      }
+      func->print(text, code);
+      text += '\n';
+    }
+    if (!cache_keys.empty()) {
+      opts.cache->storeIR(cache_keys[i], std::string{out.view()});
+    }
+    out.flush();
   }
 }
 
@@ -99,19 +358,131 @@ Compiler::generateAssemble(const std::string &file)
 {
   // 准备输出文件流
   std::string base = file.empty() ? "output" : file;
-  std::string filename = std::format("{}.s", base);
-  std::ofstream out;
-  out.open(filename);
-  if (!out) {
-    UNREACHABLE("无法打开输出文件（.s）");
+  std::ofstream file_out;
+  auto &out = openOutput(base, "s", file_out);
+
+  if (ast_root == nullptr) {
+    generateIR(file, false);
+  }
+
+  util::TimeScope phase{opts.time_report, "codegen"};
+  if (cache_keys.empty()) {
+    cg::CodeGenerator codegen{out, *symtab, opts.codegen};
+    codegen.setReport(opts.time_report);
+    codegen.generate(*ast_root, opts.jobs);
+    if (opts.profile_gen) {
+      opt::emitCounters(out, probes);
+    }
+    out.flush();
+    return;
   }
 
+  // 使用缓存时只生成未命中的函数，再按声明顺序与缓存中的汇编拼接
+  cg::CodeGenerator codegen{out, *symtab, opts.codegen};
+  codegen.setReport(opts.time_report);
+  codegen.generateHeader();
+  std::vector<std::size_t>          missed;
+  std::vector<const ir::FuncCode *> funcs;
+  for (std::size_t i = 0; i < ast_root->decls.size(); ++i) {
+    const auto &funccode = static_cast<ast::FuncDeclPtr>(ast_root->decls[i])->code;
+    if (!cached[i] && funccode) {
+      missed.push_back(i);
+      funcs.push_back(funccode.get());
+    }
+  }
+  auto texts = codegen.generateFuncs(funcs, opts.jobs);
+
+  auto next = missed.begin();
+  for (std::size_t i = 0; i < ast_root->decls.size(); ++i) {
+    if (cached[i]) {
+      out << entries[i].assembly;
+    } else if (next != missed.end() && *next == i) {
+      const auto &text = texts[next++ - missed.begin()];
+      out << text;
+      opts.cache->storeAsm(cache_keys[i], text);
+    }
+  }
+  out.flush();
+}
+
+/**
+ * @brief 直接生成 RISC-V 的 ELF 可重定位目标文件，不经过汇编器
+ * @param file 输出文件名（不带后缀）
+ */
+void
+Compiler::generateObject(const std::string &file)
+{
+  std::string base = file.empty() ? "output" : file;
+  std::ofstream file_out;
+  auto &out = openOutput(base, "o", file_out);
+
   if (ast_root == nullptr) {
     generateIR(file, false);
   }
 
-  cg::CodeGenerator codegen{out, *symtab};
-  codegen.generate(*ast_root);
+  std::ostringstream header; // 汇编的段声明，目标文件中不需要
+  cg::ElfWriter writer{opts.codegen.compress};
+  {
+    util::TimeScope phase{opts.time_report, "codegen"};
+    cg::CodeGenerator codegen{header, *symtab, opts.codegen, &writer};
+    codegen.setReport(opts.time_report);
+    codegen.generate(*ast_root, opts.jobs);
+  }
+  util::TimeScope phase{opts.time_report, "write object"};
+  writer.write(out);
+  out.flush();
+}
+
+/**
+ * @brief   用 IR 解释器运行程序，不生成代码
+ * @details 入口是 main0（与 riscv-asm/main.c 链接时的入口），没有时是 main；
+ *          main0 的返回值按 main.c 的格式输出
+ * @param   file 输出文件名（不带后缀），只用于 --dump-cfg 与 --emit-ir-bin
+ * @return  进程的退出状态：main0 的返回值；编译错误为 1；运行时错误为 133（同 ebreak 的 SIGTRAP）
+ */
+int
+Compiler::run(const std::string &file)
+{
+  if (ast_root == nullptr) {
+    generateIR(file, false);
+  }
+  if (ast_root == nullptr || reporter->hasErrs()) {
+    return 1;
+  }
+
+  std::vector<const ir::FuncCode *> funcs;
+  for (const auto &decl : ast_root->decls) {
+    if (const auto &code = static_cast<ast::FuncDeclPtr>(decl)->code; code) {
+      funcs.push_back(code.get());
+    }
+  }
+
+  util::TimeScope phase{opts.time_report, "run"};
+  interp::Interpreter interpreter{funcs};
+  std::string_view entry = interpreter.find("main0") != nullptr ? "main0" : "main";
+  const auto *func = interpreter.find(entry);
+  if (func == nullptr) {
+    std::println(stderr, "没有可以运行的入口函数（main0 或 main）");
+    return 1;
+  }
+  if (!func->params.empty()) {
+    std::println(stderr, "入口函数 {} 不能有参数", entry);
+    return 1;
+  }
+
+  auto outcome = interpreter.call(entry, {});
+  if (opts.time_report != nullptr) {
+    opts.time_report->count("bytecode instructions", interpreter.decodedInsts());
+  }
+  if (!outcome.ok()) {
+    std::println(stderr, "运行时错误: {}（{}）", interp::statusStr(outcome.status), outcome.where);
+    return 133;
+  }
+  if (entry == "main0") {
+    std::println("return value = {}", outcome.value);
+    return outcome.value;
+  }
+  return 0;
 }
 
 } // namespace cpr
@@ -1,9 +1,19 @@
 #pragma once
 
+#include "arena.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "func_cache.hpp"
+#include "pipeline.hpp"
+#include "profile.hpp"
+#include "pass_manager.hpp"
 #include "err_report.hpp"
+#include "interner.hpp"
+#include "type_factory.hpp"
 #include "symbol_table.hpp"
+#include "time_report.hpp"
+#include "source_buffer.hpp"
+#include "code_generate.hpp"
 #include "semantic_ir_builder.hpp"
 
 namespace cpr {
@@ -14,19 +24,80 @@ constexpr std::uint8_t F_LR     = 2; // 使用 LR 分析法构建的语法分析
 constexpr std::uint8_t B_X86_84 = 1; // 生成 x86_64 汇编代码
 constexpr std::uint8_t B_RISC_V = 2; // 生成 risc-v 汇编代码
 
+// 可以在多次编译之间复用的资源（server 模式下常驻）
+struct Workspace {
+  std::shared_ptr<type::TypeFactory> types = std::make_shared<type::TypeFactory>(); // 复合类型缓存
+  util::Arena                        arena; // AST 结点所在的 arena，每次编译结束后 reset
+};
+
+// 一个文件的编译选项
+struct CompileOptions {
+  bool flag_ir     = false; // 是否输出 IR（决定缓存命中需要哪些内容）
+  bool flag_asm    = false; // 是否输出汇编
+  bool flag_obj    = false; // 是否直接输出目标文件（不使用缓存）
+  bool flag_ir_bin = false; // 是否输出二进制 IR（.irb，不使用缓存）
+  bool from_ir_bin = false; // 输入文件是否是二进制 IR：跳过前端与优化，只输出 IR 或生成代码
+  bool flag_run    = false; // 是否用 IR 解释器直接运行程序（--run，不使用缓存）
+
+  unsigned           jobs     = 1;       // 语义检查、IR 生成与代码生成的线程数，大于 1 时先完整解析再并行处理各函数
+  err::ReportConfig  report;             // 诊断信息的输出格式与错误数上限
+  std::size_t        max_nesting = par::MAX_NESTING; // 表达式嵌套深度的上限（-fmax-nesting），0 表示不限制
+  bool               prune_funcs = false; // 是否只保留从 main、main0 与 exports 可达的函数（-fprune-funcs），同 jobs > 1 先完整解析
+  std::vector<std::string> exports;       // 剪枝时额外的根（-fexport）
+  FuncCache         *cache    = nullptr; // 增量编译缓存，为空时不使用；使用时同 jobs > 1 先完整解析
+  bool               dump_cfg = false;   // 是否输出各函数的控制流图（.cfg.dot）
+  opt::OptOptions    optim;              // 优化级别
+  cg::CodeGenOptions codegen;            // 代码生成选项（寄存器分配算法、目标处理器）
+
+  bool                profile_gen = false;   // 是否插桩统计各基本块的执行次数（--profile-generate）
+  const opt::Profile *profile     = nullptr; // 剖析数据（--profile-use），为空时不使用
+
+  util::TimeReport *time_report = nullptr; // 各阶段的计时、计数与内存分配统计（--time-report），为空时不统计
+};
+
 // 编译器类，维护编译器模块的调用逻辑
 class Compiler {
 public:
-  Compiler(const std::string &file);
+  Compiler(const std::string &file, const CompileOptions &opts = {}, Workspace *workspace = nullptr);
 
 public:
   void generateIR(const std::string &file, bool print = true);
   void generateAssemble(const std::string &file);
+  void generateObject(const std::string &file);
+  int  run(const std::string &file);
+
+  /**
+   * @brief 编译过程中是否发现了错误
+   */
+  [[nodiscard]] bool hasErrs() const {
+    return reporter->hasErrs();
+  }
+
+private:
+  bool buildIR(const std::string &base);
+  void loadIR(const std::string &file, Workspace *workspace);
 
 private:
+  std::unique_ptr<util::Arena> own_arena; // 没有 workspace 时使用，随 Compiler 一起释放
+  util::Arena *arena = nullptr;           // AST 结点所在的 arena
   ast::ProgPtr ast_root = nullptr;
 
+  CompileOptions    opts;   // 编译选项
+  opt::PassManager  passes; // IR 上的优化 pass
+
+  // 增量编译缓存（opts.cache 为空时不使用）
+  std::vector<std::uint64_t> cache_keys; // 各函数的缓存键，为空时本次编译不使用缓存
+  std::vector<bool>          cached;     // 各函数的输出是否取自缓存
+  std::vector<CachedFunc>    entries;    // 命中的函数的缓存内容
+
+  std::vector<opt::ProbedFunc> probes; // 插桩时各函数的计数器
+
+  std::shared_ptr<type::TypeFactory> types; // 读入二进制 IR 时复合类型所在的工厂
+
+  std::unique_ptr<util::SourceBuffer>     source;   // 原始输入文本
+  std::unique_ptr<util::Interner>         interner; // identifier pool
   std::unique_ptr<lex::Lexer>             lexer;    // lexer
+  std::unique_ptr<lex::TokenStream>       tokens;   // token stream
   std::unique_ptr<par::Parser>            parser;   // parser
   std::unique_ptr<sym::SymbolTable>       symtab;   // symbol table
   std::unique_ptr<par::SemanticIRBuilder> builder;  // semantic ir builder
@@ -0,0 +1,238 @@
+#include <unistd.h>
+
+#include <print>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "ast.hpp"
+#include "func_cache.hpp"
+#include "token_stream.hpp"
+
+namespace cpr {
+
+namespace {
+
+// 缓存格式版本，输出格式变化时修改，使旧的缓存全部失效
+constexpr std::string_view CACHE_VERSION = "toy-func-cache-1";
+
+// 64 位 FNV-1a 哈希
+class Hasher {
+public:
+  void feed(std::string_view bytes) {
+    for (unsigned char c : bytes) {
+      hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+  }
+
+  void feed(std::uint64_t word) {
+    for (int i = 0; i < 8; ++i, word >>= 8) {
+      hash = (hash ^ (word & 0xFF)) * 0x100000001b3ULL;
+    }
+  }
+
+  [[nodiscard]] std::uint64_t value() const { return hash; }
+
+private:
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+};
+
+/**
+ * @brief 哈希 token stream 中 [begin, end) 内的 token（类型与文本）
+ */
+void
+feedTokens(Hasher &hasher, const lex::TokenStream &tokens, std::size_t begin, std::size_t end)
+{
+  for (std::size_t i = begin; i < end; ++i) {
+    hasher.feed(static_cast<std::uint64_t>(tokens.type(i)));
+    hasher.feed(tokens.value(i));
+    hasher.feed(std::string_view{"\0", 1}); // 分隔相邻 token 的文本
+  }
+}
+
+} // namespace
+
+/**
+ * @param dir 缓存目录（不存在时创建）
+ */
+FuncCache::FuncCache(std::filesystem::path dir) : dir(std::move(dir))
+{
+  std::filesystem::create_directories(this->dir);
+}
+
+/**
+ * @brief   计算程序中每个函数的缓存键
+ * @details 键由函数自身的 token 与其调用的各函数的函数头 token 组成；
+ *          内联时被调用者的函数体也会进入调用者的输出，改为使用被调用者的键。
+ *          调用的函数在源文件中位于其后（不可见）时记为缺失。
+ *          存在同名函数时返回空列表，本次编译不使用缓存
+ * @param   prog     已完整解析的程序
+ * @param   tokens   程序的 token stream
+ * @param   pipeline 优化选项（见 opt::OptOptions::key）
+ * @param   bodies   是否把被调用者的函数体计入键（见 opt::OptOptions::usesCallees）
+ * @param   callees  非空时返回各函数调用的在其之前声明的函数（不含自身）
+ * @return  与 prog.decls 一一对应的缓存键
+ */
+std::vector<std::uint64_t>
+FuncCache::funcKeys(const ast::Prog &prog, const lex::TokenStream &tokens, std::string_view pipeline,
+  bool bodies, std::vector<std::vector<std::size_t>> *callees)
+{
+  std::vector<ast::FuncDeclPtr> fdecls;
+  std::unordered_map<util::SymbolId, std::size_t> index; // 函数名 -> 声明顺序
+  for (const auto &decl : prog.decls) {
+    auto fdecl = static_cast<ast::FuncDeclPtr>(decl);
+    const auto &name = fdecl->header->name;
+    if (!name.valid() || !index.try_emplace(name.id, fdecls.size()).second) {
+      return {};
+    }
+    fdecls.push_back(fdecl);
+  }
+
+  // 各函数头单独哈希，作为调用者的键的一部分
+  std::vector<std::uint64_t> headers;
+  headers.reserve(fdecls.size());
+  for (const auto &fdecl : fdecls) {
+    Hasher hasher;
+    feedTokens(hasher, tokens, fdecl->tok_begin, fdecl->tok_body);
+    headers.push_back(hasher.value());
+  }
+
+  std::vector<std::uint64_t> keys;
+  keys.reserve(fdecls.size());
+  if (callees != nullptr) {
+    callees->assign(fdecls.size(), {});
+  }
+  for (std::size_t i = 0; i < fdecls.size(); ++i) {
+    const auto &fdecl = *fdecls[i];
+
+    Hasher hasher;
+    hasher.feed(CACHE_VERSION);
+#ifdef VERBOSE
+    hasher.feed("verbose"); // 汇编中带有 IR 注释
+#endif
+    hasher.feed(pipeline);
+    feedTokens(hasher, tokens, fdecl.tok_begin, fdecl.tok_end);
+
+    // <ID> ( 即函数调用（包括函数头中的函数名本身）
+    for (std::size_t t = fdecl.tok_begin; t + 1 < fdecl.tok_end; ++t) {
+      if (tokens.type(t) != lex::TokenType::ID || tokens.type(t + 1) != lex::TokenType::LPAREN) {
+        continue;
+      }
+      auto it = index.find(tokens.name(t).id);
+      if (it == index.end() || it->second > i) {
+        hasher.feed(std::uint64_t{0});
+      } else if (it->second == i || !bodies) {
+        hasher.feed(headers[it->second]);
+      } else {
+        hasher.feed(keys[it->second]);
+      }
+      if (callees != nullptr && it != index.end() && it->second < i) {
+        (*callees)[i].push_back(it->second);
+      }
+    }
+
+    keys.push_back(hasher.value());
+  }
+
+  return keys;
+}
+
+/**
+ * @brief 缓存文件的路径
+ */
+std::filesystem::path
+FuncCache::path(std::uint64_t key, std::string_view suffix) const
+{
+  return dir / std::format("{:016x}{}", key, suffix);
+}
+
+/**
+ * @brief  查找一个函数的缓存输出
+ * @param  key      缓存键
+ * @param  need_ir  是否需要 IR
+ * @param  need_asm 是否需要汇编
+ * @return 所需的输出都存在时返回缓存内容，否则返回 std::nullopt
+ */
+std::optional<CachedFunc>
+FuncCache::lookup(std::uint64_t key, bool need_ir, bool need_asm) const
+{
+  auto read = [](const std::filesystem::path &file) -> std::optional<std::string> {
+    std::ifstream in{file, std::ios::binary};
+    if (!in) {
+      return std::nullopt;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return std::move(text).str();
+  };
+
+  CachedFunc entry;
+  if (need_ir) {
+    auto ir = read(path(key, ".ir"));
+    if (!ir.has_value()) {
+      return std::nullopt;
+    }
+    entry.ir = std::move(ir.value());
+  }
+  if (need_asm) {
+    auto assembly = read(path(key, ".s"));
+    if (!assembly.has_value()) {
+      return std::nullopt;
+    }
+    entry.assembly = std::move(assembly.value());
+  }
+  return entry;
+}
+
+/**
+ * @brief 原子地写入一个缓存文件：先写临时文件，再重命名
+ */
+void
+FuncCache::store(const std::filesystem::path &file, const std::string &text) const
+{
+  auto tmp = file;
+  tmp += std::format(".{}.{}.tmp",
+    ::getpid(), std::hash<std::thread::id>{}(std::this_thread::get_id())
+  );
+
+  {
+    std::ofstream out{tmp, std::ios::binary};
+    if (!out) {
+      return; // 缓存只是加速手段，写入失败时忽略
+    }
+    out << text;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp, file, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+  }
+}
+
+void
+FuncCache::storeIR(std::uint64_t key, const std::string &ir) const
+{
+  store(path(key, ".ir"), ir);
+}
+
+void
+FuncCache::storeAsm(std::uint64_t key, const std::string &assembly) const
+{
+  store(path(key, ".s"), assembly);
+}
+
+/**
+ * @brief 打印缓存命中统计
+ */
+void
+FuncCache::printStats() const
+{
+  std::size_t total = hits + misses;
+  std::println("Cache: {} hits, {} misses ({:.1f}% hit rate) in {}",
+    hits.load(), misses.load(), total == 0 ? 0.0 : 100.0 * hits / total, dir.string()
+  );
+}
+
+} // namespace cpr
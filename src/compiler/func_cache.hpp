@@ -0,0 +1,82 @@
+/**
+ * @file func_cache.hpp
+ * @brief Content-addressed on-disk cache of per-function compilation output.
+ *
+ * The output of one function (its printed IR and its RISC-V assembly) depends
+ * only on the function's own tokens and on the signatures of the functions it
+ * calls: labels, temporaries and code generation state are all per function.
+ * The cache key of a function therefore hashes its token stream together with
+ * the header tokens of every callee; when calls may be inlined or evaluated
+ * at compile time, the callee's own key stands in for its header. Functions
+ * whose key is found are only declared; their body is not checked, lowered
+ * or compiled again, and the cached text is spliced into the output
+ * unchanged.
+ *
+ * Layout: <dir>/<key>.ir and <dir>/<key>.s, written atomically (temp file +
+ * rename), so several processes and threads may share one directory. Only the
+ * output of functions compiled without errors is stored.
+ *
+ * Namespace: cpr
+ */
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+namespace ast { struct Prog; }
+namespace lex { class TokenStream; }
+
+namespace cpr {
+
+// 缓存中一个函数的输出
+struct CachedFunc {
+  std::string ir;       // 打印出的 IR
+  std::string assembly; // 生成的汇编
+};
+
+class FuncCache {
+public:
+  explicit FuncCache(std::filesystem::path dir);
+  ~FuncCache() = default;
+
+  FuncCache(const FuncCache &) = delete;
+  FuncCache &operator=(const FuncCache &) = delete;
+
+public:
+  static auto funcKeys(const ast::Prog &prog, const lex::TokenStream &tokens, std::string_view pipeline,
+    bool bodies = false, std::vector<std::vector<std::size_t>> *callees = nullptr)
+    -> std::vector<std::uint64_t>;
+
+  auto lookup(std::uint64_t key, bool need_ir, bool need_asm) const
+    -> std::optional<CachedFunc>;
+  void storeIR(std::uint64_t key, const std::string &ir) const;
+  void storeAsm(std::uint64_t key, const std::string &assembly) const;
+
+  /**
+   * @brief 记录一次编译中命中与未命中的函数个数
+   */
+  void count(std::size_t hit, std::size_t miss) {
+    hits   += hit;
+    misses += miss;
+  }
+
+  void printStats() const;
+
+private:
+  [[nodiscard]] auto path(std::uint64_t key, std::string_view suffix) const
+    -> std::filesystem::path;
+  void store(const std::filesystem::path &file, const std::string &text) const;
+
+private:
+  std::filesystem::path dir; // 缓存目录
+
+  std::atomic<std::size_t> hits   = 0; // 命中的函数个数
+  std::atomic<std::size_t> misses = 0; // 未命中的函数个数
+};
+
+} // namespace cpr
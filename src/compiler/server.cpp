@@ -0,0 +1,351 @@
+#include <sys/un.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <print>
+#include <format>
+#include <cstdlib>
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+
+#include "json.hpp"
+#include "panic.hpp"
+#include "timer.hpp"
+#include "batch.hpp"
+#include "server.hpp"
+
+namespace cpr {
+
+namespace {
+
+// 请求中的一个值：字符串保存解码后的内容，其它值保存原始文本
+struct JsonValue {
+  std::string text;
+  bool        is_string;
+};
+
+using JsonObject = std::unordered_map<std::string, JsonValue>;
+
+/**
+ * @brief 跳过空白字符
+ */
+void
+skipSpace(std::string_view s, std::size_t &i)
+{
+  while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) {
+    ++i;
+  }
+}
+
+/**
+ * @brief  解析一个 JSON 字符串（调用时 s[i] 为 '"'）
+ * @return 解码后的字符串，格式错误时返回 std::nullopt
+ */
+std::optional<std::string>
+parseString(std::string_view s, std::size_t &i)
+{
+  std::string str;
+  for (++i; i < s.size(); ++i) {
+    char c = s[i];
+    if (c == '"') {
+      ++i;
+      return str;
+    }
+    if (c != '\\') {
+      str.push_back(c);
+      continue;
+    }
+
+    if (++i == s.size()) {
+      return std::nullopt;
+    }
+    switch (s[i]) {
+      case '"':  str.push_back('"');  break;
+      case '\\': str.push_back('\\'); break;
+      case '/':  str.push_back('/');  break;
+      case 'b':  str.push_back('\b'); break;
+      case 'f':  str.push_back('\f'); break;
+      case 'n':  str.push_back('\n'); break;
+      case 'r':  str.push_back('\r'); break;
+      case 't':  str.push_back('\t'); break;
+      case 'u': { // 只支持基本多文种平面内的字符
+        if (i + 4 >= s.size()) {
+          return std::nullopt;
+        }
+        unsigned cp = std::strtoul(std::string{s.substr(i + 1, 4)}.c_str(), nullptr, 16);
+        i += 4;
+        if (cp < 0x80) {
+          str.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+          str.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+          str.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+          str.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+          str.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+          str.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        break;
+      }
+      default: return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief  解析一个只含标量值的 JSON 对象（协议中的请求都是这种形式）
+ * @return 键值表，格式错误时返回 std::nullopt
+ */
+std::optional<JsonObject>
+parseObject(std::string_view s)
+{
+  JsonObject obj;
+  std::size_t i = 0;
+
+  skipSpace(s, i);
+  if (i == s.size() || s[i] != '{') {
+    return std::nullopt;
+  }
+  ++i;
+
+  skipSpace(s, i);
+  if (i < s.size() && s[i] == '}') {
+    return obj;
+  }
+
+  while (true) {
+    skipSpace(s, i);
+    if (i == s.size() || s[i] != '"') {
+      return std::nullopt;
+    }
+    auto key = parseString(s, i);
+    if (!key.has_value()) {
+      return std::nullopt;
+    }
+
+    skipSpace(s, i);
+    if (i == s.size() || s[i] != ':') {
+      return std::nullopt;
+    }
+    ++i;
+    skipSpace(s, i);
+    if (i == s.size()) {
+      return std::nullopt;
+    }
+
+    if (s[i] == '"') {
+      auto val = parseString(s, i);
+      if (!val.has_value()) {
+        return std::nullopt;
+      }
+      obj[key.value()] = JsonValue{std::move(val.value()), true};
+    } else { // 数字、true、false、null
+      std::size_t start = i;
+      while (i < s.size() && s[i] != ',' && s[i] != '}' && s[i] != ' ') {
+        ++i;
+      }
+      if (start == i) {
+        return std::nullopt;
+      }
+      obj[key.value()] = JsonValue{std::string{s.substr(start, i - start)}, false};
+    }
+
+    skipSpace(s, i);
+    if (i == s.size()) {
+      return std::nullopt;
+    }
+    if (s[i] == '}') {
+      return obj;
+    }
+    if (s[i] != ',') {
+      return std::nullopt;
+    }
+    ++i;
+  } // end of while
+}
+
+/**
+ * @brief 生成响应的开头：回显请求中的 id
+ */
+std::string
+responseHead(const JsonObject &req)
+{
+  auto it = req.find("id");
+  if (it == req.end()) {
+    return "{";
+  }
+  const auto &id = it->second;
+  return std::format("{{\"id\": {}, ", id.is_string ? util::jsonQuote(id.text) : id.text);
+}
+
+} // namespace
+
+/**
+ * @brief   处理一个请求
+ * @param   line 请求（一行 JSON）
+ * @return  响应（一行 JSON，不含换行符）
+ */
+std::string
+Server::handle(std::string_view line)
+{
+  auto req = parseObject(line);
+  if (!req.has_value()) {
+    return R"({"status": "error", "message": "malformed request"})";
+  }
+
+  auto head = responseHead(req.value());
+  auto field = [&req](const std::string &key) -> std::optional<std::string> {
+    if (auto it = req->find(key); it != req->end()) {
+      return it->second.text;
+    }
+    return std::nullopt;
+  };
+
+  if (field("cmd") == "shutdown") {
+    stop = true;
+    return head + R"("status": "ok"})";
+  }
+
+  auto path = field("path");
+  if (!path.has_value()) {
+    return head + R"("status": "error", "message": "missing path"})";
+  }
+
+  auto mode = field("mode").value_or("--asm");
+  bool flag_ir  = mode == "--ir" || mode == "ir";
+  bool flag_asm = mode == "--asm" || mode == "asm";
+  bool flag_obj = mode == "--obj" || mode == "obj";
+  if (!flag_ir && !flag_asm && !flag_obj) {
+    return head + std::format(R"("path": {}, "status": "error", "message": {}}})",
+      util::jsonQuote(path.value()), util::jsonQuote(std::format("unknown mode {}", mode))
+    );
+  }
+
+  auto output = field("output").value_or(batchOutput(path.value(), ""));
+  auto jobs = static_cast<unsigned>(std::strtoul(field("jobs").value_or("1").c_str(), nullptr, 10));
+
+  const char *status = "ok";
+  util::Timer timer;
+  timer.start();
+  {
+    util::RecoverScope recover; // 一个请求中的致命错误不终止 server
+    try {
+      auto request = opts;
+      request.flag_ir  = flag_ir;
+      request.flag_asm = flag_asm;
+      request.flag_obj = flag_obj;
+      request.jobs     = std::max(jobs, 1u);
+
+      Compiler compiler{path.value(), request, &workspace};
+      if (flag_ir) {
+        compiler.generateIR(output);
+      }
+      if (flag_asm) {
+        compiler.generateAssemble(output);
+      }
+      if (flag_obj) {
+        compiler.generateObject(output);
+      }
+      if (compiler.hasErrs()) {
+        status = "failed";
+      }
+    } catch (const util::FatalAbort &) {
+      status = "aborted";
+    }
+  }
+  workspace.arena.reset();
+  timer.stop();
+
+  return head + std::format(R"("path": {}, "status": "{}", "ms": {:.3f}}})",
+    util::jsonQuote(path.value()), status, timer.seconds() * 1e3
+  );
+}
+
+/**
+ * @brief 逐行读取请求并写回响应，直到输入结束或收到 shutdown
+ */
+void
+Server::serve(std::FILE *in, std::FILE *out)
+{
+  char *buf = nullptr;
+  std::size_t cap = 0;
+
+  ssize_t len;
+  while (!stop && (len = ::getline(&buf, &cap, in)) != -1) {
+    std::string_view line{buf, static_cast<std::size_t>(len)};
+    if (line.find_first_not_of(" \t\r\n") == std::string_view::npos) {
+      continue;
+    }
+    std::println(out, "{}", handle(line));
+    std::fflush(out);
+  }
+
+  std::free(buf);
+}
+
+/**
+ * @brief   在标准输入上接收请求，响应写到标准输出
+ * @details 编译过程中原本写到标准输出的内容（如错误总数）被重定向到标准错误，
+ *          保证标准输出上只有协议数据
+ */
+void
+Server::serveStdio()
+{
+  std::fflush(stdout);
+  int proto = ::dup(STDOUT_FILENO);
+  ::dup2(STDERR_FILENO, STDOUT_FILENO);
+
+  std::FILE *out = ::fdopen(proto, "w");
+  CHECK(out != nullptr, "无法打开协议输出");
+
+  serve(stdin, out);
+  std::fclose(out);
+}
+
+/**
+ * @brief 在 Unix domain socket 上接收请求，依次处理各个连接，直到收到 shutdown
+ * @param path socket 路径（已存在时先删除）
+ */
+void
+Server::serveSocket(const std::string &path)
+{
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  CHECK(path.size() < sizeof(addr.sun_path), "socket 路径过长");
+  path.copy(addr.sun_path, path.size());
+
+  int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  CHECK(listener >= 0, "无法创建 socket");
+
+  ::unlink(path.c_str());
+  if (::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+    || ::listen(listener, 16) != 0)
+  {
+    UNREACHABLE(std::format("无法监听 socket: {}", path));
+  }
+
+  while (!stop) {
+    int conn = ::accept(listener, nullptr, nullptr);
+    if (conn < 0) {
+      continue;
+    }
+
+    std::FILE *in  = ::fdopen(conn, "r");
+    std::FILE *out = ::fdopen(::dup(conn), "w");
+    if (in != nullptr && out != nullptr) {
+      serve(in, out);
+    }
+    if (out != nullptr) {
+      std::fclose(out);
+    }
+    if (in != nullptr) {
+      std::fclose(in);
+    }
+  }
+
+  ::close(listener);
+  ::unlink(path.c_str());
+}
+
+} // namespace cpr
@@ -0,0 +1,56 @@
+/**
+ * @file server.hpp
+ * @brief Resident compile server speaking a line-delimited JSON protocol.
+ *
+ * Each request is one JSON object per line:
+ *
+ *   {"path": "a.rs", "mode": "--asm", "output": "out/a", "id": 1}
+ *
+ * `mode` is "--ir", "--asm" or "--obj" (default "--asm"), `output` is the output file
+ * name without suffix (default: the input without its suffix), `id` is echoed
+ * back unchanged. {"cmd": "shutdown"} stops the server. Each request gets one
+ * response line:
+ *
+ *   {"id": 1, "path": "a.rs", "status": "ok", "ms": 0.412}
+ *
+ * where status is "ok", "failed" (diagnostics were reported), "aborted" (fatal
+ * error) or "error" (malformed request, with a "message"). Diagnostics are
+ * written to stderr as usual.
+ *
+ * The process stays resident, so the loader, the type caches and the arena
+ * memory are reused between requests instead of being rebuilt per process.
+ * With --cache-dir, unchanged functions are spliced from the incremental
+ * compilation cache (see func_cache.hpp).
+ *
+ * Namespace: cpr
+ */
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "compiler.hpp"
+
+namespace cpr {
+
+class Server {
+public:
+  explicit Server(const CompileOptions &opts = {}) : opts(opts) {}
+  ~Server() = default;
+
+public:
+  void serveStdio();
+  void serveSocket(const std::string &path);
+
+private:
+  void serve(std::FILE *in, std::FILE *out);
+  auto handle(std::string_view line) -> std::string;
+
+private:
+  Workspace      workspace;    // 跨请求复用的资源
+  CompileOptions opts;         // 命令行给出的编译选项，请求中的 mode 与 jobs 覆盖其中的对应项
+  bool           stop = false; // 收到 shutdown 请求
+};
+
+} // namespace cpr
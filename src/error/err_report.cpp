@@ -1,8 +1,9 @@
+#include <mutex>
 #include <print>
-#include <cassert>
-#include <sstream>
-#include <iostream>
+#include <cstdio>
+#include <iterator>
 
+#include "json.hpp"
 #include "err_report.hpp"
 
 namespace err {
@@ -14,24 +15,57 @@ static inline constexpr std::string RED    = "\033[1;31m";
 static inline constexpr std::string BLUE   = "\033[1;34m";
 // static inline constexpr std::string YELLOW = "\033[1;33m";
 
+/**
+ * @brief 把格式化后的内容追加到 buf 末尾
+ */
+template<typename... Args>
+static void
+append(std::string &buf, std::format_string<Args...> fmt, Args &&...args)
+{
+  std::format_to(std::back_inserter(buf), fmt, std::forward<Args>(args)...);
+}
+
 /**
  * @brief 打印指定位置处的源代码
  *
  * @param pos 指定的位置
+ * @param buf 输出缓冲区
  */
 void
-ErrReporter::displaySrc(const util::Position &pos) const
+ErrReporter::displaySrc(const util::Position &pos, std::string &buf) const
 {
-  std::ostringstream oss;
-  oss << std::format("{:<3}", pos.row + 1);
+  auto rowstr = std::format("{:<3}", pos.row + 1);
+
+  append(buf, "{}   |  \n", BLUE);
+  append(buf, "{}{}| {}{}\n", BLUE, rowstr, RESET,
+    pos.row < text.lineCount() ? text.line(pos.row) : ""
+  );
 
-  std::cerr << BLUE << "   |  " << std::endl
-    << BLUE << oss.str() << "| " << RESET
-    << this->text[pos.row] << std::endl;
+  std::size_t delta = rowstr.length() + pos.col - 2;
+  append(buf, "{}   |{}^{}\n", BLUE, std::string(delta, ' '), RESET);
+}
 
-  int delta = oss.str().length() + pos.col - 2;
-  std::cerr << BLUE << "   |" << std::string(delta, ' ') << "^" << RESET
-    << std::endl;
+/**
+ * @brief 以一行 JSON 对象的形式输出一个错误
+ * @param buf       输出缓冲区
+ * @param kind      错误类别（lexer、parser、semantic）
+ * @param code      错误码
+ * @param message   错误提示
+ * @param err       错误实例
+ * @param extra_key 附加字段名
+ * @param extra     附加字段值
+ */
+void
+ErrReporter::displayJson(std::string &buf, std::string_view kind, std::string_view code,
+  std::string_view message, const Err &err,
+  std::string_view extra_key, std::string_view extra) const
+{
+  append(buf,
+    R"({{"file": {}, "kind": "{}", "code": "{}", "message": {}, "details": {}, "line": {}, "column": {}, "{}": {}}})"
+    "\n",
+    util::jsonQuote(text.name()), kind, code, util::jsonQuote(message), util::jsonQuote(err.msg),
+    err.pos.row + 1, err.pos.col + 1, extra_key, util::jsonQuote(extra)
+  );
 }
 
 /*---------------- LexErr ----------------*/
@@ -39,30 +73,34 @@ ErrReporter::displaySrc(const util::Position &pos) const
 /**
  * @brief 打印未知 Token 错误
  * @param err 词法错误实例
+ * @param buf 输出缓冲区
  */
 void
-ErrReporter::displayUnknownType(const LexErr &err) const
+ErrReporter::displayUnknownType(const LexErr &err, std::string &buf) const
 {
-  std::cerr << BOLD << RED << "Lexer Error[UnknownToken]" << RESET << BOLD
-    << std::format(": 识别到未知 token '{}'", err.token) << RESET << std::endl;
+  auto message = std::format("识别到未知 token '{}'", err.token);
+  if (config.format == ErrFormat::JSON) {
+    displayJson(buf, "lexer", "UnknownToken", message, err, "token", err.token);
+    return;
+  }
 
-  std::cerr << BLUE << " ---> " << RESET
-    << std::format("{}", err.pos + util::Position{1, 1})
-    << std::endl;
+  append(buf, "{}{}Lexer Error[UnknownToken]{}{}: {}{}\n", BOLD, RED, RESET, BOLD, message, RESET);
+  append(buf, "{} ---> {}{}\n", BLUE, RESET, err.pos + util::Position{1, 1});
 
-  displaySrc(err.pos);
+  displaySrc(err.pos, buf);
 }
 
 /**
  * @brief 分发处理词法错误
  * @param reporter 错误处理器实例
+ * @param buf      输出缓冲区
  */
 void
-LexErr::display(const ErrReporter &reporter) const
+LexErr::display(const ErrReporter &reporter, std::string &buf) const
 {
   switch (type) {
     case LexErrType::UNKNOWN_TOKEN:
-      reporter.displayUnknownType(*this);
+      reporter.displayUnknownType(*this, buf);
       break;
   }
 }
@@ -74,32 +112,65 @@ LexErr::display(const ErrReporter &reporter) const
 /**
  * @brief 打印 unexpected token 错误
  * @param err 语法错误实例
+ * @param buf 输出缓冲区
  */
 void
-ErrReporter::displayUnexpectedToken(const ParErr &err) const
+ErrReporter::displayUnexpectedToken(const ParErr &err, std::string &buf) const
 {
-  std::cerr << BOLD << RED << "Parser Error[UnexpectedToken]" << RESET << BOLD
-    << std::format(": 意料之外的 token '{}'", err.token) << RESET << std::endl;
+  auto message = std::format("意料之外的 token '{}'", err.token);
+  if (config.format == ErrFormat::JSON) {
+    displayJson(buf, "parser", "UnexpectedToken", message, err, "token", err.token);
+    return;
+  }
 
-  std::cerr << BLUE << " ---> " << RESET
-    << std::format("{}", err.pos + util::Position{1, 1})
-    << std::endl;
+  append(buf, "{}{}Parser Error[UnexpectedToken]{}{}: {}{}\n", BOLD, RED, RESET, BOLD, message, RESET);
+  append(buf, "{} ---> {}{}\n", BLUE, RESET, err.pos + util::Position{1, 1});
 
-  displaySrc(err.pos);
+  displaySrc(err.pos, buf);
 
-  std::cerr << BLUE << "   |" << std::endl;
-  std::cerr << BLUE << "   =" << RESET << std::format(" Details: {}", err.msg)
-    << std::endl << std::endl;
+  append(buf, "{}   |\n", BLUE);
+  append(buf, "{}   ={} Details: {}\n\n", BLUE, RESET, err.msg);
+}
+
+/**
+ * @brief 打印表达式嵌套过深的错误
+ * @param err 语法错误实例
+ * @param buf 输出缓冲区
+ */
+void
+ErrReporter::displayNestingTooDeep(const ParErr &err, std::string &buf) const
+{
+  std::string_view message = "表达式嵌套过深";
+  if (config.format == ErrFormat::JSON) {
+    displayJson(buf, "parser", "NestingTooDeep", message, err, "token", err.token);
+    return;
+  }
+
+  append(buf, "{}{}Parser Error[NestingTooDeep]{}{}: {}{}\n", BOLD, RED, RESET, BOLD, message, RESET);
+  append(buf, "{} ---> {}{}\n", BLUE, RESET, err.pos + util::Position{1, 1});
+
+  displaySrc(err.pos, buf);
+
+  append(buf, "{}   |\n", BLUE);
+  append(buf, "{}   ={} Details: {}\n\n", BLUE, RESET, err.msg);
 }
 
 /**
  * @brief 分发打印不同的语法错误
  * @param reporter 错误报告器实例
+ * @param buf      输出缓冲区
  */
 void
-ParErr::display(const ErrReporter &reporter) const
+ParErr::display(const ErrReporter &reporter, std::string &buf) const
 {
-  reporter.displayUnexpectedToken(*this);
+  switch (type) {
+    case ParErrType::UNEXPECT_TOKEN:
+      reporter.displayUnexpectedToken(*this, buf);
+      break;
+    case ParErrType::NESTING_TOO_DEEP:
+      reporter.displayNestingTooDeep(*this, buf);
+      break;
+  }
 }
 
 /*---------------- ParErr ----------------*/
@@ -124,52 +195,74 @@ displaySemErrType(SemErrType type)
 /**
  * @brief 打印语义错误
  * @param err 语义错误实例
+ * @param buf 输出缓冲区
  */
 void
-ErrReporter::displaySemErr(const SemErr &err) const
+ErrReporter::displaySemErr(const SemErr &err, std::string &buf) const
 {
   auto pair = displaySemErrType(err.type);
-  std::cerr << BOLD << RED << std::format("Semantic Error[{}]", pair.first) << RESET << BOLD
-    << ": " << pair.second << RESET << std::endl;
+  if (config.format == ErrFormat::JSON) {
+    displayJson(buf, "semantic", pair.first, pair.second, err, "scope", err.scope_name);
+    return;
+  }
 
-  std::cerr << BLUE << "  --> " << RESET <<
-    std::format(
-      "scope: {} {}",
-      err.scope_name,
-      err.pos + util::Position{1, 1}
-    ) << std::endl;
+  append(buf, "{}{}Semantic Error[{}]{}{}: {}{}\n", BOLD, RED, pair.first, RESET, BOLD, pair.second, RESET);
+  append(buf, "{}  --> {}scope: {} {}\n", BLUE, RESET, err.scope_name, err.pos + util::Position{1, 1});
 
-  displaySrc(err.pos);
+  displaySrc(err.pos, buf);
 
-  std::cerr << BLUE << "   |" << std::endl;
-  std::cerr << BLUE << "   =" << RESET << std::format(" Details: {}", err.msg)
-    << std::endl << std::endl;
+  append(buf, "{}   |\n", BLUE);
+  append(buf, "{}   ={} Details: {}\n\n", BLUE, RESET, err.msg);
 }
 
 /**
  * @brief 打印语义错误
  * @param reporter 错误报告器实例
+ * @param buf      输出缓冲区
  */
 void
-SemErr::display(const ErrReporter &reporter) const
+SemErr::display(const ErrReporter &reporter, std::string &buf) const
 {
-  reporter.displaySemErr(*this);
+  reporter.displaySemErr(*this, buf);
 }
 
 /*---------------- SemErr ----------------*/
 
 /*---------------- ErrReporter ----------------*/
 
-ErrReporter::ErrReporter(const std::string &t)
+/**
+ * @param t      输入文件原始文本
+ * @param config 输出格式与错误数上限
+ */
+ErrReporter::ErrReporter(const util::SourceBuffer &t, ReportConfig config)
+  : text(t), config(config)
 {
-  std::istringstream iss{t};
+}
 
-  std::string line{};
-  while (std::getline(iss, line)) {
-    this->text.push_back(line);
+/**
+ * @brief 登记一个错误，错误数达到上限时立即终止
+ */
+void
+ErrReporter::add(ErrPtr err)
+{
+  errs.push_back(std::move(err));
+  checkLimit();
+}
+
+/**
+ * @brief   错误数达到 --max-errors 指定的上限时，打印前 max_errs 个错误并终止编译
+ * @details 两阶段模式下各函数的错误先收集在各自的报告器中，合并后再调用
+ */
+void
+ErrReporter::checkLimit()
+{
+  if (config.max_errs == 0 || errs.size() < config.max_errs) {
+    return;
   }
 
-  assert(iss.eof());
+  errs.resize(config.max_errs);
+  limited = true;
+  terminate(*this);
 }
 
 /**
@@ -184,7 +277,7 @@ ErrReporter::report(LexErrType type, const std::string &msg,
   util::Position pos, const std::string &token)
 {
   auto lexerr = std::make_shared<LexErr>(type, msg, pos, token);
-  errs.push_back(lexerr);
+  add(std::move(lexerr));
 }
 
 /**
@@ -199,7 +292,7 @@ ErrReporter::report(ParErrType type, const std::string &msg,
   util::Position pos, const std::string &token)
 {
   auto parerr = std::make_shared<ParErr>(type, msg, pos, token);
-  errs.push_back(parerr);
+  add(std::move(parerr));
 }
 
 /**
@@ -214,7 +307,7 @@ ErrReporter::report(SemErrType type, const std::string &msg,
   util::Position pos, const std::string &scope_name)
 {
   auto semerr = std::make_shared<SemErr>(type, msg, pos, scope_name);
-  errs.push_back(semerr);
+  add(std::move(semerr));
 }
 
 /**
@@ -223,13 +316,35 @@ ErrReporter::report(SemErrType type, const std::string &msg,
 void
 ErrReporter::displayErrs() const
 {
+  // 先格式化到一块缓冲区，再一次性写出
+  std::string buf;
+  buf.reserve(errs.size() * 256);
   for (const auto &err : errs) {
-    err->display(*this);
+    err->display(*this, buf);
+  }
+
+  if (config.format == ErrFormat::JSON) {
+    append(buf, R"({{"file": {}, "errors": {}, "truncated": {}}})" "\n",
+      util::jsonQuote(text.name()), errs.size(), limited
+    );
+  } else {
+    if (limited) {
+      append(buf, "{}note{}: 错误数达到上限 {}（--max-errors），停止编译\n\n", BOLD, RESET, errs.size());
+    }
+    append(buf, "{}Error{}", RED, RESET);
   }
 
+  // 批量编译时多个文件可能同时报错，保证每个文件的错误成块输出
+  static std::mutex display_mutex;
+  std::lock_guard lock{display_mutex};
+
+  std::fwrite(buf.data(), 1, buf.size(), stderr);
+  std::fflush(stderr);
+
   // 输出错误总数
-  std::cerr << RED << "Error" << RESET;
-  std::println(": {} errors emitted", errs.size());
+  if (config.format == ErrFormat::TEXT) {
+    std::println(": {} errors emitted", errs.size());
+  }
 }
 
 /**
@@ -241,6 +356,21 @@ ErrReporter::hasErrs() const
   return !errs.empty();
 }
 
+/**
+ * @brief 把另一个报告器收集到的错误按原顺序插入到第 at 个错误之前
+ * @param at    插入位置
+ * @param other 另一个报告器（两阶段模式下每个函数一个）
+ */
+void
+ErrReporter::insertErrs(std::size_t at, ErrReporter &&other)
+{
+  errs.insert(errs.begin() + static_cast<std::ptrdiff_t>(at),
+    std::make_move_iterator(other.errs.begin()),
+    std::make_move_iterator(other.errs.end())
+  );
+  other.errs.clear();
+}
+
 /*---------------- ErrReporter ----------------*/
 
 } // namespace err
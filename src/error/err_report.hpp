@@ -1,17 +1,33 @@
 #pragma once
 
 #include <print>
+#include <string>
 #include <vector>
+#include <cstdint>
 
+#include "panic.hpp"
 #include "position.hpp"
 #include "err_type.hpp"
+#include "source_buffer.hpp"
 
 namespace err {
 
+// 诊断信息的输出格式
+enum class ErrFormat : std::uint8_t {
+  TEXT, // 带源代码片段的彩色文本
+  JSON, // 每个错误一行 JSON 对象，最后一行为错误总数，便于工具处理
+};
+
+// 错误报告器的配置
+struct ReportConfig {
+  ErrFormat   format   = ErrFormat::TEXT;
+  std::size_t max_errs = 0; // 错误数达到该值时立即打印并终止编译，0 表示不限制
+};
+
 // 错误报告器
 class ErrReporter {
 public:
-  ErrReporter(const std::string &t);
+  ErrReporter(const util::SourceBuffer &t, ReportConfig config = {});
   ~ErrReporter() = default;
 
 public:
@@ -24,18 +40,29 @@ public:
 
 public:
   void displayErrs() const;
-  void displayUnknownType(const LexErr &err) const;
-  void displayUnexpectedToken(const ParErr &err) const;
-  void displaySemErr(const SemErr &err) const;
+  void displayUnknownType(const LexErr &err, std::string &buf) const;
+  void displayUnexpectedToken(const ParErr &err, std::string &buf) const;
+  void displayNestingTooDeep(const ParErr &err, std::string &buf) const;
+  void displaySemErr(const SemErr &err, std::string &buf) const;
 
   [[nodiscard]] bool hasErrs() const;
+  [[nodiscard]] std::size_t errCount() const { return errs.size(); }
+
+  void insertErrs(std::size_t at, ErrReporter &&other);
+  void checkLimit();
 
 private:
-  void displaySrc(const util::Position &pos) const;
+  void add(ErrPtr err);
+  void displaySrc(const util::Position &pos, std::string &buf) const;
+  void displayJson(std::string &buf, std::string_view kind, std::string_view code,
+    std::string_view message, const Err &err,
+    std::string_view extra_key, std::string_view extra) const;
 
 private:
-  std::vector<std::string> text; // 输入文件原始文本
-  std::vector<ErrPtr>      errs; // 错误列表
+  const util::SourceBuffer &text;            // 输入文件原始文本
+  ReportConfig              config;          // 输出格式与错误数上限
+  std::vector<ErrPtr>       errs;            // 错误列表
+  bool                      limited = false; // 是否因错误数达到上限而终止
 };
 
 /**
@@ -49,6 +76,9 @@ terminate(err::ErrReporter &reporter) {
 
   std::println(stderr, "");
   std::println(stderr, "程序出错，终止运行！");
+  if (util::recover_fatal) {
+    throw util::FatalAbort{"TERMINATE", "程序出错，终止运行"};
+  }
   exit(1);
 }
 
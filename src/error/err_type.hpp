@@ -17,7 +17,8 @@ enum class LexErrType : std::uint8_t {
 
 // 语法错误码
 enum class ParErrType : std::uint8_t {
-  UNEXPECT_TOKEN, // 并非期望 token
+  UNEXPECT_TOKEN,   // 并非期望 token
+  NESTING_TOO_DEEP, // 表达式嵌套超过上限
 };
 
 #define SEMANTIC_ERROR_LIST(_) \
@@ -55,7 +56,7 @@ struct Err {
   Err(std::string msg, util::Position pos)
     : msg(std::move(msg)), pos(pos) {}
   virtual ~Err() = default;
-  virtual void display(const ErrReporter &reporter) const = 0;
+  virtual void display(const ErrReporter &reporter, std::string &buf) const = 0;
 };
 using ErrPtr = std::shared_ptr<Err>;
 
@@ -69,7 +70,7 @@ struct LexErr : Err {
   ) : Err(std::move(msg), pos), type(type),
       token(std::move(token)) {}
   ~LexErr() override = default;
-  void display(const ErrReporter &reporter) const override;
+  void display(const ErrReporter &reporter, std::string &buf) const override;
 };
 using LexErrPtr = std::shared_ptr<LexErr>;
 
@@ -83,7 +84,7 @@ struct ParErr : Err {
   ) : Err(std::move(msg), pos), type(type),
       token(std::move(token)) {}
   ~ParErr() override = default;
-  void display(const ErrReporter &reporter) const override;
+  void display(const ErrReporter &reporter, std::string &buf) const override;
 };
 using ParErrPtr = std::shared_ptr<ParErr>;
 
@@ -97,7 +98,7 @@ struct SemErr : Err {
   ) : Err(std::move(msg), pos), type(type),
       scope_name(std::move(scope_name)) {}
   ~SemErr() override = default;
-  void display(const ErrReporter &reporter) const override;
+  void display(const ErrReporter &reporter, std::string &buf) const override;
 };
 using SemErrPtr = std::shared_ptr<SemErr>;
 
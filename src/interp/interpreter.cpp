@@ -0,0 +1,697 @@
+#include <cstring>
+#include <algorithm>
+
+#include "fold.hpp"
+#include "panic.hpp"
+#include "def_use.hpp"
+#include "aggregate.hpp"
+#include "interpreter.hpp"
+
+#if defined(__GNUC__)
+#define INTERP_THREADED 1 // labels as values：直接线索化的分派
+#endif
+
+namespace interp {
+
+namespace {
+
+// 字节码指令，r 为当前帧的寄存器，m 为按字编址的栈，L 为指令下标
+#define INTERP_OP_LIST(_) \
+  _(MOV)   /* r[a] = r[b] */ \
+  _(MOVI)  /* r[a] = b */ \
+  _(ADD)  _(SUB)  _(MUL)  _(DIV)  _(EQ)  _(NEQ)  _(GT)  _(GEQ)  _(LT)  _(LEQ)  /* r[a] = r[b] op r[c] */ \
+  _(ADDI) _(SUBI) _(MULI) _(DIVI) _(EQI) _(NEQI) _(GTI) _(GEQI) _(LTI) _(LEQI) /* r[a] = r[b] op c */ \
+  _(JMP)   /* goto L[a] */ \
+  _(BEQZ)  /* if r[b] == 0 goto L[a] */ \
+  _(BNEZ)  /* if r[b] != 0 goto L[a] */ \
+  _(BGE)   /* if r[b] >= r[c] goto L[a] */ \
+  _(BGEI)  /* if r[b] >= c goto L[a] */ \
+  _(ADDR)  /* r[a] = 帧基址 + b：栈上数组/元组的地址 */ \
+  _(PARAM) /* 把 r[a] 指向的 c 个字复制到帧基址 + b，r[a] 改为指向副本：数组/元组按值传递 */ \
+  _(INDEX) /* r[a] = r[b] + r[c] * e，r[c] 不在 [0, d) 中时越界 */ \
+  _(INDEXI) /* r[a] = r[b] + c */ \
+  _(LOAD)  /* r[a] = m[r[b]] */ \
+  _(STORE) /* m[r[a] + c] = r[b] */ \
+  _(COPY)  /* m[r[a] + c, +d) = m[r[b], +d) */ \
+  _(CALL)  /* r[b] = 函数 a(实参 args[c, c + d))，b 为 -1 时丢弃返回值 */ \
+  _(RET)   /* 返回 r[a]，a 为 -1 时没有返回值 */ \
+  _(TRAP)  /* 以常量下标越界访问 */
+
+enum class Op : std::uint8_t {
+#define DEFINE_ENUM(name) name,
+  INTERP_OP_LIST(DEFINE_ENUM)
+#undef DEFINE_ENUM
+};
+
+struct Inst {
+  const void  *handler = nullptr; // 直接线索化时处理这条指令的代码的地址
+  std::int32_t a = -1;
+  std::int32_t b = -1;
+  std::int32_t c = -1;
+  std::int32_t d = -1;
+  std::int32_t e = -1;
+  Op           op;
+};
+static_assert(sizeof(Inst) == 32);
+
+/**
+ * @brief 64 位的结果是否超出 i32
+ */
+inline bool
+overflows(std::int64_t value)
+{
+  return value != static_cast<std::int32_t>(value);
+}
+
+/**
+ * @brief 二元运算的指令；rhs_imm 为右操作数是常量的形式
+ */
+Op
+binaryOp(ir::IROp op, bool rhs_imm)
+{
+  switch (op) {
+    case ir::IROp::ADD: return rhs_imm ? Op::ADDI : Op::ADD;
+    case ir::IROp::SUB: return rhs_imm ? Op::SUBI : Op::SUB;
+    case ir::IROp::MUL: return rhs_imm ? Op::MULI : Op::MUL;
+    case ir::IROp::DIV: return rhs_imm ? Op::DIVI : Op::DIV;
+    case ir::IROp::EQ:  return rhs_imm ? Op::EQI  : Op::EQ;
+    case ir::IROp::NEQ: return rhs_imm ? Op::NEQI : Op::NEQ;
+    case ir::IROp::GT:  return rhs_imm ? Op::GTI  : Op::GT;
+    case ir::IROp::GEQ: return rhs_imm ? Op::GEQI : Op::GEQ;
+    case ir::IROp::LT:  return rhs_imm ? Op::LTI  : Op::LT;
+    case ir::IROp::LEQ: return rhs_imm ? Op::LEQI : Op::LEQ;
+    default:
+      UNREACHABLE("not a binary operator");
+  }
+}
+
+/**
+ * @brief 数组/元组占的字数
+ */
+inline std::int32_t
+words(type::TypePtr type)
+{
+  return cg::Aggregates::sizeOf(type) / cg::Aggregates::WORD;
+}
+
+} // namespace
+
+// 一个函数的字节码；帧的布局为 [常量 | 其余的值 | 元素别名的中转槽 | 栈上的数组/元组]
+struct Interpreter::Code {
+  std::vector<Inst>         insts;
+  std::vector<std::int32_t> args;   // 各调用的实参所在的槽
+  std::vector<std::int32_t> consts; // 槽 [0, consts.size()) 中常量的值，进入函数时复制到帧中
+  std::vector<std::int32_t> params; // 形参的槽
+  std::int32_t              frame = 0; // 帧的大小（字）
+  bool                      ready = false;
+};
+
+std::string_view
+statusStr(Outcome::Status status)
+{
+  switch (status) {
+    case Outcome::Status::OK:             return "ok";
+    case Outcome::Status::OUT_OF_BOUNDS:  return "index out of bounds";
+    case Outcome::Status::STACK_OVERFLOW: return "stack overflow";
+    case Outcome::Status::OUT_OF_FUEL:    return "out of fuel";
+    case Outcome::Status::OVERFLOW:       return "i32 overflow";
+  }
+  UNREACHABLE("unknown status");
+}
+
+Interpreter::Interpreter(std::span<const ir::FuncCode *const> funcs)
+  : funcs(funcs.begin(), funcs.end()), codes(funcs.size())
+{
+  for (std::size_t i = 0; i < funcs.size(); ++i) {
+    index.emplace(funcs[i]->name, i);
+  }
+}
+
+Interpreter::~Interpreter() = default;
+
+/**
+ * @brief  按名字查找函数
+ * @return 函数的 IR，没有时为 nullptr
+ */
+const ir::FuncCode *
+Interpreter::find(std::string_view name) const
+{
+  auto it = index.find(name);
+  return it == index.end() ? nullptr : funcs[it->second];
+}
+
+/**
+ * @brief  调用函数 name，实参都是标量
+ * @param  name   函数名，必须存在
+ * @param  args   实参
+ * @param  limits 跳转、调用次数与栈的上限
+ * @return 返回值或出错的原因
+ */
+Outcome
+Interpreter::call(std::string_view name, std::span<const int> args, const Limits &limits)
+{
+  auto it = index.find(name);
+  CHECK(it != index.end(), std::format("can't find function {}", name));
+  return execute(it->second, args, limits);
+}
+
+/**
+ * @brief 把第 func 个函数的四元式解码为字节码
+ */
+void
+Interpreter::decode(std::size_t func_idx)
+{
+  const auto &func = *funcs[func_idx];
+  auto &code = codes[func_idx];
+  auto n = func.valueCount();
+
+  std::vector<bool> alias(n, false); // 数组/元组元素的别名：槽中是元素的地址
+  for (const auto &quad : func.quads) {
+    if (ir::isElemAccess(quad)) {
+      alias[quad.dst] = true;
+    }
+  }
+  auto aggregate = [&](ir::ValueId value) {
+    return cg::Aggregates::isAggregate(func.value(value)->type);
+  };
+
+  // 分配槽：常量在前，进入函数时整体复制
+  std::vector<std::int32_t> slot(n, -1);
+  for (ir::ValueId value = 0; value < n; ++value) {
+    if (func.value(value)->isConst()) {
+      slot[value] = static_cast<std::int32_t>(code.consts.size());
+      code.consts.push_back(ir::constValue(*func.value(value)));
+    }
+  }
+  auto next = static_cast<std::int32_t>(code.consts.size());
+  for (ir::ValueId value = 0; value < n; ++value) {
+    if (slot[value] < 0) {
+      slot[value] = next++;
+    }
+  }
+  std::vector<std::int32_t> shadow(n, -1); // 标量元素读出、写入时经过的槽
+  for (ir::ValueId value = 0; value < n; ++value) {
+    if (alias[value] && !aggregate(value)) {
+      shadow[value] = next++;
+    }
+  }
+
+  // 栈上的数组/元组接在槽之后
+  std::vector<std::int32_t> offset(n, -1);
+  auto frame = next;
+  for (ir::ValueId value = 0; value < n; ++value) {
+    if (!func.value(value)->isConst() && !alias[value] && aggregate(value)) {
+      offset[value] = frame;
+      frame += words(func.value(value)->type);
+    }
+  }
+  code.frame = frame;
+
+  auto &insts = code.insts;
+  auto emit = [&](Op op, std::int32_t a, std::int32_t b = -1, std::int32_t c = -1,
+                  std::int32_t d = -1, std::int32_t e = -1) {
+    insts.push_back({.a = a, .b = b, .c = c, .d = d, .e = e, .op = op});
+  };
+  auto isConst = [&](ir::ValueId value) { return func.value(value)->isConst(); };
+  auto constOf = [&](ir::ValueId value) { return ir::constValue(*func.value(value)); };
+
+  // 读取一个值的槽：标量元素先读到中转槽
+  auto use = [&](ir::ValueId value) {
+    if (shadow[value] >= 0) {
+      emit(Op::LOAD, shadow[value], slot[value]);
+      return shadow[value];
+    }
+    return slot[value];
+  };
+  // 写入一个值的槽；写入标量元素时先写到中转槽，再由 store 存回
+  auto def = [&](ir::ValueId value) {
+    return shadow[value] >= 0 ? shadow[value] : slot[value];
+  };
+  auto store = [&](ir::ValueId value) {
+    if (shadow[value] >= 0) {
+      emit(Op::STORE, slot[value], shadow[value], 0);
+    }
+  };
+
+  std::vector<std::int32_t> labels(func.labelCount(), -1); // 标号 -> 指令下标
+  std::vector<std::size_t>  jumps;                         // a 中是标号的指令
+
+  CHECK(!func.quads.empty() && func.quads.front().op == ir::IROp::FUNC,
+    std::format("{} doesn't start with its label", func.name));
+  for (const auto &quad : func.quads) {
+    switch (quad.op) {
+      case ir::IROp::FUNC:
+        // 栈上的数组/元组的地址；数组/元组形参复制到帧中
+        for (ir::ValueId value = 0; value < n; ++value) {
+          if (offset[value] >= 0 && std::ranges::find(func.params, value) == func.params.end()) {
+            emit(Op::ADDR, slot[value], offset[value]);
+          }
+        }
+        for (auto param : func.params) {
+          if (offset[param] >= 0) {
+            emit(Op::PARAM, slot[param], offset[param], words(func.value(param)->type));
+          }
+          code.params.push_back(slot[param]);
+        }
+        labels[quad.label] = static_cast<std::int32_t>(insts.size());
+        break;
+      case ir::IROp::LABEL:
+        labels[quad.label] = static_cast<std::int32_t>(insts.size());
+        break;
+      case ir::IROp::ADD: case ir::IROp::SUB:
+      case ir::IROp::MUL: case ir::IROp::DIV:
+      case ir::IROp::EQ:  case ir::IROp::NEQ:
+      case ir::IROp::GT:  case ir::IROp::GEQ:
+      case ir::IROp::LT:  case ir::IROp::LEQ:
+        // 溢出的常量运算留到运行时，由 Limits::checked 决定是否报告
+        if (isConst(quad.arg1) && isConst(quad.arg2)
+            && !overflows(ir::evalBinary(quad.op, constOf(quad.arg1), constOf(quad.arg2)))) {
+          auto value = ir::evalBinary(quad.op, constOf(quad.arg1), constOf(quad.arg2));
+          emit(Op::MOVI, def(quad.dst), static_cast<std::int32_t>(value));
+        } else if (isConst(quad.arg2)) {
+          auto lhs = use(quad.arg1);
+          emit(binaryOp(quad.op, true), def(quad.dst), lhs, constOf(quad.arg2));
+        } else {
+          auto lhs = use(quad.arg1);
+          auto rhs = use(quad.arg2);
+          emit(binaryOp(quad.op, false), def(quad.dst), lhs, rhs);
+        }
+        store(quad.dst);
+        break;
+      case ir::IROp::ASSIGN:
+        if (aggregate(quad.dst)) {
+          emit(Op::COPY, slot[quad.dst], slot[quad.arg1], 0, words(func.value(quad.dst)->type));
+          break;
+        }
+        if (isConst(quad.arg1)) {
+          emit(Op::MOVI, def(quad.dst), constOf(quad.arg1));
+        } else {
+          auto src = use(quad.arg1);
+          emit(Op::MOV, def(quad.dst), src);
+        }
+        store(quad.dst);
+        break;
+      case ir::IROp::GOTO:
+        jumps.push_back(insts.size());
+        emit(Op::JMP, static_cast<std::int32_t>(quad.label));
+        break;
+      case ir::IROp::BEQZ: case ir::IROp::BNEZ:
+        if (isConst(quad.arg1)) {
+          if (ir::branchTaken(quad.op, constOf(quad.arg1), 0)) {
+            jumps.push_back(insts.size());
+            emit(Op::JMP, static_cast<std::int32_t>(quad.label));
+          }
+          break;
+        }
+        {
+          auto cond = use(quad.arg1);
+          jumps.push_back(insts.size());
+          emit(quad.op == ir::IROp::BEQZ ? Op::BEQZ : Op::BNEZ, static_cast<std::int32_t>(quad.label), cond);
+        }
+        break;
+      case ir::IROp::BGE: {
+        if (isConst(quad.arg1) && isConst(quad.arg2)) {
+          if (ir::branchTaken(quad.op, constOf(quad.arg1), constOf(quad.arg2))) {
+            jumps.push_back(insts.size());
+            emit(Op::JMP, static_cast<std::int32_t>(quad.label));
+          }
+          break;
+        }
+        auto lhs = use(quad.arg1);
+        if (isConst(quad.arg2)) {
+          jumps.push_back(insts.size());
+          emit(Op::BGEI, static_cast<std::int32_t>(quad.label), lhs, constOf(quad.arg2));
+          break;
+        }
+        auto rhs = use(quad.arg2);
+        jumps.push_back(insts.size());
+        emit(Op::BGE, static_cast<std::int32_t>(quad.label), lhs, rhs);
+        break;
+      }
+      case ir::IROp::INDEX: case ir::IROp::DOT: {
+        auto type = func.value(quad.arg1)->type;
+        if (isConst(quad.arg2)) {
+          auto idx = constOf(quad.arg2);
+          if (idx < 0 || idx >= type->size()) {
+            emit(Op::TRAP, -1); // 同代码生成，越界的访问在运行到时才报告
+            break;
+          }
+          emit(Op::INDEXI, slot[quad.dst], slot[quad.arg1], cg::Aggregates::offsetOf(type, idx) / cg::Aggregates::WORD);
+          break;
+        }
+        // 下标不是常量的只有数组，元素大小都相同
+        auto idx = use(quad.arg2);
+        emit(Op::INDEX, slot[quad.dst], slot[quad.arg1], idx, type->size(), words(type->getElemType()));
+        break;
+      }
+      case ir::IROp::MAKE_ARR: case ir::IROp::MAKE_TUP: {
+        auto type  = func.value(quad.dst)->type;
+        auto elems = func.elems(quad.elems);
+        for (std::size_t k = 0; k < elems.size(); ++k) {
+          auto at = cg::Aggregates::offsetOf(type, static_cast<int>(k)) / cg::Aggregates::WORD;
+          if (aggregate(elems[k])) {
+            emit(Op::COPY, slot[quad.dst], slot[elems[k]], at, words(func.value(elems[k])->type));
+          } else {
+            emit(Op::STORE, slot[quad.dst], use(elems[k]), at);
+          }
+        }
+        break;
+      }
+      case ir::IROp::CALL: {
+        auto callee = index.find(func.label(quad.label));
+        CHECK(callee != index.end(), std::format("can't find function {}", func.label(quad.label)));
+        CHECK(quad.dst == ir::NONE || !aggregate(quad.dst), "functions returning arrays and tuples are not supported");
+        auto elems = func.elems(quad.elems);
+        CHECK(elems.size() == funcs[callee->second]->params.size(),
+          std::format("wrong number of arguments for {}", func.label(quad.label)));
+
+        auto first = static_cast<std::int32_t>(code.args.size());
+        for (auto elem : elems) {
+          auto arg = aggregate(elem) ? slot[elem] : use(elem);
+          code.args.push_back(arg);
+        }
+        auto dst = quad.dst == ir::NONE ? -1 : def(quad.dst);
+        emit(Op::CALL, static_cast<std::int32_t>(callee->second), dst, first, static_cast<std::int32_t>(elems.size()));
+        if (quad.dst != ir::NONE) {
+          store(quad.dst);
+        }
+        break;
+      }
+      case ir::IROp::RETURN:
+        if (quad.arg1 == ir::NONE) {
+          emit(Op::RET, -1);
+          break;
+        }
+        CHECK(!aggregate(quad.arg1), "returning arrays and tuples is not supported");
+        emit(Op::RET, use(quad.arg1));
+        break;
+      case ir::IROp::PROBE:
+        break; // 解释执行时不统计
+    } // end of switch
+  }
+
+  for (auto jump : jumps) {
+    auto &inst = insts[jump];
+    CHECK(labels[inst.a] >= 0, std::format("undefined label {} in {}", func.label(inst.a), func.name));
+    inst.a = labels[inst.a];
+  }
+  // 最后一条四元式总是 return，不会执行到字节码之外
+  code.ready = true;
+  decoded += insts.size();
+}
+
+/**
+ * @brief 从第 entry 个函数开始运行，直到它返回或出错
+ */
+Outcome
+Interpreter::execute(std::size_t entry, std::span<const int> args, const Limits &limits)
+{
+#ifdef INTERP_THREADED
+  static const void *const handlers[] = {
+#define LABEL_ADDR(name) &&L_##name,
+    INTERP_OP_LIST(LABEL_ADDR)
+#undef LABEL_ADDR
+  };
+#endif
+
+  // 首次调用时解码；直接线索化时把指令替换为处理它的代码的地址
+  auto prepare = [&](std::size_t func) {
+    if (codes[func].ready) {
+      return;
+    }
+    decode(func);
+#ifdef INTERP_THREADED
+    for (auto &inst : codes[func].insts) {
+      inst.handler = handlers[static_cast<std::size_t>(inst.op)];
+    }
+#endif
+  };
+
+  // 在 base 处为第 func 个函数建立帧：栈不够时扩大，并复制常量
+  auto enter = [&](std::size_t func, std::size_t base) {
+    const auto &code = codes[func];
+    auto need = base + static_cast<std::size_t>(code.frame);
+    if (need > limits.stack) {
+      return false;
+    }
+    if (need > mem.size()) {
+      mem.resize(std::min(limits.stack, std::max(need, mem.size() * 2)));
+    }
+    std::ranges::copy(code.consts, mem.begin() + static_cast<std::ptrdiff_t>(base));
+    return true;
+  };
+
+  // 调用者的帧
+  struct Frame {
+    std::size_t func;
+    const Inst *call; // 调用指令
+    std::size_t base;
+  };
+  std::vector<Frame> frames;
+
+  Outcome outcome;
+  auto fuel    = limits.fuel;
+  auto checked = limits.checked;
+
+  prepare(entry);
+  CHECK(args.size() == codes[entry].params.size(), std::format("wrong number of arguments for {}", funcs[entry]->name));
+  for (auto param : funcs[entry]->params) {
+    CHECK(!cg::Aggregates::isAggregate(funcs[entry]->value(param)->type),
+      "arrays and tuples can't be passed to the entry function");
+  }
+
+  std::size_t cur  = entry;
+  std::size_t base = 0;
+  if (!enter(entry, base)) {
+    outcome.status = Outcome::Status::STACK_OVERFLOW;
+    outcome.where  = funcs[entry]->name;
+    return outcome;
+  }
+  std::int32_t *m = mem.data();
+  std::int32_t *r = m + base;
+  for (std::size_t k = 0; k < args.size(); ++k) {
+    r[codes[entry].params[k]] = args[k];
+  }
+  const Inst *begin = codes[entry].insts.data();
+  const Inst *pc    = begin;
+
+#ifdef INTERP_THREADED
+#define CASE(name) L_##name:
+#define DISPATCH() goto *pc->handler
+#define NEXT()     ++pc; DISPATCH()
+#else
+#define CASE(name) case Op::name:
+#define DISPATCH() continue
+#define NEXT()     ++pc; continue
+#endif
+
+#define BINARY(name, expr) \
+  CASE(name) { \
+    int x = r[pc->b]; \
+    int y = r[pc->c]; \
+    r[pc->a] = (expr); \
+    NEXT(); \
+  } \
+  CASE(name##I) { \
+    int x = r[pc->b]; \
+    int y = pc->c; \
+    r[pc->a] = (expr); \
+    NEXT(); \
+  }
+
+// 算术运算按 64 位计算，截断为 i32 写回；checked 时超出 i32 即停止
+#define ARITH(name, expr) \
+  CASE(name) { \
+    int x = r[pc->b]; \
+    int y = r[pc->c]; \
+    std::int64_t wide = (expr); \
+    if (checked && overflows(wide)) { \
+      goto overflow; \
+    } \
+    r[pc->a] = static_cast<std::int32_t>(wide); \
+    NEXT(); \
+  } \
+  CASE(name##I) { \
+    int x = r[pc->b]; \
+    int y = pc->c; \
+    std::int64_t wide = (expr); \
+    if (checked && overflows(wide)) { \
+      goto overflow; \
+    } \
+    r[pc->a] = static_cast<std::int32_t>(wide); \
+    NEXT(); \
+  }
+
+#define TAKE_JUMP() \
+  if (fuel-- == 0) { \
+    outcome.status = Outcome::Status::OUT_OF_FUEL; \
+    goto stop; \
+  } \
+  pc = begin + pc->a; \
+  DISPATCH()
+
+#ifdef INTERP_THREADED
+  DISPATCH();
+#else
+  for (;;) switch (pc->op) {
+#endif
+
+  CASE(MOV) {
+    r[pc->a] = r[pc->b];
+    NEXT();
+  }
+  CASE(MOVI) {
+    r[pc->a] = pc->b;
+    NEXT();
+  }
+
+  ARITH(ADD, ir::evalBinary(ir::IROp::ADD, x, y))
+  ARITH(SUB, ir::evalBinary(ir::IROp::SUB, x, y))
+  ARITH(MUL, ir::evalBinary(ir::IROp::MUL, x, y))
+  ARITH(DIV, ir::evalBinary(ir::IROp::DIV, x, y))
+  BINARY(EQ,  static_cast<int>(x == y))
+  BINARY(NEQ, static_cast<int>(x != y))
+  BINARY(GT,  static_cast<int>(x  > y))
+  BINARY(GEQ, static_cast<int>(x >= y))
+  BINARY(LT,  static_cast<int>(x  < y))
+  BINARY(LEQ, static_cast<int>(x <= y))
+
+  CASE(JMP) {
+    TAKE_JUMP();
+  }
+  CASE(BEQZ) {
+    if (r[pc->b] == 0) {
+      TAKE_JUMP();
+    }
+    NEXT();
+  }
+  CASE(BNEZ) {
+    if (r[pc->b] != 0) {
+      TAKE_JUMP();
+    }
+    NEXT();
+  }
+  CASE(BGE) {
+    if (r[pc->b] >= r[pc->c]) {
+      TAKE_JUMP();
+    }
+    NEXT();
+  }
+  CASE(BGEI) {
+    if (r[pc->b] >= pc->c) {
+      TAKE_JUMP();
+    }
+    NEXT();
+  }
+
+  CASE(ADDR) {
+    r[pc->a] = static_cast<std::int32_t>(base) + pc->b;
+    NEXT();
+  }
+  CASE(PARAM) {
+    auto to = static_cast<std::int32_t>(base) + pc->b;
+    std::memmove(m + to, m + r[pc->a], static_cast<std::size_t>(pc->c) * sizeof(std::int32_t));
+    r[pc->a] = to;
+    NEXT();
+  }
+  CASE(INDEX) {
+    auto idx = r[pc->c];
+    if (static_cast<std::uint32_t>(idx) >= static_cast<std::uint32_t>(pc->d)) {
+      outcome.status = Outcome::Status::OUT_OF_BOUNDS;
+      goto stop;
+    }
+    r[pc->a] = r[pc->b] + idx * pc->e;
+    NEXT();
+  }
+  CASE(INDEXI) {
+    r[pc->a] = r[pc->b] + pc->c;
+    NEXT();
+  }
+  CASE(LOAD) {
+    r[pc->a] = m[r[pc->b]];
+    NEXT();
+  }
+  CASE(STORE) {
+    m[r[pc->a] + pc->c] = r[pc->b];
+    NEXT();
+  }
+  CASE(COPY) {
+    std::memmove(m + r[pc->a] + pc->c, m + r[pc->b], static_cast<std::size_t>(pc->d) * sizeof(std::int32_t));
+    NEXT();
+  }
+
+  CASE(CALL) {
+    auto callee = static_cast<std::size_t>(pc->a);
+    auto next   = base + static_cast<std::size_t>(codes[cur].frame);
+    if (fuel-- == 0) {
+      outcome.status = Outcome::Status::OUT_OF_FUEL;
+      goto stop;
+    }
+    prepare(callee);
+    if (!enter(callee, next)) {
+      outcome.status = Outcome::Status::STACK_OVERFLOW;
+      goto stop;
+    }
+    m = mem.data();
+    r = m + base;
+
+    const auto &actual = codes[cur].args;
+    const auto &params = codes[callee].params;
+    auto *callee_r = m + next;
+    for (std::int32_t k = 0; k < pc->d; ++k) {
+      callee_r[params[k]] = r[actual[pc->c + k]];
+    }
+
+    frames.push_back({.func = cur, .call = pc, .base = base});
+    cur   = callee;
+    base  = next;
+    r     = callee_r;
+    begin = codes[callee].insts.data();
+    pc    = begin;
+    DISPATCH();
+  }
+  CASE(RET) {
+    int value = pc->a >= 0 ? r[pc->a] : 0;
+    if (frames.empty()) {
+      outcome.value = value;
+      goto stop;
+    }
+    auto frame = frames.back();
+    frames.pop_back();
+    cur   = frame.func;
+    base  = frame.base;
+    r     = m + base;
+    begin = codes[cur].insts.data();
+    pc    = frame.call;
+    if (pc->b >= 0) {
+      r[pc->b] = value;
+    }
+    NEXT();
+  }
+  CASE(TRAP) {
+    outcome.status = Outcome::Status::OUT_OF_BOUNDS;
+    goto stop;
+  }
+
+#ifndef INTERP_THREADED
+  } // end of switch
+#endif
+
+#undef TAKE_JUMP
+#undef ARITH
+#undef BINARY
+#undef NEXT
+#undef DISPATCH
+#undef CASE
+
+overflow:
+  outcome.status = Outcome::Status::OVERFLOW;
+stop:
+  if (!outcome.ok()) {
+    outcome.where = funcs[cur]->name;
+  }
+  outcome.steps = outcome.status == Outcome::Status::OUT_OF_FUEL ? limits.fuel : limits.fuel - fuel;
+  return outcome;
+}
+
+} // namespace interp
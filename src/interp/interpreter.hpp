@@ -0,0 +1,106 @@
+/**
+ * @file interpreter.hpp
+ * @brief Runs the IR of a program directly (--run), without the RISC-V toolchain.
+ *
+ * The quads of a function are decoded, on its first call, into a compact
+ * bytecode: labels are resolved to instruction indices, every operand is a
+ * slot of the frame's register file (indexed by a per-function renumbering
+ * of the value ids, constants first), and the common forms get their own
+ * instructions (a constant right operand, the load of an element alias
+ * before it is read, the store after it is written). The dispatch loop is
+ * direct-threaded where the compiler supports labels as values (GCC,
+ * Clang): every instruction holds the address of its handler and each
+ * handler jumps straight to the next one; elsewhere it is a switch.
+ *
+ * The semantics follow the code generator, so a program behaves the same
+ * as when it is built with --asm and run in qemu:
+ *   - x / 0 is -1, like the div instruction; comparisons yield 0 or 1
+ *   - i32 arithmetic wraps. The generated code computes in 64-bit registers
+ *     and only truncates when a value is stored, so after an overflow the
+ *     two may disagree; a checked run (Limits::checked) stops at the first
+ *     result that does not fit in i32 instead
+ *   - arrays and tuples are runs of 4-byte words in a word-addressed stack
+ *     (cg::Aggregates) and are passed by value; an element alias (the dst
+ *     of INDEX or DOT) holds the address of the element
+ *   - an index out of bounds stops the program (the ebreak of the
+ *     generated code)
+ *
+ * A run may be limited by fuel (taken jumps and calls) and by the size of
+ * the stack; running out of either stops the run with a status instead of
+ * hanging or crashing the compiler.
+ *
+ * Namespace: interp
+ */
+#pragma once
+
+#include <span>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+#include "func_code.hpp"
+
+namespace interp {
+
+// 一次运行的限制
+struct Limits {
+  std::uint64_t fuel    = std::numeric_limits<std::uint64_t>::max(); // 最多执行的跳转与调用次数
+  std::size_t   stack   = std::size_t{1} << 24;                       // 栈的上限（字）
+  bool          checked = false;                                      // 算术运算的结果超出 i32 时停止
+};
+
+// 一次运行的结果
+struct Outcome {
+  enum class Status : std::uint8_t {
+    OK,             // 正常返回
+    OUT_OF_BOUNDS,  // 数组下标越界
+    STACK_OVERFLOW, // 栈超过 Limits::stack
+    OUT_OF_FUEL,    // 跳转与调用次数超过 Limits::fuel
+    OVERFLOW,       // 算术运算的结果超出 i32（只在 Limits::checked 时）
+  } status = Status::OK;
+
+  int           value = 0; // 返回值（没有返回值的函数为 0）
+  std::uint64_t steps = 0; // 用掉的 fuel（跳转与调用次数）
+  std::string   where;     // 出错时所在的函数
+
+  [[nodiscard]] bool ok() const { return status == Status::OK; }
+};
+
+[[nodiscard]] auto statusStr(Outcome::Status status) -> std::string_view;
+
+class Interpreter {
+public:
+  explicit Interpreter(std::span<const ir::FuncCode *const> funcs);
+  ~Interpreter();
+
+  Interpreter(const Interpreter &) = delete;
+  Interpreter &operator=(const Interpreter &) = delete;
+
+public:
+  [[nodiscard]] auto find(std::string_view name) const -> const ir::FuncCode *;
+
+  auto call(std::string_view name, std::span<const int> args, const Limits &limits = {}) -> Outcome;
+
+  /**
+   * @brief 已经解码的指令条数（所有函数）
+   */
+  [[nodiscard]] std::size_t decodedInsts() const { return decoded; }
+
+private:
+  struct Code;
+
+  void decode(std::size_t func);
+  auto execute(std::size_t entry, std::span<const int> args, const Limits &limits) -> Outcome;
+
+private:
+  std::vector<const ir::FuncCode *>            funcs;
+  std::unordered_map<std::string_view, std::size_t> index; // 函数名 -> funcs 中的下标
+  std::vector<Code>                            codes;   // 与 funcs 一一对应，首次调用时解码
+  std::vector<std::int32_t>                    mem;     // 栈：各帧的寄存器与数组/元组，按字编址
+  std::size_t                                  decoded = 0;
+};
+
+} // namespace interp
@@ -0,0 +1,201 @@
+#include <format>
+#include <algorithm>
+
+#include "cfg.hpp"
+#include "panic.hpp"
+
+namespace ir {
+
+/**
+ * @brief 按基本块划分函数的四元式并建立边
+ * @param code 函数的稠密 IR
+ */
+Function::Function(FuncCode &code) : code(code)
+{
+  for (const auto &quad : code.quads) {
+    bool leader = blocks.empty() || quad.op == IROp::LABEL
+      || blocks.back().terminator() != nullptr;
+    if (leader) {
+      blocks.emplace_back();
+    }
+    blocks.back().quads.push_back(quad);
+  }
+
+  rebuildEdges();
+}
+
+/**
+ * @brief  以指定标号开头的块
+ * @param  label 标号
+ * @return 块的下标
+ */
+BlockId
+Function::labelBlock(LabelId label) const
+{
+  ASSERT_MSG(label < label_blocks.size() && label_blocks[label] != NONE,
+    std::format("label {} is not defined in {}", code.label(label), code.name)
+  );
+  return label_blocks[label];
+}
+
+/**
+ * @brief 根据块尾的跳转与块的布局顺序重新建立前驱、后继
+ * @note  增删块或修改跳转目标之后调用
+ */
+void
+Function::rebuildEdges()
+{
+  label_blocks.assign(code.labelCount(), NONE);
+  for (BlockId id = 0; id < blocks.size(); ++id) {
+    if (auto label = blocks[id].label(); label != NONE) {
+      label_blocks[label] = id;
+    }
+  }
+
+  for (auto &block : blocks) {
+    block.succs.clear();
+    block.preds.clear();
+  }
+
+  for (BlockId id = 0; id < blocks.size(); ++id) {
+    auto &block = blocks[id];
+    if (auto term = block.terminator(); term != nullptr && term->op != IROp::RETURN) {
+      block.succs.push_back(labelBlock(term->label));
+    }
+    if (block.fallsThrough() && id + 1 < blocks.size()) {
+      // 条件跳转的目标恰好是下一个块时只保留一条边
+      if (block.succs.empty() || block.succs.front() != id + 1) {
+        block.succs.push_back(id + 1);
+      }
+    }
+  }
+
+  for (BlockId id = 0; id < blocks.size(); ++id) {
+    for (auto succ : blocks[id].succs) {
+      blocks[succ].preds.push_back(id);
+    }
+  }
+
+  // 不再是前驱的块对应的 φ 参数失效
+  for (auto &block : blocks) {
+    for (auto &phi : block.phis) {
+      std::erase_if(phi.args, [&](const PhiArg &arg) {
+        return std::ranges::find(block.preds, arg.pred) == block.preds.end();
+      });
+    }
+  }
+}
+
+/**
+ * @brief 在布局中的 pos 处插入块，原来位于 pos 及其之后的块依次后移
+ * @note  φ 参数跟随前驱的新下标，边会重建
+ */
+void
+Function::insertBlocks(BlockId pos, std::vector<BasicBlock> added)
+{
+  ASSERT_MSG(pos <= blocks.size(), "insert blocks out of the function");
+
+  auto count = static_cast<BlockId>(added.size());
+  for (auto &block : blocks) {
+    for (auto &phi : block.phis) {
+      for (auto &arg : phi.args) {
+        arg.pred = arg.pred >= pos ? arg.pred + count : arg.pred;
+      }
+    }
+  }
+  blocks.insert(
+    blocks.begin() + static_cast<std::ptrdiff_t>(pos),
+    std::make_move_iterator(added.begin()),
+    std::make_move_iterator(added.end())
+  );
+
+  rebuildEdges();
+}
+
+/**
+ * @brief 删除 dead[i] 为 true 的块，其余块保持原有的布局顺序
+ * @note  被删除的块不能是仍然可达的跳转目标；删除后块的下标会变化，边会重建
+ */
+void
+Function::removeBlocks(const std::vector<bool> &dead)
+{
+  ASSERT_MSG(dead.size() == blocks.size(), "dead marks do not match the blocks");
+  ASSERT_MSG(blocks.empty() || !dead[0], "can't remove the entry block");
+
+  std::vector<BlockId> renumber(blocks.size(), NONE);
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < blocks.size(); ++i) {
+    if (!dead[i]) {
+      renumber[i] = static_cast<BlockId>(kept);
+      if (kept != i) {
+        blocks[kept] = std::move(blocks[i]);
+      }
+      ++kept;
+    }
+  }
+  blocks.resize(kept);
+
+  // φ 参数跟随前驱的新下标，来自被删除的块的参数在 rebuildEdges 中丢弃
+  for (auto &block : blocks) {
+    for (auto &phi : block.phis) {
+      for (auto &arg : phi.args) {
+        arg.pred = renumber[arg.pred];
+      }
+    }
+  }
+
+  rebuildEdges();
+}
+
+/**
+ * @brief 按 order 重新排列块：新布局中的第 i 个块是原来的 order[i]
+ * @note  只改变布局，块尾的跳转不变：调用者要先补上不再顺序相邻的边上的跳转；
+ *        φ 参数跟随前驱的新下标，边会重建
+ */
+void
+Function::reorder(std::span<const BlockId> order)
+{
+  ASSERT_MSG(order.size() == blocks.size(), "layout order does not match the blocks");
+  ASSERT_MSG(blocks.empty() || order[0] == 0, "the entry block must stay first");
+
+  std::vector<BlockId> renumber(blocks.size(), NONE);
+  std::vector<BasicBlock> laid;
+  laid.reserve(blocks.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    ASSERT_MSG(renumber[order[i]] == NONE, "layout order repeats a block");
+    renumber[order[i]] = static_cast<BlockId>(i);
+    laid.push_back(std::move(blocks[order[i]]));
+  }
+  blocks = std::move(laid);
+
+  for (auto &block : blocks) {
+    for (auto &phi : block.phis) {
+      for (auto &arg : phi.args) {
+        arg.pred = renumber[arg.pred];
+      }
+    }
+  }
+
+  rebuildEdges();
+}
+
+/**
+ * @brief 按布局顺序把各块的四元式写回 FuncCode
+ */
+void
+Function::commit()
+{
+  std::size_t n = 0;
+  for (const auto &block : blocks) {
+    ASSERT_MSG(block.phis.empty(), "commit a function that is still in SSA form");
+    n += block.quads.size();
+  }
+
+  code.quads.clear();
+  code.quads.reserve(n);
+  for (const auto &block : blocks) {
+    code.quads.insert(code.quads.end(), block.quads.begin(), block.quads.end());
+  }
+}
+
+} // namespace ir
@@ -0,0 +1,120 @@
+/**
+ * @file cfg.hpp
+ * @brief Basic-block view of one function's dense IR.
+ *
+ * ir::Function splits FuncCode::quads into basic blocks (leaders: the first
+ * quad, every LABEL and every quad following a jump or a return) and links
+ * them by successor/predecessor edges resolved from the label ids. Blocks are
+ * kept in layout order; commit() writes them back to FuncCode::quads, so a
+ * function that no pass changed is written back unchanged.
+ *
+ * In SSA form a block additionally starts with phi functions. They live beside
+ * the quads (FuncCode has no phi quad) and must be removed by the out-of-SSA
+ * pass before commit(); their arguments are keyed by predecessor block and
+ * follow the blocks through rebuildEdges(), insertBlocks(), removeBlocks() and
+ * reorder().
+ *
+ * Namespace: ir
+ */
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include "ir_quad.hpp"
+#include "func_code.hpp"
+
+namespace ir {
+
+using BlockId = std::uint32_t; // 基本块在布局顺序中的下标
+
+inline constexpr bool
+isBranch(IROp op)
+{
+  return op == IROp::BEQZ || op == IROp::BNEZ || op == IROp::BGE;
+}
+
+inline constexpr bool
+isTerminator(IROp op)
+{
+  return op == IROp::GOTO || op == IROp::RETURN || isBranch(op);
+}
+
+// φ 函数的一个参数：从前驱 pred 进入时取值 value
+struct PhiArg {
+  BlockId pred;
+  ValueId value;
+};
+
+// SSA 形式下块首的 φ 函数：dst = φ(args)
+struct Phi {
+  ValueId             dst;
+  std::vector<PhiArg> args;
+};
+
+// 基本块：块首可能是 LABEL（或函数入口的 FUNC），块尾可能是跳转或返回
+struct BasicBlock {
+  std::vector<IRQuad>  quads; // 块内的四元式
+  std::vector<BlockId> succs; // 后继（条件跳转时依次为跳转目标、顺序执行的下一个块）
+  std::vector<BlockId> preds; // 前驱
+  std::vector<Phi>     phis;  // 块首的 φ 函数，只在 SSA 形式下非空
+
+  /**
+   * @brief 块首标号，没有时返回 NONE
+   */
+  [[nodiscard]] LabelId label() const {
+    return !quads.empty() && quads.front().op == IROp::LABEL ? quads.front().label : NONE;
+  }
+
+  /**
+   * @brief 块尾的跳转或返回指令，没有时（顺序落入下一个块）返回 nullptr
+   */
+  [[nodiscard]] const IRQuad *terminator() const {
+    return !quads.empty() && isTerminator(quads.back().op) ? &quads.back() : nullptr;
+  }
+
+  /**
+   * @brief 执行完本块后是否可能顺序执行布局中的下一个块
+   */
+  [[nodiscard]] bool fallsThrough() const {
+    auto term = terminator();
+    return term == nullptr || isBranch(term->op);
+  }
+};
+
+class Function {
+public:
+  explicit Function(FuncCode &code);
+  ~Function() = default;
+
+  Function(const Function &) = delete;
+  Function &operator=(const Function &) = delete;
+
+public:
+  [[nodiscard]] std::size_t size() const { return blocks.size(); }
+
+  [[nodiscard]] BasicBlock &block(BlockId id) { return blocks[id]; }
+  [[nodiscard]] const BasicBlock &block(BlockId id) const { return blocks[id]; }
+
+  [[nodiscard]] std::span<BasicBlock> allBlocks() { return blocks; }
+  [[nodiscard]] std::span<const BasicBlock> allBlocks() const { return blocks; }
+
+  [[nodiscard]] FuncCode &funcCode() { return code; }
+  [[nodiscard]] const FuncCode &funcCode() const { return code; }
+
+  [[nodiscard]] auto labelBlock(LabelId label) const -> BlockId;
+
+  void rebuildEdges();
+  void insertBlocks(BlockId pos, std::vector<BasicBlock> added);
+  void removeBlocks(const std::vector<bool> &dead);
+  void reorder(std::span<const BlockId> order);
+  void commit();
+
+private:
+  FuncCode               &code;   // 侧表（操作数、标号）仍由 FuncCode 持有
+  std::vector<BasicBlock> blocks; // 按布局顺序排列，blocks[0] 为入口
+  std::vector<BlockId>    label_blocks; // LabelId -> 以该标号开头的块，NONE 表示不在本函数中
+};
+
+} // namespace ir
@@ -0,0 +1,111 @@
+/**
+ * @file def_use.hpp
+ * @brief Operands read and written by a quad.
+ *
+ * Every quad writes at most one operand, its dst. It reads arg1, arg2 and the
+ * values of its element list (call arguments, array and tuple elements);
+ * unused fields are NONE and are skipped.
+ *
+ * NOTE: the dst of an INDEX or DOT quad names an element of its arg1, and a
+ *       later assignment to that dst stores into the aggregate. Such values
+ *       are never renamed or removed by the optimization passes.
+ *
+ * Namespace: ir
+ */
+#pragma once
+
+#include "ir_quad.hpp"
+#include "func_code.hpp"
+#include "type_factory.hpp"
+
+namespace ir {
+
+/**
+ * @brief 四元式写入的操作数，没有时为 NONE
+ */
+inline ValueId
+definedValue(const IRQuad &quad)
+{
+  return quad.dst;
+}
+
+/**
+ * @brief 依次访问四元式读取的每个操作数
+ * @param code 四元式所在函数（元素列表保存在它的侧表中）
+ * @param quad 四元式
+ * @param fn   以 ValueId& 为参数，可以就地替换操作数
+ */
+template <typename Fn>
+void
+forEachUse(FuncCode &code, IRQuad &quad, Fn &&fn)
+{
+  if (quad.arg1 != NONE) {
+    fn(quad.arg1);
+  }
+  if (quad.arg2 != NONE) {
+    fn(quad.arg2);
+  }
+  for (auto &elem : code.elems(quad.elems)) {
+    fn(elem);
+  }
+}
+
+/**
+ * @brief 只读版本
+ */
+template <typename Fn>
+void
+forEachUse(const FuncCode &code, const IRQuad &quad, Fn &&fn)
+{
+  if (quad.arg1 != NONE) {
+    fn(quad.arg1);
+  }
+  if (quad.arg2 != NONE) {
+    fn(quad.arg2);
+  }
+  for (auto elem : code.elems(quad.elems)) {
+    fn(elem);
+  }
+}
+
+/**
+ * @brief 值是否可以放在寄存器中（只有 i32 与 bool）
+ */
+inline bool
+isScalar(const sym::Value &value)
+{
+  return value.type == type::TypeFactory::INT_TYPE
+    || value.type == type::TypeFactory::BOOL_TYPE;
+}
+
+/**
+ * @brief 四元式的 dst 是否是数组/元组元素的别名
+ */
+inline bool
+isElemAccess(const IRQuad &quad)
+{
+  return quad.op == IROp::INDEX || quad.op == IROp::DOT;
+}
+
+/**
+ * @brief 四元式除写入 dst 之外是否没有其他作用（结果只依赖于操作数）
+ * @note  向元素别名赋值的 ASSIGN 会写入数组/元组，需要调用者另行排除
+ */
+inline bool
+isPure(const IRQuad &quad)
+{
+  switch (quad.op) {
+    case IROp::ADD: case IROp::SUB:
+    case IROp::MUL: case IROp::DIV:
+    case IROp::EQ:  case IROp::NEQ:
+    case IROp::GT:  case IROp::GEQ:
+    case IROp::LT:  case IROp::LEQ:
+    case IROp::ASSIGN:
+    case IROp::MAKE_ARR: case IROp::MAKE_TUP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace ir
@@ -0,0 +1,125 @@
+/**
+ * @file fold.hpp
+ * @brief Compile-time evaluation of IR operators.
+ *
+ * The generated code keeps i32 arithmetic in 64-bit registers and only
+ * truncates on stores, so a result that does not fit in i32 depends on
+ * where it lives. Such results are not folded, and neither is division by
+ * zero: both are left to run time. Comparisons yield 0 or 1.
+ *
+ * Namespace: ir
+ */
+#pragma once
+
+#include <cstdint>
+#include <variant>
+#include <optional>
+
+#include "symbol.hpp"
+#include "ir_quad.hpp"
+
+namespace ir {
+
+/**
+ * @brief 常量操作数的值，bool 按 0/1 处理
+ */
+inline int
+constValue(const sym::Value &value)
+{
+  const auto &constant = static_cast<const sym::Constant &>(value);
+  if (std::holds_alternative<int>(constant.val)) {
+    return std::get<int>(constant.val);
+  }
+  return std::get<bool>(constant.val) ? 1 : 0;
+}
+
+/**
+ * @brief 四元式是否是二元运算（算术或比较）
+ */
+inline constexpr bool
+isBinary(IROp op)
+{
+  switch (op) {
+    case IROp::ADD: case IROp::SUB:
+    case IROp::MUL: case IROp::DIV:
+    case IROp::EQ:  case IROp::NEQ:
+    case IROp::GT:  case IROp::GEQ:
+    case IROp::LT:  case IROp::LEQ:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief 四元式是否是比较运算
+ */
+inline constexpr bool
+isCompare(IROp op)
+{
+  switch (op) {
+    case IROp::EQ: case IROp::NEQ:
+    case IROp::GT: case IROp::GEQ:
+    case IROp::LT: case IROp::LEQ:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief  二元运算在生成的代码中的结果：算术运算在 64 位寄存器中计算，
+ *         不截断到 i32；除数为 0 时与 div 指令一样为 -1
+ */
+inline std::int64_t
+evalBinary(IROp op, int lhs, int rhs)
+{
+  switch (op) {
+    case IROp::ADD: return std::int64_t{lhs} + rhs;
+    case IROp::SUB: return std::int64_t{lhs} - rhs;
+    case IROp::MUL: return std::int64_t{lhs} * rhs;
+    case IROp::DIV: return rhs == 0 ? -1 : std::int64_t{lhs} / rhs;
+    case IROp::EQ:  return static_cast<int>(lhs == rhs);
+    case IROp::NEQ: return static_cast<int>(lhs != rhs);
+    case IROp::GT:  return static_cast<int>(lhs  > rhs);
+    case IROp::GEQ: return static_cast<int>(lhs >= rhs);
+    case IROp::LT:  return static_cast<int>(lhs  < rhs);
+    case IROp::LEQ: return static_cast<int>(lhs <= rhs);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief  计算二元运算
+ * @return 运算结果；除数为 0 或结果超出 i32 时返回 nullopt
+ */
+inline std::optional<int>
+foldBinary(IROp op, int lhs, int rhs)
+{
+  if (!isBinary(op) || (op == IROp::DIV && rhs == 0)) {
+    return std::nullopt;
+  }
+  auto value = evalBinary(op, lhs, rhs);
+  if (value != static_cast<std::int32_t>(value)) {
+    return std::nullopt;
+  }
+  return static_cast<int>(value);
+}
+
+/**
+ * @brief  条件跳转在给定操作数下是否跳转
+ */
+inline bool
+branchTaken(IROp op, int lhs, int rhs)
+{
+  switch (op) {
+    case IROp::BEQZ: return lhs == 0;
+    case IROp::BNEZ: return lhs != 0;
+    case IROp::BGE:  return lhs >= rhs;
+    default:
+      return false;
+  }
+}
+
+} // namespace ir
@@ -0,0 +1,312 @@
+#include <format>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+#include "func_code.hpp"
+#include "type_factory.hpp"
+
+namespace ir {
+
+namespace {
+
+// print 中代表一个操作数（而不是原样输出的文本）
+struct OperandRef {
+  ValueId id;
+};
+
+} // namespace
+
+/**
+ * @brief  登记一个操作数，同一个 sym::Value 总是得到同一个下标
+ * @param  value 操作数（nullptr 表示没有操作数）
+ * @return 操作数下标
+ */
+ValueId
+FuncCode::addValue(const sym::ValuePtr &value)
+{
+  if (value == nullptr) {
+    return NONE;
+  }
+
+  auto [it, inserted] = value_ids.try_emplace(
+    value.get(), static_cast<ValueId>(values.size())
+  );
+  if (inserted) {
+    values.push_back(value);
+    next_value = std::max(next_value, value->id + 1);
+    if (value->kind == sym::Value::Kind::TEMP) {
+      next_temp = std::max(next_temp, static_cast<const sym::Temp &>(*value).index + 1);
+    }
+  }
+  return it->second;
+}
+
+/**
+ * @brief  创建一个新的临时变量
+ * @param  type 类型
+ * @param  pos  对应的源码位置
+ * @return 操作数下标
+ */
+ValueId
+FuncCode::newTemp(type::TypePtr type, util::Position pos)
+{
+  auto temp = std::make_shared<sym::Temp>();
+  temp->id    = next_value;
+  temp->index = next_temp;
+  temp->pos   = pos;
+  temp->mut   = false;
+  temp->init  = true;
+  temp->type  = type;
+  return addValue(temp);
+}
+
+/**
+ * @brief  为变量创建一个新版本（SSA 重命名）
+ * @param  origin  原变量
+ * @param  version 版本号，用户变量打印为 scope::name.version
+ * @return 操作数下标
+ */
+ValueId
+FuncCode::newVersion(ValueId origin, std::uint32_t version)
+{
+  const auto &value = values[origin];
+  if (value->kind != sym::Value::Kind::LOCAL) {
+    return newTemp(value->type, value->pos);
+  }
+
+  auto var = std::make_shared<sym::Variable>(static_cast<const sym::Variable &>(*value));
+  var->name   = std::format("{}.{}", var->name, version);
+  var->id     = next_value;
+  var->formal = false;
+  var->init   = true;
+  return addValue(var);
+}
+
+/**
+ * @brief  为另一个函数中的值创建一个本函数中的副本（内联时使用）
+ * @note   常量直接共享；局部变量打印为 scope::name.suffix，不再是形参
+ * @param  value  另一个函数的侧表中的值
+ * @param  suffix 副本名字的后缀
+ * @return 操作数下标
+ */
+ValueId
+FuncCode::newCopy(const sym::ValuePtr &value, std::string_view suffix)
+{
+  if (value->isConst()) {
+    return addValue(value);
+  }
+  if (value->kind != sym::Value::Kind::LOCAL) {
+    return newTemp(value->type, value->pos);
+  }
+
+  auto var = std::make_shared<sym::Variable>(static_cast<const sym::Variable &>(*value));
+  var->name   = std::format("{}.{}", var->name, suffix);
+  var->id     = next_value;
+  var->formal = false;
+  return addValue(var);
+}
+
+/**
+ * @brief  创建一个常量（常量折叠的结果），同一函数中相同的常量共享下标
+ * @note   同代码生成一样，比较的结果也用 i32 的 0/1 表示
+ * @param  value 常量值
+ * @return 操作数下标
+ */
+ValueId
+FuncCode::newConst(int value)
+{
+  auto [it, inserted] = folded.try_emplace(value, NONE);
+  if (!inserted) {
+    return it->second;
+  }
+
+  auto constant = std::make_shared<sym::Constant>();
+  constant->id   = next_value;
+  constant->name = std::to_string(value);
+  constant->mut  = false;
+  constant->init = true;
+  constant->type = type::TypeFactory::INT_TYPE;
+  constant->val  = value;
+  it->second = addValue(constant);
+  return it->second;
+}
+
+/**
+ * @brief  登记一个标号，相同的标号共享同一个下标
+ * @param  label 标号
+ * @return 标号下标
+ */
+LabelId
+FuncCode::addLabel(std::string_view label)
+{
+  if (auto it = label_ids.find(label); it != label_ids.end()) {
+    return it->second;
+  }
+
+  auto id = static_cast<LabelId>(labels.size());
+  labels.emplace_back(label);
+  label_ids.emplace(labels.back(), id);
+  return id;
+}
+
+/**
+ * @brief  登记一个元素列表
+ * @param  elems 元素（按顺序）
+ * @return 元素列表下标
+ */
+ElemsId
+FuncCode::addElems(const std::vector<sym::ValuePtr> &elems)
+{
+  auto id = static_cast<ElemsId>(elem_ranges.size());
+  elem_ranges.push_back({
+    static_cast<std::uint32_t>(elem_ids.size()),
+    static_cast<std::uint32_t>(elems.size())
+  });
+  for (const auto &elem : elems) {
+    elem_ids.push_back(addValue(elem));
+  }
+  return id;
+}
+
+/**
+ * @brief  复制一个元素列表（复制四元式时使用，重命名副本的操作数不影响原列表）
+ * @param  id 元素列表下标
+ * @return 新的元素列表下标
+ */
+ElemsId
+FuncCode::copyElems(ElemsId id)
+{
+  if (id == NONE) {
+    return NONE;
+  }
+
+  auto [begin, count] = elem_ranges[id];
+  auto copy = static_cast<ElemsId>(elem_ranges.size());
+  elem_ranges.push_back({static_cast<std::uint32_t>(elem_ids.size()), count});
+  for (std::uint32_t i = 0; i < count; ++i) {
+    elem_ids.push_back(elem_ids[begin + i]);
+  }
+  return copy;
+}
+
+/**
+ * @brief 把操作数的名字追加到 out，没有操作数时为 -
+ */
+void
+FuncCode::printOperand(std::string &out, ValueId id) const
+{
+  if (id == NONE) {
+    out += '-';
+    return;
+  }
+  const auto &value = values[id];
+  switch (value->kind) {
+    case sym::Value::Kind::TEMP:
+      std::format_to(std::back_inserter(out), "%{}", static_cast<const sym::Temp &>(*value).index);
+      break;
+    case sym::Value::Kind::LOCAL: {
+      const auto &var = static_cast<const sym::Variable &>(*value);
+      out.append(var.scopename).append("::").append(var.name);
+      break;
+    }
+    case sym::Value::Kind::CONST:
+      out += value->name;
+      break;
+  }
+}
+
+void
+FuncCode::printElems(std::string &out, ElemsId id) const
+{
+  bool first = true;
+  for (auto elem : elems(id)) {
+    if (!first) {
+      out += ", ";
+    }
+    first = false;
+    printOperand(out, elem);
+  }
+}
+
+/**
+ * @brief 四元式 pretty print，直接格式化到 out 的末尾（不含换行）
+ */
+void
+FuncCode::print(std::string &out, const IRQuad &quad) const
+{
+  // 依次追加各部分：OperandRef 为操作数的名字，其余为原样的文本
+  auto put = [&](const auto &...parts) {
+    auto one = [&](const auto &part) {
+      if constexpr (std::is_same_v<std::decay_t<decltype(part)>, OperandRef>) {
+        printOperand(out, part.id);
+      } else {
+        out += part;
+      }
+    };
+    (one(parts), ...);
+  };
+  OperandRef dst{quad.dst};
+  OperandRef arg1{quad.arg1};
+  OperandRef arg2{quad.arg2};
+
+  switch (quad.op) {
+    case IROp::ADD: case IROp::SUB:
+    case IROp::MUL: case IROp::DIV:
+    case IROp::EQ:  case IROp::NEQ:
+    case IROp::GT:  case IROp::GEQ:
+    case IROp::LT:  case IROp::LEQ:
+      put(dst, " = ", arg1, " ", irop2str(quad.op), " ", arg2);
+      break;
+    case IROp::INDEX:
+      put(dst, " = ", arg1, "[", arg2, "]");
+      break;
+    case IROp::DOT:
+      put(dst, " = ", arg1, ".", arg2);
+      break;
+    case IROp::ASSIGN:
+      put(dst, " = ", arg1);
+      break;
+    case IROp::GOTO:
+      put(irop2str(quad.op), " ", label(quad.label));
+      break;
+    case IROp::CALL:
+      put(dst, " = call ", label(quad.label), "(");
+      printElems(out, quad.elems);
+      put(")");
+      break;
+    case IROp::LABEL: case IROp::FUNC:
+      put(label(quad.label), ":");
+      break;
+    case IROp::BEQZ:
+      put("if ", arg1, " == 0 goto ", label(quad.label));
+      break;
+    case IROp::BNEZ:
+      put("if ", arg1, " != 0 goto ", label(quad.label));
+      break;
+    case IROp::BGE:
+      put("if ", arg1, " >= ", arg2, " goto ", label(quad.label));
+      break;
+    case IROp::RETURN:
+      put("return ", arg1, " -> ", label(quad.label));
+      break;
+    case IROp::MAKE_ARR: case IROp::MAKE_TUP:
+      put(dst, " = ", irop2str(quad.op), "(");
+      printElems(out, quad.elems);
+      put(")");
+      break;
+    case IROp::PROBE:
+      put(irop2str(quad.op), " ", arg1);
+      break;
+  } // end of switch
+}
+
+std::string
+FuncCode::str(const IRQuad &quad) const
+{
+  std::string text;
+  print(text, quad);
+  return text;
+}
+
+} // namespace ir
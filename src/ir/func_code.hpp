@@ -0,0 +1,151 @@
+#pragma once
+
+#include <deque>
+#include <span>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include "symbol.hpp"
+#include "ir_quad.hpp"
+
+namespace type {
+
+struct Type;
+using TypePtr = const Type *;
+
+} // namespace type
+
+namespace ir {
+
+// 剖析数据（--profile-use）中的执行次数：函数入口，以及以各标号开头的块
+struct BlockCounts {
+  std::uint64_t                              entry = 0;
+  std::unordered_map<LabelId, std::uint64_t> labels;
+
+  /**
+   * @brief 以 leader 开头的块的执行次数；没有标号（或标号没有计数）时取布局中上一个块的次数 prev
+   */
+  [[nodiscard]] std::uint64_t at(const IRQuad &leader, std::uint64_t prev) const {
+    if (leader.op == IROp::FUNC) {
+      return entry;
+    }
+    if (auto it = labels.find(leader.label); leader.op == IROp::LABEL && it != labels.end()) {
+      return it->second;
+    }
+    return prev;
+  }
+};
+
+/**
+ * @brief   一个函数的稠密 IR
+ * @details 四元式连续存放在 quads 中；四元式引用的 sym::Value、标号字符串
+ *          和元素列表分别保存在侧表里，通过 32 位下标访问。
+ *          代码生成等后续遍历只需顺序扫描 quads
+ */
+class FuncCode {
+public:
+  explicit FuncCode(std::string name) : name(std::move(name)) {}
+  ~FuncCode() = default;
+
+  FuncCode(const FuncCode &) = delete;
+  FuncCode &operator=(const FuncCode &) = delete;
+
+public:
+  auto addValue(const sym::ValuePtr &value) -> ValueId;
+  auto addLabel(std::string_view label) -> LabelId;
+  auto addElems(const std::vector<sym::ValuePtr> &elems) -> ElemsId;
+
+  // 优化 pass 创建的新值，值编号与 %n 编号接在函数中已有的值之后
+  auto newTemp(type::TypePtr type, util::Position pos) -> ValueId;
+  auto newVersion(ValueId origin, std::uint32_t version) -> ValueId;
+  auto newConst(int value) -> ValueId;
+  auto newCopy(const sym::ValuePtr &value, std::string_view suffix) -> ValueId;
+  auto copyElems(ElemsId id) -> ElemsId;
+
+  /**
+   * @brief 根据下标取回操作数，NONE 对应 nullptr
+   */
+  [[nodiscard]] const sym::ValuePtr &value(ValueId id) const {
+    static const sym::ValuePtr null{};
+    return id == NONE ? null : values[id];
+  }
+
+  /**
+   * @brief 根据下标取回标号
+   */
+  [[nodiscard]] const std::string &label(LabelId id) const {
+    return labels[id];
+  }
+
+  /**
+   * @brief 侧表中的操作数个数、标号个数与元素列表个数
+   */
+  [[nodiscard]] std::size_t valueCount() const { return values.size(); }
+  [[nodiscard]] std::size_t labelCount() const { return labels.size(); }
+  [[nodiscard]] std::size_t elemsCount() const { return elem_ranges.size(); }
+
+  /**
+   * @brief 取回四元式的元素列表（操作数下标）
+   */
+  [[nodiscard]] std::span<const ValueId> elems(ElemsId id) const {
+    if (id == NONE) {
+      return {};
+    }
+    const auto &[begin, count] = elem_ranges[id];
+    return {elem_ids.data() + begin, count};
+  }
+
+  /**
+   * @brief 可修改的元素列表（重命名操作数时使用，长度不变）
+   */
+  [[nodiscard]] std::span<ValueId> elems(ElemsId id) {
+    if (id == NONE) {
+      return {};
+    }
+    const auto &[begin, count] = elem_ranges[id];
+    return {elem_ids.data() + begin, count};
+  }
+
+  void print(std::string &out, const IRQuad &quad) const;
+  [[nodiscard]] auto str(const IRQuad &quad) const -> std::string;
+
+public:
+  std::string          name;   // 函数名
+  std::vector<IRQuad>  quads;  // 按顺序排列的四元式
+  std::vector<ValueId> params; // 形参（按声明顺序），在入口处已经有值
+
+  std::optional<BlockCounts> counts; // 剖析数据中的执行次数（--profile-use），没有时为空
+  LabelId cold = NONE; // 冷块部分（.text.unlikely）开头的标号或函数入口，没有冷块时为 NONE
+
+private:
+  void printOperand(std::string &out, ValueId id) const;
+  void printElems(std::string &out, ElemsId id) const;
+
+private:
+  // 操作数侧表
+  std::vector<sym::ValuePtr> values;
+  std::unordered_map<const sym::Value *, ValueId> value_ids;
+  sym::ValueId next_value = 0; // 大于所有已登记的值编号
+  int          next_temp  = 0; // 大于所有已登记的临时变量编号
+  std::unordered_map<int, ValueId> folded; // newConst 创建的常量
+
+  // 标号侧表（deque 保证字符串地址稳定，可作为 string_view 的键）
+  std::deque<std::string> labels;
+  std::unordered_map<std::string_view, LabelId> label_ids;
+
+  // 元素列表侧表：elem_ranges[i] 是 elem_ids 中的 [begin, begin + count)
+  struct ElemRange {
+    std::uint32_t begin;
+    std::uint32_t count;
+  };
+  std::vector<ElemRange> elem_ranges;
+  std::vector<ValueId>   elem_ids;
+};
+using FuncCodePtr = std::shared_ptr<FuncCode>;
+
+} // namespace ir
@@ -0,0 +1,652 @@
+#include <array>
+#include <deque>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+
+#include "panic.hpp"
+#include "ir_binary.hpp"
+#include "symbol_table.hpp"
+#include "type_factory.hpp"
+
+namespace ir {
+
+namespace {
+
+inline constexpr std::array<char, 4> IRB_MAGIC = {'T', 'I', 'R', 'B'};
+inline constexpr std::uint32_t       IRB_ORDER = 0x01020304; // 按写出方的字节序保存
+
+struct Header {
+  std::array<char, 4> magic;
+  std::uint32_t       version;
+  std::uint32_t       order;
+  std::uint32_t       strings;      // 字符串个数
+  std::uint32_t       string_bytes; // 所有字符串的总长度
+  std::uint32_t       types;        // 类型个数
+  std::uint32_t       type_elems;   // 元组元素表的长度
+  std::uint32_t       funcs;        // 函数个数
+};
+
+// 数组：size 为长度，elem 为元素类型；元组：size 为元素个数，elem 为其在元组元素表中的起点
+struct TypeRecord {
+  std::uint8_t  kind;
+  std::uint8_t  pad[3] = {};
+  std::int32_t  size   = 0;
+  std::uint32_t elem   = NONE;
+};
+
+struct FuncHeader {
+  std::uint32_t name;
+  std::uint32_t ret;      // 返回值类型
+  std::uint32_t values;
+  std::uint32_t labels;
+  std::uint32_t params;
+  std::uint32_t elems;    // 元素列表个数
+  std::uint32_t elem_ids; // 所有元素列表的总长度
+  std::uint32_t quads;
+  std::uint32_t cold;     // FuncCode::cold
+  std::uint32_t counted;  // 有执行次数的标号个数，没有剖析数据时为 NONE
+  std::uint64_t entry;    // 函数入口的执行次数
+};
+
+enum ValueFlag : std::uint8_t {
+  MUT    = 1,
+  INIT   = 2,
+  FORMAL = 4, // 形参
+  BOOL   = 8, // bool 常量
+};
+
+// data：临时变量的编号或常量的值
+struct ValueRecord {
+  std::uint8_t  kind;
+  std::uint8_t  flags = 0;
+  std::uint16_t pad   = 0;
+  std::uint32_t name;
+  std::uint32_t scope = NONE; // 局部变量所在作用域的限定名
+  std::uint32_t type;
+  std::int32_t  data  = 0;
+  std::uint32_t row;
+  std::uint32_t col;
+};
+
+struct CountRecord {
+  std::uint32_t label;
+  std::uint32_t pad = 0;
+  std::uint64_t count;
+};
+
+static_assert(std::is_trivially_copyable_v<IRQuad>, "quads are written as raw bytes");
+
+/**
+ * @brief 把定长记录以原样的字节追加到 buf
+ */
+template <typename T>
+void
+put(std::string &buf, const T &value)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+void
+putArray(std::string &buf, std::span<const T> values)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  buf.append(reinterpret_cast<const char *>(values.data()), values.size_bytes());
+}
+
+class Writer {
+public:
+  explicit Writer(const sym::SymbolTable &symtab) : symtab(symtab) {}
+
+public:
+  void write(std::ostream &out, std::span<const FuncCode *const> funcs);
+
+private:
+  auto str(std::string_view text) -> std::uint32_t;
+  auto typeOf(type::TypePtr type) -> std::uint32_t;
+  void func(const FuncCode &code);
+
+private:
+  const sym::SymbolTable &symtab;
+
+  std::deque<std::string> strings; // deque 保证字符串地址稳定，可作为 string_view 的键
+  std::unordered_map<std::string_view, std::uint32_t> string_ids;
+
+  std::vector<TypeRecord>    types;
+  std::vector<std::uint32_t> type_elems;
+  std::unordered_map<type::TypeId, std::uint32_t> type_ids;
+
+  std::string body; // 各函数的部分，字符串表与类型表在写完所有函数之后才完整
+};
+
+void
+Writer::write(std::ostream &out, std::span<const FuncCode *const> funcs)
+{
+  for (const auto *code : funcs) {
+    func(*code);
+  }
+
+  std::string head;
+  std::uint32_t string_bytes = 0;
+  for (const auto &text : strings) {
+    string_bytes += static_cast<std::uint32_t>(text.size());
+  }
+  put(head, Header{
+    .magic        = IRB_MAGIC,
+    .version      = IRB_VERSION,
+    .order        = IRB_ORDER,
+    .strings      = static_cast<std::uint32_t>(strings.size()),
+    .string_bytes = string_bytes,
+    .types        = static_cast<std::uint32_t>(types.size()),
+    .type_elems   = static_cast<std::uint32_t>(type_elems.size()),
+    .funcs        = static_cast<std::uint32_t>(funcs.size()),
+  });
+  std::uint32_t end = 0;
+  for (const auto &text : strings) {
+    end += static_cast<std::uint32_t>(text.size());
+    put(head, end);
+  }
+  for (const auto &text : strings) {
+    head += text;
+  }
+  putArray<TypeRecord>(head, types);
+  putArray<std::uint32_t>(head, type_elems);
+
+  out.write(head.data(), static_cast<std::streamsize>(head.size()));
+  out.write(body.data(), static_cast<std::streamsize>(body.size()));
+}
+
+/**
+ * @brief 字符串在字符串表中的下标，相同的字符串只保存一次
+ */
+std::uint32_t
+Writer::str(std::string_view text)
+{
+  if (auto it = string_ids.find(text); it != string_ids.end()) {
+    return it->second;
+  }
+  auto id = static_cast<std::uint32_t>(strings.size());
+  strings.emplace_back(text);
+  string_ids.emplace(strings.back(), id);
+  return id;
+}
+
+/**
+ * @brief 类型在类型表中的下标；复合类型的元素先登记
+ */
+std::uint32_t
+Writer::typeOf(type::TypePtr type)
+{
+  if (auto it = type_ids.find(type->id); it != type_ids.end()) {
+    return it->second;
+  }
+
+  TypeRecord record{.kind = static_cast<std::uint8_t>(type->kind)};
+  if (type->kind == type::TypeKind::ARRAY) {
+    const auto &array = static_cast<const type::ArrayType &>(*type);
+    record.size = array.m_size;
+    record.elem = typeOf(array.etype);
+  } else if (type->kind == type::TypeKind::TUPLE) {
+    const auto &tuple = static_cast<const type::TupleType &>(*type);
+    std::vector<std::uint32_t> elems;
+    for (auto etype : tuple.etypes) {
+      elems.push_back(typeOf(etype));
+    }
+    record.size = static_cast<std::int32_t>(elems.size());
+    record.elem = static_cast<std::uint32_t>(type_elems.size());
+    type_elems.insert(type_elems.end(), elems.begin(), elems.end());
+  }
+
+  auto id = static_cast<std::uint32_t>(types.size());
+  types.push_back(record);
+  type_ids.emplace(type->id, id);
+  return id;
+}
+
+void
+Writer::func(const FuncCode &code)
+{
+  auto funcsym = symtab.lookupFunc(code.name);
+  CHECK(funcsym.has_value(), "can't find function symbol");
+
+  std::uint32_t elem_ids = 0;
+  for (ElemsId id = 0; id < code.elemsCount(); ++id) {
+    elem_ids += static_cast<std::uint32_t>(code.elems(id).size());
+  }
+  put(body, FuncHeader{
+    .name     = str(code.name),
+    .ret      = typeOf(funcsym.value()->type),
+    .values   = static_cast<std::uint32_t>(code.valueCount()),
+    .labels   = static_cast<std::uint32_t>(code.labelCount()),
+    .params   = static_cast<std::uint32_t>(code.params.size()),
+    .elems    = static_cast<std::uint32_t>(code.elemsCount()),
+    .elem_ids = elem_ids,
+    .quads    = static_cast<std::uint32_t>(code.quads.size()),
+    .cold     = code.cold,
+    .counted  = code.counts ? static_cast<std::uint32_t>(code.counts->labels.size()) : NONE,
+    .entry    = code.counts ? code.counts->entry : 0,
+  });
+
+  for (ValueId id = 0; id < code.valueCount(); ++id) {
+    const auto &value = *code.value(id);
+    ValueRecord record{
+      .kind  = static_cast<std::uint8_t>(value.kind),
+      .flags = static_cast<std::uint8_t>((value.mut ? MUT : 0) | (value.init ? INIT : 0)),
+      .name  = str(value.name),
+      .type  = typeOf(value.type),
+      .row   = static_cast<std::uint32_t>(value.pos.row),
+      .col   = static_cast<std::uint32_t>(value.pos.col),
+    };
+    switch (value.kind) {
+      case sym::Value::Kind::TEMP:
+        record.data = static_cast<const sym::Temp &>(value).index;
+        break;
+      case sym::Value::Kind::LOCAL: {
+        const auto &var = static_cast<const sym::Variable &>(value);
+        record.flags |= var.formal ? FORMAL : 0;
+        record.scope  = str(var.scopename);
+        break;
+      }
+      case sym::Value::Kind::CONST: {
+        const auto &val = static_cast<const sym::Constant &>(value).val;
+        if (const auto *flag = std::get_if<bool>(&val); flag != nullptr) {
+          record.flags |= BOOL;
+          record.data   = *flag ? 1 : 0;
+        } else {
+          record.data = std::get<int>(val);
+        }
+        break;
+      }
+    }
+    put(body, record);
+  }
+
+  for (LabelId id = 0; id < code.labelCount(); ++id) {
+    put(body, str(code.label(id)));
+  }
+  putArray<ValueId>(body, code.params);
+  for (ElemsId id = 0; id < code.elemsCount(); ++id) {
+    put(body, static_cast<std::uint32_t>(code.elems(id).size()));
+  }
+  for (ElemsId id = 0; id < code.elemsCount(); ++id) {
+    putArray<ValueId>(body, code.elems(id));
+  }
+  if (code.counts) {
+    std::vector<CountRecord> records;
+    for (const auto &[label, count] : code.counts->labels) {
+      records.push_back({.label = label, .count = count});
+    }
+    std::ranges::sort(records, {}, &CountRecord::label);
+    putArray<CountRecord>(body, records);
+  }
+
+  // op 之后的填充字节清零，同样的 IR 总是写出同样的字节
+  for (const auto &quad : code.quads) {
+    IRQuad clean;
+    std::memset(&clean, 0, sizeof(clean));
+    clean.op    = quad.op;
+    clean.arg1  = quad.arg1;
+    clean.arg2  = quad.arg2;
+    clean.dst   = quad.dst;
+    clean.label = quad.label;
+    clean.elems = quad.elems;
+    put(body, clean);
+  }
+}
+
+// 按顺序读出定长记录；越过末尾时返回 false
+class Reader {
+public:
+  explicit Reader(std::string_view data) : data(data) {}
+
+public:
+  template <typename T>
+  bool get(T &value) {
+    if (data.size() - pos < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  template <typename T>
+  bool get(std::vector<T> &values, std::size_t n) {
+    if (n > (data.size() - pos) / sizeof(T)) {
+      return false;
+    }
+    values.resize(n);
+    std::memcpy(values.data(), data.data() + pos, n * sizeof(T));
+    pos += n * sizeof(T);
+    return true;
+  }
+
+  /**
+   * @brief 接下来的 n 个字节，不复制
+   */
+  auto bytes(std::size_t n) -> std::optional<std::string_view> {
+    if (data.size() - pos < n) {
+      return std::nullopt;
+    }
+    pos += n;
+    return data.substr(pos - n, n);
+  }
+
+  [[nodiscard]] bool done() const { return pos == data.size(); }
+
+private:
+  std::string_view data;
+  std::size_t      pos = 0;
+};
+
+class Loader {
+public:
+  Loader(std::string_view data, type::TypeFactory &types, sym::SymbolTable &symtab)
+    : in(data), factory(types), symtab(symtab) {}
+
+public:
+  auto load() -> std::optional<std::vector<FuncCodePtr>>;
+
+private:
+  bool loadStrings(const Header &header);
+  bool loadTypes(const Header &header);
+  auto loadFunc() -> FuncCodePtr;
+  auto loadValue(const ValueRecord &record) -> sym::ValuePtr;
+  static bool validQuad(const FuncCode &code, const IRQuad &quad);
+
+private:
+  Reader             in;
+  type::TypeFactory &factory;
+  sym::SymbolTable  &symtab;
+
+  std::vector<std::string_view> strings; // 指向映射的文件
+  std::vector<type::TypePtr>    types;
+};
+
+std::optional<std::vector<FuncCodePtr>>
+Loader::load()
+{
+  Header header{};
+  if (!in.get(header) || header.magic != IRB_MAGIC || header.version != IRB_VERSION
+    || header.order != IRB_ORDER || !loadStrings(header) || !loadTypes(header))
+  {
+    return std::nullopt;
+  }
+
+  std::vector<FuncCodePtr> funcs;
+  for (std::uint32_t i = 0; i < header.funcs; ++i) {
+    auto code = loadFunc();
+    if (code == nullptr) {
+      return std::nullopt;
+    }
+    funcs.push_back(std::move(code));
+  }
+  if (!in.done()) {
+    return std::nullopt;
+  }
+  return funcs;
+}
+
+bool
+Loader::loadStrings(const Header &header)
+{
+  std::vector<std::uint32_t> ends;
+  auto text = in.get(ends, header.strings) ? in.bytes(header.string_bytes) : std::nullopt;
+  if (!text.has_value()) {
+    return false;
+  }
+
+  std::uint32_t begin = 0;
+  for (auto end : ends) {
+    if (end < begin || end > text->size()) {
+      return false;
+    }
+    strings.push_back(text->substr(begin, end - begin));
+    begin = end;
+  }
+  return true;
+}
+
+/**
+ * @brief 读出类型表并在 factory 中驻留；元素类型总在使用它的类型之前
+ */
+bool
+Loader::loadTypes(const Header &header)
+{
+  std::vector<TypeRecord>    records;
+  std::vector<std::uint32_t> elems;
+  if (!in.get(records, header.types) || !in.get(elems, header.type_elems)) {
+    return false;
+  }
+
+  for (const auto &record : records) {
+    switch (static_cast<type::TypeKind>(record.kind)) {
+      case type::TypeKind::I32:     types.push_back(type::TypeFactory::INT_TYPE);     break;
+      case type::TypeKind::BOOL:    types.push_back(type::TypeFactory::BOOL_TYPE);    break;
+      case type::TypeKind::UNIT:    types.push_back(type::TypeFactory::UNIT_TYPE);    break;
+      case type::TypeKind::UNKNOWN: types.push_back(type::TypeFactory::UNKNOWN_TYPE); break;
+      case type::TypeKind::ANY:     types.push_back(type::TypeFactory::ANY_TYPE);     break;
+      case type::TypeKind::ARRAY:
+        if (record.elem >= types.size() || record.size < 0) {
+          return false;
+        }
+        types.push_back(factory.getArray(record.size, types[record.elem]));
+        break;
+      case type::TypeKind::TUPLE: {
+        if (record.size < 0 || record.elem > elems.size()
+          || static_cast<std::size_t>(record.size) > elems.size() - record.elem)
+        {
+          return false;
+        }
+        std::vector<type::TypePtr> etypes;
+        for (std::int32_t k = 0; k < record.size; ++k) {
+          auto elem = elems[record.elem + k];
+          if (elem >= types.size()) {
+            return false;
+          }
+          etypes.push_back(types[elem]);
+        }
+        types.push_back(factory.getTuple(etypes));
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief  读出一个函数，并在符号表中声明它
+ * @return 文件损坏时为 nullptr
+ */
+FuncCodePtr
+Loader::loadFunc()
+{
+  FuncHeader header{};
+  if (!in.get(header) || header.name >= strings.size() || header.ret >= types.size()) {
+    return nullptr;
+  }
+  auto name = strings[header.name];
+  if (symtab.lookupFunc(name).has_value()) {
+    return nullptr;
+  }
+  auto code = std::make_shared<FuncCode>(std::string{name});
+
+  std::vector<ValueRecord> values;
+  if (!in.get(values, header.values)) {
+    return nullptr;
+  }
+  for (const auto &record : values) {
+    auto value = loadValue(record);
+    if (value == nullptr) {
+      return nullptr;
+    }
+    code->addValue(value);
+  }
+
+  std::vector<std::uint32_t> labels;
+  if (!in.get(labels, header.labels)) {
+    return nullptr;
+  }
+  for (std::uint32_t i = 0; i < labels.size(); ++i) {
+    if (labels[i] >= strings.size() || code->addLabel(strings[labels[i]]) != i) {
+      return nullptr;
+    }
+  }
+
+  std::vector<std::uint32_t> counts;
+  std::vector<ValueId>       elem_ids;
+  if (!in.get(code->params, header.params) || !in.get(counts, header.elems)
+    || !in.get(elem_ids, header.elem_ids))
+  {
+    return nullptr;
+  }
+  auto next = elem_ids.begin();
+  for (auto count : counts) {
+    if (count > static_cast<std::size_t>(elem_ids.end() - next)) {
+      return nullptr;
+    }
+    std::vector<sym::ValuePtr> elems;
+    for (auto id : std::span{next, count}) {
+      if (id >= code->valueCount()) {
+        return nullptr;
+      }
+      elems.push_back(code->value(id));
+    }
+    code->addElems(elems);
+    next += count;
+  }
+
+  if (header.counted != NONE) {
+    std::vector<CountRecord> records;
+    if (!in.get(records, header.counted)) {
+      return nullptr;
+    }
+    code->counts.emplace();
+    code->counts->entry = header.entry;
+    for (const auto &record : records) {
+      if (record.label >= code->labelCount()) {
+        return nullptr;
+      }
+      code->counts->labels.insert_or_assign(record.label, record.count);
+    }
+  }
+
+  if (!in.get(code->quads, header.quads) || (header.cold != NONE && header.cold >= code->labelCount())) {
+    return nullptr;
+  }
+  for (const auto &quad : code->quads) {
+    if (!validQuad(*code, quad)) {
+      return nullptr;
+    }
+  }
+  code->cold = header.cold;
+
+  auto funcsym = std::make_shared<sym::Function>();
+  funcsym->name = code->name;
+  funcsym->type = types[header.ret];
+  for (auto param : code->params) {
+    if (param >= code->valueCount()) {
+      return nullptr;
+    }
+    funcsym->argv.push_back(code->value(param));
+  }
+  symtab.declareFunc(symtab.getInterner().intern(code->name), std::move(funcsym));
+  return code;
+}
+
+/**
+ * @brief 按记录新建一个值，使用符号表分配的新编号；记录无效时为 nullptr
+ */
+sym::ValuePtr
+Loader::loadValue(const ValueRecord &record)
+{
+  if (record.name >= strings.size() || record.type >= types.size()) {
+    return nullptr;
+  }
+
+  sym::ValuePtr value;
+  switch (static_cast<sym::Value::Kind>(record.kind)) {
+    case sym::Value::Kind::TEMP: {
+      auto temp = std::make_shared<sym::Temp>();
+      temp->index = record.data;
+      value = std::move(temp);
+      break;
+    }
+    case sym::Value::Kind::LOCAL: {
+      if (record.scope >= strings.size()) {
+        return nullptr;
+      }
+      auto var = std::make_shared<sym::Variable>();
+      var->formal    = (record.flags & FORMAL) != 0;
+      var->scopename = strings[record.scope];
+      value = std::move(var);
+      break;
+    }
+    case sym::Value::Kind::CONST: {
+      auto constant = std::make_shared<sym::Constant>();
+      if ((record.flags & BOOL) != 0) {
+        constant->val = record.data != 0;
+      } else {
+        constant->val = record.data;
+      }
+      value = std::move(constant);
+      break;
+    }
+    default:
+      return nullptr;
+  }
+
+  value->name = strings[record.name];
+  value->pos  = {record.row, record.col};
+  value->mut  = (record.flags & MUT) != 0;
+  value->init = (record.flags & INIT) != 0;
+  value->id   = symtab.newValueId();
+  value->type = types[record.type];
+  value->frameaddr = 0;
+  return value;
+}
+
+/**
+ * @brief 四元式的操作码与各下标是否在所在函数的侧表之内
+ */
+bool
+Loader::validQuad(const FuncCode &code, const IRQuad &quad)
+{
+  auto fits = [](std::uint32_t id, std::size_t size) { return id == NONE || id < size; };
+  return static_cast<std::uint8_t>(quad.op) <= static_cast<std::uint8_t>(IROp::PROBE)
+    && fits(quad.arg1, code.valueCount()) && fits(quad.arg2, code.valueCount())
+    && fits(quad.dst, code.valueCount()) && fits(quad.label, code.labelCount())
+    && fits(quad.elems, code.elemsCount());
+}
+
+} // namespace
+
+/**
+ * @brief 把各函数（优化之后）的 IR 写成二进制文件
+ * @param funcs  按声明顺序排列的函数
+ * @param symtab 查询各函数的返回值类型
+ */
+void
+writeBinary(std::ostream &out, std::span<const FuncCode *const> funcs, const sym::SymbolTable &symtab)
+{
+  Writer{symtab}.write(out, funcs);
+}
+
+/**
+ * @brief  读入二进制 IR，复合类型驻留到 types 中，各函数声明到 symtab 中
+ * @param  data 文件内容（通常是 mmap 映射的内存）
+ * @return 按声明顺序排列的函数；不是同一版本的文件或文件损坏时为空
+ */
+std::optional<std::vector<FuncCodePtr>>
+readBinary(std::string_view data, type::TypeFactory &types, sym::SymbolTable &symtab)
+{
+  return Loader{data, types, symtab}.load();
+}
+
+} // namespace ir
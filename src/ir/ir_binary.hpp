@@ -0,0 +1,59 @@
+/**
+ * @file ir_binary.hpp
+ * @brief Versioned binary IR files (--emit-ir-bin, --from-ir-bin).
+ *
+ * The text .ir output is for people and can't be read back. A .irb file
+ * holds the optimized IR of every function of a program, so the front end
+ * and the code generator can run as separate processes (or on separate
+ * machines), and the IR itself can be cached or shipped between build stages.
+ *
+ * Layout (host byte order; the header records it and a reader on the other
+ * byte order rejects the file):
+ *
+ *   Header        magic "TIRB", version, byte order mark, table sizes
+ *   strings       end offset of every string, then the characters; names of
+ *                 functions, values, scopes and labels refer to it by index
+ *   types         one record per type, elements before the types using them;
+ *                 the element lists of tuples follow as one array of indices
+ *   functions     per function: a FuncHeader, the value table, the labels,
+ *                 the parameters, the element lists, the profile counts and
+ *                 the quads as the in-memory ir::IRQuad array
+ *
+ * Every table is a flat array of fixed-size records, so the reader works
+ * directly on the mapped file (util::SourceBuffer): strings are views into
+ * the mapping until a FuncCode takes a copy, and a function's quads are
+ * copied into its vector in one block. Every index is checked against its
+ * table, so a truncated or corrupt file is rejected instead of crashing the
+ * code generator.
+ *
+ * Reading declares a sym::Function (return type and parameters) for every
+ * function in the given symbol table and gives every value a fresh dense id,
+ * which is all the code generator looks up outside the FuncCode.
+ *
+ * Namespace: ir
+ */
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <optional>
+#include <string_view>
+
+#include "func_code.hpp"
+
+namespace sym { class SymbolTable; }
+
+namespace type { class TypeFactory; }
+
+namespace ir {
+
+inline constexpr std::uint32_t IRB_VERSION = 1; // 格式改变时加一，不兼容旧的文件
+
+void writeBinary(std::ostream &out, std::span<const FuncCode *const> funcs, const sym::SymbolTable &symtab);
+
+[[nodiscard]] auto readBinary(std::string_view data, type::TypeFactory &types, sym::SymbolTable &symtab)
+  -> std::optional<std::vector<FuncCodePtr>>;
+
+} // namespace ir
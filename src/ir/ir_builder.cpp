@@ -5,14 +5,14 @@
  *
  * This file contains the implementation of the IRBuilder class,
  * which traverses the abstract syntax tree (AST)
- * and generates a flat vector of IR quads for each node.
- * The IRBuilder uses modern C++ features such as ranges,
- * concepts, and perfect forwarding to efficiently concatenate
- * and transform IR code sequences.
+ * and generates a list of IR quads for each node.
+ * Child code is spliced into the parent's list instead of being copied,
+ * so every quad is created once and IR generation is linear
+ * in program size.
  *
  * Key Features:
- * - Provides utility functions for concatenating multiple IR code vectors
- *   and extracting IR code from AST node ranges.
+ * - Provides utility functions for splicing IR code lists
+ *   of child nodes into their parent.
  * - Implements visit methods for various AST node types,
  *   handling code generation for functions, statements, expressions,
  *   control flow constructs (if, while, for, loop),
@@ -20,8 +20,9 @@
  * - Handles desugaring of language constructs,
  *   such as implicit returns and block expressions.
  * - Ensures type safety and efficient IR code construction
- *   using C++20 concepts and ranges.
+ *   using C++20 concepts and std::list::splice.
  */
+#include <list>
 #include <ranges>
 #include <vector>
 
@@ -36,73 +37,41 @@ namespace ir {
 IRBuilder::IRBuilder(sem::SemanticContext &ctx) : ctx(ctx) {}
 
 /**
- * @brief 拼接多个 IR 代码序列为一个扁平的 IR 代码向量
+ * @brief 依次将多个 IR 代码序列拼接到 dst 的末尾
  *
- * 本函数接受任意个 std::vector<IRQuadPtr> 类型的参数（支持左值、右值、临时对象），
- * 并将它们按顺序拼接为一个新的 vector，返回该扁平化的结果。
+ * 通过 std::list::splice 移动链表结点，每个序列的拼接都是 O(1) 的，
+ * 因此无论语句块嵌套多深，每条四元式在生成过程中都只会被创建一次，不会被复制。
  *
- * @tparam Vecs 任意多个 std::vector<IRQuadPtr> 类型的参数（可以为左值或右值）
- * @param  vecs 要拼接的 IR 代码序列容器列表
- * @return 拼接后的 std::vector<IRQuadPtr>
- *
- * @note
- * - 使用了变参模板 + concepts + decay，确保传入的每个参数类型为 std::vector<IRQuadPtr>。
- * - 利用 ranges::views::concat 进行懒惰拼接，并使用 ranges::to 生成最终 vector。
- * - 相比手动 insert，更简洁、类型安全，支持完美转发。
+ * @tparam Codes 任意多个 IRCode 类型的参数
+ * @param  dst   目标序列
+ * @param  codes 被拼接的序列，拼接后为空
  *
  * 示例：
- *   auto result = concatIrcode(code1, std::move(code2), std::vector<IRQuadPtr>{...});
+ *   appendIrcode(aexpr.ircode, aexpr.lhs->ircode, aexpr.rhs->ircode);
  */
-template <typename... Vecs>
-  // decay 可以将 Vecs 的所有 const, &, volatile 等修饰符剥去
-  // 这样可以让本函数接受左值、右值、const、临时变量等不同类型的 vector 参数，
-  // 提高了接口的灵活性和泛用性，便于在不同上下文中高效拼接 IR 代码序列。
-requires (std::same_as<std::decay_t<Vecs>, std::vector<IRQuadPtr>> && ...)
-static std::vector<IRQuadPtr>
-concatIrcode(Vecs&&... vecs)
-{
-  // 变长参数模板中如何对参数进行展开是一个非常关键的问题，
-  // 这里使用折叠表达式（左折叠）对变长参数进行展开
-  return std::views::concat(std::forward<Vecs>(vecs)...)
-    | std::ranges::to<std::vector>();
+template <typename... Codes>
+requires (std::same_as<std::decay_t<Codes>, IRCode> && ...)
+static void
+appendIrcode(IRCode &dst, Codes&&... codes)
+{
+  // 折叠表达式（逗号运算符）按参数顺序展开
+  (dst.splice(dst.end(), codes), ...);
 }
 
 /**
- * @brief Concept to check if a type provides IR code generation.
- *
- * This concept is satisfied if the given type `T` has a member `ircode`
- * accessible via pointer dereference (`node -> ircode`), and the type of
- * `ircode` is convertible to `std::vector<IRQuadPtr>`.
+ * @brief 按顺序将一组 AST 结点的 IR 代码拼接到 dst 的末尾
  *
- * @tparam T The type to check for IR code generation capability.
- */
-template <typename T>
-concept HasIRCode = requires(const T &node) {
-  { node->ircode } -> std::convertible_to<std::vector<IRQuadPtr>>;
-};
-
-/**
- * @brief Extracts and concatenates IR code from a range of AST nodes.
- *
- * This function takes a range of AST nodes, each of which must have an `ircode` member
- * (as required by the `HasIRCode` concept). It transforms the range by extracting the
- * `ircode` from each node, flattens the resulting range of IR code sequences, and
- * collects all IR quads into a single `std::vector<IRQuadPtr>`.
- *
- * @tparam ASTNodeRange A range type whose value type satisfies the `HasIRCode` concept.
- * @param nodes The range of AST nodes to process.
- * @return std::vector<IRQuadPtr> A vector containing all IR quads from all nodes, concatenated.
+ * @tparam ASTNodeRange 元素为 AST 结点指针的 range
+ * @param  dst   目标序列
+ * @param  nodes AST 结点，拼接后各结点的 ircode 为空
  */
 template <std::ranges::range ASTNodeRange>
-  requires HasIRCode<std::ranges::range_value_t<ASTNodeRange>>
-static std::vector<IRQuadPtr>
-extractIrcodeAndConcat(const ASTNodeRange &nodes) {
-  return nodes
-    | std::views::transform([](const auto &node) {
-        return node->ircode;
-      })                              // transform
-    | std::views::join                // flatten
-    | std::ranges::to<std::vector>(); // collect
+static void
+spliceIrcode(IRCode &dst, const ASTNodeRange &nodes)
+{
+  for (const auto &node : nodes) {
+    dst.splice(dst.end(), node->ircode);
+  }
 }
 
 /**
@@ -113,7 +82,8 @@ extractIrcodeAndConcat(const ASTNodeRange &nodes) {
 void
 IRBuilder::visit(ast::Prog &prog)
 {
-  prog.ircode = extractIrcodeAndConcat(prog.decls);
+  // 各函数的 IR 保存在对应 FuncDecl 结点的 FuncCode 中，
+  // 代码生成与打印都按函数遍历，无需再拼接为一个整体
 }
 
 /**
@@ -137,7 +107,7 @@ IRBuilder::visit(ast::Prog &prog)
 void
 IRBuilder::visit(ast::FuncDecl &fdecl)
 {
-  std::vector<IRQuadPtr> retcode;
+  IRCode retcode;
   if (!fdecl.body->has_ret
     && fdecl.header->type.type == type::TypeFactory::UNIT_TYPE)
   {
@@ -146,11 +116,11 @@ IRBuilder::visit(ast::FuncDecl &fdecl)
     //       或有路径覆盖的 if 语句/loop 语句。这个意义上来讲，并不是递归检查到
     //       一条返回语句就认为有返回语句，而是路径覆盖意义上的有返回语句！
     if (fdecl.body->ircode.empty()
-      || fdecl.body->ircode.back()->op != IROp::RETURN)
+      || fdecl.body->ircode.back().op != IROp::RETURN)
     {
       // 函数体可能为空！
       retcode.push_back(
-        QuadFactory::makeRet(fdecl.header->name)
+        factory.makeRet(fdecl.header->name.str())
       );
     }
   }
@@ -160,22 +130,29 @@ IRBuilder::visit(ast::FuncDecl &fdecl)
     auto laststmt = fdecl.body->stmts.back();
 
     // 如果函数体的类型不为 unit，则最后一个语句一定是一个表达式
-    auto exprstmt = std::static_pointer_cast<ast::ExprStmt>(laststmt);
+    auto exprstmt = static_cast<ast::ExprStmtPtr>(laststmt);
     CHECK(
       exprstmt != nullptr,
       "the last statement isn't an expression"
     );
 
     retcode.push_back(
-      QuadFactory::makeRet(exprstmt->expr->symbol, fdecl.header->name)
+      factory.makeRet(exprstmt->expr->symbol, fdecl.header->name.str())
     );
   }
 
-  fdecl.ircode = concatIrcode(
-    fdecl.header->ircode,
-    fdecl.body->ircode,
-    retcode
-  );
+  appendIrcode(fdecl.ircode, fdecl.header->ircode, fdecl.body->ircode, retcode);
+
+  // 形参也登记到侧表中，即使函数体没有用到它们（优化 pass 新建的值编号需要避开它们）
+  for (const auto &arg : ctx.getCurFunc()->argv) {
+    func->params.push_back(func->addValue(arg));
+  }
+
+  // 生成完毕后展开为连续存放的四元式数组，后续遍历不再需要追踪链表指针
+  func->quads.assign(fdecl.ircode.begin(), fdecl.ircode.end());
+  fdecl.ircode.clear();
+  fdecl.code = std::move(func);
+  factory.bind(nullptr);
 }
 
 /**
@@ -192,8 +169,12 @@ IRBuilder::visit(ast::FuncDecl &fdecl)
 void
 IRBuilder::visit(ast::FuncHeaderDecl &fhdecl)
 {
-  auto quad = QuadFactory::makeFunc(fhdecl.name);
-  fhdecl.ircode.push_back(quad);
+  // 函数头先于函数体归约，在这里为整个函数创建 FuncCode，
+  // 之后函数体中生成的四元式都登记到它的侧表中
+  func = std::make_shared<FuncCode>(fhdecl.name.str());
+  factory.bind(func.get());
+
+  fhdecl.ircode.push_back(factory.makeFunc(func->name));
 }
 
 /**
@@ -220,7 +201,7 @@ IRBuilder::visit(ast::StmtBlockExpr &sbexpr)
       "the statement block is empty, but it's type isn't unit type"
     );
     auto laststmt = sbexpr.stmts.back();
-    auto exprstmt = std::static_pointer_cast<ast::ExprStmt>(laststmt);
+    auto exprstmt = static_cast<ast::ExprStmtPtr>(laststmt);
     CHECK(
       exprstmt != nullptr,
       "the last statement isn't an expression"
@@ -229,7 +210,7 @@ IRBuilder::visit(ast::StmtBlockExpr &sbexpr)
     sbexpr.symbol = exprstmt->expr->symbol;
   }
 
-  sbexpr.ircode = extractIrcodeAndConcat(sbexpr.stmts);
+  spliceIrcode(sbexpr.ircode, sbexpr.stmts);
 }
 
 /**
@@ -251,8 +232,8 @@ IRBuilder::visit(ast::VarDeclStmt &vdstmt)
     auto var = ctx.lookupVal(vdstmt.name).value_or(nullptr);
     ASSERT_MSG(var != nullptr, "variable didn't declared!");
 
-    auto quad = QuadFactory::makeAssign(rval->symbol, var);
-    vdstmt.ircode = rval->ircode;
+    auto quad = factory.makeAssign(rval->symbol, var);
+    appendIrcode(vdstmt.ircode, rval->ircode);
     vdstmt.ircode.push_back(quad);
   }
 }
@@ -260,36 +241,34 @@ IRBuilder::visit(ast::VarDeclStmt &vdstmt)
 void
 IRBuilder::visit(ast::ExprStmt &estmt)
 {
-  estmt.ircode = estmt.expr->ircode;
+  appendIrcode(estmt.ircode, estmt.expr->ircode);
 }
 
 void
 IRBuilder::visit(ast::RetExpr &rexpr)
 {
-  std::vector<IRQuadPtr> code;
   if (auto retval = rexpr.retval.value_or(nullptr); retval) {
-    code = retval->ircode;
-    code.push_back(
-      QuadFactory::makeRet(retval->symbol, ctx.getCurFuncName())
+    appendIrcode(rexpr.ircode, retval->ircode);
+    rexpr.ircode.push_back(
+      factory.makeRet(retval->symbol, ctx.getCurFuncName())
     );
   } else {
-    code.push_back(
-      QuadFactory::makeRet(ctx.getCurFuncName())
+    rexpr.ircode.push_back(
+      factory.makeRet(ctx.getCurFuncName())
     );
   }
-  rexpr.ircode = std::move(code);
 }
 
 void
 IRBuilder::visit(ast::BreakExpr &bexpr)
 {
   // 在 IR 层面上，直接将 BreakExpr desugar 为 optional<assign> 和 goto
-  std::vector<IRQuadPtr> codes;
   auto retval = bexpr.value.value_or(nullptr);
   if (retval) {
     auto dst = bexpr.dst.value_or(nullptr);
     ASSERT_MSG(dst.get(), "dst didn't exist (break expression)");
-    codes.push_back(QuadFactory::makeAssign(retval->symbol, dst));
+    appendIrcode(bexpr.ircode, retval->ircode);
+    bexpr.ircode.push_back(factory.makeAssign(retval->symbol, dst));
   }
 
   auto *loopctx = ctx.getLoopCtx().value_or(nullptr);
@@ -297,15 +276,9 @@ IRBuilder::visit(ast::BreakExpr &bexpr)
 
   std::string curfuncname = ctx.getCurFuncName();
   std::string prefix = std::format("{}_{}", curfuncname, loopctx->name);
-  codes.push_back(
-    QuadFactory::makeGoto(std::format("{}_end", prefix))
+  bexpr.ircode.push_back(
+    factory.makeGoto(std::format("{}_end", prefix))
   );
-
-  if (retval) {
-    bexpr.ircode = concatIrcode(retval->ircode, std::move(codes));
-  } else {
-    bexpr.ircode = std::move(codes);
-  }
 }
 
 void
@@ -317,28 +290,25 @@ IRBuilder::visit(ast::ContinueExpr &cexpr)
   std::string curfuncname = ctx.getCurFuncName();
   std::string prefix = std::format("{}_{}", curfuncname, loopctx->name);
   cexpr.ircode.push_back(
-    QuadFactory::makeGoto(std::format("{}_start", prefix))
+    factory.makeGoto(std::format("{}_start", prefix))
   );
 }
 
 void
 IRBuilder::visit(ast::AssignExpr &aexpr)
 {
-  auto quad = QuadFactory::makeAssign(
+  auto quad = factory.makeAssign(
     aexpr.rval->symbol,
     aexpr.lval->symbol
   );
-  aexpr.ircode = concatIrcode(
-    aexpr.lval->ircode,
-    aexpr.rval->ircode,
-    std::vector{quad}
-  );
+  appendIrcode(aexpr.ircode, aexpr.lval->ircode, aexpr.rval->ircode);
+  aexpr.ircode.push_back(quad);
 }
 
 void
 IRBuilder::visit(ast::AssignElem &aelem)
 {
-  aelem.ircode = aelem.base->ircode;
+  appendIrcode(aelem.ircode, aelem.base->ircode);
   aelem.symbol = aelem.base->symbol;
 }
 
@@ -354,18 +324,15 @@ IRBuilder::visit(ast::ArrAcc &aacc)
   sym::TempPtr temp = ctx.produceTemp(aacc.pos, aacc.type.type);
   aacc.symbol = temp;
 
-  auto quad = QuadFactory::makeAcc(
+  auto quad = factory.makeAcc(
     IROp::INDEX,
     aacc.base->symbol,
     aacc.idx->symbol,
     temp
   );
 
-  aacc.ircode = concatIrcode(
-    aacc.base->ircode,
-    aacc.idx->ircode,
-    std::vector{quad}
-  );
+  appendIrcode(aacc.ircode, aacc.base->ircode, aacc.idx->ircode);
+  aacc.ircode.push_back(quad);
 }
 
 void
@@ -374,18 +341,15 @@ IRBuilder::visit(ast::TupAcc &tacc)
   sym::TempPtr temp = ctx.produceTemp(tacc.pos, tacc.type.type);
   tacc.symbol = temp;
 
-  auto quad = QuadFactory::makeAcc(
+  auto quad = factory.makeAcc(
     IROp::DOT,
     tacc.base->symbol,
     tacc.idx->symbol,
     temp
   );
 
-  tacc.ircode = concatIrcode(
-    tacc.base->ircode,
-    tacc.idx->ircode,
-    std::vector{quad}
-  );
+  appendIrcode(tacc.ircode, tacc.base->ircode, tacc.idx->ircode);
+  tacc.ircode.push_back(quad);
 }
 
 static IROp
@@ -407,18 +371,15 @@ IRBuilder::visit(ast::CmpExpr &cexpr)
   sym::TempPtr temp = ctx.produceTemp(cexpr.pos, cexpr.type.type);
   cexpr.symbol = temp;
 
-  auto quad = QuadFactory::makeOperation(
+  auto quad = factory.makeOperation(
     cmpOp2IROp(cexpr.op),
     cexpr.lhs->symbol,
     cexpr.rhs->symbol,
     temp
   );
 
-  cexpr.ircode = concatIrcode(
-    cexpr.lhs->ircode,
-    cexpr.rhs->ircode,
-    std::vector{quad}
-  );
+  appendIrcode(cexpr.ircode, cexpr.lhs->ircode, cexpr.rhs->ircode);
+  cexpr.ircode.push_back(quad);
 }
 
 static IROp
@@ -438,18 +399,15 @@ IRBuilder::visit(ast::AriExpr &aexpr)
   sym::TempPtr temp = ctx.produceTemp(aexpr.pos, aexpr.type.type);
   aexpr.symbol = temp;
 
-  auto quad = QuadFactory::makeOperation(
+  auto quad = factory.makeOperation(
     ariOp2IROp(aexpr.op),
     aexpr.lhs->symbol,
     aexpr.rhs->symbol,
     temp
   );
 
-  aexpr.ircode = concatIrcode(
-    aexpr.lhs->ircode,
-    aexpr.rhs->ircode,
-    std::vector{quad}
-  );
+  appendIrcode(aexpr.ircode, aexpr.lhs->ircode, aexpr.rhs->ircode);
+  aexpr.ircode.push_back(quad);
 }
 
 static auto
@@ -457,7 +415,7 @@ extractSymbol(const std::vector<ast::ExprPtr> &elems)
 {
   return elems
     | std::views::transform([](const auto &elem) {
-        return Operand{elem->symbol};
+        return elem->symbol;
       })
     | std::ranges::to<std::vector>();
 }
@@ -465,31 +423,27 @@ extractSymbol(const std::vector<ast::ExprPtr> &elems)
 void
 IRBuilder::visit(ast::ArrElems &aelems)
 {
-  auto codes = extractIrcodeAndConcat(aelems.elems);
   auto elems = extractSymbol(aelems.elems);
+  spliceIrcode(aelems.ircode, aelems.elems);
 
   sym::TempPtr temp = ctx.produceTemp(aelems.pos, aelems.type.type);
   aelems.symbol = temp;
 
-  auto quad = QuadFactory::makeElems(IROp::MAKE_ARR, elems, temp);
-  codes.push_back(quad);
-
-  aelems.ircode = std::move(codes);
+  auto quad = factory.makeElems(IROp::MAKE_ARR, elems, temp);
+  aelems.ircode.push_back(quad);
 }
 
 void
 IRBuilder::visit(ast::TupElems &telems)
 {
-  auto codes = extractIrcodeAndConcat(telems.elems);
   auto elems = extractSymbol(telems.elems);
+  spliceIrcode(telems.ircode, telems.elems);
 
   sym::TempPtr temp = ctx.produceTemp(telems.pos, telems.type.type);
   telems.symbol = temp;
 
-  auto quad = QuadFactory::makeElems(IROp::MAKE_TUP, elems, temp);
-  codes.push_back(quad);
-
-  telems.ircode = std::move(codes);
+  auto quad = factory.makeElems(IROp::MAKE_TUP, elems, temp);
+  telems.ircode.push_back(quad);
 }
 
 void
@@ -503,62 +457,48 @@ IRBuilder::visit(ast::BracketExpr &bexpr)
 {
   if (auto expr = bexpr.expr.value_or(nullptr); expr) {
     bexpr.symbol = expr->symbol;
-    bexpr.ircode = expr->ircode;
+    appendIrcode(bexpr.ircode, expr->ircode);
   }
 }
 
 void
 IRBuilder::visit(ast::CallExpr &cexpr)
 {
-  auto codes = extractIrcodeAndConcat(cexpr.argv);
-
-  auto params = cexpr.argv
-    | std::views::transform([](const auto &arg) {
-        return Operand{arg->symbol};
-      })
-    | std::ranges::to<std::vector>();
+  auto params = extractSymbol(cexpr.argv);
 
   auto temp = ctx.produceTemp(cexpr.pos, cexpr.type.type);
   cexpr.symbol = temp;
 
-  auto quad = QuadFactory::makeCall(cexpr.callee, params, temp);
+  auto quad = factory.makeCall(cexpr.callee.str(), params, temp);
 
-  cexpr.ircode = concatIrcode(
-    std::move(codes),
-    std::vector{quad}
-  );
+  spliceIrcode(cexpr.ircode, cexpr.argv);
+  cexpr.ircode.push_back(quad);
 }
 
 static void
-makeCondAndInsert(std::vector<IRQuadPtr> &ircode, const ast::ExprPtr &cond, std::string label)
+makeCondAndInsert(QuadFactory &factory, IRCode &ircode,
+  const ast::ExprPtr &cond, std::string_view label)
 {
-  auto cond_code = cond->ircode;
-  cond_code.push_back(QuadFactory::makeBeqz(cond->symbol, std::move(label)));
-
-  ircode.insert(
-    ircode.begin(),
-    std::make_move_iterator(cond_code.begin()),
-    std::make_move_iterator(cond_code.end())
-  );
+  cond->ircode.push_back(factory.makeBeqz(cond->symbol, label));
+  ircode.splice(ircode.begin(), cond->ircode);
 }
 
 static void
-pushbackLabel(std::vector<IRQuadPtr> &ircode, const std::string &base)
+pushbackLabel(QuadFactory &factory, IRCode &ircode, const std::string &base)
 {
   ircode.push_back(
-    QuadFactory::makeLabel(std::format("{}_end", base))
+    factory.makeLabel(std::format("{}_end", base))
   );
 }
 
 static void
-insertLabels(std::vector<IRQuadPtr> &ircode, const std::string &base)
+insertLabels(QuadFactory &factory, IRCode &ircode, const std::string &base)
 {
-  ircode.insert(
-    ircode.begin(),
-    QuadFactory::makeLabel(std::format("{}_start", base))
+  ircode.push_front(
+    factory.makeLabel(std::format("{}_start", base))
   );
   ircode.push_back(
-    QuadFactory::makeLabel(std::format("{}_end", base))
+    factory.makeLabel(std::format("{}_end", base))
   );
 }
 
@@ -569,6 +509,7 @@ IRBuilder::visit(ast::IfExpr &iexpr)
   std::string curctxname = ctx.getCurCtxName();
   std::string prefix = std::format("{}_{}", curfuncname, curctxname);
   makeCondAndInsert(
+    factory,
     iexpr.body->ircode,
     iexpr.cond,
     std::format("{}_end", prefix)
@@ -576,22 +517,22 @@ IRBuilder::visit(ast::IfExpr &iexpr)
 
   if (iexpr.body->type.type != type::TypeFactory::UNIT_TYPE) {
     iexpr.body->ircode.push_back(
-      QuadFactory::makeAssign(
+      factory.makeAssign(
         iexpr.body->symbol,
         iexpr.symbol
       )
     );
   }
   iexpr.body->ircode.push_back(
-    QuadFactory::makeGoto(std::format("{}_final", prefix))
+    factory.makeGoto(std::format("{}_final", prefix))
   );
 
-  insertLabels(iexpr.body->ircode, prefix);
+  insertLabels(factory, iexpr.body->ircode, prefix);
 
-  auto else_codes = extractIrcodeAndConcat(iexpr.elses);
-  iexpr.ircode = concatIrcode(iexpr.body->ircode, else_codes);
+  appendIrcode(iexpr.ircode, iexpr.body->ircode);
+  spliceIrcode(iexpr.ircode, iexpr.elses);
   iexpr.ircode.push_back(
-    QuadFactory::makeLabel(std::format("{}_final", prefix))
+    factory.makeLabel(std::format("{}_final", prefix))
   );
 }
 
@@ -603,6 +544,7 @@ IRBuilder::visit(ast::ElseClause &eclause)
   std::string prefix = std::format("{}_{}", curfuncname, curctxname);
   if (const auto &cond = eclause.cond.value_or(nullptr); cond) {
     makeCondAndInsert(
+      factory,
       eclause.body->ircode,
       cond,
       std::format("{}_end", prefix)
@@ -619,45 +561,45 @@ IRBuilder::visit(ast::ElseClause &eclause)
     const auto &ifval = opt_ifval.value();
 
     eclause.body->ircode.push_back(
-      QuadFactory::makeAssign(eclause.body->symbol, ifval)
+      factory.makeAssign(eclause.body->symbol, ifval)
     );
   }
   eclause.body->ircode.push_back(
-    QuadFactory::makeGoto(
+    factory.makeGoto(
       std::format("{}_{}_final", curfuncname, ifscope.name)
     )
   );
 
-  pushbackLabel(eclause.body->ircode, prefix);
+  pushbackLabel(factory, eclause.body->ircode, prefix);
 
-  eclause.ircode = eclause.body->ircode;
+  appendIrcode(eclause.ircode, eclause.body->ircode);
 }
 
 void
 IRBuilder::visit(ast::WhileLoopExpr&wlexpr)
 {
-  auto cond_code = wlexpr.cond->ircode;
   std::string curfuncname = ctx.getCurFuncName();
   std::string curctxname = ctx.getCurCtxName();
   std::string prefix = std::format("{}_{}", curfuncname, curctxname);
-  cond_code.push_back(
-    QuadFactory::makeBeqz(
+
+  appendIrcode(wlexpr.ircode, wlexpr.cond->ircode);
+  wlexpr.ircode.push_back(
+    factory.makeBeqz(
       wlexpr.cond->symbol,
       std::format("{}_end", prefix)
     )
   );
-
-  wlexpr.ircode = concatIrcode(cond_code, wlexpr.body->ircode);
+  appendIrcode(wlexpr.ircode, wlexpr.body->ircode);
   wlexpr.ircode.push_back(
-    QuadFactory::makeGoto(std::format("{}_start", prefix))
+    factory.makeGoto(std::format("{}_start", prefix))
   );
-  insertLabels(wlexpr.ircode, prefix);
+  insertLabels(factory, wlexpr.ircode, prefix);
 }
 
 void
 IRBuilder::visit(ast::ForLoopExpr &flexpr)
 {
-  flexpr.ircode = concatIrcode(flexpr.iterexpr->ircode, flexpr.body->ircode);
+  appendIrcode(flexpr.ircode, flexpr.iterexpr->ircode, flexpr.body->ircode);
 
   auto curforscope = ctx.getCurScope();
   CHECK(curforscope.val.has_value(), "for loop iterator didn't declared");
@@ -665,9 +607,9 @@ IRBuilder::visit(ast::ForLoopExpr &flexpr)
   std::string curfuncname = ctx.getCurFuncName();
   std::string prefix = std::format("{}_{}", curfuncname, curforscope.name);
   flexpr.ircode.push_back(
-    QuadFactory::makeGoto(std::format("{}_start", prefix))
+    factory.makeGoto(std::format("{}_start", prefix))
   );
-  pushbackLabel(flexpr.ircode, prefix);
+  pushbackLabel(factory, flexpr.ircode, prefix);
 }
 
 /**
@@ -692,10 +634,8 @@ IRBuilder::visit(ast::ForLoopExpr &flexpr)
 void
 IRBuilder::visit(ast::RangeExpr &range_expr)
 {
-  auto codes = concatIrcode(
-    range_expr.start->ircode,
-    range_expr.end->ircode
-  );
+  auto &codes = range_expr.ircode;
+  appendIrcode(codes, range_expr.start->ircode, range_expr.end->ircode);
 
   auto curforscope = ctx.getCurScope();
   std::string curfuncname = ctx.getCurFuncName();
@@ -705,7 +645,7 @@ IRBuilder::visit(ast::RangeExpr &range_expr)
 
   auto one = ctx.declareConst(1, range_expr.pos);
   codes.push_back(
-    QuadFactory::makeOperation(
+    factory.makeOperation(
       IROp::SUB,
       range_expr.start->symbol,
       one,
@@ -714,26 +654,24 @@ IRBuilder::visit(ast::RangeExpr &range_expr)
   );
 
   codes.push_back(
-    QuadFactory::makeLabel(std::format("{}_start", prefix))
+    factory.makeLabel(std::format("{}_start", prefix))
   );
 
   auto temp = ctx.produceTemp(range_expr.pos, type::TypeFactory::INT_TYPE);
   codes.push_back(
-    QuadFactory::makeOperation(IROp::ADD, iter, one, temp)
+    factory.makeOperation(IROp::ADD, iter, one, temp)
   );
   codes.push_back(
-    QuadFactory::makeAssign(temp, iter)
+    factory.makeAssign(temp, iter)
   );
 
   codes.push_back(
-    QuadFactory::makeBge(
+    factory.makeBge(
       iter,
       range_expr.end->symbol,
       std::format("{}_end", prefix)
     )
   );
-
-  range_expr.ircode = std::move(codes);
 }
 
 /**
@@ -755,7 +693,8 @@ IRBuilder::visit(ast::RangeExpr &range_expr)
 void
 IRBuilder::visit(ast::IterableVal &iter)
 {
-  auto codes = iter.value->ircode;
+  auto &codes = iter.ircode;
+  appendIrcode(codes, iter.value->ircode);
 
   auto curforscope = ctx.getCurScope();
   std::string curfuncname = ctx.getCurFuncName();
@@ -770,16 +709,16 @@ IRBuilder::visit(ast::IterableVal &iter)
 
   auto temp1 = ctx.produceTemp(iter.pos, type::TypeFactory::INT_TYPE);
   codes.push_back(
-    QuadFactory::makeAssign(negone, temp1)
+    factory.makeAssign(negone, temp1)
   );
 
   codes.push_back(
-    QuadFactory::makeLabel(std::format("{}_start", prefix))
+    factory.makeLabel(std::format("{}_start", prefix))
   );
 
   auto temp2 = ctx.produceTemp(iter.pos, type::TypeFactory::INT_TYPE);
   codes.push_back(
-    QuadFactory::makeOperation(
+    factory.makeOperation(
       IROp::ADD,
       temp1,
       one,
@@ -788,7 +727,7 @@ IRBuilder::visit(ast::IterableVal &iter)
   );
 
   codes.push_back(
-    QuadFactory::makeBge(
+    factory.makeBge(
       temp2,
       size,
       std::format("{}_end", prefix)
@@ -796,32 +735,29 @@ IRBuilder::visit(ast::IterableVal &iter)
   );
 
   codes.push_back(
-    QuadFactory::makeOperation(
+    factory.makeOperation(
       IROp::INDEX,
       iter.symbol,
       temp2,
       for_it
     )
   );
-
-  iter.ircode = std::move(codes);
 }
 
 void
 IRBuilder::visit(ast::LoopExpr&lexpr)
 {
-  auto codes = lexpr.body->ircode;
+  auto &codes = lexpr.ircode;
+  appendIrcode(codes, lexpr.body->ircode);
 
   std::string curctxname = ctx.getCurCtxName();
   std::string curfuncname = ctx.getCurFuncName();
   std::string prefix = std::format("{}_{}", curfuncname, curctxname);
 
   codes.push_back(
-    QuadFactory::makeGoto(std::format("{}_start", prefix))
+    factory.makeGoto(std::format("{}_start", prefix))
   );
-  insertLabels(codes, prefix);
-
-  lexpr.ircode = std::move(codes);
+  insertLabels(factory, codes, prefix);
 }
 
 } // namespace ir
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "ast.hpp"
+#include "func_code.hpp"
 #include "crtp_visitor.hpp"
+#include "quad_factory.hpp"
 
 namespace sem { class SemanticContext; }
 
@@ -22,6 +24,9 @@ namespace ir {
 //
 // 总得来说就是，**只有中间表达式结果是静态单赋值的，而用户变量是多赋值形式**
 //
+// 开启优化（-O1）时，opt::constructSSA 在 CFG 上把用户变量也转换为 SSA 形式，
+// 优化结束后再由 opt::destructSSA 消去 φ 函数，交给代码生成
+//
 
 class IRBuilder : public ast::CRTPVisitor<IRBuilder> {
 public:
@@ -29,15 +34,15 @@ public:
 
 public:
   static void visit(ast::Prog&);
-  static void visit(ast::FuncDecl&);
-  static void visit(ast::FuncHeaderDecl&);
+  void visit(ast::FuncDecl&);
+  void visit(ast::FuncHeaderDecl&);
   static void visit(ast::StmtBlockExpr&);
   void visit(ast::VarDeclStmt&);
   static void visit(ast::ExprStmt&);
   void visit(ast::RetExpr&);
   void visit(ast::BreakExpr&);
   void visit(ast::ContinueExpr&);
-  static void visit(ast::AssignExpr&);
+  void visit(ast::AssignExpr&);
   static void visit(ast::AssignElem&);
   void visit(ast::Variable&);
   void visit(ast::ArrAcc&);
@@ -59,6 +64,9 @@ public:
 
 private:
   sem::SemanticContext &ctx;
+
+  FuncCodePtr func;    // 当前正在生成的函数
+  QuadFactory factory; // 绑定到 func 的四元式工厂
 };
 
 } // namespace ir
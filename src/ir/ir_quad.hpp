@@ -1,8 +1,9 @@
 #pragma once
 
-#include <memory>
-
-#include "symbol.hpp"
+#include <list>
+#include <limits>
+#include <string>
+#include <cstdint>
 
 #define IROP_LIST(_) \
   _(ADD,      "+") \
@@ -27,27 +28,17 @@
   _(INDEX,    "[]") \
   _(DOT,      ".") \
   _(MAKE_ARR, "make_array") \
-  _(MAKE_TUP, "make_tuple")
+  _(MAKE_TUP, "make_tuple") \
+  _(PROBE,    "probe")
 
 namespace ir {
 
-struct Operand {
-  sym::ValuePtr value;
-
-  Operand() = default;
-  explicit Operand(sym::ValuePtr val) : value(std::move(val)) {}
+// 四元式中的操作数、标号与元素列表都是所在 FuncCode 侧表中的 32 位下标
+using ValueId = std::uint32_t;
+using LabelId = std::uint32_t;
+using ElemsId = std::uint32_t;
 
-  [[nodiscard]] std::string str() const {
-    if (value != nullptr) {
-      return value->str();
-    }
-    return "-";
-  }
-
-  [[nodiscard]] bool isConst() const {
-    return value->kind == sym::Value::Kind::CONST;
-  }
-};
+inline constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
 
 enum class IROp : std::uint8_t {
 #define DEFINE_ENUM(name, str) name,
@@ -57,17 +48,20 @@ enum class IROp : std::uint8_t {
 
 [[nodiscard]] auto irop2str(const IROp &op) -> std::string;
 
+// NOTE: 定长、平凡可复制的四元式；操作数（sym::Value）、标号字符串以及
+//       make_array/make_tuple/call 的元素列表都保存在 FuncCode 的侧表中，
+//       这里只记录下标，未使用的字段为 NONE；
+//       probe（--profile-generate 插入）把计数器 arg1（常量下标）加一，没有其他作用
 struct IRQuad {
   IROp    op;
-  Operand arg1;
-  Operand arg2;
-  Operand dst;
-
-  std::vector<Operand> elems;
-  std::string label; // 仅在跳转指令中有效！
-
-  [[nodiscard]] std::string str() const;
+  ValueId arg1  = NONE;
+  ValueId arg2  = NONE;
+  ValueId dst   = NONE;
+  LabelId label = NONE; // 仅在跳转、标号、函数、返回与调用指令中有效！
+  ElemsId elems = NONE; // 仅在 make_array、make_tuple 与调用指令中有效！
 };
-using IRQuadPtr = std::shared_ptr<IRQuad>;
+static_assert(sizeof(IRQuad) == 24);
+
+using IRCode = std::list<IRQuad>; // 生成过程中的四元式序列，子结点的代码通过 splice 拼接
 
 } // namespace ir
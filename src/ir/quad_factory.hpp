@@ -2,40 +2,55 @@
 
 #include "symbol.hpp"
 #include "ir_quad.hpp"
+#include "func_code.hpp"
 
 namespace ir {
 
+/**
+ * @brief   四元式工厂
+ * @details 绑定到一个 FuncCode，构造四元式时把操作数、标号以及元素列表
+ *          登记到该函数的侧表中，返回的四元式只包含下标
+ */
 class QuadFactory {
 public:
-  static IRQuadPtr makeFunc(std::string name);
+  QuadFactory() = default;
+  explicit QuadFactory(FuncCode *func) : func(func) {}
 
-  static IRQuadPtr makeAssign(sym::ValuePtr src, sym::ValuePtr dst);
+  void bind(FuncCode *func) { this->func = func; }
 
-  static IRQuadPtr makeRet(std::string funcname);
-  static IRQuadPtr makeRet(sym::ValuePtr retval, std::string funcname);
+public:
+  IRQuad makeFunc(std::string_view name);
+
+  IRQuad makeAssign(const sym::ValuePtr &src, const sym::ValuePtr &dst);
+
+  IRQuad makeRet(std::string_view funcname);
+  IRQuad makeRet(const sym::ValuePtr &retval, std::string_view funcname);
+
+  IRQuad makeGoto(std::string_view target);
 
-  static IRQuadPtr makeGoto(std::string target);
+  IRQuad makeAcc(IROp op, const sym::ValuePtr &base,
+    const sym::ValuePtr &idx, const sym::ValuePtr &dst);
 
-  static IRQuadPtr makeAcc(IROp op, sym::ValuePtr base,
-    sym::ValuePtr idx, sym::ValuePtr dst);
+  IRQuad makeElems(IROp op, const std::vector<sym::ValuePtr> &elems,
+    const sym::ValuePtr &dst);
 
-  static IRQuadPtr makeElems(IROp op, std::vector<Operand> elems,
-    sym::ValuePtr dst);
+  IRQuad makeOperation(IROp op, const sym::ValuePtr &arg1,
+    const sym::ValuePtr &arg2, const sym::ValuePtr &dst);
 
-  static IRQuadPtr makeOperation(IROp op, sym::ValuePtr arg1,
-    sym::ValuePtr arg2, sym::ValuePtr dst);
+  IRQuad makeCall(std::string_view callee,
+    const std::vector<sym::ValuePtr> &params, const sym::ValuePtr &dst);
 
-  static IRQuadPtr makeCall(std::string callee,
-    std::vector<Operand> params, sym::ValuePtr dst);
+  IRQuad makeBeqz(const sym::ValuePtr &cond, std::string_view label);
 
-  static IRQuadPtr makeBeqz(sym::ValuePtr cond, std::string label);
+  IRQuad makeBnez(const sym::ValuePtr &cond, std::string_view label);
 
-  static IRQuadPtr makeBnez(sym::ValuePtr cond, std::string label);
+  IRQuad makeBge(const sym::ValuePtr &arg1, const sym::ValuePtr &arg2,
+    std::string_view label);
 
-  static IRQuadPtr makeBge(sym::ValuePtr arg1, sym::ValuePtr arg2,
-    std::string label);
+  IRQuad makeLabel(std::string_view label);
 
-  static IRQuadPtr makeLabel(std::string label);
+private:
+  FuncCode *func = nullptr; // 当前正在生成的函数
 };
 
 } // namespace ir
@@ -2,138 +2,127 @@
 
 namespace ir {
 
-inline IRQuadPtr
-QuadFactory::makeFunc(std::string name)
+inline IRQuad
+QuadFactory::makeFunc(std::string_view name)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::FUNC;
-  quad->label = std::move(name);
-  return quad;
+  return IRQuad{.op = IROp::FUNC, .label = func->addLabel(name)};
 }
 
-inline IRQuadPtr
-QuadFactory::makeAssign(sym::ValuePtr src, sym::ValuePtr dst)
+inline IRQuad
+QuadFactory::makeAssign(const sym::ValuePtr &src, const sym::ValuePtr &dst)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::ASSIGN;
-  quad->arg1 = Operand{std::move(src)};
-  quad->dst = Operand{std::move(dst)};
-  return quad;
+  return IRQuad{
+    .op   = IROp::ASSIGN,
+    .arg1 = func->addValue(src),
+    .dst  = func->addValue(dst)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeRet(std::string funcname)
+inline IRQuad
+QuadFactory::makeRet(std::string_view funcname)
 {
-  return makeRet(nullptr, std::move(funcname));
+  return makeRet(nullptr, funcname);
 }
 
-inline IRQuadPtr
-QuadFactory::makeRet(sym::ValuePtr retval, std::string funcname)
+inline IRQuad
+QuadFactory::makeRet(const sym::ValuePtr &retval, std::string_view funcname)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::RETURN;
-  if (retval) {
-    quad->arg1 = Operand{std::move(retval)};
-  }
-  quad->label = std::move(funcname);
-  return quad;
+  return IRQuad{
+    .op    = IROp::RETURN,
+    .arg1  = func->addValue(retval),
+    .label = func->addLabel(funcname)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeGoto(std::string target)
+inline IRQuad
+QuadFactory::makeGoto(std::string_view target)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::GOTO;
-  quad->label = std::move(target);
-  return quad;
+  return IRQuad{.op = IROp::GOTO, .label = func->addLabel(target)};
 }
 
-inline IRQuadPtr
-QuadFactory::makeAcc(IROp op, sym::ValuePtr base,
-  sym::ValuePtr idx, sym::ValuePtr dst)
+inline IRQuad
+QuadFactory::makeAcc(IROp op, const sym::ValuePtr &base,
+  const sym::ValuePtr &idx, const sym::ValuePtr &dst)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = op;
-  quad->arg1 = Operand{std::move(base)};
-  quad->arg2 = Operand{std::move(idx)};
-  quad->dst = Operand{std::move(dst)};
-  return quad;
+  return IRQuad{
+    .op   = op,
+    .arg1 = func->addValue(base),
+    .arg2 = func->addValue(idx),
+    .dst  = func->addValue(dst)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeElems(IROp op, std::vector<Operand> elems,
-  sym::ValuePtr dst)
+inline IRQuad
+QuadFactory::makeElems(IROp op, const std::vector<sym::ValuePtr> &elems,
+  const sym::ValuePtr &dst)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = op;
-  quad->elems = std::move(elems);
-  quad->dst = Operand{std::move(dst)};
-  return quad;
+  return IRQuad{
+    .op    = op,
+    .dst   = func->addValue(dst),
+    .elems = func->addElems(elems)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeOperation(IROp op, sym::ValuePtr arg1,
-  sym::ValuePtr arg2, sym::ValuePtr dst)
+inline IRQuad
+QuadFactory::makeOperation(IROp op, const sym::ValuePtr &arg1,
+  const sym::ValuePtr &arg2, const sym::ValuePtr &dst)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = op;
-  quad->arg1 = Operand{std::move(arg1)};
-  quad->arg2 = Operand{std::move(arg2)};
-  quad->dst = Operand{std::move(dst)};
-  return quad;
+  return IRQuad{
+    .op   = op,
+    .arg1 = func->addValue(arg1),
+    .arg2 = func->addValue(arg2),
+    .dst  = func->addValue(dst)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeCall(std::string callee,
-  std::vector<Operand> params, sym::ValuePtr dst)
+inline IRQuad
+QuadFactory::makeCall(std::string_view callee,
+  const std::vector<sym::ValuePtr> &params, const sym::ValuePtr &dst)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::CALL;
-  quad->elems = std::move(params);
-  quad->dst = Operand{std::move(dst)};
-  quad->label = std::move(callee);
-  return quad;
+  return IRQuad{
+    .op    = IROp::CALL,
+    .dst   = func->addValue(dst),
+    .label = func->addLabel(callee),
+    .elems = func->addElems(params)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeBeqz(sym::ValuePtr cond, std::string label)
+inline IRQuad
+QuadFactory::makeBeqz(const sym::ValuePtr &cond, std::string_view label)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::BEQZ;
-  quad->arg1 = Operand{std::move(cond)};
-  quad->label = std::move(label);
-  return quad;
+  return IRQuad{
+    .op    = IROp::BEQZ,
+    .arg1  = func->addValue(cond),
+    .label = func->addLabel(label)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeBnez(sym::ValuePtr cond, std::string label)
+inline IRQuad
+QuadFactory::makeBnez(const sym::ValuePtr &cond, std::string_view label)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::BNEZ;
-  quad->arg1 = Operand{std::move(cond)};
-  quad->label = std::move(label);
-  return quad;
+  return IRQuad{
+    .op    = IROp::BNEZ,
+    .arg1  = func->addValue(cond),
+    .label = func->addLabel(label)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeBge(sym::ValuePtr arg1, sym::ValuePtr arg2,
-  std::string label)
+inline IRQuad
+QuadFactory::makeBge(const sym::ValuePtr &arg1, const sym::ValuePtr &arg2,
+  std::string_view label)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::BGE;
-  quad->arg1 = Operand{std::move(arg1)};
-  quad->arg2 = Operand{std::move(arg2)};
-  quad->label = std::move(label);
-  return quad;
+  return IRQuad{
+    .op    = IROp::BGE,
+    .arg1  = func->addValue(arg1),
+    .arg2  = func->addValue(arg2),
+    .label = func->addLabel(label)
+  };
 }
 
-inline IRQuadPtr
-QuadFactory::makeLabel(std::string label)
+inline IRQuad
+QuadFactory::makeLabel(std::string_view label)
 {
-  auto quad = std::make_shared<IRQuad>();
-  quad->op = IROp::LABEL;
-  quad->label = std::move(label);
-  return quad;
+  return IRQuad{.op = IROp::LABEL, .label = func->addLabel(label)};
 }
 
 } // namespace ir
@@ -8,15 +8,18 @@ namespace ir {
 /**
  * @brief 生成一个临时变量
  *
+ * @param id   临时变量的值编号
  * @param pos  临时变量声明时的位置
  * @param type 临时变量类型
  * @return sym::TempPtr 生成的临时变量指针
  */
 sym::TempPtr
-TempFactory::produce(util::Position pos, type::TypePtr type)
+TempFactory::produce(sym::ValueId id, util::Position pos, type::TypePtr type)
 {
+  // NOTE: 名字 %n 只在打印时由 Temp::str 生成
   auto temp = std::make_shared<sym::Temp>();
-  temp->name = std::format("%{}", cnt++);
+  temp->id = id;
+  temp->index = cnt++;
   temp->pos = pos;
   temp->mut = false; // TODO: 临时变量是否一定不变还有待商榷
   temp->init = true;
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <cstdint>
 
 namespace sym {
 
+using ValueId = std::uint32_t;
+
 struct Temp;
 using TempPtr = std::shared_ptr<Temp>;
 
@@ -12,7 +15,7 @@ using TempPtr = std::shared_ptr<Temp>;
 namespace type {
 
 struct Type;
-using TypePtr = std::shared_ptr<Type>;
+using TypePtr = const Type *;
 
 } // namespace type
 
@@ -27,7 +30,8 @@ public:
    */
   void resetCnt() { cnt = 0; }
 
-  auto produce(util::Position pos, type::TypePtr type) -> sym::TempPtr;
+  auto produce(sym::ValueId id, util::Position pos, type::TypePtr type)
+    -> sym::TempPtr;
 
 private:
   int cnt = 0; // temp counter
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace lex {
+
+// 字符类别，用于表驱动的词法扫描
+enum class CharClass : std::uint8_t {
+  OTHER,   // 无法识别的字符
+  SPACE,   // 除换行外的空白字符
+  NEWLINE, // '\n'
+  IDSTART, // [a-zA-Z_]
+  DIGIT,   // [0-9]
+  PUNCT,   // 算符与界符的首字符
+};
+
+/**
+ * @brief 编译期生成的 256 项字符类别表
+ */
+inline constexpr std::array<CharClass, 256> CHAR_CLASS = [] {
+  std::array<CharClass, 256> table{};
+
+  for (auto c : {' ', '\t', '\v', '\f', '\r'}) {
+    table[static_cast<unsigned char>(c)] = CharClass::SPACE;
+  }
+  table['\n'] = CharClass::NEWLINE;
+
+  for (int c = 'a'; c <= 'z'; ++c) {
+    table[c] = CharClass::IDSTART;
+  }
+  for (int c = 'A'; c <= 'Z'; ++c) {
+    table[c] = CharClass::IDSTART;
+  }
+  table['_'] = CharClass::IDSTART;
+
+  for (int c = '0'; c <= '9'; ++c) {
+    table[c] = CharClass::DIGIT;
+  }
+
+  for (auto c : "(){}[];:,+-*/=<>.!") {
+    if (c != '\0') {
+      table[static_cast<unsigned char>(c)] = CharClass::PUNCT;
+    }
+  }
+
+  return table;
+}();
+
+/**
+ * @brief 查询字符类别
+ */
+constexpr CharClass
+charClass(char c)
+{
+  return CHAR_CLASS[static_cast<unsigned char>(c)];
+}
+
+/**
+ * @brief 是否为标识符的后续字符 [a-zA-Z0-9_]
+ */
+constexpr bool
+isIdentChar(char c)
+{
+  auto cls = charClass(c);
+  return cls == CharClass::IDSTART || cls == CharClass::DIGIT;
+}
+
+} // namespace lex
@@ -1,56 +1,89 @@
 #pragma once
 
-#include <unordered_map>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
 
-#include "panic.hpp"
 #include "token_type.hpp"
 
 namespace lex {
 
+struct Keyword {
+  std::string_view name; // keyword name
+  TokenType        type; // keyword token type
+};
+
+// 所有关键字
+inline constexpr std::array<Keyword, 16> KEYWORDS {{
+  {"if",       TokenType::IF},
+  {"fn",       TokenType::FN},
+  {"in",       TokenType::IN},
+  {"i32",      TokenType::I32},
+  {"bool",     TokenType::BOOL},
+  {"let",      TokenType::LET},
+  {"mut",      TokenType::MUT},
+  {"for",      TokenType::FOR},
+  {"loop",     TokenType::LOOP},
+  {"else",     TokenType::ELSE},
+  {"break",    TokenType::BREAK},
+  {"while",    TokenType::WHILE},
+  {"return",   TokenType::RETURN},
+  {"continue", TokenType::CONTINUE},
+  {"true",     TokenType::TRUE},
+  {"false",    TokenType::FALSE},
+}};
+
+// 完美哈希表的槽数
+inline constexpr std::size_t KEYWORD_SLOTS = 32;
+
+/**
+ * @brief   关键字完美哈希函数
+ * @details 仅使用长度、首字符和尾字符，对 KEYWORDS 中的关键字无冲突
+ */
+constexpr std::size_t
+keywordHash(std::string_view v)
+{
+  return (v.length() * 6
+    + static_cast<unsigned char>(v.front())
+    + static_cast<unsigned char>(v.back())) % KEYWORD_SLOTS;
+}
+
 /**
- * @brief   关键字表
- * @details 内置一个存储所有关键字的 hash map，用于查找判断指定 token
- * 是否为关键字
+ * @brief 编译期构建的关键字哈希表，空槽的 name 为空串
  */
-class KeywordTable {
-public:
-  KeywordTable() = default;
-  ~KeywordTable() = default;
-
-public:
-  /**
-   * @brief  判断给定的输入值是否是一个关键字
-   * @param  v token value
-   * @return true / false
-   */
-  bool iskeyword(const std::string &v) const {
-    return (keywords.contains(v));
+inline constexpr std::array<Keyword, KEYWORD_SLOTS> KEYWORD_TABLE = [] {
+  std::array<Keyword, KEYWORD_SLOTS> table{};
+  for (const auto &kw : KEYWORDS) {
+    auto &slot = table[keywordHash(kw.name)];
+    if (!slot.name.empty()) {
+      throw "keyword hash collision"; // 编译期报错：需要调整 keywordHash
+    }
+    slot = kw;
   }
+  return table;
+}();
 
-  /**
-   * @brief 向关键词表中添加一个关键词类型
-   * @param name keyword name
-   * @param type keyword token type
-   */
-  void addKeyword(std::string name, TokenType type) {
-    this->keywords.emplace(name, type);
+/**
+ * @brief  判断给定的输入值是否是一个关键字（单次查表）
+ * @param  v token value
+ * @return 对应的 keyword token type；不是关键字则返回 std::nullopt
+ */
+constexpr std::optional<TokenType>
+lookupKeyword(std::string_view v)
+{
+  if (v.empty()) {
+    return std::nullopt;
   }
 
-  /**
-   * @brief  根据输入值获取对应 token type
-   * @param  v token value
-   * @return keyword token type
-   */
-  TokenType getKeyword(const std::string &v) const {
-    ASSERT_MSG(
-      keywords.contains(v),
-      "Param isn't a keyword."
-    );
-    return keywords.find(v)->second;
+  const auto &slot = KEYWORD_TABLE[keywordHash(v)];
+  if (slot.name == v) {
+    return slot.type;
   }
+  return std::nullopt;
+}
 
-private:
-  std::unordered_map<std::string, TokenType> keywords; // keyword hash map
-};
+static_assert(lookupKeyword("continue") == TokenType::CONTINUE);
+static_assert(!lookupKeyword("main").has_value());
 
 } // namespace lex
@@ -1,9 +1,9 @@
-#include <regex>
-#include <vector>
-#include <cstdlib>
+#include <algorithm>
 
 #include "lexer.hpp"
 #include "token.hpp"
+#include "simd_scan.hpp"
+#include "char_class.hpp"
 #include "err_report.hpp"
 
 namespace lex {
@@ -16,188 +16,294 @@ void
 Lexer::reset(const util::Position &pos)
 {
   this->pos = pos;
-  this->peek = this->text[pos.row][pos.col];
+  this->cursor = std::min(text.lineOffset(pos.row) + pos.col, src.length());
 }
 
 /**
- * @brief lexer 前指向位置移动指定字符数
- * @param delta 位移量
+ * @brief lexer 前指向位置在当前行内移动指定字符数
+ * @param delta 位移量（不能跨越换行符）
  */
 void
-Lexer::shiftPos(std::size_t delta)
+Lexer::advance(std::size_t delta)
 {
+  cursor += delta;
   pos.col += delta;
-  // 若到达句尾，则换行
-  if (pos.col >= text[pos.row].length()) {
-    ++pos.row;
-    pos.col = 0;
+}
+
+/**
+ * @brief 越过一个换行符
+ */
+void
+Lexer::newline()
+{
+  ++cursor;
+  ++pos.row;
+  pos.col = 0;
+}
+
+/**
+ * @brief   跳过一个（可能嵌套的）块注释
+ * @details 调用时 cursor 指向 "/*"；未闭合的块注释会一直延伸到文件末尾
+ */
+void
+Lexer::skipBlockComment()
+{
+  int depth{}; // 嵌套深度
+
+  while (cursor < src.length()) {
+    auto view = src.substr(cursor);
+    if (view[0] == '\n') {
+      newline();
+    } else if (view.starts_with("/*")) {
+      ++depth;
+      advance(2);
+    } else if (view.starts_with("*/")) {
+      advance(2);
+      if (--depth == 0) {
+        return;
+      }
+    } else {
+      advance(1);
+    }
+  } // end of while
+}
+
+/**
+ * @brief 忽略所有空白字符与注释
+ */
+void
+Lexer::skipBlankAndComments()
+{
+  while (cursor < src.length()) {
+    char c = src[cursor];
+    switch (charClass(c)) {
+      case CharClass::SPACE: // 缩进等连续空白按向量宽度批量跳过
+        advance(simd::runLength<simd::Run::SPACE>(
+          src.data() + cursor, src.data() + src.length()
+        ));
+        continue;
+      case CharClass::NEWLINE:
+        newline();
+        continue;
+      default: break;
+    }
+
+    if (c != '/' || cursor + 1 >= src.length()) {
+      return;
+    }
+
+    if (src[cursor + 1] == '/') { // 单行注释，跳到行尾
+      auto eol = src.find('\n', cursor);
+      advance((eol == std::string_view::npos ? src.length() : eol) - cursor);
+    } else if (src[cursor + 1] == '*') { // 块注释
+      skipBlockComment();
+    } else {
+      return;
+    }
+  } // end of while
+}
+
+/**
+ * @brief  识别标识符或关键字：[a-zA-Z_][a-zA-Z0-9_]*
+ * @return 识别到的 token
+ */
+Token
+Lexer::scanIdentifier()
+{
+  std::size_t end = cursor + 1 + simd::runLength<simd::Run::IDENT>(
+    src.data() + cursor + 1, src.data() + src.length()
+  );
+
+  auto start = pos;
+  auto word = src.substr(cursor, end - cursor);
+  advance(end - cursor);
+
+  // 检查识别到的标识符是否是关键字
+  if (auto type = lookupKeyword(word); type.has_value()) {
+    return Token{type.value(), word, start};
   }
-};
+  return Token{TokenType::ID, word, start, interner.intern(word)};
+}
 
 /**
- * @brief  通过正则表达式匹配 token
- * @param  view 扫描窗口
- * @return 识别到的 token，没有则返回 std::nullopt
+ * @brief  识别整数：[0-9]+
+ * @return 识别到的 token
  */
-std::optional<Token>
-Lexer::matchThroughRE(const std::string &view)
+Token
+Lexer::scanInteger()
 {
-  static const std::vector<std::pair<TokenType, std::regex>> patterns {
-    {TokenType::ID,  std::regex{R"(^[a-zA-Z_]\w*)"}},
-    {TokenType::INT, std::regex{R"(^\d+)"}}
-  };
-
-  // 使用正则表达式检测 INT、ID 两类词法单元
-  for (const auto &[type, re] : patterns) {
-    std::smatch match;
-    // 根据 pattern 识别，结果存储在 match 中
-    if (std::regex_search(view, match, re)) {
-      auto pos = this->pos;
-      shiftPos(match.length(0));
-      // 检查识别到的标识符是否是关键字
-      if (type == TokenType::ID && this->keytab.iskeyword(match.str(0))) {
-        auto keytype = this->keytab.getKeyword(match.str(0));
-        return Token{keytype, match.str(0), pos};
-      } // enf of if
-      return Token{type, match.str(0), pos};
-    } // end of if
-  } // end of for
+  std::size_t end = cursor + 1 + simd::runLength<simd::Run::DIGIT>(
+    src.data() + cursor + 1, src.data() + src.length()
+  );
 
-  return std::nullopt;
+  auto start = pos;
+  auto value = src.substr(cursor, end - cursor);
+  advance(end - cursor);
+
+  return Token{TokenType::INT, value, start};
 }
 
 /**
- * @brief  通过 DFA 匹配 token
- * @param  view 扫描窗口
+ * @brief  识别算符和界符
  * @return 识别到的 token，没有则返回 std::nullopt
  */
 std::optional<Token>
-Lexer::matchThroughDFA(const std::string &view)
+Lexer::scanPunct()
 {
-  char fchar{view[0]}; // first char
-  char schar{view.length() > 1 ? view[1] : '\0'}; // second char
+  char fchar{src[cursor]}; // first char
+  char schar{cursor + 1 < src.length() ? src[cursor + 1] : '\0'}; // second char
 
-  // 检测算符和标点符号
-  Token token{}; // 识别到的词法单元
+  TokenType type{};   // 识别到的词法单元类型
+  std::size_t len{1}; // 词法单元长度
   switch (fchar) {
-    default: break;
-    case '(': token = {TokenType::LPAREN,    "("}; break;
-    case ')': token = {TokenType::RPAREN,    ")"}; break;
-    case '{': token = {TokenType::LBRACE,    "{"}; break;
-    case '}': token = {TokenType::RBRACE,    "}"}; break;
-    case '[': token = {TokenType::LBRACK,    "["}; break;
-    case ']': token = {TokenType::RBRACK,    "]"}; break;
-    case ';': token = {TokenType::SEMICOLON, ";"}; break;
-    case ':': token = {TokenType::COLON,     ":"}; break;
-    case ',': token = {TokenType::COMMA,     ","}; break;
-    case '+': token = {TokenType::PLUS,      "+"}; break;
-    case '*': token = {TokenType::MUL,       "*"}; break;
-    case '/': token = {TokenType::DIV,       "/"}; break;
+    default: return std::nullopt;
+    case '(': type = TokenType::LPAREN;    break;
+    case ')': type = TokenType::RPAREN;    break;
+    case '{': type = TokenType::LBRACE;    break;
+    case '}': type = TokenType::RBRACE;    break;
+    case '[': type = TokenType::LBRACK;    break;
+    case ']': type = TokenType::RBRACK;    break;
+    case ';': type = TokenType::SEMICOLON; break;
+    case ':': type = TokenType::COLON;     break;
+    case ',': type = TokenType::COMMA;     break;
+    case '+': type = TokenType::PLUS;      break;
+    case '*': type = TokenType::MUL;       break;
+    case '/': type = TokenType::DIV;       break;
     case '=':
       if (schar == '=') {
-        token = {TokenType::EQ, "=="};
+        type = TokenType::EQ;
+        len = 2;
       } else {
-        token = {TokenType::ASSIGN, "="};
+        type = TokenType::ASSIGN;
       }
       break;
     case '-':
       if (schar == '>') {
-        token = {TokenType::ARROW, "->"};
+        type = TokenType::ARROW;
+        len = 2;
       } else {
-        token = {TokenType::MINUS, "-"};
+        type = TokenType::MINUS;
       }
       break;
     case '>':
       if (schar == '=') {
-        token = {TokenType::GEQ, ">="};
+        type = TokenType::GEQ;
+        len = 2;
       } else {
-        token = {TokenType::GT, ">"};
+        type = TokenType::GT;
       }
       break;
     case '<':
       if (schar == '=') {
-        token = {TokenType::LEQ, "<="};
+        type = TokenType::LEQ;
+        len = 2;
       } else {
-        token = {TokenType::LT, "<"};
+        type = TokenType::LT;
       }
       break;
     case '.':
       if (schar == '.') {
-        token = {TokenType::DOTS, ".."};
+        type = TokenType::DOTS;
+        len = 2;
       } else {
-        token = {TokenType::DOT, "."};
+        type = TokenType::DOT;
       }
       break;
     case '!':
-      if (schar == '=') {
-        token = {TokenType::NEQ, "!="};
+      if (schar != '=') {
+        return std::nullopt;
       }
+      type = TokenType::NEQ;
+      len = 2;
       break;
   } // end of switch
 
-  token.pos = this->pos;
-  if (!token.value.empty()) {
-    shiftPos(token.value.length());
-    return token;
-  }
-
-  return std::nullopt;
+  Token token{type, src.substr(cursor, len), pos};
+  advance(len);
+  return token;
 }
 
 /**
- * @brief  获取下一个词法单元
- * @return next token，如果识别到未知 token 则返回 std::nullopt
+ * @brief  扫描下一个词法单元
+ * @return next token，无法识别的字符以长度为 1 的 UNKNOWN token 返回
  */
-std::optional<Token>
-Lexer::nextToken()
+Token
+Lexer::scan()
 {
-  // 检测当前是否已经到达结尾
-  if (pos.row >= text.size()) {
-    return Token{TokenType::END, "#", pos};
+  skipBlankAndComments();
+
+  // 判断是否到结尾
+  if (cursor >= src.length()) {
+    return Token{TokenType::END, "#", {text.lineCount(), 0}};
   }
 
-  // 忽略所有空白字符
-  while (pos.row < text.size()) {
-    if (text[pos.row].empty()) { // 忽略空行
-      ++pos.row;
-      pos.col = 0;
-    } else if ( // 忽略空白字符
-      static_cast<bool>(std::isspace(text[pos.row][pos.col]))
-    ) {
-      shiftPos(1);
-    } else {
+  // 根据首字符的类别分发到对应的扫描过程
+  switch (charClass(src[cursor])) {
+    case CharClass::IDSTART:
+      return scanIdentifier();
+    case CharClass::DIGIT:
+      return scanInteger();
+    case CharClass::PUNCT:
+      if (auto token = scanPunct(); token.has_value()) {
+        return token.value();
+      }
+      break;
+    default:
       break;
-    } // end of if
-  } // end of while
-
-  // 再次判断是否到结尾
-  if (pos.row >= text.size()) {
-    return Token{TokenType::END, "#", pos};
   }
 
-  // 使用正则表达式识别 INT、ID
-  std::string view{text[pos.row].substr(pos.col)};
-  auto token = matchThroughRE(view);
-  if (token.has_value()) {
-    return token;
-  }
+  Token token{TokenType::UNKNOWN, src.substr(cursor, 1), pos};
+  advance(1);
+  return token;
+}
 
-  // 使用 DFA 识别算符、界符等符号
-  token = matchThroughDFA(view);
-  if (token.has_value()) {
+/**
+ * @brief  获取下一个词法单元
+ * @return next token，如果识别到未知 token 则返回 std::nullopt
+ */
+std::optional<Token>
+Lexer::nextToken()
+{
+  auto token = scan();
+  if (token.type != TokenType::UNKNOWN) {
     return token;
   }
 
-  auto errpos = pos;
-  shiftPos(1);
-
+  std::string view{token.value};
   reporter.report(
     err::LexErrType::UNKNOWN_TOKEN,
-    std::format("识别到未知的 token: {}", view.substr(0, 1)),
-    errpos, view.substr(0, 1)
+    std::format("识别到未知的 token: {}", view),
+    token.pos, view
   );
 
   return std::nullopt;
 }
 
+/**
+ * @brief   一次性扫描整个源文件，得到词法单元流
+ * @details 未知字符以 UNKNOWN token 的形式留在流中，由使用者决定
+ *          何时报告；流总是以 END 结尾
+ * @return  token stream
+ */
+TokenStream
+Lexer::tokenize()
+{
+  TokenStream stream{text, interner};
+  stream.reserve(src.length() / 4 + 1); // 粗略估计：平均每 4 个字节一个 token
+
+  while (true) {
+    auto token = scan();
+    if (token.type == TokenType::END) {
+      stream.push(TokenType::END, src.length(), 0);
+      break;
+    }
+    stream.push(token.type,
+      static_cast<std::size_t>(token.value.data() - src.data()),
+      token.value.length(), token.name.id
+    );
+  }
+
+  return stream;
+}
+
 } // namespace lex
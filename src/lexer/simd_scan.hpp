@@ -0,0 +1,219 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "char_class.hpp"
+
+// 按编译目标选择向量指令集：AVX2 > SSE2 > NEON > 标量
+// NOTE: x86-64 总是支持 SSE2；AVX2 需要 -mavx2 或 -march=native（make NATIVE=1）；
+//       定义 LEX_NO_SIMD 可以强制使用标量路径
+#if defined(LEX_NO_SIMD)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define LEX_SIMD_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LEX_SIMD_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LEX_SIMD_NEON 1
+#endif
+
+namespace lex::simd {
+
+// 可以批量跳过的字符序列
+enum class Run : std::uint8_t {
+  SPACE, // 除换行外的空白字符
+  IDENT, // [a-zA-Z0-9_]
+  DIGIT, // [0-9]
+};
+
+/**
+ * @brief 标量判断：字符是否属于给定的序列
+ */
+template<Run R>
+constexpr bool
+inRun(char c)
+{
+  if constexpr (R == Run::SPACE) {
+    return charClass(c) == CharClass::SPACE;
+  } else if constexpr (R == Run::IDENT) {
+    return isIdentChar(c);
+  } else {
+    return charClass(c) == CharClass::DIGIT;
+  }
+}
+
+#if defined(LEX_SIMD_AVX2)
+
+inline constexpr const char   *ISA   = "avx2";
+inline constexpr std::size_t   WIDTH = 32; // 每次分类的字节数
+inline constexpr unsigned      BITS  = 1;  // 掩码中每个字节占用的位数
+inline constexpr std::uint64_t FULL  = 0xFFFFFFFFull;
+
+/**
+ * @brief  分类 WIDTH 个字节
+ * @return 属于给定序列的字节对应位为 1 的掩码
+ */
+template<Run R>
+inline std::uint64_t
+matchMask(const char *p)
+{
+  auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  auto between = [&v](char lo, char hi) { // lo <= v <= hi（有符号比较，>= 0x80 的字节不匹配）
+    return _mm256_and_si256(
+      _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v)
+    );
+  };
+
+  __m256i m;
+  if constexpr (R == Run::SPACE) {
+    m = _mm256_or_si256(
+      _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+      _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), between('\t', '\r'))
+    );
+  } else if constexpr (R == Run::IDENT) {
+    auto lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    auto alpha = _mm256_and_si256(
+      _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+      _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower)
+    );
+    m = _mm256_or_si256(
+      _mm256_or_si256(alpha, between('0', '9')),
+      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'))
+    );
+  } else {
+    m = between('0', '9');
+  }
+
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));
+}
+
+#elif defined(LEX_SIMD_SSE2)
+
+inline constexpr const char   *ISA   = "sse2";
+inline constexpr std::size_t   WIDTH = 16;
+inline constexpr unsigned      BITS  = 1;
+inline constexpr std::uint64_t FULL  = 0xFFFFull;
+
+template<Run R>
+inline std::uint64_t
+matchMask(const char *p)
+{
+  auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  auto between = [&v](char lo, char hi) {
+    return _mm_and_si128(
+      _mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+      _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(hi + 1)), v)
+    );
+  };
+
+  __m128i m;
+  if constexpr (R == Run::SPACE) {
+    m = _mm_or_si128(
+      _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+      _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), between('\t', '\r'))
+    );
+  } else if constexpr (R == Run::IDENT) {
+    auto lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    auto alpha = _mm_and_si128(
+      _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+      _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), lower)
+    );
+    m = _mm_or_si128(
+      _mm_or_si128(alpha, between('0', '9')),
+      _mm_cmpeq_epi8(v, _mm_set1_epi8('_'))
+    );
+  } else {
+    m = between('0', '9');
+  }
+
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(m));
+}
+
+#elif defined(LEX_SIMD_NEON)
+
+inline constexpr const char   *ISA   = "neon";
+inline constexpr std::size_t   WIDTH = 16;
+inline constexpr unsigned      BITS  = 4; // NEON 没有 movemask，用窄化移位得到每字节 4 位的掩码
+inline constexpr std::uint64_t FULL  = ~0ull;
+
+template<Run R>
+inline std::uint64_t
+matchMask(const char *p)
+{
+  auto v = vld1q_u8(reinterpret_cast<const std::uint8_t *>(p));
+  auto between = [](uint8x16_t x, std::uint8_t lo, std::uint8_t hi) {
+    return vandq_u8(vcgeq_u8(x, vdupq_n_u8(lo)), vcleq_u8(x, vdupq_n_u8(hi)));
+  };
+
+  uint8x16_t m;
+  if constexpr (R == Run::SPACE) {
+    m = vorrq_u8(
+      vceqq_u8(v, vdupq_n_u8(' ')),
+      vbicq_u8(between(v, '\t', '\r'), vceqq_u8(v, vdupq_n_u8('\n')))
+    );
+  } else if constexpr (R == Run::IDENT) {
+    auto lower = vorrq_u8(v, vdupq_n_u8(0x20));
+    m = vorrq_u8(
+      vorrq_u8(between(lower, 'a', 'z'), between(v, '0', '9')),
+      vceqq_u8(v, vdupq_n_u8('_'))
+    );
+  } else {
+    m = between(v, '0', '9');
+  }
+
+  auto narrowed = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+#else
+
+inline constexpr const char *ISA = "scalar";
+
+#endif
+
+// 进入向量路径前用标量方式检查的字节数
+inline constexpr std::size_t SCALAR_PREFIX = 8;
+
+/**
+ * @brief  计算从 p 开始、属于给定序列的最长前缀长度
+ * @param  p   起始地址
+ * @param  end 缓冲区末尾（不会越过 end 读取）
+ * @return 前缀长度
+ */
+template<Run R>
+inline std::size_t
+runLength(const char *p, const char *end)
+{
+  const char *q = p;
+
+  // 大多数空白与标识符都很短，先用标量路径处理开头的几个字节，
+  // 只有长序列才值得启用向量分类
+  for (std::size_t i = 0; i < SCALAR_PREFIX && q < end; ++i, ++q) {
+    if (!inRun<R>(*q)) {
+      return static_cast<std::size_t>(q - p);
+    }
+  }
+
+#if defined(LEX_SIMD_AVX2) || defined(LEX_SIMD_SSE2) || defined(LEX_SIMD_NEON)
+  while (static_cast<std::size_t>(end - q) >= WIDTH) {
+    std::uint64_t miss = ~matchMask<R>(q) & FULL;
+    if (miss != 0) {
+      return static_cast<std::size_t>(q - p) + std::countr_zero(miss) / BITS;
+    }
+    q += WIDTH;
+  }
+#endif
+
+  // 剩余不足一个向量宽度的部分走标量路径
+  while (q < end && inRun<R>(*q)) {
+    ++q;
+  }
+  return static_cast<std::size_t>(q - p);
+}
+
+} // namespace lex::simd
@@ -2,8 +2,9 @@
 
 #include <string>
 #include <cstdint>
-#include <sstream>
+#include <string_view>
 
+#include "interner.hpp"
 #include "position.hpp"
 #include "token_type.hpp"
 
@@ -11,15 +12,17 @@ namespace lex {
 
 enum class TokenType : std::uint8_t;
 
+// NOTE: Token 不持有任何堆内存，可以廉价地拷贝
 struct Token {
-  TokenType      type;  // token type
-  std::string    value; // 组成 token 的字符串
-  util::Position pos;   // position
+  TokenType        type;  // token type
+  std::string_view value; // 组成 token 的字符串（指向源缓冲区）
+  util::Position   pos;   // position
+  util::Name       name;  // 驻留后的标识符，仅对 ID 有效
 
   Token() = default;
-  Token(TokenType type, std::string value,
-    util::Position pos = {0, 0}
-  ) : type(type), value(std::move(value)), pos(pos) {}
+  Token(TokenType type, std::string_view value,
+    util::Position pos = {0, 0}, util::Name name = {}
+  ) : type(type), value(value), pos(pos), name(name) {}
   ~Token() = default;
 
   /**
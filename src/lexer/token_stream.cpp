@@ -0,0 +1,84 @@
+#include <limits>
+
+#include "panic.hpp"
+#include "token_stream.hpp"
+
+namespace lex {
+
+/**
+ * @brief 预留 n 个 token 的空间
+ */
+void
+TokenStream::reserve(std::size_t n)
+{
+  types.reserve(n);
+  offsets.reserve(n);
+  lengths.reserve(n);
+  ids.reserve(n);
+}
+
+/**
+ * @brief 在流末尾追加一个 token
+ * @param type   token type
+ * @param offset token 在缓冲区中的起始偏移
+ * @param length token 长度
+ * @param id     驻留后的标识符 id（非 ID token 为 INVALID_SYMBOL）
+ */
+void
+TokenStream::push(TokenType type, std::size_t offset, std::size_t length,
+  util::SymbolId id)
+{
+  ASSERT_MSG(offset <= std::numeric_limits<std::uint32_t>::max(),
+    "源文件过大，token 偏移超出 32 位范围");
+
+  types.push_back(type);
+  offsets.push_back(static_cast<std::uint32_t>(offset));
+  lengths.push_back(static_cast<std::uint32_t>(length));
+  ids.push_back(id);
+}
+
+/**
+ * @brief  获取第 i 个 token 的字符串
+ * @return 指向源缓冲区的 string_view，END 固定为 "#"
+ */
+std::string_view
+TokenStream::value(std::size_t i) const
+{
+  if (types[i] == TokenType::END) {
+    return "#";
+  }
+  return text.text().substr(offsets[i], lengths[i]);
+}
+
+/**
+ * @brief  获取第 i 个 token 驻留后的标识符
+ * @return 非 ID token 返回无效的 Name
+ */
+util::Name
+TokenStream::name(std::size_t i) const
+{
+  if (ids[i] == util::INVALID_SYMBOL) {
+    return {};
+  }
+  return interner.get(ids[i]);
+}
+
+/**
+ * @brief  获取第 i 个 token 的位置（由偏移惰性换算）
+ */
+util::Position
+TokenStream::pos(std::size_t i) const
+{
+  return text.position(offsets[i]);
+}
+
+/**
+ * @brief  将第 i 个 token 物化为 Token
+ */
+Token
+TokenStream::at(std::size_t i) const
+{
+  return Token{types[i], value(i), pos(i), name(i)};
+}
+
+} // namespace lex
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#include "token.hpp"
+#include "interner.hpp"
+#include "source_buffer.hpp"
+
+namespace lex {
+
+/**
+ * @brief   整个源文件的词法单元流
+ * @details 以结构体数组（SoA）的形式保存 token：类型、偏移、长度、标识符 id
+ *          各占一列，顺序扫描时只触及需要的列；行列号不单独保存，
+ *          需要时再通过 SourceBuffer 的换行符索引由偏移换算得到。
+ *          流的最后一个 token 总是 END
+ */
+class TokenStream {
+public:
+  TokenStream(const util::SourceBuffer &text, const util::Interner &interner)
+    : text(text), interner(interner) {}
+  ~TokenStream() = default;
+
+  TokenStream(TokenStream &&) = default;
+  TokenStream(const TokenStream &) = delete;
+  TokenStream &operator=(const TokenStream &) = delete;
+
+public:
+  void reserve(std::size_t n);
+  void push(TokenType type, std::size_t offset, std::size_t length,
+    util::SymbolId id = util::INVALID_SYMBOL);
+
+  [[nodiscard]] std::size_t size() const {
+    return types.size();
+  }
+
+  [[nodiscard]] TokenType type(std::size_t i) const {
+    return types[i];
+  }
+
+  [[nodiscard]] std::size_t offset(std::size_t i) const {
+    return offsets[i];
+  }
+
+  [[nodiscard]] std::size_t length(std::size_t i) const {
+    return lengths[i];
+  }
+
+  [[nodiscard]] auto value(std::size_t i) const -> std::string_view;
+  [[nodiscard]] auto name(std::size_t i) const -> util::Name;
+  [[nodiscard]] auto pos(std::size_t i) const -> util::Position;
+  [[nodiscard]] auto at(std::size_t i) const -> Token;
+
+private:
+  const util::SourceBuffer &text;     // 被扫描的源文件
+  const util::Interner     &interner; // 标识符驻留池
+
+  std::vector<TokenType>      types;   // token type
+  std::vector<std::uint32_t>  offsets; // token 在缓冲区中的起始偏移
+  std::vector<std::uint32_t>  lengths; // token 长度
+  std::vector<util::SymbolId> ids;     // 驻留后的标识符 id，仅对 ID 有效
+};
+
+} // namespace lex
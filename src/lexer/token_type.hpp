@@ -54,7 +54,8 @@ namespace lex {
   _(GEQ)        \
   _(LEQ)        \
   _(DOTS)       \
-  _(ARROW)
+  _(ARROW)      \
+  _(UNKNOWN)
 
 // token 类型
 enum class TokenType : std::uint8_t {
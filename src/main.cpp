@@ -1,8 +1,22 @@
 #include <getopt.h>
 
 #include <print>
+#include <string>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+#include <optional>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
 
+#include "timer.hpp"
+#include "batch.hpp"
+#include "server.hpp"
+#include "parallel.hpp"
 #include "compiler.hpp"
+#include "time_report.hpp"
 
 /**
  * @brief 打印版本信息
@@ -26,21 +40,78 @@ printVersion()
 void
 printHelp(const char *const exec)
 {
-  std::println("Usage: {} [options]", exec);
+  std::println("Usage: {} [options] [file...] [@response-file]", exec);
   std::println("");
   std::println("This is a Rust-like programming language compiler.");
   std::println("");
   std::println("Options:");
   std::println("  -h, --help             show help");
   std::println("  -v, -V, --version      show version");
-  std::println("  -i, --input filename   set input file (with suffix, must set an input filename)");
-  std::println("  -o, --output filename  set output file (without suffix)");
+  std::println("  -i, --input filename   add an input file (with suffix, may be given several times)");
+  std::println("  -o, --output filename  set output file (without suffix); output directory with several inputs");
+  std::println("                         '-' writes to stdout, e.g. to pipe into an assembler");
   std::println("  --ir,                  generate IR only");
   std::println("  --asm,                 generate RISC-V Assembly only");
+  std::println("  --obj,                 generate a RISC-V ELF relocatable object (.o) without an assembler;");
+  std::println("                         does not use --cache-dir");
+  std::println("  --run                  run the program with the IR interpreter instead of generating code:");
+  std::println("                         calls main0 (or main), prints its return value like riscv-asm/main.c");
+  std::println("                         and exits with it; one input file only, does not use --cache-dir");
+  std::println("  --emit-ir-bin          also write the optimized IR as a binary file (<output>.irb) that");
+  std::println("                         --from-ir-bin reads back; does not use --cache-dir");
+  std::println("  --from-ir-bin          the input files are .irb files: skip the front end and the passes,");
+  std::println("                         generate IR text, assembly or an object from the stored IR");
+  std::println("  -O level               optimization level (0: none, default; 1: SSA-based function passes)");
+  std::println("  --unroll N             with -O1, unroll range for loops with a constant trip count up to N times");
+  std::println("  -finline-threshold=N   with -O1, inline calls whose callee costs at most N quads more than");
+  std::println("                         the call itself (default: 16, 0: no inlining)");
+  std::println("  -fregalloc=kind        register allocator: linear (linear scan over live intervals, default)");
+  std::println("                         or greedy (in IR order, round-robin spilling)");
+  std::println("  -fschedule=on|off      reorder instructions within basic blocks to hide load, mul and div");
+  std::println("                         latencies (default: on)");
+  std::println("  -mtune=core            instruction costs used for multiplying and dividing by constants and");
+  std::println("                         for scheduling: generic (default), rocket, sifive-u74 or serial");
+  std::println("                         (no fast mul/div)");
+  std::println("  -march=isa             target ISA: rv64g (default); rv64gc prefers 16-bit compressed instructions");
+  std::println("                         and reports the code size of every function; rv64gcv also vectorizes");
+  std::println("                         loops over i32 arrays into RVV instructions");
+  std::println("  -j, --jobs N           use N threads (0: all cores, default: 1): per function with one input,");
+  std::println("                         per file with several inputs");
+  std::println("  --summary              print the compile time of every input file");
+  std::println("  --time-report[=file]   time every phase and pass, count tokens, quads, spills and machine");
+  std::println("                         instructions and the bytes allocated; print a table to stderr, or");
+  std::println("                         write a Chrome trace (chrome://tracing, Perfetto) to file");
+  std::println("  @file                  read further arguments from file (whitespace separated)");
+  std::println("  --server[=socket]      stay resident and serve line-delimited JSON compile requests");
+  std::println("                         on stdin/stdout, or on a Unix domain socket");
+  std::println("  --cache-dir dir        reuse the output of unchanged functions from an on-disk cache,");
+  std::println("                         print hit/miss statistics");
+  std::println("  --max-errors N         stop after N errors (default: 0, no limit)");
+  std::println("  -fmax-nesting=N        reject expressions nested more than N levels deep, counting blocks,");
+  std::println("                         brackets, calls and operators (default: 1024, 0: no limit)");
+  std::println("  -fprune-funcs=on|off   keep only the functions reachable from main, main0 and the -fexport");
+  std::println("                         roots: the others are declared but their bodies are not checked,");
+  std::println("                         lowered or compiled (default: off)");
+  std::println("  -fexport=name[,name]   with -fprune-funcs=on, also keep name and the functions it calls");
+  std::println("  --error-format fmt     print diagnostics as text (default) or json (one object per line)");
+  std::println("  --dump-cfg             write the control-flow graph of every function to <output>.cfg.dot");
+  std::println("  --profile-generate     count how often every basic block runs; the program built from the");
+  std::println("                         assembly with riscv-asm/main.c writes the counts to toy.profdata");
+  std::println("                         (or $TOY_PROFILE) when main0 returns");
+  std::println("  --profile-use=file     use the block counts of file for inlining, unrolling and spill costs");
+  std::println("                         (does not use --cache-dir)");
   std::println("");
   std::println("Examples:");
   std::println("  $ path/to/toy_compiler --ir -i test.txt");
   std::println("  $ path/to/toy_compiler --ir -i test.txt -o output");
+  std::println("  $ path/to/toy_compiler --asm -j 8 -i test.txt");
+  std::println("  $ path/to/toy_compiler --asm -O1 -i test.txt");
+  std::println("  $ path/to/toy_compiler --run -O1 -i test.txt");
+  std::println("  $ path/to/toy_compiler --asm -O1 -fprune-funcs=on -fexport=helper -i test.txt");
+  std::println("  $ path/to/toy_compiler --asm -i test.txt -o - | riscv64-linux-gnu-as -o test.o");
+  std::println("  $ path/to/toy_compiler --emit-ir-bin -O1 -i test.txt -o test");
+  std::println("  $ path/to/toy_compiler --from-ir-bin --asm -i test.irb");
+  std::println("  $ path/to/toy_compiler --asm -j 0 --summary -o out a.rs b.rs @more.txt");
   std::println("");
   std::println("Tips:");
   std::println("  Upon completion of the program execution, you can run this command");
@@ -50,34 +121,171 @@ printHelp(const char *const exec)
 
 // 定义长选项
 static constexpr struct option options[] = {
-    {.name = "help",    .has_arg = no_argument,       .flag = nullptr, .val = 'h'},
-    {.name = "version", .has_arg = no_argument,       .flag = nullptr, .val = 'v'},
-    {.name = "input",   .has_arg = required_argument, .flag = nullptr, .val = 'i'},
-    {.name = "output",  .has_arg = required_argument, .flag = nullptr, .val = 'o'},
-    {.name = "ir",      .has_arg = no_argument,       .flag = nullptr, .val = 'r'},
-    {.name = "asm",     .has_arg = no_argument,       .flag = nullptr, .val = 'a'},
-    {.name = nullptr,   .has_arg = 0,                 .flag = nullptr, .val = 0} // 结束标志
+    {.name = "help",         .has_arg = no_argument,       .flag = nullptr, .val = 'h'},
+    {.name = "version",      .has_arg = no_argument,       .flag = nullptr, .val = 'v'},
+    {.name = "input",        .has_arg = required_argument, .flag = nullptr, .val = 'i'},
+    {.name = "output",       .has_arg = required_argument, .flag = nullptr, .val = 'o'},
+    {.name = "ir",           .has_arg = no_argument,       .flag = nullptr, .val = 'r'},
+    {.name = "asm",          .has_arg = no_argument,       .flag = nullptr, .val = 'a'},
+    {.name = "obj",          .has_arg = no_argument,       .flag = nullptr, .val = 'b'},
+    {.name = "emit-ir-bin",  .has_arg = no_argument,       .flag = nullptr, .val = 'B'},
+    {.name = "from-ir-bin",  .has_arg = no_argument,       .flag = nullptr, .val = 'F'},
+    {.name = "run",          .has_arg = no_argument,       .flag = nullptr, .val = 'R'},
+    {.name = "jobs",         .has_arg = required_argument, .flag = nullptr, .val = 'j'},
+    {.name = "summary",      .has_arg = no_argument,       .flag = nullptr, .val = 's'},
+    {.name = "server",       .has_arg = optional_argument, .flag = nullptr, .val = 'S'},
+    {.name = "cache-dir",    .has_arg = required_argument, .flag = nullptr, .val = 'C'},
+    {.name = "max-errors",   .has_arg = required_argument, .flag = nullptr, .val = 'M'},
+    {.name = "error-format", .has_arg = required_argument, .flag = nullptr, .val = 'E'},
+    {.name = "dump-cfg",     .has_arg = no_argument,       .flag = nullptr, .val = 'D'},
+    {.name = "unroll",       .has_arg = required_argument, .flag = nullptr, .val = 'U'},
+    {.name = "profile-generate", .has_arg = no_argument,   .flag = nullptr, .val = 'P'},
+    {.name = "profile-use",  .has_arg = required_argument, .flag = nullptr, .val = 'u'},
+    {.name = "time-report",  .has_arg = optional_argument, .flag = nullptr, .val = 'T'},
+    {.name = nullptr,        .has_arg = 0,                 .flag = nullptr, .val = 0} // 结束标志
 };
 
+// 命令行选项
+struct Options {
+  bool flag_summary     = false;
+  bool flag_server      = false;
+  bool flag_time_report = false;
+
+  std::vector<std::string> in_files;  // 输入文件名
+  std::string              out_file;  // 输出文件名（批量编译时为输出目录）
+  std::string              socket;    // server 模式下监听的 socket，为空时使用标准输入输出
+  std::string              cache_dir; // 增量编译缓存目录，为空时不使用缓存
+  std::string              profile;   // 剖析数据文件（--profile-use），为空时不使用
+  std::string              trace;     // --time-report 的 trace 文件，为空时向标准错误输出表格
+
+  cpr::CompileOptions compile; // 每个文件的编译选项
+
+  unsigned jobs = 1; // 线程数
+};
+
+/**
+ * @brief   展开 @file 形式的参数
+ * @details response file 中的参数以空白分隔，# 开头的行是注释；不支持嵌套
+ * @param   argc argument counter
+ * @param   argv argument vector
+ * @return  展开后的参数列表
+ */
+std::vector<std::string>
+expandResponseFiles(int argc, char *argv[])
+{
+  std::vector<std::string> args;
+  for (int i = 0; i < argc; ++i) {
+    std::string_view arg{argv[i]};
+    if (i == 0 || !arg.starts_with('@')) {
+      args.emplace_back(arg);
+      continue;
+    }
+
+    std::ifstream in{std::string{arg.substr(1)}};
+    if (!in) {
+      std::println(stderr, "无法打开 response file: {}", arg.substr(1));
+      exit(1);
+    }
+    for (std::string line; std::getline(in, line);) {
+      if (line.starts_with('#')) {
+        continue;
+      }
+      std::istringstream iss{line};
+      for (std::string word; iss >> word;) {
+        args.push_back(std::move(word));
+      }
+    }
+  }
+  return args;
+}
+
+/**
+ * @brief  解析 -f 开头的参数（-fname=value）
+ * @param  opts 命令行选项
+ * @param  arg  -f 之后的部分
+ * @return 是否是已知的参数
+ */
+bool
+parseFlag(Options &opts, std::string_view arg)
+{
+  auto eq    = arg.find('=');
+  auto name  = arg.substr(0, eq);
+  auto value = eq == std::string_view::npos ? std::string_view{} : arg.substr(eq + 1);
+
+  if (name == "inline-threshold" && !value.empty()) {
+    opts.compile.optim.inline_threshold = static_cast<unsigned>(std::strtoul(value.data(), nullptr, 10));
+    return true;
+  }
+  if (name == "max-nesting" && !value.empty()) {
+    opts.compile.max_nesting = std::strtoul(value.data(), nullptr, 10);
+    return true;
+  }
+  if (name == "prune-funcs" && (value == "on" || value == "off")) {
+    opts.compile.prune_funcs = value == "on";
+    return true;
+  }
+  if (name == "export" && !value.empty()) {
+    for (std::size_t pos = 0; pos <= value.size();) {
+      auto end = std::min(value.find(',', pos), value.size());
+      if (end > pos) {
+        opts.compile.exports.emplace_back(value.substr(pos, end - pos));
+      }
+      pos = end + 1;
+    }
+    return true;
+  }
+  if (name == "regalloc" && (value == "linear" || value == "greedy")) {
+    opts.compile.codegen.regalloc = value == "linear" ? cg::RegAllocKind::LINEAR_SCAN : cg::RegAllocKind::GREEDY;
+    return true;
+  }
+  if (name == "schedule" && (value == "on" || value == "off")) {
+    opts.compile.codegen.schedule = value == "on";
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief  解析 -march= 之后的目标架构：rv64g 之后可以跟 c（压缩指令）与 v（向量扩展）
+ * @param  opts 命令行选项
+ * @param  arch 架构字符串，如 rv64gcv
+ * @return 是否是支持的架构
+ */
+bool
+parseArch(Options &opts, std::string_view arch)
+{
+  if (!arch.starts_with("rv64g")) {
+    return false;
+  }
+  opts.compile.codegen.vector   = false;
+  opts.compile.codegen.compress = false;
+  for (auto ext : arch.substr(5)) {
+    if (ext == 'v') {
+      opts.compile.codegen.vector = true;
+    } else if (ext == 'c') {
+      opts.compile.codegen.compress = true;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
  * @brief  参数解析
  * @param  argc argument counter
  * @param  argv argument vector
- * @return tuple: flag_ir, in_file, out_file
+ * @return 解析得到的选项
  */
-auto
+Options
 argumentParsing(int argc, char *argv[])
 {
   int opt; // option
 
-  bool flag_ir  = false;
-  bool flag_asm = false;
-
-  std::string in_file{};  // 输入文件名
-  std::string out_file{}; // 输出文件名
+  Options opts;
 
   // 参数解析
-  while ((opt = getopt_long(argc, argv, "hvVi:o:ra", options, nullptr)) != -1) {
+  while ((opt = getopt_long(argc, argv, "hvVi:o:raj:O:f:m:", options, nullptr)) != -1) {
     switch (opt) {
       case 'h': // help
         printHelp(argv[0]);
@@ -87,16 +295,94 @@ argumentParsing(int argc, char *argv[])
         printVersion();
         exit(0);
       case 'i': // input
-        in_file = std::string{optarg};
+        opts.in_files.emplace_back(optarg);
         break;
       case 'o': // output
-        out_file = std::string{optarg};
+        opts.out_file = std::string{optarg};
         break;
       case 'r': // ir
-        flag_ir = true;
+        opts.compile.flag_ir = true;
         break;
       case 'a': // asm
-        flag_asm = true;
+        opts.compile.flag_asm = true;
+        break;
+      case 'b': // obj
+        opts.compile.flag_obj = true;
+        break;
+      case 'B': // emit-ir-bin
+        opts.compile.flag_ir_bin = true;
+        break;
+      case 'F': // from-ir-bin
+        opts.compile.from_ir_bin = true;
+        break;
+      case 'R': // run
+        opts.compile.flag_run = true;
+        break;
+      case 'O': // optimization level
+        opts.compile.optim.level = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10));
+        break;
+      case 'f': // -fname=value
+        if (!parseFlag(opts, optarg)) {
+          std::println(stderr, "未知的参数: -f{}", optarg);
+          exit(1);
+        }
+        break;
+      case 'm': // -mtune=core, -march=isa
+        if (std::string_view arg{optarg}; arg.starts_with("tune=") && cg::findTarget(arg.substr(5)) != nullptr) {
+          opts.compile.codegen.target = cg::findTarget(arg.substr(5));
+        } else if (!arg.starts_with("arch=") || !parseArch(opts, arg.substr(5))) {
+          std::println(stderr, "未知的参数: -m{}", optarg);
+          exit(1);
+        }
+        break;
+      case 'U': // unroll
+        opts.compile.optim.unroll = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10));
+        break;
+      case 's': // summary
+        opts.flag_summary = true;
+        break;
+      case 'S': // server
+        opts.flag_server = true;
+        if (optarg != nullptr) {
+          opts.socket = std::string{optarg};
+        }
+        break;
+      case 'C': // cache-dir
+        opts.cache_dir = std::string{optarg};
+        break;
+      case 'D': // dump-cfg
+        opts.compile.dump_cfg = true;
+        break;
+      case 'P': // profile-generate
+        opts.compile.profile_gen = true;
+        break;
+      case 'u': // profile-use
+        opts.profile = std::string{optarg};
+        break;
+      case 'T': // time-report
+        opts.flag_time_report = true;
+        if (optarg != nullptr) {
+          opts.trace = std::string{optarg};
+        }
+        break;
+      case 'M': // max-errors
+        opts.compile.report.max_errs = std::strtoul(optarg, nullptr, 10);
+        break;
+      case 'E': // error-format
+        if (std::string_view{optarg} == "json") {
+          opts.compile.report.format = err::ErrFormat::JSON;
+        } else if (std::string_view{optarg} == "text") {
+          opts.compile.report.format = err::ErrFormat::TEXT;
+        } else {
+          std::println(stderr, "未知的诊断输出格式: {}（可选 text、json）", optarg);
+          exit(1);
+        }
+        break;
+      case 'j': // jobs
+        opts.jobs = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10));
+        if (opts.jobs == 0) {
+          opts.jobs = util::defaultJobs();
+        }
         break;
       case '?': // 无效选项
         std::println(stderr, "解析到未知参数");
@@ -105,31 +391,126 @@ argumentParsing(int argc, char *argv[])
     } // end switch
   } // end while
 
-  if (in_file.empty()) {
+  // 其余的非选项参数也作为输入文件
+  for (int i = optind; i < argc; ++i) {
+    opts.in_files.emplace_back(argv[i]);
+  }
+
+  if (opts.in_files.empty() && !opts.flag_server) {
     std::println(stderr, "缺失命令行参数: -i/--input");
     exit(1);
   }
+  if (opts.compile.from_ir_bin && opts.compile.profile_gen) {
+    std::println(stderr, "--from-ir-bin 不能与 --profile-generate 一起使用（插桩在优化之前进行）");
+    exit(1);
+  }
+  if (opts.compile.flag_run && (opts.in_files.size() > 1 || opts.flag_server)) {
+    std::println(stderr, "--run 只能用于一个输入文件");
+    exit(1);
+  }
+  bool linear = opts.compile.codegen.regalloc == cg::RegAllocKind::LINEAR_SCAN;
+  if (opts.compile.profile_gen && (opts.compile.flag_obj || !linear)) {
+    std::println(stderr, "--profile-generate 需要 --asm 与 -fregalloc=linear（计数器数组定义在汇编中）");
+    exit(1);
+  }
 
-  return std::make_tuple(flag_ir, flag_asm, in_file, out_file);
+  return opts;
 }
 
 /**
  * @brief   主函数
- * @details 初始化 compiler 并调用其提供的函数完成任务
+ * @details 初始化 compiler 并调用其提供的函数完成任务；
+ *          有多个输入文件时，每个文件由独立的 compiler 并发编译
  */
 int
 main(int argc, char *argv[])
 {
-  auto [flag_ir, flag_asm, in_file, out_file] = argumentParsing(argc, argv);
+  auto args = expandResponseFiles(argc, argv);
+  std::vector<char *> cargs;
+  for (auto &arg : args) {
+    cargs.push_back(arg.data());
+  }
+  cargs.push_back(nullptr);
+
+  auto opts = argumentParsing(static_cast<int>(args.size()), cargs.data());
+
+  std::unique_ptr<cpr::FuncCache> cache;
+  if (!opts.cache_dir.empty()) {
+    cache = std::make_unique<cpr::FuncCache>(opts.cache_dir);
+    opts.compile.cache = cache.get();
+  }
 
-  cpr::Compiler compiler(in_file);
+  std::optional<opt::Profile> profile;
+  if (!opts.profile.empty()) {
+    profile = opt::Profile::load(opts.profile);
+    if (!profile.has_value()) {
+      std::println(stderr, "无法读取剖析数据: {}", opts.profile);
+      exit(1);
+    }
+    opts.compile.profile = &profile.value();
+  }
+
+  if (opts.flag_server) {
+    cpr::Server server{opts.compile};
+    if (opts.socket.empty()) {
+      server.serveStdio();
+    } else {
+      server.serveSocket(opts.socket);
+    }
+    return 0;
+  }
 
-  if (flag_ir) {
-    compiler.generateIR(out_file);
+  // 多个输入文件时 -o 指定输出目录
+  if (opts.in_files.size() > 1 && opts.out_file == "-") {
+    std::println(stderr, "多个输入文件时不能输出到标准输出（-o -）");
+    exit(1);
+  }
+  if (opts.in_files.size() > 1 && !opts.out_file.empty()) {
+    std::filesystem::create_directories(opts.out_file);
   }
-  if (flag_asm) {
-    compiler.generateAssemble(out_file);
+  std::vector<cpr::BatchJob> jobs;
+  for (const auto &in_file : opts.in_files) {
+    jobs.push_back({
+      .input  = in_file,
+      .output = opts.in_files.size() == 1 ? opts.out_file : cpr::batchOutput(in_file, opts.out_file)
+    });
   }
 
+  // 在编译之前创建：同时开始统计内存分配
+  std::unique_ptr<util::TimeReport> report;
+  if (opts.flag_time_report) {
+    report = std::make_unique<util::TimeReport>();
+    opts.compile.time_report = report.get();
+  }
+
+  util::Timer timer;
+  timer.start();
+  cpr::compileBatch(jobs, opts.compile, opts.jobs);
+  timer.stop();
+
+  if (report != nullptr && opts.trace.empty()) {
+    std::ostringstream table;
+    report->printTable(table);
+    std::print(stderr, "{}", table.str());
+  } else if (report != nullptr) {
+    std::ofstream trace{opts.trace};
+    if (!trace) {
+      std::println(stderr, "无法打开输出文件: {}", opts.trace);
+      exit(1);
+    }
+    report->writeTrace(trace);
+  }
+
+  if (opts.flag_summary) {
+    cpr::printBatchSummary(jobs, timer.seconds());
+  }
+  if (cache != nullptr) {
+    cache->printStats();
+  }
+
+  // --run 时以程序的退出状态退出
+  if (opts.compile.flag_run) {
+    return jobs.front().status;
+  }
   return 0;
 }
@@ -0,0 +1,96 @@
+#include <print>
+
+#include "ast.hpp"
+#include "cfg_dump.hpp"
+#include "pass_manager.hpp"
+
+namespace opt {
+
+namespace {
+
+/**
+ * @brief 转义 dot 标签中的特殊字符
+ */
+std::string
+escape(std::string_view s)
+{
+  std::string str;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      str.push_back('\\');
+    }
+    str.push_back(c);
+  }
+  return str;
+}
+
+/**
+ * @brief 输出一个函数的控制流图（作为一个 cluster）
+ */
+void
+dumpFunc(std::ostream &out, ir::FuncCode &code)
+{
+  ir::Function func{code};
+  AnalysisManager am{func};
+  const auto &dom   = am.domTree();
+  const auto &loops = am.loops();
+
+  std::println(out, "  subgraph \"cluster_{}\" {{", escape(code.name));
+  std::println(out, "    label=\"{}\";", escape(code.name));
+
+  for (ir::BlockId id = 0; id < func.size(); ++id) {
+    const auto &block = func.block(id);
+
+    std::string label = std::format("B{}", id);
+    if (auto depth = loops.depth(id); depth > 0) {
+      label += std::format(" (loop depth {})", depth);
+    }
+    if (!dom.reachable(id)) {
+      label += " (unreachable)";
+    }
+    label += "\\l";
+    for (const auto &quad : block.quads) {
+      label += escape(code.str(quad));
+      label += "\\l";
+    }
+
+    bool header = loops.innermost(id) != ir::NONE && loops.loop(loops.innermost(id)).header == id;
+    std::println(out, "    \"{0}.B{1}\" [shape=box, fontname=monospace, label=\"{2}\"{3}];",
+      escape(code.name), id, label, header ? ", style=bold" : ""
+    );
+  }
+
+  for (ir::BlockId id = 0; id < func.size(); ++id) {
+    for (auto succ : func.block(id).succs) {
+      std::println(out, "    \"{0}.B{1}\" -> \"{0}.B{2}\";", escape(code.name), id, succ);
+    }
+    if (auto idom = dom.idom(id); idom != ir::NONE) {
+      std::println(out, "    \"{0}.B{1}\" -> \"{0}.B{2}\" [style=dashed, color=grey, constraint=false];",
+        escape(code.name), id, idom
+      );
+    }
+  }
+
+  std::println(out, "  }}");
+}
+
+} // namespace
+
+/**
+ * @brief 以 dot 格式输出程序中每个函数的控制流图
+ * @param out  输出流
+ * @param prog 已生成 IR 的程序
+ */
+void
+dumpCFG(std::ostream &out, const ast::Prog &prog)
+{
+  std::println(out, "digraph CFG {{");
+  for (const auto &decl : prog.decls) {
+    if (const auto &code = static_cast<ast::FuncDeclPtr>(decl)->code; code) {
+      dumpFunc(out, *code);
+    }
+  }
+  std::println(out, "}}");
+}
+
+} // namespace opt
@@ -0,0 +1,24 @@
+/**
+ * @file cfg_dump.hpp
+ * @brief Graphviz dump of the control-flow graphs of a program.
+ *
+ * Every function becomes a cluster; every basic block a box listing its
+ * quads, with its loop nesting depth. Solid edges are control flow, dashed
+ * grey edges point from a block to its immediate dominator, and loop headers
+ * are drawn bold.
+ *
+ *   $ dot -Tpng output.cfg.dot -o CFG.png
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include <ostream>
+
+namespace ast { struct Prog; }
+
+namespace opt {
+
+void dumpCFG(std::ostream &out, const ast::Prog &prog);
+
+} // namespace opt
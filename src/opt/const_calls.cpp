@@ -0,0 +1,207 @@
+#include <map>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast.hpp"
+#include "cfg.hpp"
+#include "fold.hpp"
+#include "def_use.hpp"
+#include "const_calls.hpp"
+#include "interpreter.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr std::uint64_t CALL_FUEL  = std::uint64_t{1} << 16; // 一次求值最多的跳转与调用次数
+inline constexpr std::uint64_t TOTAL_FUEL = std::uint64_t{1} << 22; // 整个程序的求值共用的跳转与调用次数
+inline constexpr std::size_t   STACK      = std::size_t{1} << 16;   // 求值时栈的上限（字）
+
+/**
+ * @brief 函数本身能否在编译期求值：形参与返回值都是标量，没有插桩
+ */
+bool
+evaluable(const ir::FuncCode &code)
+{
+  for (auto param : code.params) {
+    if (!ir::isScalar(*code.value(param))) {
+      return false;
+    }
+  }
+  return std::ranges::none_of(code.quads, [&](const IRQuad &quad) {
+    return quad.op == IROp::PROBE
+      || (quad.op == IROp::RETURN && quad.arg1 != NONE && !ir::isScalar(*code.value(quad.arg1)));
+  });
+}
+
+/**
+ * @brief 函数是否只调用纯函数（或自身）
+ * @param pure 已经确定的纯函数
+ */
+bool
+callsOnly(const ir::FuncCode &code, const std::unordered_set<std::string_view> &pure)
+{
+  return std::ranges::all_of(code.quads, [&](const IRQuad &quad) {
+    return quad.op != IROp::CALL || code.label(quad.label) == code.name || pure.contains(code.label(quad.label));
+  });
+}
+
+// 在解释器中求值纯函数的调用，记住每组实参的结果
+class Evaluator {
+public:
+  explicit Evaluator(std::span<const ir::FuncCode *const> funcs) : interpreter(funcs) {}
+
+public:
+  auto evaluate(std::string_view callee, std::vector<int> args) -> std::optional<int>;
+
+private:
+  interp::Interpreter interpreter;
+
+  std::map<std::pair<std::string_view, std::vector<int>>, std::optional<int>> memo; // 被调用者与实参 -> 返回值
+  std::uint64_t fuel = TOTAL_FUEL; // 剩余的跳转与调用次数
+};
+
+/**
+ * @brief  求值一次调用
+ * @return 返回值；越界、栈溢出、i32 运算溢出或超出预算时为 nullopt
+ */
+std::optional<int>
+Evaluator::evaluate(std::string_view callee, std::vector<int> args)
+{
+  auto key = std::make_pair(callee, std::move(args));
+  if (auto it = memo.find(key); it != memo.end()) {
+    return it->second;
+  }
+  if (fuel == 0) {
+    return std::nullopt;
+  }
+
+  // 溢出之后生成的代码（64 位寄存器）与回绕的结果可能不同，不能求值
+  auto outcome = interpreter.call(callee, key.second, {.fuel = std::min(CALL_FUEL, fuel), .stack = STACK, .checked = true});
+  fuel -= outcome.steps;
+  std::optional<int> result;
+  if (outcome.ok()) {
+    result = outcome.value;
+  }
+  memo.emplace(std::move(key), result);
+  return result;
+}
+
+/**
+ * @brief 把实参都已知的纯函数调用替换为返回值
+ * @param code 调用者
+ * @param pure 已经确定的纯函数
+ */
+void
+foldCalls(ir::FuncCode &code, const std::unordered_set<std::string_view> &pure, Evaluator &evaluator)
+{
+  std::vector<bool> alias(code.valueCount(), false); // 数组/元组元素的别名，赋值写入的是元素
+  for (const auto &quad : code.quads) {
+    if (ir::isElemAccess(quad)) {
+      alias[quad.dst] = true;
+    }
+  }
+
+  std::unordered_map<ValueId, int> known; // 当前块中已经确定为常量的标量
+  auto lookup = [&](ValueId id) -> std::optional<int> {
+    if (const auto &value = *code.value(id); value.isConst()) {
+      return ir::constValue(value);
+    }
+    auto it = known.find(id);
+    return it == known.end() ? std::nullopt : std::optional<int>{it->second};
+  };
+
+  bool changed = false;
+  std::vector<IRQuad> quads;
+  quads.reserve(code.quads.size());
+  for (const auto &quad : code.quads) {
+    if (quad.op == IROp::LABEL) {
+      known.clear();
+    }
+
+    auto out = quad;
+    if (quad.op == IROp::CALL && pure.contains(code.label(quad.label))) {
+      std::vector<int> args;
+      for (auto arg : code.elems(quad.elems)) {
+        auto value = lookup(arg);
+        if (!value.has_value()) {
+          break;
+        }
+        args.push_back(value.value());
+      }
+
+      auto result = args.size() == code.elems(quad.elems).size()
+        ? evaluator.evaluate(code.label(quad.label), std::move(args)) : std::nullopt;
+      if (result.has_value()) {
+        changed = true;
+        if (quad.dst == NONE) {
+          continue;
+        }
+        out = {.op = IROp::ASSIGN, .arg1 = code.newConst(result.value()), .dst = quad.dst};
+      }
+    }
+
+    if (out.dst != NONE) {
+      std::optional<int> value;
+      if (out.op == IROp::ASSIGN && !alias[out.dst] && ir::isScalar(*code.value(out.dst))) {
+        value = lookup(out.arg1);
+      }
+      if (value.has_value()) {
+        known.insert_or_assign(out.dst, value.value());
+      } else {
+        known.erase(out.dst);
+      }
+    }
+    quads.push_back(out);
+
+    if (ir::isTerminator(out.op)) {
+      known.clear();
+    }
+  }
+
+  if (changed) {
+    code.quads = std::move(quads);
+  }
+}
+
+} // namespace
+
+/**
+ * @brief 在编译期求值实参都是常量的纯函数调用
+ * @param prog 已生成 IR 的程序（缓存命中的函数的 code 为空）
+ */
+void
+evaluateCalls(ast::Prog &prog)
+{
+  std::vector<ir::FuncCode *> codes;
+  for (const auto &decl : prog.decls) {
+    if (const auto &code = static_cast<ast::FuncDeclPtr>(decl)->code; code) {
+      codes.push_back(code.get());
+    }
+  }
+  std::vector<const ir::FuncCode *> funcs{codes.begin(), codes.end()};
+  Evaluator evaluator{funcs};
+
+  // 按声明顺序：被调用者（除自身外）总在调用者之前确定是否是纯函数
+  std::unordered_set<std::string_view> pure;
+  for (auto *code : codes) {
+    if (evaluable(*code) && callsOnly(*code, pure)) {
+      pure.insert(code->name);
+    }
+    foldCalls(*code, pure, evaluator);
+  }
+}
+
+} // namespace opt
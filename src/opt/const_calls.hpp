@@ -0,0 +1,40 @@
+/**
+ * @file const_calls.hpp
+ * @brief Compile-time evaluation of calls to pure functions with constant arguments.
+ *
+ * A module pass over the IR as built, before inlining. Without references or
+ * globals a function can only affect its caller through its return value;
+ * what it may still do is trap (an index out of bounds), recurse without
+ * end or loop forever. A function is pure here when its parameters and its
+ * return value are scalars (i32, bool), it is not instrumented
+ * (--profile-generate), and every function it calls is pure. Calls only
+ * reach functions declared earlier or the caller itself, so one walk in
+ * declaration order settles the call graph bottom-up, recursion included.
+ *
+ * A call to a pure function whose arguments are all known (literals, or
+ * values set to a constant earlier in the same basic block, including the
+ * results of calls folded before) runs in the IR interpreter with a budget
+ * of jumps and calls and a small stack. If it returns, the call becomes
+ * dst = constant (or disappears when the result is unused) and the constant
+ * propagation of the function passes takes it from there. A call that traps,
+ * overflows the stack or runs out of budget is left to run time, and so is
+ * one whose i32 arithmetic overflows: the generated code computes in 64-bit
+ * registers, so its result may differ from the wrapped one. Results are
+ * memoized per callee and arguments, and the whole program shares one
+ * budget so the pass cannot dominate the compile time.
+ *
+ * Functions whose body was not lowered (incremental cache hits) are not
+ * pure; like for inlining, the driver lowers every function a recompiled
+ * caller calls.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+namespace ast { struct Prog; }
+
+namespace opt {
+
+void evaluateCalls(ast::Prog &prog);
+
+} // namespace opt
@@ -0,0 +1,161 @@
+#include <vector>
+#include <cstdint>
+
+#include "fold.hpp"
+#include "def_use.hpp"
+#include "copy_prop.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::ValueId;
+
+namespace {
+
+// 函数中各值的定义次数、使用次数与是否是元素别名
+struct Counts {
+  std::vector<std::uint32_t> defs;
+  std::vector<std::uint32_t> uses;
+  std::vector<bool>          alias;
+};
+
+Counts
+count(const ir::Function &func)
+{
+  const auto &code = func.funcCode();
+  auto n = code.valueCount();
+
+  Counts counts{
+    .defs  = std::vector<std::uint32_t>(n, 0),
+    .uses  = std::vector<std::uint32_t>(n, 0),
+    .alias = std::vector<bool>(n, false),
+  };
+  for (auto param : code.params) {
+    ++counts.defs[param];
+  }
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &phi : block.phis) {
+      ++counts.defs[phi.dst];
+      for (const auto &arg : phi.args) {
+        ++counts.uses[arg.value];
+      }
+    }
+    for (const auto &quad : block.quads) {
+      ir::forEachUse(code, quad, [&](ValueId value) { ++counts.uses[value]; });
+      if (auto dst = ir::definedValue(quad); dst != NONE) {
+        ++counts.defs[dst];
+        counts.alias[dst] = counts.alias[dst] || ir::isElemAccess(quad);
+      }
+    }
+  }
+  return counts;
+}
+
+/**
+ * @brief 定义的结果可以直接写入另一个标量的四元式
+ */
+inline bool
+retargetable(const IRQuad &quad)
+{
+  return ir::isBinary(quad.op) || quad.op == IROp::ASSIGN || quad.op == IROp::CALL;
+}
+
+} // namespace
+
+/**
+ * @brief 复制传播（要求函数处于 SSA 形式）
+ */
+Preserved
+propagateCopies(ir::Function &func, AnalysisManager &am)
+{
+  auto &code = func.funcCode();
+  auto counts = count(func);
+  auto n = code.valueCount();
+
+  auto stable = [&](ValueId value) {
+    return code.value(value)->isConst() || (counts.defs[value] == 1 && !counts.alias[value]);
+  };
+
+  std::vector<ValueId> repl(n, NONE);
+  bool any = false;
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &quad : block.quads) {
+      if (quad.op == IROp::ASSIGN && ir::isScalar(*code.value(quad.dst))
+        && stable(quad.dst) && stable(quad.arg1))
+      {
+        repl[quad.dst] = quad.arg1;
+        any = true;
+      }
+    }
+  }
+  if (!any) {
+    return Preserved::ALL;
+  }
+
+  // 复制链折叠到源头；SSA 形式下复制不会成环
+  auto source = [&](ValueId value) {
+    while (repl[value] != NONE) {
+      value = repl[value];
+    }
+    return value;
+  };
+
+  bool changed = false;
+  auto replace = [&](ValueId &value) {
+    if (auto src = source(value); src != value) {
+      value   = src;
+      changed = true;
+    }
+  };
+  for (auto &block : func.allBlocks()) {
+    for (auto &phi : block.phis) {
+      for (auto &arg : phi.args) {
+        replace(arg.value);
+      }
+    }
+    for (auto &quad : block.quads) {
+      ir::forEachUse(code, quad, replace);
+    }
+  }
+
+  return changed ? Preserved::CFG : Preserved::ALL;
+}
+
+/**
+ * @brief 把只用于紧随其后的复制的临时变量合并到复制的目标中（在 SSA 消去之后执行）
+ */
+Preserved
+coalesceCopies(ir::Function &func, AnalysisManager &am)
+{
+  auto &code = func.funcCode();
+  auto counts = count(func);
+
+  bool changed = false;
+  for (auto &block : func.allBlocks()) {
+    auto &quads = block.quads;
+    for (std::size_t i = 0; i + 1 < quads.size(); ++i) {
+      auto &def  = quads[i];
+      auto &copy = quads[i + 1];
+      auto temp  = def.dst;
+      if (!retargetable(def) || temp == NONE || copy.op != IROp::ASSIGN || copy.arg1 != temp) {
+        continue;
+      }
+      if (code.value(temp)->kind != sym::Value::Kind::TEMP || counts.defs[temp] != 1 || counts.uses[temp] != 1) {
+        continue;
+      }
+      if (counts.alias[copy.dst] || !ir::isScalar(*code.value(copy.dst))) {
+        continue;
+      }
+
+      def.dst = copy.dst;
+      quads.erase(quads.begin() + static_cast<std::ptrdiff_t>(i + 1));
+      changed = true;
+    }
+  }
+
+  return changed ? Preserved::CFG : Preserved::ALL;
+}
+
+} // namespace opt
@@ -0,0 +1,32 @@
+/**
+ * @file copy_prop.hpp
+ * @brief Copy propagation and coalescing of copies.
+ *
+ * propagateCopies runs on SSA form: for a copy d = s where both d and s
+ * have a single definition (or s is a constant) and neither is an element
+ * alias, the definition of s dominates every use of d, so those uses read s
+ * directly. Chains of copies collapse to their source; the copies themselves
+ * are left to dead code elimination.
+ *
+ * coalesceCopies runs after SSA destruction on the copies that remain
+ * because their target is assigned more than once, typically
+ *
+ *     %4 = i + 1        =>     i = i + 1
+ *     i = %4
+ *
+ * An expression temporary that is defined once, read once, and only by the
+ * copy right after its definition, is replaced by the copy's target in that
+ * definition, and the copy is removed.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto propagateCopies(ir::Function &func, AnalysisManager &am) -> Preserved;
+auto coalesceCopies(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
@@ -0,0 +1,101 @@
+#include <vector>
+
+#include "dce.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::ValueId;
+
+namespace {
+
+// 值的一处定义：块中的第 index 个四元式或第 index 个 φ 函数
+struct Def {
+  BlockId       block;
+  std::uint32_t index;
+  bool          phi;
+};
+
+} // namespace
+
+/**
+ * @brief 删除结果没有被使用的四元式与 φ 函数
+ */
+Preserved
+eliminateDeadCode(ir::Function &func, AnalysisManager &am)
+{
+  const auto &code = func.funcCode();
+  auto n = code.valueCount();
+
+  // 元素别名：向它赋值会写入数组/元组
+  std::vector<bool> alias(n, false);
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &quad : block.quads) {
+      if (ir::isElemAccess(quad)) {
+        alias[quad.dst] = true;
+      }
+    }
+  }
+  auto removable = [&](const IRQuad &quad) {
+    return ir::isPure(quad) && quad.dst != NONE && !alias[quad.dst];
+  };
+
+  std::vector<bool>             live(n, false);
+  std::vector<ValueId>          worklist;
+  std::vector<std::vector<Def>> defs(n);
+  auto use = [&](ValueId value) {
+    if (!live[value]) {
+      live[value] = true;
+      worklist.push_back(value);
+    }
+  };
+
+  for (BlockId id = 0; id < func.size(); ++id) {
+    const auto &block = func.block(id);
+    for (std::uint32_t i = 0; i < block.phis.size(); ++i) {
+      defs[block.phis[i].dst].push_back({.block = id, .index = i, .phi = true});
+    }
+    for (std::uint32_t i = 0; i < block.quads.size(); ++i) {
+      const auto &quad = block.quads[i];
+      if (removable(quad)) {
+        defs[quad.dst].push_back({.block = id, .index = i, .phi = false});
+      } else {
+        ir::forEachUse(code, quad, use);
+      }
+    }
+  }
+
+  // 活跃的值的定义所读取的值也是活跃的
+  while (!worklist.empty()) {
+    auto value = worklist.back();
+    worklist.pop_back();
+    for (const auto &def : defs[value]) {
+      const auto &block = func.block(def.block);
+      if (def.phi) {
+        for (const auto &arg : block.phis[def.index].args) {
+          use(arg.value);
+        }
+      } else {
+        ir::forEachUse(code, block.quads[def.index], use);
+      }
+    }
+  }
+
+  bool changed = false;
+  for (auto &block : func.allBlocks()) {
+    auto phis  = std::erase_if(block.phis, [&](const ir::Phi &phi) {
+      return !live[phi.dst];
+    });
+    auto quads = std::erase_if(block.quads, [&](const IRQuad &quad) {
+      return removable(quad) && !live[quad.dst];
+    });
+    changed = changed || phis != 0 || quads != 0;
+  }
+
+  return changed ? Preserved::CFG : Preserved::ALL;
+}
+
+} // namespace opt
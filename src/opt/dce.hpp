@@ -0,0 +1,26 @@
+/**
+ * @file dce.hpp
+ * @brief Dead code elimination.
+ *
+ * Mark and sweep over the values of one function: calls, jumps, returns,
+ * labels, element accesses and stores through element aliases are always
+ * kept, and a value is live if such a quad, or the definition of another
+ * live value, reads it. The definitions (quads and phi functions) of the
+ * values that are not live are removed; since liveness starts from the
+ * quads with effects, dead cycles through phi functions and loop-carried
+ * copies are removed as well.
+ *
+ * Each value is treated as a whole, so the pass works before and after SSA
+ * destruction; in SSA form every version of a variable is judged on its own.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto eliminateDeadCode(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
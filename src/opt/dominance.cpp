@@ -0,0 +1,138 @@
+#include <ranges>
+#include <algorithm>
+
+#include "dominance.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::BlockId;
+
+/**
+ * @brief 计算函数的逆后序、支配树与支配边界
+ * @param func 函数的基本块视图
+ */
+DominatorTree::DominatorTree(const ir::Function &func)
+{
+  auto n = func.size();
+  idoms.assign(n, NONE);
+  kids.assign(n, {});
+  frontiers.assign(n, {});
+  rpo_index.assign(n, NONE);
+  pre.assign(n, 0);
+  post.assign(n, 0);
+  if (n == 0) {
+    return;
+  }
+
+  // 后序：显式栈上的深度优先遍历，避免很深的 CFG 导致栈溢出
+  std::vector<bool> visited(n, false);
+  std::vector<std::pair<BlockId, std::size_t>> stack{{0, 0}};
+  visited[0] = true;
+  while (!stack.empty()) {
+    auto &[block, next] = stack.back();
+    const auto &succs = func.block(block).succs;
+    if (next < succs.size()) {
+      auto succ = succs[next++];
+      if (!visited[succ]) {
+        visited[succ] = true;
+        stack.emplace_back(succ, 0);
+      }
+      continue;
+    }
+    order.push_back(block);
+    stack.pop_back();
+  }
+  std::ranges::reverse(order);
+  for (std::uint32_t i = 0; i < order.size(); ++i) {
+    rpo_index[order[i]] = i;
+  }
+
+  // Cooper-Harvey-Kennedy：按逆后序反复求前驱的公共支配者，直到不动点
+  auto intersect = [this](BlockId a, BlockId b) {
+    while (a != b) {
+      while (rpo_index[a] > rpo_index[b]) {
+        a = idoms[a];
+      }
+      while (rpo_index[b] > rpo_index[a]) {
+        b = idoms[b];
+      }
+    }
+    return a;
+  };
+
+  idoms[0] = 0;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto block : order | std::views::drop(1)) {
+      BlockId dom = NONE;
+      for (auto pred : func.block(block).preds) {
+        if (idoms[pred] == NONE) {
+          continue; // 尚未处理或不可达
+        }
+        dom = dom == NONE ? pred : intersect(pred, dom);
+      }
+      if (idoms[block] != dom) {
+        idoms[block] = dom;
+        changed  = true;
+      }
+    }
+  }
+  idoms[0] = NONE;
+
+  for (auto block : order | std::views::drop(1)) {
+    kids[idoms[block]].push_back(block);
+  }
+
+  // 支配边界：汇合点沿各前驱向上走到其直接支配者为止
+  for (auto block : order) {
+    const auto &preds = func.block(block).preds;
+    if (preds.size() < 2) {
+      continue;
+    }
+    for (auto pred : preds) {
+      if (!reachable(pred)) {
+        continue;
+      }
+      for (auto runner = pred; runner != idoms[block]; runner = idoms[runner]) {
+        auto &df = frontiers[runner];
+        if (df.empty() || df.back() != block) {
+          df.push_back(block);
+        }
+        if (runner == 0) {
+          break; // 入口块没有直接支配者（循环回到入口时）
+        }
+      }
+    }
+  }
+
+  // 支配树上的先序/后序编号
+  std::uint32_t clock = 0;
+  std::vector<std::pair<BlockId, std::size_t>> walk{{0, 0}};
+  pre[0] = clock++;
+  while (!walk.empty()) {
+    auto &[block, next] = walk.back();
+    if (next < kids[block].size()) {
+      auto kid = kids[block][next++];
+      pre[kid] = clock++;
+      walk.emplace_back(kid, 0);
+      continue;
+    }
+    post[block] = clock++;
+    walk.pop_back();
+  }
+}
+
+/**
+ * @brief 块 a 是否支配块 b（块总是支配自身）
+ */
+bool
+DominatorTree::dominates(BlockId a, BlockId b) const
+{
+  if (!reachable(a) || !reachable(b)) {
+    return false;
+  }
+  return pre[a] <= pre[b] && post[b] <= post[a];
+}
+
+} // namespace opt
@@ -0,0 +1,65 @@
+/**
+ * @file dominance.hpp
+ * @brief Dominator tree and dominance frontiers of an ir::Function.
+ *
+ * Immediate dominators are computed with the iterative algorithm of Cooper,
+ * Harvey and Kennedy over the reverse post order of the reachable blocks.
+ * Blocks that are unreachable from the entry have no immediate dominator and
+ * are neither dominated by nor dominate any block.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "cfg.hpp"
+
+namespace opt {
+
+class DominatorTree {
+public:
+  explicit DominatorTree(const ir::Function &func);
+
+public:
+  /**
+   * @brief 直接支配者；入口块与不可达的块返回 NONE
+   */
+  [[nodiscard]] ir::BlockId idom(ir::BlockId block) const { return idoms[block]; }
+
+  /**
+   * @brief 支配树中的子结点
+   */
+  [[nodiscard]] std::span<const ir::BlockId> children(ir::BlockId block) const {
+    return kids[block];
+  }
+
+  /**
+   * @brief 支配边界
+   */
+  [[nodiscard]] std::span<const ir::BlockId> frontier(ir::BlockId block) const {
+    return frontiers[block];
+  }
+
+  /**
+   * @brief 从入口出发的逆后序（只含可达的块）
+   */
+  [[nodiscard]] std::span<const ir::BlockId> rpo() const { return order; }
+
+  [[nodiscard]] bool reachable(ir::BlockId block) const { return rpo_index[block] != ir::NONE; }
+  [[nodiscard]] bool dominates(ir::BlockId a, ir::BlockId b) const;
+
+private:
+  std::vector<ir::BlockId>              idoms;     // 直接支配者
+  std::vector<std::vector<ir::BlockId>> kids;      // 支配树中的子结点
+  std::vector<std::vector<ir::BlockId>> frontiers; // 支配边界
+  std::vector<ir::BlockId>              order;     // 逆后序
+  std::vector<std::uint32_t>            rpo_index; // 块在逆后序中的位置，不可达时为 NONE
+
+  // 支配树上的先序区间，a 支配 b 当且仅当 b 的区间包含于 a 的区间
+  std::vector<std::uint32_t> pre;
+  std::vector<std::uint32_t> post;
+};
+
+} // namespace opt
@@ -0,0 +1,254 @@
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+
+#include "gvn.hpp"
+#include "fold.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::ValueId;
+
+namespace {
+
+// 表达式：运算符与操作数的值编号
+struct Expr {
+  IROp    op;
+  ValueId lhs;
+  ValueId rhs;
+
+  bool operator==(const Expr &) const = default;
+};
+
+struct ExprHash {
+  std::size_t operator()(const Expr &expr) const noexcept {
+    auto h = static_cast<std::uint64_t>(expr.op);
+    h = h * 0x9e3779b97f4a7c15ull ^ expr.lhs;
+    h = h * 0x9e3779b97f4a7c15ull ^ expr.rhs;
+    return static_cast<std::size_t>(h);
+  }
+};
+
+inline constexpr bool
+isCommutative(IROp op)
+{
+  return op == IROp::ADD || op == IROp::MUL || op == IROp::EQ || op == IROp::NEQ;
+}
+
+class GVN {
+public:
+  GVN(ir::Function &func, const DominatorTree &dom)
+    : func(func), code(func.funcCode()), dom(dom) {}
+
+public:
+  void init();
+  void run();
+  auto rewrite() -> Preserved;
+
+private:
+  [[nodiscard]] auto expression(const IRQuad &quad) const -> std::optional<Expr>;
+  void visitBlock(BlockId id, std::vector<Expr> &log);
+
+private:
+  ir::Function        &func;
+  ir::FuncCode        &code;
+  const DominatorTree &dom;
+
+  std::vector<ValueId> vn;     // 值 -> 值编号（编号是同值的某个 ValueId）
+  std::vector<bool>    stable; // 常量或只定义一次的非别名值
+  std::vector<bool>    alias;  // 数组/元组元素的别名
+  std::vector<ValueId> repl;   // 冗余的值 -> 替换它的值，NONE 表示不替换
+
+  std::unordered_map<Expr, ValueId, ExprHash> table; // 支配路径上已计算的表达式
+};
+
+/**
+ * @brief 统计定义次数；常量按值编号，其余值的编号是自身
+ */
+void
+GVN::init()
+{
+  auto n = code.valueCount();
+
+  std::vector<std::uint32_t> defs(n, 0);
+  alias.assign(n, false);
+  for (auto param : code.params) {
+    ++defs[param];
+  }
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &phi : block.phis) {
+      ++defs[phi.dst];
+    }
+    for (const auto &quad : block.quads) {
+      if (auto dst = ir::definedValue(quad); dst != NONE) {
+        ++defs[dst];
+        alias[dst] = alias[dst] || ir::isElemAccess(quad);
+      }
+    }
+  }
+
+  std::unordered_map<int, ValueId> consts;
+  vn.resize(n);
+  stable.assign(n, false);
+  repl.assign(n, NONE);
+  for (ValueId value = 0; value < n; ++value) {
+    const auto &val = code.value(value);
+    if (val->isConst()) {
+      vn[value]     = consts.try_emplace(ir::constValue(*val), value).first->second;
+      stable[value] = true;
+    } else {
+      vn[value]     = value;
+      stable[value] = defs[value] == 1 && !alias[value];
+    }
+  }
+}
+
+/**
+ * @brief  四元式计算的表达式
+ * @return 可以编号的表达式；读取内存或有副作用的四元式返回 nullopt
+ */
+std::optional<Expr>
+GVN::expression(const IRQuad &quad) const
+{
+  if (ir::isBinary(quad.op)) {
+    if (!stable[quad.dst] || !stable[quad.arg1] || !stable[quad.arg2]) {
+      return std::nullopt;
+    }
+    Expr expr{.op = quad.op, .lhs = vn[quad.arg1], .rhs = vn[quad.arg2]};
+    if (expr.op == IROp::GT || expr.op == IROp::GEQ) {
+      expr.op = expr.op == IROp::GT ? IROp::LT : IROp::LEQ;
+      std::swap(expr.lhs, expr.rhs);
+    } else if (isCommutative(expr.op) && expr.lhs > expr.rhs) {
+      std::swap(expr.lhs, expr.rhs);
+    }
+    return expr;
+  }
+
+  if (ir::isElemAccess(quad)) {
+    // 元素的位置由聚合体本身与下标决定
+    if (!stable[quad.arg2]) {
+      return std::nullopt;
+    }
+    return Expr{.op = quad.op, .lhs = vn[quad.arg1], .rhs = vn[quad.arg2]};
+  }
+
+  return std::nullopt;
+}
+
+/**
+ * @brief 为块中的值编号，新的表达式记入 log，退出块时据此从表中删除
+ */
+void
+GVN::visitBlock(BlockId id, std::vector<Expr> &log)
+{
+  for (const auto &quad : func.block(id).quads) {
+    if (quad.op == IROp::ASSIGN && stable[quad.dst] && stable[quad.arg1]) {
+      vn[quad.dst] = vn[quad.arg1];
+      continue;
+    }
+
+    auto expr = expression(quad);
+    if (!expr.has_value()) {
+      continue;
+    }
+    auto [it, inserted] = table.try_emplace(expr.value(), quad.dst);
+    if (inserted) {
+      log.push_back(expr.value());
+      continue;
+    }
+    repl[quad.dst] = it->second;
+    vn[quad.dst]   = vn[it->second];
+  }
+}
+
+/**
+ * @brief 沿支配树先序编号（显式栈，与 SSA 的重命名相同）
+ */
+void
+GVN::run()
+{
+  struct Frame {
+    BlockId     block;
+    std::size_t mark;    // 进入块之前 log 的长度
+    bool        entered;
+  };
+  std::vector<Expr>  log;
+  std::vector<Frame> frames{{.block = 0, .mark = 0, .entered = false}};
+  while (!frames.empty()) {
+    auto &frame = frames.back();
+    if (frame.entered) {
+      for (auto i = log.size(); i > frame.mark; --i) {
+        table.erase(log[i - 1]);
+      }
+      log.resize(frame.mark);
+      frames.pop_back();
+      continue;
+    }
+
+    frame.entered = true;
+    frame.mark    = log.size();
+    auto id = frame.block;
+    visitBlock(id, log);
+    for (auto child : dom.children(id)) {
+      frames.push_back({.block = child, .mark = 0, .entered = false});
+    }
+  }
+}
+
+/**
+ * @brief 用先计算的值替换冗余的值；冗余的元素访问直接删除，
+ *        冗余的运算留给死代码删除
+ */
+Preserved
+GVN::rewrite()
+{
+  if (std::ranges::find_if(repl, [](ValueId v) { return v != NONE; }) == repl.end()) {
+    return Preserved::ALL;
+  }
+
+  auto replace = [&](ValueId &value) {
+    if (repl[value] != NONE) {
+      value = repl[value];
+    }
+  };
+  for (auto &block : func.allBlocks()) {
+    for (auto &phi : block.phis) {
+      for (auto &arg : phi.args) {
+        replace(arg.value);
+      }
+    }
+    std::erase_if(block.quads, [&](const IRQuad &quad) {
+      return ir::isElemAccess(quad) && repl[quad.dst] != NONE;
+    });
+    for (auto &quad : block.quads) {
+      ir::forEachUse(code, quad, replace);
+      if (quad.dst != NONE && alias[quad.dst]) {
+        replace(quad.dst); // 通过别名的赋值写入同一个元素
+      }
+    }
+  }
+
+  return Preserved::CFG;
+}
+
+} // namespace
+
+/**
+ * @brief 全局值编号（要求函数处于 SSA 形式）
+ */
+Preserved
+numberValues(ir::Function &func, AnalysisManager &am)
+{
+  GVN gvn{func, am.domTree()};
+  gvn.init();
+  gvn.run();
+  return gvn.rewrite();
+}
+
+} // namespace opt
@@ -0,0 +1,30 @@
+/**
+ * @file gvn.hpp
+ * @brief Dominator-based global value numbering.
+ *
+ * Walks the dominator tree with a scoped table of the expressions computed
+ * on the path from the entry. An arithmetic or comparison quad whose
+ * expression (operator and value numbers of the operands, commutative
+ * operands sorted, > and >= turned into < and <=) is already in the table
+ * is redundant: its uses are replaced by the earlier result, which
+ * dominates them, and the quad is left to dead code elimination. Copies
+ * pass the value number of their source on, so a recomputation through a
+ * user variable is found as well.
+ *
+ * INDEX and DOT only compute where an element lives, which does not change
+ * when the aggregate is written, so a repeated access of the same element
+ * is replaced by the first alias altogether. Reading through an alias is a
+ * memory access: expressions over aliases, or over any other value that is
+ * assigned more than once, are not numbered.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto numberValues(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
@@ -0,0 +1,256 @@
+#include <cmath>
+#include <format>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+#include "ast.hpp"
+#include "cfg.hpp"
+#include "inline.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::LabelId;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr int         CALL_COST       = 4;    // call、ret 与调用前后的保存恢复
+inline constexpr int         CONST_ARG_BONUS = 2;    // 常量实参可以在函数体中折叠
+inline constexpr std::size_t MAX_SIZE        = 4096; // 调用者内联后最多的四元式个数
+inline constexpr int         HOT_FACTOR      = 4;    // 剖析数据中的热调用处放宽阈值的倍数
+
+/**
+ * @brief 函数体的大小（不计标号与函数入口）
+ */
+int
+bodySize(const ir::FuncCode &code)
+{
+  int size = 0;
+  for (const auto &quad : code.quads) {
+    size += quad.op != IROp::LABEL && quad.op != IROp::FUNC ? 1 : 0;
+  }
+  return size;
+}
+
+/**
+ * @brief 函数能否被内联：形参都是标量，且不调用自身
+ */
+bool
+inlinable(const ir::FuncCode &code)
+{
+  for (auto param : code.params) {
+    if (!ir::isScalar(*code.value(param))) {
+      return false;
+    }
+  }
+  for (const auto &quad : code.quads) {
+    if (quad.op == IROp::CALL && code.label(quad.label) == code.name) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class Inliner {
+public:
+  explicit Inliner(ir::FuncCode &caller) : caller(caller) {}
+
+public:
+  void expand(const IRQuad &call, const ir::FuncCode &fn, std::uint64_t count, std::vector<IRQuad> &out);
+
+private:
+  auto value(ValueId id) -> ValueId;
+  auto label(LabelId id) -> LabelId;
+  auto newLabel(std::string name, std::uint64_t count) -> LabelId;
+
+private:
+  ir::FuncCode &caller;
+
+  const ir::FuncCode *callee = nullptr;
+  unsigned site = 0; // 调用者中内联的次数，用于区分各处副本的名字
+  std::uint64_t calls = 0; // 剖析数据中这一处调用的执行次数
+
+  std::vector<ValueId> values; // 被调用者的值 -> 调用者中的副本
+  std::vector<LabelId> labels; // 被调用者的标号 -> 调用者中的副本
+};
+
+/**
+ * @brief 被调用者的值在当前副本中对应的值
+ */
+ValueId
+Inliner::value(ValueId id)
+{
+  if (id == NONE) {
+    return NONE;
+  }
+  if (values[id] == NONE) {
+    values[id] = caller.newCopy(callee->value(id), std::format("inl{}", site));
+  }
+  return values[id];
+}
+
+/**
+ * @brief 被调用者的标号在当前副本中对应的标号
+ */
+LabelId
+Inliner::label(LabelId id)
+{
+  if (labels[id] == NONE) {
+    // 副本中的块按这一处调用占被调用者所有调用的比例计数
+    auto count = calls;
+    if (callee->counts.has_value() && callee->counts->entry > 0) {
+      auto it = callee->counts->labels.find(id);
+      auto share = static_cast<double>(calls) / static_cast<double>(callee->counts->entry);
+      count = it == callee->counts->labels.end()
+        ? calls : static_cast<std::uint64_t>(std::llround(static_cast<double>(it->second) * share));
+    }
+    labels[id] = newLabel(std::format("{}_inl{}_{}", caller.name, site, callee->label(id)), count);
+  }
+  return labels[id];
+}
+
+/**
+ * @brief 在调用者中新建标号；调用者有剖析数据时记下所在块的执行次数
+ */
+LabelId
+Inliner::newLabel(std::string name, std::uint64_t count)
+{
+  auto id = caller.addLabel(name);
+  if (caller.counts.has_value()) {
+    caller.counts->labels.insert_or_assign(id, count);
+  }
+  return id;
+}
+
+/**
+ * @brief 把一次调用展开为被调用者函数体的副本，追加到 out
+ * @param call  调用者中的 CALL 四元式
+ * @param fn    被调用者
+ * @param count 剖析数据中这一处调用的执行次数（没有剖析数据时不使用）
+ * @param out   调用者新的四元式序列
+ */
+void
+Inliner::expand(const IRQuad &call, const ir::FuncCode &fn, std::uint64_t count, std::vector<IRQuad> &out)
+{
+  callee = &fn;
+  calls  = count;
+  ++site;
+  values.assign(fn.valueCount(), NONE);
+  labels.assign(fn.labelCount(), NONE);
+
+  // 实参复制到形参的副本中
+  auto args = caller.elems(call.elems);
+  for (std::size_t i = 0; i < fn.params.size(); ++i) {
+    out.push_back({.op = IROp::ASSIGN, .arg1 = args[i], .dst = value(fn.params[i])});
+  }
+
+  auto ret = newLabel(std::format("{}_inl{}_ret", caller.name, site), count);
+  for (auto quad : fn.quads) {
+    switch (quad.op) {
+      case IROp::FUNC:
+        continue;
+      case IROp::RETURN:
+        if (quad.arg1 != NONE && call.dst != NONE) {
+          out.push_back({.op = IROp::ASSIGN, .arg1 = value(quad.arg1), .dst = call.dst});
+        }
+        out.push_back({.op = IROp::GOTO, .label = ret});
+        continue;
+      case IROp::CALL:
+        quad.label = caller.addLabel(fn.label(quad.label));
+        break;
+      default:
+        if (quad.label != NONE) {
+          quad.label = label(quad.label);
+        }
+        break;
+    }
+
+    quad.arg1 = value(quad.arg1);
+    quad.arg2 = value(quad.arg2);
+    quad.dst  = value(quad.dst);
+    if (quad.elems != NONE) {
+      std::vector<sym::ValuePtr> elems;
+      for (auto elem : fn.elems(quad.elems)) {
+        elems.push_back(caller.value(value(elem)));
+      }
+      quad.elems = caller.addElems(elems);
+    }
+    out.push_back(quad);
+  }
+  out.push_back({.op = IROp::LABEL, .label = ret});
+}
+
+} // namespace
+
+/**
+ * @brief 按代价模型把小函数内联到调用处
+ *
+ * 调用者有剖析数据时：从未执行过的调用不内联；每次进入调用者平均至少执行一次
+ * 的调用（如循环中的调用）阈值放宽为 HOT_FACTOR 倍
+ *
+ * @param prog      已生成 IR 的程序
+ * @param threshold 代价阈值，0 表示不内联
+ */
+void
+inlineCalls(ast::Prog &prog, unsigned threshold)
+{
+  if (threshold == 0) {
+    return;
+  }
+
+  // 函数名 -> 已处理完的函数（可以内联的函数才登记）
+  std::unordered_map<std::string_view, const ir::FuncCode *> done;
+  for (const auto &decl : prog.decls) {
+    const auto &code = static_cast<ast::FuncDeclPtr>(decl)->code;
+    if (!code) {
+      continue;
+    }
+
+    Inliner inliner{*code};
+    std::vector<IRQuad> quads;
+    quads.reserve(code->quads.size());
+    std::uint64_t count = 0; // 剖析数据中当前块的执行次数
+    for (std::size_t i = 0; i < code->quads.size(); ++i) {
+      const auto &quad = code->quads[i];
+      bool leader = i == 0 || quad.op == IROp::LABEL || ir::isTerminator(code->quads[i - 1].op);
+      if (code->counts.has_value() && leader) {
+        count = code->counts->at(quad, count);
+      }
+      auto it = quad.op == IROp::CALL ? done.find(code->label(quad.label)) : done.end();
+      if (it == done.end() || (code->counts.has_value() && count == 0)) {
+        quads.push_back(quad);
+        continue;
+      }
+
+      auto limit = static_cast<int>(threshold);
+      if (code->counts.has_value() && count >= std::max<std::uint64_t>(code->counts->entry, 1)) {
+        limit *= HOT_FACTOR;
+      }
+      const auto &callee = *it->second;
+      int cost = bodySize(callee) - CALL_COST - static_cast<int>(callee.params.size());
+      for (auto arg : code->elems(quad.elems)) {
+        cost -= code->value(arg)->isConst() ? CONST_ARG_BONUS : 0;
+      }
+      auto grown = quads.size() + callee.quads.size() + callee.params.size() + 1;
+      if (cost > limit || grown > MAX_SIZE) {
+        quads.push_back(quad);
+        continue;
+      }
+      inliner.expand(quad, callee, count, quads);
+    }
+    code->quads = std::move(quads);
+
+    if (inlinable(*code)) {
+      done.emplace(code->name, code.get());
+    }
+  }
+}
+
+} // namespace opt
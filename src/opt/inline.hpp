@@ -0,0 +1,42 @@
+/**
+ * @file inline.hpp
+ * @brief Inlining of small functions at their call sites.
+ *
+ * A module pass over the IR as built, before any function pass. Calls can
+ * only reach functions declared earlier (or the caller itself), so visiting
+ * the functions in declaration order inlines bottom-up along the call graph:
+ * a callee has already received its own inlined calls when it is spliced
+ * into a caller, and a self-recursive function is never inlined.
+ *
+ * A call is replaced by copies of the arguments into fresh copies of the
+ * parameters, followed by the callee's body. Every temporary and local of the
+ * callee gets a fresh value in the caller, every label a name prefixed with
+ * the caller and the call site; a return becomes a copy of its value into the
+ * call's result and a jump to the code after the call.
+ *
+ * Cost model: the callee's size in quads (labels not counted), minus what the
+ * call itself costs (the call and return, one move per argument) and a bonus
+ * for every constant argument, which the later constant propagation folds
+ * into the body. A call is inlined when this cost is at most the threshold
+ * and the caller stays below a size limit. Only callees with scalar
+ * parameters are considered.
+ *
+ * With a profile (--profile-use), calls that never ran are not inlined, and
+ * calls that run at least once per entry of the caller (e.g. in a loop) may
+ * cost four times the threshold. The blocks of an inlined copy are counted
+ * with the call's share of the callee's calls.
+ *
+ * Functions whose body was not lowered (incremental cache hits) are not
+ * inlined; the driver lowers every function a recompiled caller may inline.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+namespace ast { struct Prog; }
+
+namespace opt {
+
+void inlineCalls(ast::Prog &prog, unsigned threshold);
+
+} // namespace opt
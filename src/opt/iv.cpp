@@ -0,0 +1,509 @@
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+
+#include "iv.hpp"
+#include "fold.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::ValueId;
+
+namespace {
+
+// v = base + offset，base 是循环头的 φ 函数
+struct Affine {
+  ValueId base;
+  int     offset;
+};
+
+// 基本归纳变量：循环头的 φ 函数，每次迭代增加 step
+struct BasicIV {
+  ValueId phi;
+  ValueId init; // 从前置块进入时的值
+  int     step;
+};
+
+// 由基本归纳变量 iv 与 factor 的乘积得到的新归纳变量
+struct Reduced {
+  std::size_t        iv;
+  ValueId            factor;
+  std::optional<int> constant; // factor 是常量时的值
+  ValueId            phi;      // 新的 φ 函数
+};
+
+// 待改写的乘法：块中第 index 个四元式 dst = (iv + offset) * factor
+struct Product {
+  BlockId       block;
+  std::uint32_t index;
+  std::size_t   reduced;
+  int           offset;
+};
+
+inline int
+wrap(std::int64_t value)
+{
+  return static_cast<int>(static_cast<std::uint32_t>(value));
+}
+
+inline bool
+fits(std::int64_t value)
+{
+  return value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max();
+}
+
+class IVReducer {
+public:
+  IVReducer(ir::Function &func, const LoopForest &forest)
+    : func(func), code(func.funcCode()), forest(forest) {}
+
+public:
+  bool reduce(LoopId id);
+
+private:
+  void collect(LoopId id);
+  [[nodiscard]] auto affine(ValueId value) const -> std::optional<Affine>;
+  [[nodiscard]] auto constant(ValueId value) const -> std::optional<int>;
+  [[nodiscard]] bool invariant(ValueId value) const;
+
+  void findIVs(BlockId preheader);
+  auto findProducts() -> std::vector<Product>;
+  void materialize(const Reduced &reduced, BlockId preheader);
+  void replaceTest(std::size_t iv);
+
+  auto newTemp() -> ValueId;
+  void emit(BlockId block, IRQuad quad);
+
+private:
+  ir::Function     &func;
+  ir::FuncCode     &code;
+  const LoopForest &forest;
+
+  const Loop *loop = nullptr; // 正在处理的循环
+
+  std::vector<bool>    inside;  // 值是否在当前循环中定义
+  std::vector<bool>    stable;  // 常量或只定义一次的非别名值
+  std::vector<IRQuad>  defs;    // 只定义一次的值 -> 定义它的四元式（op 为 FUNC 表示没有）
+  std::vector<ValueId> iv_of;   // 循环头的 φ 函数 -> 基本归纳变量的下标
+
+  std::vector<BasicIV> ivs;
+  std::vector<Reduced> reduced;
+
+  std::vector<std::pair<BlockId, IRQuad>> pending; // 最后插入的四元式（块尾，跳转之前）
+};
+
+/**
+ * @brief 统计值的定义（每个循环重新统计，包括之前的循环新建的值）
+ */
+void
+IVReducer::collect(LoopId id)
+{
+  loop = &forest.loop(id);
+
+  auto n = code.valueCount();
+  std::vector<std::uint32_t> count(n, 0);
+  std::vector<bool>          alias(n, false);
+  inside.assign(n, false);
+  defs.assign(n, IRQuad{.op = IROp::FUNC});
+  for (auto param : code.params) {
+    ++count[param];
+  }
+  for (BlockId block = 0; block < func.size(); ++block) {
+    bool in_loop = loop->contains(block);
+    for (const auto &phi : func.block(block).phis) {
+      ++count[phi.dst];
+      inside[phi.dst] = inside[phi.dst] || in_loop;
+    }
+    for (const auto &quad : func.block(block).quads) {
+      if (auto dst = ir::definedValue(quad); dst != NONE) {
+        ++count[dst];
+        alias[dst]  = alias[dst] || ir::isElemAccess(quad);
+        inside[dst] = inside[dst] || in_loop;
+        defs[dst]   = quad;
+      }
+    }
+  }
+
+  stable.assign(n, false);
+  for (ValueId value = 0; value < n; ++value) {
+    stable[value] = code.value(value)->isConst() || (count[value] == 1 && !alias[value]);
+    if (!stable[value]) {
+      defs[value].op = IROp::FUNC;
+    }
+  }
+  iv_of.assign(n, NONE);
+  ivs.clear();
+  reduced.clear();
+  pending.clear();
+}
+
+auto
+IVReducer::constant(ValueId value) const -> std::optional<int>
+{
+  const auto &val = code.value(value);
+  if (!val->isConst()) {
+    return std::nullopt;
+  }
+  return ir::constValue(*val);
+}
+
+/**
+ * @brief 值是否是常量或在循环外定义（只定义一次）
+ */
+bool
+IVReducer::invariant(ValueId value) const
+{
+  return stable[value] && !inside[value];
+}
+
+/**
+ * @brief  把循环中的值表示为循环头的 φ 函数加常量（沿复制与加减常量回溯）
+ * @return 表示；不能这样表示时返回 nullopt
+ */
+auto
+IVReducer::affine(ValueId value) const -> std::optional<Affine>
+{
+  std::int64_t offset = 0;
+  for (int steps = 0; steps < 64; ++steps) {
+    if (iv_of[value] != NONE) {
+      return Affine{.base = value, .offset = wrap(offset)};
+    }
+    if (!inside[value] || defs[value].op == IROp::FUNC) {
+      return std::nullopt;
+    }
+
+    const auto &quad = defs[value];
+    if (quad.op == IROp::ASSIGN) {
+      value = quad.arg1;
+    } else if (quad.op == IROp::ADD && constant(quad.arg2).has_value()) {
+      offset += constant(quad.arg2).value();
+      value   = quad.arg1;
+    } else if (quad.op == IROp::ADD && constant(quad.arg1).has_value()) {
+      offset += constant(quad.arg1).value();
+      value   = quad.arg2;
+    } else if (quad.op == IROp::SUB && constant(quad.arg2).has_value()) {
+      offset -= constant(quad.arg2).value();
+      value   = quad.arg1;
+    } else {
+      return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief 找出循环头中的基本归纳变量：每条回边上的值都是自身加同一个非零常量
+ */
+void
+IVReducer::findIVs(BlockId preheader)
+{
+  const auto &header = func.block(loop->header);
+  for (const auto &phi : header.phis) {
+    iv_of[phi.dst] = static_cast<std::uint32_t>(ivs.size()); // 先假定是，affine 据此停下
+    ivs.push_back({.phi = phi.dst, .init = NONE, .step = 0});
+  }
+
+  std::vector<BasicIV> found;
+  for (const auto &phi : header.phis) {
+    BasicIV iv{.phi = phi.dst, .init = NONE, .step = 0};
+    bool ok = true;
+    for (const auto &arg : phi.args) {
+      if (arg.pred == preheader) {
+        iv.init = arg.value;
+        continue;
+      }
+      auto form = affine(arg.value);
+      if (!form.has_value() || form->base != phi.dst || form->offset == 0
+        || (iv.step != 0 && form->offset != iv.step)) {
+        ok = false;
+        break;
+      }
+      iv.step = form->offset;
+    }
+    if (ok && iv.init != NONE && iv.step != 0) {
+      found.push_back(iv);
+    }
+  }
+
+  for (const auto &phi : header.phis) {
+    iv_of[phi.dst] = NONE;
+  }
+  ivs = std::move(found);
+  for (std::size_t i = 0; i < ivs.size(); ++i) {
+    iv_of[ivs[i].phi] = static_cast<std::uint32_t>(i);
+  }
+}
+
+/**
+ * @brief 找出循环中 (iv + offset) * factor 形式的乘法，并为每组 (iv, factor) 分配新归纳变量
+ */
+auto
+IVReducer::findProducts() -> std::vector<Product>
+{
+  std::vector<Product> products;
+  for (auto block : loop->blocks) {
+    const auto &quads = func.block(block).quads;
+    for (std::uint32_t i = 0; i < quads.size(); ++i) {
+      const auto &quad = quads[i];
+      if (quad.op != IROp::MUL || !stable[quad.dst]) {
+        continue;
+      }
+
+      auto form   = affine(quad.arg1);
+      auto factor = quad.arg2;
+      if (!form.has_value()) {
+        form   = affine(quad.arg2);
+        factor = quad.arg1;
+      }
+      if (!form.has_value() || !invariant(factor)) {
+        continue;
+      }
+
+      auto iv = static_cast<std::size_t>(iv_of[form->base]);
+      auto k  = constant(factor);
+      auto it = std::ranges::find_if(reduced, [&](const Reduced &r) {
+        return r.iv == iv && (k.has_value() ? r.constant == k : r.factor == factor);
+      });
+      if (it == reduced.end()) {
+        reduced.push_back({.iv = iv, .factor = factor, .constant = k, .phi = NONE});
+        it = reduced.end() - 1;
+      }
+      products.push_back({
+        .block   = block,
+        .index   = i,
+        .reduced = static_cast<std::size_t>(it - reduced.begin()),
+        .offset  = form->offset,
+      });
+    }
+  }
+  return products;
+}
+
+auto
+IVReducer::newTemp() -> ValueId
+{
+  return code.newTemp(type::TypeFactory::INT_TYPE, code.value(ivs.front().phi)->pos);
+}
+
+/**
+ * @brief 记下在块尾（跳转之前）插入的四元式
+ */
+void
+IVReducer::emit(BlockId block, IRQuad quad)
+{
+  pending.emplace_back(block, quad);
+}
+
+/**
+ * @brief 建立新归纳变量：前置块中计算初值与步长，回边上增加步长
+ */
+void
+IVReducer::materialize(const Reduced &r, BlockId preheader)
+{
+  const auto &iv = ivs[r.iv];
+
+  ValueId init = NONE;
+  if (auto start = constant(iv.init); start.has_value() && r.constant.has_value()) {
+    init = code.newConst(wrap(std::int64_t{start.value()} * r.constant.value()));
+  } else {
+    init = newTemp();
+    emit(preheader, {.op = IROp::MUL, .arg1 = iv.init, .arg2 = r.factor, .dst = init});
+  }
+
+  ValueId step = NONE;
+  if (r.constant.has_value()) {
+    step = code.newConst(wrap(std::int64_t{iv.step} * r.constant.value()));
+  } else if (iv.step == 1) {
+    step = r.factor;
+  } else {
+    step = newTemp();
+    emit(preheader, {.op = IROp::MUL, .arg1 = r.factor, .arg2 = code.newConst(iv.step), .dst = step});
+  }
+
+  ir::Phi phi{.dst = r.phi};
+  phi.args.push_back({.pred = preheader, .value = init});
+  for (auto latch : loop->latches) {
+    auto next = newTemp();
+    emit(latch, {.op = IROp::ADD, .arg1 = r.phi, .arg2 = step, .dst = next});
+    phi.args.push_back({.pred = latch, .value = next});
+  }
+  func.block(loop->header).phis.push_back(std::move(phi));
+}
+
+/**
+ * @brief 基本归纳变量只用于自身的更新与循环头的退出条件时，改为比较新归纳变量
+ */
+void
+IVReducer::replaceTest(std::size_t index)
+{
+  const auto &iv = ivs[index];
+  auto start = constant(iv.init);
+  if (!start.has_value() || iv.step <= 0) {
+    return;
+  }
+  auto r = std::ranges::find_if(reduced, [&](const Reduced &r) {
+    return r.iv == index && r.constant.has_value() && r.constant.value() > 0;
+  });
+  if (r == reduced.end()) {
+    return;
+  }
+
+  // 退出条件：if v >= E goto 循环外，或 c = v < E; if c == 0 goto 循环外
+  auto &header = func.block(loop->header);
+  auto term = header.terminator();
+  if (term == nullptr || loop->contains(func.labelBlock(term->label))) {
+    return;
+  }
+  IRQuad *test = nullptr;
+  if (term->op == IROp::BGE) {
+    test = &header.quads.back();
+  } else if (term->op == IROp::BEQZ) {
+    for (auto &quad : header.quads) {
+      if (quad.dst == term->arg1 && quad.op == IROp::LT) {
+        test = &quad;
+      }
+    }
+  }
+  if (test == nullptr || !stable[test->arg1]) {
+    return;
+  }
+  auto form  = affine(test->arg1);
+  auto bound = constant(test->arg2);
+  if (!form.has_value() || form->base != iv.phi || !bound.has_value()) {
+    return;
+  }
+
+  // iv 从 start 开始递增，最多比 E - offset 多走一步
+  std::int64_t k    = r->constant.value();
+  std::int64_t end  = std::int64_t{bound.value()} - form->offset;
+  std::int64_t high = std::max<std::int64_t>(start.value(), end) + iv.step;
+  if (!fits(end) || !fits(high) || !fits(start.value() * k) || !fits(high * k) || !fits(end * k)) {
+    return;
+  }
+
+  // iv 的其他使用（循环后的使用、φ 函数等）都不允许
+  auto member = [&](ValueId value) {
+    if (value >= iv_of.size()) {
+      return false;
+    }
+    auto f = affine(value);
+    return f.has_value() && f->base == iv.phi;
+  };
+  auto chain = [&](const IRQuad &quad) {
+    return quad.dst != NONE && quad.dst < iv_of.size() && defs[quad.dst].op != IROp::FUNC
+      && (quad.op == IROp::ASSIGN || quad.op == IROp::ADD || quad.op == IROp::SUB)
+      && member(quad.dst);
+  };
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &phi : block.phis) {
+      if (phi.dst == iv.phi) {
+        continue;
+      }
+      for (const auto &arg : phi.args) {
+        if (member(arg.value)) {
+          return;
+        }
+      }
+    }
+    for (const auto &quad : block.quads) {
+      if (&quad == test || chain(quad)) {
+        continue;
+      }
+      bool used = false;
+      ir::forEachUse(code, quad, [&](ValueId value) { used = used || member(value); });
+      if (used) {
+        return;
+      }
+    }
+  }
+
+  test->arg1 = r->phi;
+  test->arg2 = code.newConst(wrap(end * k));
+}
+
+/**
+ * @brief  对一个循环做强度削弱与测试替换
+ * @return 是否修改了函数
+ */
+bool
+IVReducer::reduce(LoopId id)
+{
+  auto preheader = forest.preheader(func, id);
+  if (preheader == NONE) {
+    return false;
+  }
+
+  collect(id);
+  findIVs(preheader);
+  if (ivs.empty()) {
+    return false;
+  }
+  auto products = findProducts();
+  if (products.empty()) {
+    return false;
+  }
+
+  for (auto &r : reduced) {
+    r.phi = newTemp();
+    materialize(r, preheader);
+  }
+
+  // dst = (iv + d) * k  =>  dst = j + d * k
+  for (const auto &product : products) {
+    const auto &r = reduced[product.reduced];
+    auto &quad = func.block(product.block).quads[product.index];
+    if (product.offset == 0) {
+      quad = IRQuad{.op = IROp::ASSIGN, .arg1 = r.phi, .dst = quad.dst};
+      continue;
+    }
+
+    ValueId offset = NONE;
+    if (r.constant.has_value()) {
+      offset = code.newConst(wrap(std::int64_t{product.offset} * r.constant.value()));
+    } else if (product.offset == 1) {
+      offset = r.factor;
+    } else {
+      offset = newTemp();
+      emit(preheader, {.op = IROp::MUL, .arg1 = r.factor, .arg2 = code.newConst(product.offset), .dst = offset});
+    }
+    quad = IRQuad{.op = IROp::ADD, .arg1 = r.phi, .arg2 = offset, .dst = quad.dst};
+  }
+
+  for (std::size_t i = 0; i < ivs.size(); ++i) {
+    replaceTest(i);
+  }
+
+  for (const auto &[block, quad] : pending) {
+    auto &quads = func.block(block).quads;
+    auto pos = func.block(block).terminator() != nullptr ? quads.size() - 1 : quads.size();
+    quads.insert(quads.begin() + static_cast<std::ptrdiff_t>(pos), quad);
+  }
+  return true;
+}
+
+} // namespace
+
+/**
+ * @brief 归纳变量的强度削弱与测试替换（要求函数处于 SSA 形式）
+ */
+Preserved
+reduceInductions(ir::Function &func, AnalysisManager &am)
+{
+  const auto &forest = am.loops();
+
+  IVReducer reducer{func, forest};
+  bool changed = false;
+  for (auto id = static_cast<LoopId>(forest.size()); id-- > 0;) {
+    changed = reducer.reduce(id) || changed;
+  }
+  return changed ? Preserved::CFG : Preserved::ALL;
+}
+
+} // namespace opt
@@ -0,0 +1,32 @@
+/**
+ * @file iv.hpp
+ * @brief Induction variable strength reduction and linear function test
+ *        replacement.
+ *
+ * A basic induction variable is a phi function i in a loop header whose
+ * value on every back edge is i + c for a constant c, possibly through
+ * copies and additions of constants; a range for loop yields one for its
+ * iterator. A product (i + d) * k in the body, with k a constant or defined
+ * outside the loop, is replaced by a new induction variable j = i * k,
+ * initialised in the preheader and increased by c * k on every back edge,
+ * so the multiplication becomes a copy or an addition. Products with the
+ * same i and k share one j. All arithmetic wraps like the target, so the
+ * rewrite is exact even if the products overflow.
+ *
+ * If i is then only used by its own update and by the exit test in the
+ * header (i + d >= E, or i + d < E feeding the exit branch) with E, the
+ * start value and c > 0 constant, the test is rewritten to compare j with
+ * (E - d) * k for a positive constant k, as long as none of the values i
+ * and j take in the loop can overflow, and dead code elimination removes i.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto reduceInductions(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
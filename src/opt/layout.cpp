@@ -0,0 +1,303 @@
+#include <array>
+#include <format>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "panic.hpp"
+#include "layout.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::LabelId;
+
+namespace {
+
+class Layout {
+public:
+  explicit Layout(ir::Function &func);
+
+public:
+  bool run();
+
+private:
+  void place();
+  auto likelySucc(BlockId b) const -> BlockId;
+  bool coldPart(BlockId b) const { return split && pos[b] >= hot; }
+
+  auto labelOf(BlockId b) -> LabelId;
+  auto newLabel(std::uint64_t count) -> LabelId;
+  auto trampoline(BlockId to, bool cold) -> LabelId;
+  void fixJumps(std::size_t i);
+  void commit();
+
+private:
+  ir::Function &func;
+  ir::FuncCode &code;
+  BlockId       n;
+  bool          split; // 有剖析数据：移到末尾的冷块放入 .text.unlikely
+
+  std::vector<std::uint64_t> count;  // 各块的执行次数（剖析数据）
+  std::vector<bool>          sink;   // 移到函数末尾的块：冷块或提前返回
+  std::vector<BlockId>       target; // 原来的布局中块尾跳转的目标，没有时为 NONE
+  std::vector<BlockId>       fall;   // 原来的布局中顺序执行的下一个块，没有时为 NONE
+
+  std::vector<bool>    placed; // 已经排入新布局的块
+  std::vector<BlockId> order;  // 新的布局
+  std::vector<BlockId> pos;    // 块 -> 在新布局中的位置
+  std::size_t          hot = 0; // order 中移到末尾的块之前的部分的长度
+
+  std::vector<LabelId>        jumps; // 块 -> 紧跟在它之后的 goto 块跳到的标号，没有时为 NONE
+  std::vector<ir::BasicBlock> added; // 新建的块（goto 块、跳板），下标接在原有的块之后
+  std::array<std::vector<BlockId>, 2> tramps; // 热、冷两部分末尾的跳板
+  std::array<std::unordered_map<BlockId, LabelId>, 2> tramp_of; // 跳板的目标块 -> 跳板的标号
+};
+
+/**
+ * @brief 记下原来的布局中各块的跳转、执行次数与要移到末尾的块
+ */
+Layout::Layout(ir::Function &func)
+  : func(func), code(func.funcCode()), n(static_cast<BlockId>(func.size())), split(code.counts.has_value()),
+    count(n, 0), sink(n, false), target(n, NONE), fall(n, NONE), jumps(n, NONE)
+{
+  std::uint64_t prev = 0;
+  for (BlockId b = 0; b < n; ++b) {
+    const auto &block = func.block(b);
+    if (split) {
+      count[b] = prev = code.counts->at(block.quads.front(), prev);
+    }
+
+    const auto *term = block.terminator();
+    if (term != nullptr && term->op != IROp::RETURN) {
+      target[b] = func.labelBlock(term->label);
+    }
+    if (block.fallsThrough() && b + 1 < n) {
+      fall[b] = b + 1;
+    }
+
+    if (b != 0) {
+      sink[b] = split ? count[b] == 0
+        : term != nullptr && term->op == IROp::RETURN && b + 1 != n;
+    }
+  }
+}
+
+/**
+ * @brief  重排各块
+ * @return 布局是否改变
+ */
+bool
+Layout::run()
+{
+  // 最后一个块不能顺序落出函数（IR 生成保证函数以 return 结束）
+  if (n <= 1 || func.block(n - 1).fallsThrough()) {
+    return false;
+  }
+  // 从未调用过的函数整个放入 .text.unlikely
+  if (split && code.counts->entry == 0) {
+    code.cold = code.quads.front().label;
+    return false;
+  }
+
+  place();
+  bool moved = false;
+  for (BlockId i = 0; i < n; ++i) {
+    moved = moved || order[i] != i;
+  }
+  if (!moved && !(split && hot < n)) {
+    return false;
+  }
+
+  // 有剖析数据时，离开了原来的前一个块的块要有标号，才能继续取到自己的执行次数
+  if (split) {
+    for (std::size_t i = 1; i < order.size(); ++i) {
+      if (order[i - 1] + 1 != order[i]) {
+        labelOf(order[i]);
+      }
+    }
+  }
+  if (split && hot < n) {
+    code.cold = labelOf(order[hot]);
+  }
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    fixJumps(i);
+  }
+  commit();
+  return true;
+}
+
+/**
+ * @brief 排出新的布局：从入口与其余未排的块出发，依次接上最可能执行的后继；
+ *        要移到末尾的块按原来的顺序排在最后
+ */
+void
+Layout::place()
+{
+  placed.assign(n, false);
+  for (BlockId seed = 0; seed < n; ++seed) {
+    if (placed[seed] || sink[seed]) {
+      continue;
+    }
+    for (auto b = seed; b != NONE; b = likelySucc(b)) {
+      placed[b] = true;
+      order.push_back(b);
+    }
+  }
+  hot = order.size();
+  for (BlockId b = 0; b < n; ++b) {
+    if (sink[b]) {
+      order.push_back(b);
+    }
+  }
+
+  pos.assign(n, 0);
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    pos[order[i]] = static_cast<BlockId>(i);
+  }
+}
+
+/**
+ * @brief 接在 b 之后的块：有剖析数据时为执行次数最多的后继（相同时取原来顺序执行的块），
+ *        否则保持原来的顺序；没有未排的后继时为 NONE
+ */
+BlockId
+Layout::likelySucc(BlockId b) const
+{
+  BlockId best = NONE;
+  for (auto succ : func.block(b).succs) {
+    if (placed[succ] || sink[succ]) {
+      continue;
+    }
+    if (!split) {
+      best = succ == fall[b] ? succ : best;
+    } else if (best == NONE || count[succ] > count[best] || (count[succ] == count[best] && succ == fall[b])) {
+      best = succ;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief 块首的标号，没有时新建一个
+ */
+LabelId
+Layout::labelOf(BlockId b)
+{
+  if (auto label = func.block(b).label(); label != NONE) {
+    return label;
+  }
+  ASSERT_MSG(b != 0, "the entry block can't be a jump target");
+  auto label = newLabel(count[b]);
+  auto &quads = func.block(b).quads;
+  quads.insert(quads.begin(), IRQuad{.op = IROp::LABEL, .label = label});
+  return label;
+}
+
+/**
+ * @brief 新建标号；有剖析数据时记下所在块的执行次数
+ */
+LabelId
+Layout::newLabel(std::uint64_t count)
+{
+  auto id = code.addLabel(std::format("{}_lay{}", code.name, code.labelCount()));
+  if (code.counts.has_value()) {
+    code.counts->labels.insert_or_assign(id, count);
+  }
+  return id;
+}
+
+/**
+ * @brief 热（cold 为 false）或冷的部分末尾跳到块 to 的跳板，同一目标共用一个
+ */
+LabelId
+Layout::trampoline(BlockId to, bool cold)
+{
+  auto &labels = tramp_of[cold ? 1 : 0];
+  if (auto it = labels.find(to); it != labels.end()) {
+    return it->second;
+  }
+  auto label = newLabel(count[to]);
+  auto dest  = labelOf(to);
+  tramps[cold ? 1 : 0].push_back(n + static_cast<BlockId>(added.size()));
+  added.push_back({.quads = {{.op = IROp::LABEL, .label = label}, {.op = IROp::GOTO, .label = dest}}});
+  labels.emplace(to, label);
+  return label;
+}
+
+/**
+ * @brief 按新的布局修正 order[i] 块尾的跳转
+ *
+ * 原来顺序执行的下一个块不再紧跟其后时：条件跳转的目标恰好紧跟其后则反转条件，
+ * 否则补上 goto（块尾已有条件跳转时放在紧跟其后的新块中）。
+ * 热、冷两部分之间不顺序执行；条件跳转跨过两部分时改为跳到本部分末尾的跳板。
+ */
+void
+Layout::fixJumps(std::size_t i)
+{
+  auto b    = order[i];
+  auto next = i + 1 < order.size() && !(split && i + 1 == hot) ? order[i + 1] : NONE;
+  auto &quads = func.block(b).quads;
+  bool branch = ir::isBranch(quads.back().op);
+
+  if (fall[b] != NONE && fall[b] != next) {
+    auto &last = quads.back();
+    if (branch && target[b] == next && (last.op == IROp::BEQZ || last.op == IROp::BNEZ)) {
+      last.op    = last.op == IROp::BEQZ ? IROp::BNEZ : IROp::BEQZ;
+      last.label = labelOf(fall[b]);
+      target[b]  = fall[b];
+    } else if (branch) {
+      jumps[b] = labelOf(fall[b]);
+    } else {
+      quads.push_back({.op = IROp::GOTO, .label = labelOf(fall[b])});
+    }
+  }
+
+  if (branch && coldPart(target[b]) != coldPart(b)) {
+    quads.back().label = trampoline(target[b], coldPart(b));
+  }
+}
+
+/**
+ * @brief 把新建的块加到函数中，再按新的布局排列：
+ *        goto 块紧跟在各自的块之后，跳板放在各部分的末尾
+ */
+void
+Layout::commit()
+{
+  std::vector<BlockId> laid;
+  laid.reserve(order.size() + added.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    if (i == hot) {
+      laid.insert(laid.end(), tramps[0].begin(), tramps[0].end());
+    }
+    laid.push_back(order[i]);
+    if (jumps[order[i]] != NONE) {
+      laid.push_back(n + static_cast<BlockId>(added.size()));
+      added.push_back({.quads = {{.op = IROp::GOTO, .label = jumps[order[i]]}}});
+    }
+  }
+  if (hot == order.size()) {
+    laid.insert(laid.end(), tramps[0].begin(), tramps[0].end());
+  }
+  laid.insert(laid.end(), tramps[1].begin(), tramps[1].end());
+
+  func.insertBlocks(n, std::move(added));
+  func.reorder(laid);
+}
+
+} // namespace
+
+/**
+ * @brief 按剖析数据或静态的启发式重排基本块，冷块移到函数末尾
+ */
+Preserved
+layoutBlocks(ir::Function &func, AnalysisManager & /*am*/)
+{
+  return Layout{func}.run() ? Preserved::NONE : Preserved::ALL;
+}
+
+} // namespace opt
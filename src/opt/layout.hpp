@@ -0,0 +1,40 @@
+/**
+ * @file layout.hpp
+ * @brief Basic-block layout and hot/cold splitting.
+ *
+ * The IR builder lays blocks out in source order, so an early return or a
+ * rarely taken arm sits in the middle of the hot path and the fast path pays
+ * a taken branch around it. This pass, the last of the pipeline, orders the
+ * blocks again:
+ *
+ *   - with a profile (--profile-use) a trace starts at the entry and keeps
+ *     following the most frequently executed successor that is not placed
+ *     yet; blocks that never ran (count 0) go after all others, into the cold
+ *     part of the function, which the code generator puts in .text.unlikely.
+ *     A function that was never called is cold as a whole;
+ *   - without one the order of the builder is kept, loop bodies stay
+ *     contiguous, and only early returns (blocks ending in a return other
+ *     than the last one) move to the end of the function.
+ *
+ * Jumps are then fixed for the new order: a conditional branch whose target
+ * now follows it is inverted (beqz <-> bnez) so the likely path falls
+ * through, and a fall-through edge that is no longer adjacent gets a goto.
+ * Only unconditional jumps cross between the hot and the cold part (a
+ * conditional branch reaches +-4 KiB only): a branch into the other part is
+ * redirected to a trampoline (a label and a goto) at the end of its own part.
+ *
+ * FuncCode::cold names the label that starts the cold part. New labels get
+ * the execution count of their block, so later users of the profile still
+ * read the right counts.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto layoutBlocks(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
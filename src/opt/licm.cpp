@@ -0,0 +1,227 @@
+#include <vector>
+#include <algorithm>
+
+#include "fold.hpp"
+#include "licm.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::ValueId;
+
+namespace {
+
+class LICM {
+public:
+  LICM(ir::Function &func, const DominatorTree &dom, const LoopForest &forest)
+    : func(func), code(func.funcCode()), dom(dom), forest(forest) {}
+
+public:
+  void init();
+  bool hoist(LoopId id);
+
+private:
+  /**
+   * @brief 值是否不在当前循环中定义（常量总是如此）
+   */
+  [[nodiscard]] bool invariant(ValueId value) const { return stamp[value] != cur; }
+
+  /**
+   * @brief 值是否可以作为被外提的运算的操作数
+   */
+  [[nodiscard]] bool operand(ValueId value) const { return stable[value] && invariant(value); }
+
+  [[nodiscard]] bool hoistable(const IRQuad &quad, BlockId block) const;
+  [[nodiscard]] bool inBounds(const IRQuad &quad) const;
+  [[nodiscard]] bool guaranteed(BlockId block) const;
+
+private:
+  ir::Function        &func;
+  ir::FuncCode        &code;
+  const DominatorTree &dom;
+  const LoopForest    &forest;
+
+  std::vector<bool>          stable;   // 常量或只定义一次的非别名值
+  std::vector<bool>          alias;    // 数组/元组元素的别名
+  std::vector<std::uint32_t> accesses; // 别名 -> 定义它的 INDEX/DOT 的个数
+
+  std::vector<LoopId>  stamp;     // 值 -> 最近一次标记时定义它的循环
+  LoopId               cur = NONE; // 正在处理的循环
+  std::vector<BlockId> exiting;    // 当前循环中有后继在循环之外的块
+};
+
+void
+LICM::init()
+{
+  auto n = code.valueCount();
+
+  std::vector<std::uint32_t> defs(n, 0);
+  alias.assign(n, false);
+  accesses.assign(n, 0);
+  for (auto param : code.params) {
+    ++defs[param];
+  }
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &phi : block.phis) {
+      ++defs[phi.dst];
+    }
+    for (const auto &quad : block.quads) {
+      if (auto dst = ir::definedValue(quad); dst != NONE) {
+        ++defs[dst];
+        if (ir::isElemAccess(quad)) {
+          alias[dst] = true;
+          ++accesses[dst];
+        }
+      }
+    }
+  }
+
+  stable.assign(n, false);
+  for (ValueId value = 0; value < n; ++value) {
+    stable[value] = code.value(value)->isConst() || (defs[value] == 1 && !alias[value]);
+  }
+  stamp.assign(n, NONE);
+}
+
+/**
+ * @brief 元素访问的下标是否是范围之内的常量（越界的访问会停止程序）
+ */
+bool
+LICM::inBounds(const IRQuad &quad) const
+{
+  const auto &index = *code.value(quad.arg2);
+  if (!index.isConst()) {
+    return false;
+  }
+  auto idx = ir::constValue(index);
+  return idx >= 0 && idx < code.value(quad.arg1)->type->size();
+}
+
+/**
+ * @brief 进入当前循环后块是否一定执行：它支配循环的每个出口
+ */
+bool
+LICM::guaranteed(BlockId block) const
+{
+  return !exiting.empty() && std::ranges::all_of(exiting, [&](BlockId exit) {
+    return dom.dominates(block, exit);
+  });
+}
+
+/**
+ * @brief 四元式是否可以外提到当前循环的前置块
+ * @param block 四元式所在的块
+ */
+bool
+LICM::hoistable(const IRQuad &quad, BlockId block) const
+{
+  if (ir::isBinary(quad.op)) {
+    if (!stable[quad.dst] || !operand(quad.arg1) || !operand(quad.arg2)) {
+      return false;
+    }
+    if (quad.op == IROp::DIV) {
+      const auto &divisor = *code.value(quad.arg2);
+      return divisor.isConst() && ir::constValue(divisor) != 0;
+    }
+    return true;
+  }
+
+  switch (quad.op) {
+    case IROp::ASSIGN:
+      // 向别名赋值是写内存
+      return !alias[quad.dst] && stable[quad.dst] && ir::isScalar(*code.value(quad.dst))
+        && operand(quad.arg1);
+    case IROp::INDEX: case IROp::DOT:
+      // 元素的位置只依赖于聚合体与下标；可能越界的访问只在一定执行时外提，
+      // 否则不进入循环体（或不走这条路径）时也会停止程序
+      return accesses[quad.dst] == 1 && invariant(quad.arg1) && operand(quad.arg2)
+        && (inBounds(quad) || guaranteed(block));
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief  把一个循环中的不变量外提到它的前置块
+ * @return 是否外提了四元式
+ */
+bool
+LICM::hoist(LoopId id)
+{
+  auto preheader = forest.preheader(func, id);
+  if (preheader == NONE) {
+    return false;
+  }
+
+  // 标记在循环中定义的值；通过别名的赋值不改变别名本身
+  const auto &loop = forest.loop(id);
+  cur = id;
+  exiting.clear();
+  for (auto block : loop.blocks) {
+    if (std::ranges::any_of(func.block(block).succs, [&](BlockId succ) { return !loop.contains(succ); })) {
+      exiting.push_back(block);
+    }
+    for (const auto &phi : func.block(block).phis) {
+      stamp[phi.dst] = id;
+    }
+    for (const auto &quad : func.block(block).quads) {
+      if (quad.dst != NONE && !(quad.op == IROp::ASSIGN && alias[quad.dst])) {
+        stamp[quad.dst] = id;
+      }
+    }
+  }
+
+  // 按逆后序访问，操作数的定义先于使用被外提
+  std::vector<IRQuad> moved;
+  for (auto block : dom.rpo()) {
+    if (!loop.contains(block)) {
+      continue;
+    }
+    std::erase_if(func.block(block).quads, [&](const IRQuad &quad) {
+      if (!hoistable(quad, block)) {
+        return false;
+      }
+      moved.push_back(quad);
+      stamp[quad.dst] = NONE;
+      return true;
+    });
+  }
+  if (moved.empty()) {
+    return false;
+  }
+
+  auto &quads = func.block(preheader).quads;
+  auto pos = func.block(preheader).terminator() != nullptr ? quads.size() - 1 : quads.size();
+  quads.insert(quads.begin() + static_cast<std::ptrdiff_t>(pos), moved.begin(), moved.end());
+  return true;
+}
+
+} // namespace
+
+/**
+ * @brief 循环不变量外提（要求函数处于 SSA 形式）
+ */
+Preserved
+hoistInvariants(ir::Function &func, AnalysisManager &am)
+{
+  const auto &forest = am.loops();
+  if (forest.size() == 0) {
+    return Preserved::ALL;
+  }
+
+  LICM licm{func, am.domTree(), forest};
+  licm.init();
+
+  // 内层循环排在外层循环之后
+  bool changed = false;
+  for (auto id = static_cast<LoopId>(forest.size()); id-- > 0;) {
+    changed = licm.hoist(id) || changed;
+  }
+  return changed ? Preserved::CFG : Preserved::ALL;
+}
+
+} // namespace opt
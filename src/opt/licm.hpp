@@ -0,0 +1,37 @@
+/**
+ * @file licm.hpp
+ * @brief Loop-invariant code motion.
+ *
+ * Loops are visited from the innermost outwards. In the blocks of a loop,
+ * in reverse post order, a quad is invariant when every operand is a
+ * constant or is defined outside the loop (or by a quad hoisted before);
+ * invariant arithmetic and comparisons, copies into scalars (constant
+ * materializations included) and INDEX/DOT element accesses are moved to
+ * the end of the loop's preheader. Code hoisted into the preheader of an
+ * inner loop can then leave the outer loop as well.
+ *
+ * In SSA form every such quad defines a name of its own, and the quads are
+ * free of side effects, so moving them out of conditional code in the body
+ * is safe. A division is only moved when its divisor is a nonzero constant,
+ * so the hoisted code never divides by zero on a path that did not. Reading
+ * through an element alias loads from memory that the loop may write; only
+ * the element access itself, whose location does not change, is moved.
+ * An access out of bounds stops the program, so it is only moved when its
+ * index is a constant in range, or when its block dominates every exit of
+ * the loop: then it runs whenever the loop is entered and left, and a loop
+ * that runs zero times, or a guarded access, still does not trap.
+ *
+ * Loops without a preheader (a single predecessor outside the loop that
+ * only leads to the header) are left alone.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto hoistInvariants(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
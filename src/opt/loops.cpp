@@ -0,0 +1,111 @@
+#include <algorithm>
+
+#include "loops.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::BlockId;
+
+/**
+ * @brief 块是否在循环体中
+ */
+bool
+Loop::contains(BlockId block) const
+{
+  return std::ranges::binary_search(blocks, block);
+}
+
+/**
+ * @brief 找出所有自然循环并建立嵌套关系
+ * @param func 函数的基本块视图
+ * @param dom  func 的支配树
+ */
+LoopForest::LoopForest(const ir::Function &func, const DominatorTree &dom)
+{
+  block_loops.assign(func.size(), NONE);
+
+  std::vector<bool> in_body(func.size(), false);
+  for (auto header : dom.rpo()) {
+    Loop loop{.header = header};
+    for (auto pred : func.block(header).preds) {
+      if (dom.dominates(header, pred)) {
+        loop.latches.push_back(pred);
+      }
+    }
+    if (loop.latches.empty()) {
+      continue;
+    }
+
+    // 从回边的源块沿前驱反向遍历，直到循环头
+    std::vector<BlockId> worklist{loop.latches};
+    in_body[header] = true;
+    loop.blocks.push_back(header);
+    while (!worklist.empty()) {
+      auto block = worklist.back();
+      worklist.pop_back();
+      if (in_body[block]) {
+        continue;
+      }
+      in_body[block] = true;
+      loop.blocks.push_back(block);
+      for (auto pred : func.block(block).preds) {
+        if (dom.reachable(pred) && !in_body[pred]) {
+          worklist.push_back(pred);
+        }
+      }
+    }
+    for (auto block : loop.blocks) {
+      in_body[block] = false;
+    }
+
+    std::ranges::sort(loop.blocks);
+    loops.push_back(std::move(loop));
+  }
+
+  // 外层循环的循环体更大，排在前面；按此顺序登记，每个块最终记录的是最内层循环
+  std::ranges::stable_sort(loops, [](const Loop &a, const Loop &b) {
+    return a.blocks.size() > b.blocks.size();
+  });
+  for (LoopId id = 0; id < loops.size(); ++id) {
+    auto &loop = loops[id];
+    loop.parent = block_loops[loop.header];
+    if (loop.parent == NONE) {
+      top.push_back(id);
+    } else {
+      loops[loop.parent].children.push_back(id);
+      loop.depth = loops[loop.parent].depth + 1;
+    }
+    for (auto block : loop.blocks) {
+      block_loops[block] = id;
+    }
+  }
+}
+
+/**
+ * @brief  循环的前置块：循环外唯一的前驱，且其唯一的后继是循环头
+ * @return 前置块，不存在时返回 NONE
+ */
+BlockId
+LoopForest::preheader(const ir::Function &func, LoopId id) const
+{
+  const auto &loop = loops[id];
+
+  BlockId outside = NONE;
+  for (auto pred : func.block(loop.header).preds) {
+    if (loop.contains(pred)) {
+      continue;
+    }
+    if (outside != NONE) {
+      return NONE;
+    }
+    outside = pred;
+  }
+
+  if (outside == NONE || func.block(outside).succs.size() != 1) {
+    return NONE;
+  }
+  return outside;
+}
+
+} // namespace opt
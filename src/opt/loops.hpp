@@ -0,0 +1,71 @@
+/**
+ * @file loops.hpp
+ * @brief Loop nesting forest of an ir::Function.
+ *
+ * Every back edge (an edge whose target dominates its source) defines a
+ * natural loop; back edges to the same header are merged into one loop. Loops
+ * are nested by body inclusion: the parent of a loop is the smallest loop
+ * that contains its header. The IR only comes from structured while, for and
+ * loop expressions, so every loop is reducible.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include "cfg.hpp"
+#include "dominance.hpp"
+
+namespace opt {
+
+using LoopId = std::uint32_t;
+
+struct Loop {
+  ir::BlockId              header;             // 循环头
+  std::vector<ir::BlockId> blocks;             // 循环体（含循环头与内层循环的块），按块下标升序
+  std::vector<ir::BlockId> latches;            // 回边的源块
+  LoopId                   parent = ir::NONE;  // 外层循环
+  std::vector<LoopId>      children;           // 直接内层的循环
+  std::uint32_t            depth  = 1;         // 嵌套深度，最外层为 1
+
+  [[nodiscard]] bool contains(ir::BlockId block) const;
+};
+
+class LoopForest {
+public:
+  LoopForest(const ir::Function &func, const DominatorTree &dom);
+
+public:
+  [[nodiscard]] std::size_t size() const { return loops.size(); }
+  [[nodiscard]] const Loop &loop(LoopId id) const { return loops[id]; }
+  [[nodiscard]] std::span<const Loop> allLoops() const { return loops; }
+
+  /**
+   * @brief 最外层的循环
+   */
+  [[nodiscard]] std::span<const LoopId> roots() const { return top; }
+
+  /**
+   * @brief 包含该块的最内层循环，不在循环中时返回 NONE
+   */
+  [[nodiscard]] LoopId innermost(ir::BlockId block) const { return block_loops[block]; }
+
+  /**
+   * @brief 块所在的循环嵌套深度，不在循环中时为 0
+   */
+  [[nodiscard]] std::uint32_t depth(ir::BlockId block) const {
+    return block_loops[block] == ir::NONE ? 0 : loops[block_loops[block]].depth;
+  }
+
+  [[nodiscard]] auto preheader(const ir::Function &func, LoopId id) const -> ir::BlockId;
+
+private:
+  std::vector<Loop>   loops;       // 按循环体从大到小排列，外层循环总在内层循环之前
+  std::vector<LoopId> top;         // 最外层的循环
+  std::vector<LoopId> block_loops; // BlockId -> 最内层循环
+};
+
+} // namespace opt
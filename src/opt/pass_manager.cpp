@@ -0,0 +1,113 @@
+#include "ast.hpp"
+#include "parallel.hpp"
+#include "time_report.hpp"
+#include "pass_manager.hpp"
+
+namespace opt {
+
+/**
+ * @brief 支配树，第一次请求时计算
+ */
+const DominatorTree &
+AnalysisManager::domTree()
+{
+  if (!dom.has_value()) {
+    dom.emplace(func);
+  }
+  return dom.value();
+}
+
+/**
+ * @brief 循环嵌套森林，第一次请求时计算
+ */
+const LoopForest &
+AnalysisManager::loops()
+{
+  if (!loop_forest.has_value()) {
+    loop_forest.emplace(func, domTree());
+  }
+  return loop_forest.value();
+}
+
+/**
+ * @brief 根据 pass 的修改丢弃失效的分析结果
+ */
+void
+AnalysisManager::invalidate(Preserved preserved)
+{
+  if (preserved == Preserved::NONE) {
+    dom.reset();
+    loop_forest.reset();
+  }
+}
+
+/**
+ * @brief 在流水线末尾添加一个 pass
+ * @param name pass 的名字
+ * @param run  pass 本身
+ */
+void
+PassManager::add(std::string name, PassFn run)
+{
+  passes.push_back({std::move(name), std::move(run)});
+}
+
+/**
+ * @brief 添加一个程序级的 pass
+ * @param name pass 的名字
+ * @param run  pass 本身
+ */
+void
+PassManager::addModule(std::string name, ModulePassFn run)
+{
+  module_passes.push_back({std::move(name), std::move(run)});
+}
+
+/**
+ * @brief 对一个函数依次执行所有 pass，结果写回 FuncCode
+ * @param code 函数的稠密 IR
+ */
+void
+PassManager::run(ir::FuncCode &code) const
+{
+  ir::Function func{code};
+  AnalysisManager am{func};
+
+  bool changed = false;
+  for (const auto &pass : passes) {
+    util::TimeScope scope{report, pass.name};
+    auto preserved = pass.run(func, am);
+    am.invalidate(preserved);
+    changed = changed || preserved != Preserved::ALL;
+  }
+
+  if (changed) {
+    func.commit();
+  }
+}
+
+/**
+ * @brief 依次执行程序级的 pass，再对程序中的每个函数执行所有函数级的 pass
+ * @param prog 已生成 IR 的程序（缓存命中的函数的 code 为空）
+ * @param jobs 线程数
+ */
+void
+PassManager::run(ast::Prog &prog, unsigned jobs) const
+{
+  for (const auto &pass : module_passes) {
+    util::TimeScope scope{report, pass.name};
+    pass.run(prog);
+  }
+  if (passes.empty()) {
+    return;
+  }
+
+  util::parallelFor(prog.decls.size(), jobs, [&](std::size_t i) {
+    auto &code = static_cast<ast::FuncDeclPtr>(prog.decls[i])->code;
+    if (code) {
+      run(*code);
+    }
+  });
+}
+
+} // namespace opt
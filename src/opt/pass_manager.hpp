@@ -0,0 +1,105 @@
+/**
+ * @file pass_manager.hpp
+ * @brief Function pass pipeline with lazily computed, cached analyses.
+ *
+ * A pass transforms one ir::Function and returns which analyses are still
+ * valid afterwards. The AnalysisManager computes the dominator tree and the
+ * loop forest on first request and keeps them until a pass reports that it
+ * changed the block structure, so consecutive passes that only rewrite quads
+ * inside blocks share one computation.
+ *
+ * Passes only touch the function they are given, so the PassManager runs
+ * the functions of a program in parallel. Module passes (e.g. inlining) see
+ * the whole program instead; they run first, one after another.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <string_view>
+
+#include "cfg.hpp"
+#include "loops.hpp"
+#include "dominance.hpp"
+
+namespace ast { struct Prog; }
+
+namespace util { class TimeReport; }
+
+namespace opt {
+
+// pass 执行之后仍然有效的分析结果
+enum class Preserved : std::uint8_t {
+  NONE, // 改变了块的结构（增删块、修改跳转），所有分析失效
+  CFG,  // 只改变了块内的非跳转四元式，支配树与循环仍然有效
+  ALL,  // 没有做任何修改
+};
+
+// 分析结果的缓存
+class AnalysisManager {
+public:
+  explicit AnalysisManager(ir::Function &func) : func(func) {}
+
+public:
+  auto domTree() -> const DominatorTree &;
+  auto loops() -> const LoopForest &;
+
+  void invalidate(Preserved preserved);
+
+private:
+  ir::Function &func;
+
+  std::optional<DominatorTree> dom;         // 支配树
+  std::optional<LoopForest>    loop_forest; // 循环嵌套森林
+};
+
+using PassFn = std::function<Preserved(ir::Function &, AnalysisManager &)>;
+
+// 一个函数级的 pass
+struct Pass {
+  std::string name; // 名字，用于调试输出
+  PassFn      run;
+};
+
+using ModulePassFn = std::function<void(ast::Prog &)>;
+
+// 一个程序级的 pass，在所有函数级的 pass 之前执行
+struct ModulePass {
+  std::string  name; // 名字，用于调试输出
+  ModulePassFn run;
+};
+
+class PassManager {
+public:
+  PassManager() = default;
+  ~PassManager() = default;
+
+public:
+  void add(std::string name, PassFn run);
+  void addModule(std::string name, ModulePassFn run);
+
+  [[nodiscard]] bool empty() const { return passes.empty() && module_passes.empty(); }
+
+  /**
+   * @brief 设置 --time-report 的统计，每个 pass 的执行计时（nullptr 表示不统计）
+   */
+  void setReport(util::TimeReport *report) {
+    this->report = report;
+  }
+
+  void run(ir::FuncCode &code) const;
+  void run(ast::Prog &prog, unsigned jobs) const;
+
+private:
+  std::vector<ModulePass> module_passes; // 按添加顺序执行
+  std::vector<Pass>       passes;        // 按添加顺序执行
+
+  util::TimeReport *report = nullptr; // --time-report 的统计
+};
+
+} // namespace opt
@@ -0,0 +1,56 @@
+#include "iv.hpp"
+#include "dce.hpp"
+#include "gvn.hpp"
+#include "ssa.hpp"
+#include "licm.hpp"
+#include "sccp.hpp"
+#include "inline.hpp"
+#include "layout.hpp"
+#include "unroll.hpp"
+#include "tail_rec.hpp"
+#include "copy_prop.hpp"
+#include "const_calls.hpp"
+#include "simplify_cfg.hpp"
+#include "pipeline.hpp"
+
+namespace opt {
+
+/**
+ * @brief 按优化选项向 pm 中添加 pass
+ * @param pm   空的 pass manager
+ * @param opts 优化选项
+ */
+void
+buildPipeline(PassManager &pm, const OptOptions &opts)
+{
+  if (opts.level == 0) {
+    return;
+  }
+
+  pm.addModule("const-calls", evaluateCalls);
+  if (opts.inlines()) {
+    pm.addModule("inline", [threshold = opts.inline_threshold](ast::Prog &prog) {
+      inlineCalls(prog, threshold);
+    });
+  }
+  pm.add("tailrec", eliminateTailRecursion);
+  if (opts.unroll > 1) {
+    pm.add("unroll", [factor = opts.unroll](ir::Function &func, AnalysisManager &am) {
+      return unrollLoops(func, am, factor);
+    });
+  }
+  pm.add("ssa", constructSSA);
+  pm.add("sccp", propagateConstants);
+  pm.add("copyprop", propagateCopies);
+  pm.add("gvn", numberValues);
+  pm.add("licm", hoistInvariants);
+  pm.add("iv", reduceInductions);
+  pm.add("dce", eliminateDeadCode);
+  pm.add("out-of-ssa", destructSSA);
+  pm.add("simplify-cfg", simplifyCFG);
+  pm.add("coalesce", coalesceCopies);
+  pm.add("dce", eliminateDeadCode);
+  pm.add("layout", layoutBlocks);
+}
+
+} // namespace opt
@@ -0,0 +1,64 @@
+/**
+ * @file pipeline.hpp
+ * @brief The optimization pipeline selected by the -O level.
+ *
+ *   -O0  no pass, the IR is handed to the code generator as built
+ *   -O1  calls to pure functions with constant arguments are first
+ *        evaluated in the IR interpreter, small functions are inlined at
+ *        their call sites (-finline-threshold=N) and tail recursion becomes
+ *        a loop, then the function passes run on SSA form between its
+ *        construction and destruction: constant and copy propagation, value
+ *        numbering, loop invariant code motion and induction variable
+ *        strength reduction;
+ *        copies left by SSA destruction are coalesced afterwards; with
+ *        --unroll N, range for loops are first unrolled up to N times;
+ *        finally the blocks are laid out again, by the profile when there
+ *        is one (--profile-use), with never executed blocks split off into
+ *        .text.unlikely
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include <string>
+#include <format>
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+// 优化选项
+struct OptOptions {
+  unsigned level            = 0;  // -O 级别
+  unsigned unroll           = 1;  // 循环展开的最大倍数，1 表示不展开
+  unsigned inline_threshold = 16; // 内联的代价阈值，0 表示不内联
+
+  /**
+   * @brief 是否内联（内联后函数的输出还依赖于被调用者的函数体）
+   */
+  [[nodiscard]] bool inlines() const { return level > 0 && inline_threshold > 0; }
+
+  /**
+   * @brief 函数的输出是否依赖于被调用者的函数体（内联与编译期求值）
+   */
+  [[nodiscard]] bool usesCallees() const { return level > 0; }
+
+  /**
+   * @brief 参与增量编译缓存键：选项不同的编译不能共享缓存
+   */
+  [[nodiscard]] std::string key() const
+  {
+    auto key = std::format("O{}", level);
+    if (unroll > 1) {
+      key += std::format("-unroll{}", unroll);
+    }
+    if (inlines()) {
+      key += std::format("-inline{}", inline_threshold);
+    }
+    return key;
+  }
+};
+
+void buildPipeline(PassManager &pm, const OptOptions &opts);
+
+} // namespace opt
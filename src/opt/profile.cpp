@@ -0,0 +1,208 @@
+#include <print>
+#include <format>
+#include <fstream>
+
+#include "ast.hpp"
+#include "cfg.hpp"
+#include "profile.hpp"
+
+namespace opt {
+
+using ir::IROp;
+using ir::IRQuad;
+
+namespace {
+
+inline constexpr std::string_view PROFILE_MAGIC   = "toy-profile";
+inline constexpr int              PROFILE_VERSION = 1;
+
+/**
+ * @brief 第 i 个四元式是否是基本块的第一个（与 ir::Function 的划分规则相同）
+ */
+bool
+isLeader(const std::vector<IRQuad> &quads, std::size_t i)
+{
+  return i == 0 || quads[i].op == IROp::LABEL || ir::isTerminator(quads[i - 1].op);
+}
+
+/**
+ * @brief 函数的基本块个数
+ */
+std::size_t
+blockCount(const std::vector<IRQuad> &quads)
+{
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < quads.size(); ++i) {
+    count += isLeader(quads, i) ? 1 : 0;
+  }
+  return count;
+}
+
+} // namespace
+
+/**
+ * @brief  读取插桩程序写出的剖析数据
+ * @param  path 文件路径
+ * @return 剖析数据，无法打开或格式不对时为空
+ */
+std::optional<Profile>
+Profile::load(const std::string &path)
+{
+  std::ifstream in{path};
+  std::string magic;
+  int version = 0;
+  if (!(in >> magic >> version) || magic != PROFILE_MAGIC || version != PROFILE_VERSION) {
+    return std::nullopt;
+  }
+
+  Profile profile;
+  std::string name;
+  std::size_t blocks = 0;
+  while (in >> name >> blocks) {
+    std::vector<std::uint64_t> counts(blocks);
+    for (auto &count : counts) {
+      if (!(in >> count)) {
+        return std::nullopt;
+      }
+    }
+    profile.funcs.insert_or_assign(std::move(name), std::move(counts));
+  }
+  if (!in.eof()) {
+    return std::nullopt;
+  }
+  return profile;
+}
+
+/**
+ * @brief 函数各基本块的执行次数，剖析数据中没有该函数时为 nullptr
+ */
+const std::vector<std::uint64_t> *
+Profile::counts(std::string_view name) const
+{
+  auto it = funcs.find(std::string{name});
+  return it == funcs.end() ? nullptr : &it->second;
+}
+
+/**
+ * @brief  在每个函数的每个基本块开头（标号之后）插入计数的 probe
+ * @param  prog 刚生成 IR、尚未优化的程序
+ * @return 各函数的计数器，按声明顺序连续排列
+ */
+std::vector<ProbedFunc>
+instrument(ast::Prog &prog)
+{
+  std::vector<ProbedFunc> probed;
+  std::size_t next = 0;
+  for (const auto &decl : prog.decls) {
+    const auto &code = static_cast<ast::FuncDeclPtr>(decl)->code;
+    if (!code) {
+      continue;
+    }
+
+    auto &func = probed.emplace_back(ProbedFunc{.name = code->name, .first = next, .blocks = 0});
+    std::vector<IRQuad> quads;
+    quads.reserve(code->quads.size() * 2);
+    for (std::size_t i = 0; i < code->quads.size(); ++i) {
+      const auto &quad = code->quads[i];
+      if (!isLeader(code->quads, i)) {
+        quads.push_back(quad);
+        continue;
+      }
+
+      IRQuad probe{.op = IROp::PROBE, .arg1 = code->newConst(static_cast<int>(next++))};
+      if (quad.op == IROp::LABEL || quad.op == IROp::FUNC) {
+        quads.push_back(quad);
+        quads.push_back(probe);
+      } else {
+        quads.push_back(probe);
+        quads.push_back(quad);
+      }
+      ++func.blocks;
+    }
+    code->quads = std::move(quads);
+  }
+  return probed;
+}
+
+/**
+ * @brief 在汇编的末尾定义计数器数组与函数表 { 函数名, 块数 }，以 { 0, 0 } 结束
+ */
+void
+emitCounters(std::ostream &out, const std::vector<ProbedFunc> &funcs)
+{
+  std::size_t total = funcs.empty() ? 0 : funcs.back().first + funcs.back().blocks;
+
+  std::println(out, "  .bss");
+  std::println(out, "  .align 3");
+  std::println(out, "  .globl {}", PROFILE_COUNTERS);
+  std::println(out, "{}:", PROFILE_COUNTERS);
+  std::println(out, "  .zero {}", total * 8);
+  std::println(out, "");
+  std::println(out, "  .section .rodata");
+  std::println(out, "  .align 3");
+  std::println(out, "  .globl {}", PROFILE_TABLE);
+  std::println(out, "{}:", PROFILE_TABLE);
+  for (std::size_t i = 0; i < funcs.size(); ++i) {
+    std::println(out, "  .dword .Lprof_name{}, {}", i, funcs[i].blocks);
+  }
+  std::println(out, "  .dword 0, 0");
+  for (std::size_t i = 0; i < funcs.size(); ++i) {
+    std::println(out, ".Lprof_name{}:", i);
+    std::println(out, "  .string \"{}\"", funcs[i].name);
+  }
+}
+
+/**
+ * @brief 把剖析数据附加到块数相符的函数上（code->counts）；
+ *        次数与上一个块不同的无标号块补上标号，使各块都能取到自己的次数
+ * @param prog    刚生成 IR、尚未优化的程序
+ * @param profile 剖析数据
+ */
+void
+annotate(ast::Prog &prog, const Profile &profile)
+{
+  for (const auto &decl : prog.decls) {
+    const auto &code = static_cast<ast::FuncDeclPtr>(decl)->code;
+    if (!code) {
+      continue;
+    }
+    const auto *counts = profile.counts(code->name);
+    if (counts == nullptr) {
+      continue;
+    }
+    if (counts->size() != blockCount(code->quads)) {
+      std::println(stderr, "剖析数据与函数 {} 不符（源代码可能已经修改），忽略", code->name);
+      continue;
+    }
+
+    ir::BlockCounts annotated;
+    std::vector<IRQuad> quads;
+    quads.reserve(code->quads.size());
+    std::size_t block = 0;
+    std::uint64_t prev = 0;
+    for (std::size_t i = 0; i < code->quads.size(); ++i) {
+      const auto &quad = code->quads[i];
+      if (!isLeader(code->quads, i)) {
+        quads.push_back(quad);
+        continue;
+      }
+      auto count = (*counts)[block++];
+      if (quad.op == IROp::FUNC) {
+        annotated.entry = count;
+      } else if (quad.op == IROp::LABEL) {
+        annotated.labels.emplace(quad.label, count);
+      } else if (count != prev) {
+        // 没有标号的块（如条件跳转之后的分支）与上一个块的次数不同时补上标号
+        auto label = code->addLabel(std::format("{}_prof{}", code->name, block - 1));
+        annotated.labels.emplace(label, count);
+        quads.push_back({.op = IROp::LABEL, .label = label});
+      }
+      quads.push_back(quad);
+      prev = count;
+    }
+    code->quads = std::move(quads);
+    code->counts = std::move(annotated);
+  }
+}
+
+} // namespace opt
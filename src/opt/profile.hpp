@@ -0,0 +1,74 @@
+/**
+ * @file profile.hpp
+ * @brief Block execution counts: instrumentation (--profile-generate) and
+ *        profile feedback (--profile-use).
+ *
+ * Both sides number the basic blocks of every function the same way, on the
+ * IR as built (before any pass) with the leader rule of ir::Function, so a
+ * profile recorded by an instrumented build matches the blocks of a later
+ * build of the same source at any -O level.
+ *
+ * instrument() puts a PROBE quad at the start of every block (after its
+ * label); the code generator turns it into an increment of one 64-bit slot
+ * of __toy_prof_counts. emitCounters() appends that array and a table of
+ * { name, number of blocks } records to the assembly, which the dump hook
+ * in riscv-asm/main.c writes out after main0 returns:
+ *
+ *   toy-profile 1
+ *   fib 4 177 89 88 88
+ *   main0 1 1
+ *
+ * annotate() attaches the counts of a profile to the functions whose block
+ * count still matches: the entry count and the count of every labelled block
+ * (ir::BlockCounts). An unlabelled block whose count differs from the block
+ * before it (e.g. the arm right after a conditional branch) gets a label of
+ * its own first; labels produce no code. Labels survive the passes, and the passes that copy
+ * code (inlining, unrolling) give the copies scaled counts, so later users
+ * (the inliner, the unroller, the register allocator's spill weights) read
+ * the count of a block from its label, or take the count of the block before
+ * it for an unlabelled block.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace ast { struct Prog; }
+
+namespace opt {
+
+// 计数器数组与函数表的符号名，riscv-asm/main.c 以弱引用读取
+inline constexpr std::string_view PROFILE_COUNTERS = "__toy_prof_counts";
+inline constexpr std::string_view PROFILE_TABLE    = "__toy_prof_table";
+
+// 插桩的一个函数：计数器从 first 开始，每个基本块一个
+struct ProbedFunc {
+  std::string name;
+  std::size_t first;
+  std::size_t blocks;
+};
+
+// 剖析数据：函数名 -> 各基本块的执行次数
+class Profile {
+public:
+  static auto load(const std::string &path) -> std::optional<Profile>;
+
+public:
+  [[nodiscard]] auto counts(std::string_view name) const -> const std::vector<std::uint64_t> *;
+
+private:
+  std::unordered_map<std::string, std::vector<std::uint64_t>> funcs;
+};
+
+auto instrument(ast::Prog &prog) -> std::vector<ProbedFunc>;
+void emitCounters(std::ostream &out, const std::vector<ProbedFunc> &funcs);
+void annotate(ast::Prog &prog, const Profile &profile);
+
+} // namespace opt
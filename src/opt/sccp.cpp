@@ -0,0 +1,411 @@
+#include <vector>
+#include <algorithm>
+
+#include "fold.hpp"
+#include "sccp.hpp"
+#include "panic.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::ValueId;
+
+namespace {
+
+// 格上的一个值：TOP（尚未确定）> CONST（常量）> BOTTOM（不是常量）
+struct Cell {
+  enum Kind : std::uint8_t { TOP, CONST, BOTTOM } kind = TOP;
+  int value = 0;
+};
+
+// 值的一处使用：块中的第 index 个四元式或第 index 个 φ 函数
+struct Use {
+  BlockId       block;
+  std::uint32_t index;
+  bool          phi;
+};
+
+class SCCP {
+public:
+  explicit SCCP(ir::Function &func) : func(func), code(func.funcCode()) {}
+
+public:
+  void init();
+  void solve();
+  auto rewrite() -> Preserved;
+
+private:
+  void lower(ValueId value, Cell cell);
+  void markEdge(BlockId from, BlockId to);
+  [[nodiscard]] bool edgeExecutable(BlockId from, BlockId to) const;
+
+  void visitPhi(BlockId block, std::uint32_t index);
+  void visitQuad(BlockId block, std::uint32_t index);
+  void visitBranch(BlockId block, const IRQuad &quad);
+
+  [[nodiscard]] const Cell &cell(ValueId value) const { return cells[value]; }
+
+private:
+  ir::Function &func;
+  ir::FuncCode &code;
+
+  std::vector<Cell>             cells; // ValueId -> 格上的值
+  std::vector<std::vector<Use>> uses;  // ValueId -> 使用它的地方
+
+  std::vector<bool>              block_exec; // 块是否可执行
+  std::vector<std::vector<bool>> edge_exec;  // 块 -> 各后继边是否可执行
+
+  std::vector<std::pair<BlockId, BlockId>> flow_work; // 新的可执行边
+  std::vector<ValueId>                     ssa_work;  // 格上的值降低了的值
+};
+
+/**
+ * @brief 初始化格：常量为 CONST；形参、未定义的值、多次赋值的值（数组元素别名等）
+ *        以及调用、数组/元组操作的结果为 BOTTOM；其余为 TOP
+ */
+void
+SCCP::init()
+{
+  auto n = code.valueCount();
+  cells.assign(n, {});
+  uses.assign(n, {});
+
+  std::vector<std::uint32_t> defs(n, 0);
+  for (auto param : code.params) {
+    ++defs[param];
+  }
+  for (BlockId id = 0; id < func.size(); ++id) {
+    auto &block = func.block(id);
+    for (std::uint32_t i = 0; i < block.phis.size(); ++i) {
+      ++defs[block.phis[i].dst];
+      for (const auto &arg : block.phis[i].args) {
+        uses[arg.value].push_back({.block = id, .index = i, .phi = true});
+      }
+    }
+    for (std::uint32_t i = 0; i < block.quads.size(); ++i) {
+      auto &quad = block.quads[i];
+      ir::forEachUse(code, quad, [&](ValueId value) {
+        uses[value].push_back({.block = id, .index = i, .phi = false});
+      });
+      if (auto dst = ir::definedValue(quad); dst != NONE) {
+        ++defs[dst];
+        if (!ir::isBinary(quad.op) && quad.op != IROp::ASSIGN) {
+          cells[dst].kind = Cell::BOTTOM;
+        }
+      }
+    }
+  }
+
+  for (ValueId value = 0; value < n; ++value) {
+    const auto &val = code.value(value);
+    if (val->isConst()) {
+      cells[value] = {.kind = Cell::CONST, .value = ir::constValue(*val)};
+    } else if (defs[value] != 1) {
+      cells[value].kind = Cell::BOTTOM;
+    }
+  }
+  for (auto param : code.params) {
+    cells[param].kind = Cell::BOTTOM;
+  }
+
+  block_exec.assign(func.size(), false);
+  edge_exec.resize(func.size());
+  for (BlockId id = 0; id < func.size(); ++id) {
+    edge_exec[id].assign(func.block(id).succs.size(), false);
+  }
+}
+
+/**
+ * @brief 把值在格上降低到 cell（与原有的值求交）
+ */
+void
+SCCP::lower(ValueId value, Cell cell)
+{
+  auto &cur = cells[value];
+  if (cell.kind == Cell::TOP || cur.kind == Cell::BOTTOM) {
+    return;
+  }
+  if (cur.kind == Cell::CONST && cell.kind == Cell::CONST && cur.value == cell.value) {
+    return;
+  }
+
+  cur = cur.kind == Cell::TOP ? cell : Cell{.kind = Cell::BOTTOM};
+  ssa_work.push_back(value);
+}
+
+void
+SCCP::markEdge(BlockId from, BlockId to)
+{
+  flow_work.emplace_back(from, to);
+}
+
+bool
+SCCP::edgeExecutable(BlockId from, BlockId to) const
+{
+  const auto &succs = func.block(from).succs;
+  for (std::size_t i = 0; i < succs.size(); ++i) {
+    if (succs[i] == to) {
+      return edge_exec[from][i];
+    }
+  }
+  return false;
+}
+
+void
+SCCP::visitPhi(BlockId block, std::uint32_t index)
+{
+  const auto &phi = func.block(block).phis[index];
+
+  Cell meet;
+  for (const auto &arg : phi.args) {
+    if (!edgeExecutable(arg.pred, block)) {
+      continue;
+    }
+    const auto &in = cell(arg.value);
+    if (in.kind == Cell::TOP) {
+      continue;
+    }
+    if (meet.kind == Cell::TOP) {
+      meet = in;
+    } else if (in.kind == Cell::BOTTOM || in.value != meet.value) {
+      meet.kind = Cell::BOTTOM;
+    }
+    if (meet.kind == Cell::BOTTOM) {
+      break;
+    }
+  }
+  lower(phi.dst, meet);
+}
+
+void
+SCCP::visitQuad(BlockId block, std::uint32_t index)
+{
+  const auto &quad = func.block(block).quads[index];
+
+  if (ir::isBinary(quad.op)) {
+    const auto &lhs = cell(quad.arg1);
+    const auto &rhs = cell(quad.arg2);
+    if (lhs.kind == Cell::BOTTOM || rhs.kind == Cell::BOTTOM) {
+      lower(quad.dst, {.kind = Cell::BOTTOM});
+    } else if (lhs.kind == Cell::CONST && rhs.kind == Cell::CONST) {
+      auto res = ir::foldBinary(quad.op, lhs.value, rhs.value);
+      lower(quad.dst, res.has_value()
+        ? Cell{.kind = Cell::CONST, .value = res.value()}
+        : Cell{.kind = Cell::BOTTOM}
+      );
+    }
+    return;
+  }
+
+  switch (quad.op) {
+    case IROp::ASSIGN:
+      lower(quad.dst, cell(quad.arg1));
+      break;
+    case IROp::GOTO:
+      markEdge(block, func.block(block).succs.front());
+      break;
+    case IROp::BEQZ: case IROp::BNEZ: case IROp::BGE:
+      visitBranch(block, quad);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief 条件已知时只有一条出边可执行
+ */
+void
+SCCP::visitBranch(BlockId block, const IRQuad &quad)
+{
+  const auto &succs = func.block(block).succs;
+
+  const auto &lhs = cell(quad.arg1);
+  Cell rhs{.kind = Cell::CONST, .value = 0};
+  if (quad.op == IROp::BGE) {
+    rhs = cell(quad.arg2);
+  }
+
+  if (lhs.kind == Cell::BOTTOM || rhs.kind == Cell::BOTTOM) {
+    for (auto succ : succs) {
+      markEdge(block, succ);
+    }
+    return;
+  }
+  if (lhs.kind == Cell::TOP || rhs.kind == Cell::TOP) {
+    return;
+  }
+
+  auto target = ir::branchTaken(quad.op, lhs.value, rhs.value)
+    ? func.labelBlock(quad.label) : block + 1;
+  if (std::ranges::find(succs, target) != succs.end()) {
+    markEdge(block, target);
+  }
+}
+
+/**
+ * @brief 迭代到不动点
+ */
+void
+SCCP::solve()
+{
+  flow_work.emplace_back(NONE, 0);
+  while (!flow_work.empty() || !ssa_work.empty()) {
+    while (!flow_work.empty()) {
+      auto [from, to] = flow_work.back();
+      flow_work.pop_back();
+
+      if (from != NONE) {
+        const auto &succs = func.block(from).succs;
+        auto i = static_cast<std::size_t>(std::ranges::find(succs, to) - succs.begin());
+        if (edge_exec[from][i]) {
+          continue;
+        }
+        edge_exec[from][i] = true;
+      }
+
+      auto &block = func.block(to);
+      for (std::uint32_t i = 0; i < block.phis.size(); ++i) {
+        visitPhi(to, i);
+      }
+      if (block_exec[to]) {
+        continue;
+      }
+
+      // 第一次到达的块：求值所有四元式，没有跳转时顺序执行到后继
+      block_exec[to] = true;
+      for (std::uint32_t i = 0; i < block.quads.size(); ++i) {
+        visitQuad(to, i);
+      }
+      if (block.terminator() == nullptr) {
+        for (auto succ : block.succs) {
+          markEdge(to, succ);
+        }
+      }
+    }
+
+    while (!ssa_work.empty()) {
+      auto value = ssa_work.back();
+      ssa_work.pop_back();
+      for (const auto &use : uses[value]) {
+        if (!block_exec[use.block]) {
+          continue;
+        }
+        if (use.phi) {
+          visitPhi(use.block, use.index);
+        } else {
+          visitQuad(use.block, use.index);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief 用分析结果改写函数
+ */
+Preserved
+SCCP::rewrite()
+{
+  bool changed = false;
+  bool cfg_changed = false;
+
+  // 值为常量时返回对应的常量操作数，否则返回 NONE
+  auto constant = [&](ValueId value) {
+    if (value >= cells.size()) {
+      return NONE; // 包括 NONE 与刚创建的常量
+    }
+    const auto &c = cell(value);
+    return c.kind == Cell::CONST && !code.value(value)->isConst()
+      ? code.newConst(c.value) : NONE;
+  };
+
+  std::vector<bool> dead(func.size(), false);
+  for (BlockId id = 0; id < func.size(); ++id) {
+    auto &block = func.block(id);
+    if (!block_exec[id]) {
+      dead[id] = true;
+      cfg_changed = true;
+      continue;
+    }
+
+    for (auto &phi : block.phis) {
+      for (auto &arg : phi.args) {
+        if (auto c = constant(arg.value); c != NONE) {
+          arg.value = c;
+          changed = true;
+        }
+      }
+    }
+
+    for (auto &quad : block.quads) {
+      if (ir::isBranch(quad.op)) {
+        continue; // 条件已知的跳转在下面消去，其余跳转的操作数都不是常量
+      }
+      ir::forEachUse(code, quad, [&](ValueId &value) {
+        if (auto c = constant(value); c != NONE) {
+          value = c;
+          changed = true;
+        }
+      });
+      if (auto c = constant(quad.dst); c != NONE && !(quad.op == IROp::ASSIGN && quad.arg1 == c)) {
+        quad = IRQuad{.op = IROp::ASSIGN, .arg1 = c, .dst = quad.dst};
+        changed = true;
+      }
+    }
+
+    // 只有一条出边可执行的条件跳转：改为 goto，或者删去而顺序执行
+    if (auto term = block.terminator(); term != nullptr && ir::isBranch(term->op)) {
+      std::vector<BlockId> live;
+      for (std::size_t i = 0; i < block.succs.size(); ++i) {
+        if (edge_exec[id][i]) {
+          live.push_back(block.succs[i]);
+        }
+      }
+      ASSERT_MSG(!live.empty(), "executable block without executable successor");
+      if (live.size() == 1 && block.succs.size() == 2) {
+        if (live.front() == func.labelBlock(term->label)) {
+          block.quads.back() = IRQuad{.op = IROp::GOTO, .label = term->label};
+        } else {
+          block.quads.pop_back();
+        }
+        cfg_changed = true;
+      } else if (live.size() == 1) {
+        // 跳转目标就是下一个块，两条路径相同
+        block.quads.pop_back();
+        cfg_changed = true;
+      }
+    }
+  }
+
+  if (std::ranges::find(dead, true) != dead.end()) {
+    func.removeBlocks(dead);
+  } else if (cfg_changed) {
+    func.rebuildEdges();
+  }
+
+  if (cfg_changed) {
+    return Preserved::NONE;
+  }
+  return changed ? Preserved::CFG : Preserved::ALL;
+}
+
+} // namespace
+
+/**
+ * @brief 稀疏条件常量传播（要求函数处于 SSA 形式）
+ */
+Preserved
+propagateConstants(ir::Function &func, AnalysisManager &am)
+{
+  SCCP sccp{func};
+  sccp.init();
+  sccp.solve();
+  return sccp.rewrite();
+}
+
+} // namespace opt
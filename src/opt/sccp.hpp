@@ -0,0 +1,28 @@
+/**
+ * @file sccp.hpp
+ * @brief Sparse conditional constant propagation.
+ *
+ * The algorithm of Wegman and Zadeck on SSA form: every value starts as
+ * undefined (top) and is only lowered to a constant or to overdefined
+ * (bottom); a block is only evaluated once an edge into it is known to be
+ * executable, and a phi function only meets the arguments of executable
+ * edges. Constants therefore flow through copies, user variables and loop
+ * headers, and a branch whose condition becomes a constant makes the other
+ * arm unreachable.
+ *
+ * Afterwards constant uses are replaced by the constant, branches on known
+ * conditions become gotos (or fall through), and the blocks that were never
+ * found executable are removed. Definitions of constants are rewritten into
+ * dst = constant and left to dead code elimination.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto propagateConstants(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
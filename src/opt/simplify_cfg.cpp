@@ -0,0 +1,211 @@
+#include <vector>
+
+#include "panic.hpp"
+#include "simplify_cfg.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::BlockId;
+
+namespace {
+
+/**
+ * @brief  删除从入口不可达的块
+ * @return 是否删除了块
+ */
+bool
+removeUnreachable(ir::Function &func)
+{
+  std::vector<bool> seen(func.size(), false);
+  std::vector<BlockId> worklist{0};
+  seen[0] = true;
+  while (!worklist.empty()) {
+    auto id = worklist.back();
+    worklist.pop_back();
+    for (auto succ : func.block(id).succs) {
+      if (!seen[succ]) {
+        seen[succ] = true;
+        worklist.push_back(succ);
+      }
+    }
+  }
+
+  std::vector<bool> dead(func.size(), false);
+  bool any = false;
+  for (BlockId id = 0; id < func.size(); ++id) {
+    dead[id] = !seen[id];
+    any = any || dead[id];
+  }
+  if (any) {
+    func.removeBlocks(dead);
+  }
+  return any;
+}
+
+/**
+ * @brief  只有标号（和一条 goto）的块会把控制转到哪个块
+ * @return 转到的块；不是这样的块时返回 NONE
+ */
+BlockId
+forwardTarget(const ir::Function &func, BlockId id)
+{
+  const auto &quads = func.block(id).quads;
+  if (quads.empty() || quads.front().op != IROp::LABEL) {
+    return NONE;
+  }
+  if (quads.size() == 1) {
+    // 跳转要指向标号，下一个块不以标号开头（跳转被删除后）时不转发
+    return id + 1 < func.size() && func.block(id + 1).label() != NONE ? id + 1 : NONE;
+  }
+  if (quads.size() == 2 && quads.back().op == IROp::GOTO) {
+    return func.labelBlock(quads.back().label);
+  }
+  return NONE;
+}
+
+/**
+ * @brief  把指向转发块的跳转直接指向最终的目标
+ * @return 是否修改了跳转
+ */
+bool
+threadJumps(ir::Function &func)
+{
+  bool changed = false;
+  for (auto &block : func.allBlocks()) {
+    if (block.terminator() == nullptr || block.quads.back().op == IROp::RETURN) {
+      continue;
+    }
+
+    auto &jump   = block.quads.back();
+    auto  target = func.labelBlock(jump.label);
+    // 转发块组成的环（死循环）在走过所有块之后停下
+    for (std::size_t steps = 0; steps < func.size(); ++steps) {
+      auto next = forwardTarget(func, target);
+      if (next == NONE || next == target) {
+        break;
+      }
+      target = next;
+    }
+
+    if (auto label = func.block(target).label(); label != jump.label) {
+      jump.label = label;
+      changed = true;
+    }
+  }
+
+  if (changed) {
+    func.rebuildEdges();
+  }
+  return changed;
+}
+
+/**
+ * @brief  删除跳转到下一个块的 goto 与条件跳转
+ * @return 是否删除了跳转
+ */
+bool
+removeRedundantJumps(ir::Function &func)
+{
+  bool changed = false;
+  for (BlockId id = 0; id + 1 < func.size(); ++id) {
+    auto &block = func.block(id);
+    auto term = block.terminator();
+    if (term == nullptr || term->op == IROp::RETURN) {
+      continue;
+    }
+    if (func.labelBlock(term->label) == id + 1) {
+      block.quads.pop_back();
+      changed = true;
+    }
+  }
+
+  if (changed) {
+    func.rebuildEdges();
+  }
+  return changed;
+}
+
+/**
+ * @brief  把唯一前驱只有这一个后继的块接到前驱的末尾
+ * @note   块接到不相邻的前驱之后不再位于原来的位置，所以这样的块不能顺序执行到下一个块
+ * @return 是否合并了块
+ */
+bool
+mergeBlocks(ir::Function &func)
+{
+  std::vector<bool> dead(func.size(), false);
+  auto nextLive = [&](BlockId id) {
+    do {
+      ++id;
+    } while (id < func.size() && dead[id]);
+    return id;
+  };
+
+  bool changed = false;
+  for (BlockId id = 0; id < func.size(); ++id) {
+    if (dead[id]) {
+      continue;
+    }
+
+    auto &pred = func.block(id);
+    while (pred.succs.size() == 1) {
+      auto  succ  = pred.succs.front();
+      auto &block = func.block(succ);
+      if (succ == 0 || succ == id || block.preds.size() != 1) {
+        break;
+      }
+      if (succ != nextLive(id) && block.fallsThrough()) {
+        break;
+      }
+
+      if (pred.terminator() != nullptr) {
+        ASSERT_MSG(pred.quads.back().op == IROp::GOTO, "unexpected jump to the only successor");
+        pred.quads.pop_back();
+      }
+      auto first = block.label() != NONE ? 1 : 0;
+      pred.quads.insert(pred.quads.end(), block.quads.begin() + first, block.quads.end());
+
+      // 前驱的个数不变，后继的 preds 中仍记录着被合并的块，只用于计数
+      pred.succs = std::move(block.succs);
+      block.quads.clear();
+      block.succs.clear();
+      dead[succ] = true;
+      changed = true;
+    }
+  }
+
+  if (changed) {
+    func.removeBlocks(dead);
+  }
+  return changed;
+}
+
+} // namespace
+
+/**
+ * @brief 化简控制流图（要求函数中没有 φ 函数）
+ */
+Preserved
+simplifyCFG(ir::Function &func, AnalysisManager &am)
+{
+#ifdef DEBUG
+  for (const auto &block : func.allBlocks()) {
+    ASSERT_MSG(block.phis.empty(), "simplify the CFG of a function in SSA form");
+  }
+#endif
+
+  bool changed = false;
+  for (bool again = true; again;) {
+    again = removeUnreachable(func);
+    again = threadJumps(func) || again;
+    again = removeRedundantJumps(func) || again;
+    again = mergeBlocks(func) || again;
+    changed = changed || again;
+  }
+
+  return changed ? Preserved::NONE : Preserved::ALL;
+}
+
+} // namespace opt
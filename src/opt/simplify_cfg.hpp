@@ -0,0 +1,27 @@
+/**
+ * @file simplify_cfg.hpp
+ * @brief Control flow graph cleanup.
+ *
+ * Repeats the following until nothing changes:
+ *   - blocks that are not reachable from the entry are removed;
+ *   - a jump to a block that only holds a label (and possibly a goto) is
+ *     redirected to where that block leads, so goto chains collapse;
+ *   - a goto to the next block and a branch whose target is the next block
+ *     are removed, the block falls through instead;
+ *   - a block whose only predecessor has no other successor is appended to
+ *     that predecessor, dropping its label and the goto between them.
+ *
+ * The pass works on the form without phi functions and runs after SSA
+ * destruction.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto simplifyCFG(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
@@ -0,0 +1,363 @@
+#include <ranges>
+#include <vector>
+
+#include "ssa.hpp"
+#include "panic.hpp"
+#include "bitset.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::ValueId;
+
+namespace {
+
+/**
+ * @brief 删除从入口不可达的块
+ * @note  不可达的块不会落入可达的块之前，跳转到它们的块也都不可达，可以整体删除
+ * @return 是否删除了块
+ */
+bool
+removeUnreachable(ir::Function &func, AnalysisManager &am)
+{
+  const auto &dom = am.domTree();
+
+  std::vector<bool> dead(func.size(), false);
+  bool any = false;
+  for (BlockId id = 0; id < func.size(); ++id) {
+    dead[id] = !dom.reachable(id);
+    any = any || dead[id];
+  }
+  if (!any) {
+    return false;
+  }
+
+  func.removeBlocks(dead);
+  am.invalidate(Preserved::NONE);
+  return true;
+}
+
+// 构造 SSA 时的状态：被重命名的值称为“变量”，以稠密下标 VarId 编号
+class SSABuilder {
+public:
+  using VarId = std::uint32_t;
+
+  SSABuilder(ir::Function &func, const DominatorTree &dom)
+    : func(func), code(func.funcCode()), dom(dom) {}
+
+public:
+  bool collectVars();
+  void computeLiveness();
+  void insertPhis();
+  void rename();
+
+private:
+  [[nodiscard]] VarId varOf(ValueId value) const {
+    return value < var_of.size() ? var_of[value] : NONE;
+  }
+
+  void renameBlock(BlockId id, std::vector<VarId> &log);
+
+private:
+  ir::Function         &func;
+  ir::FuncCode         &code;
+  const DominatorTree  &dom;
+
+  std::vector<VarId>   var_of; // 原有的值 -> 变量，不重命名的值为 NONE
+  std::vector<ValueId> vars;   // 变量 -> 原有的值
+
+  std::vector<std::vector<BlockId>> def_blocks; // 变量 -> 定义它的块
+  std::vector<util::BitSet>         live_in;    // 块 -> 入口处活跃的变量
+
+  std::vector<std::vector<VarId>>   phi_vars;   // 块 -> 各 φ 函数对应的变量
+
+  std::vector<std::vector<ValueId>> stacks;     // 变量 -> 当前可见的版本
+  std::vector<std::uint32_t>        versions;   // 变量 -> 已创建的版本数
+};
+
+/**
+ * @brief  找出需要重命名的值：多次赋值（形参在入口处算一次）的标量
+ * @return 是否存在这样的值
+ */
+bool
+SSABuilder::collectVars()
+{
+  auto count = code.valueCount();
+  std::vector<std::uint32_t> defs(count, 0);
+  std::vector<bool>          alias(count, false);
+  for (auto param : code.params) {
+    ++defs[param];
+  }
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &quad : block.quads) {
+      if (auto dst = ir::definedValue(quad); dst != NONE) {
+        ++defs[dst];
+        alias[dst] = alias[dst] || ir::isElemAccess(quad);
+      }
+    }
+  }
+
+  var_of.assign(count, NONE);
+  for (ValueId value = 0; value < count; ++value) {
+    if (defs[value] > 1 && !alias[value] && ir::isScalar(*code.value(value))) {
+      var_of[value] = static_cast<VarId>(vars.size());
+      vars.push_back(value);
+    }
+  }
+  return !vars.empty();
+}
+
+/**
+ * @brief 计算各块入口处活跃的变量，只在活跃的地方放置 φ 函数
+ */
+void
+SSABuilder::computeLiveness()
+{
+  auto n = func.size();
+  auto m = vars.size();
+
+  std::vector<util::BitSet> kill(n, util::BitSet{m});
+  live_in.assign(n, util::BitSet{m});
+  def_blocks.assign(m, {});
+
+  for (BlockId id = 0; id < n; ++id) {
+    for (auto &quad : func.block(id).quads) {
+      ir::forEachUse(code, quad, [&](ValueId value) {
+        if (auto var = varOf(value); var != NONE && !kill[id].test(var)) {
+          live_in[id].set(var);
+        }
+      });
+      if (auto var = varOf(ir::definedValue(quad)); var != NONE && !kill[id].test(var)) {
+        kill[id].set(var);
+        def_blocks[var].push_back(id);
+      }
+    }
+  }
+
+  // live_in = use ∪ (live_out - kill)，按后序迭代到不动点
+  auto rpo = dom.rpo();
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto id : rpo | std::views::reverse) {
+      for (auto succ : func.block(id).succs) {
+        changed = live_in[id].uniteExcept(live_in[succ], kill[id]) || changed;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 在定义的迭代支配边界上放置 φ 函数（参数在重命名时填写）
+ */
+void
+SSABuilder::insertPhis()
+{
+  auto n = func.size();
+  phi_vars.assign(n, {});
+
+  std::vector<VarId> has_phi(n, NONE);
+  std::vector<VarId> queued(n, NONE);
+  std::vector<BlockId> worklist;
+  for (VarId var = 0; var < vars.size(); ++var) {
+    // 入口处的值就是原有的值，入口块也算一次定义
+    worklist = def_blocks[var];
+    worklist.push_back(0);
+    for (auto id : worklist) {
+      queued[id] = var;
+    }
+
+    while (!worklist.empty()) {
+      auto id = worklist.back();
+      worklist.pop_back();
+      for (auto frontier : dom.frontier(id)) {
+        if (has_phi[frontier] == var || !live_in[frontier].test(var)) {
+          continue;
+        }
+        has_phi[frontier] = var;
+
+        auto &block = func.block(frontier);
+        ir::Phi phi{.dst = vars[var]};
+        for (auto pred : block.preds) {
+          phi.args.push_back({.pred = pred, .value = NONE});
+        }
+        block.phis.push_back(std::move(phi));
+        phi_vars[frontier].push_back(var);
+
+        if (queued[frontier] != var) {
+          queued[frontier] = var;
+          worklist.push_back(frontier);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief 重命名一个块中的定义与使用，并填写后继中 φ 函数的参数
+ * @param id  块
+ * @param log 本块压入版本的变量，退出块时据此弹栈
+ */
+void
+SSABuilder::renameBlock(BlockId id, std::vector<VarId> &log)
+{
+  auto fresh = [&](VarId var) {
+    auto value = code.newVersion(vars[var], ++versions[var]);
+    stacks[var].push_back(value);
+    log.push_back(var);
+    return value;
+  };
+
+  auto &block = func.block(id);
+  for (std::size_t i = 0; i < block.phis.size(); ++i) {
+    block.phis[i].dst = fresh(phi_vars[id][i]);
+  }
+
+  for (auto &quad : block.quads) {
+    ir::forEachUse(code, quad, [&](ValueId &value) {
+      if (auto var = varOf(value); var != NONE) {
+        value = stacks[var].back();
+      }
+    });
+    if (auto var = varOf(quad.dst); var != NONE) {
+      quad.dst = fresh(var);
+    }
+  }
+
+  for (auto succ : block.succs) {
+    auto &phis = func.block(succ).phis;
+    for (std::size_t i = 0; i < phis.size(); ++i) {
+      for (auto &arg : phis[i].args) {
+        if (arg.pred == id) {
+          arg.value = stacks[phi_vars[succ][i]].back();
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief 沿支配树先序重命名（显式栈，避免很深的支配树导致栈溢出）
+ */
+void
+SSABuilder::rename()
+{
+  stacks.assign(vars.size(), {});
+  for (VarId var = 0; var < vars.size(); ++var) {
+    stacks[var].push_back(vars[var]);
+  }
+  versions.assign(vars.size(), 0);
+
+  struct Frame {
+    BlockId     block;
+    std::size_t mark;    // 进入块之前 log 的长度
+    bool        entered;
+  };
+  std::vector<VarId> log;
+  std::vector<Frame> frames{{.block = 0, .mark = 0, .entered = false}};
+  while (!frames.empty()) {
+    auto &frame = frames.back();
+    if (frame.entered) {
+      for (auto i = log.size(); i > frame.mark; --i) {
+        stacks[log[i - 1]].pop_back();
+      }
+      log.resize(frame.mark);
+      frames.pop_back();
+      continue;
+    }
+
+    frame.entered = true;
+    frame.mark    = log.size();
+    auto id = frame.block;
+    renameBlock(id, log);
+    for (auto child : dom.children(id)) {
+      frames.push_back({.block = child, .mark = 0, .entered = false});
+    }
+  }
+
+#ifdef DEBUG
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &phi : block.phis) {
+      for (const auto &arg : phi.args) {
+        ASSERT_MSG(arg.value != NONE, "phi argument is not renamed");
+      }
+    }
+  }
+#endif
+}
+
+/**
+ * @brief 在块尾（跳转之前）插入一条复制
+ */
+void
+appendCopy(ir::BasicBlock &block, ValueId src, ValueId dst)
+{
+  auto pos = block.terminator() != nullptr ? block.quads.size() - 1 : block.quads.size();
+  block.quads.insert(
+    block.quads.begin() + static_cast<std::ptrdiff_t>(pos),
+    IRQuad{.op = IROp::ASSIGN, .arg1 = src, .dst = dst}
+  );
+}
+
+} // namespace
+
+/**
+ * @brief 将函数转换为 SSA 形式
+ * @note  先删除不可达的块，只在可达的部分构造 SSA
+ */
+Preserved
+constructSSA(ir::Function &func, AnalysisManager &am)
+{
+  bool removed = removeUnreachable(func, am);
+
+  SSABuilder builder{func, am.domTree()};
+  if (!builder.collectVars()) {
+    return removed ? Preserved::NONE : Preserved::ALL;
+  }
+  builder.computeLiveness();
+  builder.insertPhis();
+  builder.rename();
+
+  return removed ? Preserved::NONE : Preserved::CFG;
+}
+
+/**
+ * @brief 消去 φ 函数，回到可以直接生成代码的形式
+ */
+Preserved
+destructSSA(ir::Function &func, AnalysisManager &am)
+{
+  auto &code = func.funcCode();
+
+  bool changed = false;
+  std::vector<IRQuad> heads;
+  for (BlockId id = 0; id < func.size(); ++id) {
+    auto &block = func.block(id);
+    if (block.phis.empty()) {
+      continue;
+    }
+    changed = true;
+
+    heads.clear();
+    for (const auto &phi : block.phis) {
+      auto dst  = code.value(phi.dst); // newTemp 会扩充侧表，不能持有引用
+      auto temp = code.newTemp(dst->type, dst->pos);
+      for (const auto &arg : phi.args) {
+        appendCopy(func.block(arg.pred), arg.value, temp);
+      }
+      heads.push_back({.op = IROp::ASSIGN, .arg1 = temp, .dst = phi.dst});
+    }
+    block.phis.clear();
+
+    // 自环时上面的复制插入在本块的块尾，这里插入块首，互不影响
+    auto pos = block.label() != NONE ? 1 : 0;
+    block.quads.insert(block.quads.begin() + pos, heads.begin(), heads.end());
+  }
+
+  return changed ? Preserved::CFG : Preserved::ALL;
+}
+
+} // namespace opt
@@ -0,0 +1,34 @@
+/**
+ * @file ssa.hpp
+ * @brief Conversion of a function into SSA form and back.
+ *
+ * The IR builder only keeps expression temporaries in SSA form; user
+ * variables, the formals and the temporaries that carry the value of an if
+ * or loop expression are assigned many times. constructSSA renames every
+ * such scalar (i32/bool) value so that each name has exactly one definition:
+ * phi functions are placed on the iterated dominance frontiers of the
+ * definitions (pruned by liveness), and the uses are renamed along the
+ * dominator tree. The value a name has on entry keeps the original name, so
+ * the formals need no definition.
+ *
+ * destructSSA replaces every phi function x = phi(a1, ..., an) by a fresh
+ * temporary t: each predecessor i assigns t = ai before its jump, and the
+ * block starts with x = t. Since t is only read at the head of the phi's own
+ * block, the copies are correct on critical edges and cannot clobber each
+ * other, whatever the passes in between did to the live ranges.
+ *
+ * Aggregates and the element aliases produced by INDEX/DOT stay in memory
+ * and are not renamed.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto constructSSA(ir::Function &func, AnalysisManager &am) -> Preserved;
+auto destructSSA(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
@@ -0,0 +1,139 @@
+#include <format>
+#include <vector>
+
+#include "def_use.hpp"
+#include "tail_rec.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr int MAX_STEPS = 64; // 沿复制与跳转向后查找 return 的最大步数
+
+/**
+ * @brief 块中第 index 个四元式（调用）的结果是否只经过复制与跳转到达 return
+ * @param alias 值是否是数组/元组元素的别名（向它复制会写入内存）
+ */
+bool
+inTailPosition(const ir::Function &func, BlockId block, std::size_t index, const std::vector<bool> &alias)
+{
+  const auto &code = func.funcCode();
+  auto tracked = func.block(block).quads[index].dst;
+
+  auto b = block;
+  auto i = index + 1;
+  for (int steps = 0; steps < MAX_STEPS; ++steps) {
+    const auto &quads = func.block(b).quads;
+    if (i == quads.size()) {
+      if (b + 1 == func.size()) {
+        return false;
+      }
+      b = b + 1;
+      i = 0;
+      continue;
+    }
+
+    const auto &quad = quads[i];
+    switch (quad.op) {
+      case IROp::LABEL: case IROp::PROBE:
+        ++i;
+        break;
+      case IROp::ASSIGN:
+        if (quad.arg1 != tracked || alias[quad.dst] || !ir::isScalar(*code.value(quad.dst))) {
+          return false;
+        }
+        tracked = quad.dst;
+        ++i;
+        break;
+      case IROp::GOTO:
+        b = func.labelBlock(quad.label);
+        i = 0;
+        break;
+      case IROp::RETURN:
+        return quad.arg1 == NONE || quad.arg1 == tracked;
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+/**
+ * @brief 把尾递归调用改写为跳回函数入口的循环（在构造 SSA 之前执行）
+ */
+Preserved
+eliminateTailRecursion(ir::Function &func, AnalysisManager &am)
+{
+  auto &code = func.funcCode();
+
+  std::vector<bool> alias(code.valueCount(), false);
+  for (const auto &block : func.allBlocks()) {
+    for (const auto &quad : block.quads) {
+      if (ir::isElemAccess(quad)) {
+        alias[quad.dst] = true;
+      }
+    }
+  }
+  for (auto param : code.params) {
+    if (!ir::isScalar(*code.value(param))) {
+      return Preserved::ALL;
+    }
+  }
+
+  ir::LabelId entry = NONE; // 循环头的标号，第一次改写时创建
+  for (BlockId id = 0; id < func.size(); ++id) {
+    auto &quads = func.block(id).quads;
+    for (std::size_t i = 0; i < quads.size(); ++i) {
+      const auto &call = quads[i];
+      if (call.op != IROp::CALL || code.label(call.label) != code.name || !inTailPosition(func, id, i, alias)) {
+        continue;
+      }
+
+      if (entry == NONE) {
+        entry = code.addLabel(std::format("{}_tailrec", code.name));
+      }
+
+      // 先把实参复制到临时变量中，再一起赋给形参
+      std::vector<IRQuad> jump;
+      std::vector<ValueId> temps;
+      auto args = code.elems(call.elems);
+      for (std::size_t k = 0; k < code.params.size(); ++k) {
+        const auto &param = code.value(code.params[k]);
+        temps.push_back(code.newTemp(param->type, param->pos));
+        jump.push_back({.op = IROp::ASSIGN, .arg1 = args[k], .dst = temps.back()});
+      }
+      for (std::size_t k = 0; k < code.params.size(); ++k) {
+        jump.push_back({.op = IROp::ASSIGN, .arg1 = temps[k], .dst = code.params[k]});
+      }
+      jump.push_back({.op = IROp::GOTO, .label = entry});
+
+      quads.resize(i);
+      quads.insert(quads.end(), jump.begin(), jump.end());
+      break; // 块以 goto 结束，其后没有别的四元式
+    }
+  }
+  if (entry == NONE) {
+    return Preserved::ALL;
+  }
+
+  // 入口块在 FUNC 之后拆开，循环头以 f_tailrec 开头
+  auto &head = func.block(0).quads;
+  ir::BasicBlock loop;
+  loop.quads.push_back({.op = IROp::LABEL, .label = entry});
+  loop.quads.insert(loop.quads.end(), head.begin() + 1, head.end());
+  head.resize(1);
+  std::vector<ir::BasicBlock> added;
+  added.push_back(std::move(loop));
+  func.insertBlocks(1, std::move(added));
+  return Preserved::NONE;
+}
+
+} // namespace opt
@@ -0,0 +1,31 @@
+/**
+ * @file tail_rec.hpp
+ * @brief Tail recursion elimination.
+ *
+ * Runs on the IR as built, before SSA construction. A call of the function
+ * itself is in tail position when its result only travels through copies,
+ * labels and gotos into a return (or the function returns unit), e.g.
+ *
+ *       %3 = call f(%1, %2)            %4 = %1
+ *       return %3 -> f          =>     %5 = %2
+ *                                      n = %4
+ *                                      m = %5
+ *                                      goto f_tailrec
+ *
+ * The arguments are first copied into fresh temporaries, since one of them
+ * may read a parameter that an earlier copy overwrites. f_tailrec labels
+ * the code right after the function entry, so the recursion becomes a loop
+ * whose header merges the parameters; SSA construction places their phi
+ * functions there. Other tail calls are left to the code generator.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto eliminateTailRecursion(ir::Function &func, AnalysisManager &am) -> Preserved;
+
+} // namespace opt
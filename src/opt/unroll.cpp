@@ -0,0 +1,232 @@
+#include <format>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+
+#include "fold.hpp"
+#include "unroll.hpp"
+#include "def_use.hpp"
+
+namespace opt {
+
+using ir::NONE;
+using ir::IROp;
+using ir::IRQuad;
+using ir::BlockId;
+using ir::LabelId;
+using ir::ValueId;
+
+namespace {
+
+inline constexpr std::size_t MAX_GROWTH = 512; // 展开最多增加的四元式个数
+
+// 可以展开的循环：循环体是 [header + 1, latch] 中的块
+struct Candidate {
+  BlockId  header;
+  BlockId  latch;
+  unsigned factor;
+};
+
+std::optional<int>
+constant(const ir::FuncCode &code, ValueId value)
+{
+  if (value == NONE || !code.value(value)->isConst()) {
+    return std::nullopt;
+  }
+  return ir::constValue(*code.value(value));
+}
+
+/**
+ * @brief  判断循环是否是常量次数的 for 循环
+ * @param  factor 最大的展开倍数
+ * @return 整除循环次数的展开倍数，不展开时返回 0
+ */
+unsigned
+unrollFactor(const ir::Function &func, const LoopForest &forest, LoopId id, unsigned factor)
+{
+  const auto &code = func.funcCode();
+  const auto &loop = forest.loop(id);
+  if (!loop.children.empty() || loop.latches.size() != 1) {
+    return 0;
+  }
+  auto header = loop.header;
+  auto latch  = loop.latches.front();
+  if (latch < header || std::ranges::any_of(loop.blocks, [&](BlockId b) { return b < header || b > latch; })) {
+    return 0;
+  }
+  // 循环的块在布局中连续，其间只能夹有不可达的块（如只有标号的空块）
+  for (auto block = header; block <= latch; ++block) {
+    if (!loop.contains(block) && !func.block(block).preds.empty()) {
+      return 0;
+    }
+  }
+
+  // L_start: t = i + 1; i = t; if i >= E goto L_end
+  const auto &head = func.block(header).quads;
+  if (head.size() != 4 || head[0].op != IROp::LABEL || head[1].op != IROp::ADD
+    || head[2].op != IROp::ASSIGN || head[3].op != IROp::BGE) {
+    return 0;
+  }
+  const auto &inc  = head[1];
+  const auto &test = head[3];
+  auto iter = head[2].dst;
+  auto end  = constant(code, test.arg2);
+  if (inc.arg1 != iter || constant(code, inc.arg2) != 1 || head[2].arg1 != inc.dst
+    || test.arg1 != iter || !end.has_value() || loop.contains(func.labelBlock(test.label))) {
+    return 0;
+  }
+
+  // 剖析数据中从未执行过的循环不展开，只会增加代码
+  if (code.counts.has_value() && code.counts->at(head[0], 1) == 0) {
+    return 0;
+  }
+
+  const auto &tail = func.block(latch).quads;
+  if (tail.empty() || tail.back().op != IROp::GOTO || func.labelBlock(tail.back().label) != header) {
+    return 0;
+  }
+
+  // 循环体不能修改 i，也不能使用 t
+  std::size_t size = 0;
+  for (auto block = header + 1; block <= latch; ++block) {
+    for (const auto &quad : func.block(block).quads) {
+      bool uses = false;
+      ir::forEachUse(code, quad, [&](ValueId value) { uses = uses || value == inc.dst; });
+      if (uses || quad.dst == iter || quad.dst == inc.dst) {
+        return 0;
+      }
+    }
+    size += func.block(block).quads.size();
+  }
+
+  // 初值：前置块中最后一次给 i 的赋值 i = S - 1
+  auto preheader = forest.preheader(func, id);
+  if (preheader == NONE) {
+    return 0;
+  }
+  std::optional<std::int64_t> start;
+  for (const auto &quad : func.block(preheader).quads) {
+    if (quad.dst != iter) {
+      continue;
+    }
+    auto lhs = constant(code, quad.arg1);
+    auto rhs = constant(code, quad.arg2);
+    start.reset();
+    if (quad.op == IROp::SUB && lhs.has_value() && rhs.has_value()) {
+      start = std::int64_t{lhs.value()} - rhs.value() + 1;
+    } else if (quad.op == IROp::ASSIGN && lhs.has_value()) {
+      start = std::int64_t{lhs.value()} + 1;
+    }
+  }
+  if (!start.has_value()) {
+    return 0;
+  }
+
+  auto trips = end.value() - start.value();
+  for (auto f = factor; f >= 2; --f) {
+    if (trips >= f && trips % f == 0 && size * (f - 1) <= MAX_GROWTH) {
+      return f;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief 展开一个循环：循环体之后依次放置 factor - 1 个副本，副本之间是 i 的递增
+ */
+void
+unroll(ir::Function &func, const Candidate &loop)
+{
+  auto &code = func.funcCode();
+  const auto &head = func.block(loop.header).quads;
+  const std::vector<IRQuad> step{head[1], head[2]}; // t = i + 1; i = t
+
+  std::vector<LabelId> labels; // 循环体中的标号，副本中需要换名
+  for (auto block = loop.header + 1; block <= loop.latch; ++block) {
+    if (auto label = func.block(block).label(); label != NONE) {
+      labels.push_back(label);
+    }
+  }
+
+  // 有剖析数据时，循环体及其每个副本各执行原来次数的 1 / factor
+  if (code.counts.has_value()) {
+    for (auto label : labels) {
+      if (auto it = code.counts->labels.find(label); it != code.counts->labels.end()) {
+        it->second /= loop.factor;
+      }
+    }
+  }
+
+  std::vector<ir::BasicBlock> added;
+  for (unsigned k = 2; k <= loop.factor; ++k) {
+    std::unordered_map<LabelId, LabelId> rename;
+    for (auto label : labels) {
+      auto copy = code.addLabel(std::format("{}_u{}", code.label(label), k));
+      rename.emplace(label, copy);
+      if (code.counts.has_value() && code.counts->labels.contains(label)) {
+        code.counts->labels.insert_or_assign(copy, code.counts->labels.at(label));
+      }
+    }
+
+    for (auto block = loop.header + 1; block <= loop.latch; ++block) {
+      auto &copy = added.emplace_back();
+      copy.quads = func.block(block).quads;
+      for (auto &quad : copy.quads) {
+        bool jump = quad.op == IROp::LABEL || quad.op == IROp::GOTO || ir::isBranch(quad.op);
+        if (auto it = rename.find(quad.label); jump && it != rename.end()) {
+          quad.label = it->second;
+        }
+        quad.elems = code.copyElems(quad.elems);
+      }
+    }
+
+    // 除最后一个副本外，回到循环头的 goto 换成递增，顺序执行到下一个副本
+    if (k != loop.factor) {
+      auto &quads = added.back().quads;
+      quads.pop_back();
+      quads.insert(quads.end(), step.begin(), step.end());
+    }
+  }
+
+  auto &quads = func.block(loop.latch).quads;
+  quads.pop_back();
+  quads.insert(quads.end(), step.begin(), step.end());
+  func.insertBlocks(loop.latch + 1, std::move(added));
+}
+
+} // namespace
+
+/**
+ * @brief 部分展开常量次数的 for 循环（在构造 SSA 之前执行）
+ * @param factor 最大的展开倍数
+ */
+Preserved
+unrollLoops(ir::Function &func, AnalysisManager &am, unsigned factor)
+{
+  if (factor < 2) {
+    return Preserved::ALL;
+  }
+
+  const auto &forest = am.loops();
+  std::vector<Candidate> found;
+  for (LoopId id = 0; id < forest.size(); ++id) {
+    if (auto f = unrollFactor(func, forest, id, factor); f != 0) {
+      const auto &loop = forest.loop(id);
+      found.push_back({.header = loop.header, .latch = loop.latches.front(), .factor = f});
+    }
+  }
+  if (found.empty()) {
+    return Preserved::ALL;
+  }
+
+  // 从布局靠后的循环开始，插入的块不影响前面的块的下标
+  std::ranges::sort(found, std::greater{}, &Candidate::header);
+  for (const auto &loop : found) {
+    unroll(func, loop);
+  }
+  return Preserved::NONE;
+}
+
+} // namespace opt
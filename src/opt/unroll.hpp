@@ -0,0 +1,37 @@
+/**
+ * @file unroll.hpp
+ * @brief Partial unrolling of range for loops with a constant trip count.
+ *
+ * Runs on the IR as built, before SSA construction, and only recognises the
+ * shape IRBuilder gives `for i in S..E` with constant S and E:
+ *
+ *       i = S - 1
+ *     L_start:
+ *       t = i + 1
+ *       i = t
+ *       if i >= E goto L_end
+ *       body
+ *       goto L_start
+ *
+ * An innermost such loop whose only back edge is the final goto is unrolled
+ * by the largest factor up to the requested one that divides the trip count
+ * E - S: the body is repeated, each copy followed by the increment, and
+ * only the first copy keeps the exit test. Labels inside the copies are
+ * renamed; break and return keep their targets. The copies are left to the
+ * SSA passes, which fold the increments and strength reduce each copy.
+ *
+ * With a profile (--profile-use), loops whose header never ran are not
+ * unrolled, and the blocks of the body and of every copy are given 1/factor
+ * of the body's counts.
+ *
+ * Namespace: opt
+ */
+#pragma once
+
+#include "pass_manager.hpp"
+
+namespace opt {
+
+auto unrollLoops(ir::Function &func, AnalysisManager &am, unsigned factor) -> Preserved;
+
+} // namespace opt
@@ -0,0 +1,95 @@
+#include <memory>
+#include <vector>
+
+#include "panic.hpp"
+#include "parallel.hpp"
+#include "parallel_lowering.hpp"
+
+namespace par {
+
+/**
+ * @brief   两阶段地检查并生成整个程序的 IR（parser 需处于延迟模式）
+ * @details 第一阶段按源文件顺序声明所有函数；第二阶段每个函数一个任务，
+ *          任务只读访问全局符号表，在各自的分支符号表中检查函数体。
+ *          检查第 i 个函数时只能看到前 i + 1 个函数，与单遍模式一致
+ * @param   prog     已完整解析的程序
+ * @param   builder  parser 使用的 builder
+ * @param   symtab   全局符号表
+ * @param   reporter 全局错误报告器，其中已有全部语法错误
+ * @param   source   源文件，用于创建各任务的错误报告器
+ * @param   jobs     线程数
+ * @param   skipped  非空时，(*skipped)[i] 为 true 的函数不再检查函数体（已有缓存的输出，或不可达）；
+ *                   返回时出错的函数及其之后的函数对应的标记被清除
+ */
+void
+lowerParallel(ast::Prog &prog, SemanticIRBuilder &builder,
+  sym::SymbolTable &symtab, err::ErrReporter &reporter,
+  const util::SourceBuffer &source, unsigned jobs, std::vector<bool> *skipped)
+{
+  const auto &marks = builder.getParseErrMarks();
+  auto n = prog.decls.size();
+  ASSERT_MSG(marks.size() == n, "parse error marks do not match the functions");
+  ASSERT_MSG(skipped == nullptr || skipped->size() == n, "skip marks do not match the functions");
+
+  std::vector<ast::FuncDeclPtr> fdecls;
+  fdecls.reserve(n);
+  for (const auto &decl : prog.decls) {
+    fdecls.push_back(static_cast<ast::FuncDeclPtr>(decl));
+  }
+
+  // 第一阶段：声明函数与形参，函数头的 IR 在第二阶段各任务中生成
+  builder.setIREnabled(false);
+  for (const auto &fdecl : fdecls) {
+    auto errcnt = reporter.errCount();
+    builder.lowerHeader(*fdecl->header);
+    builder.ctx->exitScope();
+    ASSERT_MSG(reporter.errCount() == errcnt, "function header reported errors");
+  }
+  builder.setIREnabled(true);
+
+  // 第二阶段：并行检查函数体
+  std::vector<std::unique_ptr<sym::SymbolTable>> forks(n);
+  std::vector<std::unique_ptr<err::ErrReporter>> reporters(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    forks[i]     = std::make_unique<sym::SymbolTable>(symtab, i + 1);
+    reporters[i] = std::make_unique<err::ErrReporter>(source);
+  }
+
+  auto types = builder.ctx->getTypeFactory();
+  util::parallelFor(n, jobs, [&](std::size_t i) {
+    auto &fdecl = *fdecls[i];
+    if (skipped != nullptr && (*skipped)[i]) {
+      return; // 缓存命中（输出直接取自缓存），或不可达（之后被删去）
+    }
+
+    SemanticIRBuilder local{*forks[i], *reporters[i], types};
+    // 单遍模式下，出现错误之后不再生成 IR
+    local.setIREnabled(marks[i] == 0);
+    local.resume(fdecl, symtab.lookupFunc(fdecl.header->name).value());
+    local.lowerBody(fdecl);
+  });
+
+  bool failed = false;
+  for (std::size_t i = 0; i < n; ++i) {
+    symtab.merge(std::move(*forks[i]));
+
+    failed = failed || marks[i] > 0 || reporters[i]->hasErrs();
+    if (failed) {
+      fdecls[i]->code = nullptr;
+      if (skipped != nullptr) {
+        (*skipped)[i] = false;
+      }
+    }
+  }
+
+  // 从后向前插入，前面的插入位置不受影响
+  for (std::size_t i = n; i-- > 0;) {
+    reporter.insertErrs(marks[i], std::move(*reporters[i]));
+  }
+  reporter.checkLimit();
+
+  builder.setDeferred(false);
+  builder.lower(prog);
+}
+
+} // namespace par
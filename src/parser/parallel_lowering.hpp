@@ -0,0 +1,37 @@
+/**
+ * @file parallel_lowering.hpp
+ * @brief Two-phase semantic checking and IR lowering of a fully parsed program.
+ *
+ * Phase 1 declares every function (header and arguments) in the global symbol
+ * table, sequentially and in source order. Phase 2 checks and lowers the
+ * function bodies in parallel: each task owns a forked symbol table, its own
+ * error reporter and a SemanticIRBuilder sharing the global type factory. The
+ * forks are merged back in function order, and the diagnostics of each task are
+ * inserted after the parse errors of the same function, so the output is the
+ * same as in single-pass mode.
+ *
+ * Functions whose output is already in the incremental compilation cache, and
+ * functions unreachable from the roots of the program (-fprune-funcs, see
+ * call_graph.hpp), are only declared; their bodies are neither checked nor
+ * lowered.
+ *
+ * Namespace: par
+ */
+#pragma once
+
+#include <vector>
+
+#include "ast.hpp"
+#include "err_report.hpp"
+#include "symbol_table.hpp"
+#include "source_buffer.hpp"
+#include "semantic_ir_builder.hpp"
+
+namespace par {
+
+void lowerParallel(ast::Prog &prog, SemanticIRBuilder &builder,
+  sym::SymbolTable &symtab, err::ErrReporter &reporter,
+  const util::SourceBuffer &source, unsigned jobs,
+  std::vector<bool> *skipped = nullptr);
+
+} // namespace par
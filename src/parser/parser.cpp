@@ -18,20 +18,25 @@
  *   - Composite types (arrays, tuples)
  *   - Array and tuple element access
  *
- * The parser uses recursive descent parsing techniques
- * and provides error reporting for unexpected tokens and syntactic errors.
+ * The parser uses recursive descent parsing techniques, with precedence
+ * climbing for binary operators, and provides error reporting for
+ * unexpected tokens, syntactic errors and too deeply nested expressions.
  *
  * Key classes and concepts:
  *   - Token: Represents a lexical token from the lexer.
  *   - TokenType: Enum for different types of tokens.
  *   - ast::*: Namespace containing AST node types.
- *   - builder: Responsible for building and annotating AST nodes.
+ *   - builder: Checks and lowers each function once it has been parsed.
  *   - reporter: Used for error reporting during parsing.
  *   - util::Position: Represents source code positions for error messages.
  *
  * The parser maintains lookahead tokens and supports context-sensitive parsing
  * for constructs such as function arguments, block expressions, and control flow.
  */
+#include <vector>
+#include <charconv>
+#include <algorithm>
+
 #include "panic.hpp"
 #include "parser.hpp"
 
@@ -40,18 +45,38 @@ using namespace lex;
 namespace par {
 
 /**
- * @brief  获取下一个 token
- * @return next token
+ * @brief  将 INT token 转换为整数，不产生临时字符串
+ * @param  value token value
+ * @return 转换得到的整数
  */
-Token
-Parser::nextToken()
+static int
+tokenValue2Int(std::string_view value)
 {
-  // 检查了是否有值，所以可以直接返回一个 Token，
-  // 而不是 std::optional<Token>
-  if (auto token = lexer.nextToken(); token.has_value()) {
-    return token.value();
+  int result{};
+  std::from_chars(value.data(), value.data() + value.length(), result);
+  return result;
+}
+
+/**
+ * @brief  定位当前 token 之后的第 k 个 token
+ * @param  k 向前看的距离（0 表示当前 token）
+ * @return 该 token 在 token stream 中的下标，越过 END 时停在 END
+ */
+std::size_t
+Parser::locate(std::size_t k)
+{
+  std::size_t i = std::min(idx + k, tokens.size() - 1);
+  if (tokens.type(i) != TokenType::UNKNOWN) {
+    return i;
   }
+
   // 如果识别到未知 token，则发生了词法分析错误，且需要立即终止
+  std::string view{tokens.value(i)};
+  reporter.report(
+    err::LexErrType::UNKNOWN_TOKEN,
+    std::format("识别到未知的 token: {}", view),
+    tokens.pos(i), view
+  );
   err::terminate(reporter);
 }
 
@@ -61,15 +86,8 @@ Parser::nextToken()
 void
 Parser::advance()
 {
-  // look ahead 是通过调用 next token
-  // 获取下一个 token 实现的，因此需要检查 la 是否有值
-  // 若有值直接调用 nextToken() 获取到的是下一个的下一个
-  if (la.has_value()) {
-    cur = la.value();
-    la.reset(); // 清除 la 中的值
-  } else {
-    cur = nextToken();
-  }
+  idx = locate(1);
+  cur = tokens.at(idx);
 }
 
 /**
@@ -99,18 +117,15 @@ Parser::check(TokenType type) const
 }
 
 /**
- * @brief  向前检查一个 token 是否为指定类型
+ * @brief  向前检查第 k 个 token 是否为指定类型
  * @param  type TokenType（指定的 token 类型）
+ * @param  k    向前看的距离
  * @return 是否是指定类型
  */
 bool
-Parser::checkAhead(TokenType type)
+Parser::checkAhead(TokenType type, std::size_t k)
 {
-  // 向前看一个 token，如果 la 已经有值则无需获取！
-  if (!la.has_value()) {
-    la = nextToken();
-  }
-  return la.has_value() && la.value().type == type;
+  return tokens.type(locate(k)) == type;
 }
 
 /**
@@ -126,11 +141,25 @@ Parser::consume(TokenType type, const std::string &msg)
       err::ParErrType::UNEXPECT_TOKEN,
       msg,
       cur.pos,
-      cur.value
+      std::string{cur.value}
     );
   }
 }
 
+/**
+ * @brief 表达式嵌套超过上限：报告错误并终止
+ */
+void
+Parser::nestingTooDeep()
+{
+  reporter.report(
+    err::ParErrType::NESTING_TOO_DEEP,
+    std::format("表达式嵌套超过 {} 层（可以用 -fmax-nesting=N 调整）", max_nesting),
+    cur.pos, std::string{cur.value}
+  );
+  err::terminate(reporter);
+}
+
 /**
  * @brief  解析输入程序
  * @return 解析到的 ast::Prog 结点指针
@@ -146,9 +175,8 @@ Parser::parseProgram()
     decls.push_back(parseFuncDecl());
   }
 
-  // 检查 Prog 的语义、拼接各函数的中间代码
-  auto prog = std::make_shared<ast::Prog>(decls);
-  builder.build(*prog);
+  auto prog = arena.make<ast::Prog>(decls);
+  builder.lower(*prog);
   return prog;
 }
 
@@ -156,10 +184,12 @@ Parser::parseProgram()
  * @brief  解析标识符
  * @return 解析到的标识符名和声明位置
  */
-std::pair<std::string, util::Position>
+std::pair<util::Name, util::Position>
 Parser::parseID()
 {
-  std::string id = cur.value;
+  // 当前 token 不是 ID 时只保留其文本，便于后续报错
+  util::Name id = check(TokenType::ID)
+    ? cur.name : util::Name{util::INVALID_SYMBOL, cur.value};
   util::Position declpos = cur.pos;
   consume(TokenType::ID, "Expect '<ID>'");
   return {id, declpos};
@@ -169,7 +199,7 @@ Parser::parseID()
  * @brief  解析变量声明内部
  * @return 解析到的 mutable & variable name
  */
-std::tuple<bool, std::string, util::Position>
+std::tuple<bool, util::Name, util::Position>
 Parser::parseInnerVarDecl()
 {
   // InnerVarDecl -> (mut)? <ID>
@@ -197,14 +227,19 @@ Parser::parseFuncDecl()
   // FuncDecl -> FuncHeaderDecl BlockStmt
 
   util::Position declpos = cur.pos;
+  std::size_t tok_begin = idx;
   auto header = parseFuncHeaderDecl();
+  std::size_t tok_body = idx;
   auto body   = parseStmtBlockExpr();
 
-  auto funcdecl = std::make_shared<ast::FuncDecl>(header, body);
+  auto funcdecl = arena.make<ast::FuncDecl>(header, body);
   funcdecl->pos = declpos;
+  funcdecl->tok_begin = tok_begin;
+  funcdecl->tok_body  = tok_body;
+  funcdecl->tok_end   = idx;
 
-  builder.build(*funcdecl);
-  builder.ctx->exitScope();
+  // 函数解析完成后交给 builder 做语义检查与 IR 生成
+  builder.lower(*funcdecl);
   return funcdecl;
 }
 
@@ -221,8 +256,6 @@ Parser::parseFuncHeaderDecl()
 
   auto [funcname, declpos] = parseID();
 
-  builder.ctx->enterFunc(funcname, declpos); // 必须先进入作用域！！！
-
   consume(TokenType::LPAREN, "Expect '('");
 
   // (arg)? (, arg)*
@@ -257,9 +290,8 @@ Parser::parseFuncHeaderDecl()
   }
 
   auto funcheaderdecl =
-    std::make_shared<ast::FuncHeaderDecl>(funcname, argv, rettype);
+    arena.make<ast::FuncHeaderDecl>(funcname, argv, rettype);
   funcheaderdecl->pos = declpos;
-  builder.build(*funcheaderdecl);
   return funcheaderdecl;
 }
 
@@ -277,9 +309,8 @@ Parser::parseArg()
 
   auto vartype = parseType();
 
-  auto arg = std::make_shared<ast::Arg>(varmutable, id, vartype);
+  auto arg = arena.make<ast::Arg>(varmutable, id, vartype);
   arg->pos = declpos;
-  builder.build(*arg);
   return arg;
 }
 
@@ -313,7 +344,7 @@ Parser::parseType()
 
     int elemcnt = 0;
     if (check(TokenType::INT)) {
-      elemcnt = std::stoi(cur.value);
+      elemcnt = tokenValue2Int(cur.value);
     }
     consume(TokenType::INT, "Expect <NUM>");
     consume(TokenType::RBRACK, "Expect ']'");
@@ -389,9 +420,8 @@ Parser::parseStmtBlockExpr()
 
   consume(TokenType::RBRACE, "Expect '}'");
 
-  auto stmt_block = std::make_shared<ast::StmtBlockExpr>(stmts);
+  auto stmt_block = arena.make<ast::StmtBlockExpr>(stmts);
   stmt_block->pos = declpos;
-  builder.build(*stmt_block);
   return stmt_block;
 }
 
@@ -410,9 +440,8 @@ Parser::parseStmt()
   if (check(TokenType::SEMICOLON)) {
     // EmptyStmt -> ;
     advance();
-    auto emptystmt = std::make_shared<ast::EmptyStmt>();
+    auto emptystmt = arena.make<ast::EmptyStmt>();
     emptystmt->pos = declpos;
-    builder.build(*emptystmt);
     return emptystmt;
   }
 
@@ -455,11 +484,10 @@ Parser::parseVarDeclStmt()
 
   consume(TokenType::SEMICOLON, "Expect ';'");
 
-  auto vardeclstmt = std::make_shared<ast::VarDeclStmt>(
+  auto vardeclstmt = arena.make<ast::VarDeclStmt>(
     varmutable, id, vartype, initval
   );
   vardeclstmt->pos = declpos;
-  builder.build(*vardeclstmt);
   return vardeclstmt;
 }
 
@@ -476,7 +504,7 @@ Parser::parseExprStmt()
   // 若有则匹配，若没有则不匹配
   util::Position declpos = cur.pos;
   auto expr = parseExpr();
-  auto expr_stmt = std::make_shared<ast::ExprStmt>(expr);
+  auto expr_stmt = arena.make<ast::ExprStmt>(expr);
 
   // 一个表达式只有在两种情况下被用作表达式且需要设置
   // 1. 后面有一个 semicolon
@@ -501,7 +529,6 @@ Parser::parseExprStmt()
   }
 
   expr_stmt->pos = declpos;
-  builder.build(*expr_stmt);
   return expr_stmt;
 }
 
@@ -523,6 +550,22 @@ Parser::parseExpr()
   //       | AssignExpr
   //       | CmpExpr
 
+  // 每一层 parseExpr 是表达式树中的一层；deepest 从本层重新计算，返回时并入外层
+  if (max_nesting != 0 && depth >= max_nesting) {
+    nestingTooDeep();
+  }
+  struct Nesting {
+    std::size_t &depth;
+    std::size_t &deepest;
+    std::size_t  outer;
+
+    ~Nesting() {
+      --depth;
+      deepest = std::max(outer, deepest);
+    }
+  } nesting{depth, deepest, deepest};
+  deepest = ++depth;
+
   switch (cur.type) {
     case TokenType::RETURN:   return parseRetExpr();
     case TokenType::BREAK:    return parseBreakExpr();
@@ -533,9 +576,7 @@ Parser::parseExpr()
     case TokenType::LOOP:     return parseLoopExpr();
     case TokenType::LBRACE: {
       // StmtBlocKExpr -> { (Stmt)* }
-      builder.ctx->enterBlockExpr();
       auto expr = parseStmtBlockExpr();
-      builder.ctx->exitScope();
       return expr;
     }
     case TokenType::ID: {
@@ -562,20 +603,19 @@ Parser::parseExpr()
         // AssignExpr -> AssignElem = Expr
         if (assign_elem == nullptr) {
           // 如果没有包装为一个赋值元素，则先包装
-          assign_elem = std::make_shared<ast::AssignElem>(expr);
+          assign_elem = arena.make<ast::AssignElem>(expr);
           assign_elem->kind = ast::AssignElem::Kind::VARIABLE;
           assign_elem->pos = declpos;
-          builder.build(*assign_elem);
         }
         return parseAssignExpr(std::move(assign_elem));
       }
 
-      return parseCmpExpr(assign_elem == nullptr ? expr : assign_elem);
+      return parseBinaryExpr(assign_elem == nullptr ? expr : assign_elem);
     }
     case TokenType::INT:
     case TokenType::LPAREN:
     case TokenType::LBRACK:
-      return parseCmpExpr();
+      return parseBinaryExpr();
     default:
       // TODO: unexpected token!
       UNREACHABLE("parseExpr()");
@@ -599,9 +639,8 @@ Parser::parseRetExpr()
     retval = parseExpr();
   }
 
-  auto retexpr = std::make_shared<ast::RetExpr>(retval);
+  auto retexpr = arena.make<ast::RetExpr>(retval);
   retexpr->pos = declpos;
-  builder.build(*retexpr);
   return retexpr;
 }
 
@@ -622,9 +661,8 @@ Parser::parseBreakExpr()
     retval = parseExpr();
   }
 
-  auto breakexpr = std::make_shared<ast::BreakExpr>(retval);
+  auto breakexpr = arena.make<ast::BreakExpr>(retval);
   breakexpr->pos = declpos;
-  builder.build(*breakexpr);
   return breakexpr;
 }
 
@@ -640,9 +678,8 @@ Parser::parseContinueExpr()
   util::Position declpos = cur.pos;
   consume(TokenType::CONTINUE, "Expect 'continue'");
 
-  auto contexpr = std::make_shared<ast::ContinueExpr>();
+  auto contexpr = arena.make<ast::ContinueExpr>();
   contexpr->pos = declpos;
-  builder.build(*contexpr);
   return contexpr;
 }
 
@@ -660,9 +697,8 @@ Parser::parseAssignExpr(ast::AssignElemPtr &&lval)
 
   auto rval = parseExpr();
 
-  auto assign_expr = std::make_shared<ast::AssignExpr>(lval, rval);
+  auto assign_expr = arena.make<ast::AssignExpr>(lval, rval);
   assign_expr->pos = declpos;
-  builder.build(*assign_expr);
   return assign_expr;
 }
 
@@ -732,10 +768,9 @@ Parser::parseArrAcc(ast::ExprPtr val)
   auto idx = parseExpr();
   consume(TokenType::RBRACK, "Expect ']'");
 
-  auto arr_acc = std::make_shared<ast::ArrAcc>(val, idx);
+  auto arr_acc = arena.make<ast::ArrAcc>(val, idx);
   arr_acc->kind = ast::AssignElem::Kind::ARRACC;
   arr_acc->pos = declpos;
-  builder.build(*arr_acc);
   return arr_acc;
 }
 
@@ -755,18 +790,16 @@ Parser::parseTupAcc(ast::ExprPtr val)
   ast::NumberPtr idx = nullptr;
   util::Position idxpos = cur.pos;
   if (check(TokenType::INT)) {
-    idx = std::make_shared<ast::Number>(std::stoi(cur.value));
+    idx = arena.make<ast::Number>(tokenValue2Int(cur.value));
     idx->pos = idxpos;
-    builder.build(*idx);
   } else {
     // TODO: Error!
   }
   consume(TokenType::INT, "Expect <NUM>");
 
-  auto tacc = std::make_shared<ast::TupAcc>(val, idx);
+  auto tacc = arena.make<ast::TupAcc>(val, idx);
   tacc->kind = ast::AssignElem::Kind::TUPACC;
   tacc->pos = pos;
-  builder.build(*tacc);
   return tacc;
 }
 
@@ -788,9 +821,8 @@ Parser::parseValue()
     advance();
     auto expr = parseExpr();
     consume(TokenType::RPAREN, "Expect ')'");
-    auto bexpr = std::make_shared<ast::BracketExpr>(expr);
+    auto bexpr = arena.make<ast::BracketExpr>(expr);
     bexpr->pos = pos;
-    builder.build(*bexpr);
     return bexpr;
   }
 
@@ -800,11 +832,11 @@ Parser::parseValue()
   }
 
   // Variable -> <ID>
-  std::string name = cur.value;
+  util::Name name = check(TokenType::ID)
+    ? cur.name : util::Name{util::INVALID_SYMBOL, cur.value};
   consume(TokenType::ID, "Expect '<ID>");
-  auto var = std::make_shared<ast::Variable>(name);
+  auto var = arena.make<ast::Variable>(name);
   var->pos = pos;
-  builder.build(*var);
   return var;
 }
 
@@ -850,94 +882,106 @@ tokenType2AriOper(TokenType type)
   UNREACHABLE("unreachable point");
 }
 
-/**
- * @brief  解析 compare 表达式
- * @return 解析到的 ast::Expr 结点指针
- */
-ast::ExprPtr
-Parser::parseCmpExpr(std::optional<ast::ExprPtr> expr)
-{
-  // CmpExpr -> (CmpExpr CmpOper)* AddExpr
-
-  ast::ExprPtr lhs = parseAddExpr(std::move(expr));
-  while (check(TokenType::LT) || check(TokenType::LEQ)
-      || check(TokenType::GT) || check(TokenType::GEQ)
-      || check(TokenType::EQ) || check(TokenType::NEQ)
-  ) {
-    util::Position pos = cur.pos;
-
-    TokenType op = cur.type;
-    advance();
-
-    ast::ExprPtr rhs = parseAddExpr();
-
-    auto cexpr = std::make_shared<ast::CmpExpr>(
-      lhs, tokenType2CmpOper(op), rhs // 注意结点挂载位置！！！
-    );
-    cexpr->pos = pos;
-    builder.build(*cexpr);
-    lhs = cexpr;
-  }
-
-  return lhs;
-}
+static constexpr int CMP_PREC = 1; // 比较运算符的优先级（最低）
 
 /**
- * @brief  解析 add & sub expression
- * @return 解析到的 ast::Expr 结点指针
+ * @brief  二元运算符的优先级，不是二元运算符时为 0；同一优先级左结合
+ * @param  type 待检查的 token type
+ * @return 优先级，越大结合得越紧
  */
-ast::ExprPtr
-Parser::parseAddExpr(std::optional<ast::ExprPtr> expr)
+static int
+binaryPrec(TokenType type)
 {
-  // AddExpr -> (AddExpr [+ | -])* MulExpr
-
-  ast::ExprPtr lhs = Parser::parseMulExpr(std::move(expr));
-  while (check(TokenType::PLUS) || check(TokenType::MINUS)) {
-    util::Position pos = cur.pos;
-
-    TokenType op = cur.type;
-    advance();
-
-    ast::ExprPtr rhs = parseMulExpr();
-
-    auto aexpr = std::make_shared<ast::AriExpr>(
-      lhs, tokenType2AriOper(op), rhs // 注意结点挂载位置！！！
-    );
-    aexpr->pos = pos;
-    builder.build(*aexpr);
-    lhs = aexpr;
+  // 使用 switch 加速分发过程
+  switch (type) {
+    case TokenType::EQ:  case TokenType::NEQ:
+    case TokenType::GEQ: case TokenType::LEQ:
+    case TokenType::GT:  case TokenType::LT:
+      return CMP_PREC;
+    case TokenType::PLUS: case TokenType::MINUS:
+      return 2;
+    case TokenType::MUL: case TokenType::DIV:
+      return 3;
+    default:
+      return 0;
   }
-
-  return lhs;
 }
 
 /**
- * @brief  解析 mul & div expression
+ * @brief  解析二元运算表达式（比较、加减与乘除）
+ * @param  expr 已经解析的第一个操作数（parseExpr 中以 <ID> 开头的情况）
  * @return 解析到的 ast::Expr 结点指针
  */
 ast::ExprPtr
-Parser::parseMulExpr(std::optional<ast::ExprPtr> expr)
+Parser::parseBinaryExpr(std::optional<ast::ExprPtr> expr)
 {
+  // CmpExpr -> (CmpExpr CmpOper)* AddExpr
+  // AddExpr -> (AddExpr [+ | -])* MulExpr
   // MulExpr -> (MulExpr [* | /])* Factor
 
-  ast::ExprPtr lhs = parseFactor(std::move(expr));
-  while (check(TokenType::MUL) || check(TokenType::DIV)) {
-    util::Position pos = cur.pos;
+  // 优先级爬升：操作数与运算符分别放在显式的栈中，读到的运算符优先级不高于栈顶时
+  // 先归约栈顶（左结合），各个优先级不再各占一层递归；
+  // height 是操作数子树的高度（因子内部的嵌套也计入），用于检查嵌套深度
+  struct Operand {
+    ast::ExprPtr expr;
+    std::size_t  height;
+  };
+  struct Operator {
+    TokenType      type;
+    int            prec;
+    util::Position pos;
+  };
+  std::vector<Operand>  operands;
+  std::vector<Operator> operators;
+
+  auto factor = [&] {
+    auto outer = deepest;
+    deepest = depth;
+    Operand operand{parseFactor(), 0};
+    operand.height = deepest - depth + 1;
+    deepest = std::max(outer, deepest);
+    return operand;
+  };
+
+  auto reduce = [&] {
+    auto op  = operators.back();
+    auto rhs = operands.back();
+    operators.pop_back();
+    operands.pop_back();
+    auto &lhs = operands.back();
+
+    ast::ExprPtr node = nullptr;
+    if (op.prec == CMP_PREC) {
+      node = arena.make<ast::CmpExpr>(lhs.expr, tokenType2CmpOper(op.type), rhs.expr);
+    } else {
+      node = arena.make<ast::AriExpr>(lhs.expr, tokenType2AriOper(op.type), rhs.expr);
+    }
+    node->pos = op.pos;
+    lhs = {node, std::max(lhs.height, rhs.height) + 1};
 
-    TokenType op = cur.type;
+    // 表达式的根在第 depth 层
+    auto level = depth + lhs.height - 1;
+    if (max_nesting != 0 && level > max_nesting) {
+      nestingTooDeep();
+    }
+    deepest = std::max(deepest, level);
+  };
+
+  // parseExpr 进入时重置了 deepest，此后只解析了第一个操作数
+  operands.push_back(expr.has_value() ? Operand{expr.value(), deepest - depth + 1} : factor());
+  for (int prec = binaryPrec(cur.type); prec != 0; prec = binaryPrec(cur.type)) {
+    while (!operators.empty() && operators.back().prec >= prec) {
+      reduce();
+    }
+    operators.push_back({cur.type, prec, cur.pos});
     advance();
+    operands.push_back(factor());
+  }
+  while (!operators.empty()) {
+    reduce();
+  }
 
-    ast::ExprPtr rhs = parseFactor();
-
-    auto aexpr = std::make_shared<ast::AriExpr>(
-      lhs, tokenType2AriOper(op), rhs // 注意结点挂载位置！！！
-    );
-    aexpr->pos = pos;
-    builder.build(*aexpr);
-    lhs = aexpr;
-  } // end while
-
-  return lhs;
+  return operands.back().expr;
 }
 
 /**
@@ -1013,9 +1057,8 @@ Parser::parseArrElems()
   } // end while
   advance();
 
-  auto aelems = std::make_shared<ast::ArrElems>(elems);
+  auto aelems = arena.make<ast::ArrElems>(elems);
   aelems->pos = pos;
-  builder.build(*aelems);
 
   return aelems;
 }
@@ -1061,9 +1104,8 @@ Parser::parseTupElems()
   auto cnt = elems.size();
 
   if (0 == cnt) {
-    auto bexpr = std::make_shared<ast::BracketExpr>(std::nullopt);
+    auto bexpr = arena.make<ast::BracketExpr>(std::nullopt);
     bexpr->pos = pos;
-    builder.build(*bexpr);
 
     if (check(TokenType::LBRACK) || check(TokenType::DOT)) {
       return parseAssignElem(bexpr);
@@ -1073,9 +1115,8 @@ Parser::parseTupElems()
 
   if (!is_tuple_elem) {
     // 单个表达式没有逗号不是元组，而是普通括号表达式
-    auto bexpr = std::make_shared<ast::BracketExpr>(elems[0]);
+    auto bexpr = arena.make<ast::BracketExpr>(elems[0]);
     bexpr->pos = pos;
-    builder.build(*bexpr);
 
     if (check(TokenType::LBRACK) || check(TokenType::DOT)) {
       return parseAssignElem(bexpr);
@@ -1084,9 +1125,8 @@ Parser::parseTupElems()
     return bexpr;
   } // end if
 
-  auto telems = std::make_shared<ast::TupElems>(elems);
+  auto telems = arena.make<ast::TupElems>(elems);
   telems->pos = pos;
-  builder.build(*telems);
   return telems;
 }
 
@@ -1107,12 +1147,11 @@ Parser::parseElement(std::optional<ast::ExprPtr> expr)
 
   // Number -> <NUM>
   util::Position pos = cur.pos;
-  std::string value = cur.value;
+  std::string_view value = cur.value;
   if (check(TokenType::INT)) {
     advance();
-    auto num = std::make_shared<ast::Number>(std::stoi(value));
+    auto num = arena.make<ast::Number>(tokenValue2Int(value));
     num->pos = pos;
-    builder.build(*num);
     return num;
   }
 
@@ -1160,9 +1199,8 @@ Parser::parseCallExpr()
   }
   consume(TokenType::RPAREN, "Expect ')'");
 
-  auto cexpr = std::make_shared<ast::CallExpr>(name, argv);
+  auto cexpr = arena.make<ast::CallExpr>(name, argv);
   cexpr->pos = pos;
-  builder.build(*cexpr);
   return cexpr;
 }
 
@@ -1176,26 +1214,17 @@ Parser::parseIfExpr()
 
   ast::ExprPtr cond = parseExpr();
 
-  builder.ctx->enterIf();
-
   ast::StmtBlockExprPtr body;
-  sym::TempPtr temp_val = nullptr;
   if (!check(TokenType::LBRACE)) {
     // TODO: 缺少一个 body!
     std::println(stderr, "缺少语句块，如果这是语句块，考虑在前面添加一个判断条件");
 
     std::vector<ast::StmtPtr> stmts{};
-    body = std::make_shared<ast::StmtBlockExpr>(stmts);
+    body = arena.make<ast::StmtBlockExpr>(stmts);
+    body->missing = true;
   } else {
     body = parseStmtBlockExpr();
-
-    if (body->type.type != type::TypeFactory::UNIT_TYPE) {
-      temp_val = builder.ctx->produceTemp(pos, body->type.type);
-      builder.ctx->setCurCtxSymbol(temp_val);
-    }
   }
-  builder.ctx->exitSymtabScope();
-
 
   // ElseClause -> else if Expr StmtBlockExpr ElseClause
   //             | else StmtBlockExpr
@@ -1209,15 +1238,9 @@ Parser::parseIfExpr()
     }
   }
 
-  auto iexpr = std::make_shared<ast::IfExpr>(cond, body, elses);
+  auto iexpr = arena.make<ast::IfExpr>(cond, body, elses);
   iexpr->is_ctlflow = true;
-  if (temp_val != nullptr) {
-    iexpr->symbol = temp_val;
-  }
   iexpr->pos = pos;
-  builder.build(*iexpr);
-
-  builder.ctx->exitCtxScope();
 
   return iexpr;
 }
@@ -1237,28 +1260,23 @@ Parser::parseElseClause()
     advance();
     cond = parseExpr();
 
-    builder.ctx->enterElse();
     if (!check(TokenType::LBRACE)) {
       // TODO: 缺少一个 body!
       std::println(stderr, "缺少语句块，如果这是语句块，考虑在前面添加一个判断条件");
 
       std::vector<ast::StmtPtr> stmts{};
-      body = std::make_shared<ast::StmtBlockExpr>(stmts);
+      body = arena.make<ast::StmtBlockExpr>(stmts);
+      body->missing = true;
     } else {
       body = parseStmtBlockExpr();
     }
-    builder.ctx->exitSymtabScope();
   } else {
     // StmtBlockExpr
-    builder.ctx->enterElse();
     body = parseStmtBlockExpr();
-    builder.ctx->exitSymtabScope();
   }
 
-  auto else_clause = std::make_shared<ast::ElseClause>(cond, body);
+  auto else_clause = arena.make<ast::ElseClause>(cond, body);
   else_clause->pos = pos;
-  builder.build(*else_clause);
-  builder.ctx->exitCtxScope();
   return else_clause;
 }
 
@@ -1272,24 +1290,21 @@ Parser::parseWhileLoopExpr()
 
   ast::ExprPtr cond = parseExpr();
 
-  builder.ctx->enterWhile();
-
   ast::StmtBlockExprPtr body;
   if (!check(TokenType::LBRACE)) {
     // TODO: 缺少一个 body!
     std::println(stderr, "缺少语句块，如果这是语句块，考虑在前面添加一个判断条件");
 
     std::vector<ast::StmtPtr> stmts{};
-    body = std::make_shared<ast::StmtBlockExpr>(stmts);
+    body = arena.make<ast::StmtBlockExpr>(stmts);
+    body->missing = true;
   } else {
     body = parseStmtBlockExpr();
   }
 
-  auto while_loop = std::make_shared<ast::WhileLoopExpr>(cond, body);
+  auto while_loop = arena.make<ast::WhileLoopExpr>(cond, body);
   while_loop->is_ctlflow = true;
   while_loop->pos = pos;
-  builder.build(*while_loop);
-  builder.ctx->exitScope();
   return while_loop;
 }
 
@@ -1303,14 +1318,6 @@ Parser::parseForLoopExpr()
 
   auto [mut, name, varpos] = parseInnerVarDecl();
 
-  builder.ctx->enterFor();
-  // 这里简单的将迭代器的类型认为是 i32
-  // 实际类型应该由可迭代对象的元素的类型确定
-  auto var = builder.ctx->declareVar(
-    name, mut, true, type::TypeFactory::INT_TYPE, varpos
-  );
-  builder.ctx->setCurCtxSymbol(var);
-
   consume(TokenType::IN, "Expect 'in'");
 
   ast::ExprPtr iterexpr = parseIterable();
@@ -1320,18 +1327,18 @@ Parser::parseForLoopExpr()
     std::println(stderr, "缺少语句块，如果这是语句块，考虑在前面添加一个可迭代对象");
 
     std::vector<ast::StmtPtr> stmts{};
-    body = std::make_shared<ast::StmtBlockExpr>(stmts);
+    body = arena.make<ast::StmtBlockExpr>(stmts);
+    body->missing = true;
   } else {
     body = parseStmtBlockExpr();
   }
 
   auto for_loop =
-    std::make_shared<ast::ForLoopExpr>(mut, name, iterexpr, body);
+    arena.make<ast::ForLoopExpr>(mut, name, iterexpr, body);
   for_loop->is_ctlflow = true;
   for_loop->pos = declpos;
+  for_loop->pattern_pos = varpos;
 
-  builder.build(*for_loop);
-  builder.ctx->exitScope();
   return for_loop;
 }
 
@@ -1349,15 +1356,13 @@ Parser::parseIterable()
   if (check(TokenType::DOTS)) {
     advance();
     auto expr2 = parseExpr();
-    auto range_expr = std::make_shared<ast::RangeExpr>(expr1, expr2);
+    auto range_expr = arena.make<ast::RangeExpr>(expr1, expr2);
     range_expr->pos = declpos;
-    builder.build(*range_expr);
     return range_expr;
   }
 
-  auto iterval = std::make_shared<ast::IterableVal>(expr1);
+  auto iterval = arena.make<ast::IterableVal>(expr1);
   iterval->pos = declpos;
-  builder.build(*iterval);
   return iterval;
 }
 
@@ -1369,14 +1374,11 @@ Parser::parseLoopExpr()
   util::Position declpos = cur.pos;
   consume(TokenType::LOOP, "Expect 'loop'");
 
-  builder.ctx->enterLoop();
   auto body = parseStmtBlockExpr();
 
-  auto loopexpr = std::make_shared<ast::LoopExpr>(body);
+  auto loopexpr = arena.make<ast::LoopExpr>(body);
   loopexpr->is_ctlflow = true;
   loopexpr->pos = declpos;
-  builder.build(*loopexpr);
-  builder.ctx->exitScope();
   return loopexpr;
 }
 
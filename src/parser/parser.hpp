@@ -8,7 +8,8 @@
  *
  * Dependencies:
  * - ast.hpp: Abstract Syntax Tree node definitions.
- * - lexer.hpp: Tokenizer for source code.
+ * - arena.hpp: Arena in which AST nodes are allocated.
+ * - token_stream.hpp: Token stream produced by the lexer.
  * - position.hpp: Source code position tracking.
  * - err_report.hpp: Error reporting utilities.
  * - semantic_ir_builder.hpp: Semantic IR construction.
@@ -20,22 +21,32 @@
 #include <optional>
 
 #include "ast.hpp"
-#include "lexer.hpp"
+#include "arena.hpp"
+#include "token_stream.hpp"
 #include "position.hpp"
 #include "err_report.hpp"
 #include "semantic_ir_builder.hpp"
 
 namespace par {
 
+inline constexpr std::size_t MAX_NESTING = 1024; // 默认的表达式嵌套深度上限
+
 /// @class Parser
 /// @brief Implements a recursive descent parser for the language.
 ///
-/// The Parser consumes tokens from a Lexer, reports errors via ErrReporter,
-/// and builds semantic IR using SemanticIRBuilder. It supports lookahead and
-/// provides methods for parsing all major syntactic constructs.
+/// The Parser indexes into a TokenStream tokenized up front by the Lexer,
+/// reports errors via ErrReporter, and builds semantic IR using
+/// SemanticIRBuilder. It supports arbitrary lookahead and provides methods
+/// for parsing all major syntactic constructs. Binary operators are parsed
+/// by precedence climbing over explicit operand and operator stacks, so
+/// long operator chains do not recurse. Expressions may nest at most
+/// setMaxNesting() levels (blocks, brackets, calls and operators all count);
+/// deeper input is reported as a ParErr and parsing stops instead of
+/// overflowing the stack here or in the later tree walks.
 ///
 /// Usage:
-///   - Construct with references to a Lexer, SemanticIRBuilder, and ErrReporter.
+///   - Construct with references to a TokenStream, an Arena for AST nodes,
+///     SemanticIRBuilder, and ErrReporter.
 ///   - Call parseProgram() to parse the entire program.
 ///
 /// Member Functions:
@@ -45,32 +56,43 @@ namespace par {
 ///
 /// Member Variables:
 ///   - cur: The current token.
-///   - la: Optional lookahead token.
-///   - lexer: Reference to the token source.
+///   - idx: Index of the current token in the stream.
+///   - tokens: Reference to the token stream.
+///   - arena: Arena that owns every AST node created by the parser.
 ///   - builder: Reference to the semantic IR builder.
 ///   - reporter: Reference to the error reporter.
 class Parser {
 public:
-  Parser(lex::Lexer &lexer, SemanticIRBuilder &builder,
-    err::ErrReporter &reporter
-  ) : lexer(lexer), builder(builder), reporter(reporter) {
-    advance(); // 初始化，使 current 指向第一个 token
+  Parser(const lex::TokenStream &tokens, util::Arena &arena,
+    SemanticIRBuilder &builder, err::ErrReporter &reporter
+  ) : tokens(tokens), arena(arena), builder(builder), reporter(reporter) {
+    // 初始化，使 current 指向第一个 token
+    idx = locate(0);
+    cur = tokens.at(idx);
   }
   ~Parser() = default;
 
 public:
   auto parseProgram() -> ast::ProgPtr;
 
+  /**
+   * @brief 设置表达式嵌套深度的上限（0 表示不限制）
+   */
+  void setMaxNesting(std::size_t limit) {
+    max_nesting = limit;
+  }
+
 private:
-  auto nextToken() -> lex::Token;
+  auto locate(std::size_t k) -> std::size_t;
   void advance();
   bool match(lex::TokenType type);
   bool check(lex::TokenType type) const;
-  bool checkAhead(lex::TokenType type);
+  bool checkAhead(lex::TokenType type, std::size_t k = 1);
   void consume(lex::TokenType type, const std::string &msg);
+  [[noreturn]] void nestingTooDeep();
 
-  auto parseID() -> std::pair<std::string, util::Position>;
-  auto parseInnerVarDecl() -> std::tuple<bool, std::string, util::Position>;
+  auto parseID() -> std::pair<util::Name, util::Position>;
+  auto parseInnerVarDecl() -> std::tuple<bool, util::Name, util::Position>;
   auto parseFuncDecl() -> ast::FuncDeclPtr;
   auto parseFuncHeaderDecl() -> ast::FuncHeaderDeclPtr;
   auto parseArg() -> ast::ArgPtr;
@@ -88,9 +110,7 @@ private:
   auto parseArrAcc(ast::ExprPtr val) -> ast::ArrAccPtr;
   auto parseTupAcc(ast::ExprPtr val) -> ast::TupAccPtr;
   auto parseValue() -> ast::ExprPtr;
-  auto parseCmpExpr(std::optional<ast::ExprPtr> expr = std::nullopt) -> ast::ExprPtr;
-  auto parseAddExpr(std::optional<ast::ExprPtr> expr = std::nullopt) -> ast::ExprPtr;
-  auto parseMulExpr(std::optional<ast::ExprPtr> expr = std::nullopt) -> ast::ExprPtr;
+  auto parseBinaryExpr(std::optional<ast::ExprPtr> expr = std::nullopt) -> ast::ExprPtr;
   auto parseFactor(std::optional<ast::ExprPtr> expr = std::nullopt) -> ast::ExprPtr;
   auto parseArrElems() -> ast::ExprPtr;
   auto parseTupElems() -> ast::ExprPtr;
@@ -104,10 +124,15 @@ private:
   auto parseLoopExpr() -> ast::LoopExprPtr;
 
 private:
-  lex::Token                cur;  // current token
-  std::optional<lex::Token> la; // look ahead token
+  lex::Token  cur;     // current token
+  std::size_t idx = 0; // index of current token
+
+  std::size_t depth       = 0;           // 正在解析的 parseExpr 的嵌套层数
+  std::size_t deepest     = 0;           // 当前表达式中已解析部分达到的最大深度
+  std::size_t max_nesting = MAX_NESTING; // 嵌套深度的上限，0 表示不限制
 
-  lex::Lexer        &lexer;
+  const lex::TokenStream &tokens; // token stream
+  util::Arena            &arena;  // AST 结点的分配器
   SemanticIRBuilder &builder;  // semantic ir builder
   err::ErrReporter  &reporter; // error reporter
 };
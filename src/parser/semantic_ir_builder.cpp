@@ -0,0 +1,306 @@
+#include "dispatch.hpp"
+#include "semantic_ir_builder.hpp"
+
+namespace par {
+
+namespace {
+
+/**
+ * @brief   按语法制导的顺序遍历一个函数体
+ * @details 每个结点在其子结点之后 build，语义作用域的进入与退出位置
+ *          与原先在 parser 中边解析边检查时完全一致
+ */
+class Walker {
+public:
+  explicit Walker(SemanticIRBuilder &builder) : builder(builder), ctx(*builder.ctx) {}
+
+public:
+  /**
+   * @brief 遍历语句块，不进入新的作用域（作用域由外层结构负责）
+   */
+  void block(ast::StmtBlockExpr &sbexpr) {
+    if (sbexpr.missing) {
+      return;
+    }
+    for (const auto &stmt : sbexpr.stmts) {
+      ast::dispatch(*this, *stmt);
+    }
+    builder.build(sbexpr);
+  }
+
+  void visit(ast::StmtBlockExpr &sbexpr) {
+    ctx.enterBlockExpr();
+    block(sbexpr);
+    ctx.exitScope();
+  }
+
+  void visit(ast::EmptyStmt &estmt) {
+    builder.build(estmt);
+  }
+
+  void visit(ast::VarDeclStmt &vdstmt) {
+    if (vdstmt.rval.has_value()) {
+      expr(vdstmt.rval.value());
+    }
+    builder.build(vdstmt);
+  }
+
+  void visit(ast::ExprStmt &estmt) {
+    expr(estmt.expr);
+    builder.build(estmt);
+  }
+
+  void visit(ast::RetExpr &rexpr) {
+    if (rexpr.retval.has_value()) {
+      expr(rexpr.retval.value());
+    }
+    builder.build(rexpr);
+  }
+
+  void visit(ast::BreakExpr &bexpr) {
+    if (bexpr.value.has_value()) {
+      expr(bexpr.value.value());
+    }
+    builder.build(bexpr);
+  }
+
+  void visit(ast::ContinueExpr &cexpr) {
+    builder.build(cexpr);
+  }
+
+  void visit(ast::AssignExpr &aexpr) {
+    expr(aexpr.lval);
+    expr(aexpr.rval);
+    builder.build(aexpr);
+  }
+
+  void visit(ast::AssignElem &aelem) {
+    expr(aelem.base);
+    builder.build(aelem);
+  }
+
+  void visit(ast::ArrAcc &aacc) {
+    expr(aacc.base);
+    expr(aacc.idx);
+    builder.build(aacc);
+  }
+
+  void visit(ast::TupAcc &tacc) {
+    expr(tacc.base);
+    if (tacc.idx != nullptr) {
+      builder.build(*tacc.idx);
+    }
+    builder.build(tacc);
+  }
+
+  void visit(ast::Variable &var) {
+    builder.build(var);
+  }
+
+  void visit(ast::Number &num) {
+    builder.build(num);
+  }
+
+  void visit(ast::BracketExpr &bexpr) {
+    if (bexpr.expr.has_value()) {
+      expr(bexpr.expr.value());
+    }
+    builder.build(bexpr);
+  }
+
+  void visit(ast::CallExpr &cexpr) {
+    for (const auto &arg : cexpr.argv) {
+      expr(arg);
+    }
+    builder.build(cexpr);
+  }
+
+  void visit(ast::CmpExpr &cexpr) {
+    expr(cexpr.lhs);
+    expr(cexpr.rhs);
+    builder.build(cexpr);
+  }
+
+  void visit(ast::AriExpr &aexpr) {
+    expr(aexpr.lhs);
+    expr(aexpr.rhs);
+    builder.build(aexpr);
+  }
+
+  void visit(ast::ArrElems &aelems) {
+    for (const auto &elem : aelems.elems) {
+      expr(elem);
+    }
+    builder.build(aelems);
+  }
+
+  void visit(ast::TupElems &telems) {
+    for (const auto &elem : telems.elems) {
+      expr(elem);
+    }
+    builder.build(telems);
+  }
+
+  void visit(ast::IfExpr &iexpr) {
+    expr(iexpr.cond);
+
+    ctx.enterIf();
+    block(*iexpr.body);
+    if (!iexpr.body->missing && iexpr.body->type.type != type::TypeFactory::UNIT_TYPE) {
+      auto temp = ctx.produceTemp(iexpr.pos, iexpr.body->type.type);
+      ctx.setCurCtxSymbol(temp);
+      iexpr.symbol = temp;
+    }
+    ctx.exitSymtabScope();
+
+    for (const auto &eclause : iexpr.elses) {
+      visit(*eclause);
+    }
+
+    builder.build(iexpr);
+    ctx.exitCtxScope();
+  }
+
+  void visit(ast::ElseClause &eclause) {
+    if (eclause.cond.has_value()) {
+      expr(eclause.cond.value());
+    }
+
+    ctx.enterElse();
+    block(*eclause.body);
+    ctx.exitSymtabScope();
+
+    builder.build(eclause);
+    ctx.exitCtxScope();
+  }
+
+  void visit(ast::WhileLoopExpr &wlexpr) {
+    expr(wlexpr.cond);
+
+    ctx.enterWhile();
+    block(*wlexpr.body);
+    builder.build(wlexpr);
+    ctx.exitScope();
+  }
+
+  void visit(ast::ForLoopExpr &flexpr) {
+    ctx.enterFor();
+    // 这里简单的将迭代器的类型认为是 i32
+    // 实际类型应该由可迭代对象的元素的类型确定
+    auto var = ctx.declareVar(
+      flexpr.pattern, flexpr.mut, true, type::TypeFactory::INT_TYPE, flexpr.pattern_pos
+    );
+    ctx.setCurCtxSymbol(var);
+
+    expr(flexpr.iterexpr);
+    block(*flexpr.body);
+    builder.build(flexpr);
+    ctx.exitScope();
+  }
+
+  void visit(ast::RangeExpr &rexpr) {
+    expr(rexpr.start);
+    expr(rexpr.end);
+    builder.build(rexpr);
+  }
+
+  void visit(ast::IterableVal &ival) {
+    expr(ival.value);
+    builder.build(ival);
+  }
+
+  void visit(ast::LoopExpr &lexpr) {
+    ctx.enterLoop();
+    block(*lexpr.body);
+    builder.build(lexpr);
+    ctx.exitScope();
+  }
+
+private:
+  void expr(ast::Node *node) {
+    ast::dispatch(*this, *node);
+  }
+
+private:
+  SemanticIRBuilder    &builder;
+  sem::SemanticContext &ctx;
+};
+
+} // namespace
+
+/**
+ * @brief 检查 Prog 的语义、拼接各函数的中间代码
+ */
+void
+SemanticIRBuilder::lower(ast::Prog &prog)
+{
+  util::ScopedTimer scope{timer};
+
+  if (!deferred) {
+    build(prog);
+  }
+}
+
+/**
+ * @brief 对解析完成的函数做语义检查与 IR 生成（延迟模式下只记录错误数）
+ */
+void
+SemanticIRBuilder::lower(ast::FuncDecl &fdecl)
+{
+  util::ScopedTimer scope{timer};
+
+  if (deferred) {
+    parse_err_marks.push_back(reporter.errCount());
+    return;
+  }
+
+  util::TimeScope phase{report, "semantic + IR"};
+  lowerHeader(*fdecl.header);
+  lowerBody(fdecl);
+}
+
+/**
+ * @brief 声明函数及其形参，检查函数头；返回后仍处于函数作用域中
+ */
+void
+SemanticIRBuilder::lowerHeader(ast::FuncHeaderDecl &fhdecl)
+{
+  ctx->enterFunc(fhdecl.name, fhdecl.pos); // 必须先进入作用域！！！
+  for (const auto &arg : fhdecl.argv) {
+    build(*arg);
+  }
+  build(fhdecl);
+}
+
+/**
+ * @brief 检查函数体并生成函数的 IR，最后退出函数作用域
+ */
+void
+SemanticIRBuilder::lowerBody(ast::FuncDecl &fdecl)
+{
+  Walker walker{*this};
+  walker.block(*fdecl.body);
+
+  build(fdecl);
+  ctx->exitScope();
+}
+
+/**
+ * @brief 在另一个符号表中重新进入已由 lowerHeader 声明的函数，之后可以调用 lowerBody
+ * @param fdecl 函数声明
+ * @param func  第一阶段创建的函数符号
+ */
+void
+SemanticIRBuilder::resume(ast::FuncDecl &fdecl, sym::FunctionPtr func)
+{
+  std::vector<util::Name> argnames;
+  argnames.reserve(fdecl.header->argv.size());
+  for (const auto &arg : fdecl.header->argv) {
+    argnames.push_back(arg->name);
+  }
+
+  ctx->resumeFunc(std::move(func), argnames);
+  buildIR(*fdecl.header);
+}
+
+} // namespace par
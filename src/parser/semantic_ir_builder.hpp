@@ -5,6 +5,11 @@
 /// and maintains a semantic context. For each node, it first performs semantic checking, and if no errors are reported,
 /// proceeds to IR generation. The class is intended to be used within the `par` namespace for parsing and semantic IR building.
 ///
+/// The parser hands over every function once it has been parsed (`lower`). The builder then walks the function in
+/// the order the nodes were reduced, entering and leaving semantic scopes exactly where the grammar does and calling
+/// `build` on each node after its children. In deferred mode `lower` only records where the function ends, so the
+/// whole file can be parsed first and the functions checked afterwards (see parallel_lowering.hpp).
+///
 /// @note The class template method `build` dispatches to the appropriate visitor methods for semantic checking and IR building,
 /// depending on the node type.
 ///
@@ -15,10 +20,14 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
+#include "timer.hpp"
 #include "err_report.hpp"
 #include "ir_builder.hpp"
+#include "time_report.hpp"
 #include "symbol_table.hpp"
+#include "type_factory.hpp"
 #include "semantic_checker.hpp"
 #include "semantic_context.hpp"
 
@@ -28,8 +37,11 @@ namespace par {
 class SemanticIRBuilder {
 public:
   SemanticIRBuilder(sym::SymbolTable &symtab, err::ErrReporter &reporter)
-    : ctx(std::make_unique<sem::SemanticContext>(symtab)), reporter(reporter),
-      sema(*ctx, reporter), ir(*ctx) {}
+    : SemanticIRBuilder(symtab, reporter, std::make_shared<type::TypeFactory>()) {}
+  SemanticIRBuilder(sym::SymbolTable &symtab, err::ErrReporter &reporter,
+    std::shared_ptr<type::TypeFactory> type_factory)
+    : ctx(std::make_unique<sem::SemanticContext>(symtab, std::move(type_factory))),
+      reporter(reporter), sema(*ctx, reporter), ir(*ctx) {}
   ~SemanticIRBuilder() = default;
 
 public:
@@ -39,20 +51,79 @@ public:
       sema.visit(node);
     }
 
+    buildIR(node);
+  }
+
+  /**
+   * @brief 只生成 IR（语义检查已经完成的结点）
+   */
+  template <typename NodeT>
+  void buildIR(NodeT &node) {
     if constexpr (ast::HasVisit<ir::IRBuilder, NodeT>) {
-      if (!reporter.hasErrs()) {
+      if (ir_enabled && !reporter.hasErrs()) {
         ir.visit(node);
       }
     }
   }
 
+  void lower(ast::Prog &prog);
+  void lower(ast::FuncDecl &fdecl);
+
+  void lowerHeader(ast::FuncHeaderDecl &fhdecl);
+  void lowerBody(ast::FuncDecl &fdecl);
+  void resume(ast::FuncDecl &fdecl, sym::FunctionPtr func);
+
+  /**
+   * @brief 设置延迟模式：lower 只记录每个函数结束时已有的错误数，不做检查
+   */
+  void setDeferred(bool deferred) {
+    this->deferred = deferred;
+  }
+
+  /**
+   * @brief 延迟模式下，解析完第 i 个函数时报告器中的错误数
+   */
+  [[nodiscard]] const std::vector<std::size_t> &getParseErrMarks() const {
+    return parse_err_marks;
+  }
+
+  /**
+   * @brief 允许或禁止生成 IR（两阶段模式下第一阶段只检查函数头，
+   *        或之前的函数中已有语法错误）
+   */
+  void setIREnabled(bool enabled) {
+    ir_enabled = enabled;
+  }
+
+  /**
+   * @brief 设置计时器，lower 中花费的时间会累加到其中（nullptr 表示不计时）
+   */
+  void setTimer(util::Timer *timer) {
+    this->timer = timer;
+  }
+
+  /**
+   * @brief 设置 --time-report 的统计，非延迟模式下各函数的检查与 IR 生成计入其中
+   */
+  void setReport(util::TimeReport *report) {
+    this->report = report;
+  }
+
 public:
   std::unique_ptr<sem::SemanticContext> ctx;
 
 private:
+  util::Timer          *timer  = nullptr;
+  util::TimeReport     *report = nullptr;
+
   err::ErrReporter     &reporter;
   sem::SemanticChecker  sema;
   ir::IRBuilder         ir;
+
+  bool deferred   = false; // 延迟模式
+  bool ir_enabled = true;  // 是否允许生成 IR
+
+  std::vector<std::size_t> parse_err_marks; // 见 getParseErrMarks
 };
 
 } // namespace par
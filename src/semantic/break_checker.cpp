@@ -29,7 +29,7 @@ BreakChecker::visit(ast::StmtBlockExpr &sbexpr)
 {
   // 检查各语句是否含有 break expression
   for (const auto &stmt : sbexpr.stmts) {
-    stmt->accept(*this);
+    ast::dispatch(*this, *stmt);
   }
 }
 
@@ -37,21 +37,21 @@ void
 BreakChecker::visit(ast::VarDeclStmt &vdstmt)
 {
   if (vdstmt.rval.has_value()) {
-    vdstmt.rval.value()->accept(*this);
+    ast::dispatch(*this, *vdstmt.rval.value());
   }
 }
 
 void
 BreakChecker::visit(ast::ExprStmt &estmt)
 {
-  estmt.expr->accept(*this);
+  ast::dispatch(*this, *estmt.expr);
 }
 
 void
 BreakChecker::visit(ast::RetExpr &rexpr)
 {
   if (rexpr.retval.has_value()) {
-    rexpr.retval.value()->accept(*this);
+    ast::dispatch(*this, *rexpr.retval.value());
   }
 }
 
@@ -106,30 +106,30 @@ BreakChecker::visit(ast::BreakExpr &bexpr)
 void
 BreakChecker::visit(ast::AssignExpr &aexpr)
 {
-  aexpr.rval->accept(*this);
+  ast::dispatch(*this, *aexpr.rval);
 }
 
 void
 BreakChecker::visit(ast::BracketExpr &bexpr)
 {
   if (bexpr.expr.has_value()) {
-    bexpr.expr.value()->accept(*this);
+    ast::dispatch(*this, *bexpr.expr.value());
   }
 }
 
 void
 BreakChecker::visit(ast::IfExpr &iexpr)
 {
-  iexpr.body->accept(*this);
+  ast::dispatch(*this, *iexpr.body);
   for (const auto &eclause : iexpr.elses) {
-    eclause->accept(*this);
+    ast::dispatch(*this, *eclause);
   }
 }
 
 void
 BreakChecker::visit(ast::ElseClause &eclause)
 {
-  eclause.body->accept(*this);
+  ast::dispatch(*this, *eclause.body);
 }
 
 } // namespace sem
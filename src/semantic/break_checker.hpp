@@ -2,7 +2,7 @@
 
 #include "ast.hpp"
 #include "err_report.hpp"
-#include "oop_visitor.hpp"
+#include "dispatch.hpp"
 #include "type_factory.hpp"
 #include "semantic_context.hpp"
 
@@ -11,22 +11,21 @@ namespace sem {
 // 检查 statement block expression 中是否含有 break 语句
 // 并检查各 break 语句是否具有相同的返回值类型
 // 存储检查结果以便外部直接访问
-class BreakChecker : public ast::BaseVisitor {
+class BreakChecker {
 public:
   BreakChecker(const sem::SemanticContext &ctx,
     err::ErrReporter &reporter) : ctx(ctx), reporter(reporter) {}
-  ~BreakChecker() override = default;
 
 public:
-  void visit(ast::StmtBlockExpr &sbexpr) override;
-  void visit(ast::VarDeclStmt &vdstmt) override;
-  void visit(ast::ExprStmt &estmt) override;
-  void visit(ast::RetExpr &rexpr) override;
-  void visit(ast::BreakExpr &bexpr) override;
-  void visit(ast::AssignExpr &aexpr) override;
-  void visit(ast::BracketExpr &bexpr) override;
-  void visit(ast::IfExpr &iexpr) override;
-  void visit(ast::ElseClause &eclause) override;
+  void visit(ast::StmtBlockExpr &sbexpr);
+  void visit(ast::VarDeclStmt &vdstmt);
+  void visit(ast::ExprStmt &estmt);
+  void visit(ast::RetExpr &rexpr);
+  void visit(ast::BreakExpr &bexpr);
+  void visit(ast::AssignExpr &aexpr);
+  void visit(ast::BracketExpr &bexpr);
+  void visit(ast::IfExpr &iexpr);
+  void visit(ast::ElseClause &eclause);
 
 public:
   const sem::SemanticContext &ctx;      // semantic context
@@ -9,7 +9,7 @@ ReturnChecker::visit(ast::StmtBlockExpr &sbexpr)
 {
   for (const auto &stmt : sbexpr.stmts) {
     if (!has_ret) {
-      stmt->accept(*this);
+      ast::dispatch(*this, *stmt);
     }
     // TODO: 可以选择报告一个 warning
     stmt->unreachable = has_ret;
@@ -20,14 +20,14 @@ void
 ReturnChecker::visit(ast::VarDeclStmt &vdstmt)
 {
   if (vdstmt.rval.has_value()) {
-    vdstmt.rval.value()->accept(*this);
+    ast::dispatch(*this, *vdstmt.rval.value());
   }
 }
 
 void
 ReturnChecker::visit(ast::ExprStmt &estmt)
 {
-  estmt.expr->accept(*this);
+  ast::dispatch(*this, *estmt.expr);
 }
 
 void
@@ -40,21 +40,21 @@ void
 ReturnChecker::visit(ast::BreakExpr &bexpr)
 {
   if (bexpr.value.has_value()) {
-    bexpr.value.value()->accept(*this);
+    ast::dispatch(*this, *bexpr.value.value());
   }
 }
 
 void
 ReturnChecker::visit(ast::AssignExpr &aexpr)
 {
-  aexpr.rval->accept(*this);
+  ast::dispatch(*this, *aexpr.rval);
 }
 
 void
 ReturnChecker::visit(ast::BracketExpr &bexpr)
 {
   if (bexpr.expr.has_value()) {
-    bexpr.expr.value()->accept(*this);
+    ast::dispatch(*this, *bexpr.expr.value());
   }
 }
 
@@ -70,7 +70,7 @@ ReturnChecker::visit(ast::IfExpr &iexpr)
   // 路径覆盖
   // 检查 if 主体是否有 return
   ReturnChecker checker;
-  iexpr.body->accept(checker);
+  ast::dispatch(checker, *iexpr.body);
   bool if_has_ret = checker.has_ret;
 
   // 所有 else 分支都必须 return
@@ -78,7 +78,7 @@ ReturnChecker::visit(ast::IfExpr &iexpr)
     iexpr.elses,
     [](const auto &eclause) {
       ReturnChecker checker;
-      eclause->accept(checker);
+      ast::dispatch(checker, *eclause);
       return checker.has_ret;
     }
   );
@@ -89,7 +89,7 @@ ReturnChecker::visit(ast::IfExpr &iexpr)
 void
 ReturnChecker::visit(ast::ElseClause &eclause)
 {
-  eclause.body->accept(*this);
+  ast::dispatch(*this, *eclause.body);
 }
 
 void
@@ -110,7 +110,7 @@ void
 ReturnChecker::visit(ast::LoopExpr &lexpr)
 {
   // 认为 loop 表达式一定会执行
-  lexpr.body->accept(*this);
+  ast::dispatch(*this, *lexpr.body);
 }
 
 } // namespace sem
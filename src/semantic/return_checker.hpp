@@ -1,27 +1,24 @@
 #pragma once
 
 #include "ast.hpp"
-#include "oop_visitor.hpp"
+#include "dispatch.hpp"
 
 namespace sem {
 
-class ReturnChecker : public ast::BaseVisitor {
+class ReturnChecker {
 public:
-  ~ReturnChecker() override = default;
-
-public:
-  void visit(ast::StmtBlockExpr &sbexpr) override;
-  void visit(ast::VarDeclStmt &vdstmt) override;
-  void visit(ast::ExprStmt &estmt) override;
-  void visit(ast::RetExpr &rexpr) override;
-  void visit(ast::BreakExpr &bexpr) override;
-  void visit(ast::AssignExpr &aexpr) override;
-  void visit(ast::BracketExpr &bexpr) override;
-  void visit(ast::IfExpr &iexpr) override;
-  void visit(ast::ElseClause &eclause) override;
-  void visit(ast::WhileLoopExpr&wlexpr) override;
-  void visit(ast::ForLoopExpr &flexpr) override;
-  void visit(ast::LoopExpr&lexpr) override;
+  void visit(ast::StmtBlockExpr &sbexpr);
+  void visit(ast::VarDeclStmt &vdstmt);
+  void visit(ast::ExprStmt &estmt);
+  void visit(ast::RetExpr &rexpr);
+  void visit(ast::BreakExpr &bexpr);
+  void visit(ast::AssignExpr &aexpr);
+  void visit(ast::BracketExpr &bexpr);
+  void visit(ast::IfExpr &iexpr);
+  void visit(ast::ElseClause &eclause);
+  void visit(ast::WhileLoopExpr&wlexpr);
+  void visit(ast::ForLoopExpr &flexpr);
+  void visit(ast::LoopExpr&lexpr);
 
 public:
   bool has_ret = false;
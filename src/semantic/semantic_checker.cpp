@@ -125,7 +125,7 @@ SemanticChecker::visit(ast::StmtBlockExpr &sbexpr)
 {
   // 检查语句块中是否有 return 表达式
   ReturnChecker rchecker;
-  sbexpr.accept(rchecker);
+  rchecker.visit(sbexpr);
   sbexpr.has_ret = rchecker.has_ret;
   sbexpr.res_mut = false;
 
@@ -940,7 +940,7 @@ SemanticChecker::visit(ast::LoopExpr &lexpr)
   // loop expression 的类型由其循环体内的 break 语句决定
   // 其循环体的类型应该是 unit type
   BreakChecker bchecker{ctx, reporter};
-  lexpr.body->accept(bchecker);
+  bchecker.visit(*lexpr.body);
   if (bchecker.has_break) {
     // Break Checker 返回的类型是 break 表达式返回的值的类型
     // 因此可以将 break 表达式本身的类型安全的设置为 unit type!
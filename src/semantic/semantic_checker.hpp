@@ -16,7 +16,6 @@ class SemanticChecker : public ast::CRTPVisitor<SemanticChecker> {
 public:
   SemanticChecker(sem::SemanticContext &ctx, err::ErrReporter &reporter)
     : ctx(ctx), reporter(reporter) {}
-  ~SemanticChecker() override = default;
 
 public:
   void visit(ast::FuncDecl&);
@@ -9,16 +9,37 @@
 namespace sem {
 
 void
-SemanticContext::enterFunc(const std::string &name, util::Position pos) {
+SemanticContext::enterFunc(util::Name name, util::Position pos) {
   curfunc = std::make_shared<sym::Function>();
   // 注意：形参列表和返回类型此时还未设置！
   curfunc->pos = pos;
-  curfunc->name = name;
+  curfunc->name = name.str();
 
   symtab.declareFunc(name, curfunc);
-  symtab.enterScope(name, true);
+  symtab.enterScope(curfunc->name);
   scopenum = 0;
-  scopestack.emplace_back(Scope::Kind::FUNC, name);
+  scopestack.emplace_back(Scope::Kind::FUNC, curfunc->name);
+}
+
+/**
+ * @brief   重新进入一个已经声明过的函数（两阶段模式下在工作线程中检查函数体）
+ * @details 函数符号与形参已在第一阶段创建，这里只在当前符号表中重建
+ *          函数作用域并按原顺序重新登记形参，得到与 enterFunc 之后完全相同的状态
+ * @param   func     函数符号
+ * @param   argnames 各形参的名字，与 func->argv 一一对应
+ */
+void
+SemanticContext::resumeFunc(sym::FunctionPtr func, std::span<const util::Name> argnames)
+{
+  curfunc = std::move(func);
+
+  symtab.enterScope(curfunc->name);
+  scopenum = 0;
+  scopestack.emplace_back(Scope::Kind::FUNC, curfunc->name);
+
+  for (std::size_t i = 0; i < argnames.size(); ++i) {
+    symtab.declareVal(argnames[i], curfunc->argv[i]);
+  }
 }
 
 // 统一的进入作用域函数，参数决定作用域类型
@@ -29,7 +50,7 @@ SemanticContext::enterScope(Scope::Kind kind)
   ++scopenum;
   const std::string name = std::format("L{}", scopenum);
   // 通知符号表进入新作用域
-  symtab.enterScope(name, true);
+  symtab.enterScope(name);
   // 记录作用域栈，方便后续上下文查询
   scopestack.emplace_back(kind, name);
 }
@@ -78,13 +99,13 @@ SemanticContext::exitScope()
 }
 
 std::optional<sym::FunctionPtr>
-SemanticContext::lookupFunc(const std::string &name) const
+SemanticContext::lookupFunc(util::Name name) const
 {
   return symtab.lookupFunc(name);
 }
 
 std::optional<sym::ValuePtr>
-SemanticContext::lookupVal(const std::string &name) const
+SemanticContext::lookupVal(util::Name name) const
 {
    return symtab.lookupVal(name);
 }
@@ -96,12 +117,13 @@ SemanticContext::lookupConst(const std::string &name) const
 }
 
 void
-SemanticContext::declareArg(const std::string &name, bool mut,
+SemanticContext::declareArg(util::Name name, bool mut,
   type::TypePtr type, util::Position pos)
 {
   auto arg = std::make_shared<sym::Variable>();
+  arg->id     = symtab.newValueId();
   arg->pos    = pos;
-  arg->name   = name;
+  arg->name   = name.str();
   arg->mut    = mut;
   arg->formal = true;
   arg->init   = true;
@@ -112,12 +134,13 @@ SemanticContext::declareArg(const std::string &name, bool mut,
 }
 
 sym::VariablePtr
-SemanticContext::declareVar(const std::string &name, bool mut, bool init,
+SemanticContext::declareVar(util::Name name, bool mut, bool init,
   type::TypePtr type, util::Position pos)
 {
   auto var = std::make_shared<sym::Variable>();
+  var->id     = symtab.newValueId();
   var->pos    = pos;
-  var->name   = name;
+  var->name   = name.str();
   var->mut    = mut;
   var->init   = init;
   var->formal = false;
@@ -149,6 +172,7 @@ SemanticContext::declareConst(std::variant<int, bool> val, util::Position pos)
   }
 
   auto constant = std::make_shared<sym::Constant>();
+  constant->id = symtab.newValueId();
   constant->pos = pos;
   constant->mut = false;
   constant->init = true;
@@ -182,7 +206,7 @@ SemanticContext::resetTempCnt()
 sym::TempPtr
 SemanticContext::produceTemp(util::Position pos, type::TypePtr type)
 {
-  return temp_factory->produce(pos, std::move(type));
+  return temp_factory->produce(symtab.newValueId(), pos, std::move(type));
 }
 
 void
@@ -271,12 +295,16 @@ SemanticContext::getCurFuncType() const
   return curfunc->type;
 }
 
+const sym::FunctionPtr&
+SemanticContext::getCurFunc() const
+{
+  return curfunc;
+}
+
 std::string
 SemanticContext::getCurScopeName() const
 {
-  return symtab.getCurScopeName().substr(
-    std::string("global::").length()
-  );
+  return symtab.getCurScopeName();
 }
 
 std::string
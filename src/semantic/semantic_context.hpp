@@ -1,10 +1,12 @@
 #pragma once
 
+#include <span>
 #include <memory>
 #include <vector>
 #include <variant>
 #include <optional>
 
+#include "interner.hpp"
 #include "temp_factory.hpp"
 #include "type_factory.hpp"
 
@@ -50,14 +52,18 @@ public:
 
 public:
   SemanticContext(sym::SymbolTable &symtab)
+    : SemanticContext(symtab, std::make_shared<type::TypeFactory>()) {}
+  // 与其它上下文共享同一个类型工厂（类型按编号比较，必须来自同一个工厂）
+  SemanticContext(sym::SymbolTable &symtab,
+    std::shared_ptr<type::TypeFactory> type_factory)
     : symtab(symtab),
-      type_factory(std::make_unique<type::TypeFactory>()),
+      type_factory(std::move(type_factory)),
       temp_factory(std::make_unique<ir::TempFactory>()) {}
 
-
 public:
   // utils
-  void enterFunc(const std::string &name, util::Position pos);
+  void enterFunc(util::Name name, util::Position pos);
+  void resumeFunc(sym::FunctionPtr func, std::span<const util::Name> argnames);
   void enterBlockExpr();
   void enterIf();
   void enterElse();
@@ -68,19 +74,22 @@ public:
   void exitScope();
 
   [[nodiscard]]
-  auto lookupFunc(const std::string &name) const -> std::optional<sym::FunctionPtr>;
+  auto lookupFunc(util::Name name) const -> std::optional<sym::FunctionPtr>;
   [[nodiscard]]
-  auto lookupVal(const std::string &name) const -> std::optional<sym::ValuePtr>;
+  auto lookupVal(util::Name name) const -> std::optional<sym::ValuePtr>;
   [[nodiscard]]
   auto lookupConst(const std::string &name) const -> std::optional<sym::ConstantPtr>;
 
-  void declareArg(const std::string &name, bool mut,
+  void declareArg(util::Name name, bool mut,
     type::TypePtr type, util::Position pos);
-  auto declareVar(const std::string &name, bool mut, bool init,
+  auto declareVar(util::Name name, bool mut, bool init,
     type::TypePtr type, util::Position pos) -> sym::VariablePtr;
   [[nodiscard]]
   auto declareConst(std::variant<int, bool> val, util::Position pos) -> sym::ConstantPtr;
 
+  [[nodiscard]] auto getTypeFactory() const -> std::shared_ptr<type::TypeFactory> {
+    return type_factory;
+  }
   auto produceArrType(int size, type::TypePtr etype) -> type::TypePtr;
   auto produceTupType(std::vector<type::TypePtr> etypes) -> type::TypePtr;
 
@@ -108,6 +117,8 @@ public:
   [[nodiscard]]
   auto getCurFuncType() const -> const type::TypePtr&;
   [[nodiscard]]
+  auto getCurFunc() const -> const sym::FunctionPtr&;
+  [[nodiscard]]
   auto getCurScopeName() const -> std::string;
   [[nodiscard]]
   auto getCurCtxName() const -> std::string;
@@ -118,7 +129,7 @@ private:
 private:
   sym::SymbolTable  &symtab;
 
-  std::unique_ptr<type::TypeFactory> type_factory;
+  std::shared_ptr<type::TypeFactory> type_factory;
   std::unique_ptr<ir::TempFactory>   temp_factory;
 
   // 当前函数上下文
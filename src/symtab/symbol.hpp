@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <vector>
+#include <cstdint>
 #include <variant>
 
 #include "position.hpp"
@@ -9,7 +10,7 @@
 namespace type {
 
 struct Type;
-using TypePtr = std::shared_ptr<Type>;
+using TypePtr = const Type *;
 
 } // namespace type
 
@@ -27,6 +28,11 @@ using SymbolPtr = std::shared_ptr<Symbol>;
 
 // NOTE: 所有非基本类型，包括数组和元组，都在栈上分配空间！
 
+// 值的稠密编号，创建时由 SymbolTable::newValueId 分配，同一次编译内唯一
+// （并行检查时各函数分别编号，只保证同一函数内唯一）；
+// 代码生成阶段以它为下标索引各种状态（逐函数重置），名字只在打印时才生成
+using ValueId = std::uint32_t;
+
 struct Value : Symbol {
   enum class Kind : std::uint8_t {
     TEMP,  // 临时变量
@@ -40,6 +46,8 @@ struct Value : Symbol {
   //       在使用前至少用一次使用 数组元素/元组元素 进行的赋值！
   bool init; // 是否已经初始化
 
+  ValueId id = 0; // 稠密编号
+
   int frameaddr; // 在栈上分配的相对地址
 
   type::TypePtr type; // 变量类型
@@ -53,13 +61,15 @@ struct Value : Symbol {
 using ValuePtr = std::shared_ptr<Value>;
 
 struct Temp : Value {
+  int index = 0; // 函数内的临时变量编号，打印为 %index
+
   Temp() : Value(Kind::TEMP) {}
   ~Temp() override = default;
 
   [[nodiscard]] bool isConst() const override {
     return false;
   }
-  std::string str() final { return this->name; }
+  std::string str() final { return std::format("%{}", this->index); }
 };
 using TempPtr = std::shared_ptr<Temp>;
 
@@ -98,7 +108,8 @@ using ConstantPtr = std::shared_ptr<Constant>;
 
 struct Function : Symbol {
   std::vector<ValuePtr> argv;
-  type::TypePtr         type; // return value type
+  type::TypePtr         type;      // return value type
+  std::size_t           order = 0; // 在源文件中的声明顺序
 
   ~Function() override = default;
   std::string str() final { return this->name; }
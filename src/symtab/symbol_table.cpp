@@ -1,7 +1,6 @@
 #include <print>
-#include <regex>
+#include <algorithm>
 #include <fstream>
-#include <generator>
 #include <string_view>
 
 #include "panic.hpp"
@@ -11,58 +10,97 @@
 namespace sym {
 
 /**
- * @brief 进入作用域
- * @param name   作用域限定符
- * @param create 是否新建作用域
+ * @brief   从全局符号表分出一个只用于检查单个函数体的符号表
+ * @details 分支表的值编号从全局表当前的编号继续分配，保证同一函数内不与形参冲突；
+ *          检查期间全局表只读，因此多个分支表可以在不同线程中并发使用
+ * @param   global  全局符号表（所有函数都已声明）
+ * @param   visible 可见的函数个数，与单遍模式下检查该函数时已声明的函数一致
+ */
+SymbolTable::SymbolTable(const SymbolTable &global, std::size_t visible)
+  : SymbolTable(global.interner)
+{
+  this->global    = &global;
+  this->visible   = visible;
+  this->value_cnt = global.value_cnt;
+}
+
+/**
+ * @brief   把分支符号表的内容并回全局符号表
+ * @details 作用域按分支表中的创建顺序追加，按函数顺序依次合并即可得到
+ *          与单遍模式相同的打印顺序；值编号取两者的最大值（代码生成只要求
+ *          同一函数内的值编号互不相同）
+ * @param   fork 分支符号表
  */
 void
-SymbolTable::enterScope(const std::string &name, bool create)
+SymbolTable::merge(SymbolTable &&fork)
 {
-  std::string nextname = std::format("{}::{}", curname, name);
-
-  if (!create) {
-    ASSERT_MSG(
-      scopes.contains(nextname),
-      "scope didn't created"
-    );
-    curname  = nextname;
-    curscope = scopes[curname];
-    return;
+  ASSERT_MSG(fork.global == this, "not a fork of this symbol table");
+
+  auto base = static_cast<ScopeId>(scopes.size() - 1); // 分支表的全局作用域不合并
+  for (ScopeId id = GLOBAL_SCOPE + 1; id < fork.scopes.size(); ++id) {
+    auto &scope = fork.scopes[id];
+    scope.parent = scope.parent == GLOBAL_SCOPE ? GLOBAL_SCOPE : scope.parent + base;
+    scope.path_built = false;
+    scopes.push_back(std::move(scope));
   }
 
-  ASSERT_MSG(
-    !scopes.contains(nextname),
-    "scope already exists"
-  );
+  // 常量按创建顺序插入，使 constvals 的状态（以及打印顺序）与单遍模式一致
+  std::vector<std::pair<std::string, ConstantPtr>> consts{
+    std::make_move_iterator(fork.constvals.begin()),
+    std::make_move_iterator(fork.constvals.end())
+  };
+  std::ranges::sort(consts, {}, [](const auto &con) { return con.second->id; });
+  for (auto &[name, con] : consts) {
+    constvals.try_emplace(std::move(name), std::move(con));
+  }
+
+  value_cnt = std::max(value_cnt, fork.value_cnt);
+}
 
-  curname  = nextname;
-  curscope = std::make_shared<Scope>();
-  scopes[curname] = curscope;
+/**
+ * @brief 进入一个新的子作用域
+ * @param name 作用域名
+ */
+void
+SymbolTable::enterScope(std::string_view name)
+{
+  scopes.push_back({
+    .parent = curscope,
+    .name   = std::string{name},
+    .virt   = name == "virt"
+  });
+  curscope = static_cast<ScopeId>(scopes.size() - 1);
 }
 
 /**
- * @brief  退出作用域
+ * @brief  退出作用域（同时退出其中因遮蔽而创建的虚拟作用域）
  */
 void
 SymbolTable::exitScope()
 {
-  std::string name;
+  bool virt;
   do {
-    std::size_t idx = curname.rfind("::");
-    ASSERT_MSG(
-      idx < curname.length(),
-      "can't exit scope"
-    );
-
-    name = curname.substr(idx + 2);
-    curname = curname.substr(0, idx);
-    ASSERT_MSG(
-      scopes.contains(curname),
-      "scope doesn't exist"
-    );
-  } while (name == "virt");
-
-  curscope = scopes[curname];
+    ASSERT_MSG(curscope != GLOBAL_SCOPE, "can't exit scope");
+    virt = scopes[curscope].virt;
+    curscope = scopes[curscope].parent;
+  } while (virt);
+}
+
+/**
+ * @brief  取作用域的限定名（不含 global），只在第一次需要时生成
+ * @param  id 作用域
+ * @return 限定名，如 main::L1::virt
+ */
+const std::string &
+SymbolTable::scopePath(ScopeId id)
+{
+  auto &scope = scopes[id];
+  if (!scope.path_built) {
+    const auto &parent = scopePath(scope.parent);
+    scope.path = parent.empty() ? scope.name : std::format("{}::{}", parent, scope.name);
+    scope.path_built = true;
+  }
+  return scope.path;
 }
 
 /**
@@ -71,13 +109,14 @@ SymbolTable::exitScope()
  * @param func 函数符号指针
  */
 void
-SymbolTable::declareFunc(const std::string &fname, FunctionPtr func)
+SymbolTable::declareFunc(util::Name fname, FunctionPtr func)
 {
-  if (funcs.contains(fname)) {
+  if (funcs.contains(fname.id)) {
     UNREACHABLE("function name already exists");
   }
 
-  funcs[fname] = std::move(func);
+  func->order = funcs.size();
+  funcs[fname.id] = std::move(func);
 }
 
 /**
@@ -86,18 +125,18 @@ SymbolTable::declareFunc(const std::string &fname, FunctionPtr func)
  * @param p_var 变量符号指针
  */
 void
-SymbolTable::declareVal(const std::string &vname, ValuePtr val)
+SymbolTable::declareVal(util::Name vname, ValuePtr val)
 {
-  if ((*curscope).contains(vname)) {
-    enterScope("virt", true);
+  if (scopes[curscope].vals.contains(vname.id)) {
+    enterScope("virt");
   }
 
   if (val->kind == Value::Kind::LOCAL) {
     auto localval = std::static_pointer_cast<Variable>(val);
-    localval->scopename = curname.substr(std::string{"global::"}.length());
+    localval->scopename = scopePath(curscope);
   }
 
-  (*curscope)[vname] = std::move(val);
+  scopes[curscope].vals.insert(vname.id, std::move(val));
 }
 
 void
@@ -116,41 +155,50 @@ SymbolTable::declareConst(const std::string &cname, ConstantPtr con)
  * @return std::optional<FunctionPtr> 需要检查是否能查到
  */
 std::optional<FunctionPtr>
-SymbolTable::lookupFunc(const std::string &name) const
+SymbolTable::lookupFunc(util::Name name) const
 {
-  if (funcs.contains(name)) {
-    return funcs.find(name)->second;
+  if (global != nullptr) {
+    auto func = global->lookupFunc(name);
+    if (func.has_value() && func.value()->order >= visible) {
+      return std::nullopt; // 单遍模式下此时还未声明
+    }
+    return func;
+  }
+
+  if (auto it = funcs.find(name.id); it != funcs.end()) {
+    return it->second;
   }
   return std::nullopt;
 }
 
-static std::generator<std::string_view>
-reverseScopeRange(std::string_view scope_name)
+/**
+ * @brief  按函数名字符串查找函数符号（用于 IR 中以字符串保存的调用目标）
+ * @param  name 函数名
+ * @return std::optional<FunctionPtr> 需要检查是否能查到
+ */
+std::optional<FunctionPtr>
+SymbolTable::lookupFunc(std::string_view name) const
 {
-  while (true) {
-    co_yield scope_name;
-    auto pos = scope_name.rfind("::");
-    if (pos == std::string_view::npos) {
-      break;
-    }
-    scope_name = scope_name.substr(0, pos);
+  if (auto id = interner.find(name); id.has_value()) {
+    return lookupFunc(id.value());
   }
+  return std::nullopt;
 }
 
 /**
- * @brief  查找变量符号
+ * @brief  查找变量符号，从当前作用域沿父结点向外查找
  * @param  name 变量名
  * @return std::optional<VariablePtr> 需要检查是否能查到
  */
 std::optional<ValuePtr>
-SymbolTable::lookupVal(const std::string &name) const
+SymbolTable::lookupVal(util::Name name) const
 {
-  for (auto scopename : reverseScopeRange(curname)) {
-    if (auto it = scopes.find(scopename); it != scopes.end()) {
-      auto scope = it->second;
-      if (auto var_it = scope->find(name); var_it != scope->end()) {
-        return var_it->second;
-      }
+  for (ScopeId id = curscope;; id = scopes[id].parent) {
+    if (const auto *val = scopes[id].vals.find(name.id); val != nullptr) {
+      return *val;
+    }
+    if (id == GLOBAL_SCOPE) {
+      break;
     }
   }
 
@@ -167,13 +215,13 @@ SymbolTable::lookupConst(const std::string &name) const
 }
 
 /**
- * @brief  取作用域名
- * @return 作用域名，含global
- */
+ * @brief  取作用域名
+ * @return 作用域名，不含global
+ */
 std::string
-SymbolTable::getCurScopeName() const
+SymbolTable::getCurScopeName()
 {
-  return curname;
+  return scopePath(curscope);
 }
 
 /**
@@ -181,12 +229,13 @@ SymbolTable::getCurScopeName() const
  * @return 函数名，不含global
  */
 std::string
-SymbolTable::getFuncName()
+SymbolTable::getFuncName() const
 {
-  std::regex re{R"(^global::(\w+))"};
-  std::smatch match;
-  std::regex_search(curname, match, re);
-  return match[1];
+  ScopeId id = curscope;
+  while (id != GLOBAL_SCOPE && scopes[id].parent != GLOBAL_SCOPE) {
+    id = scopes[id].parent;
+  }
+  return id == GLOBAL_SCOPE ? std::string{} : scopes[id].name;
 }
 
 /**
@@ -198,11 +247,16 @@ SymbolTable::checkAutoTypeInfer() const
 {
   std::vector<ValuePtr> failed_vals;
 
-  for (const auto &[name, val] : *curscope) {
+  scopes[curscope].vals.forEach([&failed_vals](util::SymbolId, const ValuePtr &val) {
     if (val->type->kind == type::TypeKind::UNKNOWN) {
       failed_vals.push_back(val);
     }
-  }
+  });
+
+  // 按声明顺序报告，不依赖哈希表的遍历顺序
+  std::ranges::sort(failed_vals, {}, [](const ValuePtr &val) {
+    return std::pair{val->pos.row, val->pos.col};
+  });
 
   return failed_vals;
 }
@@ -231,7 +285,7 @@ SymbolTable::dumpFunc(std::ofstream &out)
   std::println(out, "{}", std::string(delimiter_cnt, '-'));
 
   for (const auto &func : funcs) {
-    std::println(out, "  function name: {}", func.first);
+    std::println(out, "  function name: {}", func.second->name);
     std::println(out, "  argc: {}", func.second->argv.size());
     if (func.second->argv.size() > 0) {
       std::println(out, "  argv:");
@@ -256,19 +310,14 @@ SymbolTable::dumpLocalVar(std::ofstream &out)
 {
   std::println(out, "\nLocal Variable:");
 
-  for (const auto &scope : scopes) {
-    if (scope.first == "global") {
-      continue;
-    }
-
-    std::string str = "global::";
-    auto scopename = scope.first.substr(str.length());
-    auto p_scope = scope.second;
+  // 按作用域创建顺序打印，跳过全局作用域
+  for (ScopeId id = GLOBAL_SCOPE + 1; id < scopes.size(); ++id) {
+    const auto &scopename = scopePath(id);
 
     int cnt = 0;
-    for (const auto &val : *p_scope) {
-      if (val.second->kind == Value::Kind::LOCAL) {
-        auto var = std::static_pointer_cast<Variable>(val.second);
+    scopes[id].vals.forEach([&](util::SymbolId, const ValuePtr &val) {
+      if (val->kind == Value::Kind::LOCAL) {
+        auto var = std::static_pointer_cast<Variable>(val);
         if (!var->formal) {
           std::println(out,
             " {:>2}. name: {}, mutable: {}, type: {}",
@@ -279,7 +328,7 @@ SymbolTable::dumpLocalVar(std::ofstream &out)
           );
         }
       }
-    }
+    });
   }
 }
 
@@ -19,45 +19,76 @@
  * lookup with optional type inference checks.
  *
  * @note
- * - Scopes are managed as shared pointers to unordered maps.
- * - Transparent hashing and comparison are used for efficient string lookups.
+ * - Scopes form a parent-linked tree of frames identified by integer ScopeIds;
+ *   entering and exiting a scope is O(1) and builds no strings.
+ * - Each frame holds a flat open-addressing map (util::IdMap) keyed by interned
+ *   identifier ids (util::SymbolId); lookups walk the parent links.
+ * - Qualified scope names ("main::L1") are only built for printing, once per scope.
+ * - A fork (SymbolTable(global, visible)) checks one function body on a worker
+ *   thread: it has its own scopes, constants and value ids, and resolves functions
+ *   read-only through the global table. merge() folds it back in declaration order.
  * - The class supports dumping its contents to an output file stream.
  */
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
 #include <unordered_map>
 
+#include "id_map.hpp"
 #include "symbol.hpp"
+#include "interner.hpp"
 
 namespace sym {
 
+using ScopeId = std::uint32_t;
+
 class SymbolTable {
 public:
-  SymbolTable() {
-    curname  = "global";
-    curscope = std::make_shared<Scope>();
-    scopes[curname] = curscope;
+  static constexpr ScopeId GLOBAL_SCOPE = 0;
+
+  SymbolTable(util::Interner &interner) : interner(interner) {
+    scopes.push_back({.parent = GLOBAL_SCOPE, .name = "global", .virt = false});
+    scopes.back().path_built = true; // 全局作用域的限定名为空
+    curscope = GLOBAL_SCOPE;
   }
+  SymbolTable(const SymbolTable &global, std::size_t visible);
   ~SymbolTable() = default;
 
 public:
-  void enterScope(const std::string &name, bool create);
+  void enterScope(std::string_view name);
   void exitScope();
 
-  void declareFunc(const std::string &fname, FunctionPtr func);
-  void declareVal(const std::string &vname, ValuePtr val);
+  void declareFunc(util::Name fname, FunctionPtr func);
+  void declareVal(util::Name vname, ValuePtr val);
   void declareConst(const std::string &cname, ConstantPtr con);
 
-  auto lookupFunc(const std::string &name) const -> std::optional<FunctionPtr>;
-  auto lookupVal(const std::string &name) const -> std::optional<ValuePtr>;
+  auto lookupFunc(util::Name name) const -> std::optional<FunctionPtr>;
+  auto lookupFunc(std::string_view name) const -> std::optional<FunctionPtr>;
+  auto lookupVal(util::Name name) const -> std::optional<ValuePtr>;
   auto lookupConst(const std::string &name) const -> std::optional<ConstantPtr>;
 
-  auto getCurScopeName() const -> std::string;
-  auto getFuncName() -> std::string;
+  auto getCurScopeName() -> std::string;
+  auto getFuncName() const -> std::string;
 
   auto checkAutoTypeInfer() const -> std::vector<ValuePtr>;
 
+  [[nodiscard]] util::Interner &getInterner() const { return interner; }
+
+  /**
+   * @brief 为新创建的值分配一个稠密编号
+   */
+  ValueId newValueId() { return value_cnt++; }
+
+  /**
+   * @brief 已分配的值编号个数，编号都小于它
+   */
+  [[nodiscard]] std::size_t valueCount() const { return value_cnt; }
+
+  void merge(SymbolTable &&fork);
+
   void dump(std::ofstream &out);
 
 private:
@@ -65,32 +96,34 @@ private:
   void dumpLocalVar(std::ofstream &out);
   void dumpConstant(std::ofstream &out);
 
-private:
-  using Scope    = std::unordered_map<std::string, ValuePtr>;
-  using ScopePtr = std::shared_ptr<Scope>;
+  auto scopePath(ScopeId id) -> const std::string &;
 
-  ScopePtr    curscope; // current scope
-  std::string curname;  // 作用域限定符
+private:
+  // 作用域树中的一个结点
+  struct Scope {
+    ScopeId     parent;  // 父作用域（全局作用域的父结点是其自身）
+    std::string name;    // 作用域名：函数名、L<n> 或 virt
+    bool        virt;    // 同名变量遮蔽时创建的虚拟作用域，随外层作用域一起退出
 
-  struct TransparentHash {
-    using is_transparent = void;
+    util::IdMap<ValuePtr> vals; // TempVal && LocalVal
 
-    std::size_t operator()(std::string_view str) const noexcept {
-      return std::hash<std::string_view>{}(str);
-    }
-    std::size_t operator()(const std::string &str) const noexcept {
-      return std::hash<std::string_view>{}(str);
-    }
+    std::string path;           // 不含 global 的限定名，如 main::L1，首次需要时生成
+    bool        path_built = false;
   };
 
-  std::unordered_map<
-    std::string,
-    ScopePtr,
-    TransparentHash,
-    std::equal_to<> // 透明比较器
-  > scopes; // TempVal && LocalVal
+  std::vector<Scope> scopes;   // 按创建顺序排列，下标即 ScopeId
+  ScopeId            curscope; // current scope
+
   std::unordered_map<std::string, ConstantPtr> constvals;
-  std::unordered_map<std::string, FunctionPtr> funcs;
+  std::unordered_map<util::SymbolId, FunctionPtr> funcs;
+
+  util::Interner &interner; // identifier pool
+
+  ValueId value_cnt = 0; // 下一个值编号
+
+  // 分支符号表：函数到全局符号表中查找，且只能看到声明顺序在 visible 之前的函数
+  const SymbolTable *global  = nullptr;
+  std::size_t        visible = 0;
 };
 
 } // namespace symbol
@@ -41,19 +41,24 @@
  * @struct TupleType
  *   Represents a tuple type, which is a fixed-size collection of heterogeneous types.
  *
+ * @typedef TypeId
+ *   Small dense integer that uniquely identifies an interned type.
+ *
  * @typedef TypePtr
- *   Alias for std::shared_ptr<Type>, used for managing type instances.
+ *   Alias for const Type *, a non-owning handle to an interned type.
  *
  * @note
- *   - All type instances are managed via shared pointers for polymorphic behavior.
+ *   - All type instances are owned by TypeFactory (builtin types are static objects),
+ *     so handles are plain pointers and copying them costs nothing.
+ *   - Every type carries a TypeId; two types are equal iff their ids are equal.
  *   - Composite types (ArrayType, TupleType) provide element access and size information.
  *   - The type system supports reference qualifiers for future extensibility.
  */
 #pragma once
 
-#include <memory>
 #include <ranges>
 #include <vector>
+#include <cstdint>
 #include <algorithm>
 
 #include "panic.hpp"
@@ -75,10 +80,14 @@ enum class RefKind : std::uint8_t {
   IMMUTABLE  // 不可变引用
 };
 
+// 类型编号，由 TypeFactory 分配，同一类型只有一个编号
+using TypeId = std::uint32_t;
+
 struct Type;
-using  TypePtr = std::shared_ptr<Type>;
+using  TypePtr = const Type *; // 非拥有指针，类型实例由 TypeFactory 持有
 
 struct Type {
+  TypeId   id = 0;
   TypeKind kind;
   RefKind  ref = RefKind::NORMAL;
   int      memory;
@@ -88,10 +97,10 @@ struct Type {
   virtual ~Type() = default;
 
   [[nodiscard]] virtual std::string str() const = 0;
-  virtual TypePtr getElemType(int idx = 0)  {
+  [[nodiscard]] virtual TypePtr getElemType(int idx = 0) const {
     UNREACHABLE("Shouldn't call this function!");
   }
-  virtual int size() {
+  [[nodiscard]] virtual int size() const {
     UNREACHABLE("Shouldn't call this function!");
   }
 };
@@ -105,7 +114,6 @@ struct AnyType : Type {
 
   [[nodiscard]] std::string str() const override { return "any"; }
 };
-using AnyTypePtr = std::shared_ptr<AnyType>;
 
 struct UnknownType : Type {
   UnknownType() : Type(TypeKind::UNKNOWN) {
@@ -116,7 +124,6 @@ struct UnknownType : Type {
 
   [[nodiscard]] std::string str() const override { return "unknown"; }
 };
-using UnknownTypePtr = std::shared_ptr<UnknownType>;
 
 struct UnitType : Type {
   UnitType() : Type(TypeKind::UNIT) {
@@ -127,7 +134,6 @@ struct UnitType : Type {
 
   [[nodiscard]] std::string str() const override { return "()"; }
 };
-using UnitTypePtr = std::shared_ptr<UnitType>;
 
 // i32
 struct IntType : Type {
@@ -139,7 +145,6 @@ struct IntType : Type {
 
   [[nodiscard]] std::string str() const override { return "i32"; }
 };
-using IntTypePtr = std::shared_ptr<IntType>;
 
 struct BoolType : Type {
   BoolType() : Type(TypeKind::BOOL) {
@@ -150,14 +155,13 @@ struct BoolType : Type {
 
   [[nodiscard]] std::string str() const override { return "bool"; }
 };
-using BoolTypePtr = std::shared_ptr<BoolType>;
 
 struct ArrayType : Type {
   int     m_size;
   TypePtr etype;
 
   ArrayType(int size, TypePtr type) : Type(TypeKind::ARRAY),
-    m_size(size), etype(std::move(type))
+    m_size(size), etype(type)
   {
     memory = m_size * (etype->memory);
     iterable = true;
@@ -167,10 +171,9 @@ struct ArrayType : Type {
   [[nodiscard]] std::string str() const override {
     return std::format("[{}; {}]", etype->str(), m_size);
   }
-  TypePtr getElemType(int idx = 0) override { return etype; }
-  int size() override { return m_size; }
+  [[nodiscard]] TypePtr getElemType(int idx = 0) const override { return etype; }
+  [[nodiscard]] int size() const override { return m_size; }
 };
-using ArrayTypePtr = std::shared_ptr<ArrayType>;
 
 struct TupleType : Type {
   int                  m_size;
@@ -202,12 +205,11 @@ struct TupleType : Type {
 
     return "(" + inner + (etypes.size() == 1 ? "," : "") + ")";
   }
-  TypePtr getElemType(int idx = 0) override {
+  [[nodiscard]] TypePtr getElemType(int idx = 0) const override {
     ASSERT_MSG(idx >= 0 && idx < m_size, "out of bounds access!");
     return etypes[idx];
   }
-  int size() override { return m_size; }
+  [[nodiscard]] int size() const override { return m_size; }
 };
-using TupleTypePtr = std::shared_ptr<TupleType>;
 
 } // namespace type
@@ -1,28 +1,111 @@
+#include <algorithm>
+
 #include "type_factory.hpp"
 
 namespace type {
 
-const TypePtr TypeFactory::ANY_TYPE  = std::make_shared<AnyType>();
-const TypePtr TypeFactory::INT_TYPE  = std::make_shared<IntType>();
-const TypePtr TypeFactory::BOOL_TYPE = std::make_shared<BoolType>();
-const TypePtr TypeFactory::UNIT_TYPE = std::make_shared<UnitType>();
-const TypePtr TypeFactory::UNKNOWN_TYPE = std::make_shared<UnknownType>();
+/**
+ * @brief  构造一个编号固定的基本类型实例
+ * @tparam T  基本类型
+ * @param  id 类型编号
+ */
+template<typename T>
+static TypePtr
+builtin(TypeId id)
+{
+  static T type;
+  type.id = id;
+  return &type;
+}
+
+// NOTE: 编号顺序需与 typeEquals 及 get 保持一致，ANY_TYPE 必须为 0
+const TypePtr TypeFactory::ANY_TYPE     = builtin<AnyType>(0);
+const TypePtr TypeFactory::INT_TYPE     = builtin<IntType>(1);
+const TypePtr TypeFactory::BOOL_TYPE    = builtin<BoolType>(2);
+const TypePtr TypeFactory::UNIT_TYPE    = builtin<UnitType>(3);
+const TypePtr TypeFactory::UNKNOWN_TYPE = builtin<UnknownType>(4);
+
+/**
+ * @brief  为一个新的复合类型分配编号，并转移所有权到 TypeFactory
+ * @param  type 新类型
+ * @return 驻留后的类型
+ */
+TypePtr
+TypeFactory::intern(std::unique_ptr<Type> type)
+{
+  type->id = static_cast<TypeId>(BUILTIN_CNT + types.size());
+  types.push_back(std::move(type));
+  return types.back().get();
+}
 
 /**
- * @brief  判断两类型是否相同
- *
- * @param  lhs 左值
- * @param  rhs 右值
- *
- * @return 相同为 true，不同为 false
+ * @brief  根据编号取回类型
  */
-bool
-typeEquals(const TypePtr &lhs, const TypePtr &rhs)
+TypePtr
+TypeFactory::get(TypeId id) const
 {
-  if (lhs == TypeFactory::ANY_TYPE || rhs == TypeFactory::ANY_TYPE) {
-    return true;
+  switch (id) {
+    case 0: return ANY_TYPE;
+    case 1: return INT_TYPE;
+    case 2: return BOOL_TYPE;
+    case 3: return UNIT_TYPE;
+    case 4: return UNKNOWN_TYPE;
+    default: {
+      std::lock_guard lock{mutex};
+      ASSERT_MSG(id - BUILTIN_CNT < types.size(), "invalid type id");
+      return types[id - BUILTIN_CNT].get();
+    }
   }
-  return lhs == rhs;
+}
+
+/**
+ * @brief  获取数组类型 [etype; size]
+ * @param  size  数组大小
+ * @param  etype 元素类型
+ * @return 唯一的数组类型实例
+ */
+TypePtr
+TypeFactory::getArray(int size, TypePtr etype)
+{
+  // Array 的所有元素类型一致，因此 (元素类型, 大小) 即可唯一确定一个数组类型
+  std::uint64_t key = (static_cast<std::uint64_t>(etype->id) << 32)
+                    | static_cast<std::uint32_t>(size);
+
+  std::lock_guard lock{mutex};
+  auto [iter, inserted] = arrays.try_emplace(key, nullptr);
+  if (inserted) {
+    iter->second = intern(std::make_unique<ArrayType>(size, etype));
+  }
+  return iter->second;
+}
+
+/**
+ * @brief  获取元组类型 (etypes...)
+ * @param  etypes 各元素类型
+ * @return 唯一的元组类型实例
+ */
+TypePtr
+TypeFactory::getTuple(std::span<const TypePtr> etypes)
+{
+  std::size_t h = etypes.size();
+  for (const auto &etype : etypes) {
+    h ^= std::hash<TypeId>{}(etype->id) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+  }
+
+  std::lock_guard lock{mutex};
+  auto [first, last] = tuples.equal_range(h);
+  for (auto iter = first; iter != last; ++iter) {
+    const auto &tuple = static_cast<const TupleType &>(*iter->second);
+    if (std::ranges::equal(tuple.etypes, etypes, {}, &Type::id, &Type::id)) {
+      return iter->second;
+    }
+  }
+
+  auto tuple = intern(std::make_unique<TupleType>(
+    std::vector<TypePtr>(etypes.begin(), etypes.end())
+  ));
+  tuples.emplace(h, tuple);
+  return tuple;
 }
 
 } // namespace type
@@ -1,87 +1,45 @@
 /**
  * @file type_factory.hpp
- * @brief Defines the TypeFactory class and supporting structures for unique type management.
+ * @brief Defines the TypeFactory class, which interns every type into a table of TypeIds.
  *
  * This header provides mechanisms to ensure unique instances of types (such as arrays and tuples)
  * within the type system. It includes:
- * - The TypeKey struct for uniquely identifying types based on kind, size, and element types.
- * - Specialization of std::hash for TypeKey to allow its use in unordered containers.
- * - The TypeFactory class, which manages the creation and caching of unique type instances.
- * - Static type instances for common types (ANY, INT, BOOL, UNIT, UNKNOWN).
+ * - The TypeFactory class, which owns all composite type instances and assigns each a TypeId.
+ * - Static type instances for common types (ANY, INT, BOOL, UNIT, UNKNOWN) with fixed ids.
+ * - Allocation-free lookup of array types (keyed by element id and size) and
+ *   tuple types (keyed by a hash of element ids).
  * - Utility functions for type comparison and identification.
  *
  * All type instances created through TypeFactory are guaranteed to be unique, ensuring
- * pointer equality can be used for type comparison throughout the system.
+ * id (or pointer) equality can be used for type comparison throughout the system.
  */
 #pragma once
 
+#include <span>
+#include <mutex>
+#include <memory>
 #include <vector>
+#include <cstdint>
 #include <unordered_map>
 
 #include "type.hpp"
 
 namespace type {
 
-// 唯一性区分不同类型
-struct TypeKey {
-  TypeKind kind; // 只使用 ARRAY 和 TUPLE
-  int size;
-  std::vector<TypePtr> etypes;
-
-  TypeKey(TypeKind kind, int size, std::vector<TypePtr> etypes)
-    : kind(kind), size(size), etypes(std::move(etypes)) {}
-
-  bool operator== (const TypeKey &other) const {
-    if (kind != other.kind || size != other.size ||
-        etypes.size() != other.etypes.size()) {
-      return false;
-    }
-
-    // 依次检查各元素的类型
-    for (std::size_t i = 0; i < etypes.size(); ++i) {
-      if (etypes[i] != other.etypes[i]) {
-        return false;
-      }
-    }
-    return true;
-  }
-};
-
-} // namespace type
-
-namespace std {
-
-// 计算 TypeKey 的 hash 值
-template<>
-struct hash<type::TypeKey> {
-  std::size_t operator() (const type::TypeKey &k) const {
-    std::size_t h = std::hash<int>()(static_cast<int>(k.kind));
-    for (const auto &p : k.etypes) {
-      h ^= (std::hash<type::Type*>()(p.get())
-        + 0x9e3779b9 + (h << 6) + (h >> 2));
-    }
-    return h;
-  }
-};
-
-} // namespace std
-
-namespace type {
-
 /**
  * @brief 工厂类，用于创建和管理类型系统中的各种类型实例，确保类型实例的唯一性。
  *
  * TypeFactory 提供了对基本类型（如 ANY_TYPE、INT_TYPE、BOOL_TYPE、UNIT_TYPE、UNKNOWN_TYPE）的唯一实例访问，
- * 并通过缓存机制保证数组类型（ArrayType）和元组类型（TupleType）的唯一性。
+ * 并通过驻留表保证数组类型（ArrayType）和元组类型（TupleType）的唯一性。
  *
  * - 所有类型的实例都通过 TypeFactory 创建和管理，保证类型系统中同一类型只有一个实例。
+ * - 每个类型有一个稠密的 TypeId：基本类型的编号固定，复合类型按创建顺序编号。
  * - 提供静态方法判断类型（如 isArray, isTuple）。
- * - 提供 getArray 和 getTuple 方法用于获取数组和元组类型的唯一实例。
+ * - 提供 getArray 和 getTuple 方法用于获取数组和元组类型的唯一实例，命中时不分配内存。
  *
  * @note
- *  - TypePtr 为 std::shared_ptr<Type>。
- *  - TypeKey 用于唯一标识类型实例，需实现合适的哈希和比较操作。
- *  - cache 用于存储已创建的类型实例，避免重复创建。
+ *  - TypePtr 为 const Type *，实例由 TypeFactory 持有，生命周期与 TypeFactory 相同。
+ *  - 两阶段模式下多个线程共享同一个 TypeFactory，驻留与查询都在互斥锁保护下进行。
  */
 class TypeFactory {
 public:
@@ -92,44 +50,52 @@ public:
   static const TypePtr UNIT_TYPE;
   static const TypePtr UNKNOWN_TYPE;
 
+  static constexpr TypeId BUILTIN_CNT = 5; // 基本类型占用编号 [0, BUILTIN_CNT)
+
 public:
-  static bool isArray(const TypePtr &type) {
+  static bool isArray(TypePtr type) {
     return type->kind == TypeKind::ARRAY;
   }
 
-  TypePtr getArray(int size, TypePtr etype) {
-    // Array 的所有元素类型一致，因此只存储一份！
-    TypeKey key{TypeKind::ARRAY, size, {etype}};
-
-    if (auto iter = cache.find(key); iter != cache.end()) {
-      return iter->second;
-    }
-
-    auto array = std::make_shared<ArrayType>(size, etype);
-    cache[key] = array;
-    return array;
-  }
-
-  static bool isTuple(const TypePtr &type) {
+  static bool isTuple(TypePtr type) {
     return type->kind == TypeKind::TUPLE;
   }
 
-  TypePtr getTuple(std::vector<TypePtr> etypes) {
-    TypeKey key{TypeKind::TUPLE, static_cast<int>(etypes.size()), etypes};
+  auto getArray(int size, TypePtr etype) -> TypePtr;
+  auto getTuple(std::span<const TypePtr> etypes) -> TypePtr;
 
-    if (auto iter = cache.find(key); iter != cache.end()) {
-      return iter->second;
-    }
+  [[nodiscard]] auto get(TypeId id) const -> TypePtr;
 
-    auto tuple = std::make_shared<TupleType>(etypes);
-    cache[key] = tuple;
-    return tuple;
+  /**
+   * @brief 已分配的类型编号个数
+   */
+  [[nodiscard]] std::size_t size() const {
+    std::lock_guard lock{mutex};
+    return BUILTIN_CNT + types.size();
   }
 
 private:
-  std::unordered_map<TypeKey, TypePtr> cache;
+  auto intern(std::unique_ptr<Type> type) -> TypePtr;
+
+private:
+  mutable std::mutex mutex; // 保护下面的驻留表
+
+  std::vector<std::unique_ptr<Type>> types; // 复合类型，下标为 id - BUILTIN_CNT
+
+  // (元素类型编号 << 32 | 数组大小) -> 数组类型
+  std::unordered_map<std::uint64_t, TypePtr> arrays;
+  // 元素类型编号序列的 hash -> 元组类型（冲突时逐个比较元素）
+  std::unordered_multimap<std::size_t, TypePtr> tuples;
 };
 
-bool typeEquals(const TypePtr &lhs, const TypePtr &rhs);
+/**
+ * @brief  判断两类型是否相同（ANY 与任意类型相同）
+ */
+inline bool
+typeEquals(TypePtr lhs, TypePtr rhs)
+{
+  constexpr TypeId any = 0; // ANY_TYPE 的编号
+  return lhs->id == rhs->id || lhs->id == any || rhs->id == any;
+}
 
 } // namespace type
@@ -0,0 +1,65 @@
+#include <memory>
+#include <algorithm>
+
+#include "arena.hpp"
+
+namespace util {
+
+Arena::~Arena()
+{
+  reset();
+}
+
+/**
+ * @brief   析构所有对象并回收内存，内存块留给之后的分配复用
+ * @details 之前通过 make() 得到的指针全部失效
+ */
+void
+Arena::reset()
+{
+  // 按分配的逆序析构，与自动变量的析构顺序一致
+  for (auto it = dtors.rbegin(); it != dtors.rend(); ++it) {
+    it->destroy(it->obj);
+  }
+  dtors.clear();
+
+  next = 0;
+  cur  = nullptr;
+  end  = nullptr;
+  used = 0;
+}
+
+/**
+ * @brief  分配一块对齐的内存
+ * @param  size  字节数
+ * @param  align 对齐要求
+ * @return 内存首地址
+ */
+void *
+Arena::allocate(std::size_t size, std::size_t align)
+{
+  void *ptr = cur;
+  std::size_t space = static_cast<std::size_t>(end - cur);
+  if (cur == nullptr || std::align(align, size, ptr, space) == nullptr) {
+    // 当前块放不下：优先复用 reset 前的块，否则新开一块，超大的对象单独占用一块
+    if (next == blocks.size() || blocks[next].size < size + align) {
+      std::size_t block = std::max(BLOCK_SIZE, size + align);
+      blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(next),
+        Block{std::make_unique_for_overwrite<std::byte[]>(block), block}
+      );
+    }
+    auto &block = blocks[next++];
+    cur = block.mem.get();
+    end = cur + block.size;
+
+    ptr = cur;
+    space = block.size;
+    std::align(align, size, ptr, space);
+  }
+
+  cur = static_cast<std::byte *>(ptr) + size;
+  used += size;
+  return ptr;
+}
+
+} // namespace util
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <new>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+namespace util {
+
+/**
+ * @brief   bump 分配器
+ * @details 对象在大块内存中顺序分配，不支持单独释放；
+ *          arena 析构时按分配的逆序调用非平凡析构函数，再统一释放所有内存块。
+ *          通过 make() 得到的指针是非拥有的，生命期与 arena 相同
+ */
+class Arena {
+public:
+  Arena() = default;
+  ~Arena();
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+public:
+  /**
+   * @brief  在 arena 中构造一个对象
+   * @param  args 构造函数参数
+   * @return 指向新对象的非拥有指针
+   */
+  template<typename T, typename... Args>
+  T *make(Args &&...args) {
+    void *mem = allocate(sizeof(T), alignof(T));
+    T *obj = ::new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      dtors.push_back({obj, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+    return obj;
+  }
+
+  void reset();
+
+  /**
+   * @brief 已分配的字节数（不含对齐填充）
+   */
+  [[nodiscard]] std::size_t bytesUsed() const {
+    return used;
+  }
+
+private:
+  auto allocate(std::size_t size, std::size_t align) -> void *;
+
+private:
+  static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+  // 需要在释放内存前调用的析构函数
+  struct Dtor {
+    void *obj;
+    void (*destroy)(void *);
+  };
+
+  struct Block {
+    std::unique_ptr<std::byte[]> mem;
+    std::size_t                  size;
+  };
+
+  std::vector<Block> blocks;   // 内存块，[0, next) 正在使用，其余为 reset 后可复用的块
+  std::size_t next = 0;
+  std::byte  *cur = nullptr; // 当前块中下一个可分配的地址
+  std::byte  *end = nullptr; // 当前块的末尾
+  std::size_t used = 0;
+
+  std::vector<Dtor> dtors;
+};
+
+} // namespace util
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+/**
+ * @brief   长度在构造时确定的位集合
+ * @details 数据流分析（活跃变量等）中每个基本块持有一个，
+ *          按 64 位字做并、差运算
+ */
+class BitSet {
+public:
+  BitSet() = default;
+  explicit BitSet(std::size_t n) : words((n + 63) / 64, 0) {}
+
+public:
+  void set(std::size_t i) { words[i / 64] |= std::uint64_t{1} << (i % 64); }
+  void reset(std::size_t i) { words[i / 64] &= ~(std::uint64_t{1} << (i % 64)); }
+
+  [[nodiscard]] bool test(std::size_t i) const {
+    return (words[i / 64] >> (i % 64) & 1) != 0;
+  }
+
+  /**
+   * @brief  this |= other
+   * @return 是否有新的位被置上
+   */
+  bool unite(const BitSet &other) {
+    bool changed = false;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+      auto merged = words[i] | other.words[i];
+      changed  = changed || merged != words[i];
+      words[i] = merged;
+    }
+    return changed;
+  }
+
+  /**
+   * @brief  this |= (in & ~kill)
+   * @return 是否有新的位被置上
+   */
+  bool uniteExcept(const BitSet &in, const BitSet &kill) {
+    bool changed = false;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+      auto merged = words[i] | (in.words[i] & ~kill.words[i]);
+      changed  = changed || merged != words[i];
+      words[i] = merged;
+    }
+    return changed;
+  }
+
+private:
+  std::vector<std::uint64_t> words;
+};
+
+} // namespace util
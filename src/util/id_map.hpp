@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+
+#include "interner.hpp"
+
+namespace util {
+
+/**
+ * @brief   以驻留标识符 id 为键的开放寻址哈希表
+ * @details 线性探测，容量为 2 的幂，负载因子不超过 1/2；
+ *          INVALID_SYMBOL 作为空槽标记。不支持删除。
+ *          空表不分配内存，绝大多数作用域只会持有少量符号
+ */
+template<typename V>
+class IdMap {
+public:
+  IdMap() = default;
+
+  IdMap(IdMap &&) noexcept = default;
+  IdMap &operator=(IdMap &&) noexcept = default;
+
+public:
+  /**
+   * @brief  查找键对应的值
+   * @return 指向值的指针，不存在则返回 nullptr
+   */
+  [[nodiscard]] const V *find(SymbolId key) const {
+    if (count == 0) {
+      return nullptr;
+    }
+    for (std::size_t i = slot(key);; i = (i + 1) & (capacity - 1)) {
+      if (keys[i] == key) {
+        return &vals[i];
+      }
+      if (keys[i] == INVALID_SYMBOL) {
+        return nullptr;
+      }
+    }
+  }
+
+  [[nodiscard]] bool contains(SymbolId key) const {
+    return find(key) != nullptr;
+  }
+
+  /**
+   * @brief 插入或覆盖键对应的值
+   */
+  void insert(SymbolId key, V val) {
+    if ((count + 1) * 2 > capacity) {
+      grow();
+    }
+    std::size_t i = slot(key);
+    while (keys[i] != INVALID_SYMBOL && keys[i] != key) {
+      i = (i + 1) & (capacity - 1);
+    }
+    if (keys[i] == INVALID_SYMBOL) {
+      keys[i] = key;
+      ++count;
+    }
+    vals[i] = std::move(val);
+  }
+
+  [[nodiscard]] std::size_t size() const { return count; }
+  [[nodiscard]] bool empty() const { return count == 0; }
+
+  /**
+   * @brief 按槽位顺序遍历所有 (key, value)
+   */
+  template<typename Fn>
+  void forEach(Fn &&fn) const {
+    for (std::size_t i = 0; i < capacity; ++i) {
+      if (keys[i] != INVALID_SYMBOL) {
+        fn(keys[i], vals[i]);
+      }
+    }
+  }
+
+private:
+  [[nodiscard]] std::size_t slot(SymbolId key) const {
+    // 驻留 id 是连续分配的，乘以奇数常数后再取低位，把相邻的 id 打散到各个槽位
+    return static_cast<std::size_t>(key * 0x9E3779B9u) & (capacity - 1);
+  }
+
+  void grow() {
+    std::size_t old_capacity = capacity;
+    auto old_keys = std::move(keys);
+    auto old_vals = std::move(vals);
+
+    capacity = old_capacity == 0 ? MIN_CAPACITY : old_capacity * 2;
+    keys = std::make_unique<SymbolId[]>(capacity);
+    vals = std::make_unique<V[]>(capacity);
+    std::fill_n(keys.get(), capacity, INVALID_SYMBOL);
+    count = 0;
+
+    for (std::size_t i = 0; i < old_capacity; ++i) {
+      if (old_keys[i] != INVALID_SYMBOL) {
+        insert(old_keys[i], std::move(old_vals[i]));
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t MIN_CAPACITY = 4;
+
+  std::unique_ptr<SymbolId[]> keys;
+  std::unique_ptr<V[]>        vals;
+  std::size_t capacity = 0;
+  std::size_t count    = 0;
+};
+
+} // namespace util
@@ -0,0 +1,65 @@
+#include <cstring>
+#include <algorithm>
+
+#include "interner.hpp"
+
+namespace util {
+
+/**
+ * @brief  将标识符拷贝到驻留池持有的内存中
+ * @param  text 标识符
+ * @return 指向驻留池内存的 string_view
+ */
+std::string_view
+Interner::store(std::string_view text)
+{
+  if (chunk_used + text.length() > CHUNK_SIZE || chunks.empty()) {
+    // 超长标识符单独分配一块
+    chunks.push_back(
+      std::make_unique<char[]>(std::max(CHUNK_SIZE, text.length()))
+    );
+    chunk_used = 0;
+  }
+
+  char *dst = chunks.back().get() + chunk_used;
+  std::memcpy(dst, text.data(), text.length());
+  chunk_used += text.length();
+
+  return {dst, text.length()};
+}
+
+/**
+ * @brief  驻留一个标识符
+ * @param  text 标识符
+ * @return 驻留后的标识符，相同的 text 总是得到相同的 id
+ */
+Name
+Interner::intern(std::string_view text)
+{
+  if (auto it = ids.find(text); it != ids.end()) {
+    return {it->second, texts[it->second]};
+  }
+
+  auto id = static_cast<SymbolId>(texts.size());
+  auto stored = store(text);
+  texts.push_back(stored);
+  ids.emplace(stored, id);
+
+  return {id, stored};
+}
+
+/**
+ * @brief  查找一个已驻留的标识符，不会插入新标识符
+ * @param  text 标识符
+ * @return 驻留后的标识符，不存在则返回 std::nullopt
+ */
+std::optional<Name>
+Interner::find(std::string_view text) const
+{
+  if (auto it = ids.find(text); it != ids.end()) {
+    return Name{it->second, texts[it->second]};
+  }
+  return std::nullopt;
+}
+
+} // namespace util
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <format>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace util {
+
+using SymbolId = std::uint32_t;
+
+inline constexpr SymbolId INVALID_SYMBOL = UINT32_MAX;
+
+/**
+ * @brief   驻留后的标识符
+ * @details id 唯一标识一个标识符，比较时只比较 id；
+ *          text 指向 Interner 持有的内存，仅用于打印
+ */
+struct Name {
+  SymbolId         id = INVALID_SYMBOL;
+  std::string_view text;
+
+  Name() = default;
+  Name(SymbolId id, std::string_view text) : id(id), text(text) {}
+
+  bool operator==(const Name &rhs) const { return id == rhs.id; }
+  [[nodiscard]] bool valid() const { return id != INVALID_SYMBOL; }
+  [[nodiscard]] std::string str() const { return std::string{text}; }
+};
+
+/**
+ * @brief   标识符驻留池
+ * @details 相同的标识符只保存一份，并分配一个稠密的 SymbolId；
+ *          lexer、符号表与语义上下文共享同一个驻留池
+ */
+class Interner {
+public:
+  Interner() = default;
+  ~Interner() = default;
+
+  Interner(const Interner &) = delete;
+  Interner &operator=(const Interner &) = delete;
+
+public:
+  auto intern(std::string_view text) -> Name;
+  [[nodiscard]] auto find(std::string_view text) const -> std::optional<Name>;
+
+  /**
+   * @brief 根据 id 取回标识符
+   */
+  [[nodiscard]] Name get(SymbolId id) const {
+    return {id, texts[id]};
+  }
+
+  [[nodiscard]] std::size_t size() const {
+    return texts.size();
+  }
+
+private:
+  auto store(std::string_view text) -> std::string_view;
+
+private:
+  static constexpr std::size_t CHUNK_SIZE = 16 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> chunks; // 字符存储块
+  std::size_t chunk_used = CHUNK_SIZE;         // 当前块已使用的字节数
+
+  std::vector<std::string_view> texts; // id -> text
+  std::unordered_map<std::string_view, SymbolId> ids; // text -> id
+};
+
+} // namespace util
+
+namespace std {
+
+template<>
+struct hash<util::Name> {
+  std::size_t operator()(const util::Name &name) const noexcept {
+    return std::hash<util::SymbolId>{}(name.id);
+  }
+};
+
+/**
+ * @brief 格式化 struct Name 为 string，便于 format 打印
+ */
+template<>
+struct formatter<util::Name> : formatter<std::string_view> {
+  auto format(const util::Name &name, format_context &ctx) const {
+    return formatter<std::string_view>::format(name.text, ctx);
+  }
+};
+
+} // namespace std
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <format>
+#include <string_view>
+
+namespace util {
+
+/**
+ * @brief 转义为 JSON 字符串字面量（含引号）
+ */
+inline std::string
+jsonQuote(std::string_view s)
+{
+  std::string str{"\""};
+  for (char c : s) {
+    switch (c) {
+      case '"':  str += "\\\""; break;
+      case '\\': str += "\\\\"; break;
+      case '\n': str += "\\n";  break;
+      case '\r': str += "\\r";  break;
+      case '\t': str += "\\t";  break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          str += std::format("\\u{:04x}", static_cast<unsigned>(c));
+        } else {
+          str.push_back(c);
+        }
+        break;
+    }
+  }
+  str.push_back('"');
+  return str;
+}
+
+} // namespace util
@@ -0,0 +1,107 @@
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <algorithm>
+
+#include "mem_stats.hpp"
+
+namespace util {
+
+namespace {
+
+// 释放时不知道块是否分配在 enable 之后，一律按 malloc_usable_size 减去
+std::atomic<bool>          tracking{false};
+std::atomic<std::uint64_t> total{0};   // 累计分配
+std::atomic<std::int64_t>  current{0}; // 尚未释放（可能因 enable 之前的块而为负）
+std::atomic<std::int64_t>  highest{0}; // current 的最大值
+thread_local std::uint64_t thread_total = 0;
+
+void
+onAlloc(void *ptr)
+{
+  if (!tracking.load(std::memory_order_relaxed)) {
+    return;
+  }
+  auto size = malloc_usable_size(ptr);
+  total.fetch_add(size, std::memory_order_relaxed);
+  thread_total += size;
+
+  auto now  = current.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed)
+    + static_cast<std::int64_t>(size);
+  auto peak = highest.load(std::memory_order_relaxed);
+  while (now > peak && !highest.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+  }
+}
+
+void
+onFree(void *ptr)
+{
+  if (ptr != nullptr && tracking.load(std::memory_order_relaxed)) {
+    current.fetch_sub(static_cast<std::int64_t>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+  }
+}
+
+} // namespace
+
+/**
+ * @brief 开始统计（--time-report）
+ */
+void
+MemStats::enable()
+{
+  tracking.store(true, std::memory_order_relaxed);
+}
+
+std::uint64_t
+MemStats::allocated()
+{
+  return total.load(std::memory_order_relaxed);
+}
+
+std::uint64_t
+MemStats::threadAllocated()
+{
+  return thread_total;
+}
+
+std::uint64_t
+MemStats::live()
+{
+  return static_cast<std::uint64_t>(std::max<std::int64_t>(current.load(std::memory_order_relaxed), 0));
+}
+
+std::uint64_t
+MemStats::peak()
+{
+  return static_cast<std::uint64_t>(highest.load(std::memory_order_relaxed));
+}
+
+} // namespace util
+
+// 替换全局的 operator new/delete；数组、带大小与 nothrow 的版本由标准库转发到这里
+
+void *
+operator new(std::size_t size)
+{
+  void *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc{};
+  }
+  util::onAlloc(ptr);
+  return ptr;
+}
+
+void
+operator delete(void *ptr) noexcept
+{
+  util::onFree(ptr);
+  std::free(ptr);
+}
+
+void
+operator delete(void *ptr, std::size_t /*size*/) noexcept
+{
+  util::onFree(ptr);
+  std::free(ptr);
+}
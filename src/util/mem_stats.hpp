@@ -0,0 +1,33 @@
+/**
+ * @file mem_stats.hpp
+ * @brief Allocation statistics of the global operator new and delete.
+ *
+ * mem_stats.cpp replaces the global operator new and delete. After
+ * MemStats::enable() they count the bytes handed out (malloc_usable_size,
+ * so the numbers include the allocator's rounding): the total allocated by
+ * all threads and by the calling thread, the bytes still live and the peak
+ * of those. Until then an allocation only pays one relaxed atomic load.
+ *
+ * Blocks allocated before enable() and freed after it are subtracted as
+ * well, so live() may be a little low; it never goes below 0. Arena blocks
+ * are counted when they are allocated; the mapped source file is not.
+ *
+ * Namespace: util
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace util {
+
+class MemStats {
+public:
+  static void enable();
+
+  [[nodiscard]] static std::uint64_t allocated();       // 所有线程累计分配的字节数
+  [[nodiscard]] static std::uint64_t threadAllocated(); // 当前线程累计分配的字节数
+  [[nodiscard]] static std::uint64_t live();            // 尚未释放的字节数
+  [[nodiscard]] static std::uint64_t peak();            // live 的最大值
+};
+
+} // namespace util
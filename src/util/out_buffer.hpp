@@ -0,0 +1,85 @@
+/**
+ * @file out_buffer.hpp
+ * @brief Reusable text buffer for the .ir and .s writers.
+ *
+ * Text is formatted straight into one std::string with std::format_to
+ * instead of going through an ostream per line; flush() hands the text of
+ * a whole function to the stream in one write and flushes it, so the output
+ * of every function reaches a pipe as soon as the function is done. The
+ * buffer keeps its capacity, so after the first few functions no further
+ * allocations are needed.
+ *
+ * Namespace: util
+ */
+#pragma once
+
+#include <format>
+#include <string>
+#include <ostream>
+#include <utility>
+#include <iterator>
+#include <string_view>
+
+namespace util {
+
+class OutBuffer {
+public:
+  explicit OutBuffer(std::ostream &out) : out(out) {
+    buf.reserve(INITIAL_CAPACITY);
+  }
+  ~OutBuffer() { flush(); }
+
+  OutBuffer(const OutBuffer &) = delete;
+  OutBuffer &operator=(const OutBuffer &) = delete;
+
+public:
+  template <typename... Args>
+  void print(std::format_string<Args...> fmt, Args &&...args) {
+    std::format_to(std::back_inserter(buf), fmt, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  void println(std::format_string<Args...> fmt, Args &&...args) {
+    print(fmt, std::forward<Args>(args)...);
+    buf.push_back('\n');
+  }
+
+  void append(std::string_view text) { buf.append(text); }
+
+  /**
+   * @brief 缓冲区写出到的流
+   */
+  [[nodiscard]] std::ostream &stream() const { return out; }
+
+  /**
+   * @brief 缓冲区本身，供直接格式化到末尾的函数使用
+   */
+  [[nodiscard]] std::string &text() { return buf; }
+
+  /**
+   * @brief 缓冲区中 from 之后的内容（如刚生成的一个函数）
+   */
+  [[nodiscard]] std::string_view view(std::size_t from = 0) const {
+    return std::string_view{buf}.substr(from);
+  }
+
+  /**
+   * @brief 把缓冲区中的内容一次写出并清空，保留容量
+   */
+  void flush() {
+    if (buf.empty()) {
+      return;
+    }
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    out.flush();
+    buf.clear();
+  }
+
+private:
+  static constexpr std::size_t INITIAL_CAPACITY = 64 * 1024;
+
+  std::ostream &out;
+  std::string   buf;
+};
+
+} // namespace util
@@ -7,6 +7,35 @@
 
 namespace util {
 
+/**
+ * @brief 在 RecoverScope 中发生的致命错误以该异常的形式抛出，而不终止进程
+ */
+struct FatalAbort {
+  std::string kind; // 错误种类
+  std::string msg;  // 错误信息
+};
+
+// 当前线程中的致命错误是否可以恢复（见 RecoverScope）
+inline thread_local bool recover_fatal = false;
+
+/**
+ * @brief   作用域内当前线程的致命错误（断言失败、UNREACHABLE、err::terminate）
+ *          抛出 FatalAbort 而不是终止进程
+ * @details 批量编译时一个文件的致命错误不应该影响其它文件；
+ *          util::parallelFor 的工作线程沿用调用线程的设置，FatalAbort 在调用线程中重新抛出
+ */
+class RecoverScope {
+public:
+  RecoverScope() : saved(recover_fatal) { recover_fatal = true; }
+  ~RecoverScope() { recover_fatal = saved; }
+
+  RecoverScope(const RecoverScope &) = delete;
+  RecoverScope &operator=(const RecoverScope &) = delete;
+
+private:
+  bool saved;
+};
+
 /**
  * @brief 打印错误信息并退出
  *
@@ -22,6 +51,9 @@ printErrMsgAbort(const std::string &kind, const std::string &msg, const std::sou
   std::println("Function: {}", loc.function_name());
   std::println("Message : {}", msg);
   std::println("\n============== {} ==============\n", kind);
+  if (recover_fatal) {
+    throw FatalAbort{kind, msg};
+  }
   std::abort();
 }
 
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <algorithm>
+#include <exception>
+
+#include "panic.hpp"
+
+namespace util {
+
+namespace detail {
+
+// 一个工作线程持有的下标区间 [begin, end)
+struct WorkRange {
+  std::mutex  mutex;
+  std::size_t begin = 0;
+  std::size_t end   = 0;
+
+  // 线程自己从区间头部取任务
+  std::optional<std::size_t> pop() {
+    std::lock_guard lock{mutex};
+    if (begin == end) {
+      return std::nullopt;
+    }
+    return begin++;
+  }
+
+  // 其它线程从区间尾部偷走一半（至少一个）任务
+  bool stealInto(WorkRange &thief) {
+    std::size_t lo, hi;
+    {
+      std::lock_guard lock{mutex};
+      if (begin == end) {
+        return false;
+      }
+      lo  = begin + (end - begin) / 2;
+      hi  = end;
+      end = lo;
+    }
+    // 此时 thief 的区间为空，其它线程不会从中取到任务
+    std::lock_guard lock{thief.mutex};
+    thief.begin = lo;
+    thief.end   = hi;
+    return true;
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief   在 jobs 个线程上并行执行 fn(0) ... fn(n - 1)
+ * @details work stealing：下标先按线程均分为连续区间，每个线程顺序执行自己的区间，
+ *          做完后从其它线程的区间尾部偷走一半，任务耗时不均时也能保持负载均衡；
+ *          jobs <= 1 时直接在调用线程中顺序执行。函数返回时所有任务都已完成。
+ *          工作线程沿用调用线程的 RecoverScope：任务抛出异常（如可以恢复的致命错误
+ *          FatalAbort）后各线程不再开始新的任务，所有线程结束后在调用线程中重新抛出
+ *          第一个异常
+ * @param   n    任务个数
+ * @param   jobs 线程数
+ * @param   fn   任务，接受一个下标
+ */
+template<typename Fn>
+void
+parallelFor(std::size_t n, unsigned jobs, Fn &&fn)
+{
+  jobs = static_cast<unsigned>(std::min<std::size_t>(jobs, n));
+  if (jobs <= 1) {
+    for (std::size_t i = 0; i < n; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  auto ranges = std::make_unique<detail::WorkRange[]>(jobs);
+  for (unsigned t = 0; t < jobs; ++t) {
+    ranges[t].begin = n * t / jobs;
+    ranges[t].end   = n * (t + 1) / jobs;
+  }
+
+  bool               recover = recover_fatal; // 调用线程中的致命错误是否可以恢复
+  std::atomic<bool>  failed  = false;          // 是否已有任务抛出异常
+  std::exception_ptr error;                    // 第一个异常
+  std::mutex         error_mutex;
+
+  auto run = [&](unsigned self) {
+    while (!failed.load(std::memory_order_relaxed)) {
+      if (auto i = ranges[self].pop()) {
+        fn(i.value());
+        continue;
+      }
+
+      // 自己的区间做完了，依次尝试从其它线程偷取
+      bool stolen = false;
+      for (unsigned k = 1; k < jobs && !stolen; ++k) {
+        stolen = ranges[(self + k) % jobs].stealInto(ranges[self]);
+      }
+      if (!stolen) {
+        return; // 所有区间都已空，剩余任务正在其它线程中执行
+      }
+    }
+  };
+
+  auto worker = [&](unsigned self) {
+    std::optional<RecoverScope> scope;
+    if (recover) {
+      scope.emplace();
+    }
+    try {
+      run(self);
+    } catch (...) {
+      std::lock_guard lock{error_mutex};
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(jobs - 1);
+    for (unsigned t = 1; t < jobs; ++t) {
+      threads.emplace_back(worker, t);
+    }
+    worker(0); // 调用线程也参与执行
+  } // 等待所有线程结束
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * @brief 默认线程数：硬件线程数（无法获取时为 1）
+ */
+inline unsigned
+defaultJobs()
+{
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // namespace util
@@ -0,0 +1,127 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cstring>
+#include <algorithm>
+
+#include "panic.hpp"
+#include "source_buffer.hpp"
+
+namespace util {
+
+/**
+ * @brief 通过 mmap 映射输入文件
+ * @param file 输入文件名
+ */
+SourceBuffer::SourceBuffer(const std::string &file)
+  : filename(file)
+{
+  int fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    UNREACHABLE("无法打开输入文件");
+  }
+
+  struct stat st{};
+  if (::fstat(fd, &st) < 0) {
+    ::close(fd);
+    UNREACHABLE("无法获取输入文件信息");
+  }
+
+  size = static_cast<std::size_t>(st.st_size);
+  if (size > 0) {
+    void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      ::close(fd);
+      UNREACHABLE("无法映射输入文件");
+    }
+    // 顺序扫描，提示内核提前预读
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(addr);
+    mapped = true;
+  }
+  ::close(fd); // 映射建立后即可关闭文件描述符
+}
+
+/**
+ * @brief 持有一段内存中的文本
+ * @param name 缓冲区名称
+ * @param text 文本内容
+ */
+SourceBuffer::SourceBuffer(std::string name, std::string text)
+  : owned(std::move(text)), filename(std::move(name))
+{
+  data = owned.data();
+  size = owned.size();
+}
+
+SourceBuffer::~SourceBuffer()
+{
+  if (mapped) {
+    ::munmap(const_cast<char *>(data), size);
+  }
+}
+
+/**
+ * @brief 建立换行符偏移索引
+ */
+void
+SourceBuffer::buildLineIndex() const
+{
+  line_offsets.clear();
+
+  std::size_t start = 0;
+  while (start < size) {
+    line_offsets.push_back(start);
+    const void *nl = std::memchr(data + start, '\n', size - start);
+    if (nl == nullptr) {
+      break;
+    }
+    start = static_cast<const char *>(nl) - data + 1;
+  }
+}
+
+/**
+ * @brief  获取指定行（不包含换行符）
+ * @param  row 行号（从 0 开始）
+ * @return 对应行的 string_view
+ */
+std::string_view
+SourceBuffer::line(std::size_t row) const
+{
+  const auto &offsets = lineIndex();
+  ASSERT_MSG(row < offsets.size(), "行号越界");
+
+  std::size_t start = offsets[row];
+  std::size_t end = row + 1 < offsets.size()
+    ? offsets[row + 1] - 1 : size;
+  if (end > start && data[end - 1] == '\n') {
+    --end;
+  }
+
+  return {data + start, end - start};
+}
+
+/**
+ * @brief   将缓冲区偏移换算为行列号
+ * @details 在换行符偏移索引上二分查找；偏移不小于缓冲区大小时
+ *          返回 {lineCount(), 0}，与 END token 的位置一致
+ * @param   offset 缓冲区偏移
+ * @return  对应的位置
+ */
+Position
+SourceBuffer::position(std::size_t offset) const
+{
+  const auto &offsets = lineIndex();
+  if (offset >= size) {
+    return {offsets.size(), 0};
+  }
+
+  auto it = std::upper_bound(offsets.begin(), offsets.end(), offset);
+  std::size_t row = static_cast<std::size_t>(it - offsets.begin()) - 1;
+
+  return {row, offset - offsets[row]};
+}
+
+} // namespace util
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <string_view>
+
+#include "position.hpp"
+
+namespace util {
+
+/**
+ * @brief   源代码缓冲区
+ * @details 输入文件只通过 mmap 映射一次；换行符偏移索引在第一次换算行列号时
+ *          才建立（只做词法分析或不报错时无需扫描换行符）。
+ *          lexer 与 ErrReporter 均通过 std::string_view
+ *          访问同一块内存，避免逐行拷贝
+ */
+class SourceBuffer {
+public:
+  explicit SourceBuffer(const std::string &file);
+  SourceBuffer(std::string name, std::string text);
+  ~SourceBuffer();
+
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+public:
+  /**
+   * @brief  获取整个缓冲区
+   */
+  [[nodiscard]] std::string_view text() const {
+    return {data, size};
+  }
+
+  /**
+   * @brief  获取缓冲区对应的文件名
+   */
+  [[nodiscard]] const std::string &name() const {
+    return filename;
+  }
+
+  /**
+   * @brief  获取总行数（与 std::getline 的切分方式一致）
+   */
+  [[nodiscard]] std::size_t lineCount() const {
+    return lineIndex().size();
+  }
+
+  /**
+   * @brief  获取指定行的起始偏移，越界时返回缓冲区大小
+   */
+  [[nodiscard]] std::size_t lineOffset(std::size_t row) const {
+    const auto &offsets = lineIndex();
+    return row < offsets.size() ? offsets[row] : size;
+  }
+
+  [[nodiscard]] std::string_view line(std::size_t row) const;
+  [[nodiscard]] Position position(std::size_t offset) const;
+
+private:
+  /**
+   * @brief 换行符偏移索引，第一次访问时建立（线程安全）
+   */
+  const std::vector<std::size_t> &lineIndex() const {
+    std::call_once(line_once, [this] { buildLineIndex(); });
+    return line_offsets;
+  }
+
+  void buildLineIndex() const;
+
+private:
+  const char *data = nullptr; // 缓冲区首地址
+  std::size_t size = 0;       // 缓冲区大小
+  bool        mapped = false; // 是否为 mmap 映射的内存
+
+  std::string owned;    // 非文件来源时持有的文本
+  std::string filename; // 文件名
+
+  mutable std::once_flag           line_once;    // 保证索引只建立一次
+  mutable std::vector<std::size_t> line_offsets; // 每一行的起始偏移
+};
+
+} // namespace util
@@ -0,0 +1,234 @@
+#include <array>
+#include <print>
+#include <format>
+#include <ranges>
+#include <algorithm>
+
+#include "json.hpp"
+#include "panic.hpp"
+#include "mem_stats.hpp"
+#include "time_report.hpp"
+
+namespace util {
+
+namespace {
+
+inline constexpr int NAME_WIDTH = 36; // 表中区间名一列的宽度（含缩进）
+
+/**
+ * @brief 字节数的可读形式：B、KiB、MiB、GiB
+ */
+std::string
+formatBytes(std::uint64_t bytes)
+{
+  constexpr std::array<std::string_view, 4> units{"B", "KiB", "MiB", "GiB"};
+  auto value = static_cast<double>(bytes);
+  std::size_t unit = 0;
+  while (value >= 1024 && unit + 1 < units.size()) {
+    value /= 1024;
+    ++unit;
+  }
+  return unit == 0 ? std::format("{} B", bytes) : std::format("{:.1f} {}", value, units[unit]);
+}
+
+double
+millis(std::chrono::steady_clock::duration time)
+{
+  return std::chrono::duration<double, std::milli>(time).count();
+}
+
+double
+micros(std::chrono::steady_clock::duration time)
+{
+  return std::chrono::duration<double, std::micro>(time).count();
+}
+
+} // namespace
+
+/**
+ * @brief 由当前线程创建；同时开始统计内存分配
+ */
+TimeReport::TimeReport() : owner(std::this_thread::get_id()), start(Clock::now())
+{
+  MemStats::enable();
+  nodes.push_back({.name = "total"});
+}
+
+/**
+ * @brief 在当前线程上开始一个名为 name 的区间
+ */
+void
+TimeReport::begin(std::string_view name)
+{
+  auto now = Clock::now();
+  auto id  = std::this_thread::get_id();
+  auto allocated = id == owner ? MemStats::allocated() : MemStats::threadAllocated();
+
+  std::lock_guard lock{mutex};
+  std::size_t parent = 0;
+  if (auto it = stacks.find(id); it != stacks.end() && !it->second.empty()) {
+    parent = it->second.back().node;
+  } else if (auto main = stacks.find(owner); main != stacks.end() && !main->second.empty()) {
+    parent = main->second.back().node;
+  }
+  auto node = child(parent, name);
+  stacks[id].push_back({.node = node, .begin = now, .allocated = allocated});
+}
+
+/**
+ * @brief 结束当前线程上最近开始的区间
+ */
+void
+TimeReport::end()
+{
+  auto now = Clock::now();
+  auto id  = std::this_thread::get_id();
+  auto allocated = id == owner ? MemStats::allocated() : MemStats::threadAllocated();
+
+  std::lock_guard lock{mutex};
+  auto &stack = stacks[id];
+  ASSERT_MSG(!stack.empty(), "time report scope ended twice");
+  auto open = stack.back();
+  stack.pop_back();
+
+  auto &node = nodes[open.node];
+  auto time  = now - open.begin;
+  auto bytes = allocated - open.allocated;
+  node.time  += time;
+  node.bytes += bytes;
+  ++node.calls;
+  events.push_back({.node = open.node, .tid = tidOf(id), .begin = open.begin, .time = time, .bytes = bytes});
+}
+
+/**
+ * @brief 计数器 name 加 n
+ */
+void
+TimeReport::count(std::string_view name, std::uint64_t n)
+{
+  std::lock_guard lock{mutex};
+  auto it = std::ranges::find(counters, name, &std::pair<std::string, std::uint64_t>::first);
+  if (it == counters.end()) {
+    counters.emplace_back(std::string{name}, n);
+  } else {
+    it->second += n;
+  }
+}
+
+/**
+ * @brief 所有名为 name 的区间（不论嵌套在哪个阶段之下）的总时间（秒）
+ */
+double
+TimeReport::seconds(std::string_view name) const
+{
+  std::lock_guard lock{mutex};
+  auto total = Clock::duration::zero();
+  for (const auto &node : nodes) {
+    if (node.name == name) {
+      total += node.time;
+    }
+  }
+  return std::chrono::duration<double>(total).count();
+}
+
+/**
+ * @brief 父结点下名为 name 的子结点，没有时新建
+ */
+std::size_t
+TimeReport::child(std::size_t parent, std::string_view name)
+{
+  for (auto c : nodes[parent].children) {
+    if (nodes[c].name == name) {
+      return c;
+    }
+  }
+  nodes.push_back({.name = std::string{name}, .parent = parent});
+  nodes[parent].children.push_back(nodes.size() - 1);
+  return nodes.size() - 1;
+}
+
+/**
+ * @brief trace 中线程的编号：创建者为 0，其余按第一次结束区间的顺序编号
+ */
+unsigned
+TimeReport::tidOf(std::thread::id id)
+{
+  if (threads.empty()) {
+    threads.push_back(owner);
+  }
+  auto it = std::ranges::find(threads, id);
+  if (it != threads.end()) {
+    return static_cast<unsigned>(it - threads.begin());
+  }
+  threads.push_back(id);
+  return static_cast<unsigned>(threads.size() - 1);
+}
+
+/**
+ * @brief 以缩进的表格输出各阶段的调用次数、时间、占比与分配的字节数，以及各计数器
+ */
+void
+TimeReport::printTable(std::ostream &out) const
+{
+  std::lock_guard lock{mutex};
+  auto wall = millis(Clock::now() - start);
+  std::println(out, "Time report: {:.3f} ms wall, peak {} live, {} allocated",
+    wall, formatBytes(MemStats::peak()), formatBytes(MemStats::allocated()));
+  std::println(out, "  {:<{}} {:>7} {:>12} {:>7} {:>12}", "phase", NAME_WIDTH, "calls", "time", "%", "allocated");
+  for (auto c : nodes[0].children) {
+    printNode(out, c, 0, wall);
+  }
+
+  if (!counters.empty()) {
+    std::println(out, "Counters:");
+    for (const auto &[name, n] : counters) {
+      std::println(out, "  {:<{}} {:>12}", name, NAME_WIDTH, n);
+    }
+  }
+}
+
+/**
+ * @brief 输出一个结点及其子结点（按第一次出现的顺序）
+ * @note  多线程的区间的时间会累加，子结点之和可能超过父结点
+ */
+void
+TimeReport::printNode(std::ostream &out, std::size_t node, int depth, double total) const
+{
+  const auto &n = nodes[node];
+  auto name = std::format("{:{}}{}", "", depth * 2, n.name);
+  auto time = millis(n.time);
+  std::println(out, "  {:<{}} {:>7} {:>9.3f} ms {:>6.1f}% {:>12}", name, NAME_WIDTH, n.calls, time,
+    total > 0 ? time * 100 / total : 0.0, formatBytes(n.bytes));
+  for (auto c : n.children) {
+    printNode(out, c, depth + 1, total);
+  }
+}
+
+/**
+ * @brief 以 Chrome trace event 格式（JSON）输出每个区间与各计数器
+ */
+void
+TimeReport::writeTrace(std::ostream &out) const
+{
+  std::lock_guard lock{mutex};
+  std::println(out, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (std::size_t tid = 0; tid < std::max<std::size_t>(threads.size(), 1); ++tid) {
+    std::println(out, "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":{}}}}},",
+      tid, jsonQuote(tid == 0 ? "main" : std::format("worker {}", tid)));
+  }
+  for (const auto &event : events) {
+    std::println(out,
+      "{{\"name\":{},\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"allocated\":{}}}}},",
+      jsonQuote(nodes[event.node].name), event.tid, micros(event.begin - start), micros(event.time), event.bytes);
+  }
+
+  std::string args = std::format("\"peak\":{}", MemStats::peak());
+  for (const auto &[name, n] : counters) {
+    args += std::format(",{}:{}", jsonQuote(name), n);
+  }
+  std::println(out, "{{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":{:.3f},\"args\":{{{}}}}}",
+    micros(Clock::now() - start), args);
+  std::println(out, "]}}");
+}
+
+} // namespace util
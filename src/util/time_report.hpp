@@ -0,0 +1,126 @@
+/**
+ * @file time_report.hpp
+ * @brief Hierarchical phase timers, counters and allocation statistics (--time-report).
+ *
+ * A TimeScope opens a named interval on the calling thread and closes it
+ * when it goes out of scope; an interval opened while another one is open
+ * on the same thread becomes its child. A worker thread without an open
+ * interval nests under the innermost open interval of the thread that
+ * created the report, so the per-function work of a parallel phase (passes,
+ * code generation) lands under that phase. The table merges the intervals
+ * with the same name under the same parent and counts their calls; the
+ * trace keeps every interval.
+ *
+ * Every interval records the bytes allocated while it was open
+ * (mem_stats.hpp): by all threads for the intervals of the creating thread,
+ * by its own thread for a worker's. Counters (tokens, quads, spills, ...)
+ * are sums over the whole compilation.
+ *
+ * seconds() sums the intervals of one name wherever they nest, for tools
+ * that run the compiler in-process (bench/scaling_bench.cpp).
+ *
+ * printTable() writes an indented table with the peak of live allocations;
+ * writeTrace() writes the Chrome trace event format (chrome://tracing,
+ * Perfetto): one complete event per interval and the counters as a final
+ * counter event.
+ *
+ * Namespace: util
+ */
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+
+namespace util {
+
+class TimeReport {
+public:
+  TimeReport();
+
+public:
+  void begin(std::string_view name);
+  void end();
+  void count(std::string_view name, std::uint64_t n);
+
+  [[nodiscard]] double seconds(std::string_view name) const;
+
+  void printTable(std::ostream &out) const;
+  void writeTrace(std::ostream &out) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  // 表中的一行：同一父结点下同名的区间合并
+  struct Node {
+    std::string              name;
+    std::size_t              parent = 0;
+    std::vector<std::size_t> children;
+    Clock::duration          time   = Clock::duration::zero();
+    std::uint64_t            calls  = 0;
+    std::uint64_t            bytes  = 0; // 区间内分配的字节数
+  };
+
+  // 线程上尚未结束的区间
+  struct Open {
+    std::size_t       node;
+    Clock::time_point begin;
+    std::uint64_t     allocated; // 开始时的累计分配量
+  };
+
+  // trace 中的一个区间
+  struct Event {
+    std::size_t       node;
+    unsigned          tid;
+    Clock::time_point begin;
+    Clock::duration   time;
+    std::uint64_t     bytes;
+  };
+
+  auto child(std::size_t parent, std::string_view name) -> std::size_t;
+  auto tidOf(std::thread::id id) -> unsigned;
+  void printNode(std::ostream &out, std::size_t node, int depth, double total) const;
+
+private:
+  mutable std::mutex mutex;
+  std::thread::id    owner; // 创建者线程，其余线程的区间挂在它当前的区间之下
+  Clock::time_point  start;
+
+  std::vector<Node>  nodes; // nodes[0] 为根
+  std::vector<Event> events;
+  std::unordered_map<std::thread::id, std::vector<Open>> stacks;
+  std::vector<std::thread::id> threads; // trace 中的 tid -> 线程
+
+  std::vector<std::pair<std::string, std::uint64_t>> counters; // 按第一次计数的顺序
+};
+
+/**
+ * @brief 作用域计时：构造时开始一个区间，析构时结束；report 为空时什么也不做
+ */
+class TimeScope {
+public:
+  TimeScope(TimeReport *report, std::string_view name) : report(report) {
+    if (report != nullptr) {
+      report->begin(name);
+    }
+  }
+  ~TimeScope() {
+    if (report != nullptr) {
+      report->end();
+    }
+  }
+
+  TimeScope(const TimeScope &) = delete;
+  TimeScope &operator=(const TimeScope &) = delete;
+
+private:
+  TimeReport *report;
+};
+
+} // namespace util
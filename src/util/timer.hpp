@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+
+namespace util {
+
+/**
+ * @brief   可累加的计时器
+ * @details 多次 start/stop 之间的时间会累加，便于统计被分散调用的阶段
+ */
+class Timer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  Timer() = default;
+  ~Timer() = default;
+
+public:
+  void start() {
+    begin = Clock::now();
+  }
+
+  void stop() {
+    total += Clock::now() - begin;
+  }
+
+  void reset() {
+    total = Clock::duration::zero();
+  }
+
+  /**
+   * @brief  获取累计时间（秒）
+   */
+  [[nodiscard]] double seconds() const {
+    return std::chrono::duration<double>(total).count();
+  }
+
+private:
+  Clock::time_point begin;
+  Clock::duration   total = Clock::duration::zero();
+};
+
+/**
+ * @brief 作用域计时：构造时开始，析构时停止；timer 为空时什么也不做
+ */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Timer *timer) : timer(timer) {
+    if (timer != nullptr) {
+      timer->start();
+    }
+  }
+  ~ScopedTimer() {
+    if (timer != nullptr) {
+      timer->stop();
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Timer *timer;
+};
+
+} // namespace util
@@ -0,0 +1,9 @@
+// 常量运算的边界：除数为 0 时 div 指令的结果是 -1，编译器自身不能因此崩溃；
+// 超出 i32 的结果在 64 位寄存器中不截断，-O1 不能把它折叠为回绕后的常量。
+// -O0 与 -O1 的 main0 返回值应相同
+fn main0() -> i32 {
+    let mut big: i32 = 2147483647;
+    big = big + 1;
+    let d: i32 = 7 / 0;
+    big / 65536 + d
+}
@@ -0,0 +1,28 @@
+// -O1 的循环不变量外提不能让可能越界的数组访问提前执行：
+// 循环一次也不执行、或访问受条件保护时，-O0 与 -O1 都不越界，main0 返回 10
+fn zero_trip(a: [i32; 3], k: i32, n: i32) -> i32 {
+    let mut s = 0;
+    let mut i = 0;
+    while i < n {
+        s = s + a[k] * i;
+        i = i + 1;
+    }
+    s
+}
+
+fn guarded(a: [i32; 3], k: i32) -> i32 {
+    let mut s = 0;
+    let mut i = 0;
+    while i < 4 {
+        if k < 3 {
+            s = s + a[k];
+        }
+        i = i + 1;
+    }
+    s
+}
+
+fn main0() -> i32 {
+    let a = [1, 2, 3];
+    zero_trip(a, 7, 0) + guarded(a, 5) + guarded(a, 1) + 2
+}
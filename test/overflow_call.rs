@@ -0,0 +1,13 @@
+// 纯函数中的 i32 运算溢出：生成的代码在 64 位寄存器中运算，溢出之后的值与回绕的结果不同，
+// -O1 不能在编译期把这样的调用求值为回绕后的常量；-O0 与 -O1 的 main0 返回值应相同
+fn shift(x: i32, n: i32) -> i32 {
+    if n == 0 {
+        x / 65536
+    } else {
+        shift(x * 2, n - 1)
+    }
+}
+
+fn main0() -> i32 {
+    shift(1, 40) + shift(196608, 4)
+}